@@ -3,13 +3,21 @@
 #include "FootTrailsGeneratorComponent.h"
 //---
 #include "FootTrailsDataAsset.h"
+#include "GeneratedMap.h"
 #include "InstancedStaticMeshActor.h"
 #include "MyDataTable/MyDataTable.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
 #include "Structures/Cell.h"
+#include "Subsystems/CosmeticEventsSubsystem.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
 #include "UtilityLibraries/CellsUtilsLibrary.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/AssetManager.h"
 #include "Engine/StaticMesh.h"
+#include "Engine/StreamableManager.h"
 #include "Engine/World.h"
 #include "GameFramework/Actor.h"
 //---
@@ -34,18 +42,375 @@ const UFootTrailsDataAsset& UFootTrailsGeneratorComponent::GetFootTrailsDataAsse
 // Returns the random foot trail instance for given types
 const UStaticMesh* UFootTrailsGeneratorComponent::GetRandomMesh(EFootTrailType FootTrailType) const
 {
-	TArray<const UStaticMesh*> MatchingMeshes;
-	const ELevelType CurrentLevelType = UMyBlueprintFunctionLibrary::GetLevelType();
+	const int32 BucketIndex = GetMeshBucketIndex(FootTrailType, CurrentLevelTypeInternal);
+	if (!MeshBucketsInternal.IsValidIndex(BucketIndex))
+	{
+		return nullptr;
+	}
+
+	const TArray<const UStaticMesh*>& MatchingMeshes = MeshBucketsInternal[BucketIndex];
+	const int32 Index = FMath::RandRange(0, MatchingMeshes.Num() - 1);
+	return MatchingMeshes.IsValidIndex(Index) ? MatchingMeshes[Index] : nullptr;
+}
+
+// Spawns foot trails on all walkable cells of the level: its type and rotation is chosen by walkable neighbours
+void UFootTrailsGeneratorComponent::GenerateFootTrails()
+{
+	if (UUtilsLibrary::IsDedicatedServer())
+	{
+		// Foot trails are cosmetics, nothing to generate on the server
+		return;
+	}
+
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+	if (!ensureMsgf(GeneratedMap, TEXT("%s: 'GeneratedMap' is not valid"), *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	// Hide all previous foot trails, their instances are reused by new ones
+	TSet<UInstancedStaticMeshComponent*> DirtyComponents;
+	TArray<int32> SpawnedCellIndices;
+	SpawnedFootTrailsInternal.GenerateKeyArray(SpawnedCellIndices);
+	for (const int32 CellIndexIt : SpawnedCellIndices)
+	{
+		ReleaseFootTrail(CellIndexIt, DirtyComponents);
+	}
+
+	for (UInstancedStaticMeshComponent* It : DirtyComponents)
+	{
+		It->MarkRenderStateDirty();
+	}
+
+	RebuildWalkableCells(*GeneratedMap);
+
+	// ----- Classifying in parallel -----
+
+	// Each cell reads only the walkability of its neighbours, so workers write own elements without locks
+	const int32 CellsNum = WalkableCellsInternal.Num();
+	TArray<EFootTrailType> CellFootTrailTypes;
+	TArray<float> CellRotations;
+	CellFootTrailTypes.SetNumUninitialized(CellsNum);
+	CellRotations.SetNumUninitialized(CellsNum);
+	ParallelFor(CellsNum, [this, GeneratedMap, &CellFootTrailTypes, &CellRotations](int32 CellIndex)
+	{
+		GetFootTrailOnCellIndex(*GeneratedMap, CellIndex, CellFootTrailTypes[CellIndex], CellRotations[CellIndex]);
+	});
+
+	// ----- Spawning on the game thread -----
+
+	TArray<FFootTrailSpawn> FootTrails;
+	FootTrails.Reserve(CellsNum);
+	for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+	{
+		if (CellFootTrailTypes[CellIndex] != EFootTrailType::None)
+		{
+			FFootTrailSpawn& FootTrailSpawn = FootTrails.AddDefaulted_GetRef();
+			FootTrailSpawn.FootTrailType = CellFootTrailTypes[CellIndex];
+			FootTrailSpawn.Cell = GeneratedMap->GetCellByIndex(CellIndex);
+			FootTrailSpawn.CellRotation = CellRotations[CellIndex];
+		}
+	}
+
+	SpawnFootTrails(FootTrails);
+}
+
+// Returns the index of the mesh bucket for given types in MeshBucketsInternal
+int32 UFootTrailsGeneratorComponent::GetMeshBucketIndex(EFootTrailType FootTrailType, ELevelType LevelType)
+{
+	constexpr int32 FootTrailTypesNum = static_cast<int32>(EFootTrailType::Turn) + 1;
+	return TO_FLAG(LevelType) * FootTrailTypesNum + static_cast<int32>(FootTrailType);
+}
+
+// Distributes loaded meshes into buckets by level type and foot trail type
+void UFootTrailsGeneratorComponent::BuildMeshBuckets()
+{
+	constexpr int32 BucketsNum = TO_FLAG(ELT::Max) + 1;
+	MeshBucketsInternal.Reset();
+	MeshBucketsInternal.SetNum(GetMeshBucketIndex(EFootTrailType::None, static_cast<ELevelType>(BucketsNum)));
+
 	for (const TTuple<FFootTrailArchetype, TObjectPtr<UStaticMesh>>& It : FootTrailInstancesInternal)
 	{
-		if (It.Key.FootTrailType == FootTrailType && It.Key.LevelType == CurrentLevelType)
+		const int32 BucketIndex = GetMeshBucketIndex(It.Key.FootTrailType, It.Key.LevelType);
+		if (It.Value
+			&& MeshBucketsInternal.IsValidIndex(BucketIndex))
 		{
-			MatchingMeshes.Emplace(It.Value);
+			MeshBucketsInternal[BucketIndex].Emplace(It.Value);
 		}
 	}
+}
 
-	const int32 Index = FMath::RandRange(0, MatchingMeshes.Num() - 1);
-	return MatchingMeshes.IsValidIndex(Index) ? MatchingMeshes[Index] : nullptr;
+// Is called when the level type is changed to pick meshes from another buckets
+void UFootTrailsGeneratorComponent::OnLevelTypeChanged(ELevelType NewLevelType)
+{
+	CurrentLevelTypeInternal = NewLevelType;
+}
+
+// Is called when level actors are regenerated to forget or regenerate all foot trails
+void UFootTrailsGeneratorComponent::OnGeneratedLevelActors()
+{
+	if (bAutoGenerateFootTrailsInternal)
+	{
+		GenerateFootTrails();
+		return;
+	}
+
+	// Foot trails are respawned from outside, so tracked cells are not valid anymore
+	SpawnedFootTrailsInternal.Empty();
+	WalkableCellsInternal.Empty();
+}
+
+// Is called once per frame with all cosmetic events to update foot trails around cells whose walls or boxes were destroyed
+void UFootTrailsGeneratorComponent::OnCosmeticEvents(TConstArrayView<FCosmeticEvent> Events)
+{
+	if (SpawnedFootTrailsInternal.IsEmpty())
+	{
+		// No foot trails are spawned on this level yet
+		return;
+	}
+
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+	if (!GeneratedMap)
+	{
+		return;
+	}
+
+	const FIntPoint& GridSize = GeneratedMap->GetGridSize();
+	const bool bIsRebuilt = WalkableCellsInternal.Num() != GridSize.X * GridSize.Y;
+	if (bIsRebuilt)
+	{
+		RebuildWalkableCells(*GeneratedMap);
+	}
+
+	for (const FCosmeticEvent& EventIt : Events)
+	{
+		if (EventIt.Type != ECosmeticEventType::ActorDestroyed
+			|| !(TO_FLAG(EventIt.ActorType) & BlockingActorTypesInternal))
+		{
+			// E.g. an item was picked up or a player moved, foot trails are not affected
+			continue;
+		}
+
+		const int32 CellIndex = GeneratedMap->GetCellIndex(EventIt.Cell);
+		if (!WalkableCellsInternal.IsValidIndex(CellIndex))
+		{
+			continue;
+		}
+
+		if (!bIsRebuilt)
+		{
+			// The cell could still be blocked by another actor
+			const bool bIsWalkable = (GeneratedMap->GetActorTypesOnCellIndex(CellIndex) & BlockingActorTypesInternal) == 0;
+			if (WalkableCellsInternal[CellIndex] == bIsWalkable)
+			{
+				continue;
+			}
+
+			WalkableCellsInternal[CellIndex] = bIsWalkable;
+		}
+
+		UpdateFootTrailsAroundCellIndex(CellIndex);
+	}
+}
+
+// Recalculates walkability of all cells
+void UFootTrailsGeneratorComponent::RebuildWalkableCells(const AGeneratedMap& GeneratedMap)
+{
+	const FIntPoint& GridSize = GeneratedMap.GetGridSize();
+	const int32 CellsNum = GridSize.X * GridSize.Y;
+	WalkableCellsInternal.Init(false, CellsNum);
+	for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+	{
+		WalkableCellsInternal[CellIndex] = (GeneratedMap.GetActorTypesOnCellIndex(CellIndex) & BlockingActorTypesInternal) == 0;
+	}
+}
+
+// Returns the foot trail type and its rotation for the cell by its walkable neighbours, the type is none if the cell is not walkable
+void UFootTrailsGeneratorComponent::GetFootTrailOnCellIndex(const AGeneratedMap& GeneratedMap, int32 CellIndex, EFootTrailType& OutFootTrailType, float& OutCellRotation) const
+{
+	OutFootTrailType = EFootTrailType::None;
+	OutCellRotation = 0.f;
+
+	const int32 Columns = GeneratedMap.GetGridSize().X;
+	if (!Columns
+		|| !WalkableCellsInternal.IsValidIndex(CellIndex)
+		|| !WalkableCellsInternal[CellIndex])
+	{
+		return;
+	}
+
+	const int32 Column = CellIndex % Columns;
+	const int32 Row = CellIndex / Columns;
+	const int32 Rows = WalkableCellsInternal.Num() / Columns;
+
+	// Next column, next row, previous column, previous row
+	static const FIntPoint Sides[] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+	int32 WalkableSidesBitmask = 0;
+	for (int32 SideIndex = 0; SideIndex < UE_ARRAY_COUNT(Sides); ++SideIndex)
+	{
+		const int32 SideColumn = Column + Sides[SideIndex].X;
+		const int32 SideRow = Row + Sides[SideIndex].Y;
+		if (SideColumn >= 0 && SideColumn < Columns
+			&& SideRow >= 0 && SideRow < Rows
+			&& WalkableCellsInternal[SideRow * Columns + SideColumn])
+		{
+			WalkableSidesBitmask |= 1 << SideIndex;
+		}
+	}
+
+	GetFootTrailBySides(WalkableSidesBitmask, OutFootTrailType, OutCellRotation);
+}
+
+// Returns the foot trail type and its rotation by given bitmask of walkable sides
+void UFootTrailsGeneratorComponent::GetFootTrailBySides(int32 WalkableSidesBitmask, EFootTrailType& OutFootTrailType, float& OutCellRotation)
+{
+	constexpr int32 AllSides = 0b1111;
+	WalkableSidesBitmask &= AllSides;
+	OutCellRotation = 0.f;
+
+	// Returns the side index rotated from given one by the specified number of quarters
+	auto RotateSide = [](int32 SideIndex, int32 Quarters) { return (SideIndex + Quarters) % 4; };
+	auto HasSide = [WalkableSidesBitmask](int32 SideIndex) { return (WalkableSidesBitmask & (1 << SideIndex)) != 0; };
+
+	switch (FMath::CountBits(WalkableSidesBitmask))
+	{
+	case 4:
+		OutFootTrailType = EFootTrailType::Crossroad;
+		break;
+	case 3:
+		for (int32 SideIndex = 0; SideIndex < 4; ++SideIndex)
+		{
+			if (!HasSide(SideIndex))
+			{
+				// The stem is opposite to the closed side
+				OutFootTrailType = EFootTrailType::TJunction;
+				OutCellRotation = RotateSide(SideIndex, 2) * 90.f;
+				break;
+			}
+		}
+		break;
+	case 2:
+		for (int32 SideIndex = 0; SideIndex < 4; ++SideIndex)
+		{
+			if (!HasSide(SideIndex))
+			{
+				continue;
+			}
+
+			if (HasSide(RotateSide(SideIndex, 2)))
+			{
+				OutFootTrailType = EFootTrailType::Straight;
+				OutCellRotation = SideIndex * 90.f;
+				break;
+			}
+
+			if (HasSide(RotateSide(SideIndex, 1)))
+			{
+				// The first side of the turn in clockwise order
+				OutFootTrailType = EFootTrailType::Turn;
+				OutCellRotation = SideIndex * 90.f;
+				break;
+			}
+		}
+		break;
+	case 1:
+		OutFootTrailType = EFootTrailType::DeadEnd;
+		OutCellRotation = FMath::CountTrailingZeros(WalkableSidesBitmask) * 90.f;
+		break;
+	default:
+		OutFootTrailType = EFootTrailType::None;
+		break;
+	}
+}
+
+// Updates foot trails only on given cell and its neighbours
+void UFootTrailsGeneratorComponent::UpdateFootTrailsAroundCellIndex(int32 CellIndex)
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+	const int32 Columns = GeneratedMap ? GeneratedMap->GetGridSize().X : 0;
+	if (!Columns
+		|| !WalkableCellsInternal.IsValidIndex(CellIndex))
+	{
+		return;
+	}
+
+	const int32 Column = CellIndex % Columns;
+	TArray<int32, TInlineAllocator<5>> AffectedCellIndices{CellIndex, CellIndex - Columns, CellIndex + Columns};
+	if (Column > 0)
+	{
+		AffectedCellIndices.Emplace(CellIndex - 1);
+	}
+	if (Column < Columns - 1)
+	{
+		AffectedCellIndices.Emplace(CellIndex + 1);
+	}
+
+	TSet<UInstancedStaticMeshComponent*> DirtyComponents;
+	TArray<FFootTrailSpawn> FootTrails;
+	for (const int32 CellIndexIt : AffectedCellIndices)
+	{
+		if (!WalkableCellsInternal.IsValidIndex(CellIndexIt))
+		{
+			continue;
+		}
+
+		FFootTrailSpawn FootTrailSpawn;
+		GetFootTrailOnCellIndex(*GeneratedMap, CellIndexIt, FootTrailSpawn.FootTrailType, FootTrailSpawn.CellRotation);
+
+		if (const FFootTrailInstance* SpawnedFootTrail = SpawnedFootTrailsInternal.Find(CellIndexIt))
+		{
+			if (SpawnedFootTrail->FootTrailType == FootTrailSpawn.FootTrailType
+				&& FMath::IsNearlyEqual(SpawnedFootTrail->CellRotation, FootTrailSpawn.CellRotation))
+			{
+				// This foot trail is not changed
+				continue;
+			}
+
+			ReleaseFootTrail(CellIndexIt, DirtyComponents);
+		}
+
+		if (FootTrailSpawn.FootTrailType != EFootTrailType::None)
+		{
+			FootTrailSpawn.Cell = GeneratedMap->GetCellByIndex(CellIndexIt);
+			FootTrails.Emplace(MoveTemp(FootTrailSpawn));
+		}
+	}
+
+	for (UInstancedStaticMeshComponent* It : DirtyComponents)
+	{
+		It->MarkRenderStateDirty();
+	}
+
+	SpawnFootTrails(FootTrails);
+}
+
+// Hides the foot trail on the cell by its index and keeps its instance to be reused
+void UFootTrailsGeneratorComponent::ReleaseFootTrail(int32 CellIndex, TSet<UInstancedStaticMeshComponent*>& OutDirtyComponents)
+{
+	FFootTrailInstance FootTrailInstance;
+	if (!SpawnedFootTrailsInternal.RemoveAndCopyValue(CellIndex, FootTrailInstance))
+	{
+		return;
+	}
+
+	UInstancedStaticMeshComponent* Component = FootTrailInstance.Component.Get();
+	if (!Component
+		|| !Component->IsValidInstance(FootTrailInstance.InstanceIndex))
+	{
+		return;
+	}
+
+	// Zero scale hides the instance without shifting indices of others, the render state is marked dirty by the caller once
+	FTransform HiddenTransform;
+	Component->GetInstanceTransform(FootTrailInstance.InstanceIndex, HiddenTransform, /*bWorldSpace*/true);
+	HiddenTransform.SetScale3D(FVector::ZeroVector);
+	Component->UpdateInstanceTransform(FootTrailInstance.InstanceIndex, HiddenTransform, /*bWorldSpace*/true, /*bMarkRenderStateDirty*/false, /*bTeleport*/true);
+
+	FreeInstancesInternal.FindOrAdd(Component).Emplace(FootTrailInstance.InstanceIndex);
+	OutDirtyComponents.Emplace(Component);
 }
 
 // Called when the game starts
@@ -65,57 +430,326 @@ void UFootTrailsGeneratorComponent::EndPlay(const EEndPlayReason::Type EndPlayRe
 		InstancedStaticMeshActorInternal = nullptr;
 	}
 
+	if (MeshesHandleInternal.IsValid())
+	{
+		MeshesHandleInternal->CancelHandle();
+		MeshesHandleInternal.Reset();
+	}
+
+	if (DataAssetHandleInternal.IsValid())
+	{
+		DataAssetHandleInternal->ReleaseHandle();
+		DataAssetHandleInternal.Reset();
+	}
+
 	FootTrailInstancesInternal.Empty();
+	MeshBucketsInternal.Empty();
+	PendingFootTrailsInternal.Empty();
+	SpawnedFootTrailsInternal.Empty();
+	ComponentsByMeshInternal.Empty();
+	FreeInstancesInternal.Empty();
+	WalkableCellsInternal.Empty();
+	bAreFootTrailsLoadedInternal = false;
+
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	if (AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr)
+	{
+		GeneratedMap->OnSetNewLevelType.RemoveAll(this);
+		GeneratedMap->OnGeneratedLevelActors.RemoveAll(this);
+	}
+
+	if (UCosmeticEventsSubsystem* CosmeticEventsSubsystem = UCosmeticEventsSubsystem::GetCosmeticEventsSubsystem(this))
+	{
+		CosmeticEventsSubsystem->OnCosmeticEvents.RemoveAll(this);
+	}
 
 	Super::EndPlay(EndPlayReason);
 }
 
-// Loads all foot trails archetypes
+// Starts loading all foot trails archetypes asynchronously: the data asset first, then all meshes in one batch
 void UFootTrailsGeneratorComponent::Init()
 {
-	const UDataTable* FootTrailsDT = GetFootTrailsDataAssetChecked().GetFootTrailsDataTable();
-	if (!ensureMsgf(FootTrailsDT, TEXT("%s: 'FootTrailsDT' is not set"), *FString(__FUNCTION__))
-		|| !FootTrailInstancesInternal.IsEmpty())
+	if (bAreFootTrailsLoadedInternal
+		|| MeshesHandleInternal.IsValid()
+		|| DataAssetHandleInternal.IsValid())
 	{
-		// is already initialized
+		// is already initialized or loading
 		return;
 	}
 
-	InstancedStaticMeshActorInternal = GetWorld()->SpawnActor<AInstancedStaticMeshActor>();
-	checkf(InstancedStaticMeshActorInternal, TEXT("%s: ERROR: 'InstancedStaticMeshActor' was not spawned!"), *FString(__FUNCTION__));
+	if (UUtilsLibrary::IsDedicatedServer())
+	{
+		// Foot trails are cosmetics, so neither meshes are loaded nor instances are spawned on the server
+		return;
+	}
 
-	TMap<FName, FFootTrailArchetype> FootTrailsRows;
-	UMyDataTable::GetRows(*FootTrailsDT, FootTrailsRows);
-	for (const TTuple<FName, FFootTrailArchetype>& FootTrailsRowIt : FootTrailsRows)
+	if (!InstancedStaticMeshActorInternal)
+	{
+		InstancedStaticMeshActorInternal = GetWorld()->SpawnActor<AInstancedStaticMeshActor>();
+		checkf(InstancedStaticMeshActorInternal, TEXT("%s: ERROR: 'InstancedStaticMeshActor' was not spawned!"), *FString(__FUNCTION__));
+
+		// Is found by the tag in 'Bomber.MemReport'
+		InstancedStaticMeshActorInternal->Tags.AddUnique(TEXT("FootTrails"));
+	}
+
+	if (FootTrailsDataAssetInternal.IsValid()
+		|| FootTrailsDataAssetInternal.IsNull())
+	{
+		OnFootTrailsDataAssetLoaded();
+		return;
+	}
+
+	FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+	DataAssetHandleInternal = StreamableManager.RequestAsyncLoad(FootTrailsDataAssetInternal.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &ThisClass::OnFootTrailsDataAssetLoaded));
+}
+
+// Is called when the data asset is loaded to request all foot trail meshes
+void UFootTrailsGeneratorComponent::OnFootTrailsDataAssetLoaded()
+{
+	const UDataTable* FootTrailsDT = GetFootTrailsDataAssetChecked().GetFootTrailsDataTable();
+	if (!ensureMsgf(FootTrailsDT, TEXT("%s: 'FootTrailsDT' is not set"), *FString(__FUNCTION__)))
+	{
+		// Meshes will never be loaded, so deferred foot trails would be kept forever
+		PendingFootTrailsInternal.Empty();
+		return;
+	}
+
+	TArray<FSoftObjectPath> MeshPaths;
+	UMyDataTable::ForEachRow<FFootTrailArchetype>(*FootTrailsDT, [this, &MeshPaths](FName RowName, const FFootTrailArchetype& ArchetypeIt)
 	{
-		const FFootTrailArchetype& ArchetypeIt = FootTrailsRowIt.Value;
 		if (ArchetypeIt.Mesh.IsNull())
 		{
 			// skip empty rows
-			continue;
+			return;
 		}
 
-		FootTrailInstancesInternal.Emplace(ArchetypeIt, ArchetypeIt.Mesh.LoadSynchronous());
+		// Mesh is set on load
+		FootTrailInstancesInternal.Emplace(ArchetypeIt, nullptr);
+		MeshPaths.AddUnique(ArchetypeIt.Mesh.ToSoftObjectPath());
+	});
+
+	FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+	MeshesHandleInternal = StreamableManager.RequestAsyncLoad(MoveTemp(MeshPaths), FStreamableDelegate::CreateUObject(this, &ThisClass::OnFootTrailMeshesLoaded));
+	if (!MeshesHandleInternal.IsValid())
+	{
+		// Nothing to load, e.g. all meshes are already in memory
+		OnFootTrailMeshesLoaded();
 	}
 }
 
-// Spawns given Foot Trail by its type on the specified cell
+// Is called when all foot trail meshes are loaded to bucket them and spawn deferred foot trails
+void UFootTrailsGeneratorComponent::OnFootTrailMeshesLoaded()
+{
+	for (TTuple<FFootTrailArchetype, TObjectPtr<UStaticMesh>>& It : FootTrailInstancesInternal)
+	{
+		It.Value = It.Key.Mesh.Get();
+	}
+
+	BuildMeshBuckets();
+	bAreFootTrailsLoadedInternal = true;
+
+	// Meshes are referenced by the map from now, so the handle is not needed anymore
+	if (MeshesHandleInternal.IsValid())
+	{
+		MeshesHandleInternal->ReleaseHandle();
+		MeshesHandleInternal.Reset();
+	}
+
+	// Track the level type to not fetch it on each spawned foot trail
+	CurrentLevelTypeInternal = UMyBlueprintFunctionLibrary::GetLevelType();
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	if (AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr)
+	{
+		GeneratedMap->OnSetNewLevelType.AddUniqueDynamic(this, &ThisClass::OnLevelTypeChanged);
+
+		GeneratedMap->OnGeneratedLevelActors.AddUniqueDynamic(this, &ThisClass::OnGeneratedLevelActors);
+	}
+
+	// Only cells of destroyed walls and boxes are updated once per frame instead of regenerating all foot trails
+	if (UCosmeticEventsSubsystem* CosmeticEventsSubsystem = UCosmeticEventsSubsystem::GetCosmeticEventsSubsystem(this))
+	{
+		CosmeticEventsSubsystem->OnCosmeticEvents.AddUObject(this, &ThisClass::OnCosmeticEvents);
+	}
+
+	// Spawn all foot trails that were requested while meshes were loading
+	const TArray<FFootTrailSpawn> PendingFootTrails = MoveTemp(PendingFootTrailsInternal);
+	SpawnFootTrails(PendingFootTrails);
+}
+
+// Spawns given Foot Trail by its type on the specified cell, is deferred until meshes are loaded
 void UFootTrailsGeneratorComponent::SpawnFootTrail(EFootTrailType FootTrailType, const FCell& Cell, float CellRotation)
 {
-	const UStaticMesh* FootTrailMesh = GetRandomMesh(FootTrailType);
-	if (!FootTrailMesh
-		|| !ensureMsgf(FootTrailType != EFootTrailType::None, TEXT("%s: 'FootTrailType' is none"), *FString(__FUNCTION__))
-		|| !ensureMsgf(InstancedStaticMeshActorInternal, TEXT("%s: 'InstancedStaticMeshActor' is not valid"), *FString(__FUNCTION__)))
+	FFootTrailSpawn FootTrailSpawn;
+	FootTrailSpawn.FootTrailType = FootTrailType;
+	FootTrailSpawn.Cell = Cell;
+	FootTrailSpawn.CellRotation = CellRotation;
+	SpawnFootTrails({FootTrailSpawn});
+}
+
+// Spawns all given Foot Trails in one batch: instances are grouped by mesh and added once per mesh, is deferred until meshes are loaded
+void UFootTrailsGeneratorComponent::SpawnFootTrails(const TArray<FFootTrailSpawn>& FootTrails)
+{
+	if (FootTrails.IsEmpty()
+		|| UUtilsLibrary::IsDedicatedServer()) // Is never loaded on the server, so don't keep pending foot trails
 	{
 		return;
 	}
 
+	if (!bAreFootTrailsLoadedInternal)
+	{
+		// Is queued only while loading is in progress, nothing is kept if loading failed
+		const bool bIsLoading = MeshesHandleInternal.IsValid()
+			|| (DataAssetHandleInternal.IsValid() && DataAssetHandleInternal->IsLoadingInProgress());
+		if (bIsLoading)
+		{
+			PendingFootTrailsInternal.Append(FootTrails);
+		}
+		return;
+	}
+
+	if (!ensureMsgf(InstancedStaticMeshActorInternal, TEXT("%s: 'InstancedStaticMeshActor' is not valid"), *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	// Are the same for the whole batch
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
 	const AActor* Owner = GetOwner();
 	checkf(Owner, TEXT("%s: ERROR: 'Owner' is null!"), *FString(__FUNCTION__));
 	const FRotator OwnerLootAtRot = Owner->GetActorRotation();
-	CellRotation += UCellsUtilsLibrary::GetCellYawDegree();
-	const FRotator CellRot(OwnerLootAtRot.Pitch, CellRotation, OwnerLootAtRot.Roll);
-	const FTransform CellTransform(CellRot, Cell, FVector::OneVector);
+	const float CellYawDegree = UCellsUtilsLibrary::GetCellYawDegree();
+
+	TMap<const UStaticMesh*, TArray<FTransform>> TransformsByMesh;
+	TMap<const UStaticMesh*, TArray<const FFootTrailSpawn*>> FootTrailsByMesh;
+	TSet<UInstancedStaticMeshComponent*> DirtyComponents;
+	for (const FFootTrailSpawn& FootTrailIt : FootTrails)
+	{
+		if (!ensureMsgf(FootTrailIt.FootTrailType != EFootTrailType::None, TEXT("%s: 'FootTrailType' is none"), *FString(__FUNCTION__)))
+		{
+			continue;
+		}
+
+		const UStaticMesh* FootTrailMesh = GetRandomMesh(FootTrailIt.FootTrailType);
+		if (!FootTrailMesh)
+		{
+			continue;
+		}
+
+		// Replace the previous foot trail on this cell if any
+		ReleaseFootTrail(GeneratedMap ? GeneratedMap->GetCellIndex(FootTrailIt.Cell) : INDEX_NONE, DirtyComponents);
+
+		const FRotator CellRot(OwnerLootAtRot.Pitch, FootTrailIt.CellRotation + CellYawDegree, OwnerLootAtRot.Roll);
+		TransformsByMesh.FindOrAdd(FootTrailMesh).Emplace(CellRot, FootTrailIt.Cell, FVector::OneVector);
+		FootTrailsByMesh.FindOrAdd(FootTrailMesh).Emplace(&FootTrailIt);
+	}
+
+	for (UInstancedStaticMeshComponent* It : DirtyComponents)
+	{
+		It->MarkRenderStateDirty();
+	}
+
+	for (const TTuple<const UStaticMesh*, TArray<FTransform>>& It : TransformsByMesh)
+	{
+		TArray<int32> InstanceIndices;
+		UInstancedStaticMeshComponent* Component = AddInstancesByMesh(It.Key, It.Value, InstanceIndices);
+		const TArray<const FFootTrailSpawn*>& MeshFootTrails = FootTrailsByMesh.FindChecked(It.Key);
+		if (!Component
+			|| !GeneratedMap
+			|| InstanceIndices.Num() != MeshFootTrails.Num())
+		{
+			// Instances can't be tracked, so these foot trails won't be updated
+			continue;
+		}
+
+		// Track spawned instances by cells to update them on level actors change
+		for (int32 Index = 0; Index < MeshFootTrails.Num(); ++Index)
+		{
+			const int32 CellIndex = GeneratedMap->GetCellIndex(MeshFootTrails[Index]->Cell);
+			if (CellIndex != INDEX_NONE)
+			{
+				FFootTrailInstance& FootTrailInstance = SpawnedFootTrailsInternal.Add(CellIndex);
+				FootTrailInstance.Component = Component;
+				FootTrailInstance.InstanceIndex = InstanceIndices[Index];
+				FootTrailInstance.FootTrailType = MeshFootTrails[Index]->FootTrailType;
+				FootTrailInstance.CellRotation = MeshFootTrails[Index]->CellRotation;
+			}
+		}
+	}
+}
+
+// Adds all instances of given mesh with one render state update, reuses hidden instances first
+UInstancedStaticMeshComponent* UFootTrailsGeneratorComponent::AddInstancesByMesh(const UStaticMesh* Mesh, const TArray<FTransform>& Transforms, TArray<int32>& OutInstanceIndices)
+{
+	OutInstanceIndices.Reset();
+	if (!Mesh
+		|| Transforms.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	int32 NextTransformIndex = 0;
+	UInstancedStaticMeshComponent* FoundComponent = ComponentsByMeshInternal.FindRef(Mesh).Get();
+	if (!FoundComponent)
+	{
+		// First instance is spawned by the actor, so it creates the instanced component for this mesh if needed
+		InstancedStaticMeshActorInternal->SpawnInstanceByMesh(Transforms[NextTransformIndex++], Mesh);
+
+		TInlineComponentArray<UInstancedStaticMeshComponent*> InstancedComponents(InstancedStaticMeshActorInternal);
+		for (UInstancedStaticMeshComponent* It : InstancedComponents)
+		{
+			if (It && It->GetStaticMesh() == Mesh)
+			{
+				FoundComponent = It;
+				break;
+			}
+		}
+
+		if (!FoundComponent)
+		{
+			// Fallback to spawn one by one, such instances are not tracked
+			for (; NextTransformIndex < Transforms.Num(); ++NextTransformIndex)
+			{
+				InstancedStaticMeshActorInternal->SpawnInstanceByMesh(Transforms[NextTransformIndex], Mesh);
+			}
+			return nullptr;
+		}
+
+		ComponentsByMeshInternal.Emplace(Mesh, FoundComponent);
+		OutInstanceIndices.Emplace(FoundComponent->GetInstanceCount() - 1);
+	}
+
+	static constexpr bool bWorldSpace = true;
+
+	// Reuse hidden instances without changing the instances count
+	bool bReusedAny = false;
+	if (TArray<int32>* FreeInstances = FreeInstancesInternal.Find(FoundComponent))
+	{
+		while (NextTransformIndex < Transforms.Num()
+			&& !FreeInstances->IsEmpty())
+		{
+			const int32 InstanceIndex = FreeInstances->Pop(/*bAllowShrinking*/false);
+			if (FoundComponent->IsValidInstance(InstanceIndex))
+			{
+				FoundComponent->UpdateInstanceTransform(InstanceIndex, Transforms[NextTransformIndex++], bWorldSpace, /*bMarkRenderStateDirty*/false, /*bTeleport*/true);
+				OutInstanceIndices.Emplace(InstanceIndex);
+				bReusedAny = true;
+			}
+		}
+	}
+
+	if (bReusedAny)
+	{
+		FoundComponent->MarkRenderStateDirty();
+	}
+
+	// The rest are added at once, so the render state is marked dirty only once
+	if (NextTransformIndex < Transforms.Num())
+	{
+		const TArray<FTransform> RestTransforms(Transforms.GetData() + NextTransformIndex, Transforms.Num() - NextTransformIndex);
+		static constexpr bool bShouldReturnIndices = true;
+		OutInstanceIndices.Append(FoundComponent->AddInstances(RestTransforms, bShouldReturnIndices, bWorldSpace));
+	}
 
-	InstancedStaticMeshActorInternal->SpawnInstanceByMesh(CellTransform, FootTrailMesh);
+	return FoundComponent;
 }
@@ -8,9 +8,31 @@
 //---
 #include "FootTrailsGeneratorComponent.generated.h"
 
+class AGeneratedMap;
 class UFootTrailsDataAsset;
+class UInstancedStaticMeshComponent;
 class UStaticMesh;
 
+struct FStreamableHandle;
+
+/**
+ * Tracks one spawned foot trail instance on the cell, is used to update only changed cells.
+ */
+struct FFootTrailInstance
+{
+	/** The instanced component that holds this foot trail. */
+	TWeakObjectPtr<UInstancedStaticMeshComponent> Component = nullptr;
+
+	/** The index of the instance in the component, is stable since instances are hidden and reused instead of being removed. */
+	int32 InstanceIndex = INDEX_NONE;
+
+	/** The spawned foot trail type. */
+	EFootTrailType FootTrailType = EFootTrailType::None;
+
+	/** The spawned yaw of the foot trail relative to the grid. */
+	float CellRotation = 0.f;
+};
+
 /**
  * Is main logic component that generates foot trails.
  */
@@ -34,10 +56,20 @@ public:
 	/** Guarantees that the data asset is loaded, otherwise, it will crash. */
 	const class UFootTrailsDataAsset& GetFootTrailsDataAssetChecked() const;
 
+	/** Returns true if all foot trail meshes are loaded, so trails are spawned right away instead of being deferred. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool AreFootTrailsLoaded() const { return bAreFootTrailsLoadedInternal; }
+
 	/** Returns the random foot trail instance for given types. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	const UStaticMesh* GetRandomMesh(EFootTrailType FootTrailType) const;
 
+	/** Spawns foot trails on all walkable cells of the level: its type and rotation is chosen by walkable neighbours.
+	 * Cells are classified in parallel, then instances are added on the game thread.
+	 * Replaces all previously spawned foot trails, then only changed cells are updated on level actors change. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void GenerateFootTrails();
+
 	/*********************************************************************************************
 	 * Protected properties
 	 ********************************************************************************************* */
@@ -54,6 +86,48 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Foot Trail Instances"))
 	TMap<FFootTrailArchetype, TObjectPtr<UStaticMesh>> FootTrailInstancesInternal;
 
+	/** Meshes of loaded archetypes bucketed once on init by level type and foot trail type, is indexed by GetMeshBucketIndex.
+	 * Meshes are referenced by FootTrailInstancesInternal, so they are not tracked by GC here. */
+	TArray<TArray<const UStaticMesh*>> MeshBucketsInternal;
+
+	/** The level type which meshes are picked for, is updated on level type change instead of being fetched on each spawn. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Current Level Type"))
+	ELevelType CurrentLevelTypeInternal = ELevelType::None;
+
+	/** Is true when all foot trail meshes are loaded asynchronously. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Are Foot Trails Loaded"))
+	bool bAreFootTrailsLoadedInternal = false;
+
+	/** Keeps the data asset loaded once it is requested asynchronously. */
+	TSharedPtr<FStreamableHandle> DataAssetHandleInternal = nullptr;
+
+	/** Is valid while all foot trail meshes are loading, then meshes are referenced by FootTrailInstancesInternal. */
+	TSharedPtr<FStreamableHandle> MeshesHandleInternal = nullptr;
+
+	/** Cells with any of these level actors are not walkable, so no foot trails are spawned there. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Blocking Actor Types", Bitmask, BitmaskEnum = "/Script/Bomber.EActorType"))
+	int32 BlockingActorTypesInternal = TO_FLAG(EAT::Wall | EAT::Box);
+
+	/** If true, all foot trails are generated by C++ each time level actors are regenerated, otherwise they are spawned from outside. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Auto Generate Foot Trails"))
+	bool bAutoGenerateFootTrailsInternal = false;
+
+	/** All spawned foot trails by row-major indices of their cells. */
+	TMap<int32, FFootTrailInstance> SpawnedFootTrailsInternal;
+
+	/** Instanced components of the actor by their meshes, is filled on first spawned instance of each mesh. */
+	TMap<TObjectKey<UStaticMesh>, TWeakObjectPtr<UInstancedStaticMeshComponent>> ComponentsByMeshInternal;
+
+	/** Hidden instances of each component that are reused by next spawned foot trails instead of adding new ones. */
+	TMap<TObjectKey<UInstancedStaticMeshComponent>, TArray<int32>> FreeInstancesInternal;
+
+	/** Is true for each row-major cell index that is walkable, is used to skip level actor changes that do not affect foot trails. */
+	TBitArray<> WalkableCellsInternal;
+
+	/** Foot trails requested to be spawned while meshes are still loading, are spawned once loaded. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Pending Foot Trails"))
+	TArray<FFootTrailSpawn> PendingFootTrailsInternal;
+
 	/*********************************************************************************************
 	 * Protected functions
 	 ********************************************************************************************* */
@@ -64,11 +138,61 @@ protected:
 	/** Called when the game ends. */
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	/** Loads all foot trails archetypes. */
+	/** Starts loading all foot trails archetypes asynchronously: the data asset first, then all meshes in one batch. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void Init();
 
-	/** Spawns given Foot Trail by its type on the specified cell. */
+	/** Is called when the data asset is loaded to request all foot trail meshes. */
+	void OnFootTrailsDataAssetLoaded();
+
+	/** Is called when all foot trail meshes are loaded to bucket them and spawn deferred foot trails. */
+	void OnFootTrailMeshesLoaded();
+
+	/** Returns the index of the mesh bucket for given types in MeshBucketsInternal. */
+	static int32 GetMeshBucketIndex(EFootTrailType FootTrailType, ELevelType LevelType);
+
+	/** Distributes loaded meshes into buckets by level type and foot trail type. */
+	void BuildMeshBuckets();
+
+	/** Is called when the level type is changed to pick meshes from another buckets. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void OnLevelTypeChanged(ELevelType NewLevelType);
+
+	/** Is called when level actors are regenerated to forget or regenerate all foot trails. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void OnGeneratedLevelActors();
+
+	/** Is called once per frame with all cosmetic events to update foot trails around cells whose walls or boxes were destroyed. */
+	void OnCosmeticEvents(TConstArrayView<struct FCosmeticEvent> Events);
+
+	/** Recalculates walkability of all cells. */
+	void RebuildWalkableCells(const AGeneratedMap& GeneratedMap);
+
+	/** Returns the foot trail type and its rotation for the cell by its walkable neighbours, the type is none if the cell is not walkable.
+	 * Is thread-safe while walkable cells are not changed, so it is called from workers on generation. */
+	void GetFootTrailOnCellIndex(const AGeneratedMap& GeneratedMap, int32 CellIndex, EFootTrailType& OutFootTrailType, float& OutCellRotation) const;
+
+	/** Returns the foot trail type and its rotation by given bitmask of walkable sides: 1 is next column, 2 is next row, 4 is previous column and 8 is previous row.
+	 * Rotation is a multiple of 90 degrees, meshes are expected to be authored with the only (or first) open side towards the next column. */
+	static void GetFootTrailBySides(int32 WalkableSidesBitmask, EFootTrailType& OutFootTrailType, float& OutCellRotation);
+
+	/** Updates foot trails only on given cell and its neighbours. */
+	void UpdateFootTrailsAroundCellIndex(int32 CellIndex);
+
+	/** Hides the foot trail on the cell by its index and keeps its instance to be reused. */
+	void ReleaseFootTrail(int32 CellIndex, TSet<UInstancedStaticMeshComponent*>& OutDirtyComponents);
+
+	/** Spawns given Foot Trail by its type on the specified cell, is deferred until meshes are loaded.
+	 * @see UFootTrailsGeneratorComponent::SpawnFootTrails to spawn many foot trails at once. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void SpawnFootTrail(EFootTrailType FootTrailType, const struct FCell& Cell, float CellRotation);
+
+	/** Spawns all given Foot Trails in one batch: instances are grouped by mesh and added once per mesh, is deferred until meshes are loaded. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void SpawnFootTrails(const TArray<FFootTrailSpawn>& FootTrails);
+
+	/** Adds all instances of given mesh with one render state update, reuses hidden instances first.
+	 * @param OutInstanceIndices Indices of added instances in the same order as transforms, is empty if instances could not be tracked.
+	 * @return The instanced component that holds these instances. */
+	UInstancedStaticMeshComponent* AddInstancesByMesh(const UStaticMesh* Mesh, const TArray<FTransform>& Transforms, TArray<int32>& OutInstanceIndices);
 };
@@ -6,6 +6,7 @@
 //---
 #include "Bomber.h" // ELevelType
 #include "Misc/EnumRange.h"
+#include "Structures/Cell.h"
 //---
 #include "FootTrailsTypes.generated.h"
 
@@ -25,6 +26,27 @@ enum class EFootTrailType : uint8
 
 ENUM_RANGE_BY_FIRST_AND_LAST(EFootTrailType, EFootTrailType::Crossroad, EFootTrailType::Turn);
 
+/**
+ * Request to spawn one foot trail, is used to spawn many foot trails in one batch.
+ */
+USTRUCT(BlueprintType)
+struct FOOTTRAILSGENERATORRUNTIME_API FFootTrailSpawn
+{
+	GENERATED_BODY()
+
+	/** The foot trail type to spawn. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "C++")
+	EFootTrailType FootTrailType = EFootTrailType::None;
+
+	/** The cell to spawn the foot trail on. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "C++")
+	FCell Cell = FCell::InvalidCell;
+
+	/** The yaw of the foot trail relative to the grid. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "C++")
+	float CellRotation = 0.f;
+};
+
 /**
  * Specific foot trail archetype.
  */
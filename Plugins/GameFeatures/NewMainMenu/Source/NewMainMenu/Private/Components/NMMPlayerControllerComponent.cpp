@@ -114,6 +114,9 @@ void UNMMPlayerControllerComponent::OnUnregister()
 	// Kill current save game object
 	if (SaveGameDataInternal)
 	{
+		// Delayed write can't be awaited anymore
+		SaveGameDataInternal->FlushPendingSave();
+
 		SaveGameDataInternal->ConditionalBeginDestroy();
 		SaveGameDataInternal = nullptr;
 	}
@@ -127,6 +130,9 @@ void UNMMPlayerControllerComponent::OnMainMenuSpotReady_Implementation(UNMMSpotC
 	checkf(MainMenuSpotComponent, TEXT("ERROR: [%i] %s:\n'MainMenuSpotComponent' is null!"), __LINE__, *FString(__FUNCTION__));
 	if (MainMenuSpotComponent->IsActiveSpot())
 	{
+		// Spots are reloaded when the preload window moves or on synchronous load of the active spot, so the Menu state is set only for the first one
+		UNMMSubsystem::Get().OnMainMenuSpotReady.RemoveDynamic(this, &ThisClass::OnMainMenuSpotReady);
+
 		GetPlayerControllerChecked().SetMenuState();
 	}
 }
@@ -6,11 +6,9 @@
 #include "NMMUtils.h"
 #include "Components/MyCameraComponent.h"
 #include "Controllers/MyPlayerController.h"
-#include "Data/NMMDataAsset.h"
 #include "Data/NMMSaveGameData.h"
 #include "Data/NMMSubsystem.h"
 #include "GameFramework/MyGameStateBase.h"
-#include "MyDataTable/MyDataTable.h"
 #include "MyUtilsLibraries/CinematicUtils.h"
 #include "MyUtilsLibraries/UtilsLibrary.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
@@ -47,6 +45,54 @@ UMySkeletalMeshComponent& UNMMSpotComponent::GetMeshChecked() const
 	return *Mesh;
 }
 
+// Stops ticking and animating the mesh of this spot and hides its props, all of it is restored once the spot is woken up
+void UNMMSpotComponent::SetDormant(bool bInDormant)
+{
+	if (bIsDormantInternal == bInDormant
+		|| (bInDormant && IsActiveSpot()))
+	{
+		return;
+	}
+
+	UMySkeletalMeshComponent* Mesh = GetMySkeletalMeshComponent();
+	if (!Mesh)
+	{
+		return;
+	}
+
+	bIsDormantInternal = bInDormant;
+
+	// The mesh keeps rendering its last pose without evaluating animations and updating bones
+	Mesh->SetComponentTickEnabled(!bInDormant);
+	Mesh->bPauseAnims = bInDormant;
+	Mesh->bNoSkeletonUpdate = bInDormant;
+
+	if (!bInDormant)
+	{
+		// Props that were hidden or stopped before the dormancy are kept the same
+		for (const FDormantProp& It : DormantPropsInternal)
+		{
+			if (UMeshComponent* Prop = It.Prop.Get())
+			{
+				Prop->SetVisibility(It.bWasVisible);
+				Prop->SetComponentTickEnabled(It.bWasTickEnabled);
+			}
+		}
+		DormantPropsInternal.Empty();
+		return;
+	}
+
+	TArray<UMeshComponent*> Props;
+	Mesh->GetAttachedPropsByClass(Props, UMeshComponent::StaticClass());
+	DormantPropsInternal.Reset(Props.Num());
+	for (UMeshComponent* PropIt : Props)
+	{
+		DormantPropsInternal.Add({PropIt, PropIt->IsVisible(), PropIt->IsComponentTickEnabled()});
+		PropIt->SetVisibility(false);
+		PropIt->SetComponentTickEnabled(false);
+	}
+}
+
 // Returns main cinematic of this spot
 ULevelSequence* UNMMSpotComponent::GetMasterSequence() const
 {
@@ -107,6 +153,76 @@ void UNMMSpotComponent::SetCinematicState(ENMMCinematicState CinematicState)
 	CinematicStateInternal = CinematicState;
 }
 
+// Starts loading the master sequence asynchronously with given priority if it's not loaded or loading yet
+void UNMMSpotComponent::PreloadMasterSequence(int32 Priority)
+{
+	if (MasterPlayerInternal
+		|| MasterSequenceHandleInternal.IsValid())
+	{
+		// Is already created or loading
+		return;
+	}
+
+	const TSoftObjectPtr<ULevelSequence> FoundMasterSequence = CinematicRowInternal.LevelSequence;
+	if (!ensureMsgf(!FoundMasterSequence.IsNull(), TEXT("'LevelSequenceToLoad' is not found, can not play cinematic for '%s' spot."), *GetNameSafe(this)))
+	{
+		return;
+	}
+
+	if (FoundMasterSequence.IsValid())
+	{
+		OnMasterSequenceLoaded(FoundMasterSequence);
+		return;
+	}
+
+	FStreamableManager& StreamableManager = UAssetManager::Get().GetStreamableManager();
+	MasterSequenceHandleInternal = StreamableManager.RequestAsyncLoad(FoundMasterSequence.ToSoftObjectPath(),
+	                                                                  FStreamableDelegate::CreateUObject(this, &ThisClass::OnMasterSequenceLoaded, FoundMasterSequence),
+	                                                                  Priority);
+}
+
+// Destroys the master sequence player and cancels its loading, so the sequence can be garbage collected
+void UNMMSpotComponent::UnloadMasterSequence()
+{
+	if (IsActiveSpot())
+	{
+		// Active spot is always kept loaded
+		return;
+	}
+
+	ReleaseMasterSequenceHandle();
+
+	if (MasterPlayerInternal)
+	{
+		MasterPlayerInternal->OnPause.RemoveAll(this);
+		MasterPlayerInternal->Stop();
+		MasterPlayerInternal->ConditionalBeginDestroy();
+		MasterPlayerInternal = nullptr;
+	}
+
+	CinematicStateInternal = ENMMCinematicState::None;
+}
+
+// Cancels loading of the master sequence if it's in progress and resets its handle
+void UNMMSpotComponent::ReleaseMasterSequenceHandle()
+{
+	if (!MasterSequenceHandleInternal.IsValid())
+	{
+		return;
+	}
+
+	if (MasterSequenceHandleInternal->IsLoadingInProgress())
+	{
+		MasterSequenceHandleInternal->CancelHandle();
+	}
+	else
+	{
+		MasterSequenceHandleInternal->ReleaseHandle();
+	}
+
+	MasterSequenceHandleInternal.Reset();
+}
+
 // Overridable native event for when play begins for this actor.
 void UNMMSpotComponent::BeginPlay()
 {
@@ -119,10 +235,10 @@ void UNMMSpotComponent::BeginPlay()
 		return;
 	}
 
-	UNMMSubsystem::Get().AddNewMainMenuSpot(this);
-
 	UpdateCinematicData();
-	LoadMasterSequencePlayer();
+
+	// Master sequence is loaded by the subsystem only if this spot is close to the active one
+	UNMMSubsystem::Get().AddNewMainMenuSpot(this);
 
 	// Listen states to spawn widgets
 	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
@@ -140,6 +256,8 @@ void UNMMSpotComponent::OnUnregister()
 {
 	CinematicRowInternal = FNMMCinematicRow::Empty;
 
+	ReleaseMasterSequenceHandle();
+
 	// Kill current cinematic player
 	if (MasterPlayerInternal)
 	{
@@ -193,37 +311,15 @@ void UNMMSpotComponent::BindOnGameStateChanged(AMyGameStateBase* MyGameState)
 	}
 
 	// Listen states to handle this widget behavior
-	MyGameState->OnGameStateChanged.AddUniqueDynamic(this, &ThisClass::OnGameStateChanged);
+	MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 }
 
 // Obtains and caches cinematic data from the table to this spot
 void UNMMSpotComponent::UpdateCinematicData()
 {
-	const UDataTable* CinematicsDataTable = UNMMDataAsset::Get().GetCinematicsDataTable();
-	if (!ensureMsgf(CinematicsDataTable, TEXT("'CinematicsDataTable' is nullptr, can not play cinematic for '%s' spot."), *GetNameSafe(this)))
-	{
-		return;
-	}
-
-	const FPlayerTag& PlayerTag = GetMeshChecked().GetPlayerTag();
-
-	int32 RowIndex = 0;
-	TMap<FName, FNMMCinematicRow> CinematicsRows;
-	UMyDataTable::GetRows(*CinematicsDataTable, CinematicsRows);
-	for (const TTuple<FName, FNMMCinematicRow>& RowIt : CinematicsRows)
-	{
-		if (RowIt.Value.PlayerTag == PlayerTag)
-		{
-			CinematicRowInternal = RowIt.Value;
-			break;
-		}
-		++RowIndex;
-	}
-
-	if (ensureMsgf(!CinematicRowInternal.IsEmpty(), TEXT("%s: 'CinematicRowInternal' is not found for '%s' spot."), *FString(__FUNCTION__), *GetNameSafe(this)))
-	{
-		CinematicRowInternal.RowIndex = RowIndex;
-	}
+	// The table is parsed once by the subsystem for all spots
+	CinematicRowInternal = UNMMSubsystem::Get().FindCinematicRow(GetMeshChecked().GetPlayerTag());
+	ensureMsgf(!CinematicRowInternal.IsEmpty(), TEXT("%s: 'CinematicRowInternal' is not found for '%s' spot."), *FString(__FUNCTION__), *GetNameSafe(this));
 }
 
 // Loads cinematic of this spot
@@ -235,24 +331,8 @@ void UNMMSpotComponent::LoadMasterSequencePlayer()
 		return;
 	}
 
-	const TSoftObjectPtr<ULevelSequence> FoundMasterSequence = CinematicRowInternal.LevelSequence;
-	if (!ensureMsgf(!FoundMasterSequence.IsNull(), TEXT("'LevelSequenceToLoad' is not found, can not play cinematic for '%s' spot."), *GetNameSafe(this)))
-	{
-		return;
-	}
-
-	if (FoundMasterSequence.IsValid())
-	{
-		OnMasterSequenceLoaded(FoundMasterSequence);
-	}
-	else
-	{
-		const TAsyncLoadPriority Priority = IsActiveSpot() ? FStreamableManager::AsyncLoadHighPriority : FStreamableManager::DefaultAsyncLoadPriority;
-		FStreamableManager& StreamableManager = UAssetManager::Get().GetStreamableManager();
-		StreamableManager.RequestAsyncLoad(FoundMasterSequence.ToSoftObjectPath(),
-		                                   FStreamableDelegate::CreateUObject(this, &ThisClass::OnMasterSequenceLoaded, FoundMasterSequence),
-		                                   Priority);
-	}
+	const TAsyncLoadPriority Priority = IsActiveSpot() ? FStreamableManager::AsyncLoadHighPriority : FStreamableManager::DefaultAsyncLoadPriority;
+	PreloadMasterSequence(Priority);
 }
 
 // Starts viewing through camera of current cinematic
@@ -308,6 +388,9 @@ void UNMMSpotComponent::OnMasterSequenceLoaded(TSoftObjectPtr<ULevelSequence> Lo
 		return;
 	}
 
+	// The player references the sequence from now, so the handle is not needed anymore
+	ReleaseMasterSequenceHandle();
+
 	// Create and cache the master sequence
 	ALevelSequenceActor* OutActor = nullptr;
 	MasterPlayerInternal = ULevelSequencePlayer::CreateLevelSequencePlayer(this, LoadedMasterSequence.Get(), {}, OutActor);
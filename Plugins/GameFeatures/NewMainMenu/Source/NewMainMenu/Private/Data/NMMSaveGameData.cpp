@@ -2,6 +2,9 @@
 
 #include "Data/NMMSaveGameData.h"
 //---
+#include "Data/NMMDataAsset.h"
+//---
+#include "Async/Async.h"
 #include "Kismet/GameplayStatics.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(NMMSaveGameData)
@@ -16,7 +19,136 @@ const FString& UNMMSaveGameData::GetSaveSlotName()
 // Performs the save operation on the background thread
 void UNMMSaveGameData::SaveDataAsync()
 {
-	UGameplayStatics::AsyncSaveGameToSlot(this, GetSaveSlotName(), GetSaveSlotIndex());
+	if (SaveTickerHandleInternal.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SaveTickerHandleInternal);
+		SaveTickerHandleInternal.Reset();
+	}
+
+	if (bIsSavingInternal)
+	{
+		// Will be saved once current write is finished
+		bIsSaveDirtyInternal = true;
+		return;
+	}
+
+	// Data is serialized on the game thread, only the write is done in background
+	TSharedRef<TArray<uint8>> SaveData = MakeShared<TArray<uint8>>();
+	if (!UGameplayStatics::SaveGameToMemory(this, *SaveData))
+	{
+		ensureMsgf(false, TEXT("%s: Failed to serialize '%s' slot"), *FString(__FUNCTION__), *GetSaveSlotName());
+		return;
+	}
+
+	bIsSaveDirtyInternal = false;
+	bIsSavingInternal = true;
+	LastSaveTimeInternal = FPlatformTime::Seconds();
+
+	// Is written by own task instead of AsyncSaveGameToSlot, so the flush could wait for it
+	TWeakObjectPtr<ThisClass> WeakThis(this);
+	SaveFutureInternal = Async(EAsyncExecution::ThreadPool, [WeakThis, SaveData]()
+	{
+		const FString& SlotName = GetSaveSlotName();
+		const int32 UserIndex = GetSaveSlotIndex();
+		const bool bSuccess = UGameplayStatics::SaveDataToSlot(*SaveData, SlotName, UserIndex);
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, SlotName, UserIndex, bSuccess]()
+		{
+			if (ThisClass* This = WeakThis.Get())
+			{
+				This->OnAsyncSaveCompleted(SlotName, UserIndex, bSuccess);
+			}
+		});
+		return bSuccess;
+	});
+}
+
+// Marks the data as changed to be saved on the background thread, all changes are coalesced into one write per min save interval
+void UNMMSaveGameData::RequestSave()
+{
+	bIsSaveDirtyInternal = true;
+
+	if (bIsSavingInternal
+		|| SaveTickerHandleInternal.IsValid())
+	{
+		// Will be saved once current write is finished or the scheduled one is started
+		return;
+	}
+
+	const double ElapsedSinceLastSave = FPlatformTime::Seconds() - LastSaveTimeInternal;
+	const float Delay = FMath::Max(0.f, UNMMDataAsset::Get().GetMinSaveInterval() - static_cast<float>(ElapsedSinceLastSave));
+	SaveTickerHandleInternal = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnSaveTickerElapsed), Delay);
+}
+
+// Writes pending changes synchronously if any, is called on shutdown when the delayed save can't be awaited
+void UNMMSaveGameData::FlushPendingSave()
+{
+	if (SaveTickerHandleInternal.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SaveTickerHandleInternal);
+		SaveTickerHandleInternal.Reset();
+	}
+
+	// Same slot can't be written by both threads at once, so the background write is finished first
+	if (SaveFutureInternal.IsValid())
+	{
+		SaveFutureInternal.Wait();
+		SaveFutureInternal.Reset();
+		bIsSavingInternal = false;
+	}
+
+	if (bIsSaveDirtyInternal)
+	{
+		bIsSaveDirtyInternal = false;
+		LastSaveTimeInternal = FPlatformTime::Seconds();
+		UGameplayStatics::SaveGameToSlot(this, GetSaveSlotName(), GetSaveSlotIndex());
+	}
+}
+
+// Is called when the delay of the scheduled write is elapsed
+bool UNMMSaveGameData::OnSaveTickerElapsed(float DeltaTime)
+{
+	SaveTickerHandleInternal.Reset();
+
+	if (bIsSaveDirtyInternal)
+	{
+		SaveDataAsync();
+	}
+
+	// Is one-shot
+	return false;
+}
+
+// Is called when the background write is finished
+void UNMMSaveGameData::OnAsyncSaveCompleted(const FString& SlotName, int32 UserIndex, bool bSuccess)
+{
+	if (!bIsSavingInternal)
+	{
+		// Was already awaited by the flush
+		return;
+	}
+
+	bIsSavingInternal = false;
+	SaveFutureInternal.Reset();
+
+	ensureMsgf(bSuccess, TEXT("%s: Failed to save '%s' slot"), *FString(__FUNCTION__), *SlotName);
+
+	// Data could be changed while writing
+	if (bIsSaveDirtyInternal)
+	{
+		RequestSave();
+	}
+}
+
+// Removes the scheduled write
+void UNMMSaveGameData::BeginDestroy()
+{
+	if (SaveTickerHandleInternal.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SaveTickerHandleInternal);
+		SaveTickerHandleInternal.Reset();
+	}
+
+	Super::BeginDestroy();
 }
 
 // Adds given cinematic to the list of cinematics have seen by the player
@@ -27,6 +159,6 @@ void UNMMSaveGameData::MarkCinematicAsSeen(int32 CinematicRowIndex)
 	if (bIsNewCinematic)
 	{
 		AllSeenCinematicsBitmaskInternal |= Bitmask;
-		SaveDataAsync();
+		RequestSave();
 	}
 }
@@ -5,8 +5,12 @@
 #include "NMMUtils.h"
 #include "Components/NMMSpotComponent.h"
 #include "Data/NMMDataAsset.h"
+#include "MyDataTable/MyDataTable.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
+#include "Algo/BinarySearch.h"
+#include "Engine/StreamableManager.h"
+//---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(NMMSubsystem)
 
 // Returns this Subsystem, is checked and wil crash if can't be obtained
@@ -26,102 +30,194 @@ const UNMMDataAsset* UNMMSubsystem::GetNewMainMenuDataAsset() const
 // Add new Main-Menu spot, so it can be obtained by other objects
 void UNMMSubsystem::AddNewMainMenuSpot(UNMMSpotComponent* NewMainMenuSpotComponent)
 {
-	if (ensureMsgf(NewMainMenuSpotComponent, TEXT("%s: 'NewMainMenuSpotComponent' is null"), *FString(__FUNCTION__)))
+	if (!ensureMsgf(NewMainMenuSpotComponent, TEXT("%s: 'NewMainMenuSpotComponent' is null"), *FString(__FUNCTION__))
+		|| MainMenuSpotsInternal.Contains(NewMainMenuSpotComponent))
+	{
+		return;
+	}
+
+	MainMenuSpotsInternal.Emplace(NewMainMenuSpotComponent);
+
+	const FNMMCinematicRow& CinematicRow = NewMainMenuSpotComponent->GetCinematicRow();
+	if (!CinematicRow.IsEmpty())
 	{
-		MainMenuSpotsInternal.AddUnique(NewMainMenuSpotComponent);
+		// Insert by the row index to keep the array sorted
+		TArray<TObjectPtr<UNMMSpotComponent>>& LevelTypeSpots = SpotsByLevelTypeInternal.FindOrAdd(CinematicRow.LevelType);
+		const int32 InsertPosition = Algo::UpperBoundBy(LevelTypeSpots, CinematicRow.RowIndex, [](const UNMMSpotComponent* SpotIt) { return SpotIt->GetCinematicRow().RowIndex; });
+		LevelTypeSpots.Insert(NewMainMenuSpotComponent, InsertPosition);
+
+		if (CinematicRow.RowIndex == ActiveMainMenuSpotIdx)
+		{
+			ActiveMainMenuSpotInternal = NewMainMenuSpotComponent;
+		}
 	}
+
+	UpdatePreloadedSpots();
 }
 
 // Removes Main-Menu spot if should not be available by other objects anymore
 void UNMMSubsystem::RemoveMainMenuSpot(UNMMSpotComponent* MainMenuSpotComponent)
 {
-	if (ensureMsgf(MainMenuSpotComponent, TEXT("%s: 'MainMenuSpotComponent' is null"), *FString(__FUNCTION__)))
+	if (!ensureMsgf(MainMenuSpotComponent, TEXT("%s: 'MainMenuSpotComponent' is null"), *FString(__FUNCTION__)))
 	{
-		MainMenuSpotsInternal.RemoveSwap(MainMenuSpotComponent);
+		return;
 	}
-}
 
-// Returns currently selected Main-Menu spot
-UNMMSpotComponent* UNMMSubsystem::GetActiveMainMenuSpotComponent() const
-{
-	for (UNMMSpotComponent* MainMenuSpotComponent : MainMenuSpotsInternal)
+	MainMenuSpotsInternal.RemoveSwap(MainMenuSpotComponent);
+
+	// Spot's row could be already reset, so remove it from all level types keeping the order
+	for (TTuple<ELevelType, TArray<TObjectPtr<UNMMSpotComponent>>>& It : SpotsByLevelTypeInternal)
 	{
-		if (MainMenuSpotComponent && MainMenuSpotComponent->GetCinematicRow().RowIndex == ActiveMainMenuSpotIdx)
-		{
-			return MainMenuSpotComponent;
-		}
+		It.Value.Remove(MainMenuSpotComponent);
 	}
 
-	return nullptr;
+	if (ActiveMainMenuSpotInternal == MainMenuSpotComponent)
+	{
+		ActiveMainMenuSpotInternal = nullptr;
+	}
 }
 
 // Returns Main-Menu spots by given level type
 void UNMMSubsystem::GetMainMenuSpotsByLevelType(TArray<UNMMSpotComponent*>& OutSpots, ELevelType LevelType) const
 {
-	for (UNMMSpotComponent* MainMenuSpotComponent : MainMenuSpotsInternal)
+	// Is already sorted by the RowIndex
+	OutSpots.Append(GetSortedSpotsByLevelType(LevelType));
+}
+
+// Returns Main-Menu spots by given level type sorted by their row index without copying, is empty if there are no spots
+const TArray<TObjectPtr<UNMMSpotComponent>>& UNMMSubsystem::GetSortedSpotsByLevelType(ELevelType LevelType) const
+{
+	static const TArray<TObjectPtr<UNMMSpotComponent>> EmptySpots;
+	const TArray<TObjectPtr<UNMMSpotComponent>>* FoundSpots = SpotsByLevelTypeInternal.Find(LevelType);
+	return FoundSpots ? *FoundSpots : EmptySpots;
+}
+
+// Returns the first cinematic row of given player in the table, the cinematics table is parsed once on first request
+const FNMMCinematicRow& UNMMSubsystem::FindCinematicRow(const FPlayerTag& PlayerTag)
+{
+	if (CinematicRowsInternal.IsEmpty())
 	{
-		if (MainMenuSpotComponent
-			&& MainMenuSpotComponent->GetCinematicRow().LevelType == LevelType)
-		{
-			OutSpots.AddUnique(MainMenuSpotComponent);
-		}
+		BuildCinematicRows();
 	}
 
-	// Sort the array based on the RowIndex
-	OutSpots.Sort([](const UNMMSpotComponent& A, const UNMMSpotComponent& B)
+	const int32* FoundIndex = FirstCinematicRowIndicesInternal.Find(PlayerTag);
+
+	return FoundIndex && CinematicRowsInternal.IsValidIndex(*FoundIndex) ? CinematicRowsInternal[*FoundIndex] : FNMMCinematicRow::Empty;
+}
+
+// Parses the cinematics table into CinematicRowsInternal and its indices
+void UNMMSubsystem::BuildCinematicRows()
+{
+	CinematicRowsInternal.Empty();
+	FirstCinematicRowIndicesInternal.Empty();
+
+	const UNMMDataAsset* DataAsset = GetNewMainMenuDataAsset();
+	const UDataTable* CinematicsDataTable = DataAsset ? DataAsset->GetCinematicsDataTable() : nullptr;
+	if (!ensureMsgf(CinematicsDataTable, TEXT("%s: 'CinematicsDataTable' is nullptr, can not play cinematics."), *FString(__FUNCTION__)))
 	{
-		return A.GetCinematicRow().RowIndex < B.GetCinematicRow().RowIndex;
+		return;
+	}
+
+	CinematicRowsInternal.Reserve(CinematicsDataTable->GetRowMap().Num());
+	UMyDataTable::ForEachRow<FNMMCinematicRow>(*CinematicsDataTable, [this](FName RowName, const FNMMCinematicRow& RowIt)
+	{
+		// Row index is the position in the table
+		const int32 RowIndex = CinematicRowsInternal.Emplace(RowIt);
+		CinematicRowsInternal[RowIndex].RowIndex = RowIndex;
+
+		// Only the first row of each player is picked
+		FirstCinematicRowIndicesInternal.FindOrAdd(RowIt.PlayerTag, RowIndex);
 	});
 }
 
 // Goes to another Spot to show another player character on current level
 UNMMSpotComponent* UNMMSubsystem::MoveMainMenuSpot(int32 Incrementer)
 {
-	// Get all rows of current level type
+	// Get all spots of current level type, they are already sorted by row indices
 	const ELevelType CurrentLevelType = UMyBlueprintFunctionLibrary::GetLevelType();
-	TArray<UNMMSpotComponent*> CurrentLevelTypeSpots;
-	GetMainMenuSpotsByLevelType(/*out*/CurrentLevelTypeSpots, CurrentLevelType);
-
-	// Extract the row indices, so we can track the bounds
-	TArray<int32> SpotRowIndices;
-	for (const UNMMSpotComponent* SpotIt : CurrentLevelTypeSpots)
-	{
-		SpotRowIndices.AddUnique(SpotIt->GetCinematicRow().RowIndex);
-	}
+	const TArray<TObjectPtr<UNMMSpotComponent>>& CurrentLevelTypeSpots = GetSortedSpotsByLevelType(CurrentLevelType);
 
-	const bool bFoundActiveIdx = SpotRowIndices.Contains(ActiveMainMenuSpotIdx);
-	if (!ensureMsgf(bFoundActiveIdx, TEXT("%s: 'ActiveMainMenuSpotIdx' is not found in the 'SpotRowIndices'"), *FString(__FUNCTION__)))
+	const int32 ActiveSpotPosition = Algo::BinarySearchBy(CurrentLevelTypeSpots, ActiveMainMenuSpotIdx, [](const UNMMSpotComponent* SpotIt) { return SpotIt->GetCinematicRow().RowIndex; });
+	if (!ensureMsgf(ActiveSpotPosition != INDEX_NONE, TEXT("%s: 'ActiveMainMenuSpotIdx' is not found in the 'CurrentLevelTypeSpots'"), *FString(__FUNCTION__)))
 	{
 		// Most likely the level is switched that could be not supported yet
 		return nullptr;
 	}
 
 	// Stop the current spot
-	const int32 ActiveSpotPosition = SpotRowIndices.IndexOfByKey(ActiveMainMenuSpotIdx);
-	checkf(CurrentLevelTypeSpots.IsValidIndex(ActiveSpotPosition), TEXT("ERROR: [%i] %s:\n'CurrentLevelTypeSpots array has to have ActiveSpotPosition index since it's the same size as SpotRowIndices array!"), __LINE__, *FString(__FUNCTION__))
 	UNMMSpotComponent* CurrentSpot = CurrentLevelTypeSpots[ActiveSpotPosition];
 	checkf(CurrentSpot, TEXT("ERROR: [%i] %s:\n'CurrentSpot' can't be null since CurrentLevelTypeSpots array does not contain nulls!"), __LINE__, *FString(__FUNCTION__))
 	CurrentSpot->StopMasterSequence();
 
 	// Find the new index based on the incrementer
 	// If there is no next spot in array, it will take the first one with its index and vise versa for decrementing
-	const int32 NewSpotIndex = (ActiveSpotPosition + Incrementer + SpotRowIndices.Num()) % SpotRowIndices.Num();
-	ActiveMainMenuSpotIdx = SpotRowIndices[NewSpotIndex];
-
-	// Play the new spot
-	checkf(CurrentLevelTypeSpots.IsValidIndex(NewSpotIndex), TEXT("ERROR: [%i] %s:\n'CurrentLevelTypeSpots array has to have NewSpotIndex since it's the same size as SpotRowIndices array!"), __LINE__, *FString(__FUNCTION__));
+	const int32 SpotsNum = CurrentLevelTypeSpots.Num();
+	const int32 NewSpotIndex = ((ActiveSpotPosition + Incrementer) % SpotsNum + SpotsNum) % SpotsNum;
 	UNMMSpotComponent* NewSpot = CurrentLevelTypeSpots[NewSpotIndex];
 	checkf(NewSpot, TEXT("ERROR: [%i] %s:\n'NewSpot' can't be null since CurrentLevelTypeSpots array does not contain nulls!"), __LINE__, *FString(__FUNCTION__));
+	ActiveMainMenuSpotIdx = NewSpot->GetCinematicRow().RowIndex;
+	ActiveMainMenuSpotInternal = NewSpot;
+	NewSpot->SetDormant(false);
+
+	// Play the new spot
 	NewSpot->SetCinematicState(ENMMCinematicState::IdlePart);
 
+	// Move the preload window, so next spots are loaded in advance
+	UpdatePreloadedSpots();
+
 	return NewSpot;
 }
 
+// Keeps master sequences loaded only for the active spot and its neighbours within the preload distance, others are unloaded
+void UNMMSubsystem::UpdatePreloadedSpots()
+{
+	const UNMMSpotComponent* ActiveSpot = GetActiveMainMenuSpotComponent();
+	if (!ActiveSpot)
+	{
+		// Active spot is not registered yet, the window will be updated once it's added
+		return;
+	}
+
+	// Spots are browsed in a loop, so the distance is taken in both directions
+	const TArray<TObjectPtr<UNMMSpotComponent>>& ActiveLevelTypeSpots = GetSortedSpotsByLevelType(ActiveSpot->GetCinematicRow().LevelType);
+	const int32 SpotsNum = ActiveLevelTypeSpots.Num();
+	const int32 ActiveSpotPosition = ActiveLevelTypeSpots.IndexOfByKey(ActiveSpot);
+
+	for (UNMMSpotComponent* SpotIt : MainMenuSpotsInternal)
+	{
+		if (!SpotIt
+			|| SpotIt->GetCinematicRow().IsEmpty())
+		{
+			continue;
+		}
+
+		const int32 SpotPosition = ActiveLevelTypeSpots.IndexOfByKey(SpotIt);
+		const int32 ForwardDistance = (SpotPosition - ActiveSpotPosition + SpotsNum) % FMath::Max(SpotsNum, 1);
+		const int32 Distance = SpotPosition != INDEX_NONE ? FMath::Min(ForwardDistance, SpotsNum - ForwardDistance) : MAX_int32;
+
+		// Only the active spot is animated, so the menu cost does not scale with the number of spots
+		SpotIt->SetDormant(SpotIt != ActiveSpot);
+		if (Distance > PreloadSpotsDistanceInternal)
+		{
+			SpotIt->UnloadMasterSequence();
+			continue;
+		}
+
+		// Active spot is loaded first, then its closest neighbours
+		const TAsyncLoadPriority Priority = FStreamableManager::AsyncLoadHighPriority / (Distance + 1);
+		SpotIt->PreloadMasterSequence(Priority);
+	}
+}
+
 // Clears all transient data contained in this subsystem
 void UNMMSubsystem::Deinitialize()
 {
 	NewMainMenuDataAssetInternal.Reset();
 	MainMenuSpotsInternal.Empty();
+	SpotsByLevelTypeInternal.Empty();
+	ActiveMainMenuSpotInternal = nullptr;
+	CinematicRowsInternal.Empty();
+	FirstCinematicRowIndicesInternal.Empty();
 
 	Super::Deinitialize();
 }
@@ -55,7 +55,7 @@ void UNMMCinematicStateWidget::BindOnGameStateChanged(AMyGameStateBase* MyGameSt
 	checkf(MyGameState, TEXT("ERROR: 'MyGameState' is null!"));
 
 	// Listen states to handle this widget behavior
-	MyGameState->OnGameStateChanged.AddUniqueDynamic(this, &ThisClass::OnGameStateChanged);
+	MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 	if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
 	{
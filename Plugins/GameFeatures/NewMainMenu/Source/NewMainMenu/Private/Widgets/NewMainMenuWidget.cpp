@@ -87,7 +87,7 @@ void UNewMainMenuWidget::BindOnGameStateChanged(AMyGameStateBase* MyGameState)
 	checkf(MyGameState, TEXT("ERROR: 'MyGameState' is null!"));
 
 	// Listen states to handle this widget behavior
-	MyGameState->OnGameStateChanged.AddUniqueDynamic(this, &ThisClass::OnGameStateChanged);
+	MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 	if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
 	{
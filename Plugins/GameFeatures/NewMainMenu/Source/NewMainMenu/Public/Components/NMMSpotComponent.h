@@ -12,6 +12,8 @@ enum class ECurrentGameState : uint8;
 
 class ULevelSequence;
 
+struct FStreamableHandle;
+
 /**
  * Represents a spot where a character can be selected in the Main Menu.
  * Is added dynamically to the My Skeletal Mesh actors on the level.
@@ -37,6 +39,16 @@ public:
 	class UMySkeletalMeshComponent* GetMySkeletalMeshComponent() const;
 	class UMySkeletalMeshComponent& GetMeshChecked() const;
 
+	/** Returns true if this spot is dormant: its mesh is not animated and its props are hidden.
+	 * @see UNMMSpotComponent::bIsDormantInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsDormant() const { return bIsDormantInternal; }
+
+	/** Stops ticking and animating the mesh of this spot and hides its props, all of it is restored once the spot is woken up.
+	 * Is called by the subsystem for all spots that are not active, does nothing to make the active spot dormant. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void SetDormant(bool bInDormant);
+
 	/*********************************************************************************************
 	 * Cinematics
 	 ********************************************************************************************* */
@@ -62,6 +74,16 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void SetCinematicState(ENMMCinematicState CinematicState);
 
+	/** Starts loading the master sequence asynchronously with given priority if it's not loaded or loading yet.
+	 * Is called by the subsystem for spots around the active one, so switching spots has no load delay. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void PreloadMasterSequence(int32 Priority);
+
+	/** Destroys the master sequence player and cancels its loading, so the sequence can be garbage collected.
+	 * Is called by the subsystem for spots that are far from the active one, does nothing for the active spot. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void UnloadMasterSequence();
+
 	/*********************************************************************************************
 	 * Protected properties
 	 ********************************************************************************************* */
@@ -78,6 +100,24 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Cinematic State"))
 	ENMMCinematicState CinematicStateInternal = ENMMCinematicState::None;
 
+	/** Is true when the mesh of this spot is not animated and its props are hidden since the spot is not active. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Dormant"))
+	bool bIsDormantInternal = false;
+
+	/** Props of the mesh that were visible or ticking when the spot became dormant, only they are restored once the spot is woken up. */
+	struct FDormantProp
+	{
+		TWeakObjectPtr<class UMeshComponent> Prop = nullptr;
+		bool bWasVisible = false;
+		bool bWasTickEnabled = false;
+	};
+
+	/** Props that are hidden or stopped by the dormancy of this spot, @see UNMMSpotComponent::SetDormant. */
+	TArray<FDormantProp> DormantPropsInternal;
+
+	/** Handle of the master sequence while it's loading asynchronously. */
+	TSharedPtr<FStreamableHandle> MasterSequenceHandleInternal = nullptr;
+
 	/*********************************************************************************************
 	 * Protected functions
 	 ********************************************************************************************* */
@@ -105,6 +145,9 @@ protected:
 	/** Is called when the cinematic was loaded to finish creation. */
 	void OnMasterSequenceLoaded(TSoftObjectPtr<ULevelSequence> LoadedMasterSequence);
 
+	/** Cancels loading of the master sequence if it's in progress and resets its handle. */
+	void ReleaseMasterSequenceHandle();
+
 	/** Starts viewing through camera of current cinematic or gameplay one depending on given state. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void PossessCamera(ENMMCinematicState CinematicState);
@@ -49,6 +49,11 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE USoundClass* GetCinematicsSoundClass() const { return CinematicsSoundClassInternal; }
 
+	/** Returns the minimal time between two writes of the save game.
+	 * @see UNMMDataAsset::MinSaveIntervalInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetMinSaveInterval() const { return MinSaveIntervalInternal; }
+
 protected:
 	/** The data table with the cinematics to be played. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Cinematics Data Table", ShowOnlyInnerProperties))
@@ -69,4 +74,8 @@ protected:
 	/** The sound of cinematics music. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Music Sound Class", ShowOnlyInnerProperties))
 	TObjectPtr<class USoundClass> CinematicsSoundClassInternal = nullptr;
+
+	/** The minimal time in seconds between two writes of the save game, all changes during this time are saved at once. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Min Save Interval", ClampMin = "0", Units = "Seconds"))
+	float MinSaveIntervalInternal = 2.f;
 };
@@ -4,6 +4,9 @@
 
 #include "GameFramework/SaveGame.h"
 //---
+#include "Async/Future.h"
+#include "Containers/Ticker.h"
+//---
 #include "NMMSaveGameData.generated.h"
 
 /**
@@ -27,6 +30,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void SaveDataAsync();
 
+	/** Marks the data as changed to be saved on the background thread, all changes are coalesced into one write per min save interval.
+	 * @see UNMMDataAsset::MinSaveIntervalInternal */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void RequestSave();
+
+	/** Writes pending changes synchronously if any, is called on shutdown when the delayed save can't be awaited. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void FlushPendingSave();
+
 	/** Returns true if given cinematic has been seen by player. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE bool HasCinematicBeenSeen(int32 CinematicRowIndex) const { return (AllSeenCinematicsBitmaskInternal & (1 << CinematicRowIndex)) != 0; }
@@ -40,4 +52,28 @@ protected:
 	 * Is bitmask instead of array since there are less than 32 cinematics in New Main Menu. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, SaveGame, Category = "C++", DisplayName = "Cinematics Played Bitmask")
 	int32 AllSeenCinematicsBitmaskInternal = 0;
+
+	/** Is true when there are changes that are not written yet. */
+	bool bIsSaveDirtyInternal = false;
+
+	/** Is true while the background write is in progress. */
+	bool bIsSavingInternal = false;
+
+	/** Result of the background write, allows to wait for it before the same slot is written synchronously. */
+	TFuture<bool> SaveFutureInternal;
+
+	/** The time in seconds when the last write was started. */
+	double LastSaveTimeInternal = 0.0;
+
+	/** The handle of the scheduled write, is world-independent since the save game is not outered to any world. */
+	FTSTicker::FDelegateHandle SaveTickerHandleInternal;
+
+	/** Is called when the delay of the scheduled write is elapsed. */
+	bool OnSaveTickerElapsed(float DeltaTime);
+
+	/** Is called when the background write is finished. */
+	void OnAsyncSaveCompleted(const FString& SlotName, int32 UserIndex, bool bSuccess);
+
+	/** Removes the scheduled write. */
+	virtual void BeginDestroy() override;
 };
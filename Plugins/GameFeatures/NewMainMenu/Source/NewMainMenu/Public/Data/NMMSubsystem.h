@@ -4,10 +4,10 @@
 
 #include "Subsystems/WorldSubsystem.h"
 //---
+#include "Data/NMMTypes.h"
+//---
 #include "NMMSubsystem.generated.h"
 
-enum class ELevelType : uint8;
-
 class UNMMSpotComponent;
 
 /**
@@ -41,20 +41,35 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void RemoveMainMenuSpot(UNMMSpotComponent* MainMenuSpotComponent);
 
-	/** Returns currently selected Main-Menu spot. */
+	/** Returns currently selected Main-Menu spot.
+	 * @see UNMMSubsystem::ActiveMainMenuSpotInternal */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	UNMMSpotComponent* GetActiveMainMenuSpotComponent() const;
+	FORCEINLINE UNMMSpotComponent* GetActiveMainMenuSpotComponent() const { return ActiveMainMenuSpotInternal; }
 
 	/** Returns Main-Menu spots by given level type. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	void GetMainMenuSpotsByLevelType(TArray<UNMMSpotComponent*>& OutSpots, ELevelType LevelType) const;
 
+	/** Returns Main-Menu spots by given level type sorted by their row index without copying, is empty if there are no spots. */
+	const TArray<TObjectPtr<UNMMSpotComponent>>& GetSortedSpotsByLevelType(ELevelType LevelType) const;
+
+	/** Returns the first cinematic row of given player in the table, the cinematics table is parsed once on first request.
+	 * Empty row is returned if nothing is found.
+	 * @see UNMMSubsystem::CinematicRowsInternal */
+	const FNMMCinematicRow& FindCinematicRow(const FPlayerTag& PlayerTag);
+
 	/** Goes to another Spot to show another player character on current level.
 	 * @param Incrementer 1 to move right, -1 to move left.
 	 * @return New active Main-Menu spot component. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	UNMMSpotComponent* MoveMainMenuSpot(int32 Incrementer);
 
+	/** Keeps master sequences loaded only for the active spot and its neighbours within the preload distance, others are unloaded.
+	 * Closer spots are loaded with higher priority, all spots except the active one are made dormant.
+	 * @see UNMMSubsystem::PreloadSpotsDistanceInternal */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void UpdatePreloadedSpots();
+
 protected:
 	/** Contains all the assets and tweaks of New Main Menu game feature.
 	 * Note: Since Subsystem is code-only, is is config property set in NewMainMenu.ini.
@@ -72,7 +87,30 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Active Main-Menu Spot Index"))
 	int32 ActiveMainMenuSpotIdx = 0;
 
+	/** Currently selected Main-Menu spot, is cached on add, remove and move of spots to not search it. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Active Main-Menu Spot"))
+	TObjectPtr<UNMMSpotComponent> ActiveMainMenuSpotInternal = nullptr;
+
+	/** All rows of the cinematics table with set row indices, is parsed once and shared by all spots. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Cinematic Rows"))
+	TArray<FNMMCinematicRow> CinematicRowsInternal;
+
+	/** Indices in CinematicRowsInternal of the first row of each player. */
+	TMap<FPlayerTag, int32> FirstCinematicRowIndicesInternal;
+
+	/** Main-Menu spots by level types, each array is kept sorted by the row index on add and remove, so navigation does not sort or allocate.
+	 * Is not UPROPERTY since all spots are referenced by MainMenuSpotsInternal. */
+	TMap<ELevelType, TArray<TObjectPtr<UNMMSpotComponent>>> SpotsByLevelTypeInternal;
+
+	/** How many spots on each side of the active one keep their master sequences loaded, is set in NewMainMenu.ini.
+	 * 1 means previous and next spots are preloaded, so the player browses characters without load delay. */
+	UPROPERTY(Config, VisibleInstanceOnly, BlueprintReadWrite, Category = "C++", meta = (BlueprintProtected, DisplayName = "Preload Spots Distance", ClampMin = "0"))
+	int32 PreloadSpotsDistanceInternal = 1;
+
 protected:
 	/** Clears all transient data contained in this subsystem. */
 	virtual void Deinitialize() override;
+
+	/** Parses the cinematics table into CinematicRowsInternal and its indices. */
+	void BuildCinematicRows();
 };
@@ -110,6 +110,18 @@ bool UUtilsLibrary::IsServer()
 	return World && !World->IsNetMode(NM_Client);
 }
 
+// Returns true if this instance is the dedicated server, including the dedicated server of multiplayer PIE
+bool UUtilsLibrary::IsDedicatedServer()
+{
+	if (IsRunningDedicatedServer())
+	{
+		return true;
+	}
+
+	const UWorld* World = GetPlayWorld();
+	return World && World->IsNetMode(NM_DedicatedServer);
+}
+
 // Returns true if viewport is initialized, is always true in PIE, but takes a while in builds
 bool UUtilsLibrary::IsViewportInitialized()
 {
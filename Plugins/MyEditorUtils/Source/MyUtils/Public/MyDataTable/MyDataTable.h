@@ -41,6 +41,13 @@ public:
 	template <typename T>
 	static void GetRows(const UDataTable& DataTable, TMap<FName, T>& OutRows);
 
+	/** Iterates the table rows without copying them, given rows point directly to the table's memory. */
+	template <typename T>
+	void ForEachRow(TFunctionRef<void(FName, const T&)> Function) const { ForEachRow<T>(*this, Function); }
+
+	template <typename T>
+	static void ForEachRow(const UDataTable& DataTable, TFunctionRef<void(FName, const T&)> Function);
+
 protected:
 #if WITH_EDITOR
 	friend FMyTableRow;
@@ -83,3 +90,21 @@ void UMyDataTable::GetRows(const UDataTable& DataTable, TMap<FName, T>& OutRows)
 		}
 	}
 }
+
+/** Iterates the table rows without copying them. */
+template <typename T>
+void UMyDataTable::ForEachRow(const UDataTable& DataTable, TFunctionRef<void(FName, const T&)> Function)
+{
+	if (!ensureAlwaysMsgf(DataTable.RowStruct && DataTable.RowStruct->IsChildOf(T::StaticStruct()), TEXT("ASSERT: 'RowStruct' is not child of specified struct")))
+	{
+		return;
+	}
+
+	for (const TTuple<FName, uint8*>& RowIt : DataTable.GetRowMap())
+	{
+		if (const T* FoundRowPtr = reinterpret_cast<const T*>(RowIt.Value))
+		{
+			Function(RowIt.Key, *FoundRowPtr);
+		}
+	}
+}
@@ -56,6 +56,11 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	static bool IsServer();
 
+	/** Returns true if this instance is the dedicated server, including the dedicated server of multiplayer PIE.
+	 * Is used to skip cosmetics like meshes, materials, VFX, sounds and props that nobody sees on the server. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsDedicatedServer();
+
 	/*********************************************************************************************
 	 * Viewport
 	 ********************************************************************************************* */
@@ -2,13 +2,70 @@
 
 #include "Bomber.h"
 //---
+#include "Engine/BomberTelemetry.h"
+#include "Engine/FrameSpikeCapture.h"
+#include "Engine/MyReplicationGraph.h"
+#include "Engine/StartupTimings.h"
+//---
+#include "Engine/NetDriver.h"
 #include "Kismet/GameplayStatics.h"
 //---
 #include "Modules/ModuleManager.h"
+#include "UObject/UObjectGlobals.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(Bomber)
 
-IMPLEMENT_PRIMARY_GAME_MODULE(FDefaultGameModuleImpl, Bomber, "Bomber");
+/**
+ * The primary module of the Bomber, creates own replication graph for net drivers.
+ */
+class FBomberModule final : public FDefaultGameModuleImpl
+{
+public:
+	/** Is called right after the module is loaded. */
+	virtual void StartupModule() override
+	{
+		STARTUP_TIMING_SCOPE(BomberModuleStartup);
+
+		UReplicationDriver::CreateReplicationDriverDelegate().BindLambda([](UNetDriver* ForNetDriver, const FURL& URL, UWorld* World) -> UReplicationDriver*
+		{
+			// Replays and beacons use default replication
+			const bool bIsGameNetDriver = ForNetDriver && ForNetDriver->NetDriverName == NAME_GameNetDriver;
+			return bIsGameNetDriver && UMyReplicationGraph::IsReplicationGraphEnabled() ? NewObject<UMyReplicationGraph>(GetTransientPackage()) : nullptr;
+		});
+
+		// Measure the map loading until the startup summary is printed
+		PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddLambda([](const FString& MapName)
+		{
+			FStartupTimings::BeginPhase(TEXT("MapLoad"));
+		});
+		PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddLambda([](UWorld* LoadedWorld)
+		{
+			FStartupTimings::EndPhase(TEXT("MapLoad"));
+		});
+
+		FFrameSpikeCapture::Initialize();
+		FBomberTelemetry::Initialize();
+	}
+
+	/** Is called before the module is unloaded. */
+	virtual void ShutdownModule() override
+	{
+		UReplicationDriver::CreateReplicationDriverDelegate().Unbind();
+
+		FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+		FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+		FFrameSpikeCapture::Deinitialize();
+		FBomberTelemetry::Deinitialize();
+	}
+
+private:
+	/** Handles of the map loading delegates that are used to measure the startup. */
+	FDelegateHandle PreLoadMapHandle;
+	FDelegateHandle PostLoadMapHandle;
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE(FBomberModule, Bomber, "Bomber");
 
 DEFINE_LOG_CATEGORY(LogBomber);
 
@@ -0,0 +1,132 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Components/DebugCellsComponent.h"
+//---
+#include "Components/TextRenderComponent.h"
+#include "GameFramework/Actor.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(DebugCellsComponent)
+
+bool FDebugCellLabel::operator==(const FDebugCellLabel& Other) const
+{
+	return Location.Equals(Other.Location)
+	       && Rotation.Equals(Other.Rotation)
+	       && FMath::IsNearlyEqual(WorldSize, Other.WorldSize)
+	       && Color == Other.Color
+	       && Text.Equals(Other.Text, ESearchCase::CaseSensitive);
+}
+
+// Sets default values for this component's properties
+UDebugCellsComponent::UDebugCellsComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+	bTickInEditor = true;
+}
+
+// Returns the debug cells component of given actor, creates it if is not added yet
+UDebugCellsComponent& UDebugCellsComponent::GetOrCreateDebugCellsComponent(AActor& Owner)
+{
+	if (UDebugCellsComponent* FoundComponent = Owner.FindComponentByClass<UDebugCellsComponent>())
+	{
+		return *FoundComponent;
+	}
+
+	UDebugCellsComponent& NewComponent = *NewObject<UDebugCellsComponent>(&Owner, NAME_None, RF_Transient);
+	NewComponent.RegisterComponent();
+	return NewComponent;
+}
+
+// Marks all displayed labels as unused, are hidden at the end of the frame unless are displayed again
+void UDebugCellsComponent::ClearLabels()
+{
+	if (!UsedNumInternal)
+	{
+		return;
+	}
+
+	UsedNumInternal = 0;
+	SetComponentTickEnabled(true);
+}
+
+// Shows given label by next unused text render, the text render is updated only if it shows another label
+void UDebugCellsComponent::AddLabel(const FDebugCellLabel& Label)
+{
+	AActor* Owner = GetOwner();
+	if (!Owner)
+	{
+		return;
+	}
+
+	const int32 LabelIndex = UsedNumInternal++;
+	if (!TextRendersInternal.IsValidIndex(LabelIndex))
+	{
+		UTextRenderComponent& NewTextRender = *NewObject<UTextRenderComponent>(Owner, NAME_None, RF_Transient);
+		NewTextRender.SetAbsolute(true, true, true);
+		NewTextRender.SetHorizontalAlignment(EHTA_Center);
+		NewTextRender.SetVerticalAlignment(EVRTA_TextCenter);
+		NewTextRender.RegisterComponent();
+		TextRendersInternal.Emplace(&NewTextRender);
+		ShownLabelsInternal.AddDefaulted();
+	}
+
+	UTextRenderComponent* TextRender = TextRendersInternal[LabelIndex];
+	if (!ensureMsgf(TextRender, TEXT("ASSERT: [%i] %s:\n'TextRender' is null!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	if (!TextRender->IsVisible())
+	{
+		TextRender->SetVisibility(true);
+	}
+
+	FDebugCellLabel& ShownLabel = ShownLabelsInternal[LabelIndex];
+	if (ShownLabel == Label)
+	{
+		// Is already shown, skip updating the render state
+		return;
+	}
+
+	ShownLabel = Label;
+	TextRender->SetText(FText::FromString(Label.Text));
+	TextRender->SetWorldSize(Label.WorldSize);
+	TextRender->SetTextRenderColor(Label.Color);
+	TextRender->SetWorldLocationAndRotation(Label.Location, Label.Rotation);
+}
+
+// Hides text renders that were not displayed again since the last clear
+void UDebugCellsComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	for (int32 Index = UsedNumInternal; Index < TextRendersInternal.Num(); ++Index)
+	{
+		UTextRenderComponent* TextRenderIt = TextRendersInternal[Index];
+		if (TextRenderIt
+		    && TextRenderIt->IsVisible())
+		{
+			TextRenderIt->SetVisibility(false);
+		}
+	}
+
+	SetComponentTickEnabled(false);
+}
+
+// Destroys all pooled text renders
+void UDebugCellsComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
+{
+	for (UTextRenderComponent* TextRenderIt : TextRendersInternal)
+	{
+		if (IsValid(TextRenderIt))
+		{
+			TextRenderIt->DestroyComponent();
+		}
+	}
+	TextRendersInternal.Empty();
+	ShownLabelsInternal.Empty();
+	UsedNumInternal = 0;
+
+	Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
@@ -0,0 +1,175 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Components/GridMovementComponent.h"
+//---
+#include "GeneratedMap.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+//---
+#include "GameFramework/Character.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GridMovementComponent)
+
+/*********************************************************************************************
+ * Network Moves
+ ********************************************************************************************* */
+
+// Writes the move with planar location and acceleration
+bool FGridNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	NetworkMoveType = MoveType;
+	const bool bIsSaving = Ar.IsSaving();
+
+	// Zigzag encoding keeps small negative values small
+	auto SerializeQuantized = [&Ar, bIsSaving](double& InOutValue, double Scale)
+	{
+		uint32 Packed = bIsSaving ? FZigzag::Encode(FMath::RoundToInt32(InOutValue * Scale)) : 0;
+		Ar.SerializeIntPacked(Packed);
+		if (!bIsSaving)
+		{
+			InOutValue = FZigzag::Decode(Packed) / Scale;
+		}
+	};
+
+	Ar << TimeStamp;
+
+	// Acceleration has the same precision as FVector_NetQuantize10, location as FVector_NetQuantize100
+	static constexpr double AccelerationScale = 10.0;
+	SerializeQuantized(Acceleration.X, AccelerationScale);
+	SerializeQuantized(Acceleration.Y, AccelerationScale);
+	if (!bIsSaving)
+	{
+		Acceleration.Z = 0.0;
+	}
+
+	// The location is planar if the client is on the same height as its character, the server takes the height of its own character then
+	const USceneComponent* UpdatedComponent = CharacterMovement.UpdatedComponent;
+	uint8 bIsPlanarLocation = bIsSaving && UpdatedComponent && FMath::IsNearlyEqual(Location.Z, UpdatedComponent->GetComponentLocation().Z, 0.01);
+	Ar.SerializeBits(&bIsPlanarLocation, 1);
+	static constexpr double LocationScale = 100.0;
+	SerializeQuantized(Location.X, LocationScale);
+	SerializeQuantized(Location.Y, LocationScale);
+	if (!bIsPlanarLocation)
+	{
+		SerializeQuantized(Location.Z, LocationScale);
+	}
+	else if (!bIsSaving)
+	{
+		Location.Z = UpdatedComponent ? UpdatedComponent->GetComponentLocation().Z : 0.0;
+	}
+
+	uint16 CompressedYaw = FRotator::CompressAxisToShort(ControlRotation.Yaw);
+	Ar << CompressedYaw;
+	if (!bIsSaving)
+	{
+		ControlRotation = FRotator(0.f, FRotator::DecompressAxisFromShort(CompressedYaw), 0.f);
+	}
+
+	Ar << CompressedMoveFlags;
+
+	if (MoveType == ENetworkMoveType::NewMove)
+	{
+		// The base and the movement mode are used only for error checking, so only the final move has them
+		uint8 bHasMovementBase = MovementBase != nullptr || MovementBaseBoneName != NAME_None;
+		Ar.SerializeBits(&bHasMovementBase, 1);
+		if (bHasMovementBase)
+		{
+			UObject* MovementBaseObject = MovementBase;
+			Ar << MovementBaseObject;
+			Ar << MovementBaseBoneName;
+			if (!bIsSaving)
+			{
+				MovementBase = Cast<UPrimitiveComponent>(MovementBaseObject);
+			}
+		}
+		else if (!bIsSaving)
+		{
+			MovementBase = nullptr;
+			MovementBaseBoneName = NAME_None;
+		}
+
+		Ar << MovementMode;
+	}
+
+	return !Ar.IsError();
+}
+
+// Holds the new, pending and old grid moves instead of default ones
+FGridNetworkMoveDataContainer::FGridNetworkMoveDataContainer()
+{
+	NewMoveData = &GridMoveData[0];
+	PendingMoveData = &GridMoveData[1];
+	OldMoveData = &GridMoveData[2];
+}
+
+/*********************************************************************************************
+ * Grid Movement Component
+ ********************************************************************************************* */
+
+// Sets default values for this component's properties
+UGridMovementComponent::UGridMovementComponent()
+{
+	// The character never leaves the plane of the level, it is not snapped since the plane origin is not the level height
+	SetPlaneConstraintEnabled(true);
+	SetPlaneConstraintNormal(FVector::UpVector);
+	bSnapToPlaneAtStart = false;
+
+	NavAgentProps.bCanJump = false;
+	NavAgentProps.bCanCrouch = false;
+	NavAgentProps.bCanSwim = false;
+	NavAgentProps.bCanFly = false;
+
+	// The floor of the level is flat and static, so it is not swept every update
+	bAlwaysCheckFloor = false;
+	bUseFlatBaseForFloorChecks = true;
+	bEnablePhysicsInteraction = false;
+
+	// Simulated proxies move only along lanes, so linear smoothing is enough
+	NetworkSmoothingMode = ENetworkSmoothingMode::Linear;
+
+	SetNetworkMoveDataContainer(GridNetworkMoveDataContainer);
+}
+
+// Snaps the input to the dominant grid axis and steers it onto the lane of the nearest cell
+FVector UGridMovementComponent::ConstrainInputAcceleration(const FVector& InputAcceleration) const
+{
+	const FVector ConstrainedInput = Super::ConstrainInputAcceleration(InputAcceleration);
+	const double InputSize = ConstrainedInput.Size2D();
+	if (InputSize <= UE_KINDA_SMALL_NUMBER
+	    || !UpdatedComponent)
+	{
+		return ConstrainedInput;
+	}
+
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMapByContext(CharacterOwner) : nullptr;
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	const FCell& NearestCell = GeneratedMap ? GeneratedMap->GetCellByIndex(GeneratedMap->GetNearestCellIndex(Location)) : FCell::InvalidCell;
+	if (NearestCell.IsInvalidCell())
+	{
+		return ConstrainedInput;
+	}
+
+	// Lanes are along grid axes, so the input is processed in the grid space
+	const FQuat GridRotation = GeneratedMap->GetGridTransform().GetRotation();
+	const FVector LocalInput = GridRotation.UnrotateVector(ConstrainedInput);
+
+	// Only one axis is moved along at once, the steering never exceeds it, so the constrained input keeps its axis
+	const bool bIsAlongX = FMath::Abs(LocalInput.X) >= FMath::Abs(LocalInput.Y);
+	const double Direction = FMath::Sign(bIsAlongX ? LocalInput.X : LocalInput.Y);
+
+	// Steer towards the center of the lane, the closer the character is to it, the less it is steered
+	const FVector LocalOffset = GridRotation.UnrotateVector(Location - NearestCell.Location);
+	const double LaneOffset = bIsAlongX ? LocalOffset.Y : LocalOffset.X;
+	const double AssistDistance = FCell::CellSize * CorneringAssistInternal;
+	double Steering = 0.0;
+	if (AssistDistance > UE_KINDA_SMALL_NUMBER
+	    && FMath::Abs(LaneOffset) > LaneToleranceInternal
+	    && FMath::Abs(LaneOffset) <= AssistDistance)
+	{
+		static constexpr double MaxSteering = 0.5;
+		Steering = -FMath::Clamp(LaneOffset / AssistDistance, -MaxSteering, MaxSteering);
+	}
+
+	const FVector LocalAcceleration = bIsAlongX ? FVector(Direction, Steering, 0.0) : FVector(Steering, Direction, 0.0);
+	return GridRotation.RotateVector(LocalAcceleration).GetSafeNormal() * InputSize;
+}
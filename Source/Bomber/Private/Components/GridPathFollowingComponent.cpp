@@ -0,0 +1,165 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Components/GridPathFollowingComponent.h"
+//---
+#include "GeneratedMap.h"
+//---
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GridPathFollowingComponent)
+
+// Sets default values for this component's properties
+UGridPathFollowingComponent::UGridPathFollowingComponent()
+{
+	// Is ticking only while moving to the destination
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+// Returns the controller of this component
+AController* UGridPathFollowingComponent::GetController() const
+{
+	return Cast<AController>(GetOwner());
+}
+
+// Starts moving the controlled pawn to given cell
+void UGridPathFollowingComponent::MoveToCell(const FCell& DestinationCell)
+{
+	const int32 NewDestinationIndex = AGeneratedMap::Get().GetCellIndex(DestinationCell);
+	if (NewDestinationIndex == INDEX_NONE)
+	{
+		StopMovement();
+		return;
+	}
+
+	if (NewDestinationIndex != DestinationCellIndexInternal)
+	{
+		DestinationCellIndexInternal = NewDestinationIndex;
+
+		// Force rebuilding the distance field for the new destination
+		DistanceFieldInternal.Reset();
+	}
+
+	SetComponentTickEnabled(true);
+}
+
+// Stops moving the controlled pawn
+void UGridPathFollowingComponent::StopMovement()
+{
+	DestinationCellIndexInternal = INDEX_NONE;
+	DistanceFieldInternal.Reset();
+	SetComponentTickEnabled(false);
+}
+
+// Steers the pawn to the next cell on the way to the destination
+void UGridPathFollowingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const AController* Controller = GetController();
+	APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+	if (!Pawn
+	    || !IsMoving())
+	{
+		StopMovement();
+		return;
+	}
+
+	UpdateDistanceField();
+
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const FVector PawnLocation = Pawn->GetActorLocation();
+	const int32 CurrentCellIndex = GeneratedMap.GetNearestCellIndex(PawnLocation);
+	const FVector CurrentCellLocation = GeneratedMap.GetCellByIndex(CurrentCellIndex).Location;
+
+	int32 NextCellIndex = INDEX_NONE;
+	if (CurrentCellIndex == DestinationCellIndexInternal)
+	{
+		// Is on the destination cell, so come to its center
+		static constexpr float AcceptanceRadius = FCell::CellSize * 0.1f;
+		if (FVector::DistSquared2D(PawnLocation, CurrentCellLocation) <= FMath::Square(AcceptanceRadius))
+		{
+			StopMovement();
+			return;
+		}
+		NextCellIndex = CurrentCellIndex;
+	}
+	else
+	{
+		NextCellIndex = FindNextCellIndex(CurrentCellIndex);
+		if (NextCellIndex == INDEX_NONE)
+		{
+			// Destination is not reachable anymore, wait for the next decision
+			StopMovement();
+			return;
+		}
+	}
+
+	// Move along the line between cells and pull back to it, so the pawn doesn't cut corners of walls
+	const FVector NextCellLocation = GeneratedMap.GetCellByIndex(NextCellIndex).Location;
+	FVector MoveAxis = (NextCellLocation - CurrentCellLocation).GetSafeNormal2D();
+	const FVector Offset = PawnLocation - CurrentCellLocation;
+	FVector MoveDirection;
+	if (MoveAxis.IsNearlyZero())
+	{
+		MoveDirection = -Offset;
+	}
+	else
+	{
+		const FVector LateralOffset = (Offset - MoveAxis * FVector::DotProduct(Offset, MoveAxis)) * FVector(1.f, 1.f, 0.f);
+		MoveDirection = MoveAxis * FCell::CellSize - LateralOffset;
+	}
+
+	Pawn->AddMovementInput(MoveDirection.GetSafeNormal2D());
+}
+
+// Rebuilds the distance field if it is outdated
+void UGridPathFollowingComponent::UpdateDistanceField()
+{
+	const FAIWorldSnapshot& Snapshot = AGeneratedMap::Get().GetAIWorldSnapshot();
+	if (DistanceFieldInternal.Num() == Snapshot.Num()
+	    && DistanceFieldVersionInternal == Snapshot.StateVersion)
+	{
+		return;
+	}
+
+	const int32 TargetCellIndices[] = {DestinationCellIndexInternal};
+	Snapshot.BuildDistanceField(DistanceFieldInternal, TargetCellIndices);
+	DistanceFieldVersionInternal = Snapshot.StateVersion;
+}
+
+// Returns the neighbour of given cell that is closer to the destination, INDEX_NONE if there is no way
+int32 UGridPathFollowingComponent::FindNextCellIndex(int32 CellIndex) const
+{
+	if (!DistanceFieldInternal.IsValidIndex(CellIndex)
+	    || DistanceFieldInternal[CellIndex] == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 MaxWidth = AGeneratedMap::Get().GetGridSize().X;
+	const int32 Column = MaxWidth ? CellIndex % MaxWidth : 0;
+	const int32 Neighbours[] = {
+		Column > 0 ? CellIndex - 1 : INDEX_NONE,
+		Column < MaxWidth - 1 ? CellIndex + 1 : INDEX_NONE,
+		CellIndex - MaxWidth,
+		CellIndex + MaxWidth
+	};
+
+	int32 NextCellIndex = INDEX_NONE;
+	int32 NextDistance = DistanceFieldInternal[CellIndex];
+	for (const int32 NeighbourIt : Neighbours)
+	{
+		if (DistanceFieldInternal.IsValidIndex(NeighbourIt)
+		    && DistanceFieldInternal[NeighbourIt] != INDEX_NONE
+		    && DistanceFieldInternal[NeighbourIt] < NextDistance)
+		{
+			NextCellIndex = NeighbourIt;
+			NextDistance = DistanceFieldInternal[NeighbourIt];
+		}
+	}
+
+	return NextCellIndex;
+}
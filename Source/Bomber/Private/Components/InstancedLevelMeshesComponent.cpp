@@ -0,0 +1,239 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Components/InstancedLevelMeshesComponent.h"
+//---
+#include "GeneratedMap.h"
+#include "Components/MapComponent.h"
+#include "DataAssets/GeneratedMapDataAsset.h"
+//---
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(InstancedLevelMeshesComponent)
+
+// Sets default values for this component's properties
+UInstancedLevelMeshesComponent::UInstancedLevelMeshesComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+// Returns true if walls and boxes should be drawn by this component
+bool UInstancedLevelMeshesComponent::IsInstancingEnabled()
+{
+	return UGeneratedMapDataAsset::Get().IsInstancedWallsAndBoxes();
+}
+
+// Returns true if collisions of walls and boxes are handled by instances of this component instead of level actors
+bool UInstancedLevelMeshesComponent::IsInstancedCollisionEnabled()
+{
+	const UGeneratedMapDataAsset& GeneratedMapDataAsset = UGeneratedMapDataAsset::Get();
+	return GeneratedMapDataAsset.IsInstancedWallsAndBoxes()
+	       && GeneratedMapDataAsset.IsInstancedCollision();
+}
+
+// Returns true if all walls of one level type are drawn by a single instanced component instead of one per chunk
+bool UInstancedLevelMeshesComponent::IsMergedStaticWallsEnabled() const
+{
+	const AGeneratedMap* GeneratedMap = Cast<AGeneratedMap>(GetOwner());
+	return GeneratedMap
+	       && UGeneratedMapDataAsset::Get().IsMergedStaticWalls()
+	       && GeneratedMap->HasBakedLevelLayout();
+}
+
+// Adds or updates the instance of given map component by its current mesh and transform, hides own mesh of level actor
+void UInstancedLevelMeshesComponent::AddInstance(const UMapComponent* MapComponent)
+{
+	UStaticMeshComponent* MeshComponent = MapComponent ? Cast<UStaticMeshComponent>(MapComponent->GetMeshComponent()) : nullptr;
+	UStaticMesh* Mesh = MeshComponent ? MeshComponent->GetStaticMesh() : nullptr;
+	if (!Mesh)
+	{
+		return;
+	}
+
+	// Level actor is still present for the logic and collisions, but is not rendered by itself
+	MeshComponent->SetVisibility(false);
+
+	const FTransform InstanceTransform = MeshComponent->GetComponentTransform();
+	const ECollisionResponse CollisionResponse = MapComponent->GetActorDataAssetChecked().GetCollisionResponse();
+	const int32 ChunkIndex = GetInstanceChunkIndex(InstanceTransform.GetLocation(), MapComponent->GetActorType());
+
+	FLevelMeshInstance& Instance = InstancesInternal.FindOrAdd(MapComponent);
+	if (Instance.Mesh == Mesh
+	    && Instance.ChunkIndex == ChunkIndex
+	    && Instance.InstanceIndex != INDEX_NONE)
+	{
+		// Is already added, just move it
+		UHierarchicalInstancedStaticMeshComponent* InstancedMesh = FindOrCreateInstancedMesh(Mesh, ChunkIndex, CollisionResponse);
+		InstancedMesh->UpdateInstanceTransform(Instance.InstanceIndex, InstanceTransform, /*bWorldSpace*/true, /*bMarkRenderStateDirty*/true, /*bTeleport*/true);
+		return;
+	}
+
+	// The mesh or the chunk was changed, release previous instance
+	if (Instance.InstanceIndex != INDEX_NONE)
+	{
+		HideInstance(Instance);
+	}
+
+	Instance.Mesh = Mesh;
+	Instance.ChunkIndex = ChunkIndex;
+	PlaceInstance(Instance, InstanceTransform, CollisionResponse);
+}
+
+// Removes the instance of given map component if was added before
+void UInstancedLevelMeshesComponent::RemoveInstance(const UMapComponent* MapComponent)
+{
+	FLevelMeshInstance Instance;
+	if (!InstancesInternal.RemoveAndCopyValue(MapComponent, Instance))
+	{
+		return;
+	}
+
+	HideInstance(Instance);
+
+	// Return own rendering to the level actor, so it looks as expected if is used without this component
+	if (UMeshComponent* MeshComponent = MapComponent ? MapComponent->GetMeshComponent() : nullptr)
+	{
+		MeshComponent->SetVisibility(true);
+	}
+}
+
+// Removes all instances of map components that are not contained in given set
+void UInstancedLevelMeshesComponent::RemoveInstancesExcept(const TSet<const UMapComponent*>& KeptMapComponents)
+{
+	TArray<TWeakObjectPtr<const UMapComponent>> RemovedMapComponents;
+	for (const TTuple<TWeakObjectPtr<const UMapComponent>, FLevelMeshInstance>& It : InstancesInternal)
+	{
+		if (!KeptMapComponents.Contains(It.Key.Get()))
+		{
+			RemovedMapComponents.Emplace(It.Key);
+		}
+	}
+
+	for (const TWeakObjectPtr<const UMapComponent>& It : RemovedMapComponents)
+	{
+		FLevelMeshInstance Instance;
+		InstancesInternal.RemoveAndCopyValue(It, Instance);
+		HideInstance(Instance);
+	}
+}
+
+// Replaces instances that are not owned by any map component
+void UInstancedLevelMeshesComponent::SetLayoutInstances(UStaticMesh* Mesh, const TArray<FTransform>& Transforms, ECollisionResponse CollisionResponse)
+{
+	for (const FLevelMeshInstance& It : LayoutInstancesInternal)
+	{
+		HideInstance(It);
+	}
+	LayoutInstancesInternal.Reset();
+
+	if (!Mesh)
+	{
+		return;
+	}
+
+	LayoutInstancesInternal.Reserve(Transforms.Num());
+	for (const FTransform& TransformIt : Transforms)
+	{
+		FLevelMeshInstance& Instance = LayoutInstancesInternal.AddDefaulted_GetRef();
+		Instance.Mesh = Mesh;
+		Instance.ChunkIndex = GetInstanceChunkIndex(TransformIt.GetLocation(), EActorType::Wall);
+		PlaceInstance(Instance, TransformIt, CollisionResponse);
+	}
+}
+
+// Returns the instanced component for given mesh in specified chunk, creates new one if not found
+UHierarchicalInstancedStaticMeshComponent* UInstancedLevelMeshesComponent::FindOrCreateInstancedMesh(UStaticMesh* Mesh, int32 ChunkIndex, ECollisionResponse CollisionResponse/* = ECR_Ignore*/)
+{
+	checkf(Mesh, TEXT("ERROR: [%i] %s:\n'Mesh' is null!"), __LINE__, *FString(__FUNCTION__));
+	const FInstancedMeshKey Key{Mesh, ChunkIndex};
+	if (UHierarchicalInstancedStaticMeshComponent* FoundInstancedMesh = InstancedMeshesByKeyInternal.FindRef(Key).Get())
+	{
+		return FoundInstancedMesh;
+	}
+
+	AActor* Owner = GetOwner();
+	checkf(Owner, TEXT("ERROR: [%i] %s:\n'Owner' is null!"), __LINE__, *FString(__FUNCTION__));
+
+	UHierarchicalInstancedStaticMeshComponent* InstancedMesh = NewObject<UHierarchicalInstancedStaticMeshComponent>(Owner, NAME_None, RF_Transient);
+	InstancedMesh->SetupAttachment(this);
+	InstancedMesh->SetStaticMesh(Mesh);
+	InstancedMesh->SetMobility(EComponentMobility::Movable);
+	InstancedMesh->SetReceivesDecals(false);
+
+	if (IsInstancedCollisionEnabled()
+	    && CollisionResponse != ECR_Ignore)
+	{
+		// All instance bodies are registered by this component in one batch, hidden instances don't have bodies because of zero scale
+		InstancedMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		InstancedMesh->SetCollisionResponseToAllChannels(CollisionResponse);
+	}
+	else
+	{
+		// Collisions are handled by level actors themselves
+		InstancedMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
+	InstancedMesh->RegisterComponent();
+
+	InstancedMeshesInternal.Emplace(InstancedMesh);
+	InstancedMeshesByKeyInternal.Emplace(Key, InstancedMesh);
+	return InstancedMesh;
+}
+
+// Returns the chunk of the Generated Map that contains given world location
+int32 UInstancedLevelMeshesComponent::GetChunkIndexByLocation(const FVector& Location) const
+{
+	const AGeneratedMap* GeneratedMap = Cast<AGeneratedMap>(GetOwner());
+	return GeneratedMap ? GeneratedMap->GetGridChunks().GetChunkIndex(GeneratedMap->GetNearestCellIndex(Location)) : INDEX_NONE;
+}
+
+// Returns the chunk of the instance of given actor type at given location, is MergedChunkIndex for merged static walls
+int32 UInstancedLevelMeshesComponent::GetInstanceChunkIndex(const FVector& Location, EActorType ActorType) const
+{
+	if (ActorType == EActorType::Wall
+	    && IsMergedStaticWallsEnabled())
+	{
+		// Walls never change on baked layouts, so one component per mesh costs the least draw calls and is never rebuilt
+		return MergedChunkIndex;
+	}
+
+	return GetChunkIndexByLocation(Location);
+}
+
+// Sets given instance of the component to specified transform, reuses a hidden instance of the same chunk if any
+void UInstancedLevelMeshesComponent::PlaceInstance(FLevelMeshInstance& InOutInstance, const FTransform& InstanceTransform, ECollisionResponse CollisionResponse)
+{
+	UHierarchicalInstancedStaticMeshComponent* InstancedMesh = FindOrCreateInstancedMesh(InOutInstance.Mesh.Get(), InOutInstance.ChunkIndex, CollisionResponse);
+	constexpr bool bWorldSpace = true;
+
+	TArray<int32>& FreeInstances = FreeInstancesInternal.FindOrAdd(InOutInstance.GetKey());
+	if (!FreeInstances.IsEmpty())
+	{
+		InOutInstance.InstanceIndex = FreeInstances.Pop(/*bAllowShrinking*/false);
+		InstancedMesh->UpdateInstanceTransform(InOutInstance.InstanceIndex, InstanceTransform, bWorldSpace, /*bMarkRenderStateDirty*/true, /*bTeleport*/true);
+	}
+	else
+	{
+		InOutInstance.InstanceIndex = InstancedMesh->AddInstance(InstanceTransform, bWorldSpace);
+	}
+}
+
+// Hides the specified instance and marks it as free
+void UInstancedLevelMeshesComponent::HideInstance(const FLevelMeshInstance& Instance)
+{
+	const FInstancedMeshKey Key = Instance.GetKey();
+	UHierarchicalInstancedStaticMeshComponent* FoundInstancedMesh = InstancedMeshesByKeyInternal.FindRef(Key).Get();
+	if (!FoundInstancedMesh
+	    || Instance.InstanceIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Zero scale hides the instance without shifting indexes of others
+	FTransform HiddenTransform = FTransform::Identity;
+	HiddenTransform.SetScale3D(FVector::ZeroVector);
+	FoundInstancedMesh->UpdateInstanceTransform(Instance.InstanceIndex, HiddenTransform, /*bWorldSpace*/false, /*bMarkRenderStateDirty*/true, /*bTeleport*/true);
+
+	FreeInstancesInternal.FindOrAdd(Key).Emplace(Instance.InstanceIndex);
+}
@@ -4,12 +4,15 @@
 //---
 #include "Bomber.h"
 #include "GeneratedMap.h"
+#include "Components/InstancedLevelMeshesComponent.h"
+#include "Components/MapComponentOwner.h"
 #include "PoolManagerSubsystem.h"
 #include "DataAssets/DataAssetsContainer.h"
 #include "DataAssets/GameStateDataAsset.h"
 #include "DataAssets/LevelActorDataAsset.h"
 #include "LevelActors/PlayerCharacter.h"
 #include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/CosmeticEventsSubsystem.h"
 #include "Subsystems/GeneratedMapSubsystem.h"
 #include "UtilityLibraries/CellsUtilsLibrary.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
@@ -21,6 +24,7 @@
 #include "Engine/EngineTypes.h"
 #include "Engine/StreamableRenderAsset.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 //---
 #if WITH_EDITOR
 #include "MyUnrealEdEngine.h"
@@ -46,16 +50,24 @@ UMapComponent::UMapComponent()
 // Rerun owner's construction scripts. The temporary only editor owner will not be updated
 void UMapComponent::ConstructOwnerActor()
 {
-	// Construct the actor's map component
-	const bool bIsConstructed = OnConstructionOwnerActor();
-	if (!bIsConstructed)
+	bool bIsConstructed = false;
 	{
-		return;
+		// Meshes requested by this component and by the owner's listeners are applied only once after the whole construction
+		TGuardValue<bool> ConstructingGuard(bIsConstructingOwnerInternal, true);
+
+		// Construct the actor's map component
+		bIsConstructed = OnConstructionOwnerActor();
+		if (bIsConstructed
+		    && OnOwnerWantsReconstruct.IsBound())
+		{
+			OnOwnerWantsReconstruct.Broadcast();
+		}
 	}
 
-	if (OnOwnerWantsReconstruct.IsBound())
+	if (bIsConstructed
+	    && !bIsConstructingOwnerInternal)
 	{
-		OnOwnerWantsReconstruct.Broadcast();
+		ApplyPendingMesh();
 	}
 }
 
@@ -68,9 +80,9 @@ bool UMapComponent::OnConstructionOwnerActor()
 		return false;
 	}
 
-	// Check the object state in the Pool Manager
+	// Check the object state in the Pool Manager, the cached handle means it is already taken
 	UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
-	const EPoolObjectState PoolObjectState = PoolManager.GetPoolObjectState(Owner);
+	const EPoolObjectState PoolObjectState = PoolObjectHandleInternal.IsValid() ? EPoolObjectState::Active : PoolManager.GetPoolObjectState(Owner);
 	if (PoolObjectState == EPoolObjectState::None)
 	{
 		// The owner actor is not in the pool
@@ -86,7 +98,10 @@ bool UMapComponent::OnConstructionOwnerActor()
 		return false;
 	}
 
-	AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	// The owner is taken from the pool or moved, so it has to be replicated even if is dormant
+	FlushOwnerNetDormancy();
+
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get(GetOwner());
 
 	// Find new Location at dragging and update-delegate
 	GeneratedMap.SetNearestCell(this);
@@ -108,11 +123,25 @@ bool UMapComponent::OnConstructionOwnerActor()
 	const ECollisionResponse CollisionResponse = GetActorDataAssetChecked().GetCollisionResponse();
 	SetCollisionResponses(CollisionResponse);
 
+	// The actor is placed, so it could go dormant until the next change
+	const FLevelActorNetPolicy& NetPolicy = GetActorDataAssetChecked().GetNetPolicy();
+	if (Owner->HasAuthority()
+	    && NetPolicy.NetDormancy > DORM_Awake)
+	{
+		Owner->SetNetDormancy(NetPolicy.NetDormancy);
+	}
+
+	// The actor is replicated by now, so Iris is able to filter and prioritize it
+	if (Owner->HasAuthority())
+	{
+		NetPolicy.ApplyToReplicationSystem(*Owner);
+	}
+
 	if (UUtilsLibrary::IsEditorNotPieWorld())
 	{
 #if WITH_EDITOR
 		// Update AI renders after adding obj to map
-		UMyUnrealEdEngine::GOnAIUpdatedDelegate.Broadcast();
+		UMyUnrealEdEngine::MarkAIDirty();
 #endif
 	}
 
@@ -122,9 +151,21 @@ bool UMapComponent::OnConstructionOwnerActor()
 // Override current cell data, where owner is located on the Generated Map
 void UMapComponent::SetCell(const FCell& Cell)
 {
+	const FCell PreviousCell = CellInternal;
+	if (PreviousCell != Cell)
+	{
+		FlushOwnerNetDormancy();
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CellInternal, this);
+	}
 	CellInternal = Cell;
 
-	TryDisplayOwnedCell();
+	QueueCellChangedEvent();
+
+	if (PreviousCell != Cell)
+	{
+		UpdatePackedState();
+		OnCellChanged.Broadcast(this, Cell, PreviousCell);
+	}
 }
 
 // Show current cell if owned actor type is allowed, is not available in shipping build
@@ -140,24 +181,52 @@ void UMapComponent::TryDisplayOwnedCell()
 #endif // !UE_BUILD_SHIPPING
 }
 
+// Queues current cell to be shown by cosmetics of this frame, is displayed right away if there are no cosmetic events, e.g: in editor
+void UMapComponent::QueueCellChangedEvent()
+{
+	if (UCosmeticEventsSubsystem* CosmeticEventsSubsystem = UCosmeticEventsSubsystem::GetCosmeticEventsSubsystem(this))
+	{
+		CosmeticEventsSubsystem->AddEvent(ECosmeticEventType::CellChanged, CellInternal, GetActorType(), this);
+	}
+	else
+	{
+		TryDisplayOwnedCell();
+	}
+}
+
 // Updates current mesh to default according current level type
 void UMapComponent::SetDefaultMesh()
 {
-	if (GetActorDataAssetChecked().GetActorType() == EActorType::Player)
+	if (ActorTypeInternal == EActorType::Player)
 	{
 		// ACharacter has own mesh component, no need to manage it
 		return;
 	}
 
 	const ULevelActorRow* FoundRow = GetActorDataAssetChecked().GetRowByLevelType(UMyBlueprintFunctionLibrary::GetLevelType());
-	UUtilsLibrary::SetMesh(MeshComponentInternal, FoundRow->Mesh);
+	SetDefaultMeshByRow(FoundRow);
+}
+
+// Updates current mesh to default one of given row, is used to swap meshes of many components by once resolved row
+void UMapComponent::SetDefaultMeshByRow(const ULevelActorRow* Row)
+{
+	if (ActorTypeInternal == EActorType::Player
+	    || !ensureMsgf(Row, TEXT("ASSERT: [%i] %s:\n'Row' is not valid!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	ApplyMesh(Row->Mesh);
 
 	// Reset custom mesh name for replication
 	const AActor* Owner = GetOwner();
 	checkf(Owner, TEXT("ERROR: [%i] %s:\n'Owner' is null!"), __LINE__, *FString(__FUNCTION__));
-	if (Owner->HasAuthority())
+	if (Owner->HasAuthority()
+	    && CustomMeshAssetInternal)
 	{
+		FlushOwnerNetDormancy();
 		CustomMeshAssetInternal = nullptr;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CustomMeshAssetInternal, this);
 	}
 }
 
@@ -169,14 +238,17 @@ void UMapComponent::SetCustomMeshAsset(UStreamableRenderAsset* CustomMeshAsset)
 		return;
 	}
 
-	UUtilsLibrary::SetMesh(MeshComponentInternal, CustomMeshAsset);
+	ApplyMesh(CustomMeshAsset);
 
 	// Update the mesh name for replication
 	const AActor* Owner = GetOwner();
 	checkf(Owner, TEXT("ERROR: [%i] %s:\n'Owner' is null!"), __LINE__, *FString(__FUNCTION__));
-	if (Owner->HasAuthority())
+	if (Owner->HasAuthority()
+	    && CustomMeshAssetInternal != CustomMeshAsset)
 	{
+		FlushOwnerNetDormancy();
 		CustomMeshAssetInternal = CustomMeshAsset;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CustomMeshAssetInternal, this);
 	}
 }
 
@@ -193,13 +265,19 @@ void UMapComponent::SetMaterial(UMaterialInterface* Material)
 // Returns the map component of the specified owner
 UMapComponent* UMapComponent::GetMapComponent(const AActor* Owner)
 {
-	return Owner ? Owner->FindComponentByClass<UMapComponent>() : nullptr;
-}
+	if (!Owner)
+	{
+		return nullptr;
+	}
 
-// Get the owner's data asset
-EActorType UMapComponent::GetActorType() const
-{
-	return GetActorDataAssetChecked().GetActorType();
+	// Level actors keep own map component, so all their components are not walked
+	if (const IMapComponentOwner* MapComponentOwner = Cast<IMapComponentOwner>(Owner))
+	{
+		return MapComponentOwner->GetOwnedMapComponent();
+	}
+
+	// The map component could be added to any other actor, e.g: in blueprints
+	return Owner->FindComponentByClass<UMapComponent>();
 }
 
 // Get the owner's data asset
@@ -212,7 +290,20 @@ const ULevelActorDataAsset& UMapComponent::GetActorDataAssetChecked() const
 // Set true to make an owner to be undestroyable on this level
 void UMapComponent::SetUndestroyable(bool bIsUndestroyable)
 {
-	bIsUndestroyableInternal = bIsUndestroyable;
+	if (bIsUndestroyableInternal != bIsUndestroyable)
+	{
+		bIsUndestroyableInternal = bIsUndestroyable;
+	}
+}
+
+// Notifies the Generated Map to update the cell of this component in its packed mirror
+void UMapComponent::UpdatePackedState() const
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	if (const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr)
+	{
+		GeneratedMap->UpdatePackedMapComponent(*this);
+	}
 }
 
 // Set new collisions data for any channel of the Box Collision Component
@@ -227,13 +318,18 @@ void UMapComponent::SetCollisionResponses(const FCollisionResponseContainer& New
 		return;
 	}
 
+	FlushOwnerNetDormancy();
 	CollisionResponseInternal = NewResponses;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CollisionResponseInternal, this);
 	ApplyCollisionResponse();
 }
 
 // Is called when an owner was destroyed on the Generated Map
 void UMapComponent::OnDeactivated(UObject* DestroyCauser/* = nullptr*/)
 {
+	// Wake up dormant owner, so its return to the pool is replicated
+	FlushOwnerNetDormancy();
+
 	if (OnDeactivatedMapComponent.IsBound())
 	{
 		OnDeactivatedMapComponent.Broadcast(this, DestroyCauser);
@@ -243,11 +339,16 @@ void UMapComponent::OnDeactivated(UObject* DestroyCauser/* = nullptr*/)
 
 	SetCollisionResponses(ECR_Ignore);
 
-	if (CustomMeshAssetInternal != nullptr)
+	// Only the replicated custom mesh is reset here, the hidden owner keeps its mesh until it is reactivated with the row's one
+	if (CustomMeshAssetInternal != nullptr
+	    && GetOwner()->HasAuthority())
 	{
-		SetDefaultMesh();
+		CustomMeshAssetInternal = nullptr;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CustomMeshAssetInternal, this);
 	}
 
+	RemoveInstancedMesh();
+
 	if (IsUndestroyable())
 	{
 		SetUndestroyable(false);
@@ -260,6 +361,100 @@ void UMapComponent::OnDeactivated(UObject* DestroyCauser/* = nullptr*/)
 	}
 }
 
+// Returns false if the mesh is only cosmetic on this side, so it is not set at all, e.g: on the dedicated server
+bool UMapComponent::ShouldApplyMesh() const
+{
+	if (!UUtilsLibrary::IsDedicatedServer())
+	{
+		return true;
+	}
+
+	// Instances of walls and boxes are taken by their meshes, the server needs them for collisions
+	return TO_FLAG(GetActorType()) & TO_FLAG(EAT::Box | EAT::Wall)
+	       && UInstancedLevelMeshesComponent::IsInstancedCollisionEnabled();
+}
+
+// Sets given mesh to the mesh component, is deferred until the end of ThisClass::ConstructOwnerActor() while the owner is constructed
+void UMapComponent::ApplyMesh(UStreamableRenderAsset* Mesh)
+{
+	if (!ShouldApplyMesh())
+	{
+		return;
+	}
+
+	PendingMeshInternal = Mesh;
+	bHasPendingMeshInternal = true;
+
+	if (!bIsConstructingOwnerInternal)
+	{
+		ApplyPendingMesh();
+	}
+}
+
+// Applies the last requested mesh, the mesh component is touched only if the mesh was changed since the last activation
+void UMapComponent::ApplyPendingMesh()
+{
+	if (!bHasPendingMeshInternal)
+	{
+		return;
+	}
+
+	bHasPendingMeshInternal = false;
+	UStreamableRenderAsset* Mesh = PendingMeshInternal.Get();
+	PendingMeshInternal = nullptr;
+
+	if (Mesh != AppliedMeshInternal.Get()
+	    || !AppliedMeshInternal.IsValid())
+	{
+		UUtilsLibrary::SetMesh(MeshComponentInternal, Mesh);
+		AppliedMeshInternal = Mesh;
+	}
+
+	// The instance is removed on each deactivation, so it is added back even if the mesh is the same
+	UpdateInstancedMesh();
+}
+
+// Adds or moves the instance of this wall or box if its meshes are drawn as instances by the Generated Map
+void UMapComponent::UpdateInstancedMesh()
+{
+	const AActor* Owner = GetOwner();
+	if (!ActorDataAssetInternal
+	    || !(TO_FLAG(GetActorType()) & TO_FLAG(EAT::Box | EAT::Wall))
+	    || IS_TRANSIENT(Owner)
+	    || !UInstancedLevelMeshesComponent::IsInstancingEnabled()
+	    || !PoolObjectHandleInternal.IsValid() && UPoolManagerSubsystem::Get().GetPoolObjectState(Owner) == EPoolObjectState::Inactive)
+	{
+		return;
+	}
+
+	if (GetActorType() == EAT::Wall
+	    && !Owner->HasAuthority()
+	    && MeshComponentInternal)
+	{
+		// Clients draw walls by the replicated walls layout of the Generated Map
+		MeshComponentInternal->SetVisibility(false);
+		return;
+	}
+
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem();
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+	if (UInstancedLevelMeshesComponent* InstancedMeshesComponent = GeneratedMap ? GeneratedMap->GetInstancedMeshesComponent() : nullptr)
+	{
+		InstancedMeshesComponent->AddInstance(this);
+	}
+}
+
+// Removes the instance of this wall or box from the Generated Map if was added before
+void UMapComponent::RemoveInstancedMesh()
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem();
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+	if (UInstancedLevelMeshesComponent* InstancedMeshesComponent = GeneratedMap ? GeneratedMap->GetInstancedMeshesComponent() : nullptr)
+	{
+		InstancedMeshesComponent->RemoveInstance(this);
+	}
+}
+
 //  Called when a component is registered (not loaded)
 void UMapComponent::OnRegister()
 {
@@ -272,9 +467,13 @@ void UMapComponent::OnRegister()
 	constexpr bool bAddOnlyInGameWorlds = true;
 	UGameFrameworkComponentManager::AddGameFrameworkComponentReceiver(Owner, bAddOnlyInGameWorlds);
 
+	// The mesh component could be changed while unregistered, so the next mesh is always applied
+	AppliedMeshInternal = nullptr;
+
 	if (ActorDataAssetInternal)
 	{
 		// Its data asset is valid, so initialization was already performed before
+		ActorTypeInternal = ActorDataAssetInternal->GetActorType();
 		return;
 	}
 
@@ -295,8 +494,32 @@ void UMapComponent::OnRegister()
 		return;
 	}
 
+	ActorTypeInternal = ActorDataAssetInternal->GetActorType();
+
+	// Apply replication settings of this actor type
+	if (Owner->HasAuthority())
+	{
+		ActorDataAssetInternal->GetNetPolicy().ApplyToActor(*Owner);
+	}
+
+	if (IsSlim()
+	    && !UUtilsLibrary::IsEditorNotPieWorld())
+	{
+		// Clients know cells of slim actors by the replicated layout, the Generated Map collides by instances on each side
+		if (Owner->HasAuthority())
+		{
+			Owner->SetReplicates(false);
+		}
+
+		if (BoxCollisionComponentInternal)
+		{
+			BoxCollisionComponentInternal->DestroyComponent();
+			BoxCollisionComponentInternal = nullptr;
+		}
+	}
+
 	// Initialize the Box Collision Component
-	if (ensureMsgf(BoxCollisionComponentInternal, TEXT("ASSERT: 'BoxCollisionInternal' is not valid")))
+	if (BoxCollisionComponentInternal)
 	{
 		BoxCollisionComponentInternal->AttachToComponent(Owner->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
 		BoxCollisionComponentInternal->SetBoxExtent(ActorDataAssetInternal->GetCollisionExtent());
@@ -306,7 +529,7 @@ void UMapComponent::OnRegister()
 	}
 
 	// Initialize mesh component
-	if (ActorDataAssetInternal->GetActorType() == EAT::Player)
+	if (ActorTypeInternal == EAT::Player)
 	{
 		// The character class already has own initialized skeletal component
 		const ACharacter* Player = CastChecked<ACharacter>(Owner);
@@ -344,8 +567,14 @@ void UMapComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 		// Disable collision for safety
 		ComponentOwner->SetActorEnableCollision(false);
 
-		// Delete spawned collision component
-		BoxCollisionComponentInternal->DestroyComponent();
+		// Delete spawned collision component, slim owners do not have it
+		if (BoxCollisionComponentInternal)
+		{
+			BoxCollisionComponentInternal->DestroyComponent();
+		}
+
+		// Remove its instance from the Generated Map
+		RemoveInstancedMesh();
 
 		if (UUtilsLibrary::IsEditorNotPieWorld())
 		{
@@ -358,7 +587,7 @@ void UMapComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 			}
 
 #if WITH_EDITOR
-			UMyUnrealEdEngine::GOnAIUpdatedDelegate.Broadcast();
+			UMyUnrealEdEngine::MarkAIDirty();
 #endif
 		}
 	}
@@ -371,9 +600,46 @@ void UMapComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLif
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ThisClass, CellInternal);
-	DOREPLIFETIME(ThisClass, CustomMeshAssetInternal);
-	DOREPLIFETIME(ThisClass, CollisionResponseInternal);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, CellInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, CustomMeshAssetInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, CollisionResponseInternal, Params);
+}
+
+// Forces dormant owner to replicate its next changes
+void UMapComponent::FlushOwnerNetDormancy() const
+{
+	AActor* Owner = GetOwner();
+	if (Owner
+	    && Owner->HasAuthority()
+	    && Owner->NetDormancy > DORM_Awake)
+	{
+		Owner->FlushNetDormancy();
+	}
+}
+
+// Is called on client to notify listeners that the owner has moved to another cell
+void UMapComponent::OnRep_Cell(const FCell& PreviousCell)
+{
+	QueueCellChangedEvent();
+
+	if (PreviousCell != CellInternal)
+	{
+		UpdatePackedState();
+		OnCellChanged.Broadcast(this, CellInternal, PreviousCell);
+	}
+
+	UpdateInstancedMesh();
+}
+
+// Returns true if level actors of given type are kept slim: without own collision component and without replication
+bool UMapComponent::IsSlimActorType(EActorType ActorType)
+{
+	const ULevelActorDataAsset* DataAsset = UDataAssetsContainer::GetDataAssetByActorType(ActorType);
+	return DataAsset
+	       && DataAsset->IsStatic()
+	       && UInstancedLevelMeshesComponent::IsInstancedCollisionEnabled();
 }
 
 // Is called on client to update current level actor row
@@ -390,7 +656,7 @@ void UMapComponent::OnRep_CustomMeshAsset()
 	SetCustomMeshAsset(CustomMeshAssetInternal);
 }
 
-// Updates current collisions for the Box Collision Component
+// Updates current collisions for the Box Collision Component, is called on each side
 void UMapComponent::ApplyCollisionResponse()
 {
 	if (!BoxCollisionComponentInternal
@@ -399,7 +665,18 @@ void UMapComponent::ApplyCollisionResponse()
 		return;
 	}
 
-	BoxCollisionComponentInternal->SetCollisionResponseToChannels(CollisionResponseInternal);
+	if (TO_FLAG(GetActorType()) & TO_FLAG(EAT::Box | EAT::Wall)
+	    && UInstancedLevelMeshesComponent::IsInstancedCollisionEnabled())
+	{
+		// Instances of the Generated Map collide instead, so this box is not even registered in the physics scene
+		BoxCollisionComponentInternal->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		return;
+	}
+
+	FCollisionResponseContainer AppliedResponses = CollisionResponseInternal;
+	OnApplyCollisionResponses.Broadcast(AppliedResponses);
+
+	BoxCollisionComponentInternal->SetCollisionResponseToChannels(AppliedResponses);
 }
 
 // Is called on client to response on changes in collision responses
@@ -0,0 +1,13 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Components/MapComponentOwner.h"
+//---
+#include "Subsystems/GridSpectatorSubsystem.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(MapComponentOwner)
+
+// Returns true if given viewer is the spectator that watches the grid stream
+bool IMapComponentOwner::IsGridStreamViewer(const AActor* RealViewer)
+{
+	return UGridSpectatorSubsystem::IsStreamViewer(RealViewer);
+}
@@ -5,6 +5,7 @@
 #include "GameFramework/MyGameStateBase.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
+#include "TimerManager.h"
 #include "GameFramework/PlayerController.h"
 //---
 #if WITH_EDITOR
@@ -18,8 +19,8 @@
 // Sets default values for this component's properties
 UMouseActivityComponent::UMouseActivityComponent()
 {
-	// Is ticking to calculate Delta Time
-	PrimaryComponentTick.bCanEverTick = true;
+	// Inactivity is counted by the timer
+	PrimaryComponentTick.bCanEverTick = false;
 	PrimaryComponentTick.bStartWithTickEnabled = false;
 }
 
@@ -61,9 +62,7 @@ void UMouseActivityComponent::SetMouseVisibility(bool bShouldShow)
 
 	SetMouseFocusOnUI(bShouldShow);
 
-	SetComponentTickEnabled(bShouldShow);
-
-	CurrentlyInactiveSecInternal = 0.f;
+	RestartAutoHideTimer();
 
 	if (OnMouseVisibilityChanged.IsBound())
 	{
@@ -122,7 +121,7 @@ void UMouseActivityComponent::BeginPlay()
 	// Listen to handle input for each game state
 	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
-		MyGameState->OnGameStateChanged.AddDynamic(this, &ThisClass::OnGameStateChanged);
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 		// Handle current game state if initialized with delay
 		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -132,27 +131,58 @@ void UMouseActivityComponent::BeginPlay()
 	}
 }
 
-// Called every frame to calculate Delta Time
-void UMouseActivityComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+// Starts the auto-hide timer if the mouse is shown and could be hidden on inactivity, otherwise stops it
+void UMouseActivityComponent::RestartAutoHideTimer()
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	FTimerManager& TimerManager = World->GetTimerManager();
+	TimerManager.ClearTimer(AutoHideTimerInternal);
 
 	const FMouseVisibilitySettings& VisibilitySettings = GetCurrentVisibilitySettings();
-	if (VisibilitySettings.IsInactivityEnabled())
+	if (!GetPlayerControllerChecked().ShouldShowMouseCursor()
+	    || !VisibilitySettings.IsInactivityEnabled())
 	{
-		CurrentlyInactiveSecInternal += DeltaTime;
+		return;
+	}
 
-		if (CurrentlyInactiveSecInternal >= VisibilitySettings.SecToAutoHide)
-		{
-			SetMouseVisibility(false);
-		}
+	LastActivityTimeInternal = World->GetTimeSeconds();
+	TimerManager.SetTimer(AutoHideTimerInternal, this, &ThisClass::OnAutoHideTimer, VisibilitySettings.SecToAutoHide, false);
+}
+
+// Is called by the auto-hide timer to hide the mouse, or waits the rest of time if the mouse was moved meanwhile
+void UMouseActivityComponent::OnAutoHideTimer()
+{
+	UWorld* World = GetWorld();
+	const FMouseVisibilitySettings& VisibilitySettings = GetCurrentVisibilitySettings();
+	if (!World
+	    || !VisibilitySettings.IsInactivityEnabled())
+	{
+		return;
 	}
+
+	// Mouse moves only update the activity time, so the timer is not reset on each of them
+	const float RemainSec = VisibilitySettings.SecToAutoHide - static_cast<float>(World->GetTimeSeconds() - LastActivityTimeInternal);
+	if (RemainSec > UE_KINDA_SMALL_NUMBER)
+	{
+		World->GetTimerManager().SetTimer(AutoHideTimerInternal, this, &ThisClass::OnAutoHideTimer, RemainSec, false);
+		return;
+	}
+
+	SetMouseVisibility(false);
 }
 
 // Is called from input mouse event to reset inactivity time
 void UMouseActivityComponent::OnMouseMove_Implementation()
 {
-	CurrentlyInactiveSecInternal = 0.f;
+	if (const UWorld* World = GetWorld())
+	{
+		LastActivityTimeInternal = World->GetTimeSeconds();
+	}
 
 	const APlayerController& PC = GetPlayerControllerChecked();
 	if (!PC.ShouldShowMouseCursor()
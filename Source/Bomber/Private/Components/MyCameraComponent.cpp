@@ -3,6 +3,8 @@
 #include "Components/MyCameraComponent.h"
 //---
 #include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Components/MapComponent.h"
 #include "Controllers/MyPlayerController.h"
 #include "DataAssets/GameStateDataAsset.h"
 #include "Engine/MyGameViewportClient.h"
@@ -18,6 +20,13 @@
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MyCameraComponent)
 
+// Stop the camera tick once it reaches the location between players
+static TAutoConsoleVariable<bool> CVarCameraAutoSleep(
+	TEXT("Bomber.Camera.AutoSleep"),
+	true,
+	TEXT("Stop ticking the camera once it reaches its target until players move or the screen is resized: 1 (Sleep) OR 0 (Tick every frame)"),
+	ECVF_Default);
+
 // If set, returns additional FOV modifier scaled by level size and current screen aspect ratio
 void FCameraDistanceParams::CalculateFitViewAdditiveAngle(float& InOutFOV) const
 {
@@ -105,9 +114,12 @@ bool UMyCameraComponent::UpdateLocation(float DeltaTime/* = 0.f*/)
 		SetWorldLocation(NewLocation);
 	};
 
+	PruneTrackedPlayers();
+	const int32 AlivePlayersNum = !TrackedPlayerLocationsInternal.IsEmpty() ? TrackedPlayerLocationsInternal.Num() : UMyBlueprintFunctionLibrary::GetAlivePlayersNum();
+
 	// If true, the camera will be forced moving to the start position
 	if (bIsCameraLockedOnCenterInternal
-	    || !UMyBlueprintFunctionLibrary::GetAlivePlayersNum()
+	    || !AlivePlayersNum
 	    || bForceStartInternal)
 	{
 		static constexpr float Tolerance = 10.f;
@@ -124,7 +136,17 @@ bool UMyCameraComponent::UpdateLocation(float DeltaTime/* = 0.f*/)
 	}
 
 	// Distance finding between players
-	MoveCamera(GetCameraLocationBetweenPlayers());
+	const FVector LocationBetweenPlayers = GetCameraLocationBetweenPlayers();
+	if (CVarCameraAutoSleep.GetValueOnAnyThread()
+	    && !TrackedPlayerLocationsInternal.IsEmpty() // players are listened, so the camera will be woken up on their moves
+	    && GetComponentLocation().Equals(LocationBetweenPlayers, /*Tolerance*/1.f))
+	{
+		// The target is reached, snap to it and return false to fall asleep until players change their cells
+		SetWorldLocation(LocationBetweenPlayers);
+		return false;
+	}
+
+	MoveCamera(LocationBetweenPlayers);
 
 	return true;
 }
@@ -147,6 +169,7 @@ void UMyCameraComponent::SetCameraLockedOnCenter(bool bInCameraLockedOnCenter)
 void UMyCameraComponent::SetCameraDistanceParams(const FCameraDistanceParams& InCameraDistanceParams)
 {
 	DistanceParamsInternal = InCameraDistanceParams;
+	bIsLockedLocationDirtyInternal = true;
 
 	// Update camera location to apply new distance params
 	UpdateLocation();
@@ -174,8 +197,18 @@ float UMyCameraComponent::GetCameraDistanceToCells(const FCells& Cells) const
 // Returns the center location between all players and bots
 FVector UMyCameraComponent::GetCameraLocationBetweenPlayers() const
 {
-	const FCells PlayersCells = UCellsUtilsLibrary::GetAllCellsWithActors(TO_FLAG(EAT::Player));
-	FVector NewLocation = FCell::GetCellArrayCenter(PlayersCells).Location;
+	FVector NewLocation = FVector::ZeroVector;
+	if (const int32 TrackedPlayersNum = TrackedPlayerLocationsInternal.Num())
+	{
+		NewLocation = TrackedPlayersSumInternal / static_cast<float>(TrackedPlayersNum);
+	}
+	else
+	{
+		// Players are not tracked yet, e.g. is called outside of the match
+		const FCells PlayersCells = UCellsUtilsLibrary::GetAllCellsWithActors(TO_FLAG(EAT::Player));
+		NewLocation = FCell::GetCellArrayCenter(PlayersCells).Location;
+	}
+
 	NewLocation.Z = GetCameraLockedLocation().Z; // Z = CameraLock.Z: keep Z axis unchanged to avoid zooming in/out
 	return NewLocation;
 }
@@ -183,9 +216,25 @@ FVector UMyCameraComponent::GetCameraLocationBetweenPlayers() const
 // Returns the default location between all players and bots
 FVector UMyCameraComponent::GetCameraLockedLocation() const
 {
+	// Corners and the fit distance depend only on the grid, FOV and aspect ratio, so recalculate them only on their change
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const FTransform& GridTransform = GeneratedMap.GetGridTransform();
+	const float CurrentFOV = GetCameraManagerFOV();
+	if (!bIsLockedLocationDirtyInternal
+	    && FMath::IsNearlyEqual(CachedLockedFOVInternal, CurrentFOV)
+	    && CachedLockedGridTransformInternal.Equals(GridTransform))
+	{
+		return CachedLockedLocationInternal;
+	}
+
 	const FCells CornerCells = UCellsUtilsLibrary::GetCornerCellsOnLevel();
 	FVector NewLocation = FCell::GetCellArrayCenter(CornerCells).Location;
 	NewLocation.Z += GetCameraDistanceToCells(CornerCells); // Z = Corners.Z + FitDistance: find the distance to fit the view
+
+	CachedLockedLocationInternal = NewLocation;
+	CachedLockedGridTransformInternal = GridTransform;
+	CachedLockedFOVInternal = CurrentFOV;
+	bIsLockedLocationDirtyInternal = false;
 	return NewLocation;
 }
 
@@ -216,7 +265,7 @@ void UMyCameraComponent::BeginPlay()
 	// Listen states to manage the tick
 	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
-		MyGameState->OnGameStateChanged.AddDynamic(this, &ThisClass::OnGameStateChanged);
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 		// Handle current game state if initialized with delay
 		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -245,6 +294,7 @@ void UMyCameraComponent::OnGameStateChanged_Implementation(ECurrentGameState Cur
 			{
 				PossessCamera();
 			}
+			TrackPlayers();
 			bShouldTick = true;
 			break;
 		}
@@ -256,6 +306,8 @@ void UMyCameraComponent::OnGameStateChanged_Implementation(ECurrentGameState Cur
 		}
 		case ECurrentGameState::InGame:
 		{
+			// Track again, since on clients some players might be not replicated yet on starting
+			TrackPlayers();
 			bForceStartInternal = false;
 			bShouldTick = true;
 			break;
@@ -270,7 +322,76 @@ void UMyCameraComponent::OnGameStateChanged_Implementation(ECurrentGameState Cur
 // Listen to recalculate camera location when screen aspect ratio was changed
 void UMyCameraComponent::OnAspectRatioChanged_Implementation(float NewAspectRatio, EAspectRatioAxisConstraint NewAxisConstraint)
 {
+	bIsLockedLocationDirtyInternal = true;
 	UpdateLocation();
+	WakeUpCamera();
+}
+
+// Starts listening cells of all players on the level, so their center is updated incrementally
+void UMyCameraComponent::TrackPlayers()
+{
+	TrackedPlayerLocationsInternal.Reset();
+	TrackedPlayersSumInternal = FVector::ZeroVector;
+
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	GeneratedMap.OnAnyCharacterDestroyed.AddUniqueDynamic(this, &ThisClass::OnAnyCharacterDestroyed);
+	GeneratedMap.OnGeneratedMapWantsReconstruct.AddUniqueDynamic(this, &ThisClass::OnGeneratedMapWantsReconstruct);
+
+	FMapComponents PlayerComponents;
+	GeneratedMap.GetMapComponents(PlayerComponents, TO_FLAG(EAT::Player));
+	for (UMapComponent* MapComponentIt : PlayerComponents)
+	{
+		const FCell& CellIt = MapComponentIt ? MapComponentIt->GetCell() : FCell::InvalidCell;
+		if (CellIt.IsInvalidCell())
+		{
+			continue;
+		}
+
+		MapComponentIt->OnCellChanged.AddUniqueDynamic(this, &ThisClass::OnPlayerCellChanged);
+		TrackedPlayerLocationsInternal.Emplace(MapComponentIt, CellIt.Location);
+		TrackedPlayersSumInternal += CellIt.Location;
+	}
+}
+
+// Is called when any tracked player changes its cell to update the center between players
+void UMyCameraComponent::OnPlayerCellChanged(UMapComponent* MapComponent, const FCell& NewCell, const FCell& PreviousCell)
+{
+	FVector* TrackedLocation = TrackedPlayerLocationsInternal.Find(MapComponent);
+	if (!TrackedLocation)
+	{
+		return;
+	}
+
+	TrackedPlayersSumInternal -= *TrackedLocation;
+	if (NewCell.IsInvalidCell())
+	{
+		// The player has left the level
+		TrackedPlayerLocationsInternal.Remove(MapComponent);
+		WakeUpCamera();
+		return;
+	}
+
+	*TrackedLocation = NewCell.Location;
+	TrackedPlayersSumInternal += NewCell.Location;
+
+	WakeUpCamera();
+}
+
+// Stops tracking players that are not on the level anymore, is cheap since only few players are tracked
+void UMyCameraComponent::PruneTrackedPlayers()
+{
+	for (TMap<TObjectKey<UMapComponent>, FVector>::TIterator It = TrackedPlayerLocationsInternal.CreateIterator(); It; ++It)
+	{
+		// Killed players are returned to the pool where they are hidden, it works the same on server and clients
+		const UMapComponent* MapComponent = It.Key().ResolveObjectPtr();
+		const AActor* Owner = MapComponent ? MapComponent->GetOwner() : nullptr;
+		if (!Owner
+		    || Owner->IsHidden())
+		{
+			TrackedPlayersSumInternal -= It.Value();
+			It.RemoveCurrent();
+		}
+	}
 }
 
 // Starts viewing through this camera
@@ -292,3 +413,33 @@ void UMyCameraComponent::SetAutoPossessCameraEnabled(bool bInAutoPossessCamera)
 {
 	bAutoPossessCameraInternal = bInAutoPossessCamera;
 }
+
+// Enables the tick again if the camera fell asleep on reaching its target, but the target might be changed
+void UMyCameraComponent::WakeUpCamera()
+{
+	if (IsComponentTickEnabled())
+	{
+		return;
+	}
+
+	const ECurrentGameState CurrentGameState = AMyGameStateBase::GetCurrentGameState();
+	if (CurrentGameState == ECurrentGameState::InGame
+	    || CurrentGameState == ECurrentGameState::GameStarting
+	    || CurrentGameState == ECurrentGameState::EndGame)
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+// Is called when any character is destroyed to wake up the camera
+void UMyCameraComponent::OnAnyCharacterDestroyed()
+{
+	WakeUpCamera();
+}
+
+// Is called when the level is resized or moved to recalculate the locked location
+void UMyCameraComponent::OnGeneratedMapWantsReconstruct(const FTransform& Transform)
+{
+	bIsLockedLocationDirtyInternal = true;
+	WakeUpCamera();
+}
@@ -3,6 +3,7 @@
 #include "Components/MySkeletalMeshComponent.h"
 //---
 #include "DataAssets/PlayerDataAsset.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
 //---
 #include "Animation/AnimSequence.h"
 #include "Components/GameFrameworkComponentManager.h"
@@ -82,6 +83,10 @@ UMySkeletalMeshComponent::UMySkeletalMeshComponent()
 	PrimaryComponentTick.bCanEverTick = true;
 
 	CastShadow = false;
+
+	// Skip animation frames by the distance to the camera, only montages are ticked while the mesh is not rendered to keep their notifies
+	bEnableUpdateRateOptimizations = true;
+	VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
 }
 
 // Controls what kind of collision is enabled for this body and all attached props
@@ -197,30 +202,65 @@ void UMySkeletalMeshComponent::AttachProps()
 {
 	const UPlayerRow* PlayerRow = PlayerMeshDataInternal.PlayerRow;
 	if (!PlayerRow
-	    || !ArePropsWantToUpdate())
+	    || !ArePropsWantToUpdate()
+	    || UUtilsLibrary::IsDedicatedServer()) // Props are cosmetics, no need to create their components on the server
 	{
 		return;
 	}
 
 	AttachedMeshesTypeInternal = PlayerRow->LevelType;
 
-	// Destroy previous meshes
-	for (int32 Index = AttachedMeshesInternal.Num() - 1; Index >= 0; --Index)
-	{
-		UMeshComponent* MeshComponentIt = AttachedMeshesInternal.IsValidIndex(Index) ? AttachedMeshesInternal[Index] : nullptr;
-		if (MeshComponentIt)
-		{
-			AttachedMeshesInternal.RemoveAt(Index);
-			MeshComponentIt->DestroyComponent();
-		}
-	}
+	// Previous components are reused by new props with the same socket and class, the rest is destroyed at the end
+	TArray<TObjectPtr<UMeshComponent>> PreviousMeshes = MoveTemp(AttachedMeshesInternal);
+	AttachedMeshesInternal.Reset();
 
 	// Spawn new components and attach meshes
 	const TArray<FAttachedMesh>& PlayerProps = PlayerRow->PlayerProps;
 	for (const FAttachedMesh& AttachedMeshIt : PlayerProps)
 	{
+		const auto SkeletalMeshProp = Cast<USkeletalMesh>(AttachedMeshIt.AttachedMesh);
+		const auto StaticMeshProp = Cast<UStaticMesh>(AttachedMeshIt.AttachedMesh);
+		const UClass* PropComponentClass = SkeletalMeshProp ? USkeletalMeshComponent::StaticClass()
+		                                   : StaticMeshProp ? UStaticMeshComponent::StaticClass()
+		                                   : nullptr;
+
+		const int32 ReusedIndex = PropComponentClass ? PreviousMeshes.IndexOfByPredicate([PropComponentClass, &AttachedMeshIt](const UMeshComponent* It)
+		{
+			return It
+			    && It->GetClass() == PropComponentClass
+			    && It->GetAttachSocketName() == AttachedMeshIt.Socket;
+		}) : INDEX_NONE;
+
+		if (ReusedIndex != INDEX_NONE)
+		{
+			// Swap the mesh on already attached and registered component, so no render state is recreated
+			UMeshComponent* ReusedComponent = PreviousMeshes[ReusedIndex];
+			PreviousMeshes.RemoveAtSwap(ReusedIndex);
+			if (USkeletalMeshComponent* SkeletalComponent = Cast<USkeletalMeshComponent>(ReusedComponent))
+			{
+				SkeletalComponent->SetSkeletalMesh(SkeletalMeshProp);
+				if (AttachedMeshIt.MeshAnimation)
+				{
+					SkeletalComponent->OverrideAnimationData(AttachedMeshIt.MeshAnimation);
+				}
+				else
+				{
+					SkeletalComponent->SetAnimation(nullptr);
+				}
+			}
+			else if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(ReusedComponent))
+			{
+				StaticMeshComponent->SetStaticMesh(StaticMeshProp);
+			}
+
+			ReusedComponent->SetCastShadow(CastShadow);
+			ReusedComponent->LightingChannels = LightingChannels;
+			AttachedMeshesInternal.Emplace(ReusedComponent);
+			continue;
+		}
+
 		UMeshComponent* MeshComponent = nullptr;
-		if (const auto SkeletalMeshProp = Cast<USkeletalMesh>(AttachedMeshIt.AttachedMesh))
+		if (SkeletalMeshProp)
 		{
 			USkeletalMeshComponent* SkeletalComponent = NewObject<USkeletalMeshComponent>(this, NAME_None, RF_Transient);
 			SkeletalComponent->SetSkeletalMesh(SkeletalMeshProp);
@@ -231,7 +271,7 @@ void UMySkeletalMeshComponent::AttachProps()
 			}
 			MeshComponent = SkeletalComponent;
 		}
-		else if (const auto StaticMeshProp = Cast<UStaticMesh>(AttachedMeshIt.AttachedMesh))
+		else if (StaticMeshProp)
 		{
 			UStaticMeshComponent* StaticMeshComponent = NewObject<UStaticMeshComponent>(this, NAME_None, RF_Transient);
 			StaticMeshComponent->SetStaticMesh(StaticMeshProp);
@@ -261,6 +301,15 @@ void UMySkeletalMeshComponent::AttachProps()
 		MeshComponent->AttachToComponent(this, AttachRules, AttachedMeshIt.Socket);
 		MeshComponent->RegisterComponent();
 	}
+
+	// Destroy previous meshes that were not reused
+	for (UMeshComponent* MeshComponentIt : PreviousMeshes)
+	{
+		if (MeshComponentIt)
+		{
+			MeshComponentIt->DestroyComponent();
+		}
+	}
 }
 
 // Returns true when is needed to attach or detach props
@@ -333,7 +382,11 @@ void UMySkeletalMeshComponent::SetSkin(int32 SkinIndex)
 		const TArray<UMaterialInterface*>& AllMaterials = MeshComponent->GetMaterials();
 		for (int32 Index = 0; Index < AllMaterials.Num(); ++Index)
 		{
-			MeshComponent->SetMaterial(Index, MaterialInstanceDynamic);
+			// Skip slots that already use the shared instance, so the render state is not recreated on repeated skin changes
+			if (AllMaterials[Index] != MaterialInstanceDynamic)
+			{
+				MeshComponent->SetMaterial(Index, MaterialInstanceDynamic);
+			}
 		}
 	};
 
@@ -3,17 +3,22 @@
 #include "Controllers/MyAIController.h"
 //---
 #include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Components/GridPathFollowingComponent.h"
 #include "Components/MapComponent.h"
 #include "DataAssets/AIDataAsset.h"
 #include "DataAssets/GameStateDataAsset.h"
+#include "Engine/BomberPerfBudget.h"
+#include "Engine/BomberTelemetry.h"
 #include "GameFramework/MyGameStateBase.h"
 #include "LevelActors/PlayerCharacter.h"
 #include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/AISchedulerSubsystem.h"
 #include "UtilityLibraries/CellsUtilsLibrary.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
-#include "TimerManager.h"
 #include "Components/GameFrameworkComponentManager.h"
+#include "GameFramework/CharacterMovementComponent.h"
 //---
 #if WITH_EDITOR
 #include "MyUnrealEdEngine.h"
@@ -29,6 +34,49 @@ static TAutoConsoleVariable<bool> CVarAISetEnabled(
 	TEXT("Enable or disable all bots: 1 (Enable) OR 0 (Disable)"),
 	ECVF_Default);
 
+// Move bots by the grid path follower instead of the navmesh
+static TAutoConsoleVariable<bool> CVarAIGridNavigation(
+	TEXT("Bomber.AI.GridNavigation"),
+	true,
+	TEXT("Move bots by the distance field on the cells grid: 1 (Grid) OR 0 (Navmesh)"),
+	ECVF_Default);
+
+// Skip decisions while nothing is changed around the bot
+static TAutoConsoleVariable<bool> CVarAIDecisionCache(
+	TEXT("Bomber.AI.DecisionCache"),
+	true,
+	TEXT("Skip decisions of bots while the bot keeps its cell and nothing is changed around: 1 (Enable) OR 0 (Disable)"),
+	ECVF_Default);
+
+namespace MyAIController
+{
+	/** Temporary bitboards of one decision, are kept per thread by GetDecisionScratch(),
+	 * so next decisions reuse their bits instead of allocating and freeing them on each update. */
+	struct FDecisionScratch
+	{
+		FCellsBitboard Free;
+		FCellsBitboard ItemsFromF0;
+		FCellsBitboard AllCrossways;
+		FCellsBitboard SecureCrossways;
+		FCellsBitboard FoundItems;
+		FCellsBitboard FreeToIterate;
+		FCellsBitboard ThisCrossway;
+		FCellsBitboard Way;
+		FCellsBitboard ItemsAround;
+		FCellsBitboard Filtered;
+		FCellsBitboard FilteringStep;
+		FCellsBitboard SecureCells;
+		FCellsBitboard BoxesAndPlayers;
+	};
+
+	/** Returns scratch bitboards of the calling thread, decisions are made both on the game thread and on workers. */
+	FDecisionScratch& GetDecisionScratch()
+	{
+		static thread_local FDecisionScratch DecisionScratch;
+		return DecisionScratch;
+	}
+}
+
 // Sets default values for this character's properties
 AMyAIController::AMyAIController()
 {
@@ -37,6 +85,9 @@ AMyAIController::AMyAIController()
 	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	bAttachToPawn = true;
+
+	// Initialize the grid path follower
+	GridPathFollowingInternal = CreateDefaultSubobject<UGridPathFollowingComponent>(TEXT("GridPathFollowingComponent"));
 }
 
 // Makes AI go toward specified destination cell
@@ -50,7 +101,14 @@ void AMyAIController::MoveToCell(const FCell& DestinationCell)
 	if (!IsMoveInputIgnored())
 	{
 		AIMoveToInternal = DestinationCell;
-		MoveToLocation(AIMoveToInternal.Location, INDEX_NONE, false, false);
+		if (CVarAIGridNavigation.GetValueOnAnyThread())
+		{
+			GridPathFollowingInternal->MoveToCell(AIMoveToInternal);
+		}
+		else
+		{
+			MoveToLocation(AIMoveToInternal.Location, INDEX_NONE, false, false);
+		}
 	}
 
 #if WITH_EDITOR	 // [IsEditor]
@@ -98,19 +156,6 @@ void AMyAIController::PostInitializeComponents()
 	UGameFrameworkComponentManager::AddGameFrameworkComponentReceiver(this);
 }
 
-//  Called when the game starts or when spawned
-void AMyAIController::BeginPlay()
-{
-	// Call to super
-	Super::BeginPlay();
-
-	// Setup timer handle to update AI brain (initialized being paused)
-	constexpr bool bInLoop = true;
-	FTimerManager& TimerManager = GetWorldTimerManager();
-	TimerManager.SetTimer(AIUpdateHandleInternal, this, &ThisClass::UpdateAI, UGameStateDataAsset::Get().GetTickInterval(), bInLoop, KINDA_SMALL_NUMBER);
-	TimerManager.PauseTimer(AIUpdateHandleInternal);
-}
-
 // Allows the controller to react on possessing the pawn
 void AMyAIController::OnPossess(APawn* InPawn)
 {
@@ -134,7 +179,7 @@ void AMyAIController::OnPossess(APawn* InPawn)
 	// Listen states
 	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
-		MyGameState->OnGameStateChanged.AddUniqueDynamic(this, &ThisClass::OnGameStateChanged);
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 		// Handle current game state if initialized with delay
 		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -177,153 +222,278 @@ void AMyAIController::Reset()
 {
 	// Abort current movement task
 	Super::Reset();
+	GridPathFollowingInternal->StopMovement();
 
 	// Reset target location
 	AIMoveToInternal = FCell::InvalidCell;
+	DecisionCacheInternal = FAIDecisionCache();
 }
 
 // The main AI logic
 void AMyAIController::UpdateAI()
+{
+	BOMBER_PERF_BUDGET_SCOPE(UpdateAI);
+
+	FAIDecisionInput Input;
+	if (!PrepareDecision(Input))
+	{
+		return;
+	}
+
+	FAIDecision Decision;
+	const double StartTime = FPlatformTime::Seconds();
+	MakeDecision(AGeneratedMap::Get(GetPawn()).GetAIWorldSnapshot(), Input, Decision);
+	const double DecisionSeconds = FPlatformTime::Seconds() - StartTime;
+	DecisionStatsInternal.AddDecision(DecisionSeconds);
+	RecordDecisionTelemetry(Decision, DecisionSeconds);
+
+	ApplyDecision(Decision);
+}
+
+// Writes the made decision to the telemetry if enabled
+void AMyAIController::RecordDecisionTelemetry(const FAIDecision& Decision, double DecisionSeconds) const
+{
+	if (!FBomberTelemetry::IsEnabled()
+	    || !OwnerInternal)
+	{
+		return;
+	}
+
+	const UMapComponent* MapComponent = UMapComponent::GetMapComponent(OwnerInternal);
+	const int32 CellIndex = MapComponent ? AGeneratedMap::Get(this).GetCellIndex(MapComponent->GetCell()) : INDEX_NONE;
+	FBomberTelemetry::RecordEvent(EBomberTelemetryEvent::AIDecision, CellIndex, OwnerInternal->GetCharacterID(), Decision.MoveToCellIndex, static_cast<float>(DecisionSeconds * 1000.0));
+}
+
+// Gathers on the game thread everything that is needed to make the decision
+bool AMyAIController::PrepareDecision(FAIDecisionInput& OutInput)
 {
 	const UMapComponent* MapComponent = UMapComponent::GetMapComponent(OwnerInternal);
 	if (!OwnerInternal
 	    || !IsValid(MapComponent)
 	    || !CVarAISetEnabled.GetValueOnAnyThread()) // AI is disabled
 	{
-		return;
+		return false;
 	}
 
-	const UAIDataAsset& AIDataAsset = UAIDataAsset::Get();
-
 #if WITH_EDITOR
 	if (FEditorUtilsLibrary::IsEditorNotPieWorld()) // [IsEditorNotPieWorld]
 	{
 		UCellsUtilsLibrary::ClearDisplayedCells(OwnerInternal);
 		AIMoveToInternal = FCell::InvalidCell;
 	}
+
+	OutInput.bShouldShowRenders = MapComponent->bShouldShowRenders;
 #endif	// WITH_EDITOR [IsEditorNotPieWorld]
 
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(GetPawn());
+	OutInput.CellIndex = GeneratedMap.GetCellIndex(MapComponent->GetCell());
+	OutInput.MoveToCellIndex = GeneratedMap.GetCellIndex(AIMoveToInternal);
+	OutInput.FireRadius = OwnerInternal->GetPowerups().FireN;
+
+	const UAIDataAsset& AIDataAsset = UAIDataAsset::Get();
+	OutInput.ItemSearchRadius = AIDataAsset.GetItemSearchRadius();
+	OutInput.CrosswaySearchRadius = AIDataAsset.GetCrosswaySearchRadius();
+	OutInput.NearDangerousRadius = AIDataAsset.GetNearDangerousRadius();
+	OutInput.NearFilterRadius = AIDataAsset.GetNearFilterRadius();
+	OutInput.DangerSafetyMargin = AIDataAsset.GetDangerSafetyMargin();
+
+	// ----- Skipping the decision if the previous one is still actual -----
+
+	const FAIWorldSnapshot& Snapshot = GeneratedMap.GetAIWorldSnapshot();
+	const bool bCanUseCache = CVarAIDecisionCache.GetValueOnGameThread()
+	                          && GridPathFollowingInternal->IsMoving()          // is still following the previous decision
+	                          && !Snapshot.DangerousCells.IsSet(OutInput.CellIndex); // escaping depends on time, so is decided each update
+	const int32 CacheRadius = FMath::Max(OutInput.CrosswaySearchRadius, OutInput.ItemSearchRadius);
+	if (bCanUseCache
+	    && DecisionCacheInternal.CellIndex == OutInput.CellIndex
+	    && DecisionCacheInternal.FireRadius == OutInput.FireRadius
+	    && !Snapshot.IsChangedAround(OutInput.CellIndex, CacheRadius, DecisionCacheInternal.BuildNumber))
+	{
+		return false;
+	}
+
+	DecisionCacheInternal.CellIndex = OutInput.CellIndex;
+	DecisionCacheInternal.FireRadius = OutInput.FireRadius;
+	DecisionCacheInternal.BuildNumber = Snapshot.BuildNumber;
+
+	OutInput.RandomSeed = FMath::Rand();
+
+	const UWorld* World = GetWorld();
+	OutInput.CurrentTime = World ? World->GetTimeSeconds() : 0.f;
+
+	const UCharacterMovementComponent* MovementComponent = OwnerInternal->GetCharacterMovement();
+	const float MaxSpeed = MovementComponent ? MovementComponent->GetMaxSpeed() : 0.f;
+	OutInput.SecondsPerCell = MaxSpeed > 0.f ? FCell::CellSize / MaxSpeed : 0.f;
+	return true;
+}
+
+// Decides where to move and whether to put the bomb, does not touch any object, so could be called outside of the game thread
+void AMyAIController::MakeDecision(const FAIWorldSnapshot& Snapshot, const FAIDecisionInput& Input, FAIDecision& OutDecision)
+{
 	// ----- Part 0: Before iterations -----
 
 	// Set the START cell searching bot location
-	const FCell& F0 = MapComponent->GetCell();
+	const int32 C0 = Input.CellIndex;
+	if (!Snapshot.IsValidIndex(C0))
+	{
+		return;
+	}
 
-	// Searching 'SAFE NEIGHBORS'
-	static constexpr int32 MaxInteger = TNumericLimits<int32>::Max();
-	FCells Free;
-	uint8 bIsDangerous;
-	for (bIsDangerous = 0; bIsDangerous <= 1; ++bIsDangerous) // two searches (safe and free)
+	const FCell& F0 = Snapshot.GridCells[C0];
+
+	// Escaping by detonation times of dangerous cells, so the bot does not run through cells that are about to explode
+	if (Snapshot.DangerousCells.IsSet(C0))
 	{
-		Free = UCellsUtilsLibrary::GetCellsAround(F0, bIsDangerous ? EPathType::Free : EPathType::Safe, MaxInteger);
-		if (!bIsDangerous && Free.Num() > 0)
+		const int32 MaxEscapeSteps = Snapshot.GridSize.X + Snapshot.GridSize.Y;
+		const int32 EscapeCellIndex = Snapshot.FindEscapeCell(C0, Input.CurrentTime, Input.SecondsPerCell, Input.DangerSafetyMargin, MaxEscapeSteps);
+		if (EscapeCellIndex != INDEX_NONE)
 		{
-			// Remove this cell from array
-			bIsDangerous = !Free.Remove(F0); // if it can't be removed - the bot is standing in the explosion
-			break;
+			OutDecision.MoveToCellIndex = EscapeCellIndex;
+			return;
 		}
+		// There is no escape, so try to find more or less safe cell around
+	}
+
+	// Bitboards are initialized by each use, their bits are reused by next decisions of this thread
+	MyAIController::FDecisionScratch& Scratch = MyAIController::GetDecisionScratch();
+
+	// Searching 'SAFE NEIGHBORS'
+	static constexpr int32 MaxInteger = TNumericLimits<int32>::Max();
+	FCellsBitboard& Free = Scratch.Free;
+	Snapshot.GetCellsAround(Free, C0, EPathType::Safe, MaxInteger);
+	bool bIsDangerous = false;
+	if (!Free.IsEmpty())
+	{
+		// Remove this cell from found cells, if it can't be removed - the bot is standing in the explosion
+		bIsDangerous = !Free.IsSet(C0);
+		Free.SetBit(C0, false);
+	}
+	else
+	{
+		bIsDangerous = true;
+		Snapshot.GetCellsAround(Free, C0, EPathType::Free, MaxInteger);
 	}
 
 	// Is there an item nearby?
 	if (bIsDangerous == false)
 	{
-		const FCells ItemsFromF0 = UCellsUtilsLibrary::GetCellsAroundWithActors(F0, EPathType::Safe, AIDataAsset.GetItemSearchRadius(), TO_FLAG(EAT::Item));
-		if (!ItemsFromF0.IsEmpty())
+		FCellsBitboard& ItemsFromF0 = Scratch.ItemsFromF0;
+		Snapshot.GetCellsAround(ItemsFromF0, C0, EPathType::Safe, Input.ItemSearchRadius);
+		Snapshot.FilterCellsByActors(ItemsFromF0, TO_FLAG(EAT::Item));
+		const int32 FirstItemIndex = ItemsFromF0.Bits.Find(true);
+		if (FirstItemIndex != INDEX_NONE)
 		{
-			MoveToCell(FCell::GetFirstCellInSet(ItemsFromF0));
+			OutDecision.MoveToCellIndex = FirstItemIndex;
 			return;
 		}
 	}
 	// ----- Part 1: Cells iteration -----
 
-	FCells AllCrossways;    //  cells of all crossways
-	FCells SecureCrossways; // crossways without players
-	FCells FoundItems;
+	FCellsBitboard& AllCrossways = Scratch.AllCrossways;       //  cells of all crossways
+	FCellsBitboard& SecureCrossways = Scratch.SecureCrossways; // crossways without players
+	FCellsBitboard& FoundItems = Scratch.FoundItems;
+	AllCrossways.Init(Snapshot.Num());
+	SecureCrossways.Init(Snapshot.Num());
+	FoundItems.Init(Snapshot.Num());
 	bool bIsItemInDirect = false;
 
-	for (auto F = Free.CreateIterator(); F; ++F)
+	// Cells are removed from Free during iterations, so iterate its copy
+	FCellsBitboard& FreeToIterate = Scratch.FreeToIterate;
+	FreeToIterate = Free;
+	FCellsBitboard& ThisCrossway = Scratch.ThisCrossway;
+	FCellsBitboard& Way = Scratch.Way;
+	for (TConstSetBitIterator<> F(FreeToIterate.Bits); F; ++F)
 	{
+		const int32 FIndex = F.GetIndex();
 		if (bIsDangerous // is not dangerous situation
-		    && FCell::Distance<float>(F0, *F) > AIDataAsset.GetNearDangerousRadius())
+		    && FCell::Distance<float>(F0, Snapshot.GridCells[FIndex]) > Input.NearDangerousRadius)
 		{
-			F.RemoveCurrent(); // removing distant cells
+			Free.SetBit(FIndex, false); // removing distant cells
 			continue;
 		}
 
-		const FCells ThisCrossway = UCellsUtilsLibrary::GetCellsAround(*F, EPathType::Safe, AIDataAsset.GetCrosswaySearchRadius());
-		FCells Way = Free;                  // Way = Safe / (Free + F0)
-		Way.Emplace(F0);                    // Way = Free + F0
-		Way = ThisCrossway.Difference(Way); // Way = Safe / Way
+		// Is the crossway if there are safe cells by the side perpendicular to the line from F0, these cells are never contained in Free
+		const bool bHorizontalLine = FIndex / Snapshot.GridSize.X == C0 / Snapshot.GridSize.X;
+		const bool bIsCrossway = FIndex != C0 && Snapshot.GetCrossway(FIndex).HasPerpendicularSide(bHorizontalLine, Input.CrosswaySearchRadius);
 
-		if (Way.Num() > 0) // Are there any cells?
+		if (bIsCrossway) // Are there any cells?
 		{
+			Snapshot.GetSafeCellsAround(ThisCrossway, FIndex, Input.CrosswaySearchRadius);
+
 			// Finding crossways
-			AllCrossways.Emplace(*F); // is the crossway
-			Way = UCellsUtilsLibrary::FilterCellsByActors(ThisCrossway, TO_FLAG(EAT::Player));
-			Way.Remove(MapComponent->GetCell());
-			if (Way.Num() == 0)
+			AllCrossways.SetBit(FIndex, true); // is the crossway
+			Way = ThisCrossway;
+			Snapshot.FilterCellsByActors(Way, TO_FLAG(EAT::Player));
+			Way.SetBit(C0, false);
+			if (Way.IsEmpty())
 			{
-				SecureCrossways.Emplace(*F);
+				SecureCrossways.SetBit(FIndex, true);
 			}
 
 			// Finding items
-			FCells ItemsAround = UCellsUtilsLibrary::FilterCellsByActors(ThisCrossway, TO_FLAG(EAT::Item));
-			if (ItemsAround.Num() > 0) // Is there items in this crossway?
+			FCellsBitboard& ItemsAround = Scratch.ItemsAround;
+			ItemsAround = ThisCrossway;
+			Snapshot.FilterCellsByActors(ItemsAround, TO_FLAG(EAT::Item));
+			if (!ItemsAround.IsEmpty()) // Is there items in this crossway?
 			{
-				ItemsAround = ItemsAround.Intersect(Free); // ItemsAround = ItemsAround ∪ Free
-				if (ItemsAround.Num() > 0)                 // Is there direct items in this crossway?
+				ItemsAround &= Free;        // ItemsAround = ItemsAround ∪ Free
+				if (!ItemsAround.IsEmpty()) // Is there direct items in this crossway?
 				{
 					if (bIsItemInDirect == false) // is the first found direct item
 					{
 						bIsItemInDirect = true;
-						FoundItems.Empty(); // clear all previously found corner items
+						FoundItems.Init(Snapshot.Num()); // clear all previously found corner items
 					}
-					FoundItems = FoundItems.Union(ItemsAround); // Add found direct items
-				}                                               // item around the corner
-				else if (bIsItemInDirect == false)              // Need corner item?
+					FoundItems |= ItemsAround;    // Add found direct items
+				}                                 // item around the corner
+				else if (bIsItemInDirect == false) // Need corner item?
 				{
-					FoundItems.Emplace(*F); // Add found corner item
+					FoundItems.SetBit(FIndex, true); // Add found corner item
 				}
 			} // [has items]
 		}     // [is crossway]
-		else if (bIsDangerous && ThisCrossway.Contains(*F) == false)
+		else if (bIsDangerous && Snapshot.DangerousCells.IsSet(FIndex))
 		{
-			F.RemoveCurrent(); // In the dangerous situation delete a non-crossway cell
+			Free.SetBit(FIndex, false); // In the dangerous situation delete a non-crossway cell
 		}
 	}
 
-	Free.Compact();
-	Free.Shrink();
-	if (Free.Num() == 0)
+	if (Free.IsEmpty())
 	{
 		return;
 	}
 
 	// ----- Part 2: Cells filtration -----
 
-	FCells Filtered = FoundItems.Num() > 0 ? FoundItems : Free; // selected cells
+	FCellsBitboard& Filtered = Scratch.Filtered; // selected cells
+	Filtered = !FoundItems.IsEmpty() ? FoundItems : Free;
 	bool bIsFilteringFailed = false;
 	static constexpr int32 FilteringStepsNum = 4;
 	for (int32 Index = 0; Index < FilteringStepsNum; ++Index)
 	{
-		FCells FilteringStep;
+		FCellsBitboard& FilteringStep = Scratch.FilteringStep;
+		FilteringStep = Filtered;
 		switch (Index)
 		{
 			case 0: // All crossways: Filtered ∪ AllCrossways
-				FilteringStep = Filtered.Intersect(AllCrossways);
+				FilteringStep &= AllCrossways;
 				break;
 			case 1: // Without players
-				FilteringStep = UCellsUtilsLibrary::GetCellsAround(F0, EPathType::Secure, MaxInteger);
-				FilteringStep = Filtered.Intersect(FilteringStep);
+			{
+				FCellsBitboard& SecureCells = Scratch.SecureCells;
+				Snapshot.GetCellsAround(SecureCells, C0, EPathType::Secure, MaxInteger);
+				FilteringStep &= SecureCells;
 				break;
+			}
 			case 2: // Without crossways with another players
-				FilteringStep = Filtered.Intersect(SecureCrossways);
+				FilteringStep &= SecureCrossways;
 				break;
 			case 3: // Only nearest cells (length <= near radius)
-				for (const FCell& It : Filtered)
+				for (TConstSetBitIterator<> It(Filtered.Bits); It; ++It)
 				{
-					if (FCell::Distance<float>(F0, It) <= AIDataAsset.GetNearFilterRadius())
+					if (FCell::Distance<float>(F0, Snapshot.GridCells[It.GetIndex()]) > Input.NearFilterRadius)
 					{
-						FilteringStep.Emplace(It);
+						FilteringStep.SetBit(It.GetIndex(), false);
 					}
 				}
 				break;
@@ -331,8 +501,9 @@ void AMyAIController::UpdateAI()
 				break;
 		}
 
-		if (FilteringStep.Num() > 0)
+		if (!FilteringStep.IsEmpty())
 		{
+			// Is copied instead of moved to keep bits of both scratch bitboards
 			Filtered = FilteringStep;
 		}
 		else
@@ -347,75 +518,160 @@ void AMyAIController::UpdateAI()
 	    && bIsFilteringFailed == false // filtering was not failed
 	    && bIsItemInDirect == false)   // was not found direct items
 	{
-		FCells BoxesAndPlayers = UCellsUtilsLibrary::GetCellsAroundWithActors(F0, EPathType::Explosion, OwnerInternal->GetPowerups().FireN, TO_FLAG(EAT::Box | EAT::Player));
-		BoxesAndPlayers.Remove(MapComponent->GetCell());
-		if (BoxesAndPlayers.Num() > 0) // Are bombs or players in own bomb radius
+		FCellsBitboard& BoxesAndPlayers = Scratch.BoxesAndPlayers;
+		Snapshot.GetCellsAround(BoxesAndPlayers, C0, EPathType::Explosion, Input.FireRadius);
+		Snapshot.FilterCellsByActors(BoxesAndPlayers, TO_FLAG(EAT::Box | EAT::Player));
+		BoxesAndPlayers.SetBit(C0, false);
+		if (!BoxesAndPlayers.IsEmpty()) // Are bombs or players in own bomb radius
 		{
-			OwnerInternal->ServerSpawnBomb();
-			Free.Empty(); // Delete all cells to make new choice
+			OutDecision.bSpawnBomb = true;
+			Free.Init(Snapshot.Num()); // Delete all cells to make new choice
+		}
+	}
+
+	// ----- Part 3: Making choice-----
+
+	if (Free.IsSet(Input.MoveToCellIndex))
+	{
+		return;
+	}
+
+	// Pick random cell among filtered ones
+	const FRandomStream RandomStream(Input.RandomSeed);
+	int32 ChosenNumber = RandomStream.RandRange(0, Filtered.CountSetBits() - 1);
+	for (TConstSetBitIterator<> It(Filtered.Bits); It; ++It)
+	{
+		if (ChosenNumber-- == 0)
+		{
+			OutDecision.MoveToCellIndex = It.GetIndex();
+			break;
+		}
+	}
 
 #if WITH_EDITOR	 // [Editor]
-			if (MapComponent->bShouldShowRenders)
-			{
-				static const FDisplayCellsParams DisplayParams{FLinearColor::Red, 261.F, 95.F, TEXT("Attack")};
-				UCellsUtilsLibrary::DisplayCell(OwnerInternal, F0, DisplayParams);
-			}
+	if (Input.bShouldShowRenders)
+	{
+		OutDecision.AllCrossways = AllCrossways;
+		OutDecision.SecureCrossways = SecureCrossways;
+		OutDecision.Filtered = Filtered;
+	}
 #endif	// [Editor]
-		}
+}
+
+// Applies the decision on the game thread
+void AMyAIController::ApplyDecision(const FAIDecision& Decision)
+{
+	if (!OwnerInternal)
+	{
+		return;
 	}
 
-	// ----- Part 3: Making choice-----
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(GetPawn());
 
-	if (Free.Contains(AIMoveToInternal))
+	if (Decision.bSpawnBomb)
+	{
+		OwnerInternal->ServerSpawnBomb();
+
+#if WITH_EDITOR	 // [Editor]
+		const UMapComponent* MapComponent = UMapComponent::GetMapComponent(OwnerInternal);
+		if (MapComponent && MapComponent->bShouldShowRenders)
+		{
+			static const FDisplayCellsParams DisplayParams{FLinearColor::Red, 261.F, 95.F, TEXT("Attack")};
+			UCellsUtilsLibrary::DisplayCell(OwnerInternal, MapComponent->GetCell(), DisplayParams);
+		}
+#endif	// [Editor]
+	}
+
+	if (Decision.MoveToCellIndex == INDEX_NONE)
 	{
 		return;
 	}
 
-	MoveToCell(Filtered.Array()[FMath::RandRange(0, Filtered.Num() - 1)]);
+	MoveToCell(GeneratedMap.GetCellByIndex(Decision.MoveToCellIndex));
 
 #if WITH_EDITOR	 // [Editor]
-	if (MapComponent->bShouldShowRenders)
+	static constexpr int32 VisualizationTypesNum = 3;
+	for (int32 Index = 0; Index < VisualizationTypesNum; ++Index)
 	{
-		static constexpr int32 VisualizationTypesNum = 3;
-		for (int32 Index = 0; Index < VisualizationTypesNum; ++Index)
+		FCellsBitboard VisualizingStep;
+		FLinearColor Color;
+		FName Symbol = TEXT("+");
+		FVector Position = FVector::ZeroVector;
+		switch (Index)
 		{
-			FCells VisualizingStep;
-			FLinearColor Color;
-			FName Symbol = TEXT("+");
-			FVector Position = FVector::ZeroVector;
-			switch (Index)
+			case 0:
 			{
-				case 0:
-				{
-					VisualizingStep = AllCrossways.Difference(SecureCrossways);
-					Color = FLinearColor::Red;
-					break;
-				}
-				case 1:
-				{
-					VisualizingStep = SecureCrossways;
-					Color = FLinearColor::Green;
-					break;
-				}
-				case 2:
-				{
-					VisualizingStep = Filtered;
-					Color = FLinearColor::Yellow;
-					Symbol = TEXT("F");
-					static const FVector DefaultPosition(-50.0F, -50.0F, 0.0F);
-					Position = DefaultPosition;
-					break;
-				}
-				default:
-					break;
+				VisualizingStep = Decision.AllCrossways;
+				VisualizingStep.Subtract(Decision.SecureCrossways);
+				Color = FLinearColor::Red;
+				break;
 			}
-			const FDisplayCellsParams DisplayParams{Color, 263.f, 124.f, Symbol, Position};
-			UCellsUtilsLibrary::DisplayCells(OwnerInternal, VisualizingStep, DisplayParams);
-		} // [Loopy visualization]
-	}
+			case 1:
+			{
+				VisualizingStep = Decision.SecureCrossways;
+				Color = FLinearColor::Green;
+				break;
+			}
+			case 2:
+			{
+				VisualizingStep = Decision.Filtered;
+				Color = FLinearColor::Yellow;
+				Symbol = TEXT("F");
+				static const FVector DefaultPosition(-50.0F, -50.0F, 0.0F);
+				Position = DefaultPosition;
+				break;
+			}
+			default:
+				break;
+		}
+
+		if (VisualizingStep.IsEmpty())
+		{
+			continue;
+		}
+
+		FCells VisualizingCells;
+		VisualizingStep.ForEachSetBit([&VisualizingCells, &GeneratedMap](int32 CellIndex) { VisualizingCells.Emplace(GeneratedMap.GetCellByIndex(CellIndex)); });
+
+		const FDisplayCellsParams DisplayParams{Color, 263.f, 124.f, Symbol, Position};
+		UCellsUtilsLibrary::DisplayCells(OwnerInternal, VisualizingCells, DisplayParams);
+	} // [Loopy visualization]
 #endif	// [Editor]
 }
 
+// Returns how often in seconds this bot has to be updated by its distance to the nearest threat and the game phase
+float AMyAIController::GetUpdateInterval() const
+{
+	const float DefaultInterval = UGameStateDataAsset::Get().GetTickInterval();
+	const UMapComponent* MapComponent = UMapComponent::GetMapComponent(OwnerInternal);
+	if (!MapComponent)
+	{
+		return DefaultInterval;
+	}
+
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(GetPawn());
+	const FAIWorldSnapshot& Snapshot = GeneratedMap.GetAIWorldSnapshot();
+	const UAIDataAsset& AIDataAsset = UAIDataAsset::Get();
+	const int32 CellIndex = GeneratedMap.GetCellIndex(MapComponent->GetCell());
+	const int32 IsolatedRadius = FMath::Max(AIDataAsset.GetIsolatedRadius(), AIDataAsset.GetNearThreatRadius());
+	const int32 ThreatDistance = Snapshot.GetThreatDistance(CellIndex, IsolatedRadius);
+
+	if (ThreatDistance != INDEX_NONE
+	    && ThreatDistance <= AIDataAsset.GetNearThreatRadius())
+	{
+		return FMath::Min(DefaultInterval, AIDataAsset.GetNearThreatTickInterval());
+	}
+
+	if (ThreatDistance == INDEX_NONE
+	    && Snapshot.PlayersNum > AIDataAsset.GetFinalPlayersNum())
+	{
+		// Is slowed down only while there are enough players, in the final phase every decision matters
+		return FMath::Max(DefaultInterval, AIDataAsset.GetIsolatedTickInterval());
+	}
+
+	return DefaultInterval;
+}
+
 // Enable or disable AI for this bot
 void AMyAIController::SetAI(bool bShouldEnable)
 {
@@ -430,15 +686,20 @@ void AMyAIController::SetAI(bool bShouldEnable)
 
 	SetIgnoreMoveInput(!bShouldEnable);
 
-	// Handle the Ai updating timer
-	FTimerManager& TimerManager = GetWorldTimerManager();
+	// Handle the AI updating by the scheduler
+	UAISchedulerSubsystem* AISchedulerSubsystem = UAISchedulerSubsystem::GetAISchedulerSubsystem(this);
+	if (!AISchedulerSubsystem)
+	{
+		return;
+	}
+
 	if (bShouldEnable)
 	{
-		TimerManager.UnPauseTimer(AIUpdateHandleInternal);
+		AISchedulerSubsystem->RegisterBot(this);
 	}
 	else
 	{
-		TimerManager.PauseTimer(AIUpdateHandleInternal);
+		AISchedulerSubsystem->UnregisterBot(this);
 	}
 }
 
@@ -12,12 +12,14 @@
 #include "GameFramework/MyGameStateBase.h"
 #include "GameFramework/MyPlayerState.h"
 #include "MyUtilsLibraries/InputUtilsLibrary.h"
+#include "Subsystems/GridSpectatorSubsystem.h"
 #include "UI/InGameMenuWidget.h"
 #include "UI/MyHUD.h"
 #include "UI/SettingsWidget.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 ///---
 #include "EnhancedInputComponent.h"
+#include "EnhancedInputSubsystems.h"
 #include "Components/GameFrameworkComponentManager.h"
 #include "Framework/Application/NavigationConfig.h"
 #include "Framework/Application/SlateApplication.h"
@@ -50,6 +52,33 @@ void AMyPlayerController::ServerSetGameState_Implementation(ECurrentGameState Ne
 	}
 }
 
+// Is called on the spectator client to rebuild the grid from the layout of the server
+void AMyPlayerController::ClientReceiveSpectatorLayout_Implementation(const FGridSpectatorLayout& Layout)
+{
+	if (UGridSpectatorSubsystem* GridSpectatorSubsystem = UGridSpectatorSubsystem::GetGridSpectatorSubsystem(this))
+	{
+		GridSpectatorSubsystem->ApplyLayout(Layout);
+	}
+}
+
+// Is called on the spectator client for grid events of each simulation step in their order
+void AMyPlayerController::ClientReceiveSpectatorEvents_Implementation(const FGridSpectatorEvents& Events)
+{
+	if (UGridSpectatorSubsystem* GridSpectatorSubsystem = UGridSpectatorSubsystem::GetGridSpectatorSubsystem(this))
+	{
+		GridSpectatorSubsystem->ApplyEvents(Events);
+	}
+}
+
+// Is called on the spectator client at reduced frequency with positions of players
+void AMyPlayerController::ClientReceiveSpectatorPlayers_Implementation(const FGridSpectatorPlayers& Players)
+{
+	if (UGridSpectatorSubsystem* GridSpectatorSubsystem = UGridSpectatorSubsystem::GetGridSpectatorSubsystem(this))
+	{
+		GridSpectatorSubsystem->ApplyPlayers(Players);
+	}
+}
+
 // Sets the GameStarting game state
 void AMyPlayerController::SetGameStartingState()
 {
@@ -126,6 +155,8 @@ void AMyPlayerController::AddNewInputContexts(const TArray<const UMyInputMapping
 			AllInputContextsInternal.AddUnique(InputContextIt);
 		}
 	}
+
+	InputContextsByStateInternal.Reset();
 }
 
 // Returns true if Player Controller is ready to setup all the inputs
@@ -186,7 +217,7 @@ void AMyPlayerController::BeginPlay()
 	// Listen to handle input for each game state
 	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
-		MyGameState->OnGameStateChanged.AddDynamic(this, &ThisClass::OnGameStateChanged);
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 		// Handle current game state if initialized with delay
 		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -293,14 +324,19 @@ void AMyPlayerController::RemoveInputContexts(const TArray<const UMyInputMapping
 		return;
 	}
 	
+	TArray<const UMyInputMappingContext*> ToDisable;
+	ToDisable.Reserve(InputContexts.Num());
 	for (const UMyInputMappingContext* InputContextIt : InputContexts)
 	{
 		if (InputContextIt)
 		{
 			AllInputContextsInternal.RemoveSwap(InputContextIt);
-			SetInputContextEnabled(false, InputContextIt);
+			ToDisable.Emplace(InputContextIt);
 		}
 	}
+
+	InputContextsByStateInternal.Reset();
+	ApplyInputContexts({}, ToDisable);
 }
 
 // Prevents built-in slate input on UMG
@@ -370,10 +406,14 @@ void AMyPlayerController::OnToggledInGameMenu_Implementation(bool bIsVisible)
 	}
 
 	// Invert gameplay input contexts
-	SetAllInputContextsEnabled(!bIsVisible, ECurrentGameState::InGame);
+	TArray<const UMyInputMappingContext*> ToEnable;
+	TArray<const UMyInputMappingContext*> ToDisable;
+	GatherInputContextsByState(!bIsVisible, ECurrentGameState::InGame, /*bInvertRest*/false, ToEnable, ToDisable);
 
 	// Turn on or off specific In-Game menu input context (it does not contain any game state)
-	SetInputContextEnabled(bIsVisible, UPlayerInputDataAsset::Get().GetInGameMenuInputContext());
+	(bIsVisible ? ToEnable : ToDisable).Emplace(UPlayerInputDataAsset::Get().GetInGameMenuInputContext());
+
+	ApplyInputContexts(ToEnable, ToDisable);
 
 	checkf(MouseComponentInternal, TEXT("ERROR: [%i] %s:\n'MouseComponentInternal' is null!"), __LINE__, *FString(__FUNCTION__));
 	MouseComponentInternal->SetMouseVisibility(bIsVisible);
@@ -382,59 +422,143 @@ void AMyPlayerController::OnToggledInGameMenu_Implementation(bool bIsVisible)
 // Listens to handle input on opening and closing the Settings widget
 void AMyPlayerController::OnToggledSettings_Implementation(bool bIsVisible)
 {
+	TArray<const UMyInputMappingContext*> ToEnable;
+	TArray<const UMyInputMappingContext*> ToDisable;
+
 	const ECurrentGameState CurrentGameState = AMyGameStateBase::GetCurrentGameState();
 	if (CurrentGameState == ECGS::Menu)
 	{
 		// Toggle all previous Input Contexts
-		SetAllInputContextsEnabled(!bIsVisible, CurrentGameState);
+		GatherInputContextsByState(!bIsVisible, CurrentGameState, /*bInvertRest*/false, ToEnable, ToDisable);
 	}
 	else if (CurrentGameState == ECGS::InGame)
 	{
 		// Toggle In-Game Menu Input Context
-		SetInputContextEnabled(!bIsVisible, UPlayerInputDataAsset::Get().GetInGameMenuInputContext());
+		(bIsVisible ? ToDisable : ToEnable).Emplace(UPlayerInputDataAsset::Get().GetInGameMenuInputContext());
 	}
 
 	// Turn on or off specific Settings input context (it does not contain any game state)
-	SetInputContextEnabled(bIsVisible, UPlayerInputDataAsset::Get().GetSettingsInputContext());
+	(bIsVisible ? ToEnable : ToDisable).Emplace(UPlayerInputDataAsset::Get().GetSettingsInputContext());
+
+	ApplyInputContexts(ToEnable, ToDisable);
 }
 
 // Takes all cached inputs contexts and turns them on or off according given game state
 void AMyPlayerController::SetAllInputContextsEnabled(bool bEnable, ECurrentGameState CurrentGameState, bool bInvertRest/* = false*/)
 {
+	TArray<const UMyInputMappingContext*> ToEnable;
+	TArray<const UMyInputMappingContext*> ToDisable;
+	GatherInputContextsByState(bEnable, CurrentGameState, bInvertRest, ToEnable, ToDisable);
+	ApplyInputContexts(ToEnable, ToDisable);
+}
+
+// Enables or disables specified input context
+void AMyPlayerController::SetInputContextEnabled(bool bEnable, const UMyInputMappingContext* InInputContext)
+{
+	if (!ensureMsgf(InInputContext, TEXT("ASSERT: [%i] %s:\n'InInputContext' is not valid!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	ApplyInputContexts(bEnable ? TArray<const UMyInputMappingContext*>{InInputContext} : TArray<const UMyInputMappingContext*>{},
+	                   bEnable ? TArray<const UMyInputMappingContext*>{} : TArray<const UMyInputMappingContext*>{InInputContext});
+}
+
+// Returns contexts of AllInputContextsInternal that are chosen for given game state, is cached per state
+const TArray<const UMyInputMappingContext*>& AMyPlayerController::GetInputContextsByState(ECurrentGameState GameState)
+{
+	if (const TArray<const UMyInputMappingContext*>* FoundContexts = InputContextsByStateInternal.Find(GameState))
+	{
+		return *FoundContexts;
+	}
+
+	TArray<const UMyInputMappingContext*>& NewContexts = InputContextsByStateInternal.Add(GameState);
 	for (const UMyInputMappingContext* InputContextIt : AllInputContextsInternal)
 	{
-		if (!InputContextIt)
+		if (InputContextIt
+		    && InputContextIt->GetChosenGameStatesBitmask() & TO_FLAG(GameState))
 		{
-			continue;
+			NewContexts.Emplace(InputContextIt);
 		}
+	}
+	return NewContexts;
+}
 
-		const int32 GameStatesBitmask = InputContextIt->GetChosenGameStatesBitmask();
-		const bool bIsForCurrentState = GameStatesBitmask & TO_FLAG(CurrentGameState);
-		if (!bIsForCurrentState && !bInvertRest)
+// Collects contexts to turn on or off according given game state without applying them
+void AMyPlayerController::GatherInputContextsByState(bool bEnable, ECurrentGameState CurrentGameState, bool bInvertRest, TArray<const UMyInputMappingContext*>& InOutToEnable, TArray<const UMyInputMappingContext*>& InOutToDisable)
+{
+	const TArray<const UMyInputMappingContext*>& StateContexts = GetInputContextsByState(CurrentGameState);
+	(bEnable ? InOutToEnable : InOutToDisable).Append(StateContexts);
+
+	if (!bInvertRest)
+	{
+		return;
+	}
+
+	TArray<const UMyInputMappingContext*>& RestContexts = bEnable ? InOutToDisable : InOutToEnable;
+	for (const UMyInputMappingContext* InputContextIt : AllInputContextsInternal)
+	{
+		if (InputContextIt
+		    && !StateContexts.Contains(InputContextIt))
 		{
-			continue;
+			RestContexts.Emplace(InputContextIt);
 		}
-
-		const bool bFinalEnable = bIsForCurrentState ? bEnable : !bEnable;
-		SetInputContextEnabled(bFinalEnable, InputContextIt);
 	}
 }
 
-// Enables or disables specified input context
-void AMyPlayerController::SetInputContextEnabled(bool bEnable, const UMyInputMappingContext* InInputContext)
+// Applies all changes of input contexts as one diff: contexts that are already in required state are skipped, and mappings are rebuilt only once
+void AMyPlayerController::ApplyInputContexts(const TArray<const UMyInputMappingContext*>& ToEnable, const TArray<const UMyInputMappingContext*>& ToDisable)
 {
-	if (!ensureMsgf(InInputContext, TEXT("ASSERT: [%i] %s:\n'InInputContext' is not valid!"), __LINE__, *FString(__FUNCTION__)))
+	UEnhancedInputLocalPlayerSubsystem* InputSubsystem = UInputUtilsLibrary::GetEnhancedInputSubsystem(this);
+	if (!InputSubsystem)
 	{
+		// Can be null on remote clients, do nothing
 		return;
 	}
 
-	if (bEnable)
+	// Each change only requests the rebuild, so all of them are applied by the single one below
+	FModifyContextOptions RemoveOptions;
+	RemoveOptions.bIgnoreAllPressedKeysUntilRelease = false;
+	RemoveOptions.bForceImmediately = false;
+	RemoveOptions.bNotifyUserSettings = true;
+	FModifyContextOptions AddOptions;
+	AddOptions.bForceImmediately = false;
+
+	bool bAnyChanged = false;
+	for (const UMyInputMappingContext* InputContextIt : ToDisable)
+	{
+		if (InputContextIt
+		    && !ToEnable.Contains(InputContextIt) // is enabled by another reason
+		    && InputSubsystem->HasMappingContext(InputContextIt))
+		{
+			InputSubsystem->RemoveMappingContext(InputContextIt, RemoveOptions);
+			bAnyChanged = true;
+		}
+	}
+
+	for (const UMyInputMappingContext* InputContextIt : ToEnable)
 	{
+		if (!InputContextIt)
+		{
+			continue;
+		}
+
 		// Make sure all the input actions are bound
-		BindInputActionsInContext(InInputContext);
+		BindInputActionsInContext(InputContextIt);
+
+		if (!InputSubsystem->HasMappingContext(InputContextIt))
+		{
+			InputSubsystem->AddMappingContext(InputContextIt, InputContextIt->GetContextPriority(), AddOptions);
+			bAnyChanged = true;
+		}
 	}
 
-	UInputUtilsLibrary::SetInputContextEnabled(this, bEnable, InInputContext, InInputContext->GetContextPriority());
+	if (bAnyChanged)
+	{
+		FModifyContextOptions RebuildOptions;
+		RebuildOptions.bForceImmediately = true;
+		InputSubsystem->RequestRebuildControlMappings(RebuildOptions);
+	}
 }
 
 // Is called when all game widgets are initialized
@@ -454,8 +578,27 @@ void AMyPlayerController::OnWidgetsInitialized_Implementation()
 		InGameMenuWidget->OnToggledInGameMenu.AddUniqueDynamic(this, &ThisClass::OnToggledInGameMenu);
 	}
 
-	// Listens to handle input on opening and closing the Settings widget
-	USettingsWidget* SettingsWidget = UMyBlueprintFunctionLibrary::GetSettingsWidget();
+	// Listens to handle input on opening and closing the Settings widget, it is created on demand
+	if (USettingsWidget* SettingsWidget = HUD ? HUD->GetSettingsWidget() : nullptr)
+	{
+		OnSettingsWidgetCreated(SettingsWidget);
+	}
+	else if (HUD)
+	{
+		HUD->OnSettingsWidgetCreated.AddUniqueDynamic(this, &ThisClass::OnSettingsWidgetCreated);
+	}
+}
+
+// Is called when the Settings widget is created on demand
+void AMyPlayerController::OnSettingsWidgetCreated_Implementation(USettingsWidget* SettingsWidget)
+{
+	AMyHUD* HUD = GetHUD<AMyHUD>();
+	if (HUD
+	    && HUD->OnSettingsWidgetCreated.IsAlreadyBound(this, &ThisClass::OnSettingsWidgetCreated))
+	{
+		HUD->OnSettingsWidgetCreated.RemoveDynamic(this, &ThisClass::OnSettingsWidgetCreated);
+	}
+
 	if (ensureMsgf(SettingsWidget, TEXT("ASSERT: 'SettingsWidget' is not valid")))
 	{
 		SettingsWidget->OnToggledSettings.AddUniqueDynamic(this, &ThisClass::OnToggledSettings);
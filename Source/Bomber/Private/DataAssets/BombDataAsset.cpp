@@ -3,9 +3,14 @@
 #include "DataAssets/BombDataAsset.h"
 //---
 #include "DataAssets/DataAssetsContainer.h"
+#include "Engine/CosmeticCookScope.h"
+#include "GameFramework/MyGameUserSettings.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(BombDataAsset)
 
+// The default tier that is used when no tier is set
+const FExplosionVFXTier FExplosionVFXTier::Default = FExplosionVFXTier();
+
 // Default constructor
 UBombDataAsset::UBombDataAsset()
 {
@@ -17,3 +22,27 @@ const UBombDataAsset& UBombDataAsset::Get()
 {
 	return UDataAssetsContainer::GetLevelActorDataAssetChecked<ThisClass>();
 }
+
+// Returns the explosion tier of the current overall scalability level of game settings
+const FExplosionVFXTier& UBombDataAsset::GetExplosionVFXTier() const
+{
+	if (ExplosionVFXTiersInternal.IsEmpty())
+	{
+		return FExplosionVFXTier::Default;
+	}
+
+	// Overall level starts from 1 for Low, while 0 is Custom
+	const int32 ScalabilityLevel = UMyGameUserSettings::Get().GetOverallScalabilityLevel();
+	const int32 LastIndex = ExplosionVFXTiersInternal.Num() - 1;
+	const int32 TierIndex = ScalabilityLevel > 0 ? FMath::Min(ScalabilityLevel - 1, LastIndex) : LastIndex;
+	return ExplosionVFXTiersInternal[TierIndex];
+}
+
+// Strips cosmetic references when is cooked for the dedicated server
+void UBombDataAsset::Serialize(FArchive& Ar)
+{
+	// Only the color index of the bomb is replicated, so materials are resolved by clients themselves
+	const FCosmeticCookScope CosmeticCookScope(Ar, *this);
+
+	Super::Serialize(Ar);
+}
@@ -10,6 +10,7 @@
 UBoxDataAsset::UBoxDataAsset()
 {
 	ActorTypeInternal = EAT::Box;
+	NetPolicyInternal.NetDormancy = DORM_DormantAll;
 }
 
 // Returns the box data asset
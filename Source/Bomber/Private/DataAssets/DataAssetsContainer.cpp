@@ -10,15 +10,33 @@
 #include "DataAssets/PlayerInputDataAsset.h"
 #include "DataAssets/SoundsDataAsset.h"
 #include "DataAssets/UIDataAsset.h"
+#include "Engine/StartupTimings.h"
 //---
 #include "GameFramework/Actor.h"
 //---
+#if WITH_EDITOR
+#include "MyUnrealEdEngine.h"
+#endif
+//---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(DataAssetsContainer)
 
+// Returns the loaded data asset, measures the time only if it has to be loaded synchronously
+template <typename T>
+static T* LoadDataAssetSynchronous(const TSoftObjectPtr<T>& DataAsset)
+{
+	if (T* LoadedDataAsset = DataAsset.Get())
+	{
+		return LoadedDataAsset;
+	}
+
+	STARTUP_TIMING_SCOPE(DataAssetsSyncLoad);
+	return DataAsset.LoadSynchronous();
+}
+
 // Returns the Levels Data Asset
 const UGeneratedMapDataAsset* UDataAssetsContainer::GetGeneratedMapDataAsset()
 {
-	const UGeneratedMapDataAsset* LevelsDataAsset = Get().GeneratedMapDataAssetInternal.LoadSynchronous();
+	const UGeneratedMapDataAsset* LevelsDataAsset = LoadDataAssetSynchronous(Get().GeneratedMapDataAssetInternal);
 	checkf(LevelsDataAsset, TEXT("%s: 'LevelsDataAsset' is not loaded"), *FString(__FUNCTION__));
 	return LevelsDataAsset;
 }
@@ -26,7 +44,7 @@ const UGeneratedMapDataAsset* UDataAssetsContainer::GetGeneratedMapDataAsset()
 // Returns the UI Data Asset
 const UUIDataAsset* UDataAssetsContainer::GetUIDataAsset()
 {
-	const UUIDataAsset* UIDataAsset = Get().UIDataAssetInternal.LoadSynchronous();
+	const UUIDataAsset* UIDataAsset = LoadDataAssetSynchronous(Get().UIDataAssetInternal);
 	checkf(UIDataAsset, TEXT("%s: 'UIDataAsset' is not loaded"), *FString(__FUNCTION__));
 	return UIDataAsset;
 }
@@ -34,7 +52,7 @@ const UUIDataAsset* UDataAssetsContainer::GetUIDataAsset()
 // Returns the AI Data Asset
 const UAIDataAsset* UDataAssetsContainer::GetAIDataAsset()
 {
-	const UAIDataAsset* AIDataAsset = Get().AIDataAssetInternal.LoadSynchronous();
+	const UAIDataAsset* AIDataAsset = LoadDataAssetSynchronous(Get().AIDataAssetInternal);
 	checkf(AIDataAsset, TEXT("%s: 'AIDataAsset' is not loaded"), *FString(__FUNCTION__));
 	return AIDataAsset;
 }
@@ -42,7 +60,7 @@ const UAIDataAsset* UDataAssetsContainer::GetAIDataAsset()
 // Returns the Player Input Data Asset
 const UPlayerInputDataAsset* UDataAssetsContainer::GetPlayerInputDataAsset()
 {
-	const UPlayerInputDataAsset* PlayerInputDataAsset = Get().PlayerInputDataAssetInternal.LoadSynchronous();
+	const UPlayerInputDataAsset* PlayerInputDataAsset = LoadDataAssetSynchronous(Get().PlayerInputDataAssetInternal);
 	checkf(PlayerInputDataAsset, TEXT("%s: 'PlayerInputDataAsset' is not loaded"), *FString(__FUNCTION__));
 	return PlayerInputDataAsset;
 }
@@ -50,7 +68,7 @@ const UPlayerInputDataAsset* UDataAssetsContainer::GetPlayerInputDataAsset()
 // Returns the Sounds Data Asset
 const USoundsDataAsset* UDataAssetsContainer::GetSoundsDataAsset()
 {
-	const USoundsDataAsset* SoundsDataAsset = Get().SoundsDataAssetInternal.LoadSynchronous();
+	const USoundsDataAsset* SoundsDataAsset = LoadDataAssetSynchronous(Get().SoundsDataAssetInternal);
 	checkf(SoundsDataAsset, TEXT("%s: 'SoundsDataAsset' is not loaded"), *FString(__FUNCTION__));
 	return SoundsDataAsset;
 }
@@ -58,11 +76,42 @@ const USoundsDataAsset* UDataAssetsContainer::GetSoundsDataAsset()
 // Returns the Game State Data Asset
 const UGameStateDataAsset* UDataAssetsContainer::GetGameStateDataAsset()
 {
-	const UGameStateDataAsset* GameStateDataAsset = Get().GameStateDataAssetInternal.LoadSynchronous();
+	const UGameStateDataAsset* GameStateDataAsset = LoadDataAssetSynchronous(Get().GameStateDataAssetInternal);
 	checkf(GameStateDataAsset, TEXT("%s: 'GameStateDataAsset' is not loaded"), *FString(__FUNCTION__));
 	return GameStateDataAsset;
 }
 
+// Returns paths of all data assets of this container, is used to preload them asynchronously
+void UDataAssetsContainer::GetAllDataAssetPaths(TArray<FSoftObjectPath>& OutDataAssetPaths)
+{
+	const UDataAssetsContainer& Container = Get();
+	const TArray<FSoftObjectPath> CoreDataAssetPaths = {
+		Container.GeneratedMapDataAssetInternal.ToSoftObjectPath(),
+		Container.UIDataAssetInternal.ToSoftObjectPath(),
+		Container.AIDataAssetInternal.ToSoftObjectPath(),
+		Container.PlayerInputDataAssetInternal.ToSoftObjectPath(),
+		Container.SoundsDataAssetInternal.ToSoftObjectPath(),
+		Container.GameStateDataAssetInternal.ToSoftObjectPath()
+	};
+
+	OutDataAssetPaths.Reserve(OutDataAssetPaths.Num() + CoreDataAssetPaths.Num() + Container.ActorsDataAssetsInternal.Num());
+	for (const FSoftObjectPath& PathIt : CoreDataAssetPaths)
+	{
+		if (PathIt.IsValid())
+		{
+			OutDataAssetPaths.AddUnique(PathIt);
+		}
+	}
+
+	for (const TSoftObjectPtr<ULevelActorDataAsset>& DataAssetSoftIt : Container.ActorsDataAssetsInternal)
+	{
+		if (!DataAssetSoftIt.IsNull())
+		{
+			OutDataAssetPaths.AddUnique(DataAssetSoftIt.ToSoftObjectPath());
+		}
+	}
+}
+
 // Best suits for blueprints to get the data asset by its class since converts the result to the specified class
 const ULevelActorDataAsset* UDataAssetsContainer::GetLevelActorDataAsset(TSubclassOf<ULevelActorDataAsset> DataAssetClass)
 {
@@ -71,18 +120,29 @@ const ULevelActorDataAsset* UDataAssetsContainer::GetLevelActorDataAsset(TSubcla
 		return nullptr;
 	}
 
-	const TArray<TSoftObjectPtr<ULevelActorDataAsset>>& ActorsDataAssets = Get().ActorsDataAssetsInternal;
-	for (const TSoftObjectPtr<ULevelActorDataAsset>& DataAssetSoftIt : ActorsDataAssets)
+	const UDataAssetsContainer& Container = Get();
+	Container.ResolveActorsDataAssets();
+
+	const TWeakObjectPtr<ULevelActorDataAsset>* CachedDataAsset = Container.DataAssetsByDataAssetClassInternal.Find(DataAssetClass.Get());
+	if (CachedDataAsset
+	    && (CachedDataAsset->IsExplicitlyNull() || CachedDataAsset->IsValid()))
 	{
-		const ULevelActorDataAsset* DataAssetIt = DataAssetSoftIt.LoadSynchronous();
-		checkf(DataAssetIt, TEXT("%s: 'DataAssetIt' is not loaded"), *FString(__FUNCTION__));
-		if (DataAssetIt->IsA(DataAssetClass))
+		return CachedDataAsset->Get();
+	}
+
+	ULevelActorDataAsset* FoundDataAsset = nullptr;
+	for (const TWeakObjectPtr<ULevelActorDataAsset>& DataAssetIt : Container.ResolvedActorsDataAssetsInternal)
+	{
+		if (DataAssetIt.IsValid()
+		    && DataAssetIt->IsA(DataAssetClass))
 		{
-			return DataAssetIt;
+			FoundDataAsset = DataAssetIt.Get();
+			break;
 		}
 	}
 
-	return nullptr;
+	Container.DataAssetsByDataAssetClassInternal.Emplace(DataAssetClass.Get(), FoundDataAsset);
+	return FoundDataAsset;
 }
 
 // Iterate ActorsDataAssets array and returns the found Level Actor class by specified data asset
@@ -93,35 +153,44 @@ const ULevelActorDataAsset* UDataAssetsContainer::GetDataAssetByActorClass(const
 		return nullptr;
 	}
 
-	const TArray<TSoftObjectPtr<ULevelActorDataAsset>>& ActorsDataAssets = Get().ActorsDataAssetsInternal;
-	for (const TSoftObjectPtr<ULevelActorDataAsset>& DataAssetSoftIt : ActorsDataAssets)
+	const UDataAssetsContainer& Container = Get();
+	Container.ResolveActorsDataAssets();
+
+	const TWeakObjectPtr<ULevelActorDataAsset>* CachedDataAsset = Container.DataAssetsByActorClassInternal.Find(ActorClass.Get());
+	if (CachedDataAsset
+	    && (CachedDataAsset->IsExplicitlyNull() || CachedDataAsset->IsValid()))
 	{
-		const ULevelActorDataAsset* DataAssetIt = DataAssetSoftIt.LoadSynchronous();
-		checkf(DataAssetIt, TEXT("%s: 'DataAssetIt' is not loaded"), *FString(__FUNCTION__));
+		return CachedDataAsset->Get();
+	}
 
-		const UClass* ActorClassIt = DataAssetIt ? DataAssetIt->GetActorClass() : nullptr;
+	ULevelActorDataAsset* FoundDataAsset = nullptr;
+	for (const TWeakObjectPtr<ULevelActorDataAsset>& DataAssetIt : Container.ResolvedActorsDataAssetsInternal)
+	{
+		const UClass* ActorClassIt = DataAssetIt.IsValid() ? DataAssetIt->GetActorClass() : nullptr;
 		if (ActorClassIt
 		    && ActorClassIt->IsChildOf(ActorClass))
 		{
-			return DataAssetIt;
+			FoundDataAsset = DataAssetIt.Get();
+			break;
 		}
 	}
-	return nullptr;
+
+	Container.DataAssetsByActorClassInternal.Emplace(ActorClass.Get(), FoundDataAsset);
+	return FoundDataAsset;
 }
 
 // Iterate ActorsDataAssets array and returns the found Data Assets of level actors by specified types.
 void UDataAssetsContainer::GetDataAssetsByActorTypes(TArray<ULevelActorDataAsset*>& OutDataAssets, int32 ActorsTypesBitmask)
 {
-	const TArray<TSoftObjectPtr<ULevelActorDataAsset>>& ActorsDataAssets = Get().ActorsDataAssetsInternal;
-	for (const TSoftObjectPtr<ULevelActorDataAsset>& DataAssetSoftIt : ActorsDataAssets)
-	{
-		ULevelActorDataAsset* DataAssetIt = DataAssetSoftIt.LoadSynchronous();
-		checkf(DataAssetIt, TEXT("%s: 'DataAssetIt' is not loaded"), *FString(__FUNCTION__));
+	const UDataAssetsContainer& Container = Get();
+	Container.ResolveActorsDataAssets();
 
-		if (DataAssetIt
+	for (const TWeakObjectPtr<ULevelActorDataAsset>& DataAssetIt : Container.ResolvedActorsDataAssetsInternal)
+	{
+		if (DataAssetIt.IsValid()
 		    && (ActorsTypesBitmask & TO_FLAG(DataAssetIt->GetActorType())) != 0)
 		{
-			OutDataAssets.Emplace(DataAssetIt);
+			OutDataAssets.Emplace(DataAssetIt.Get());
 		}
 	}
 }
@@ -129,9 +198,21 @@ void UDataAssetsContainer::GetDataAssetsByActorTypes(TArray<ULevelActorDataAsset
 // Iterate ActorsDataAssets array and return the first found Data Assets of level actors by specified type
 const ULevelActorDataAsset* UDataAssetsContainer::GetDataAssetByActorType(EActorType ActorType)
 {
-	TArray<ULevelActorDataAsset*> FoundDataAssets;
-	GetDataAssetsByActorTypes(FoundDataAssets, TO_FLAG(ActorType));
-	return FoundDataAssets.IsValidIndex(0) ? FoundDataAssets[0] : nullptr;
+	const int32 TypeBitmask = TO_FLAG(ActorType);
+	if (!TypeBitmask
+	    || !FMath::IsPowerOfTwo(TypeBitmask))
+	{
+		// Is not a single type, find the first matching one in the array order
+		TArray<ULevelActorDataAsset*> FoundDataAssets;
+		GetDataAssetsByActorTypes(FoundDataAssets, TypeBitmask);
+		return FoundDataAssets.IsValidIndex(0) ? FoundDataAssets[0] : nullptr;
+	}
+
+	const UDataAssetsContainer& Container = Get();
+	Container.ResolveActorsDataAssets();
+
+	const int32 TypeBitIndex = FMath::FloorLog2(TypeBitmask);
+	return Container.DataAssetsByTypeBitInternal.IsValidIndex(TypeBitIndex) ? Container.DataAssetsByTypeBitInternal[TypeBitIndex].Get() : nullptr;
 }
 
 // Iterate ActorsDataAssets array and returns the found actor class by specified actor type
@@ -140,3 +221,65 @@ UClass* UDataAssetsContainer::GetActorClassByType(EActorType ActorType)
 	const ULevelActorDataAsset* FoundDataAsset = GetDataAssetByActorType(ActorType);
 	return FoundDataAsset ? FoundDataAsset->GetActorClass() : nullptr;
 }
+
+// Forgets resolved lookup tables of level actor data assets, so they are built again on next request
+void UDataAssetsContainer::ResetResolvedDataAssets()
+{
+	const UDataAssetsContainer& Container = Get();
+	Container.ResolvedActorsDataAssetsInternal.Empty();
+	Container.DataAssetsByTypeBitInternal.Empty();
+	Container.DataAssetsByActorClassInternal.Empty();
+	Container.DataAssetsByDataAssetClassInternal.Empty();
+	Container.bActorsDataAssetsResolvedInternal = false;
+}
+
+// Loads all level actor data assets once and builds lookup tables by their actor types
+void UDataAssetsContainer::ResolveActorsDataAssets() const
+{
+	if (bActorsDataAssetsResolvedInternal)
+	{
+		return;
+	}
+
+	ResetResolvedDataAssets();
+	bActorsDataAssetsResolvedInternal = true;
+
+#if WITH_EDITOR
+	static FDelegateHandle OnAnyDataAssetChangedHandle;
+	if (!OnAnyDataAssetChangedHandle.IsValid())
+	{
+		OnAnyDataAssetChangedHandle = UMyUnrealEdEngine::GOnAnyDataAssetChanged.AddLambda([](const UObject* ChangedDataAsset) { ResetResolvedDataAssets(); });
+	}
+#endif //WITH_EDITOR
+
+	constexpr int32 TypeBitsNum = 8 * sizeof(EActorType);
+	DataAssetsByTypeBitInternal.SetNum(TypeBitsNum);
+	ResolvedActorsDataAssetsInternal.Reserve(ActorsDataAssetsInternal.Num());
+	for (const TSoftObjectPtr<ULevelActorDataAsset>& DataAssetSoftIt : ActorsDataAssetsInternal)
+	{
+		ULevelActorDataAsset* DataAssetIt = LoadDataAssetSynchronous(DataAssetSoftIt);
+		checkf(DataAssetIt, TEXT("%s: 'DataAssetIt' is not loaded"), *FString(__FUNCTION__));
+		ResolvedActorsDataAssetsInternal.Emplace(DataAssetIt);
+
+		const int32 TypeBitmask = TO_FLAG(DataAssetIt->GetActorType());
+		for (int32 BitIndex = 0; BitIndex < TypeBitsNum; ++BitIndex)
+		{
+			// The first data asset of the type wins same as it was found by iterating the array
+			if ((TypeBitmask & (1 << BitIndex)) != 0
+			    && !DataAssetsByTypeBitInternal[BitIndex].IsValid())
+			{
+				DataAssetsByTypeBitInternal[BitIndex] = DataAssetIt;
+			}
+		}
+	}
+}
+
+#if WITH_EDITOR
+// Is called when any property of this container is changed in editor
+void UDataAssetsContainer::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	ResetResolvedDataAssets();
+}
+#endif //WITH_EDITOR
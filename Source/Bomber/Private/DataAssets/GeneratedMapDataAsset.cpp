@@ -4,6 +4,8 @@
 //---
 #include "DataAssets/DataAssetsContainer.h"
 //---
+#include "GenericPlatform/GenericPlatformChunkInstall.h"
+//---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GeneratedMapDataAsset)
 
 // Returns the generated map data asset
@@ -13,3 +15,86 @@ const UGeneratedMapDataAsset& UGeneratedMapDataAsset::Get()
 	checkf(GeneratedMapDataAsset, TEXT("The Generated Map Data Asset is not valid"))
 	return *GeneratedMapDataAsset;
 }
+
+// Returns the pak chunk of given level type, is none if the level type is cooked into the base chunk
+int32 UGeneratedMapDataAsset::GetLevelTypeChunkId(ELevelType LevelType) const
+{
+	const FLevelStreamRow* FoundRow = LevelsInternal.FindByPredicate([LevelType](const FLevelStreamRow& RowIt) { return RowIt.LevelType == LevelType; });
+	return FoundRow ? FoundRow->ChunkId : INDEX_NONE;
+}
+
+// Returns true if the pak chunk of given level type is installed, so the level type can be loaded
+bool UGeneratedMapDataAsset::IsLevelTypeInstalled(ELevelType LevelType) const
+{
+	const int32 ChunkId = GetLevelTypeChunkId(LevelType);
+	const IPlatformChunkInstall* ChunkInstall = ChunkId > 0 ? FPlatformMisc::GetPlatformChunkInstall() : nullptr;
+	return !ChunkInstall
+	       || ChunkInstall->GetPakchunkLocation(ChunkId) != EChunkLocation::NotAvailable;
+}
+
+// Requests the platform to install the pak chunk of given level type in background with high priority if it's not installed yet
+void UGeneratedMapDataAsset::RequestLevelTypeInstall(ELevelType LevelType) const
+{
+	const int32 ChunkId = GetLevelTypeChunkId(LevelType);
+	IPlatformChunkInstall* ChunkInstall = ChunkId > 0 ? FPlatformMisc::GetPlatformChunkInstall() : nullptr;
+	if (ChunkInstall
+	    && ChunkInstall->GetPakchunkLocation(ChunkId) == EChunkLocation::NotAvailable)
+	{
+		ChunkInstall->PrioritizePakchunk(ChunkId, EChunkPriority::High);
+	}
+}
+
+// Returns the estimated cost of regenerating the level of given size by current chances and the cost model
+FLevelSizeCost UGeneratedMapDataAsset::EstimateLevelSizeCost(const FIntPoint& LevelSize) const
+{
+	const FLevelSizeCostModel& Model = LevelSizeCostModelInternal;
+	const int32 CellsNum = FMath::Max(0, LevelSize.X) * FMath::Max(0, LevelSize.Y);
+
+	// Walls are rolled first, boxes take the chance on the rest of cells
+	const float WallsFill = WallsChanceInternal / 100.f;
+	const float BoxesFill = (1.f - WallsFill) * BoxesChanceInternal / 100.f;
+
+	const float Attempts = GenerationModeInternal == ELevelGenerationMode::Constructive ? 1.f : Model.ExpectedGenerationAttempts;
+	const float GenerationMs = CellsNum * Model.GenerationMsPerCell * Attempts;
+
+	FLevelSizeCost Cost;
+	Cost.ActorsNum = FMath::CeilToInt32(CellsNum * (WallsFill + BoxesFill));
+	Cost.SpawnMs = Cost.ActorsNum * Model.SpawnMsPerActor;
+	Cost.FrameMs = GenerationMs + (SpawnBudgetMsInternal > 0.f ? FMath::Min(SpawnBudgetMsInternal, Cost.SpawnMs) : Cost.SpawnMs);
+	Cost.ReplicatedBytes = static_cast<int64>(Cost.ActorsNum) * Model.ReplicatedBytesPerActor;
+	return Cost;
+}
+
+// Returns true if the level of given size could be regenerated within the frame budget and the replication limit
+bool UGeneratedMapDataAsset::IsLevelSizeAffordable(const FIntPoint& LevelSize) const
+{
+	const FLevelSizeCostModel& Model = LevelSizeCostModelInternal;
+	if (LevelSize.X > Model.MaxLevelSize.X
+	    || LevelSize.Y > Model.MaxLevelSize.Y)
+	{
+		return false;
+	}
+
+	const FLevelSizeCost Cost = EstimateLevelSizeCost(LevelSize);
+	return (Model.FrameBudgetMs <= 0.f || Cost.FrameMs <= Model.FrameBudgetMs)
+	       && (Model.MaxReplicatedBytes <= 0 || Cost.ReplicatedBytes <= Model.MaxReplicatedBytes);
+}
+
+// Returns given size shrunk to the largest affordable one, sides are shrunk by two cells to keep them unpaired (odd)
+FIntPoint UGeneratedMapDataAsset::ClampLevelSize(const FIntPoint& LevelSize) const
+{
+	constexpr int32 MinSide = 3;
+	const FIntPoint& MaxLevelSize = LevelSizeCostModelInternal.MaxLevelSize;
+	FIntPoint ClampedSize(FMath::Clamp(LevelSize.X, MinSide, FMath::Max(MinSide, MaxLevelSize.X)),
+	                      FMath::Clamp(LevelSize.Y, MinSide, FMath::Max(MinSide, MaxLevelSize.Y)));
+
+	// Shrink the longest side by two cells until the cost fits the budget
+	while (!IsLevelSizeAffordable(ClampedSize)
+	       && ClampedSize.GetMax() > MinSide)
+	{
+		int32& LongestSide = ClampedSize.X >= ClampedSize.Y ? ClampedSize.X : ClampedSize.Y;
+		LongestSide = FMath::Max(MinSide, LongestSide - 2);
+	}
+
+	return ClampedSize;
+}
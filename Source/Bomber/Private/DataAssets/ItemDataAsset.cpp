@@ -10,6 +10,7 @@
 UItemDataAsset::UItemDataAsset()
 {
 	ActorTypeInternal = EAT::Item;
+	NetPolicyInternal.NetDormancy = DORM_DormantAll;
 	RowClassInternal = UItemRow::StaticClass();
 }
 
@@ -6,17 +6,75 @@
 //---
 #include "GameFramework/Actor.h"
 //---
+#if UE_WITH_IRIS
+#include "Iris/ReplicationSystem/ReplicationSystem.h"
+#include "Iris/ReplicationSystem/Filtering/NetObjectFilter.h"
+#include "Net/Iris/ReplicationSystem/ReplicationSystemUtil.h"
+#endif // UE_WITH_IRIS
+//---
 #if WITH_EDITOR
 #include "MyUnrealEdEngine.h"
 #endif
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(LevelActorDataAsset)
 
+// Applies update frequency, priority and relevancy of this policy to given actor
+void FLevelActorNetPolicy::ApplyToActor(AActor& Actor) const
+{
+	if (NetUpdateFrequency > 0.f)
+	{
+		Actor.NetUpdateFrequency = NetUpdateFrequency;
+	}
+
+	if (NetPriority > 0.f)
+	{
+		Actor.NetPriority = NetPriority;
+	}
+
+	Actor.bAlwaysRelevant = bAlwaysRelevant;
+}
+
+// Applies the filter and the static priority of this policy to given actor in the Iris replication system
+void FLevelActorNetPolicy::ApplyToReplicationSystem(const AActor& Actor) const
+{
+#if UE_WITH_IRIS
+	using namespace UE::Net;
+
+	const UReplicationSystem* ReplicationSystem = FReplicationSystemUtil::GetReplicationSystem(&Actor);
+	if (!ReplicationSystem)
+	{
+		// Is replicated by the legacy replication
+		return;
+	}
+
+	if (NetPriority > 0.f)
+	{
+		FReplicationSystemUtil::SetStaticPriority(&Actor, NetPriority);
+	}
+
+	if (!bAlwaysRelevant
+	    && !IrisFilterName.IsNone())
+	{
+		const FNetObjectFilterHandle FilterHandle = ReplicationSystem->GetFilterHandle(IrisFilterName);
+		if (ensureMsgf(FilterHandle != InvalidNetObjectFilterHandle, TEXT("ASSERT: [%i] %s:\nIris filter '%s' is not found!"), __LINE__, *FString(__FUNCTION__), *IrisFilterName.ToString()))
+		{
+			FReplicationSystemUtil::SetFilter(&Actor, FilterHandle);
+		}
+	}
+#endif // UE_WITH_IRIS
+}
+
 #if WITH_EDITOR // [IsEditorNotPieWorld]
 // Called to handle row changes
 void ULevelActorRow::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
 	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Level type or mesh of this row could be changed
+	if (const ULevelActorDataAsset* DataAsset = GetTypedOuter<ULevelActorDataAsset>())
+	{
+		DataAsset->RebuildRowsByLevelType();
+	}
 }
 
 // Called to notify on any data asset changes
@@ -26,7 +84,7 @@ void UBomberDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyCha
 
 	if (UUtilsLibrary::IsEditorNotPieWorld())
 	{
-		UMyUnrealEdEngine::GOnAnyDataAssetChanged.Broadcast();
+		UMyUnrealEdEngine::GOnAnyDataAssetChanged.Broadcast(this);
 	}
 }
 
@@ -35,6 +93,9 @@ void ULevelActorDataAsset::PostEditChangeProperty(FPropertyChangedEvent& Propert
 {
 	Super::PostEditChangeProperty(PropertyChangedEvent);
 
+	// Rows could be added, removed or changed, new rows are empty, so they are not taken by the table until their meshes are set
+	RebuildRowsByLevelType();
+
 	if (!ensureMsgf(RowClassInternal, TEXT("ASSERT: 'RowClassInternal' is not valid")))
 	{
 		return;
@@ -84,6 +145,33 @@ void ULevelActorDataAsset::GetRowsByLevelType(TArray<ULevelActorRow*>& OutRows,
 	}
 }
 
+// Return first found row by specified level types, is constant-time lookup in the precomputed table
+const ULevelActorRow* ULevelActorDataAsset::GetRowByLevelType(ELevelType LevelType) const
+{
+	if (RowsByLevelTypeInternal.IsEmpty())
+	{
+		// Is built on first request after loading, when all instanced rows are already loaded
+		RebuildRowsByLevelType();
+	}
+
+	const int32 LevelTypeIndex = TO_FLAG(LevelType);
+	return RowsByLevelTypeInternal.IsValidIndex(LevelTypeIndex) ? RowsByLevelTypeInternal[LevelTypeIndex].Get() : nullptr;
+}
+
+// Precomputes the first found row for each level type, is called on first lookup and on any change of rows
+void ULevelActorDataAsset::RebuildRowsByLevelType() const
+{
+	// Every value of the enum is stored, so combined flags are resolved the same way as single ones
+	constexpr int32 LevelTypesNum = TO_FLAG(ELT::Max) + 1;
+	RowsByLevelTypeInternal.Reset();
+	RowsByLevelTypeInternal.SetNum(LevelTypesNum);
+	for (int32 LevelTypeIndex = 0; LevelTypeIndex < LevelTypesNum; ++LevelTypeIndex)
+	{
+		const ELevelType LevelType = TO_ENUM(ELevelType, LevelTypeIndex);
+		RowsByLevelTypeInternal[LevelTypeIndex] = GetRowByPredicate([LevelType](const ULevelActorRow& RowIt) { return RowIt.LevelType == LevelType || RowIt.LevelType == ELT::Max; });
+	}
+}
+
 // Returns first found row by given predicate function
 const ULevelActorRow* ULevelActorDataAsset::GetRowByPredicate(const TFunctionRef<bool(const ULevelActorRow&)>& Predicate) const
 {
@@ -0,0 +1,123 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "DataAssets/LevelTypeAssetLabel.h"
+//---
+#include "DataAssets/DataAssetsContainer.h"
+#include "DataAssets/GeneratedMapDataAsset.h"
+#include "DataAssets/LevelActorDataAsset.h"
+#include "DataAssets/PlayerDataAsset.h"
+#include "DataAssets/SoundsDataAsset.h"
+//---
+#include "Animation/AnimSequence.h"
+#include "Animation/BlendSpace1D.h"
+#include "Engine/StreamableRenderAsset.h"
+#include "Sound/SoundBase.h"
+#include "UObject/ObjectSaveContext.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(LevelTypeAssetLabel)
+
+// Default constructor
+ULevelTypeAssetLabel::ULevelTypeAssetLabel()
+{
+	// Only collected assets are labeled, labels are placed together in one folder
+	bLabelAssetsInMyDirectory = false;
+	bIsRuntimeLabel = false;
+}
+
+#if WITH_EDITOR
+// Collects assets of the level type before saving, so the label is always up to date with data assets
+void ULevelTypeAssetLabel::PreSave(FObjectPreSaveContext SaveContext)
+{
+	RefreshLevelTypeAssets();
+
+	Super::PreSave(SaveContext);
+}
+
+// Collects assets of the level type once it is changed
+void ULevelTypeAssetLabel::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(ThisClass, LevelTypeInternal))
+	{
+		RefreshLevelTypeAssets();
+	}
+}
+
+// Fills explicit assets and the chunk of this label by all assets of the level type
+void ULevelTypeAssetLabel::RefreshLevelTypeAssets()
+{
+	const UGeneratedMapDataAsset* GeneratedMapDataAsset = UDataAssetsContainer::GetGeneratedMapDataAsset();
+	if (LevelTypeInternal == ELT::None
+	    || !GeneratedMapDataAsset)
+	{
+		return;
+	}
+
+	TSet<TSoftObjectPtr<UObject>> LevelTypeAssets;
+	auto AddAsset = [&LevelTypeAssets](const UObject* Asset)
+	{
+		if (Asset)
+		{
+			LevelTypeAssets.Emplace(TSoftObjectPtr<UObject>(FSoftObjectPath(Asset)));
+		}
+	};
+
+	// --- The streaming level
+	TArray<FLevelStreamRow> LevelStreamRows;
+	GeneratedMapDataAsset->GetLevelStreamRows(LevelStreamRows);
+	for (const FLevelStreamRow& LevelStreamRowIt : LevelStreamRows)
+	{
+		if (LevelStreamRowIt.LevelType == LevelTypeInternal
+		    && !LevelStreamRowIt.Level.IsNull())
+		{
+			LevelTypeAssets.Emplace(TSoftObjectPtr<UObject>(LevelStreamRowIt.Level.ToSoftObjectPath()));
+		}
+	}
+
+	// --- Meshes of level actors, rows shared by several level types stay in the base chunk
+	TArray<ULevelActorDataAsset*> ActorsDataAssets;
+	UDataAssetsContainer::GetDataAssetsByActorTypes(ActorsDataAssets, TO_FLAG(EAT::All));
+	for (const ULevelActorDataAsset* DataAssetIt : ActorsDataAssets)
+	{
+		TArray<ULevelActorRow*> Rows;
+		DataAssetIt->GetRowsByLevelType(Rows, TO_FLAG(LevelTypeInternal));
+		for (const ULevelActorRow* RowIt : Rows)
+		{
+			if (!RowIt
+			    || RowIt->LevelType != LevelTypeInternal)
+			{
+				continue;
+			}
+
+			AddAsset(RowIt->Mesh);
+
+			if (const UPlayerRow* PlayerRow = Cast<UPlayerRow>(RowIt))
+			{
+				AddAsset(PlayerRow->IdleWalkRunBlendSpace);
+				AddAsset(PlayerRow->DanceAnimation);
+				for (const FAttachedMesh& PropIt : PlayerRow->PlayerProps)
+				{
+					AddAsset(PropIt.AttachedMesh);
+					AddAsset(PropIt.MeshAnimation);
+				}
+			}
+		}
+	}
+
+	// --- Music of the level in game and in the main menu
+	if (const USoundsDataAsset* SoundsDataAsset = UDataAssetsContainer::GetSoundsDataAsset())
+	{
+		for (const TSoftObjectPtr<USoundBase>& MusicIt : {SoundsDataAsset->GetSoftLevelMusic(LevelTypeInternal), SoundsDataAsset->GetSoftLevelMainMenuMusic(LevelTypeInternal)})
+		{
+			if (!MusicIt.IsNull())
+			{
+				LevelTypeAssets.Emplace(TSoftObjectPtr<UObject>(MusicIt.ToSoftObjectPath()));
+			}
+		}
+	}
+
+	ExplicitAssets = LevelTypeAssets.Array();
+	Rules.ChunkId = GeneratedMapDataAsset->GetLevelTypeChunkId(LevelTypeInternal);
+}
+#endif // WITH_EDITOR
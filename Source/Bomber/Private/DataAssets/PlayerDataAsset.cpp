@@ -3,6 +3,7 @@
 #include "DataAssets/PlayerDataAsset.h"
 //---
 #include "DataAssets/DataAssetsContainer.h"
+#include "Engine/CosmeticCookScope.h"
 //---
 #include "GameFramework/Actor.h"
 #include "Engine/Texture2DArray.h"
@@ -26,6 +27,15 @@ UMaterialInstanceDynamic* UPlayerRow::GetMaterialInstanceDynamic(int32 SkinIndex
 	return nullptr;
 }
 
+// Strips props when is cooked for the dedicated server
+void UPlayerRow::Serialize(FArchive& Ar)
+{
+	// Props are never attached on the server, @see UMySkeletalMeshComponent::AttachProps
+	const FCosmeticCookScope CosmeticCookScope(Ar, *this);
+
+	Super::Serialize(Ar);
+}
+
 #if WITH_EDITOR
 // Handle adding and changing material instance to prepare dynamic materials
 void UPlayerRow::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
@@ -123,16 +133,34 @@ UMaterialInterface* UPlayerDataAsset::GetNameplateMaterial(int32 Index) const
 	return nullptr;
 }
 
-// Return first found row by specified player tag
+// Return first found row by specified player tag, is constant-time lookup in the precomputed map
 const UPlayerRow* UPlayerDataAsset::GetRowByPlayerTag(const FPlayerTag& PlayerTag) const
 {
-	for (const TObjectPtr<ULevelActorRow> RowIt : RowsInternal)
+	if (RowsByLevelTypeInternal.IsEmpty())
+	{
+		// Is built on first request after loading together with the base table
+		RebuildRowsByLevelType();
+	}
+
+	const TWeakObjectPtr<const UPlayerRow>* FoundRow = RowsByPlayerTagInternal.Find(PlayerTag);
+	return FoundRow ? FoundRow->Get() : nullptr;
+}
+
+// Precomputes player rows by tags together with the base table of level types
+void UPlayerDataAsset::RebuildRowsByLevelType() const
+{
+	Super::RebuildRowsByLevelType();
+
+	// The first row wins, the same as it was found by iterating rows
+	RowsByPlayerTagInternal.Reset();
+	for (const TObjectPtr<ULevelActorRow>& RowIt : RowsInternal)
 	{
 		const UPlayerRow* PlayerRow = Cast<UPlayerRow>(RowIt);
-		if (PlayerRow && PlayerRow->PlayerTag == PlayerTag)
+		if (!PlayerRow)
 		{
-			return PlayerRow;
+			continue;
 		}
+
+		RowsByPlayerTagInternal.FindOrAdd(PlayerRow->PlayerTag, PlayerRow);
 	}
-	return nullptr;
 }
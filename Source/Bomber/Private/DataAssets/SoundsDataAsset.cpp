@@ -5,6 +5,7 @@
 #include "Bomber.h"
 //---
 #include "DataAssets/DataAssetsContainer.h"
+#include "Engine/CosmeticCookScope.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(SoundsDataAsset)
 
@@ -16,10 +17,25 @@ const USoundsDataAsset& USoundsDataAsset::Get()
 	return *SoundsDataAsset;
 }
 
-// Returns the music of specified level
+// Strips cosmetic references when is cooked for the dedicated server
+void USoundsDataAsset::Serialize(FArchive& Ar)
+{
+	// Sound classes and the mix are kept, since they are tiny and are read by settings
+	const FCosmeticCookScope CosmeticCookScope(Ar, *this);
+
+	Super::Serialize(Ar);
+}
+
+// Returns the music of specified level if it's loaded
 USoundBase* USoundsDataAsset::GetLevelMusic(ELevelType LevelType) const
 {
-	if (const TObjectPtr<USoundBase>* FoundMusic = LevelsMusicInternal.Find(LevelType))
+	return GetSoftLevelMusic(LevelType).Get();
+}
+
+// Returns the soft reference to the music of specified level, is loaded on demand with its level type
+TSoftObjectPtr<USoundBase> USoundsDataAsset::GetSoftLevelMusic(ELevelType LevelType) const
+{
+	if (const TSoftObjectPtr<USoundBase>* FoundMusic = LevelsMusicInternal.Find(LevelType))
 	{
 		return *FoundMusic;
 	}
@@ -27,10 +43,16 @@ USoundBase* USoundsDataAsset::GetLevelMusic(ELevelType LevelType) const
 	return nullptr;
 }
 
-// Returns the main menu music of specified level
+// Returns the main menu music of specified level if it's loaded
 USoundBase* USoundsDataAsset::GetLevelMainMenuMusic(ELevelType LevelType) const
 {
-	if (const TObjectPtr<USoundBase>* FoundMusic = LevelsMainMenuMusicInternal.Find(LevelType))
+	return GetSoftLevelMainMenuMusic(LevelType).Get();
+}
+
+// Returns the soft reference to the main menu music of specified level, is loaded on demand with its level type
+TSoftObjectPtr<USoundBase> USoundsDataAsset::GetSoftLevelMainMenuMusic(ELevelType LevelType) const
+{
+	if (const TSoftObjectPtr<USoundBase>* FoundMusic = LevelsMainMenuMusicInternal.Find(LevelType))
 	{
 		return *FoundMusic;
 	}
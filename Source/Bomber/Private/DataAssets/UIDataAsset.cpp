@@ -3,6 +3,7 @@
 #include "DataAssets/UIDataAsset.h"
 //---
 #include "DataAssets/DataAssetsContainer.h"
+#include "Engine/CosmeticCookScope.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(UIDataAsset)
 
@@ -13,3 +14,12 @@ const UUIDataAsset& UUIDataAsset::Get()
 	checkf(UIDataAsset, TEXT("The UI Data Asset is not valid"));
 	return *UIDataAsset;
 }
+
+// Strips cosmetic references when is cooked for the dedicated server
+void UUIDataAsset::Serialize(FArchive& Ar)
+{
+	// Widgets are created only by local HUDs, the dedicated server does not have any
+	const FCosmeticCookScope CosmeticCookScope(Ar, *this);
+
+	Super::Serialize(Ar);
+}
@@ -10,6 +10,8 @@
 UWallDataAsset::UWallDataAsset()
 {
 	ActorTypeInternal = EAT::Wall;
+	bIsStaticInternal = true;
+	NetPolicyInternal.NetDormancy = DORM_DormantAll;
 }
 
 // Returns the wall data asset
@@ -0,0 +1,224 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Engine/BombLatencyStats.h"
+//---
+#include "Bomber.h"
+//---
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+
+CSV_DEFINE_CATEGORY_MODULE(BOMBER_API, BomberLatency, true);
+
+// Measures the latency of bomb placing
+static TAutoConsoleVariable<bool> CVarLatencyProfiling(
+	TEXT("Bomber.Latency.Profiling"),
+	false,
+	TEXT("Measure the latency from the bomb input to the placed bomb: 1 (Measure) OR 0 (Do not measure)"),
+	ECVF_Default);
+
+namespace BombLatencyStats
+{
+/** Upper bounds of histogram buckets in milliseconds, the last bucket takes everything above. */
+static constexpr double BucketBoundsMs[] = {1.0, 2.0, 4.0, 8.0, 16.0, 33.0, 50.0, 66.0, 100.0, 150.0, 200.0, 300.0, 500.0, 1000.0};
+static constexpr int32 BucketsNum = UE_ARRAY_COUNT(BucketBoundsMs) + 1;
+
+/** Inputs are forgotten after this time, e.g: when the request was rejected. */
+static constexpr double InputTimeout = 2.0;
+
+/** Histogram of one stage since the last reset. */
+struct FHistogram
+{
+	int64 Buckets[BucketsNum] = {};
+	int64 SamplesNum = 0;
+	double TotalMs = 0.0;
+	double MaxMs = 0.0;
+};
+
+static FHistogram Histograms[static_cast<int32>(EBombLatencyStage::Num)];
+
+/** The input that waits for its bomb. */
+struct FInput
+{
+	double Time = 0.0;
+	int32 CharacterID = INDEX_NONE;
+};
+
+/** Inputs by their cells that wait for their bombs. */
+static TMap<int32, FInput> Inputs;
+
+/** Names of stages, are used both for CSV stats and logs. */
+static const TCHAR* StageNames[] = {
+	TEXT("InputToSend"),
+	TEXT("InputToPrediction"),
+	TEXT("ReceiptToSpawn"),
+	TEXT("InputToVisible")
+};
+static_assert(UE_ARRAY_COUNT(StageNames) == static_cast<int32>(EBombLatencyStage::Num), "Each stage has to be named");
+
+/** Returns the upper bound in milliseconds that is reached by given part of samples of the histogram. */
+static double GetPercentileMs(const FHistogram& Histogram, double Percentile)
+{
+	const int64 TargetNum = FMath::CeilToInt64(Histogram.SamplesNum * Percentile);
+	int64 CountedNum = 0;
+	for (int32 BucketIndex = 0; BucketIndex < BucketsNum; ++BucketIndex)
+	{
+		CountedNum += Histogram.Buckets[BucketIndex];
+		if (CountedNum >= TargetNum)
+		{
+			return BucketIndex < BucketsNum - 1 ? BucketBoundsMs[BucketIndex] : Histogram.MaxMs;
+		}
+	}
+	return Histogram.MaxMs;
+}
+}
+
+// Returns true if latencies are measured
+bool FBombLatencyStats::IsEnabled()
+{
+	return CVarLatencyProfiling.GetValueOnAnyThread();
+}
+
+// Adds the sample of given stage in seconds
+void FBombLatencyStats::AddSample(EBombLatencyStage Stage, double Seconds)
+{
+	using namespace BombLatencyStats;
+	const int32 StageIndex = static_cast<int32>(Stage);
+	if (!IsEnabled()
+	    || !ensureMsgf(StageIndex < static_cast<int32>(EBombLatencyStage::Num), TEXT("ASSERT: 'Stage' is invalid")))
+	{
+		return;
+	}
+
+	const double SampleMs = FMath::Max(0.0, Seconds * 1000.0);
+	int32 BucketIndex = 0;
+	while (BucketIndex < BucketsNum - 1
+	       && SampleMs > BucketBoundsMs[BucketIndex])
+	{
+		++BucketIndex;
+	}
+
+	FHistogram& Histogram = Histograms[StageIndex];
+	++Histogram.Buckets[BucketIndex];
+	++Histogram.SamplesNum;
+	Histogram.TotalMs += SampleMs;
+	Histogram.MaxMs = FMath::Max(Histogram.MaxMs, SampleMs);
+
+#if CSV_PROFILER
+	static const TArray<FName> StageStatNames = []
+	{
+		TArray<FName> Names;
+		for (const TCHAR* NameIt : StageNames)
+		{
+			Names.Emplace(FString::Printf(TEXT("%sMs"), NameIt));
+		}
+		return Names;
+	}();
+
+	FCsvProfiler::RecordCustomStat(StageStatNames[StageIndex], CSV_CATEGORY_INDEX(BomberLatency), static_cast<float>(SampleMs), ECsvCustomStatOp::Max);
+#endif // CSV_PROFILER
+}
+
+// Remembers the time of the bomb input of given character on given cell
+void FBombLatencyStats::OnInput(int32 CellIndex, int32 CharacterID)
+{
+	using namespace BombLatencyStats;
+	if (!IsEnabled()
+	    || CellIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	const double CurrentTime = FPlatformTime::Seconds();
+	for (TMap<int32, FInput>::TIterator It = Inputs.CreateIterator(); It; ++It)
+	{
+		if (CurrentTime - It.Value().Time > InputTimeout)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// The first input is kept if it's repeated on the same cell before its bomb is placed
+	if (!Inputs.Contains(CellIndex))
+	{
+		Inputs.Add(CellIndex, {CurrentTime, CharacterID});
+	}
+}
+
+// Returns the time of the remembered input on given cell
+double FBombLatencyStats::GetInputTime(int32 CellIndex)
+{
+	const BombLatencyStats::FInput* FoundInput = BombLatencyStats::Inputs.Find(CellIndex);
+	return FoundInput ? FoundInput->Time : 0.0;
+}
+
+// Is called on the owning machine when the authoritative bomb appears on given cell
+void FBombLatencyStats::OnBombVisible(int32 CellIndex, int32 OwnerCharacterID)
+{
+	using namespace BombLatencyStats;
+	const FInput* FoundInput = IsEnabled() ? Inputs.Find(CellIndex) : nullptr;
+	if (!FoundInput
+	    || FoundInput->CharacterID != OwnerCharacterID)
+	{
+		// E.g: another player put the bomb on the same cell, while the request of this input was rejected
+		return;
+	}
+
+	AddSample(EBombLatencyStage::InputToVisible, FPlatformTime::Seconds() - FoundInput->Time);
+	Inputs.Remove(CellIndex);
+}
+
+// Logs the histogram and percentiles of each stage since the last reset
+void FBombLatencyStats::Dump()
+{
+	using namespace BombLatencyStats;
+	UE_LOG(LogBomber, Log, TEXT("Bomb latency since the last reset%s:"), IsEnabled() ? TEXT("") : TEXT(" (measuring is disabled by Bomber.Latency.Profiling)"));
+
+	// Frames queued ahead add to the latency, so show how they are queued now
+	static const IConsoleVariable* OneFrameThreadLagCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.OneFrameThreadLag"));
+	static const IConsoleVariable* GTSyncTypeCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.GTSyncType"));
+	UE_LOG(LogBomber, Log, TEXT("\tFrame queue: r.OneFrameThreadLag %i, r.GTSyncType %i, max FPS %.0f"),
+	       OneFrameThreadLagCVar ? OneFrameThreadLagCVar->GetInt() : INDEX_NONE, GTSyncTypeCVar ? GTSyncTypeCVar->GetInt() : INDEX_NONE, GEngine ? GEngine->GetMaxFPS() : 0.f);
+	for (int32 StageIndex = 0; StageIndex < static_cast<int32>(EBombLatencyStage::Num); ++StageIndex)
+	{
+		const FHistogram& Histogram = Histograms[StageIndex];
+		if (!Histogram.SamplesNum)
+		{
+			UE_LOG(LogBomber, Log, TEXT("\t%s: no samples"), StageNames[StageIndex]);
+			continue;
+		}
+
+		FString BucketsString;
+		for (int32 BucketIndex = 0; BucketIndex < BucketsNum; ++BucketIndex)
+		{
+			if (Histogram.Buckets[BucketIndex])
+			{
+				const FString BoundString = BucketIndex < BucketsNum - 1 ? FString::Printf(TEXT("<=%.0f"), BucketBoundsMs[BucketIndex]) : TEXT(">1000");
+				BucketsString += FString::Printf(TEXT(" [%sms: %lld]"), *BoundString, Histogram.Buckets[BucketIndex]);
+			}
+		}
+
+		UE_LOG(LogBomber, Log, TEXT("\t%s: %lld samples, avg %.2fms, p50 %.0fms, p95 %.0fms, p99 %.0fms, max %.2fms,%s"), StageNames[StageIndex], Histogram.SamplesNum,
+		       Histogram.TotalMs / Histogram.SamplesNum, GetPercentileMs(Histogram, 0.5), GetPercentileMs(Histogram, 0.95), GetPercentileMs(Histogram, 0.99), Histogram.MaxMs, *BucketsString);
+	}
+}
+
+// Starts measuring from scratch
+void FBombLatencyStats::Reset()
+{
+	using namespace BombLatencyStats;
+	for (FHistogram& HistogramIt : Histograms)
+	{
+		HistogramIt = FHistogram();
+	}
+	Inputs.Empty();
+}
+
+static FAutoConsoleCommand DumpLatencyStatsCommand(
+	TEXT("Bomber.Latency.DumpStats"),
+	TEXT("Logs latency histograms of bomb placing since the last reset"),
+	FConsoleCommandDelegate::CreateStatic(&FBombLatencyStats::Dump));
+
+static FAutoConsoleCommand ResetLatencyStatsCommand(
+	TEXT("Bomber.Latency.ResetStats"),
+	TEXT("Resets measured latencies of bomb placing"),
+	FConsoleCommandDelegate::CreateStatic(&FBombLatencyStats::Reset));
@@ -0,0 +1,280 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "PoolManagerSubsystem.h"
+#include "Components/MapComponent.h"
+#include "DataAssets/LevelActorDataAsset.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+//---
+#include "EngineUtils.h"
+#include "NiagaraComponent.h"
+#include "Blueprint/UserWidget.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/AudioComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/PropertyIterator.h"
+#include "UObject/UObjectIterator.h"
+
+/**
+ * Logs the memory footprint of the Bomber systems: bytes and counts of pooled level actors, containers of the Generated Map,
+ * loaded data assets with their soft references, Niagara and audio components, foot trails and widget trees.
+ * The engine-wide 'memreport' does not attribute memory to these systems, so this report is used to check budgets of consoles and small servers.
+ * Bytes are counted by FArchiveCountMem the same way as 'obj list' does: properties and containers of the object itself,
+ * while referenced objects like meshes and textures are not followed, so they are never counted twice.
+ */
+namespace BomberMemReport
+{
+/** Bytes and counts of one entry of the report. */
+struct FEntry
+{
+	int64 Bytes = 0;
+	int32 Num = 0;
+	int32 ActiveNum = 0;
+};
+
+/** Is added by the Foot Trails Generator feature to the actor of its instanced meshes, the feature depends on this module, but not vice versa. */
+static const FName FootTrailsActorTag(TEXT("FootTrails"));
+
+/** Returns the allocated memory of given object in bytes. */
+static int64 GetObjectBytes(UObject* Object)
+{
+	if (!Object)
+	{
+		return 0;
+	}
+
+	FArchiveCountMem CountMem(Object);
+	return static_cast<int64>(CountMem.GetMax());
+}
+
+/** Returns the allocated memory of given actor and all its components in bytes. */
+static int64 GetActorBytes(AActor* Actor)
+{
+	int64 Bytes = GetObjectBytes(Actor);
+	if (Actor)
+	{
+		for (UActorComponent* ComponentIt : Actor->GetComponents())
+		{
+			Bytes += GetObjectBytes(ComponentIt);
+		}
+	}
+	return Bytes;
+}
+
+/** Logs entries sorted by bytes under given title. */
+static void LogEntries(const TCHAR* Title, const TCHAR* ActiveName, TMap<FString, FEntry>& Entries)
+{
+	Entries.ValueSort([](const FEntry& A, const FEntry& B) { return A.Bytes > B.Bytes; });
+
+	FEntry Total;
+	for (const TTuple<FString, FEntry>& It : Entries)
+	{
+		Total.Bytes += It.Value.Bytes;
+		Total.Num += It.Value.Num;
+		Total.ActiveNum += It.Value.ActiveNum;
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("%s: %.1f KB, %i objects, %i %s"), Title, Total.Bytes / 1024.f, Total.Num, Total.ActiveNum, ActiveName);
+	for (const TTuple<FString, FEntry>& It : Entries)
+	{
+		UE_LOG(LogBomber, Log, TEXT("\t%s: %.1f KB, %i objects, %i %s"), *It.Key, It.Value.Bytes / 1024.f, It.Value.Num, It.Value.ActiveNum, ActiveName);
+	}
+}
+
+/** Level actors by their classes, active ones are on the level, others are inactive in pools. */
+static void ReportPools(UWorld* World)
+{
+	TMap<FString, FEntry> Entries;
+	const UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		AActor* Actor = *It;
+		if (!UMapComponent::GetMapComponent(Actor))
+		{
+			continue;
+		}
+
+		FEntry& Entry = Entries.FindOrAdd(GetNameSafe(Actor->GetClass()));
+		Entry.Bytes += GetActorBytes(Actor);
+		++Entry.Num;
+		Entry.ActiveNum += PoolManager.GetPoolObjectState(Actor) != EPoolObjectState::Inactive ? 1 : 0;
+	}
+
+	LogEntries(TEXT("Level actor pools"), TEXT("active"), Entries);
+}
+
+/** Containers of the Generated Map. */
+static void ReportGeneratedMap(UWorld* World)
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(World);
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+	if (!GeneratedMap)
+	{
+		UE_LOG(LogBomber, Log, TEXT("Generated Map: is not spawned"));
+		return;
+	}
+
+	const FIntPoint& GridSize = GeneratedMap->GetGridSize();
+	UE_LOG(LogBomber, Log, TEXT("Generated Map: grid %ix%i, %.1f KB; %i map components, %.1f KB; %i chunks"),
+	       GridSize.X, GridSize.Y, GeneratedMap->GetGridAllocatedSize() / 1024.f,
+	       GeneratedMap->GetMapComponentsNum(), GeneratedMap->GetMapComponentsAllocatedSize() / 1024.f, GeneratedMap->GetGridChunks().Num());
+}
+
+/** Loaded data assets by their classes, active ones are loaded soft references. */
+static void ReportDataAssets()
+{
+	TMap<FString, FEntry> Entries;
+	TMap<FString, FEntry> SoftReferences;
+	for (TObjectIterator<UBomberDataAsset> It; It; ++It)
+	{
+		UBomberDataAsset* DataAsset = *It;
+		if (DataAsset->IsTemplate())
+		{
+			continue;
+		}
+
+		const FString ClassName = GetNameSafe(DataAsset->GetClass());
+		FEntry& Entry = Entries.FindOrAdd(ClassName);
+		Entry.Bytes += GetObjectBytes(DataAsset);
+		++Entry.Num;
+
+		// Soft references are searched in all nested structs and containers
+		FEntry& SoftEntry = SoftReferences.FindOrAdd(ClassName);
+		for (TPropertyValueIterator<FSoftObjectProperty> PropertyIt(DataAsset->GetClass(), DataAsset, EPropertyValueIteratorFlags::FullRecursion); PropertyIt; ++PropertyIt)
+		{
+			const FSoftObjectPtr& SoftObject = *static_cast<const FSoftObjectPtr*>(PropertyIt.Value());
+			if (SoftObject.IsNull())
+			{
+				continue;
+			}
+
+			UObject* LoadedObject = SoftObject.Get();
+			++SoftEntry.Num;
+			SoftEntry.ActiveNum += LoadedObject ? 1 : 0;
+			SoftEntry.Bytes += GetObjectBytes(LoadedObject);
+		}
+	}
+
+	LogEntries(TEXT("Data assets"), TEXT("instances"), Entries);
+	LogEntries(TEXT("Soft references of data assets"), TEXT("loaded"), SoftReferences);
+}
+
+/** Niagara and audio components by their assets, pooled ones are inactive until reused. */
+static void ReportEffects(UWorld* World)
+{
+	TMap<FString, FEntry> NiagaraEntries;
+	for (TObjectIterator<UNiagaraComponent> It; It; ++It)
+	{
+		UNiagaraComponent* NiagaraComponent = *It;
+		if (NiagaraComponent->GetWorld() != World)
+		{
+			continue;
+		}
+
+		FEntry& Entry = NiagaraEntries.FindOrAdd(GetNameSafe(NiagaraComponent->GetAsset()));
+		Entry.Bytes += GetObjectBytes(NiagaraComponent);
+		++Entry.Num;
+		Entry.ActiveNum += NiagaraComponent->IsActive() ? 1 : 0;
+	}
+	LogEntries(TEXT("Niagara components"), TEXT("active"), NiagaraEntries);
+
+	TMap<FString, FEntry> AudioEntries;
+	for (TObjectIterator<UAudioComponent> It; It; ++It)
+	{
+		UAudioComponent* AudioComponent = *It;
+		if (AudioComponent->GetWorld() != World)
+		{
+			continue;
+		}
+
+		FEntry& Entry = AudioEntries.FindOrAdd(GetNameSafe(AudioComponent->Sound));
+		Entry.Bytes += GetObjectBytes(AudioComponent);
+		++Entry.Num;
+		Entry.ActiveNum += AudioComponent->IsPlaying() ? 1 : 0;
+	}
+	LogEntries(TEXT("Audio components"), TEXT("playing"), AudioEntries);
+}
+
+/** Instanced mesh components of foot trails by their meshes, active ones are instances. */
+static void ReportFootTrails(UWorld* World)
+{
+	TMap<FString, FEntry> Entries;
+	for (TObjectIterator<UInstancedStaticMeshComponent> It; It; ++It)
+	{
+		UInstancedStaticMeshComponent* InstancedComponent = *It;
+		const AActor* Owner = InstancedComponent->GetOwner();
+		if (InstancedComponent->GetWorld() != World
+		    || !Owner
+		    || !Owner->ActorHasTag(FootTrailsActorTag))
+		{
+			continue;
+		}
+
+		FEntry& Entry = Entries.FindOrAdd(GetNameSafe(InstancedComponent->GetStaticMesh()));
+		Entry.Bytes += GetObjectBytes(InstancedComponent);
+		++Entry.Num;
+		Entry.ActiveNum += InstancedComponent->GetInstanceCount();
+	}
+
+	LogEntries(TEXT("Foot trails"), TEXT("instances"), Entries);
+}
+
+/** Root widgets like ones created by the HUD with all widgets of their trees, active ones are in the viewport. */
+static void ReportWidgets(UWorld* World)
+{
+	TMap<FString, FEntry> Entries;
+	for (TObjectIterator<UUserWidget> It; It; ++It)
+	{
+		UUserWidget* UserWidget = *It;
+		if (UserWidget->GetWorld() != World
+		    || UserWidget->GetTypedOuter<UWidgetTree>()) // is a part of another widget tree, so is counted by its root
+		{
+			continue;
+		}
+
+		FEntry& Entry = Entries.FindOrAdd(GetNameSafe(UserWidget->GetClass()));
+		Entry.Bytes += GetObjectBytes(UserWidget);
+		++Entry.Num;
+		Entry.ActiveNum += UserWidget->IsInViewport() ? 1 : 0;
+
+		if (UserWidget->WidgetTree)
+		{
+			TArray<UWidget*> TreeWidgets;
+			UserWidget->WidgetTree->GetAllWidgets(TreeWidgets);
+			Entry.Num += TreeWidgets.Num();
+			for (UWidget* WidgetIt : TreeWidgets)
+			{
+				Entry.Bytes += GetObjectBytes(WidgetIt);
+			}
+		}
+	}
+
+	LogEntries(TEXT("Widget trees"), TEXT("in viewport"), Entries);
+}
+
+/** Logs all sections of the report for given world. */
+static void Run(UWorld* World)
+{
+	if (!World)
+	{
+		return;
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Bomber memory report of %s:"), *World->GetMapName());
+	ReportPools(World);
+	ReportGeneratedMap(World);
+	ReportDataAssets();
+	ReportEffects(World);
+	ReportFootTrails(World);
+	ReportWidgets(World);
+}
+}
+
+static FAutoConsoleCommandWithWorld MemReportCommand(
+	TEXT("Bomber.MemReport"),
+	TEXT("Logs bytes and counts of level actor pools, Generated Map containers, data assets, Niagara and audio components, foot trails and widget trees"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&BomberMemReport::Run));
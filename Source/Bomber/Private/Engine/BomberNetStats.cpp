@@ -0,0 +1,120 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Engine/BomberNetStats.h"
+//---
+#include "Bomber.h"
+//---
+#include "HAL/IConsoleManager.h"
+
+CSV_DEFINE_CATEGORY_MODULE(BOMBER_API, BomberNet, true);
+
+// Counts replicated bits and RPCs of the game by their source
+static TAutoConsoleVariable<bool> CVarNetProfiling(
+	TEXT("Bomber.Net.Profiling"),
+	false,
+	TEXT("Count replicated bits and RPCs by their source: 1 (Count) OR 0 (Do not count)"),
+	ECVF_Default);
+
+namespace BomberNetStats
+{
+/** Totals of one source since the last reset. */
+struct FTotals
+{
+	int64 Events = 0;
+	int64 Bits = 0;
+};
+
+static FTotals Totals[static_cast<int32>(EBomberNetSource::Num)];
+
+/** Names of sources, are used both for CSV stats and logs. */
+static const TCHAR* SourceNames[] = {
+	TEXT("MapComponentsDelta"),
+	TEXT("MulticastDetonateBomb"),
+	TEXT("ServerSpawnBomb"),
+	TEXT("MulticastSetLevelSize"),
+	TEXT("PlayerPowerups"),
+	TEXT("PlayerMeshData"),
+	TEXT("GameStateCountdowns")
+};
+static_assert(UE_ARRAY_COUNT(SourceNames) == static_cast<int32>(EBomberNetSource::Num), "Each source has to be named");
+}
+
+// Returns true if the network traffic is counted
+bool FBomberNetStats::IsEnabled()
+{
+	return CVarNetProfiling.GetValueOnAnyThread();
+}
+
+// Counts one event of given source and its bits if they are known
+void FBomberNetStats::Add(EBomberNetSource Source, int64 Bits/* = 0*/)
+{
+	using namespace BomberNetStats;
+	const int32 SourceIndex = static_cast<int32>(Source);
+	if (!ensureMsgf(SourceIndex < static_cast<int32>(EBomberNetSource::Num), TEXT("ASSERT: 'Source' is invalid")))
+	{
+		return;
+	}
+
+	FTotals& SourceTotals = Totals[SourceIndex];
+	++SourceTotals.Events;
+	SourceTotals.Bits += Bits;
+
+#if CSV_PROFILER
+	static const TArray<FName> EventStatNames = []
+	{
+		TArray<FName> Names;
+		for (const TCHAR* NameIt : SourceNames)
+		{
+			Names.Emplace(FString::Printf(TEXT("%s_Events"), NameIt));
+		}
+		return Names;
+	}();
+	static const TArray<FName> BytesStatNames = []
+	{
+		TArray<FName> Names;
+		for (const TCHAR* NameIt : SourceNames)
+		{
+			Names.Emplace(FString::Printf(TEXT("%s_Bytes"), NameIt));
+		}
+		return Names;
+	}();
+
+	FCsvProfiler::RecordCustomStat(EventStatNames[SourceIndex], CSV_CATEGORY_INDEX(BomberNet), 1, ECsvCustomStatOp::Accumulate);
+	if (Bits > 0)
+	{
+		FCsvProfiler::RecordCustomStat(BytesStatNames[SourceIndex], CSV_CATEGORY_INDEX(BomberNet), static_cast<float>(Bits) / 8.f, ECsvCustomStatOp::Accumulate);
+	}
+#endif // CSV_PROFILER
+}
+
+// Logs the number of events and bytes of each source since the last reset
+void FBomberNetStats::Dump()
+{
+	using namespace BomberNetStats;
+	UE_LOG(LogBomber, Log, TEXT("Network stats since the last reset%s:"), IsEnabled() ? TEXT("") : TEXT(" (counting is disabled by Bomber.Net.Profiling)"));
+	for (int32 SourceIndex = 0; SourceIndex < static_cast<int32>(EBomberNetSource::Num); ++SourceIndex)
+	{
+		const FTotals& SourceTotals = Totals[SourceIndex];
+		UE_LOG(LogBomber, Log, TEXT("\t%s: %lld events, %lld bytes"), SourceNames[SourceIndex], SourceTotals.Events, SourceTotals.Bits / 8);
+	}
+}
+
+// Starts counting from scratch
+void FBomberNetStats::Reset()
+{
+	using namespace BomberNetStats;
+	for (FTotals& TotalsIt : Totals)
+	{
+		TotalsIt = FTotals();
+	}
+}
+
+static FAutoConsoleCommand DumpNetStatsCommand(
+	TEXT("Bomber.Net.DumpStats"),
+	TEXT("Logs replicated bytes and RPCs of the game by their source since the last reset"),
+	FConsoleCommandDelegate::CreateStatic(&FBomberNetStats::Dump));
+
+static FAutoConsoleCommand ResetNetStatsCommand(
+	TEXT("Bomber.Net.ResetStats"),
+	TEXT("Resets counted replicated bytes and RPCs of the game"),
+	FConsoleCommandDelegate::CreateStatic(&FBomberNetStats::Reset));
@@ -0,0 +1,181 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Engine/BomberPerfBudget.h"
+
+#if WITH_BOMBER_PERF_BUDGETS
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+//---
+#include "HAL/IConsoleManager.h"
+//---
+#include <atomic>
+
+// Checks critical functions against their budgets
+static TAutoConsoleVariable<bool> CVarBudgetEnabled(
+	TEXT("Bomber.Budget.Enabled"),
+	true,
+	TEXT("Log warnings when critical functions exceed their budgets: 1 (Check) OR 0 (Do not check)"),
+	ECVF_Default);
+
+// Budget of the sides cells query
+static TAutoConsoleVariable<float> CVarBudgetGetSidesCellsMs(
+	TEXT("Bomber.Budget.GetSidesCellsMs"),
+	0.2f,
+	TEXT("Milliseconds of one GetSidesCells call: 0 (Not checked)"),
+	ECVF_Default);
+
+// Budget of the bomb explosion cells query
+static TAutoConsoleVariable<float> CVarBudgetGetExplosionCellsMs(
+	TEXT("Bomber.Budget.GetExplosionCellsMs"),
+	0.2f,
+	TEXT("Milliseconds of one GetExplosionCells call: 0 (Not checked)"),
+	ECVF_Default);
+
+// Budget of the level actors regeneration
+static TAutoConsoleVariable<float> CVarBudgetGenerateLevelActorsMs(
+	TEXT("Bomber.Budget.GenerateLevelActorsMs"),
+	50.f,
+	TEXT("Milliseconds of one GenerateLevelActors call: 0 (Not checked)"),
+	ECVF_Default);
+
+// Budget of one bot update
+static TAutoConsoleVariable<float> CVarBudgetUpdateAIMs(
+	TEXT("Bomber.Budget.UpdateAIMs"),
+	1.f,
+	TEXT("Milliseconds of one UpdateAI call: 0 (Not checked)"),
+	ECVF_Default);
+
+// Budget of applying replicated map components
+static TAutoConsoleVariable<float> CVarBudgetOnRepMapComponentsMs(
+	TEXT("Bomber.Budget.OnRepMapComponentsMs"),
+	2.f,
+	TEXT("Milliseconds of one OnRep_MapComponents call: 0 (Not checked)"),
+	ECVF_Default);
+
+// Budget of the bomb chain reaction
+static TAutoConsoleVariable<float> CVarBudgetDetonateBombMs(
+	TEXT("Bomber.Budget.DetonateBombMs"),
+	2.f,
+	TEXT("Milliseconds of one DetonateBomb call with its whole chain reaction: 0 (Not checked)"),
+	ECVF_Default);
+
+namespace BomberPerfBudget
+{
+/** Seconds between warnings of the same function, so the log is not flooded by frequent queries. */
+static constexpr double WarningInterval = 1.0;
+
+static const TCHAR* Names[] = {TEXT("GetSidesCells"), TEXT("GetExplosionCells"), TEXT("GenerateLevelActors"), TEXT("UpdateAI"), TEXT("OnRep_MapComponents"), TEXT("DetonateBomb")};
+static_assert(UE_ARRAY_COUNT(Names) == static_cast<SIZE_T>(EBomberPerfBudget::Num), "Names have to match EBomberPerfBudget");
+
+/** The last time the warning of each function was logged and the number of exceeded calls since then. */
+static double LastWarningTimes[static_cast<int32>(EBomberPerfBudget::Num)] = {};
+static int32 SkippedWarnings[static_cast<int32>(EBomberPerfBudget::Num)] = {};
+static FCriticalSection WarningsSection;
+
+/** Measured cycles and calls of each function, functions like grid queries could be measured on worker threads. */
+static std::atomic<uint64> TotalCycles[static_cast<int32>(EBomberPerfBudget::Num)] = {};
+static std::atomic<uint64> TotalCalls[static_cast<int32>(EBomberPerfBudget::Num)] = {};
+}
+
+// Starts measuring the scope
+FBomberPerfBudget::FScope::FScope(EBomberPerfBudget InBudget)
+{
+	if (IsEnabled())
+	{
+		Budget = InBudget;
+		StartCycles = FPlatformTime::Cycles64();
+	}
+}
+
+// Checks the measured time against the budget
+FBomberPerfBudget::FScope::~FScope()
+{
+	if (Budget == EBomberPerfBudget::Num)
+	{
+		return;
+	}
+
+	const uint64 ElapsedCycles = FPlatformTime::Cycles64() - StartCycles;
+	const int32 BudgetIndex = static_cast<int32>(Budget);
+	BomberPerfBudget::TotalCycles[BudgetIndex].fetch_add(ElapsedCycles, std::memory_order_relaxed);
+	BomberPerfBudget::TotalCalls[BudgetIndex].fetch_add(1, std::memory_order_relaxed);
+
+	const float BudgetMs = GetBudgetMs(Budget);
+	const double ElapsedMs = FPlatformTime::ToMilliseconds64(ElapsedCycles);
+	if (BudgetMs > 0.f
+	    && ElapsedMs > BudgetMs)
+	{
+		OnBudgetExceeded(Budget, ElapsedMs);
+	}
+}
+
+// Returns true if budgets are checked
+bool FBomberPerfBudget::IsEnabled()
+{
+	return CVarBudgetEnabled.GetValueOnAnyThread();
+}
+
+// Returns the budget of given function in milliseconds, 0 if the function is not checked
+float FBomberPerfBudget::GetBudgetMs(EBomberPerfBudget Budget)
+{
+	switch (Budget)
+	{
+		case EBomberPerfBudget::GetSidesCells: return CVarBudgetGetSidesCellsMs.GetValueOnAnyThread();
+		case EBomberPerfBudget::GetExplosionCells: return CVarBudgetGetExplosionCellsMs.GetValueOnAnyThread();
+		case EBomberPerfBudget::GenerateLevelActors: return CVarBudgetGenerateLevelActorsMs.GetValueOnAnyThread();
+		case EBomberPerfBudget::UpdateAI: return CVarBudgetUpdateAIMs.GetValueOnAnyThread();
+		case EBomberPerfBudget::OnRepMapComponents: return CVarBudgetOnRepMapComponentsMs.GetValueOnAnyThread();
+		case EBomberPerfBudget::DetonateBomb: return CVarBudgetDetonateBombMs.GetValueOnAnyThread();
+		default: return 0.f;
+	}
+}
+
+// Returns the total time in milliseconds and the number of calls of given function measured since the launch
+void FBomberPerfBudget::GetTotals(EBomberPerfBudget Budget, double& OutTotalMs, uint64& OutCallsNum)
+{
+	const int32 BudgetIndex = static_cast<int32>(Budget);
+	if (!ensureMsgf(BudgetIndex < static_cast<int32>(EBomberPerfBudget::Num), TEXT("ASSERT: 'Budget' is invalid")))
+	{
+		OutTotalMs = 0.0;
+		OutCallsNum = 0;
+		return;
+	}
+
+	OutTotalMs = FPlatformTime::ToMilliseconds64(BomberPerfBudget::TotalCycles[BudgetIndex].load(std::memory_order_relaxed));
+	OutCallsNum = BomberPerfBudget::TotalCalls[BudgetIndex].load(std::memory_order_relaxed);
+}
+
+// Logs the warning about exceeded budget of given function with the map size and the number of level actors
+void FBomberPerfBudget::OnBudgetExceeded(EBomberPerfBudget Budget, double ElapsedMs)
+{
+	const int32 BudgetIndex = static_cast<int32>(Budget);
+	int32 SkippedNum = 0;
+	{
+		FScopeLock Lock(&BomberPerfBudget::WarningsSection);
+		const double Now = FPlatformTime::Seconds();
+		if (Now - BomberPerfBudget::LastWarningTimes[BudgetIndex] < BomberPerfBudget::WarningInterval)
+		{
+			++BomberPerfBudget::SkippedWarnings[BudgetIndex];
+			return;
+		}
+
+		BomberPerfBudget::LastWarningTimes[BudgetIndex] = Now;
+		SkippedNum = BomberPerfBudget::SkippedWarnings[BudgetIndex];
+		BomberPerfBudget::SkippedWarnings[BudgetIndex] = 0;
+	}
+
+	// The level is read only on the game thread, queries on worker threads are logged without the context
+	FString Context = TEXT("level context is not available on this thread");
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = IsInGameThread() ? UGeneratedMapSubsystem::GetGeneratedMapSubsystem() : nullptr;
+	if (const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr)
+	{
+		const FIntPoint& GridSize = GeneratedMap->GetGridSize();
+		Context = FString::Printf(TEXT("map %ix%i, level actors %i, alive players %i"), GridSize.X, GridSize.Y, GeneratedMap->GetMapComponentsNum(), GeneratedMap->GetAlivePlayersNum());
+	}
+
+	UE_LOG(LogBomber, Warning, TEXT("Budget exceeded: %s took %.3f ms of %.3f ms budget (%s), %i more exceeded calls since the last warning"),
+	       BomberPerfBudget::Names[BudgetIndex], ElapsedMs, GetBudgetMs(Budget), *Context, SkippedNum);
+}
+#endif // WITH_BOMBER_PERF_BUDGETS
@@ -0,0 +1,449 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Engine/BomberTelemetry.h"
+//---
+#include "Bomber.h"
+//---
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+//---
+#include <atomic>
+
+// Writes gameplay telemetry to a file by the background thread
+static TAutoConsoleVariable<bool> CVarTelemetryEnabled(
+	TEXT("Bomber.Telemetry.Enabled"),
+	false,
+	TEXT("Write gameplay telemetry to a file by the background thread: 1 (Enabled) OR 0 (Disabled)"),
+	ECVF_Default);
+
+// The format of written events
+static TAutoConsoleVariable<int32> CVarTelemetryFormat(
+	TEXT("Bomber.Telemetry.Format"),
+	0,
+	TEXT("The format of telemetry files, is applied to next files: 0 (JSON lines) OR 1 (Compact binary records)"),
+	ECVF_Default);
+
+// Milliseconds between writes of queued events
+static TAutoConsoleVariable<int32> CVarTelemetryFlushMs(
+	TEXT("Bomber.Telemetry.FlushMs"),
+	500,
+	TEXT("Milliseconds between writes of queued telemetry events to the file"),
+	ECVF_Default);
+
+namespace BomberTelemetry
+{
+/** Version of binary records, is written in the header of binary files. */
+static constexpr uint32 BinaryVersion = 1;
+
+/** Max number of events that are queued between writes, is the power of two, events over it are dropped until the next write. */
+static constexpr uint32 QueueCapacity = 8192;
+
+/** Returns the name of given event type as it is written to JSON lines. */
+static const TCHAR* GetEventName(EBomberTelemetryEvent Type)
+{
+	switch (Type)
+	{
+		case EBomberTelemetryEvent::BombPlaced: return TEXT("BombPlaced");
+		case EBomberTelemetryEvent::BombDetonated: return TEXT("BombDetonated");
+		case EBomberTelemetryEvent::PlayerDied: return TEXT("PlayerDied");
+		case EBomberTelemetryEvent::ItemPickedUp: return TEXT("ItemPickedUp");
+		case EBomberTelemetryEvent::AIDecision: return TEXT("AIDecision");
+		case EBomberTelemetryEvent::StepTiming: return TEXT("StepTiming");
+		default: return TEXT("None");
+	}
+}
+
+/**
+ * The bounded queue of events with multiple producers and one consumer, its slots are allocated once, so pushing never allocates.
+ * Each slot has the sequence number that tells producers and the consumer whether the slot is free or filled.
+ */
+class FEventsRingBuffer
+{
+public:
+	FEventsRingBuffer()
+		: Slots(MakeUnique<FSlot[]>(QueueCapacity))
+	{
+		static_assert(FMath::IsPowerOfTwo(QueueCapacity), "QueueCapacity has to be the power of two");
+		for (uint32 Index = 0; Index < QueueCapacity; ++Index)
+		{
+			Slots[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+	}
+
+	/** Is called from any thread, returns false if the buffer is full and the event is dropped. */
+	bool TryEnqueue(const FBomberTelemetryEvent& Event, uint32& OutPosition)
+	{
+		uint32 Position = EnqueuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			FSlot& Slot = Slots[Position & (QueueCapacity - 1)];
+			const int32 Difference = static_cast<int32>(Slot.Sequence.load(std::memory_order_acquire) - Position);
+			if (Difference == 0)
+			{
+				if (EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+				{
+					Slot.Event = Event;
+					Slot.Sequence.store(Position + 1, std::memory_order_release);
+					OutPosition = Position;
+					return true;
+				}
+			}
+			else if (Difference < 0)
+			{
+				// The consumer has not read this slot yet
+				return false;
+			}
+			else
+			{
+				Position = EnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/** Is called only by the consumer thread, returns false if no filled event is left. */
+	bool Dequeue(FBomberTelemetryEvent& OutEvent)
+	{
+		FSlot& Slot = Slots[DequeuePosition & (QueueCapacity - 1)];
+		if (static_cast<int32>(Slot.Sequence.load(std::memory_order_acquire) - (DequeuePosition + 1)) < 0)
+		{
+			return false;
+		}
+
+		OutEvent = Slot.Event;
+		Slot.Sequence.store(DequeuePosition + QueueCapacity, std::memory_order_release);
+		++DequeuePosition;
+		return true;
+	}
+
+private:
+	struct FSlot
+	{
+		std::atomic<uint32> Sequence = 0;
+		FBomberTelemetryEvent Event;
+	};
+
+	TUniquePtr<FSlot[]> Slots = nullptr;
+	std::atomic<uint32> EnqueuePosition = 0;
+	uint32 DequeuePosition = 0;
+};
+
+/**
+ * Drains the queue of events on the background thread and writes them to the file.
+ */
+class FWriter final : public FRunnable
+{
+public:
+	FWriter(FArchive* InFileWriter, bool bInIsBinary)
+		: FileWriter(InFileWriter)
+		, bIsBinary(bInIsBinary)
+	{
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+
+		if (bIsBinary)
+		{
+			uint32 Version = BinaryVersion;
+			*FileWriter << Version;
+		}
+	}
+
+	virtual ~FWriter() override
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+
+		if (FileWriter)
+		{
+			FileWriter->Close();
+			delete FileWriter;
+			FileWriter = nullptr;
+		}
+	}
+
+	/** Is called from any thread, the queue has multiple producers and one consumer. */
+	void Enqueue(const FBomberTelemetryEvent& Event)
+	{
+		uint32 Position = 0;
+		if (!Queue.TryEnqueue(Event, Position))
+		{
+			DroppedNum.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		// Write earlier than by the flush interval once the half of the buffer is filled, so bursts are not dropped
+		if ((Position & (QueueCapacity / 2 - 1)) == 0)
+		{
+			WakeEvent->Trigger();
+		}
+	}
+
+	/** Returns the number of events that were dropped since the queue was full. */
+	FORCEINLINE uint32 GetDroppedNum() const { return DroppedNum.load(std::memory_order_relaxed); }
+
+	virtual uint32 Run() override
+	{
+		while (!bStopRequested)
+		{
+			WakeEvent->Wait(FMath::Max(CVarTelemetryFlushMs.GetValueOnAnyThread(), 1));
+			WriteQueuedEvents();
+		}
+
+		// Write events that were pushed right before the stop
+		WriteQueuedEvents();
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopRequested = true;
+		WakeEvent->Trigger();
+	}
+
+private:
+	/** Writes all queued events at once, so the file is touched only once per flush. */
+	void WriteQueuedEvents()
+	{
+		bool bAnyWritten = false;
+		FBomberTelemetryEvent Event;
+		while (Queue.Dequeue(Event))
+		{
+			bIsBinary ? WriteBinary(Event) : WriteJson(Event);
+			bAnyWritten = true;
+		}
+
+		if (bAnyWritten)
+		{
+			FileWriter->Flush();
+		}
+	}
+
+	/** Writes the event as one JSON line. */
+	void WriteJson(const FBomberTelemetryEvent& Event)
+	{
+		LineBuilder.Reset();
+		LineBuilder.Appendf("{\"t\":%.4f,\"e\":\"%s\"", Event.Time, TCHAR_TO_ANSI(GetEventName(Event.Type)));
+		if (!Event.Name.IsNone())
+		{
+			LineBuilder.Appendf(",\"n\":\"%s\"", TCHAR_TO_ANSI(*Event.Name.ToString()));
+		}
+		if (Event.CellIndex != INDEX_NONE)
+		{
+			LineBuilder.Appendf(",\"c\":%i", Event.CellIndex);
+		}
+		if (Event.Subject != INDEX_NONE)
+		{
+			LineBuilder.Appendf(",\"s\":%i", Event.Subject);
+		}
+		if (Event.Data != INDEX_NONE)
+		{
+			LineBuilder.Appendf(",\"d\":%i", Event.Data);
+		}
+		if (Event.Value != 0.f)
+		{
+			LineBuilder.Appendf(",\"v\":%.4f", Event.Value);
+		}
+		LineBuilder.Append("}\n");
+
+		FileWriter->Serialize(const_cast<ANSICHAR*>(LineBuilder.GetData()), LineBuilder.Len() * sizeof(ANSICHAR));
+	}
+
+	/** Writes the event as the fixed record, the name is written as the string only for timings. */
+	void WriteBinary(FBomberTelemetryEvent& Event)
+	{
+		uint8 Type = static_cast<uint8>(Event.Type);
+		*FileWriter << Type;
+		*FileWriter << Event.Time;
+		*FileWriter << Event.CellIndex;
+		*FileWriter << Event.Subject;
+		*FileWriter << Event.Data;
+		*FileWriter << Event.Value;
+		if (Event.Type == EBomberTelemetryEvent::StepTiming)
+		{
+			FString Name = Event.Name.ToString();
+			*FileWriter << Name;
+		}
+	}
+
+	FEventsRingBuffer Queue;
+	FArchive* FileWriter = nullptr;
+	FEvent* WakeEvent = nullptr;
+	TAnsiStringBuilder<256> LineBuilder;
+	std::atomic<bool> bStopRequested = false;
+	std::atomic<uint32> DroppedNum = 0;
+	bool bIsBinary = false;
+};
+
+static FWriter* Writer = nullptr;
+static FRunnableThread* WriterThread = nullptr;
+static std::atomic<bool> bIsEnabled = false;
+static double StartTime = 0.0;
+
+/** The number of producers that are pushing events right now, the writer is deleted only once there are none of them. */
+static std::atomic<int32> ActiveProducersNum = 0;
+
+/** Pushes the event to the writer if the telemetry is still enabled, is fenced by the number of active producers. */
+static void PushEvent(const FBomberTelemetryEvent& Event)
+{
+	ActiveProducersNum.fetch_add(1);
+	if (bIsEnabled.load())
+	{
+		Writer->Enqueue(Event);
+	}
+	ActiveProducersNum.fetch_sub(1);
+}
+}
+
+// Starts the writer if enabled, is called when the module is loaded
+void FBomberTelemetry::Initialize()
+{
+	CVarTelemetryEnabled->SetOnChangedCallback(FConsoleVariableDelegate::CreateStatic(&FBomberTelemetry::OnEnabledChanged));
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("BomberTelemetry"))
+	    || FCString::Strifind(FCommandLine::Get(), TEXT("-BomberTelemetry=")))
+	{
+		CVarTelemetryEnabled->Set(true, ECVF_SetByCommandline);
+	}
+
+	if (CVarTelemetryEnabled.GetValueOnGameThread())
+	{
+		StartWriter();
+	}
+}
+
+// Stops the writer and flushes all queued events
+void FBomberTelemetry::Deinitialize()
+{
+	CVarTelemetryEnabled->SetOnChangedCallback(FConsoleVariableDelegate());
+	StopWriter();
+}
+
+// Returns true while events are written
+bool FBomberTelemetry::IsEnabled()
+{
+	return BomberTelemetry::bIsEnabled.load(std::memory_order_relaxed);
+}
+
+// Pushes the event into the queue, does nothing if the telemetry is disabled
+void FBomberTelemetry::RecordEvent(EBomberTelemetryEvent Type, int32 CellIndex/* = INDEX_NONE*/, int32 Subject/* = INDEX_NONE*/, int32 Data/* = INDEX_NONE*/, float Value/* = 0.f*/)
+{
+	using namespace BomberTelemetry;
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	FBomberTelemetryEvent Event;
+	Event.Time = FPlatformTime::Seconds() - StartTime;
+	Event.Type = Type;
+	Event.CellIndex = CellIndex;
+	Event.Subject = Subject;
+	Event.Data = Data;
+	Event.Value = Value;
+	PushEvent(Event);
+}
+
+// Pushes the time of given step into the queue, does nothing if the telemetry is disabled
+void FBomberTelemetry::RecordStepTiming(FName Step, double Seconds)
+{
+	using namespace BomberTelemetry;
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	FBomberTelemetryEvent Event;
+	Event.Time = FPlatformTime::Seconds() - StartTime;
+	Event.Type = EBomberTelemetryEvent::StepTiming;
+	Event.Name = Step;
+	Event.Value = static_cast<float>(Seconds * 1000.0);
+	PushEvent(Event);
+}
+
+// Creates the file and the background thread that writes queued events
+void FBomberTelemetry::StartWriter()
+{
+	using namespace BomberTelemetry;
+	if (Writer)
+	{
+		return;
+	}
+
+	const bool bIsBinary = CVarTelemetryFormat.GetValueOnGameThread() == 1;
+	FString FilePath;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("BomberTelemetry="), FilePath))
+	{
+		const TCHAR* Extension = bIsBinary ? TEXT("bin") : TEXT("jsonl");
+		FilePath = FPaths::ProjectSavedDir() / TEXT("Telemetry") / FString::Printf(TEXT("Telemetry_%s.%s"), *FDateTime::Now().ToString(), Extension);
+	}
+
+	// The file writer is buffered, so events are written to the disk by large blocks
+	FArchive* FileWriter = IFileManager::Get().CreateFileWriter(*FilePath, FILEWRITE_AllowRead);
+	if (!FileWriter)
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Telemetry: failed to create the file '%s'"), *FilePath);
+		return;
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	Writer = new FWriter(FileWriter, bIsBinary);
+	WriterThread = FRunnableThread::Create(Writer, TEXT("BomberTelemetryWriter"), 0, TPri_BelowNormal);
+	if (!WriterThread)
+	{
+		delete Writer;
+		Writer = nullptr;
+		return;
+	}
+
+	bIsEnabled = true;
+	UE_LOG(LogBomber, Log, TEXT("Telemetry: events are written to '%s'"), *FilePath);
+}
+
+// Stops the background thread, remaining events are written before the file is closed
+void FBomberTelemetry::StopWriter()
+{
+	using namespace BomberTelemetry;
+	if (!Writer)
+	{
+		return;
+	}
+
+	// Producers check the flag after they are counted, so once none of them is active, no one can touch the writer anymore
+	bIsEnabled = false;
+	while (ActiveProducersNum.load() > 0)
+	{
+		FPlatformProcess::Yield();
+	}
+
+	if (WriterThread)
+	{
+		WriterThread->Kill(/*bShouldWait*/true);
+		delete WriterThread;
+		WriterThread = nullptr;
+	}
+
+	if (const uint32 DroppedNum = Writer->GetDroppedNum())
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Telemetry: %u events were dropped since the queue was full, decrease 'Bomber.Telemetry.FlushMs'"), DroppedNum);
+	}
+
+	delete Writer;
+	Writer = nullptr;
+}
+
+// Starts or stops the writer once 'Bomber.Telemetry.Enabled' is changed
+void FBomberTelemetry::OnEnabledChanged(IConsoleVariable* ConsoleVariable)
+{
+	if (ConsoleVariable && ConsoleVariable->GetBool())
+	{
+		StartWriter();
+	}
+	else
+	{
+		StopWriter();
+	}
+}
@@ -0,0 +1,72 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Engine/CosmeticCookScope.h"
+//---
+#include "Serialization/Archive.h"
+#include "UObject/UnrealType.h"
+//---
+#if WITH_EDITOR
+#include "Interfaces/ITargetPlatform.h"
+#endif
+
+// The metadata of properties that are stripped
+const FName FCosmeticCookScope::CosmeticOnlyMetaName = TEXT("CosmeticOnly");
+
+// Strips all 'CosmeticOnly' properties of given object if given archive cooks for the dedicated server
+FCosmeticCookScope::FCosmeticCookScope(const FArchive& Ar, UObject& Object)
+	: bIsCookingForServer(IsCookingForServer(Ar))
+{
+	if (bIsCookingForServer)
+	{
+		StripCosmeticProperties(Object);
+	}
+}
+
+// Restores all stripped references
+FCosmeticCookScope::~FCosmeticCookScope()
+{
+	for (int32 Index = Restores.Num() - 1; Index >= 0; --Index)
+	{
+		Restores[Index]();
+	}
+}
+
+// Clears all 'CosmeticOnly' properties of given object until this scope is destroyed
+void FCosmeticCookScope::StripCosmeticProperties(UObject& Object)
+{
+#if WITH_EDITORONLY_DATA
+	for (TFieldIterator<FProperty> It(Object.GetClass()); It; ++It)
+	{
+		const FProperty* Property = *It;
+		if (!Property->HasMetaData(CosmeticOnlyMetaName))
+		{
+			continue;
+		}
+
+		// Move the value aside and reset the property to its empty value
+		void* ValuePtr = Property->ContainerPtrToValuePtr<void>(&Object);
+		void* StrippedValue = FMemory::Malloc(Property->GetSize(), Property->GetMinAlignment());
+		Property->InitializeValue(StrippedValue);
+		Property->CopyCompleteValue(StrippedValue, ValuePtr);
+		Property->ClearValue(ValuePtr);
+
+		Restores.Emplace([Property, ValuePtr, StrippedValue]()
+		{
+			Property->CopyCompleteValue(ValuePtr, StrippedValue);
+			Property->DestroyValue(StrippedValue);
+			FMemory::Free(StrippedValue);
+		});
+	}
+#endif // WITH_EDITORONLY_DATA
+}
+
+// Returns true if given archive saves the package cooked for the server-only platform
+bool FCosmeticCookScope::IsCookingForServer(const FArchive& Ar)
+{
+#if WITH_EDITOR
+	const ITargetPlatform* CookingTarget = Ar.IsSaving() && Ar.IsCooking() ? Ar.CookingTarget() : nullptr;
+	return CookingTarget && CookingTarget->IsServerOnly();
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,186 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Engine/FrameSpikeCapture.h"
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+//---
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "ProfilingDebugging/TraceAuxiliary.h"
+
+// The frame time in milliseconds above which the next frames are traced
+static TAutoConsoleVariable<float> CVarSpikeCaptureFrameMs(
+	TEXT("Bomber.SpikeCapture.FrameMs"),
+	0.f,
+	TEXT("Trace next frames once the frame time is above given milliseconds: 0 (Disabled)"),
+	ECVF_Default);
+
+// The number of bombs in a chain reaction from which its explosions are traced
+static TAutoConsoleVariable<int32> CVarSpikeCaptureChainBombs(
+	TEXT("Bomber.SpikeCapture.ChainBombs"),
+	0,
+	TEXT("Trace explosions of chain reactions of at least given bombs: 0 (Disabled)"),
+	ECVF_Default);
+
+// Traces each regeneration of level actors
+static TAutoConsoleVariable<bool> CVarSpikeCaptureRegeneration(
+	TEXT("Bomber.SpikeCapture.Regeneration"),
+	false,
+	TEXT("Trace regenerations of level actors: 1 (Trace) OR 0 (Do not trace)"),
+	ECVF_Default);
+
+// Seconds each capture lasts
+static TAutoConsoleVariable<float> CVarSpikeCaptureSeconds(
+	TEXT("Bomber.SpikeCapture.Seconds"),
+	3.f,
+	TEXT("Seconds each spike capture lasts"),
+	ECVF_Default);
+
+namespace FrameSpikeCapture
+{
+/** Seconds after the capture is finished during which new captures are not started, so the same spike is not traced many times. */
+static constexpr double Cooldown = 30.0;
+
+static FTSTicker::FDelegateHandle FrameTickerHandle;
+static FTSTicker::FDelegateHandle StopTickerHandle;
+static bool bIsCapturing = false;
+static double LastCaptureEndTime = -Cooldown;
+
+/** Returns true if given world takes part in the match. */
+static bool IsMatchWorld(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World && World->IsGameWorld();
+}
+}
+
+// Starts watching frame times, is called when the module is loaded
+void FFrameSpikeCapture::Initialize()
+{
+	using namespace FrameSpikeCapture;
+	if (!FrameTickerHandle.IsValid())
+	{
+		FrameTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FFrameSpikeCapture::OnFrameTick));
+	}
+}
+
+// Stops watching frame times and stops the running capture
+void FFrameSpikeCapture::Deinitialize()
+{
+	using namespace FrameSpikeCapture;
+	FTSTicker::GetCoreTicker().RemoveTicker(FrameTickerHandle);
+	FrameTickerHandle.Reset();
+
+	if (bIsCapturing)
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(StopTickerHandle);
+		StopCapture(0.f);
+	}
+}
+
+// Is called by bombs right before explosions of the chain reaction are applied
+void FFrameSpikeCapture::OnChainReaction(const UObject* WorldContextObject, int32 BombsNum)
+{
+	const int32 MinBombsNum = CVarSpikeCaptureChainBombs.GetValueOnAnyThread();
+	if (MinBombsNum > 0
+	    && BombsNum >= MinBombsNum
+	    && FrameSpikeCapture::IsMatchWorld(WorldContextObject))
+	{
+		StartCapture(*FString::Printf(TEXT("Chain%i"), BombsNum));
+	}
+}
+
+// Is called by the Generated Map right before level actors are regenerated
+void FFrameSpikeCapture::OnRegeneration(const UObject* WorldContextObject)
+{
+	if (CVarSpikeCaptureRegeneration.GetValueOnAnyThread()
+	    && FrameSpikeCapture::IsMatchWorld(WorldContextObject))
+	{
+		StartCapture(TEXT("Regeneration"));
+	}
+}
+
+// Returns true while the trace is written by this capture
+bool FFrameSpikeCapture::IsCapturing()
+{
+	return FrameSpikeCapture::bIsCapturing;
+}
+
+// Starts the trace or adds the bookmark if it is already running
+void FFrameSpikeCapture::StartCapture(const TCHAR* Reason)
+{
+#if UE_TRACE_ENABLED
+	using namespace FrameSpikeCapture;
+
+	// The trace is already written by this capture or by someone else, so just mark the moment
+	if (bIsCapturing
+	    || FTraceAuxiliary::IsConnected())
+	{
+		TRACE_BOOKMARK(TEXT("Bomber spike: %s"), Reason);
+		return;
+	}
+
+	if (FPlatformTime::Seconds() - LastCaptureEndTime < Cooldown)
+	{
+		return;
+	}
+
+	const AGeneratedMap* GeneratedMap = UGeneratedMapSubsystem::Get().GetGeneratedMap();
+	const int32 Seed = GeneratedMap ? GeneratedMap->GetGenerationSeed() : 0;
+
+	const FString Directory = FPaths::ProfilingDir() / TEXT("SpikeCapture");
+	IFileManager::Get().MakeDirectory(*Directory, /*Tree*/true);
+	const FString FilePath = Directory / FString::Printf(TEXT("SpikeCapture_%s_Seed%i_%s.utrace"), Reason, Seed, *FDateTime::Now().ToString());
+
+	if (!FTraceAuxiliary::Start(FTraceAuxiliary::EConnectionType::File, *FilePath, TEXT("default,bookmark")))
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Spike capture: failed to start the trace to '%s'"), *FilePath);
+		return;
+	}
+
+	bIsCapturing = true;
+	TRACE_BOOKMARK(TEXT("Bomber spike: %s, seed %i"), Reason, Seed);
+
+	const float Seconds = FMath::Max(0.1f, CVarSpikeCaptureSeconds.GetValueOnAnyThread());
+	StopTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FFrameSpikeCapture::StopCapture), Seconds);
+
+	UE_LOG(LogBomber, Log, TEXT("Spike capture: '%s' is traced for %.1f seconds to '%s'"), Reason, Seconds, *FilePath);
+#endif // UE_TRACE_ENABLED
+}
+
+// Stops the trace started by this capture
+bool FFrameSpikeCapture::StopCapture(float DeltaTime)
+{
+	using namespace FrameSpikeCapture;
+#if UE_TRACE_ENABLED
+	if (bIsCapturing)
+	{
+		FTraceAuxiliary::Stop();
+	}
+#endif // UE_TRACE_ENABLED
+
+	bIsCapturing = false;
+	StopTickerHandle.Reset();
+	LastCaptureEndTime = FPlatformTime::Seconds();
+
+	// Is called once
+	return false;
+}
+
+// Triggers the capture once the frame time goes over the threshold
+bool FFrameSpikeCapture::OnFrameTick(float DeltaTime)
+{
+	const float ThresholdMs = CVarSpikeCaptureFrameMs.GetValueOnAnyThread();
+	if (ThresholdMs > 0.f
+	    && DeltaTime * 1000.f > ThresholdMs)
+	{
+		// The spike frame is already finished, so next frames are traced in case spikes come in series
+		StartCapture(*FString::Printf(TEXT("Frame%.0fms"), DeltaTime * 1000.f));
+	}
+
+	return true;
+}
@@ -0,0 +1,363 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Engine/MyReplicationGraph.h"
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "PoolManagerSubsystem.h"
+#include "Components/MapComponent.h"
+#include "LevelActors/PlayerCharacter.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+//---
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(MyReplicationGraph)
+
+static TAutoConsoleVariable<int32> CVarReplicationGraph(
+	TEXT("Bomber.Net.ReplicationGraph"),
+	0,
+	TEXT("Is read on creating net driver: 1 (Replicate by the Bomber replication graph) OR 0 (Use default relevancy checks of each actor)"),
+	ECVF_Default);
+
+/*********************************************************************************************
+ * UMyReplicationGraphNode_LevelGrid
+ ********************************************************************************************* */
+
+// Sets default values for this node's properties
+UMyReplicationGraphNode_LevelGrid::UMyReplicationGraphNode_LevelGrid()
+{
+	// Cells of level actors are checked once per frame instead of each connection
+	bRequiresPrepareForReplicationCall = true;
+}
+
+// Is called when a level actor is added to the graph
+void UMyReplicationGraphNode_LevelGrid::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	FLevelGridActor& LevelActor = LevelActorsInternal.FindOrAdd(ActorInfo.Actor);
+	LevelActor.MapComponent = UMapComponent::GetMapComponent(ActorInfo.Actor);
+
+	// Cell is not known yet, actor is added to the region in next preparation
+	LevelActor.CellIndex = INDEX_NONE;
+	MapComponentsVersionInternal = MAX_uint32;
+}
+
+// Is called when a level actor is removed from the graph
+bool UMyReplicationGraphNode_LevelGrid::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	FLevelGridActor LevelActor;
+	if (!LevelActorsInternal.RemoveAndCopyValue(ActorInfo.Actor, LevelActor))
+	{
+		return false;
+	}
+
+	MoveActorToCell(ActorInfo.Actor, LevelActor, INDEX_NONE);
+	return true;
+}
+
+// Is called when all actors are removed from the graph
+void UMyReplicationGraphNode_LevelGrid::NotifyResetAllNetworkActors()
+{
+	LevelActorsInternal.Reset();
+	RegionsInternal.Reset();
+	MapComponentsVersionInternal = MAX_uint32;
+}
+
+// Rebuckets level actors whose cells were changed since last frame
+void UMyReplicationGraphNode_LevelGrid::PrepareForReplication()
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(GetWorld());
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+	if (!GeneratedMap)
+	{
+		return;
+	}
+
+	// Level actors change cells only with map components of the Generated Map, so nothing is checked on frames without changes
+	const uint32 MapComponentsVersion = GeneratedMap->GetMapComponentsVersion();
+	if (MapComponentsVersion == MapComponentsVersionInternal)
+	{
+		return;
+	}
+	MapComponentsVersionInternal = MapComponentsVersion;
+
+	// Inactive actors in pools are not replicated until they are placed on the level
+	const UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+	for (TTuple<FActorRepListType, FLevelGridActor>& It : LevelActorsInternal)
+	{
+		const UMapComponent* MapComponent = It.Value.MapComponent.Get();
+		const bool bIsOnLevel = MapComponent && PoolManager.GetPoolObjectState(It.Key) != EPoolObjectState::Inactive;
+		const int32 NewCellIndex = bIsOnLevel ? GeneratedMap->GetCellIndex(MapComponent->GetCell()) : INDEX_NONE;
+		if (NewCellIndex != It.Value.CellIndex)
+		{
+			MoveActorToCell(It.Key, It.Value, NewCellIndex);
+		}
+	}
+}
+
+// Adds lists of regions around viewers of the connection
+void UMyReplicationGraphNode_LevelGrid::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(GetWorld());
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+
+	// Far regions are gathered only on some frames, each connection is in step since it is based on the shared frame number
+	const bool bIsFarFrame = Params.ReplicationFrameNum % FMath::Max(FarRegionReplicationPeriod, 1) == 0;
+	const bool bHasFarRegions = FarRegionViewRadius < 0 || FarRegionViewRadius > RegionViewRadius;
+	const bool bAllFarRegions = bIsFarFrame && FarRegionViewRadius < 0;
+	const int32 ViewRadius = bIsFarFrame && bHasFarRegions ? FarRegionViewRadius : RegionViewRadius;
+
+	TSet<FIntPoint, DefaultKeyFuncs<FIntPoint>, TInlineSetAllocator<16>> RelevantRegions;
+	bool bAllRegions = RegionViewRadius < 0 || bAllFarRegions || !GeneratedMap;
+	for (const FNetViewer& ViewerIt : Params.Viewers)
+	{
+		if (bAllRegions)
+		{
+			break;
+		}
+
+		const FIntPoint ViewerRegion = GetRegionByCellIndex(GeneratedMap->GetNearestCellIndex(ViewerIt.ViewLocation));
+		if (ViewerRegion == FIntPoint::NoneValue)
+		{
+			// Viewer is not on the level, e.g. spectator
+			bAllRegions = true;
+			break;
+		}
+
+		for (int32 X = -ViewRadius; X <= ViewRadius; ++X)
+		{
+			for (int32 Y = -ViewRadius; Y <= ViewRadius; ++Y)
+			{
+				RelevantRegions.Emplace(ViewerRegion + FIntPoint(X, Y));
+			}
+		}
+	}
+
+	for (TTuple<FIntPoint, FActorRepListRefView>& It : RegionsInternal)
+	{
+		if (It.Value.Num() > 0
+		    && (bAllRegions || RelevantRegions.Contains(It.Key)))
+		{
+			Params.OutGatheredReplicationLists.AddReplicationActorList(It.Value);
+		}
+	}
+}
+
+// Returns the region of specified cell index on the grid
+FIntPoint UMyReplicationGraphNode_LevelGrid::GetRegionByCellIndex(int32 CellIndex) const
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(GetWorld());
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+	return GeneratedMap ? GeneratedMap->GetGridChunks().GetChunkCoord(CellIndex) : FIntPoint::NoneValue;
+}
+
+// Moves given actor from the region of its previous cell into the region of new cell
+void UMyReplicationGraphNode_LevelGrid::MoveActorToCell(FActorRepListType Actor, FLevelGridActor& InOutLevelActor, int32 NewCellIndex)
+{
+	const FIntPoint PrevRegion = GetRegionByCellIndex(InOutLevelActor.CellIndex);
+	const FIntPoint NewRegion = GetRegionByCellIndex(NewCellIndex);
+	InOutLevelActor.CellIndex = NewCellIndex;
+
+	if (PrevRegion == NewRegion)
+	{
+		return;
+	}
+
+	if (FActorRepListRefView* PrevList = PrevRegion != FIntPoint::NoneValue ? RegionsInternal.Find(PrevRegion) : nullptr)
+	{
+		PrevList->RemoveFast(Actor);
+	}
+
+	if (NewRegion != FIntPoint::NoneValue)
+	{
+		RegionsInternal.FindOrAdd(NewRegion).Add(Actor);
+	}
+}
+
+/*********************************************************************************************
+ * UMyReplicationGraphNode_OwnerOnly
+ ********************************************************************************************* */
+
+// Is called when an owner only actor is added to the graph
+void UMyReplicationGraphNode_OwnerOnly::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	ActorsInternal.AddUnique(ActorInfo.Actor);
+}
+
+// Is called when an owner only actor is removed from the graph
+bool UMyReplicationGraphNode_OwnerOnly::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	constexpr bool bAllowShrinking = false;
+	return ActorsInternal.RemoveSwap(ActorInfo.Actor, bAllowShrinking) > 0;
+}
+
+// Is called when all actors are removed from the graph
+void UMyReplicationGraphNode_OwnerOnly::NotifyResetAllNetworkActors()
+{
+	ActorsInternal.Reset();
+	ConnectionListsInternal.Reset();
+}
+
+// Adds actors owned by the connection
+void UMyReplicationGraphNode_OwnerOnly::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	FActorRepListRefView& ConnectionList = ConnectionListsInternal.FindOrAdd(Params.ConnectionManager.NetConnection);
+	ConnectionList.Reset();
+
+	for (const FActorRepListType& ActorIt : ActorsInternal)
+	{
+		const UNetConnection* OwningConnection = ActorIt ? ActorIt->GetNetConnection() : nullptr;
+		if (!OwningConnection)
+		{
+			// Owner is not set yet
+			continue;
+		}
+
+		for (const FNetViewer& ViewerIt : Params.Viewers)
+		{
+			if (ViewerIt.Connection == OwningConnection)
+			{
+				ConnectionList.Add(ActorIt);
+				break;
+			}
+		}
+	}
+
+	if (ConnectionList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(ConnectionList);
+	}
+}
+
+/*********************************************************************************************
+ * UMyReplicationGraph
+ ********************************************************************************************* */
+
+// Returns true if the replication graph should be used by net drivers
+bool UMyReplicationGraph::IsReplicationGraphEnabled()
+{
+	return CVarReplicationGraph.GetValueOnAnyThread() != 0;
+}
+
+// Sets replication settings of all replicated classes
+void UMyReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Each replicated class keeps the update frequency of its default object, relevancy by distance is decided by nodes instead of cull distance
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (!ActorCDO
+		    || !ActorCDO->GetIsReplicated()
+		    || Class->HasAnyClassFlags(CLASS_Abstract)
+		    || Class->GetName().StartsWith(TEXT("SKEL_"))
+		    || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.SetCullDistanceSquared(0.f);
+		ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->NetUpdateFrequency);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+// Creates nodes that are shared by all connections
+void UMyReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	LevelGridNodeInternal = CreateNewNode<UMyReplicationGraphNode_LevelGrid>();
+	AddGlobalGraphNode(LevelGridNodeInternal);
+
+	AlwaysRelevantNodeInternal = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNodeInternal);
+
+	OwnerOnlyNodeInternal = CreateNewNode<UMyReplicationGraphNode_OwnerOnly>();
+	AddGlobalGraphNode(OwnerOnlyNodeInternal);
+}
+
+// Creates nodes of each connection
+void UMyReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// Player controller and its view target
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+// Adds new replicated actor into the node according its type
+void UMyReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const AActor* Actor = ActorInfo.Actor;
+	if (!Actor
+	    || IsConnectionActor(Actor))
+	{
+		// Is gathered by the connection's own node
+		return;
+	}
+
+	// Update frequency could be changed on the instance by the net policy of level actors
+	GlobalInfo.Settings.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(Actor->NetUpdateFrequency);
+
+	if (Actor->bOnlyRelevantToOwner)
+	{
+		OwnerOnlyNodeInternal->NotifyAddNetworkActor(ActorInfo);
+		return;
+	}
+
+	if (IsLevelGridActor(Actor))
+	{
+		LevelGridNodeInternal->NotifyAddNetworkActor(ActorInfo);
+		return;
+	}
+
+	// The Generated Map, players, game state, player states, always relevant level actors and the rest
+	AlwaysRelevantNodeInternal->NotifyAddNetworkActor(ActorInfo);
+}
+
+// Removes replicated actor from the node according its type
+void UMyReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	const AActor* Actor = ActorInfo.Actor;
+	if (!Actor
+	    || IsConnectionActor(Actor))
+	{
+		return;
+	}
+
+	if (Actor->bOnlyRelevantToOwner)
+	{
+		OwnerOnlyNodeInternal->NotifyRemoveNetworkActor(ActorInfo);
+		return;
+	}
+
+	// The actor could become always relevant after it was added, so it is looked up in the grid first
+	constexpr bool bWarnIfNotFound = false;
+	if (!LevelGridNodeInternal->NotifyRemoveNetworkActor(ActorInfo, bWarnIfNotFound))
+	{
+		AlwaysRelevantNodeInternal->NotifyRemoveNetworkActor(ActorInfo);
+	}
+}
+
+// Returns true if given actor is a level actor that is replicated by its cell
+bool UMyReplicationGraph::IsLevelGridActor(const AActor* Actor)
+{
+	// Players move freely and are always relevant since the whole level is visible
+	return UMapComponent::GetMapComponent(Actor)
+	       && !Actor->IsA<APlayerCharacter>()
+	       && !Actor->bAlwaysRelevant;
+}
+
+// Returns true if given actor is gathered by the per connection node of its owner
+bool UMyReplicationGraph::IsConnectionActor(const AActor* Actor)
+{
+	return Actor && Actor->IsA<APlayerController>();
+}
@@ -0,0 +1,108 @@
+﻿// Copyright (c) Yevhenii Selivanov.
+
+#include "Engine/StartupTimings.h"
+//---
+#include "Bomber.h"
+
+CSV_DEFINE_CATEGORY_MODULE(BOMBER_API, BomberStartup, true);
+
+namespace StartupTimings
+{
+/** Measured seconds of each phase in order of their first appearance. */
+static TArray<TPair<FName, double>> PhaseSeconds;
+
+/** Start time of phases that end asynchronously. */
+static TMap<FName, double> PendingPhases;
+
+/** Is set once the summary is printed. */
+static bool bSummaryPrinted = false;
+}
+
+// Starts measuring the scope
+FStartupTimings::FScope::FScope(FName InPhase)
+{
+	if (IsRecording())
+	{
+		Phase = InPhase;
+		StartSeconds = FPlatformTime::Seconds();
+	}
+}
+
+// Adds the time of the scope to its phase
+FStartupTimings::FScope::~FScope()
+{
+	if (!Phase.IsNone())
+	{
+		AddPhaseSeconds(Phase, FPlatformTime::Seconds() - StartSeconds);
+	}
+}
+
+// Adds the time to the specified phase, the same phase can be measured multiple times
+void FStartupTimings::AddPhaseSeconds(FName Phase, double Seconds)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	TPair<FName, double>* FoundPhase = StartupTimings::PhaseSeconds.FindByPredicate([Phase](const TPair<FName, double>& It) { return It.Key == Phase; });
+	if (FoundPhase)
+	{
+		FoundPhase->Value += Seconds;
+	}
+	else
+	{
+		StartupTimings::PhaseSeconds.Emplace(Phase, Seconds);
+	}
+}
+
+// Starts measuring the phase that ends asynchronously, e.g: map loading or game features activation
+void FStartupTimings::BeginPhase(FName Phase)
+{
+	if (IsRecording())
+	{
+		StartupTimings::PendingPhases.FindOrAdd(Phase, FPlatformTime::Seconds());
+	}
+}
+
+// Finishes measuring the phase started by BeginPhase, does nothing if it was not started
+void FStartupTimings::EndPhase(FName Phase)
+{
+	double StartSeconds = 0.0;
+	if (IsRecording()
+	    && StartupTimings::PendingPhases.RemoveAndCopyValue(Phase, StartSeconds))
+	{
+		AddPhaseSeconds(Phase, FPlatformTime::Seconds() - StartSeconds);
+	}
+}
+
+// Prints all measured phases and the total time since the launch, does it only once
+void FStartupTimings::PrintSummary()
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	StartupTimings::bSummaryPrinted = true;
+
+	UE_LOG(LogBomber, Log, TEXT("Startup timings: the Menu is reached in %.3f seconds since the launch"), FPlatformTime::Seconds() - GStartTime);
+	for (const TPair<FName, double>& It : StartupTimings::PhaseSeconds)
+	{
+		UE_LOG(LogBomber, Log, TEXT("\t%s: %.3f seconds"), *It.Key.ToString(), It.Value);
+	}
+
+	for (const TPair<FName, double>& It : StartupTimings::PendingPhases)
+	{
+		UE_LOG(LogBomber, Log, TEXT("\t%s: is not finished yet, %.3f seconds elapsed"), *It.Key.ToString(), FPlatformTime::Seconds() - It.Value);
+	}
+
+	StartupTimings::PhaseSeconds.Empty();
+	StartupTimings::PendingPhases.Empty();
+}
+
+// Returns true while the startup is measured, false after the summary is printed
+bool FStartupTimings::IsRecording()
+{
+	return !StartupTimings::bSummaryPrinted && IsInGameThread();
+}
@@ -7,11 +7,16 @@
 #include "Components/MapComponent.h"
 #include "Components/MyCameraComponent.h"
 #include "DataAssets/ItemDataAsset.h"
+#include "LevelActors/BombActor.h"
 #include "LevelActors/BoxActor.h"
 #include "LevelActors/PlayerCharacter.h"
+#include "Structures/LevelLayout.h"
+#include "UI/MyHUD.h"
 #include "UtilityLibraries/CellsUtilsLibrary.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
+#include "Net/Core/PushModel/PushModel.h"
+//---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MyCheatManager)
 
 // Returns bitmask from reverse bitmask in string
@@ -129,6 +134,7 @@ void UMyCheatManager::SetPowerups(int32 NewLevel)
 		PlayerCharacter->PowerupsInternal.BombN = NewLevel;
 		PlayerCharacter->PowerupsInternal.FireN = NewLevel;
 		PlayerCharacter->PowerupsInternal.SkateN = NewLevel;
+		MARK_PROPERTY_DIRTY_FROM_NAME(APlayerCharacter, PowerupsInternal, PlayerCharacter);
 		PlayerCharacter->ApplyPowerups();
 	}
 }
@@ -143,6 +149,15 @@ void UMyCheatManager::SetGodMode(bool bShouldEnable)
 	}
 }
 
+// Shows or hides the live performance overlay on the HUD
+void UMyCheatManager::SetPerfOverlayEnabled(bool bShouldEnable)
+{
+	if (AMyHUD* MyHUD = UMyBlueprintFunctionLibrary::GetMyHUD())
+	{
+		MyHUD->SetPerfOverlayEnabled(bShouldEnable);
+	}
+}
+
 // Shows coordinates of all level actors by specified types
 void UMyCheatManager::DisplayCells(const FString& ActorTypesString)
 {
@@ -177,6 +192,181 @@ void UMyCheatManager::SetLevelSize(const FString& LevelSize)
 	}
 }
 
+// Returns the full path of the layout file, the name without a path is put into the Saved/Levels folder
+static FString GetLevelLayoutPath(const FString& FilePath)
+{
+	FString FullPath = FPaths::IsRelative(FilePath) && FPaths::GetPath(FilePath).IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("Levels") / FilePath : FilePath;
+	if (FPaths::GetExtension(FullPath).IsEmpty())
+	{
+		FullPath += FLevelLayout::FileExtension;
+	}
+	return FullPath;
+}
+
+// Writes current layout of the level to the file, the name without a path is saved to the Saved/Levels folder
+void UMyCheatManager::ExportLevel(const FString& FilePath)
+{
+	AGeneratedMap::Get().ExportLevelLayout(GetLevelLayoutPath(FilePath));
+}
+
+// Spawns the level from the layout file without any generation, the name without a path is read from the Saved/Levels folder
+void UMyCheatManager::ImportLevel(const FString& FilePath)
+{
+	AGeneratedMap::Get().ImportLevelLayout(GetLevelLayoutPath(FilePath));
+}
+
+// Restores the running match from its last checkpoint
+void UMyCheatManager::RestoreMatch()
+{
+	AGeneratedMap::Get().RestoreMatchCheckpoint();
+}
+
+// Spawns given number of bombs on random free cells to reproduce the worst-case load
+void UMyCheatManager::SpawnBombs(int32 BombsNum)
+{
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	if (!GeneratedMap.HasAuthority()
+	    || BombsNum <= 0)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FCell> FreeCells = UCellsUtilsLibrary::GetAllEmptyCellsWithoutActors().Array();
+	const int32 SpawnsNum = FMath::Min(BombsNum, FreeCells.Num());
+	for (int32 Index = 0; Index < SpawnsNum; ++Index)
+	{
+		// Partial shuffle: pick the random cell from the rest of free cells
+		FreeCells.Swap(Index, FMath::RandRange(Index, FreeCells.Num() - 1));
+		GeneratedMap.SpawnActorByType(EAT::Bomb, FreeCells[Index], [](AActor* SpawnedActor)
+		{
+			CastChecked<ABombActor>(SpawnedActor)->InitBomb();
+		});
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Stress: requested %i of %i bombs in %.3f ms"), SpawnsNum, BombsNum, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+// Sets the maximum level of each powerup for all bots
+void UMyCheatManager::MaxBotsPowerups()
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 MaxItemsNum = UItemDataAsset::Get().GetMaxAllowedItemsNum();
+
+	int32 BotsNum = 0;
+	FMapComponents MapComponents;
+	AGeneratedMap::Get().GetMapComponents(MapComponents, TO_FLAG(EAT::Player));
+	for (const UMapComponent* MapComponentIt : MapComponents)
+	{
+		APlayerCharacter* PlayerCharacter = MapComponentIt ? MapComponentIt->GetOwner<APlayerCharacter>() : nullptr;
+		if (!PlayerCharacter
+		    || !PlayerCharacter->HasAuthority()
+		    || PlayerCharacter->IsPlayerControlled())
+		{
+			continue;
+		}
+
+		PlayerCharacter->PowerupsInternal.BombN = MaxItemsNum;
+		PlayerCharacter->PowerupsInternal.FireN = MaxItemsNum;
+		PlayerCharacter->PowerupsInternal.SkateN = MaxItemsNum;
+		MARK_PROPERTY_DIRTY_FROM_NAME(APlayerCharacter, PowerupsInternal, PlayerCharacter);
+		PlayerCharacter->ApplyPowerups();
+		++BotsNum;
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Stress: powerups of %i bots are set to %i in %.3f ms"), BotsNum, MaxItemsNum, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+// Spawns boxes on all free cells of the level
+void UMyCheatManager::FillBoxes()
+{
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	if (!GeneratedMap.HasAuthority())
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const FCells FreeCells = UCellsUtilsLibrary::GetAllEmptyCellsWithoutActors();
+	for (const FCell& CellIt : FreeCells)
+	{
+		GeneratedMap.SpawnActorByType(EAT::Box, CellIt);
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Stress: requested %i boxes in %.3f ms"), FreeCells.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+// Detonates all bombs on the level at once to trigger the map-wide chain reaction
+void UMyCheatManager::ChainReaction()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Bombs are collected first, since the map components are changed by detonations
+	FMapComponents MapComponents;
+	AGeneratedMap::Get().GetMapComponents(MapComponents, TO_FLAG(EAT::Bomb));
+	TArray<TWeakObjectPtr<ABombActor>, TInlineAllocator<32>> Bombs;
+	for (const UMapComponent* MapComponentIt : MapComponents)
+	{
+		Bombs.Emplace(MapComponentIt ? MapComponentIt->GetOwner<ABombActor>() : nullptr);
+	}
+
+	// Bombs exploded by the chain of previous ones are skipped by themselves
+	for (const TWeakObjectPtr<ABombActor>& BombIt : Bombs)
+	{
+		if (ABombActor* BombActor = BombIt.Get())
+		{
+			BombActor->DetonateBomb();
+		}
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Stress: %i bombs are detonated in %.3f ms"), Bombs.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+// Regenerates the level given number of times in a row
+void UMyCheatManager::Regenerate(int32 Times)
+{
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	if (!GeneratedMap.HasAuthority()
+	    || Times <= 0)
+	{
+		return;
+	}
+
+	// The layout is computed on the game thread, so each call measures the whole generation instead of only scheduling it
+	IConsoleVariable* AsyncLayoutCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Bomber.Level.AsyncLayout"));
+	const FString PrevAsyncLayout = AsyncLayoutCVar ? AsyncLayoutCVar->GetString() : FString();
+	if (AsyncLayoutCVar)
+	{
+		AsyncLayoutCVar->Set(false, ECVF_SetByCode);
+	}
+
+	double MinTime = MAX_dbl;
+	double MaxTime = 0.0;
+	double TotalTime = 0.0;
+	for (int32 Index = 0; Index < Times; ++Index)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		GeneratedMap.GenerateLevelActors();
+		const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+		MinTime = FMath::Min(MinTime, ElapsedTime);
+		MaxTime = FMath::Max(MaxTime, ElapsedTime);
+		TotalTime += ElapsedTime;
+	}
+
+	if (AsyncLayoutCVar)
+	{
+		AsyncLayoutCVar->Set(*PrevAsyncLayout, ECVF_SetByCode);
+	}
+
+	// The last applied generation is printed as well to show how its time is split
+	UE_LOG(LogBomber, Log, TEXT("Stress: regenerated %i times, min %.3f ms, avg %.3f ms, max %.3f ms, last generation %.3f ms (%i attempts, path check %.3f ms)"),
+	       Times, MinTime * 1000.0, TotalTime / Times * 1000.0, MaxTime * 1000.0,
+	       GeneratedMap.GetLastGenerationTime() * 1000.f, GeneratedMap.GetLastGenerationAttempts(), GeneratedMap.GetLastPathCheckTime() * 1000.f);
+}
+
 // Tweak the custom additive angle to affect the fit distance calculation from camera to the level
 void UMyCheatManager::FitViewAdditiveAngle(float InFitViewAdditiveAngle)
 {
@@ -5,8 +5,11 @@
 #include "Controllers/MyPlayerController.h"
 #include "GameFramework/MyGameStateBase.h"
 #include "GameFramework/MyPlayerState.h"
+#include "Subsystems/GridSpectatorSubsystem.h"
 #include "UI/MyHUD.h"
 //---
+#include "TimerManager.h"
+//---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MyGameModeBase)
 
 // Sets default values for this actor's properties
@@ -63,17 +66,36 @@ void AMyGameModeBase::PostLogin(APlayerController* NewPlayer)
 
 	if (APlayerState* PlayerState = MyPC->GetPlayerState<APlayerState>())
 	{
-		// Spectators are not supported
+		// Spectators receive the match as the stream of grid events, they are not playable
+		UGridSpectatorSubsystem* GridSpectatorSubsystem = UGridSpectatorSubsystem::GetGridSpectatorSubsystem(this);
+		if (GridSpectatorSubsystem
+		    && PlayerState->IsOnlyASpectator()
+		    && !MyPC->IsLocalController())
+		{
+			GridSpectatorSubsystem->AddSpectator(MyPC);
+			return;
+		}
+
 		PlayerState->SetIsOnlyASpectator(false);
 	}
 
 	PlayerControllersInternal.AddUnique(MyPC);
+
+	if (AMyGameStateBase* MyGameState = GetGameState<AMyGameStateBase>())
+	{
+		MyGameState->UpdateServerIdleState();
+	}
 }
 
 // Called when a Controller with a PlayerState leaves the game or is destroyed
 void AMyGameModeBase::Logout(AController* Exiting)
 {
 	AMyPlayerController* MyPC = Cast<AMyPlayerController>(Exiting);
+	if (UGridSpectatorSubsystem* GridSpectatorSubsystem = UGridSpectatorSubsystem::GetGridSpectatorSubsystem(this))
+	{
+		GridSpectatorSubsystem->RemoveSpectator(MyPC);
+	}
+
 	if (MyPC
 	    && MyPC->HasClientLoadedCurrentWorld())
 	{
@@ -81,6 +103,12 @@ void AMyGameModeBase::Logout(AController* Exiting)
 	}
 
 	Super::Logout(Exiting);
+
+	// The leaving controller is still counted as the player during logout, so check the idle state on next tick
+	if (AMyGameStateBase* MyGameState = GetGameState<AMyGameStateBase>())
+	{
+		GetWorldTimerManager().SetTimerForNextTick(MyGameState, &AMyGameStateBase::UpdateServerIdleState);
+	}
 }
 
 #if WITH_EDITOR
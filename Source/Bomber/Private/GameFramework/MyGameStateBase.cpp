@@ -2,18 +2,36 @@
 
 #include "GameFramework/MyGameStateBase.h"
 //---
+#include "Bomber.h"
 #include "GeneratedMap.h"
+#include "Components/MapComponent.h"
 #include "DataAssets/GameStateDataAsset.h"
+#include "Engine/BomberNetStats.h"
+#include "Engine/StartupTimings.h"
+#include "GameFramework/MyGameUserSettings.h"
 #include "GameFramework/MyPlayerState.h"
+#include "Subsystems/DataAssetsPreloadSubsystem.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "Subsystems/GridSimulationSubsystem.h"
 #include "Subsystems/SoundsSubsystem.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
 #include "GameFeaturesSubsystem.h"
 #include "TimerManager.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameModeBase.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MyGameStateBase)
 
+// The tick rate of the idle dedicated server
+static TAutoConsoleVariable<int32> CVarServerIdleTickRate(
+	TEXT("Bomber.Server.IdleTickRate"),
+	5,
+	TEXT("Max tick rate of the dedicated server in Menu, EndGame or without players, while level actors and bots do not tick: 0 (Do not throttle)"),
+	ECVF_Default);
+
 // Default constructor
 AMyGameStateBase::AMyGameStateBase()
 {
@@ -40,6 +58,44 @@ ECurrentGameState AMyGameStateBase::GetCurrentGameState()
 	return ECurrentGameState::None;
 }
 
+// Returns the left second of the 'Three-two-one-GO' timer, is computed locally from the replicated end time
+float AMyGameStateBase::GetStartingTimerSecondsRemain() const
+{
+	if (StartingTimerEndTimeInternal <= 0.0)
+	{
+		return 0.f;
+	}
+
+	return static_cast<float>(FMath::Max(StartingTimerEndTimeInternal - GetServerWorldTimeSeconds(), 0.0));
+}
+
+// Returns the left second to the end of the match, is computed locally from the replicated end time
+float AMyGameStateBase::GetInGameTimerSecondsRemain() const
+{
+	if (InGameTimerEndTimeInternal <= 0.0)
+	{
+		// The match is not started yet (or its end time is not replicated yet), so the whole round is remain
+		const bool bIsMatchStarting = CurrentGameStateInternal == ECGS::GameStarting || CurrentGameStateInternal == ECGS::InGame;
+		return bIsMatchStarting ? static_cast<float>(UGameStateDataAsset::Get().GetInGameCountdown()) : 0.f;
+	}
+
+	return static_cast<float>(FMath::Max(InGameTimerEndTimeInternal - GetServerWorldTimeSeconds(), 0.0));
+}
+
+// Moves the end of the match, so given seconds remain
+void AMyGameStateBase::SetInGameTimerSecondsRemain(float SecondsRemain)
+{
+	if (!HasAuthority()
+	    || SecondsRemain <= 0.f)
+	{
+		return;
+	}
+
+	InGameTimerEndTimeInternal = GetServerWorldTimeSeconds() + SecondsRemain;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, InGameTimerEndTimeInternal, this);
+	BOMBER_NET_STAT(GameStateCountdowns, sizeof(InGameTimerEndTimeInternal) * 8);
+}
+
 // Returns the AMyGameState::CurrentGameState property.
 void AMyGameStateBase::ServerSetGameState_Implementation(ECurrentGameState NewGameState)
 {
@@ -48,7 +104,21 @@ void AMyGameStateBase::ServerSetGameState_Implementation(ECurrentGameState NewGa
 		return;
 	}
 
+	// Enter the Menu only once all data assets are loaded, so it does not hitch on synchronous loads
+	UDataAssetsPreloadSubsystem* PreloadSubsystem = UDataAssetsPreloadSubsystem::GetDataAssetsPreloadSubsystem(this);
+	if (NewGameState == ECurrentGameState::Menu
+	    && PreloadSubsystem
+	    && !PreloadSubsystem->IsPreloaded())
+	{
+		PreloadSubsystem->CallOrWaitPreloaded(UDataAssetsPreloadSubsystem::FOnDataAssetsPreloaded::FDelegate::CreateWeakLambda(this, [this]()
+		{
+			ServerSetGameState(ECurrentGameState::Menu);
+		}));
+		return;
+	}
+
 	CurrentGameStateInternal = NewGameState;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CurrentGameStateInternal, this);
 	ApplyGameState();
 
 	// Update replicated state now, not waiting for the next tick
@@ -56,6 +126,100 @@ void AMyGameStateBase::ServerSetGameState_Implementation(ECurrentGameState NewGa
 	ForceNetUpdate();
 }
 
+// Throttles the dedicated server while it is idle: in the Menu or EndGame state or without connected players
+void AMyGameStateBase::UpdateServerIdleState()
+{
+	UWorld* World = GetWorld();
+	if (!HasAuthority()
+	    || !World
+	    || World->GetNetMode() != NM_DedicatedServer)
+	{
+		return;
+	}
+
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	const int32 IdleTickRate = CVarServerIdleTickRate.GetValueOnGameThread();
+	const bool bShouldBeIdle = IdleTickRate > 0
+	                           && (CurrentGameStateInternal == ECGS::Menu
+	                               || CurrentGameStateInternal == ECGS::EndGame
+	                               || !GameMode
+	                               || GameMode->GetNumPlayers() == 0);
+	if (bShouldBeIdle == bIsServerIdleInternal)
+	{
+		return;
+	}
+
+	bIsServerIdleInternal = bShouldBeIdle;
+	UNetDriver* NetDriver = World->GetNetDriver();
+	UGridSimulationSubsystem* GridSimulationSubsystem = UGridSimulationSubsystem::GetGridSimulationSubsystem(this);
+
+	if (!bShouldBeIdle)
+	{
+		// Restore everything at once, so the match starts at the full rate
+		if (NetDriver
+		    && ServerMaxTickRateInternal > 0)
+		{
+			NetDriver->SetNetServerMaxTickRate(ServerMaxTickRateInternal);
+		}
+
+		if (GridSimulationSubsystem)
+		{
+			GridSimulationSubsystem->SetSimulationPaused(false);
+		}
+
+		for (const TWeakObjectPtr<AActor>& ActorIt : IdlePausedActorsInternal)
+		{
+			if (AActor* Actor = ActorIt.Get())
+			{
+				Actor->SetActorTickEnabled(true);
+			}
+		}
+		IdlePausedActorsInternal.Reset();
+
+		UE_LOG(LogBomber, Log, TEXT("Server is active: tick rate is restored to %i"), ServerMaxTickRateInternal);
+		return;
+	}
+
+	if (NetDriver)
+	{
+		ServerMaxTickRateInternal = NetDriver->GetNetServerMaxTickRate();
+		NetDriver->SetNetServerMaxTickRate(IdleTickRate);
+	}
+
+	// Bots are updated by the AI phase of the simulation, so pausing it stops them as well
+	if (GridSimulationSubsystem)
+	{
+		GridSimulationSubsystem->SetSimulationPaused(true);
+	}
+
+	// Stop ticking of level actors, only ticking ones are remembered to be restored
+	FMapComponents MapComponents;
+	AGeneratedMap::Get(this).GetMapComponents(MapComponents, TO_FLAG(EAT::All));
+	for (const UMapComponent* MapComponentIt : MapComponents)
+	{
+		if (AActor* Owner = MapComponentIt ? MapComponentIt->GetOwner() : nullptr)
+		{
+			PauseTickWhileIdle(*Owner);
+		}
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Server is idle: tick rate is lowered from %i to %i, %i level actors stopped ticking"), ServerMaxTickRateInternal, IdleTickRate, IdlePausedActorsInternal.Num());
+}
+
+// Stops ticking of given level actor while the server is idle
+void AMyGameStateBase::PauseTickWhileIdle(AActor& LevelActor)
+{
+	if (!bIsServerIdleInternal
+	    || !LevelActor.IsActorTickEnabled())
+	{
+		// Only ticking actors are remembered to be restored
+		return;
+	}
+
+	LevelActor.SetActorTickEnabled(false);
+	IdlePausedActorsInternal.Emplace(&LevelActor);
+}
+
 /* ---------------------------------------------------
  *		Protected
  * --------------------------------------------------- */
@@ -65,9 +229,11 @@ void AMyGameStateBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Out
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ThisClass, CurrentGameStateInternal);
-	DOREPLIFETIME(ThisClass, StartingTimerSecRemainInternal);
-	DOREPLIFETIME(ThisClass, InGameTimerSecRemainInternal);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, CurrentGameStateInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, StartingTimerEndTimeInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, InGameTimerEndTimeInternal, Params);
 }
 
 // Called when the game starts
@@ -75,9 +241,18 @@ void AMyGameStateBase::BeginPlay()
 {
 	Super::BeginPlay();
 
-	if (HasAuthority())
+	// Characters of each match instance are destroyed on their own map, so deaths are listened on all of them
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	if (HasAuthority()
+	    && GeneratedMapSubsystem)
 	{
-		AGeneratedMap::Get().OnAnyCharacterDestroyed.AddDynamic(this, &ThisClass::OnAnyCharacterDestroyed);
+		for (AGeneratedMap* GeneratedMapIt : GeneratedMapSubsystem->GetGeneratedMaps())
+		{
+			if (GeneratedMapIt)
+			{
+				GeneratedMapIt->OnAnyCharacterDestroyed.AddUniqueDynamic(this, &ThisClass::OnAnyCharacterDestroyed);
+			}
+		}
 	}
 
 	SetGameFeaturesEnabled(true);
@@ -88,24 +263,117 @@ void AMyGameStateBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
+	if (const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this))
+	{
+		for (AGeneratedMap* GeneratedMapIt : GeneratedMapSubsystem->GetGeneratedMaps())
+		{
+			if (GeneratedMapIt)
+			{
+				GeneratedMapIt->OnAnyCharacterDestroyed.RemoveDynamic(this, &ThisClass::OnAnyCharacterDestroyed);
+			}
+		}
+	}
+
 	SetGameFeaturesEnabled(false);
 }
 
 // Updates current game state
 void AMyGameStateBase::ApplyGameState()
 {
+	// Is updated first, so listeners of GameStarting already run at the full rate
+	UpdateServerIdleState();
+
 	if (CurrentGameStateInternal == ECGS::GameStarting)
 	{
 		TriggerCountdowns();
 	}
+	else if (CurrentGameStateInternal == ECGS::Menu)
+	{
+		// The game is playable, show how long the startup was taken
+		FStartupTimings::PrintSummary();
+	}
+	else if (CurrentGameStateInternal == ECGS::InGame)
+	{
+		StartInGameCountdown();
+
+		// Tune the quality by the first seconds of the match if enabled
+		if (UMyGameUserSettings* MyGameUserSettings = UMyBlueprintFunctionLibrary::GetMyGameUserSettings())
+		{
+			MyGameUserSettings->RestartAutoScalability();
+		}
+	}
+
+	if (CurrentGameStateInternal != ECGS::InGame)
+	{
+		// The match is over, so frame times are not measured until the next one
+		if (UMyGameUserSettings* MyGameUserSettings = UMyBlueprintFunctionLibrary::GetMyGameUserSettings())
+		{
+			MyGameUserSettings->StopAutoScalability();
+		}
+	}
 
 	// Notify listeners
+	BroadcastGameStateListeners();
+
 	if (OnGameStateChanged.IsBound())
 	{
 		OnGameStateChanged.Broadcast(CurrentGameStateInternal);
 	}
 }
 
+// Returns the bucket of code listeners of specified class, creates it on first request
+AMyGameStateBase::FGameStateListenersBucket& AMyGameStateBase::FindOrAddGameStateListenersBucket(const UClass* ListenerClass)
+{
+	FGameStateListenersBucket* FoundBucket = GameStateListenersInternal.FindByPredicate([ListenerClass](const FGameStateListenersBucket& BucketIt)
+	{
+		return BucketIt.ListenerClass == ListenerClass;
+	});
+	if (FoundBucket)
+	{
+		return *FoundBucket;
+	}
+
+	FGameStateListenersBucket& AddedBucket = GameStateListenersInternal.AddDefaulted_GetRef();
+	AddedBucket.ListenerClass = ListenerClass;
+	return AddedBucket;
+}
+
+// Notifies all code listeners about the current game state, is called before OnGameStateChanged delegate
+void AMyGameStateBase::BroadcastGameStateListeners()
+{
+	// Listeners could spawn new ones during the broadcast, so only current ones are notified by indices
+	const int32 BucketsNum = GameStateListenersInternal.Num();
+	for (int32 BucketIndex = 0; BucketIndex < BucketsNum; ++BucketIndex)
+	{
+		FGameStateListenersBucket& Bucket = GameStateListenersInternal[BucketIndex];
+		Bucket.Listeners.RemoveAllSwap([&Bucket](const TWeakObjectPtr<UObject>& ListenerIt)
+		{
+			if (ListenerIt.IsValid())
+			{
+				return false;
+			}
+
+			Bucket.ListenerKeys.Remove(ListenerIt);
+			return true;
+		});
+
+		// Is copied since the bucket could be reallocated by a new one
+		const TFunction<void(UObject&, ECurrentGameState)> Callback = GameStateListenersInternal[BucketIndex].Callback;
+		const int32 ListenersNum = GameStateListenersInternal[BucketIndex].Listeners.Num();
+		for (int32 ListenerIndex = 0; ListenerIndex < ListenersNum; ++ListenerIndex)
+		{
+			UObject* Listener = GameStateListenersInternal[BucketIndex].Listeners[ListenerIndex].Get();
+			if (!Listener)
+			{
+				continue;
+			}
+
+			// Pooled listeners are notified as well, so they have the current state once are taken from the pool
+			Callback(*Listener, CurrentGameStateInternal);
+		}
+	}
+}
+
 // Called on the AMyGameState::CurrentGameState property updating.
 void AMyGameStateBase::OnRep_CurrentGameState()
 {
@@ -122,8 +390,12 @@ void AMyGameStateBase::TriggerCountdowns()
 		return;
 	}
 
-	StartingTimerSecRemainInternal = UGameStateDataAsset::Get().GetStartingCountdown();
-	InGameTimerSecRemainInternal = UGameStateDataAsset::Get().GetInGameCountdown();
+	// Only end times are replicated, clients compute remain seconds locally
+	StartingTimerEndTimeInternal = GetServerWorldTimeSeconds() + UGameStateDataAsset::Get().GetStartingCountdown();
+	InGameTimerEndTimeInternal = 0.0;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, StartingTimerEndTimeInternal, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, InGameTimerEndTimeInternal, this);
+	BOMBER_NET_STAT(GameStateCountdowns, sizeof(StartingTimerEndTimeInternal) * 8 + sizeof(InGameTimerEndTimeInternal) * 8);
 
 	constexpr bool bInLoop = true;
 	const float InRate = UGameStateDataAsset::Get().GetTickInterval();
@@ -132,6 +404,19 @@ void AMyGameStateBase::TriggerCountdowns()
 	USoundsSubsystem::Get().PlayStartGameCountdownSFX();
 }
 
+// Sets the end time of the match countdown once the In-Game state is started
+void AMyGameStateBase::StartInGameCountdown()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	InGameTimerEndTimeInternal = GetServerWorldTimeSeconds() + UGameStateDataAsset::Get().GetInGameCountdown();
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, InGameTimerEndTimeInternal, this);
+	BOMBER_NET_STAT(GameStateCountdowns, sizeof(InGameTimerEndTimeInternal) * 8);
+}
+
 // Is called each UGameStateDataAsset::TickInternal to count different time in the game
 void AMyGameStateBase::OnCountdownTimerTicked()
 {
@@ -164,8 +449,6 @@ void AMyGameStateBase::DecrementStartingCountdown()
 		return;
 	}
 
-	StartingTimerSecRemainInternal -= UGameStateDataAsset::Get().GetTickInterval();
-
 	if (IsStartingTimerElapsed())
 	{
 		ServerSetGameState(ECurrentGameState::InGame);
@@ -181,8 +464,7 @@ void AMyGameStateBase::DecrementInGameCountdown()
 		return;
 	}
 
-	InGameTimerSecRemainInternal -= UGameStateDataAsset::Get().GetTickInterval();
-
+	const float InGameTimerSecRemain = GetInGameTimerSecondsRemain();
 	if (IsInGameTimerElapsed())
 	{
 		ServerSetGameState(ECurrentGameState::EndGame);
@@ -190,9 +472,11 @@ void AMyGameStateBase::DecrementInGameCountdown()
 	else
 	{
 		// @todo JanSeliv baYkHels Adjust hardcoded value to match the duration of the EndGame SFX from meta sound
-		const float Tolerance = UGameStateDataAsset::Get().GetTickInterval() - World->GetDeltaSeconds();
+		// Play once the remain time crosses the sound duration since the previous tick
 		constexpr float SoundDuration = 10.f;
-		if (FMath::IsNearlyEqual(InGameTimerSecRemainInternal, SoundDuration, Tolerance))
+		const float PreviousSecRemain = InGameTimerSecRemain + UGameStateDataAsset::Get().GetTickInterval();
+		if (InGameTimerSecRemain <= SoundDuration
+		    && PreviousSecRemain > SoundDuration)
 		{
 			USoundsSubsystem::Get().PlayEndGameCountdownSFX();
 		}
@@ -255,7 +539,13 @@ void AMyGameStateBase::SetGameFeaturesEnabled(bool bEnable)
 		static const FGameFeaturePluginLoadComplete EmptyCallback{};
 		if (bEnable)
 		{
-			GameFeaturesSubsystem.LoadAndActivateGameFeaturePlugin(GameFeatureURL, EmptyCallback);
+			// Activation is asynchronous, so it is measured until the callback
+			const FName PhaseName = *FString::Printf(TEXT("GameFeature_%s"), *GameFeatureName.ToString());
+			FStartupTimings::BeginPhase(PhaseName);
+			GameFeaturesSubsystem.LoadAndActivateGameFeaturePlugin(GameFeatureURL, FStartupTimings::IsRecording() ? FGameFeaturePluginLoadComplete::CreateLambda([PhaseName](const UE::GameFeatures::FResult& Result)
+			{
+				FStartupTimings::EndPhase(PhaseName);
+			}) : EmptyCallback);
 		}
 		else
 		{
@@ -1,16 +1,87 @@
-// Copyright (c) Yevhenii Selivanov.
+﻿// Copyright (c) Yevhenii Selivanov.
 
 #include "GameFramework/MyGameUserSettings.h"
 //---
+#include "Bomber.h"
+#include "Engine/BombLatencyStats.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "UI/MyHUD.h"
 #include "UI/SettingsWidget.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
 #include "DynamicRHI.h"
+#include "RenderCore.h"
 #include "Engine/DataTable.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
 #include "Misc/ConfigCacheIni.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MyGameUserSettings)
 
+static TAutoConsoleVariable<float> CVarSettingsSaveDelay(
+	TEXT("Bomber.Settings.SaveDelay"),
+	1.f,
+	TEXT("Seconds without new changes before requested settings are written to config: 0 (Save on the next frame)"),
+	ECVF_Default);
+
+// Auto scalability measures frames during the window, then waits the interval before the next one
+namespace AutoScalability
+{
+	static constexpr float SampleWindowSeconds = 5.f;
+	static constexpr float SampleIntervalSeconds = 30.f;
+
+	// The quality is lowered if the average frame is longer than the target by this ratio, and raised if shorter
+	static constexpr float LowerQualityRatio = 1.1f;
+	static constexpr float RaiseQualityRatio = 0.7f;
+}
+
+// Console variables and screen percentages that are set by the upscaler modes
+namespace UpscalerSettings
+{
+	// 4 is TSR
+	static constexpr int32 TSRMethod = 4;
+
+	// The internal resolution of each upscaler mode in percents of the screen resolution
+	static constexpr float ScreenPercentages[] = {100.f, 67.f, 58.f, 50.f};
+	static constexpr int32 ModesNum = UE_ARRAY_COUNT(ScreenPercentages);
+	static_assert(ModesNum == static_cast<int32>(EUpscalerMode::Performance) + 1, "Each upscaler mode has to have its screen percentage");
+
+	// 1 enables the dynamic resolution if it is enabled by game user settings
+	static constexpr int32 DynamicResByGameUserSettings = 1;
+
+	static constexpr float MinFrameBudgetMs = 4.f;
+	static constexpr float MaxFrameBudgetMs = 100.f;
+	static constexpr float MinScreenPercentage = 10.f;
+}
+
+// Console variables that are set by the low latency mode, each one is skipped if is not registered on this platform or RHI
+namespace LowLatencyMode
+{
+	// 1 lets the game thread run one frame ahead of the render thread, 0 waits for it
+	static const TCHAR* OneFrameThreadLag = TEXT("r.OneFrameThreadLag");
+
+	// 0 syncs the game thread with the render thread, 1 with the RHI thread, so the GPU has no frame queued ahead
+	static const TCHAR* GTSyncType = TEXT("r.GTSyncType");
+
+	// Is registered by the Streamline plugin only
+	static const TCHAR* ReflexEnable = TEXT("t.Streamline.Reflex.Enable");
+
+	/** Sets given console variable with the same priority as game user settings, returns false if it is not registered.
+	 * Is shared with the upscaler settings, so the value is either int32 or float. */
+	template <typename TValue>
+	static bool SetCVar(const TCHAR* Name, TValue Value)
+	{
+		IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(Name);
+		if (!CVar)
+		{
+			return false;
+		}
+
+		CVar->Set(Value, ECVF_SetByGameSetting);
+		return true;
+	}
+}
+
 // Returns the game user settings
 UMyGameUserSettings& UMyGameUserSettings::Get()
 {
@@ -24,6 +95,26 @@ void UMyGameUserSettings::ValidateSettings()
 {
 	Super::ValidateSettings();
 
+	// Validate auto scalability bounds
+	AutoTargetFPSInternal = FMath::Max(AutoTargetFPSInternal, 1);
+	AutoFallbackFPSInternal = FMath::Clamp(AutoFallbackFPSInternal, 1, AutoTargetFPSInternal);
+	AutoQualityBoundsInternal.X = FMath::Clamp(AutoQualityBoundsInternal.X, 1, 5);
+	AutoQualityBoundsInternal.Y = FMath::Clamp(AutoQualityBoundsInternal.Y, AutoQualityBoundsInternal.X, 5);
+	if (bAutoScalabilityInternal
+	    && OverallQualityInternal)
+	{
+		// Keep last tuned quality, but within bounds
+		SetOverallScalabilityLevel(FMath::Clamp(OverallQualityInternal, AutoQualityBoundsInternal.X, AutoQualityBoundsInternal.Y));
+	}
+
+	// Validate upscaler and dynamic resolution
+	if (static_cast<int32>(UpscalerModeInternal) >= UpscalerSettings::ModesNum)
+	{
+		UpscalerModeInternal = EUpscalerMode::Native;
+	}
+	DynamicResolutionFrameBudgetMsInternal = FMath::Clamp(DynamicResolutionFrameBudgetMsInternal, UpscalerSettings::MinFrameBudgetMs, UpscalerSettings::MaxFrameBudgetMs);
+	DynamicResolutionMinScreenPercentageInternal = FMath::Clamp(DynamicResolutionMinScreenPercentageInternal, UpscalerSettings::MinScreenPercentage, 100.f);
+
 	// Validate resolution
 	if (IntResolutionsInternal.IsValidIndex(CurrentResolutionIndexInternal))
 	{
@@ -76,6 +167,91 @@ void UMyGameUserSettings::ConfirmVideoMode()
 	Super::ConfirmVideoMode();
 }
 
+// Saves settings once no other change is requested during the quiet period
+void UMyGameUserSettings::RequestSaveSettings(UObject* ConfigObject)
+{
+	if (ConfigObject && ConfigObject != this)
+	{
+		PendingSaveObjectsInternal.AddUnique(ConfigObject);
+	}
+
+	// Every new change restarts the quiet period
+	PendingSaveSecondsInternal = FMath::Max(CVarSettingsSaveDelay.GetValueOnGameThread(), 0.f);
+
+	if (!SaveTickerHandleInternal.IsValid())
+	{
+		SaveTickerHandleInternal = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnSaveSettingsTick));
+	}
+}
+
+// Saves requested settings right away if the quiet period is not finished yet
+void UMyGameUserSettings::FlushPendingSave()
+{
+	if (!SaveTickerHandleInternal.IsValid())
+	{
+		return;
+	}
+
+	FTSTicker::GetCoreTicker().RemoveTicker(SaveTickerHandleInternal);
+	SaveTickerHandleInternal.Reset();
+
+	for (const TWeakObjectPtr<UObject>& ConfigObjectIt : PendingSaveObjectsInternal)
+	{
+		if (UObject* ConfigObject = ConfigObjectIt.Get())
+		{
+			ConfigObject->SaveConfig();
+		}
+	}
+	PendingSaveObjectsInternal.Empty();
+
+	SaveSettings();
+}
+
+// Is called every frame while the save is pending to count down the quiet period
+bool UMyGameUserSettings::OnSaveSettingsTick(float DeltaTime)
+{
+	PendingSaveSecondsInternal -= DeltaTime;
+	if (PendingSaveSecondsInternal > 0.f)
+	{
+		return true;
+	}
+
+	FlushPendingSave();
+
+	// The ticker is already removed by the flush
+	return false;
+}
+
+// Get all supported resolutions of the primary monitor in the text format, are enumerated on first request
+void UMyGameUserSettings::GetTextResolutions(TArray<FText>& OutTextResolutions)
+{
+	TryUpdateSupportedResolutions();
+	OutTextResolutions = TextResolutionsInternal;
+}
+
+// Get all supported resolutions of the primary monitor in the int point format, are enumerated on first request
+void UMyGameUserSettings::GetIntResolutions(TArray<FIntPoint>& OutIntResolutions)
+{
+	TryUpdateSupportedResolutions();
+	OutIntResolutions = IntResolutionsInternal;
+}
+
+// Returns the index of chosen resolution, resolutions are enumerated on first request
+int32 UMyGameUserSettings::GetResolutionIndex()
+{
+	TryUpdateSupportedResolutions();
+	return CurrentResolutionIndexInternal;
+}
+
+// Enumerates supported resolutions only if it was not done before
+void UMyGameUserSettings::TryUpdateSupportedResolutions()
+{
+	if (IntResolutionsInternal.IsEmpty())
+	{
+		UpdateSupportedResolutions();
+	}
+}
+
 // Get all supported resolutions of the primary monitor
 void UMyGameUserSettings::UpdateSupportedResolutions()
 {
@@ -167,6 +343,8 @@ void UMyGameUserSettings::UpdateSupportedResolutions()
 // Set new resolution by index
 void UMyGameUserSettings::SetResolutionByIndex(int32 Index)
 {
+	TryUpdateSupportedResolutions();
+
 	if (!IntResolutionsInternal.IsValidIndex(Index)
 	    || GetResolutionIndex() == Index)
 	{
@@ -202,7 +380,9 @@ void UMyGameUserSettings::SetFullscreenEnabled(bool bIsFullscreen)
 // Update fullscreen mode on UI for cases when it's changed outside (e.g. by Alt+Enter)
 void UMyGameUserSettings::UpdateFullscreenEnabled()
 {
-	USettingsWidget* SettingsWidget = UMyBlueprintFunctionLibrary::GetSettingsWidget();
+	// Do not create the settings widget just to update it, it reads current values on construction
+	const AMyHUD* MyHUD = UMyBlueprintFunctionLibrary::GetMyHUD();
+	USettingsWidget* SettingsWidget = MyHUD ? MyHUD->GetSettingsWidget() : nullptr;
 	if (!SettingsWidget)
 	{
 		return;
@@ -222,60 +402,375 @@ void UMyGameUserSettings::UpdateFullscreenEnabled()
 // Set the FPS cap by specified member index
 void UMyGameUserSettings::SetFPSLockByIndex(int32 Index)
 {
-	const USettingsWidget* SettingsWidget = UMyBlueprintFunctionLibrary::GetSettingsWidget();
-	if (!SettingsWidget
-	    || GetFPSLockIndex() == Index)
+	if (GetFPSLockIndex() == Index)
+	{
+		return;
+	}
+
+	const int32 MaxFPS = GetFPSLockByIndex(Index);
+	if (MaxFPS == INDEX_NONE)
 	{
 		return;
 	}
 
+	// The choice is kept, but the lock is applied only when is not tuned automatically
+	if (!bAutoScalabilityInternal)
+	{
+		// 0 disables frame rate limiting
+		ApplyFrameRateLimit(MaxFPS);
+	}
+
+	FPSLockIndexInternal = Index;
+}
+
+// Returns the frame rate of the FPS lock by specified member index
+int32 UMyGameUserSettings::GetFPSLockByIndex(int32 Index) const
+{
+	const USettingsWidget* SettingsWidget = UMyBlueprintFunctionLibrary::GetSettingsWidget();
+	if (!SettingsWidget)
+	{
+		return INDEX_NONE;
+	}
+
 	static const FSettingFunctionPicker ThisFunction(GetClass(), GET_FUNCTION_NAME_CHECKED(ThisClass, SetFPSLockByIndex));
 	const FSettingTag& FPSLockTag = SettingsWidget->GetTagByFunction(ThisFunction);
 	if (!FPSLockTag.IsValid())
 	{
-		return;
+		return INDEX_NONE;
 	}
 
 	TArray<FText> ComboboxMembers;
 	SettingsWidget->GetComboboxMembers(FPSLockTag, ComboboxMembers);
 	if (!ComboboxMembers.IsValidIndex(Index))
 	{
-		return;
+		return INDEX_NONE;
 	}
 
-	auto SetFPSLock = [&](int32 MaxFPS)
-	{
-		// 0 disables frame rate limiting
-		SetFrameRateLimit(MaxFPS);
-		SetFrameRateLimitCVar(MaxFPS);
-
-		FPSLockIndexInternal = Index;
-	};
-
-	// If numeric like '144', then set and return
+	// If numeric like '144', then return it
 	const FString& StrMaxFPS = ComboboxMembers[Index].ToString();
 	if (StrMaxFPS.IsNumeric())
 	{
-		const int32 MaxFPS = FCString::Atoi(*StrMaxFPS);
-		SetFPSLock(MaxFPS);
-		return;
+		return FCString::Atoi(*StrMaxFPS);
 	}
 
-	// If numeric contains in the string like '144 FPS', then extract '144', set and return
+	// If numeric contains in the string like '144 FPS', then extract '144' and return it
 	static const FString SpaceDelimiter = TEXT(" ");
 	TArray<FString> StringArray;
 	StrMaxFPS.ParseIntoArray(StringArray, *SpaceDelimiter);
 	const FString* FoundNumericStr = StringArray.FindByPredicate([](const FString& StrIt) { return StrIt.IsNumeric(); });
 	if (FoundNumericStr)
 	{
-		const int32 MaxFPS = FCString::Atoi(**FoundNumericStr);
-		SetFPSLock(MaxFPS);
-		return;
+		return FCString::Atoi(**FoundNumericStr);
 	}
 
 	// It is not a numeric member, uncap FPS
 	static constexpr int32 UncappedFPS = 0;
-	SetFPSLock(UncappedFPS);
+	return UncappedFPS;
+}
+
+// Set true to tune the overall quality and FPS lock automatically to hold the target frame rate
+void UMyGameUserSettings::SetAutoScalabilityEnabled(bool bIsEnabled)
+{
+	if (bAutoScalabilityInternal == bIsEnabled)
+	{
+		return;
+	}
+
+	bAutoScalabilityInternal = bIsEnabled;
+
+	if (bIsEnabled)
+	{
+		// Frame times are measured only during the match, otherwise it is started on next match
+		if (AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame)
+		{
+			RestartAutoScalability();
+		}
+		return;
+	}
+
+	StopAutoScalability();
+
+	// Return the FPS lock chosen by the user
+	const int32 ChosenFPSLockIndex = FPSLockIndexInternal;
+	FPSLockIndexInternal = INDEX_NONE;
+	SetFPSLockByIndex(ChosenFPSLockIndex);
+	if (FPSLockIndexInternal == INDEX_NONE)
+	{
+		// Settings widget is not created yet, the lock will be applied by it
+		FPSLockIndexInternal = ChosenFPSLockIndex;
+	}
+}
+
+// Applies all settings besides resolution ones, the upscaler and dynamic resolution are applied after the scalability
+void UMyGameUserSettings::ApplyNonResolutionSettings()
+{
+	Super::ApplyNonResolutionSettings();
+
+	// The saved limit is applied unpaced by the engine, so cap it below the refresh rate again
+	SetFrameRateLimitCVar(GetPacedFrameRateLimit(FMath::RoundToInt(GetFrameRateLimit())));
+
+	// Is applied after the scalability, so its screen percentage is overridden by the chosen upscaler mode
+	ApplyUpscalerSettings();
+}
+
+// Set and apply the upscaler mode by its index
+void UMyGameUserSettings::SetUpscalerModeByIndex(int32 Index)
+{
+	if (Index == GetUpscalerModeIndex()
+	    || !FMath::IsWithin(Index, 0, UpscalerSettings::ModesNum))
+	{
+		return;
+	}
+
+	UpscalerModeInternal = static_cast<EUpscalerMode>(Index);
+	ApplyUpscalerSettings();
+}
+
+// Set and apply the frame time in milliseconds the dynamic resolution tries to hold
+void UMyGameUserSettings::SetDynamicResolutionFrameBudgetMs(float InFrameBudgetMs)
+{
+	const float NewFrameBudgetMs = FMath::Clamp(InFrameBudgetMs, UpscalerSettings::MinFrameBudgetMs, UpscalerSettings::MaxFrameBudgetMs);
+	if (FMath::IsNearlyEqual(NewFrameBudgetMs, DynamicResolutionFrameBudgetMsInternal))
+	{
+		return;
+	}
+
+	DynamicResolutionFrameBudgetMsInternal = NewFrameBudgetMs;
+	ApplyUpscalerSettings();
+}
+
+// Set and apply the dynamic resolution that drops the internal resolution while frames are slower than the budget
+void UMyGameUserSettings::SetDynamicResolutionEnabledNow(bool bIsEnabled)
+{
+	if (IsDynamicResolutionEnabled() == bIsEnabled)
+	{
+		return;
+	}
+
+	SetDynamicResolutionEnabled(bIsEnabled);
+
+	// The engine switches the dynamic resolution state on the next frame
+	if (GEngine)
+	{
+		GEngine->SetDynamicResolutionUserSetting(bIsEnabled);
+	}
+
+	ApplyUpscalerSettings();
+}
+
+// Applies console variables of the chosen upscaler mode and the dynamic resolution bounds
+void UMyGameUserSettings::ApplyUpscalerSettings()
+{
+	using namespace UpscalerSettings;
+	const float MaxScreenPercentage = ScreenPercentages[FMath::Clamp(GetUpscalerModeIndex(), 0, ModesNum - 1)];
+
+	using LowLatencyMode::SetCVar;
+	SetCVar(TEXT("r.AntiAliasingMethod"), TSRMethod);
+	SetCVar(TEXT("r.ScreenPercentage"), MaxScreenPercentage);
+
+	// The dynamic resolution moves between the min percentage and the one of upscaler mode
+	SetCVar(TEXT("r.DynamicRes.OperationMode"), DynamicResByGameUserSettings);
+	SetCVar(TEXT("r.DynamicRes.FrameTimeBudget"), DynamicResolutionFrameBudgetMsInternal);
+	SetCVar(TEXT("r.DynamicRes.MinScreenPercentage"), FMath::Min(DynamicResolutionMinScreenPercentageInternal, MaxScreenPercentage));
+	SetCVar(TEXT("r.DynamicRes.MaxScreenPercentage"), MaxScreenPercentage);
+}
+
+// Set true to reduce queued frames and pace them slightly below the refresh rate
+void UMyGameUserSettings::SetLowLatencyModeEnabled(bool bIsEnabled)
+{
+	if (bLowLatencyModeInternal == bIsEnabled)
+	{
+		return;
+	}
+
+	if (FBombLatencyStats::IsEnabled())
+	{
+		// Report latencies of the previous mode, so both modes can be compared
+		FBombLatencyStats::Dump();
+		FBombLatencyStats::Reset();
+	}
+
+	bLowLatencyModeInternal = bIsEnabled;
+
+	ApplyLowLatencyMode();
+
+	// Cap or uncap the current lock by the refresh rate
+	ApplyFrameRateLimit(RequestedFrameRateLimitInternal);
+}
+
+// Starts measuring frame times from scratch, is called on match start
+void UMyGameUserSettings::RestartAutoScalability()
+{
+	if (!bAutoScalabilityInternal)
+	{
+		return;
+	}
+
+	StartAutoScalabilityWindow();
+	ApplyFrameRateLimit(AutoTargetFPSInternal);
+}
+
+// Stops measuring frame times until the next restart
+void UMyGameUserSettings::StopAutoScalability()
+{
+	if (AutoScalabilityTickerHandleInternal.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(AutoScalabilityTickerHandleInternal);
+		AutoScalabilityTickerHandleInternal.Reset();
+	}
+}
+
+// Starts the per-frame sampling of the next window from scratch
+void UMyGameUserSettings::StartAutoScalabilityWindow()
+{
+	StopAutoScalability();
+
+	AutoSampledFrameMsInternal = 0.0;
+	AutoSampledFramesNumInternal = 0;
+	AutoSampleElapsedSecondsInternal = 0.f;
+	AutoScalabilityTickerHandleInternal = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnAutoScalabilityTick));
+}
+
+// Is called every frame during the sampling window to measure frame times, is removed once the window is finished
+bool UMyGameUserSettings::OnAutoScalabilityTick(float DeltaTime)
+{
+	AutoSampleElapsedSecondsInternal += DeltaTime;
+
+	// The busiest of game, render and GPU work, so the measure is not hidden by the FPS lock
+	const uint32 BusiestCycles = FMath::Max3(GGameThreadTime, GRenderThreadTime, RHIGetGPUFrameCycles());
+	AutoSampledFrameMsInternal += FPlatformTime::ToMilliseconds(BusiestCycles);
+	++AutoSampledFramesNumInternal;
+
+	if (AutoSampleElapsedSecondsInternal >= AutoScalability::SampleWindowSeconds)
+	{
+		const float AverageFrameMs = static_cast<float>(AutoSampledFrameMsInternal / FMath::Max(AutoSampledFramesNumInternal, 1));
+		ApplyAutoScalability(AverageFrameMs);
+
+		// Nothing is ticked until the next window, the handle is replaced, so this ticker is just removed
+		AutoScalabilityTickerHandleInternal = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float)
+		{
+			AutoScalabilityTickerHandleInternal.Reset();
+			StartAutoScalabilityWindow();
+			return false;
+		}), AutoScalability::SampleIntervalSeconds);
+		return false;
+	}
+
+	return true;
+}
+
+// Moves the overall quality or FPS lock by given average frame time of the finished window
+void UMyGameUserSettings::ApplyAutoScalability(float AverageFrameMs)
+{
+	const float TargetFrameMs = 1000.f / AutoTargetFPSInternal;
+	const int32 CurrentQuality = FMath::Clamp(OverallQualityInternal ? OverallQualityInternal : GetOverallScalabilityLevel(), AutoQualityBoundsInternal.X, AutoQualityBoundsInternal.Y);
+	const bool bIsFallbackLocked = FMath::IsNearlyEqual(GetFrameRateLimit(), static_cast<float>(AutoFallbackFPSInternal));
+
+	int32 NewQuality = CurrentQuality;
+	int32 NewFPSLock = bIsFallbackLocked ? AutoFallbackFPSInternal : AutoTargetFPSInternal;
+	if (AverageFrameMs > TargetFrameMs * AutoScalability::LowerQualityRatio)
+	{
+		if (CurrentQuality > AutoQualityBoundsInternal.X)
+		{
+			--NewQuality;
+		}
+		else
+		{
+			// Can't hold the target even on min quality
+			NewFPSLock = AutoFallbackFPSInternal;
+		}
+	}
+	else if (AverageFrameMs < TargetFrameMs * AutoScalability::RaiseQualityRatio)
+	{
+		if (bIsFallbackLocked)
+		{
+			// Try the target frame rate first
+			NewFPSLock = AutoTargetFPSInternal;
+		}
+		else if (CurrentQuality < AutoQualityBoundsInternal.Y)
+		{
+			++NewQuality;
+		}
+	}
+
+	const bool bQualityChanged = NewQuality != OverallQualityInternal;
+	if (bQualityChanged)
+	{
+		SetOverallScalabilityLevel(NewQuality);
+		ApplyNonResolutionSettings();
+	}
+
+	const bool bFPSLockChanged = NewFPSLock != (bIsFallbackLocked ? AutoFallbackFPSInternal : AutoTargetFPSInternal);
+	if (bFPSLockChanged)
+	{
+		ApplyFrameRateLimit(NewFPSLock);
+	}
+
+	if (bQualityChanged || bFPSLockChanged)
+	{
+		// Persist the tuned result, so the next session starts from it
+		RequestSaveSettings();
+	}
+}
+
+// Locks the frame rate without changing the chosen FPS lock index
+void UMyGameUserSettings::ApplyFrameRateLimit(int32 MaxFPS)
+{
+	RequestedFrameRateLimitInternal = MaxFPS;
+
+	// The requested limit is saved, so the paced cap never replaces it in config
+	SetFrameRateLimit(MaxFPS);
+	SetFrameRateLimitCVar(GetPacedFrameRateLimit(MaxFPS));
+}
+
+// Returns given frame rate capped below the refresh rate in the low latency mode
+int32 UMyGameUserSettings::GetPacedFrameRateLimit(int32 MaxFPS) const
+{
+	const int32 RefreshRate = bLowLatencyModeInternal ? GetDisplayRefreshRate() : 0;
+	if (RefreshRate <= LowLatencyFPSMarginInternal)
+	{
+		return MaxFPS;
+	}
+
+	// Frames rendered faster than the display shows them wait in the queue, so under-target the refresh rate
+	const int32 PacedFPS = RefreshRate - LowLatencyFPSMarginInternal;
+	return MaxFPS > 0 ? FMath::Min(MaxFPS, PacedFPS) : PacedFPS;
+}
+
+// Applies render queue console variables of the current low latency mode
+void UMyGameUserSettings::ApplyLowLatencyMode()
+{
+	using namespace LowLatencyMode;
+	const bool bIsEnabled = bLowLatencyModeInternal;
+	SetCVar(OneFrameThreadLag, bIsEnabled ? 0 : 1);
+	SetCVar(GTSyncType, bIsEnabled ? 1 : 0);
+
+	// 1 is the low latency without the boost of GPU clocks
+	const bool bHasReflex = SetCVar(ReflexEnable, bIsEnabled ? 1 : 0);
+
+	UE_LOG(LogBomber, Log, TEXT("Low latency mode is %s%s"), bIsEnabled ? TEXT("enabled") : TEXT("disabled"), bHasReflex ? TEXT(" with Reflex") : TEXT(""));
+}
+
+// Returns the highest refresh rate of current resolution, 0 if unknown
+int32 UMyGameUserSettings::GetDisplayRefreshRate() const
+{
+	FScreenResolutionArray ResolutionsArray;
+	if (!RHIGetAvailableResolutions(ResolutionsArray, true))
+	{
+		return 0;
+	}
+
+	const FIntPoint CurrentResolution = GetScreenResolution();
+	int32 RefreshRate = 0;
+	for (const FScreenResolutionRHI& ResolutionIt : ResolutionsArray)
+	{
+		if (static_cast<int32>(ResolutionIt.Width) == CurrentResolution.X
+		    && static_cast<int32>(ResolutionIt.Height) == CurrentResolution.Y)
+		{
+			RefreshRate = FMath::Max(RefreshRate, static_cast<int32>(ResolutionIt.RefreshRate));
+		}
+	}
+	return RefreshRate;
 }
 
 // Loads the user settings from persistent storage
@@ -293,15 +788,23 @@ void UMyGameUserSettings::LoadSettings(bool bForceReload)
 		GConfig->GetInt(*Section, TEXT("MinWindowHeight"), MinResolutionSizeYInternal, GGameIni);
 	}
 
-	if (!IntResolutionsInternal.Num())
-	{
-		UpdateSupportedResolutions();
-	}
-
 	constexpr float NoBenchmarkRun = -1.f;
 	if (GetLastGPUBenchmarkResult() == NoBenchmarkRun)
 	{
 		RunHardwareBenchmark();
 		ApplyHardwareBenchmarkResults();
 	}
+
+	ApplyLowLatencyMode();
+
+	if (bAutoScalabilityInternal)
+	{
+		// Continue from the last tuned result saved to config
+		ApplyFrameRateLimit(GetFrameRateLimit() > 0.f ? FMath::RoundToInt(GetFrameRateLimit()) : AutoTargetFPSInternal);
+		return;
+	}
+
+	// Restore the unpaced lock chosen by the user, the saved limit is used until the settings widget is created
+	const int32 ChosenFPSLock = GetFPSLockByIndex(FPSLockIndexInternal);
+	ApplyFrameRateLimit(ChosenFPSLock != INDEX_NONE ? ChosenFPSLock : FMath::RoundToInt(GetFrameRateLimit()));
 }
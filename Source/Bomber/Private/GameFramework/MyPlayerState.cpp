@@ -7,6 +7,7 @@
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Kismet/KismetSystemLibrary.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MyPlayerState)
@@ -33,6 +34,7 @@ void AMyPlayerState::SetPlayerNameCustom(FName NewName)
 
 	bUseCustomPlayerNames = true;
 	CustomPlayerNameInternal = NewName;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CustomPlayerNameInternal, this);
 
 	SetPlayerName(NewName.ToString());
 
@@ -60,8 +62,10 @@ void AMyPlayerState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLi
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ThisClass, EndGameStateInternal);
-	DOREPLIFETIME(ThisClass, CustomPlayerNameInternal);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, EndGameStateInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, CustomPlayerNameInternal, Params);
 }
 
 // Called when the game starts
@@ -74,7 +78,7 @@ void AMyPlayerState::BeginPlay()
 		// Listen states
 		if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 		{
-			MyGameState->OnGameStateChanged.AddDynamic(this, &ThisClass::OnGameStateChanged);
+			MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 			// Handle current game state if initialized with delay
 			if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -166,6 +170,7 @@ void AMyPlayerState::MulticastSetEndGameState_Implementation(EEndGameState NewEn
 	}
 
 	EndGameStateInternal = NewEndGameState;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, EndGameStateInternal, this);
 
 	if (OnEndGameStateChanged.IsBound())
 	{
@@ -3,23 +3,46 @@
 #include "GeneratedMap.h"
 //---
 #include "PoolManagerSubsystem.h"
+#include "Components/InstancedLevelMeshesComponent.h"
 #include "Components/MapComponent.h"
 #include "Components/MyCameraComponent.h"
 #include "DataAssets/DataAssetsContainer.h"
 #include "DataAssets/GeneratedMapDataAsset.h"
+#include "DataAssets/LevelActorDataAsset.h"
+#include "Engine/BombLatencyStats.h"
+#include "Engine/BomberNetStats.h"
+#include "Engine/BomberPerfBudget.h"
+#include "Engine/BomberTelemetry.h"
+#include "Engine/FrameSpikeCapture.h"
+#include "Engine/StartupTimings.h"
 #include "GameFramework/MyGameStateBase.h"
 #include "LevelActors/BombActor.h"
+#include "LevelActors/ItemActor.h"
+#include "LevelActors/PlayerCharacter.h"
 #include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/CosmeticEventsSubsystem.h"
 #include "Subsystems/GeneratedMapSubsystem.h"
+#include "Subsystems/GridReplaySubsystem.h"
+#include "Subsystems/GridSpectatorSubsystem.h"
+#include "Structures/LevelLayout.h"
+#include "Structures/MatchSnapshot.h"
+#include "Subsystems/MatchPerformanceSubsystem.h"
 #include "UtilityLibraries/CellsUtilsLibrary.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
+#include "Async/Async.h"
 #include "Components/GameFrameworkComponentManager.h"
 #include "Engine/LevelStreaming.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StreamableRenderAsset.h"
 #include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GenericPlatform/GenericPlatformChunkInstall.h"
 #include "Kismet/GameplayStatics.h"
 #include "Math/UnrealMathUtility.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "TimerManager.h"
 //---
 #if WITH_EDITOR
 #include "MyUnrealEdEngine.h"
@@ -33,6 +56,60 @@
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(GeneratedMap)
 
+// Load all streaming levels in background on starting the game
+static TAutoConsoleVariable<bool> CVarPreloadLevelTypes(
+	TEXT("Bomber.Level.PreloadLevelTypes"),
+	true,
+	TEXT("Load all level types hidden in background on starting the game: 1 (Preload) OR 0 (Load on switching)"),
+	ECVF_Default);
+
+// How long meshes of preloaded level types are kept fully streamed in
+static TAutoConsoleVariable<float> CVarPrestreamMeshesSeconds(
+	TEXT("Bomber.Level.PrestreamMeshesSeconds"),
+	30.f,
+	TEXT("Seconds to force all LODs of level actor meshes of preloaded level type to be resident, 0 to disable prestreaming"),
+	ECVF_Default);
+
+// Compute the layout of level actors on a worker thread in game worlds
+static TAutoConsoleVariable<bool> CVarAsyncLevelLayout(
+	TEXT("Bomber.Level.AsyncLayout"),
+	true,
+	TEXT("Compute the layout of generated level actors: 1 (On worker thread, spawn on game thread) OR 0 (On game thread)"),
+	ECVF_Default);
+
+// How often the server captures the checkpoint of the running match
+static TAutoConsoleVariable<float> CVarMatchCheckpointSeconds(
+	TEXT("Bomber.Match.CheckpointSeconds"),
+	5.f,
+	TEXT("Seconds between match snapshots captured by the server while the match is in progress, 0 to disable checkpoints"),
+	ECVF_Default);
+
+// Grid queries are measured both by duration and by calls per frame, since the AI runs them many times each tick
+DECLARE_CYCLE_STAT(TEXT("GetSidesCells"), STAT_GeneratedMap_GetSidesCells, STATGROUP_Bomber);
+DECLARE_DWORD_COUNTER_STAT(TEXT("GetSidesCells Calls"), STAT_GeneratedMap_GetSidesCells_Calls, STATGROUP_Bomber);
+DECLARE_CYCLE_STAT(TEXT("IntersectCellsByTypes"), STAT_GeneratedMap_IntersectCellsByTypes, STATGROUP_Bomber);
+DECLARE_DWORD_COUNTER_STAT(TEXT("IntersectCellsByTypes Calls"), STAT_GeneratedMap_IntersectCellsByTypes_Calls, STATGROUP_Bomber);
+DECLARE_CYCLE_STAT(TEXT("DoesPathExistToCells"), STAT_GeneratedMap_DoesPathExistToCells, STATGROUP_Bomber);
+DECLARE_DWORD_COUNTER_STAT(TEXT("DoesPathExistToCells Calls"), STAT_GeneratedMap_DoesPathExistToCells_Calls, STATGROUP_Bomber);
+DECLARE_CYCLE_STAT(TEXT("GetMapComponents"), STAT_GeneratedMap_GetMapComponents, STATGROUP_Bomber);
+DECLARE_DWORD_COUNTER_STAT(TEXT("GetMapComponents Calls"), STAT_GeneratedMap_GetMapComponents_Calls, STATGROUP_Bomber);
+DECLARE_CYCLE_STAT(TEXT("SpawnActorsByTypes"), STAT_GeneratedMap_SpawnActorsByTypes, STATGROUP_Bomber);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SpawnActorsByTypes Calls"), STAT_GeneratedMap_SpawnActorsByTypes_Calls, STATGROUP_Bomber);
+DECLARE_CYCLE_STAT(TEXT("DestroyLevelActorsOnCells"), STAT_GeneratedMap_DestroyLevelActorsOnCells, STATGROUP_Bomber);
+DECLARE_DWORD_COUNTER_STAT(TEXT("DestroyLevelActorsOnCells Calls"), STAT_GeneratedMap_DestroyLevelActorsOnCells_Calls, STATGROUP_Bomber);
+DECLARE_CYCLE_STAT(TEXT("SetNearestCell"), STAT_GeneratedMap_SetNearestCell, STATGROUP_Bomber);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SetNearestCell Calls"), STAT_GeneratedMap_SetNearestCell_Calls, STATGROUP_Bomber);
+
+/** Measures the scope of the grid query: 'stat Bomber' shows its time and calls, without stats it is still visible in Unreal Insights. */
+#if STATS
+#define GENERATED_MAP_STAT_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_GeneratedMap_##Name); \
+	INC_DWORD_STAT(STAT_GeneratedMap_##Name##_Calls)
+#else
+#define GENERATED_MAP_STAT_SCOPE(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(AGeneratedMap::Name)
+#endif // STATS
+
 /* ---------------------------------------------------
  *		Generated Map public functions
  * --------------------------------------------------- */
@@ -66,6 +143,13 @@ AGeneratedMap::AGeneratedMap()
 	// Default camera class
 	CameraComponentInternal = CreateDefaultSubobject<UMyCameraComponent>(TEXT("Camera Component"));
 	CameraComponentInternal->SetupAttachment(RootComponent);
+
+	// Instanced meshes of walls and boxes
+	InstancedMeshesComponentInternal = CreateDefaultSubobject<UInstancedLevelMeshesComponent>(TEXT("Instanced Meshes Component"));
+	InstancedMeshesComponentInternal->SetupAttachment(RootComponent);
+
+	// Replicated map components are mirrored into the occupancy on client
+	MapComponentsInternal.SetOwnerMap(this);
 }
 
 // Returns the generated map
@@ -76,6 +160,14 @@ AGeneratedMap& AGeneratedMap::Get()
 	return *GeneratedMap;
 }
 
+// Returns the generated map of the match instance that owns given context object, the primary one if it can't be resolved
+AGeneratedMap& AGeneratedMap::Get(const UObject* ContextObject)
+{
+	AGeneratedMap* GeneratedMap = UGeneratedMapSubsystem::Get().GetGeneratedMapByContext(ContextObject);
+	checkf(GeneratedMap, TEXT("%s: ERROR: 'GeneratedMap' is null"), *FString(__FUNCTION__));
+	return *GeneratedMap;
+}
+
 // Initialize this Generated Map actor, could be called multiple times
 void AGeneratedMap::ConstructGeneratedMap(const FTransform& Transform)
 {
@@ -96,26 +188,54 @@ void AGeneratedMap::SetLevelSize(const FIntPoint& LevelSize)
 		return;
 	}
 
+	// Clamp sizes which regeneration would exceed the frame budget or the replication limit
+	const UGeneratedMapDataAsset& GeneratedMapDataAsset = UGeneratedMapDataAsset::Get();
+	const FIntPoint AffordableSize = GeneratedMapDataAsset.ClampLevelSize(LevelSize);
+	if (AffordableSize != LevelSize)
+	{
+		const FLevelSizeCost Cost = GeneratedMapDataAsset.EstimateLevelSizeCost(LevelSize);
+		UE_LOG(LogBomber, Warning, TEXT("Level size %s is clamped to %s: estimated %i actors, %.2f ms frame, %lld bytes per client"),
+		       *LevelSize.ToString(), *AffordableSize.ToString(), Cost.ActorsNum, Cost.FrameMs, Cost.ReplicatedBytes);
+	}
+
 	AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState();
 	if (MyGameState && MyGameState->GetCurrentGameState() == ECGS::InGame)
 	{
 		MyGameState->ServerSetGameState(ECurrentGameState::GameStarting);
 	}
 
-	MulticastSetLevelSize(LevelSize);
+	if (AffordableSize == GetGridSize())
+	{
+		// The grid is not changed, so clients do not need to be reconstructed, only level actors are regenerated and replicated by their diff
+		GenerateLevelActors();
+		return;
+	}
+
+	BOMBER_NET_STAT(MulticastSetLevelSize, sizeof(AffordableSize) * 8);
+	MulticastSetLevelSize(AffordableSize);
+}
+
+// Forces chances of walls and boxes of next generations, negative values to use chances of the data asset
+void AGeneratedMap::SetGenerationChancesOverride(int32 WallsChance, int32 BoxesChance)
+{
+	WallsChanceOverrideInternal = WallsChance;
+	BoxesChanceOverrideInternal = BoxesChance;
 }
 
 // Getting an array of cells by four sides of an input center cell and type of breaks
+template <typename SetAllocator>
 void AGeneratedMap::GetSidesCells(
-	FCells& OutCells,
+	TSet<FCell, DefaultKeyFuncs<FCell>, SetAllocator>& OutCells,
 	const FCell& Cell,
 	EPathType Pathfinder,
 	int32 SideLength,
 	int32 DirectionsBitmask,
 	bool bBreakInputCells) const
 {
-	const int32 MaxWidth = UCellsUtilsLibrary::GetCellColumnsNumOnLevel();
-	if (!ensureMsgf(MaxWidth, TEXT("ASSERT: Level has zero width (Scale.X)"))
+	GENERATED_MAP_STAT_SCOPE(GetSidesCells);
+	BOMBER_PERF_BUDGET_SCOPE(GetSidesCells);
+
+	if (!ensureMsgf(GridSizeInternal.X, TEXT("ASSERT: Level has zero width (Scale.X)"))
 	    || !ensureMsgf(DirectionsBitmask, TEXT("ASSERT: 'DirectionsBitmask' is not set"))
 	    || !ensureMsgf(SideLength > 0, TEXT("ASSERT: 'SideLength' is less than 1"))
 	    || !ensureMsgf(Cell.IsValid(), TEXT("ASSERT: 'Cell' is invalid")))
@@ -123,171 +243,532 @@ void AGeneratedMap::GetSidesCells(
 		return;
 	}
 
-	const bool bIsAnyPath = Pathfinder == EPathType::Any;
+	// the index of the specified cell
+	const int32 C0 = GetCellIndex(Cell);
+	if (C0 == INDEX_NONE) // if index was found and cell is contained in the array
+	{
+		if (!bBreakInputCells)
+		{
+			OutCells.Empty();
+		}
+		return;
+	}
+
+	int32 BreakActorTypes = GetBreakActorTypes(Pathfinder);
+
+	// Is called many times each tick, so temporary bitboards of this thread are reused instead of being allocated on each call
+	static thread_local FCellsBitboard BreakCells;
+	static thread_local FCellsBitboard DangerousCells;
+	bool bHasBreakCells = false;
 
 	// ----- Walls definition -----
-	FCells Walls;
-	bool bBreakOnWalls = !bIsAnyPath && !OutCells.Num();
-	if (bBreakOnWalls)
+	if (OutCells.Num())
 	{
-		Walls = UCellsUtilsLibrary::GetAllCellsWithActors(TO_FLAG(EAT::Wall));
+		// Level walls break lines only if input cells are not specified
+		BreakActorTypes &= ~TO_FLAG(EAT::Wall);
+
+		if (bBreakInputCells) // specified OutCells is not empty, these cells break lines as the Wall behavior, don't empty specified array
+		{
+			BreakCells.Init(GridCellsInternal.Num());
+			for (const FCell& InputCellIt : OutCells)
+			{
+				const int32 InputCellIndex = GetCellIndex(InputCellIt);
+				if (InputCellIndex != INDEX_NONE)
+				{
+					BreakCells.SetBit(InputCellIndex, true);
+				}
+			}
+			bHasBreakCells = true;
+		}
+		else
+		{
+			OutCells.Empty(); // should empty array in order to return only sides cells
+		}
 	}
-	else if (bBreakInputCells) // specified OutCells is not empty, these cells break lines as the Wall behavior
+
+	// ----- A path without explosions -----
+	if (Pathfinder == EPathType::Safe
+	    || Pathfinder == EPathType::Secure)
 	{
-		bBreakOnWalls = true;
-		Walls = OutCells; // these cells break lines as the Wall behavior, don't empty specified array
+		GetDangerousCellsBitboard(DangerousCells);
+		if (bHasBreakCells)
+		{
+			BreakCells |= DangerousCells;
+		}
+		else
+		{
+			BreakCells = DangerousCells;
+			bHasBreakCells = true;
+		}
 	}
-	else // !bBreakOnWalls && !bBreakInputCells
+
+	// ----- Cells finding -----
+	FCellIndices FoundCellIndices;
+	GetSidesCellIndices(FoundCellIndices, C0, BreakActorTypes, bHasBreakCells ? &BreakCells : nullptr, SideLength, DirectionsBitmask);
+
+	OutCells.Reserve(OutCells.Num() + FoundCellIndices.Num());
+	for (const int32 FoundCellIndexIt : FoundCellIndices)
 	{
-		OutCells.Empty(); // should empty array in order to return only sides cells
+		OutCells.Emplace(GridCellsInternal[FoundCellIndexIt]);
 	}
+}
 
-	// the index of the specified cell
-	const int32 C0 = GridCellsInternal.IndexOfByPredicate([&Cell](const FCell& InCell) { return InCell == Cell; });
-	if (C0 == INDEX_NONE) // if index was found and cell is contained in the array
+// Both common and small sets of cells could be found
+template void AGeneratedMap::GetSidesCells(FCells& OutCells, const FCell& Cell, EPathType Pathfinder, int32 SideLength, int32 DirectionsBitmask, bool bBreakInputCells) const;
+template void AGeneratedMap::GetSidesCells(FSmallCells& OutCells, const FCell& Cell, EPathType Pathfinder, int32 SideLength, int32 DirectionsBitmask, bool bBreakInputCells) const;
+
+// Allocation-free version of GetSidesCells that works with row-major indices of cells
+void AGeneratedMap::GetSidesCellIndices(
+	FCellIndices& OutCellIndices,
+	int32 CellIndex,
+	int32 BreakActorTypes,
+	const FCellsBitboard* BreakCells,
+	int32 SideLength,
+	int32 DirectionsBitmask) const
+{
+	GetSidesCellIndices(OutCellIndices, CellIndex, GridSizeInternal, CellActorTypesInternal, BreakActorTypes, BreakCells, SideLength, DirectionsBitmask);
+}
+
+// Returns the number of free cells by each side of given cell until the line is broken, without the center
+void AGeneratedMap::GetSideRayLengths(uint8 (&OutRayLengths)[4], int32 CellIndex, int32 BreakActorTypes, int32 SideLength) const
+{
+	FMemory::Memzero(OutRayLengths);
+
+	const int32 MaxWidth = GridSizeInternal.X;
+	const int32 MaxLength = GridSizeInternal.Y;
+	if (!MaxWidth
+	    || !CellActorTypesInternal.IsValidIndex(CellIndex)
+	    || ActorTypesColumnBitboardsInternal[0].Num() != CellActorTypesInternal.Num())
 	{
 		return;
 	}
 
-	// ----- A path without obstacles -----
-	FCells Obstacles;
-	const bool bBreakOnObstacles = !bIsAnyPath && Pathfinder != EPathType::Explosion;
-	if (bBreakOnObstacles) // if is the request to find the path without Bombs/Boxes
-	{
-		Obstacles = UCellsUtilsLibrary::GetAllCellsWithActors(TO_FLAG(EAT::Bomb | EAT::Box));
-	}
+	const int32 Column = CellIndex % MaxWidth;
+	const int32 Row = CellIndex / MaxWidth;
+	const int32 ColumnIndex = Column * MaxLength + Row;
+	SideLength = FMath::Clamp(SideLength, 0, static_cast<int32>(MAX_uint8));
 
-	// ----- Secure: a path without players -----
-	FCells PlayersCells;
-	const bool bBreakOnPlayers = Pathfinder == EPathType::Secure;
-	if (bBreakOnPlayers) // if is the request to find the path without players cells.
+	// Returns the number of free cells until the nearest blocker of break types in the range from the center
+	auto CastRay = [BreakActorTypes](const TStaticArray<FCellsBitboard, ActorTypesNum>& Bitboards, int32 Center, int32 StepsNum, bool bForward) -> uint8
 	{
-		PlayersCells = UCellsUtilsLibrary::GetAllCellsWithActors(TO_FLAG(EAT::Player));
-	}
+		if (StepsNum <= 0)
+		{
+			return 0;
+		}
 
-	// ----- A path without explosions -----
-	FCells DangerousCells = AdditionalDangerousCells;
-	const bool bBreakOnExplosions = Pathfinder == EPathType::Safe || Pathfinder == EPathType::Secure;
-	if (bBreakOnExplosions) // if is the request to find the path without explosions.
-	{
-		FMapComponents BombsMapComponents;
-		GetMapComponents(BombsMapComponents, TO_FLAG(EAT::Bomb));
-		if (BombsMapComponents.Num() > 0)
+		int32 Length = StepsNum;
+		for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
 		{
-			for (const UMapComponent* MapComponentIt : BombsMapComponents)
+			if (!(BreakActorTypes & (1 << TypeIndex)))
 			{
-				const ABombActor* BombOwner = MapComponentIt ? MapComponentIt->GetOwner<ABombActor>() : nullptr;
-				if (BombOwner)
-				{
-					DangerousCells = DangerousCells.Union(BombOwner->GetExplosionCells());
-				}
+				continue;
+			}
+
+			const FCellsBitboard& Bitboard = Bitboards[TypeIndex];
+			const int32 BlockerIndex = bForward ? Bitboard.FindFirstSetBit(Center + 1, Center + Length) : Bitboard.FindLastSetBit(Center - Length, Center - 1);
+			if (BlockerIndex != INDEX_NONE)
+			{
+				Length = FMath::Abs(BlockerIndex - Center) - 1;
 			}
 		}
-	}
+		return static_cast<uint8>(Length);
+	};
+
+	OutRayLengths[0] = CastRay(ActorTypesBitboardsInternal, CellIndex, FMath::Min(SideLength, Column), false);
+	OutRayLengths[1] = CastRay(ActorTypesBitboardsInternal, CellIndex, FMath::Min(SideLength, MaxWidth - 1 - Column), true);
+	OutRayLengths[2] = CastRay(ActorTypesColumnBitboardsInternal, ColumnIndex, FMath::Min(SideLength, Row), false);
+	OutRayLengths[3] = CastRay(ActorTypesColumnBitboardsInternal, ColumnIndex, FMath::Min(SideLength, MaxLength - 1 - Row), true);
+}
 
-	// ----- The specified cell adding -----
-	if (bBreakOnExplosions == false        // can be danger
-	    || !DangerousCells.Contains(Cell)) // is not dangerous cell
+namespace GeneratedMapSides
+{
+	/** One side of the cell: the direction and offsets of one step by columns and rows. */
+	struct FSide
 	{
-		OutCells.Emplace(Cell);
-	}
+		ECellDirection Direction;
+		int32 ColumnStep;
+		int32 RowStep;
+	};
 
-	// ----- Cells finding -----
-	for (int8 bIsY = 0; bIsY <= 1; ++bIsY) // 0(X-raw direction) and 1(Y-column direction)
+	/** All sides in the order of found cells: Left, Right, Forward, Backward. */
+	static constexpr FSide Sides[] = {
+		{ECellDirection::Left, -1, 0},
+		{ECellDirection::Right, 1, 0},
+		{ECellDirection::Forward, 0, -1},
+		{ECellDirection::Backward, 0, 1}
+	};
+
+	/** Finds cells by each requested side until the line is broken.
+	 * Is specialized by break cells, so the ray is a straight bit test and the index add when there are no break cells. */
+	template <bool bHasBreakCells>
+	void FindSidesCellIndices(
+		FCellIndices& OutCellIndices,
+		int32 CellIndex,
+		const FIntPoint& GridSize,
+		TConstArrayView<uint8> CellActorTypes,
+		int32 BreakActorTypes,
+		const FCellsBitboard* BreakCells,
+		int32 SideLength,
+		int32 DirectionsBitmask)
 	{
-		const int32 PositionC0 = bIsY ? /*Y-column*/ C0 % MaxWidth : C0 / MaxWidth /*raw*/;
-		for (int8 SideMultiplier = -1; SideMultiplier <= 1; SideMultiplier += 2) // -1(Left|Down) and 1(Right|Up)
+		// ----- The specified cell adding -----
+		if (!bHasBreakCells                   // nothing to break
+		    || !BreakCells->IsSet(CellIndex)) // is not dangerous cell
+		{
+			OutCellIndices.Emplace(CellIndex);
+		}
+
+		// ----- Cells finding -----
+		const int32 Column = CellIndex % GridSize.X;
+		const int32 Row = CellIndex / GridSize.X;
+		for (const FSide& SideIt : Sides)
 		{
-			const FVector& VectorDirection = bIsY ? FVector::BackwardVector : FVector::RightVector;
-			const FCell CellDirection = VectorDirection * FVector(SideMultiplier);
-			const ECellDirection EnumDirection = FCell::GetCellDirection(CellDirection);
-			if (!EnumHasAnyFlags(EnumDirection, TO_ENUM(ECellDirection, DirectionsBitmask)))
+			if (!(DirectionsBitmask & TO_FLAG(SideIt.Direction)))
 			{
 				continue;
 			}
 
-			for (int8 i = 1; i <= SideLength; ++i)
+			const int32 MaxSteps = SideIt.ColumnStep < 0 ? Column
+			                       : SideIt.ColumnStep > 0 ? GridSize.X - 1 - Column
+			                       : SideIt.RowStep < 0 ? Row
+			                       : GridSize.Y - 1 - Row;
+			const int32 IndexStep = SideIt.ColumnStep + SideIt.RowStep * GridSize.X;
+			const int32 StepsNum = FMath::Min(SideLength, MaxSteps);
+			int32 FoundIndex = CellIndex;
+			for (int32 Step = 1; Step <= StepsNum; ++Step)
 			{
-				int32 Distance = i * SideMultiplier;
-				if (bIsY)
-				{
-					Distance *= MaxWidth;
-				}
-				const int32 FoundIndex = C0 + Distance;
-				if (PositionC0 != (bIsY ? FoundIndex % MaxWidth : FoundIndex / MaxWidth) // PositionC0 != PositionX
-				    || !GridCellsInternal.IsValidIndex(FoundIndex))                      // is not in range
+				FoundIndex += IndexStep;
+				if (BreakActorTypes & CellActorTypes[FoundIndex]       // cell contains a wall, obstacle (Bombs/Boxes) or player
+				    || bHasBreakCells && BreakCells->Bits[FoundIndex]) // cell is an explosion or one of the input cells
 				{
 					break; // to the next side
 				}
 
-				const FCell FoundCell = GridCellsInternal[FoundIndex];
+				OutCellIndices.Emplace(FoundIndex);
+			}
+		}
+	}
+}
 
-				if (bBreakOnWalls && Walls.Contains(FoundCell)                   // cell contains a wall
-				    || bBreakOnObstacles && Obstacles.Contains(FoundCell)        // cell contains an obstacle (Bombs/Boxes)
-				    || bBreakOnPlayers && PlayersCells.Contains(FoundCell)       // cell contains a player
-				    || bBreakOnExplosions && DangerousCells.Contains(FoundCell)) // cell contains an explosion
-				{
-					break; // to the next side
-				}
+// Static implementation of GetSidesCellIndices() that works with any given occupancy of the grid
+void AGeneratedMap::GetSidesCellIndices(
+	FCellIndices& OutCellIndices,
+	int32 CellIndex,
+	const FIntPoint& GridSize,
+	TConstArrayView<uint8> CellActorTypes,
+	int32 BreakActorTypes,
+	const FCellsBitboard* BreakCells,
+	int32 SideLength,
+	int32 DirectionsBitmask)
+{
+	const int32 MaxWidth = GridSize.X;
+	const int32 MaxLength = GridSize.Y;
+	if (!MaxWidth
+	    || CellActorTypes.Num() != MaxWidth * MaxLength
+	    || !CellActorTypes.IsValidIndex(CellIndex))
+	{
+		return;
+	}
+
+	if (BreakCells
+	    && BreakCells->Num() != CellActorTypes.Num())
+	{
+		UE_LOG(LogBomber, Warning, TEXT("%s: break cells of %i cells do not match the grid of %i cells, so they are ignored"), *FString(__FUNCTION__), BreakCells->Num(), CellActorTypes.Num());
+		BreakCells = nullptr;
+	}
+
+	// Break cells are dispatched once, so the ray loop does not check them for each cell
+	if (BreakCells)
+	{
+		GeneratedMapSides::FindSidesCellIndices<true>(OutCellIndices, CellIndex, GridSize, CellActorTypes, BreakActorTypes, BreakCells, SideLength, DirectionsBitmask);
+	}
+	else
+	{
+		GeneratedMapSides::FindSidesCellIndices<false>(OutCellIndices, CellIndex, GridSize, CellActorTypes, BreakActorTypes, nullptr, SideLength, DirectionsBitmask);
+	}
+}
+
+// Returns the bitboard of cells that are going to be exploded by bombs or marked as dangerous from outside
+void AGeneratedMap::GetDangerousCellsBitboard(FCellsBitboard& OutBitboard) const
+{
+	OutBitboard = DangerousCellsInternal;
+	if (OutBitboard.Num() != GridCellsInternal.Num())
+	{
+		OutBitboard.Init(GridCellsInternal.Num());
+	}
+
+	for (const FCell& CellIt : AdditionalDangerousCells)
+	{
+		const int32 DangerousCellIndex = GetCellIndex(CellIt);
+		if (DangerousCellIndex != INDEX_NONE)
+		{
+			OutBitboard.SetBit(DangerousCellIndex, true);
+		}
+	}
+}
+
+// Replaces outside added dangerous cells, bots take them into account on their next update
+void AGeneratedMap::SetAdditionalDangerousCells(const TSet<FCell>& InCells)
+{
+	AdditionalDangerousCells = InCells;
+	++AdditionalDangerousCellsVersionInternal;
+}
+
+// Returns the shared read-only state of the level for bots
+const FAIWorldSnapshot& AGeneratedMap::GetAIWorldSnapshot() const
+{
+	if (AIWorldSnapshotInternal.StateVersion != StateVersionInternal
+	    || AIWorldSnapshotDangerVersionInternal != AdditionalDangerousCellsVersionInternal
+	    || AIWorldSnapshotInternal.Num() != GridCellsInternal.Num())
+	{
+		AIWorldSnapshotInternal.Build(*this);
+		AIWorldSnapshotInternal.StateVersion = StateVersionInternal;
+		AIWorldSnapshotDangerVersionInternal = AdditionalDangerousCellsVersionInternal;
+	}
+
+	return AIWorldSnapshotInternal;
+}
+
+// Returns the number of steps by free cells from each cell to the nearest cell with actors of specified types
+const TArray<int32>& AGeneratedMap::GetDistanceMap(int32 ActorsTypesBitmask) const
+{
+	FGridDistanceMap& DistanceMap = DistanceMapsInternal.FindOrAdd(ActorsTypesBitmask);
+	if (DistanceMap.StateVersion == StateVersionInternal
+	    && DistanceMap.Distances.Num() == GridCellsInternal.Num())
+	{
+		return DistanceMap.Distances;
+	}
+
+	FCellsBitboard TargetCells;
+	GetCellsBitboard(TargetCells, ActorsTypesBitmask);
+
+	FCellIndices TargetCellIndices;
+	TargetCells.ForEachSetBit([&TargetCellIndices](int32 CellIndex) { TargetCellIndices.Emplace(CellIndex); });
+
+	// Buffer of previous distances is reused
+	GetAIWorldSnapshot().BuildDistanceField(DistanceMap.Distances, TargetCellIndices);
+	DistanceMap.StateVersion = StateVersionInternal;
+	return DistanceMap.Distances;
+}
+
+// Returns the immutable ref-counted copy of the AI snapshot that could be kept and read by worker threads
+TSharedRef<const FAIWorldSnapshot, ESPMode::ThreadSafe> AGeneratedMap::GetSharedWorldSnapshot() const
+{
+	check(IsInGameThread());
+
+	const FAIWorldSnapshot& Snapshot = GetAIWorldSnapshot();
+	const TSharedPtr<FAIWorldSnapshot, ESPMode::ThreadSafe>& FrontSnapshot = SharedWorldSnapshotsInternal[SharedWorldSnapshotIndexInternal];
+	if (FrontSnapshot.IsValid()
+	    && FrontSnapshot->BuildNumber == Snapshot.BuildNumber)
+	{
+		// Nothing is changed since the last publish
+		return FrontSnapshot.ToSharedRef();
+	}
+
+	const int32 BackIndex = 1 - SharedWorldSnapshotIndexInternal;
+	TSharedPtr<FAIWorldSnapshot, ESPMode::ThreadSafe>& BackSnapshot = SharedWorldSnapshotsInternal[BackIndex];
+	if (BackSnapshot.IsValid()
+	    && BackSnapshot.IsUnique())
+	{
+		// No worker reads the back copy anymore, so its allocations are reused
+		*BackSnapshot = Snapshot;
+	}
+	else
+	{
+		// Is still held by some worker, leave it to that reader
+		BackSnapshot = MakeShared<FAIWorldSnapshot, ESPMode::ThreadSafe>(Snapshot);
+	}
+
+	SharedWorldSnapshotIndexInternal = BackIndex;
+	return BackSnapshot.ToSharedRef();
+}
+
+// Registers, refreshes or unregisters given bomb in the danger map
+void AGeneratedMap::UpdateBombDanger(const ABombActor* BombActor)
+{
+	if (!BombActor)
+	{
+		return;
+	}
+
+	int32 BombIndex = BombsDangerInternal.IndexOfByPredicate([BombActor](const FBombDanger& BombDangerIt) { return BombDangerIt.Bomb == BombActor; });
+
+	const FCells ExplosionCells = BombActor->GetExplosionCells();
+	if (ExplosionCells.IsEmpty())
+	{
+		// The bomb is detonated or removed from the level
+		if (BombIndex != INDEX_NONE)
+		{
+			BombsDangerInternal.RemoveAtSwap(BombIndex);
+			RebuildDangerMap();
+		}
+		return;
+	}
 
-				OutCells.Emplace(FoundCell);
-			} // Cells iterating
-		}     // Each side iterating: -1(Left|Down) and 1(Right|Up)
-	}         // Each direction iterating: 0(X-raw) and 1(Y-column)
+	if (BombIndex == INDEX_NONE)
+	{
+		BombIndex = BombsDangerInternal.AddDefaulted();
+	}
+
+	FBombDanger& BombDanger = BombsDangerInternal[BombIndex];
+	BombDanger.Bomb = BombActor;
+	BombDanger.DetonationTime = BombActor->GetDetonationTime();
+	BombDanger.ExplosionCellIndices.Reset();
+	for (const FCell& ExplosionCellIt : ExplosionCells)
+	{
+		const int32 ExplosionCellIndex = GetCellIndex(ExplosionCellIt);
+		if (ExplosionCellIndex != INDEX_NONE)
+		{
+			BombDanger.ExplosionCellIndices.Emplace(ExplosionCellIndex);
+		}
+	}
+
+	RebuildDangerMap();
+}
+
+// Returns the number of seconds left until given cell is exploded by the earliest bomb
+float AGeneratedMap::GetCellDangerTime(const FCell& Cell) const
+{
+	const int32 CellIndex = GetCellIndex(Cell);
+	if (!DangerTimesInternal.IsValidIndex(CellIndex)
+	    || !DangerousCellsInternal.IsSet(CellIndex))
+	{
+		return -1.f;
+	}
+
+	const float DetonationTime = DangerTimesInternal[CellIndex];
+	if (DetonationTime == MAX_flt)
+	{
+		// The bomb is placed, but its timer is not started yet
+		return MAX_flt;
+	}
+
+	const UWorld* World = GetWorld();
+	return FMath::Max(0.f, DetonationTime - (World ? World->GetTimeSeconds() : 0.f));
 }
 
 // Returns true if any player is able to reach all specified cells by any any path
 bool AGeneratedMap::DoesPathExistToCells(const FCells& CellsToFind, const FCells& OptionalPathBreakers/* = FCell::EmptyCells*/)
 {
-	FCells InOutSideCells = OptionalPathBreakers;
+	GENERATED_MAP_STAT_SCOPE(DoesPathExistToCells);
+
+	const int32 CellsNum = GridCellsInternal.Num();
+	const int32 MaxWidth = GridSizeInternal.X;
+	check(GridCellsInternal.IsValidIndex(0));
+	if (!ensureMsgf(MaxWidth, TEXT("ASSERT: [%i] %s:\nLevel has zero width (Scale.X)"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return false;
+	}
+
+	// Visited cells include path breakers, so they are never entered
+	FCellsBitboard VisitedCells;
 	if (OptionalPathBreakers.IsEmpty())
 	{
 		// Include walls to prevent finding way through their cells
-		InOutSideCells = UCellsUtilsLibrary::GetAllCellsWithActors(TO_FLAG(EAT::Wall));
+		// Are the spawned walls of the level, so they are outdated while a new layout is generated, @see ThisClass::ComputeLevelLayout
+		GetCellsBitboard(VisitedCells, TO_FLAG(EAT::Wall));
+	}
+	else
+	{
+		VisitedCells.Init(CellsNum);
+		for (const FCell& PathBreakerIt : OptionalPathBreakers)
+		{
+			const int32 PathBreakerIndex = GetCellIndex(PathBreakerIt);
+			if (PathBreakerIndex != INDEX_NONE)
+			{
+				VisitedCells.SetBit(PathBreakerIndex, true);
+			}
+		}
 	}
 
-	// Contains all cells need to find their side cells
-	check(GridCellsInternal.IsValidIndex(0));
-	FCells CellsToIterate{GridCellsInternal[0]};
-
-	FCells FoundCells = FCell::EmptyCells;
-	while (CellsToIterate.Num())
+	// Cells that still need to be reached
+	FCellsBitboard CellsToReach;
+	CellsToReach.Init(CellsNum);
+	int32 CellsToReachNum = 0;
+	for (const FCell& CellToFindIt : CellsToFind)
 	{
-		// Cache all previous side cells
-		const FCells PrevSideCells = InOutSideCells;
+		const int32 CellToFindIndex = GetCellIndex(CellToFindIt);
+		if (CellToFindIndex == INDEX_NONE)
+		{
+			// Is not on the grid, so can't be reached
+			return false;
+		}
+
+		if (!CellsToReach.IsSet(CellToFindIndex))
+		{
+			CellsToReach.SetBit(CellToFindIndex, true);
+			++CellsToReachNum;
+		}
+	}
 
-		for (const FCell& CellIt : CellsToIterate)
+	auto VisitCell = [&VisitedCells, &CellsToReach, &CellsToReachNum](int32 CellIndex)
+	{
+		VisitedCells.SetBit(CellIndex, true);
+		if (CellsToReach.IsSet(CellIndex))
 		{
-			constexpr int32 MaxInteger = TNumericLimits<int32>::Max();
-			constexpr bool bBreakInputCells = true;
-			// InOutAllFoundCells include as wall cells as well all previous iterated cells
-			GetSidesCells(/*InOut*/InOutSideCells, CellIt, EPathType::Explosion, MaxInteger, TO_FLAG(ECellDirection::All), bBreakInputCells);
+			--CellsToReachNum;
 		}
+	};
+
+	// Breadth-first flood fill from the first cell, each cell is visited once
+	TArray<int32> CellsQueue;
+	CellsQueue.Reserve(CellsNum);
+	CellsQueue.Emplace(0);
+	if (!VisitedCells.IsSet(0))
+	{
+		VisitCell(0);
+	}
 
-		// Extract newly found cells
-		CellsToIterate = InOutSideCells.Difference(PrevSideCells);
+	for (int32 QueueIndex = 0; QueueIndex < CellsQueue.Num() && CellsToReachNum > 0; ++QueueIndex)
+	{
+		const int32 CellIndex = CellsQueue[QueueIndex];
+		const int32 Column = CellIndex % MaxWidth;
+
+		const int32 NeighbourIndices[] = {
+			Column > 0 ? CellIndex - 1 : INDEX_NONE,               // Left
+			Column < MaxWidth - 1 ? CellIndex + 1 : INDEX_NONE,    // Right
+			CellIndex - MaxWidth,                                  // Forward
+			CellIndex + MaxWidth                                   // Backward
+		};
 
-		const FCells NotFoundCells = CellsToFind.Difference(FoundCells);
-		FoundCells = CellsToIterate.Intersect(NotFoundCells).Union(FoundCells);
-		if (FoundCells.Includes(CellsToFind))
+		for (const int32 NeighbourIndexIt : NeighbourIndices)
 		{
-			return true;
+			if (NeighbourIndexIt >= 0
+			    && NeighbourIndexIt < CellsNum
+			    && !VisitedCells.IsSet(NeighbourIndexIt))
+			{
+				VisitCell(NeighbourIndexIt);
+				CellsQueue.Emplace(NeighbourIndexIt);
+			}
 		}
 	}
 
-	return false;
+	return CellsToReachNum <= 0;
 }
 
 // Spawns level actor on the Generated Map by the specified type
 void AGeneratedMap::SpawnActorByType(EActorType Type, const FCell& Cell, const TFunction<void(AActor*)>& OnSpawned/* = nullptr*/)
 {
 	if (!HasAuthority()
-	    || UCellsUtilsLibrary::IsCellHasAnyMatchingActor(Cell, TO_FLAG(~EAT::Player)) // the free cell was not found
-	    || Type == EAT::None)                                                         // nothing to spawn
+	    || Type == EAT::None) // nothing to spawn
 	{
 		return;
 	}
 
+	if (SpawnBatchDepthInternal > 0
+	    && OnSpawned == nullptr)
+	{
+		// Is spawned together with other actors of current destruction batch, the cell is validated once the batch is finished
+		BatchedSpawnsInternal.Emplace(Cell, Type);
+		return;
+	}
+
+	if (UCellsUtilsLibrary::IsCellHasAnyMatchingActor(Cell, TO_FLAG(~EAT::Player)))
+	{
+		// The free cell was not found
+		return;
+	}
+
 	// --- Prepare spawn request
 	const TWeakObjectPtr<ThisClass> WeakThis(this);
 	const FOnSpawnCallback OnCompleted = [WeakThis, OnSpawned](const FPoolObjectData& CreatedObject)
@@ -303,6 +784,11 @@ void AGeneratedMap::SpawnActorByType(EActorType Type, const FCell& Cell, const T
 		SpawnedActor.SetFlags(RF_Transient); // Do not save generated actors into the map
 		SpawnedActor.SetOwner(GeneratedMap);
 
+		if (UMapComponent* MapComponent = UMapComponent::GetMapComponent(&SpawnedActor))
+		{
+			MapComponent->SetPoolObjectHandle(CreatedObject.Handle);
+		}
+
 		if (OnSpawned != nullptr)
 		{
 			OnSpawned(&SpawnedActor);
@@ -318,79 +804,290 @@ void AGeneratedMap::SpawnActorByType(EActorType Type, const FCell& Cell, const T
 	MapComponentsInternal.FindOrAdd(Handle);
 }
 
-// Spawns many level actors at once, used for level generation
+// Spawns many level actors, used for level generation
 void AGeneratedMap::SpawnActorsByTypes(const TMap<FCell, EActorType>& ActorsToSpawn)
 {
+	GENERATED_MAP_STAT_SCOPE(SpawnActorsByTypes);
+
 	if (!HasAuthority())
 	{
 		return;
 	}
 
-	// --- Prepare spawn requests
-	TArray<FSpawnRequest> InOutRequests;
+	// --- Prepare spawns, previous pending ones are replaced by the new generation
+	++SpawnGenerationInternal;
+	if (const UWorld* World = GetWorld())
+	{
+		// Don't let the chain of previous generation continue together with the new one
+		World->GetTimerManager().ClearTimer(SpawnPendingTimerInternal);
+	}
+	PendingSpawnsInternal.Reset(ActorsToSpawn.Num());
 	for (const TTuple<FCell, EActorType>& It : ActorsToSpawn)
 	{
-		const FCell& Cell = It.Key;
-		const EActorType& Type = It.Value;
-
-		if (UCellsUtilsLibrary::IsCellHasAnyMatchingActor(Cell, TO_FLAG(~EAT::Player)) // the free cell was not found
-		    || Type == EAT::None)                                                      // nothing to spawn
+		if (UCellsUtilsLibrary::IsCellHasAnyMatchingActor(It.Key, TO_FLAG(~EAT::Player)) // the free cell was not found
+		    || It.Value == EAT::None)                                                    // nothing to spawn
 		{
 			continue;
 		}
 
-		FSpawnRequest& NewRequestRef = InOutRequests.AddDefaulted_GetRef();
-		NewRequestRef.Class = UDataAssetsContainer::GetActorClassByType(Type);
-		NewRequestRef.Transform = FTransform(Cell);
+		PendingSpawnsInternal.Emplace(It.Key, It.Value);
 	}
 
-	// --- Prepare On Spawn All callback
-	TWeakObjectPtr<ThisClass> WeakThis(this);
-	const FOnSpawnAllCallback OnCompleted = [WeakThis](const TArray<FPoolObjectData>& CreatedObjects)
+	// Walls first, then boxes, items and players, so the level is built from its frame while spawning is spread across frames
+	// Is sorted in reverse order, since the last spawn is popped first
+	auto GetSpawnOrder = [](EActorType ActorType)
 	{
-		AGeneratedMap* This = WeakThis.Get();
-		if (!This)
-		{
-			return;
-		}
-
-		// Setup spawned actors
-		for (const FPoolObjectData& CreatedObject : CreatedObjects)
+		switch (ActorType)
 		{
-			AActor& SpawnedActor = CreatedObject.GetChecked<AActor>();
-			SpawnedActor.SetFlags(RF_Transient); // Do not save generated actors into the map
-			SpawnedActor.SetOwner(This);
+			case EAT::Wall: return 0;
+			case EAT::Box: return 1;
+			case EAT::Item: return 2;
+			case EAT::Player: return 3;
+			default: return 4;
 		}
-
-		This->MapComponentsInternal.MarkArrayDirty();
-
-		This->OnGeneratedLevelActors.Broadcast();
 	};
+	PendingSpawnsInternal.StableSort([&GetSpawnOrder](const TPair<FCell, EActorType>& A, const TPair<FCell, EActorType>& B)
+	{
+		return GetSpawnOrder(A.Value) > GetSpawnOrder(B.Value);
+	});
 
-	// --- Spawn all actors
-	UPoolManagerSubsystem::Get().TakeFromPool(InOutRequests, OnCompleted);
+	SpawnsNumInternal = PendingSpawnsInternal.Num();
+	SpawnedNumInternal = 0;
+	PendingSpawnBatchesNumInternal = 0;
+	SetGenerationProgress(SpawnsNumInternal ? 0.f : 1.f);
 
-	// --- Add handles if requested spawning, so they can be canceled if regenerate before spawning finished
-	for (const FSpawnRequest& It : InOutRequests)
+	if (!SpawnsNumInternal)
 	{
-		checkf(It.Handle.IsValid(), TEXT("ERROR: [%i] %s:\n'Handle' is not valid!"), __LINE__, *FString(__FUNCTION__));
-		MapComponentsInternal.FindOrAdd(It.Handle);
+		OnFinishedSpawningGeneratedActors();
+		OnGeneratedLevelActors.Broadcast();
+		return;
 	}
+
+	SpawnPendingActors();
 }
 
-// The function that places the actor on the Generated Map, attaches it and writes this actor to the GridArray_
-void AGeneratedMap::AddToGrid(UMapComponent* AddedComponent)
+// Requests next pending level actors from pools until the spawn budget of this frame is reached
+void AGeneratedMap::SpawnPendingActors()
 {
-	AActor* ComponentOwner = AddedComponent ? AddedComponent->GetOwner() : nullptr;
-	if (!HasAuthority()
-	    || !ComponentOwner
-	    || !ComponentOwner->HasAuthority())
+	UWorld* World = GetWorld();
+	if (!World
+	    || PendingSpawnsInternal.IsEmpty())
 	{
 		return;
 	}
 
-	const FPoolObjectHandle& Handle = UPoolManagerSubsystem::Get().FindPoolHandleByObject(ComponentOwner);
-	if (!ensureMsgf(Handle.IsValid(), TEXT("ASSERT: [%i] %s:\n'Handle' is not valid, this object has to be known by Pool Manager!"), __LINE__, *FString(__FUNCTION__)))
+	// If no budget, all actors are requested at once
+	const double BudgetSeconds = UGeneratedMapDataAsset::Get().GetSpawnBudgetMs() / 1000.0;
+	const double StartTime = FPlatformTime::Seconds();
+	static constexpr int32 SpawnsPerBatch = 8;
+	const int32 MaxSpawnsPerBatch = BudgetSeconds > 0.0 ? SpawnsPerBatch : PendingSpawnsInternal.Num();
+
+	UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+	const uint32 SpawnGeneration = SpawnGenerationInternal;
+	do
+	{
+		// --- Prepare spawn requests
+		TArray<FSpawnRequest> InOutRequests;
+		InOutRequests.Reserve(MaxSpawnsPerBatch);
+		while (!PendingSpawnsInternal.IsEmpty()
+		       && InOutRequests.Num() < MaxSpawnsPerBatch)
+		{
+			constexpr bool bAllowShrinking = false;
+			const TPair<FCell, EActorType> SpawnIt = PendingSpawnsInternal.Pop(bAllowShrinking);
+
+			FSpawnRequest& NewRequestRef = InOutRequests.AddDefaulted_GetRef();
+			NewRequestRef.Class = UDataAssetsContainer::GetActorClassByType(SpawnIt.Value);
+			NewRequestRef.Transform = FTransform(SpawnIt.Key);
+		}
+
+		// --- Spawn actors of this batch
+		TWeakObjectPtr<ThisClass> WeakThis(this);
+		const FOnSpawnAllCallback OnCompleted = [WeakThis, SpawnGeneration](const TArray<FPoolObjectData>& CreatedObjects)
+		{
+			if (AGeneratedMap* This = WeakThis.Get())
+			{
+				This->OnSpawnedPendingActors(CreatedObjects, SpawnGeneration);
+			}
+		};
+
+		++PendingSpawnBatchesNumInternal;
+		PoolManager.TakeFromPool(InOutRequests, OnCompleted);
+
+		// --- Add handles if requested spawning, so they can be canceled if regenerate before spawning finished
+		for (const FSpawnRequest& It : InOutRequests)
+		{
+			checkf(It.Handle.IsValid(), TEXT("ERROR: [%i] %s:\n'Handle' is not valid!"), __LINE__, *FString(__FUNCTION__));
+			MapComponentsInternal.FindOrAdd(It.Handle);
+		}
+	}
+	while (!PendingSpawnsInternal.IsEmpty()
+	       && FPlatformTime::Seconds() - StartTime < BudgetSeconds);
+
+	if (!PendingSpawnsInternal.IsEmpty())
+	{
+		SpawnPendingTimerInternal = World->GetTimerManager().SetTimerForNextTick(this, &ThisClass::SpawnPendingActors);
+	}
+}
+
+// Validates all spawns collected during the finished destruction batch in one pass and requests them from pools by one request
+void AGeneratedMap::SpawnBatchedActors()
+{
+	if (BatchedSpawnsInternal.IsEmpty())
+	{
+		return;
+	}
+
+	// --- Prepare spawn requests, all victims are already removed from the grid
+	TArray<FSpawnRequest> InOutRequests;
+	InOutRequests.Reserve(BatchedSpawnsInternal.Num());
+	for (const TPair<FCell, EActorType>& SpawnIt : BatchedSpawnsInternal)
+	{
+		const int32 CellIndex = GetCellIndex(SpawnIt.Key);
+		if (!CellActorTypesInternal.IsValidIndex(CellIndex)
+		    || CellActorTypesInternal[CellIndex] & TO_FLAG(~EAT::Player)) // the free cell was not found
+		{
+			continue;
+		}
+
+		FSpawnRequest& NewRequestRef = InOutRequests.AddDefaulted_GetRef();
+		NewRequestRef.Class = UDataAssetsContainer::GetActorClassByType(SpawnIt.Value);
+		NewRequestRef.Transform = FTransform(SpawnIt.Key);
+	}
+	BatchedSpawnsInternal.Reset();
+
+	if (InOutRequests.IsEmpty())
+	{
+		return;
+	}
+
+	// --- Spawn actors of this batch
+	const TWeakObjectPtr<ThisClass> WeakThis(this);
+	const FOnSpawnAllCallback OnCompleted = [WeakThis](const TArray<FPoolObjectData>& CreatedObjects)
+	{
+		AGeneratedMap* GeneratedMap = WeakThis.Get();
+		if (!GeneratedMap)
+		{
+			return;
+		}
+
+		for (const FPoolObjectData& CreatedObject : CreatedObjects)
+		{
+			AActor& SpawnedActor = CreatedObject.GetChecked<AActor>();
+			SpawnedActor.SetFlags(RF_Transient); // Do not save generated actors into the map
+			SpawnedActor.SetOwner(GeneratedMap);
+
+			if (UMapComponent* MapComponent = UMapComponent::GetMapComponent(&SpawnedActor))
+			{
+				MapComponent->SetPoolObjectHandle(CreatedObject.Handle);
+			}
+		}
+	};
+
+	UPoolManagerSubsystem::Get().TakeFromPool(InOutRequests, OnCompleted);
+
+	// --- Add handles if requested spawning, so they can be canceled if regenerate before spawning finished
+	for (const FSpawnRequest& It : InOutRequests)
+	{
+		checkf(It.Handle.IsValid(), TEXT("ERROR: [%i] %s:\n'Handle' is not valid!"), __LINE__, *FString(__FUNCTION__));
+		MapComponentsInternal.FindOrAdd(It.Handle);
+	}
+}
+
+// Is called when pools have spawned requested level actors of given generation
+void AGeneratedMap::OnSpawnedPendingActors(const TArray<FPoolObjectData>& CreatedObjects, uint32 SpawnGeneration)
+{
+	if (SpawnGeneration != SpawnGenerationInternal)
+	{
+		// Is spawned by the previous generation that was already replaced
+		return;
+	}
+
+	// Setup spawned actors
+	for (const FPoolObjectData& CreatedObject : CreatedObjects)
+	{
+		AActor& SpawnedActor = CreatedObject.GetChecked<AActor>();
+		SpawnedActor.SetFlags(RF_Transient); // Do not save generated actors into the map
+		SpawnedActor.SetOwner(this);
+
+		if (UMapComponent* MapComponent = UMapComponent::GetMapComponent(&SpawnedActor))
+		{
+			MapComponent->SetPoolObjectHandle(CreatedObject.Handle);
+		}
+	}
+
+	MapComponentsInternal.MarkArrayDirty();
+
+	--PendingSpawnBatchesNumInternal;
+	SpawnedNumInternal += CreatedObjects.Num();
+
+	const bool bIsCompleted = PendingSpawnsInternal.IsEmpty() && PendingSpawnBatchesNumInternal <= 0;
+	SetGenerationProgress(bIsCompleted || !SpawnsNumInternal ? 1.f : static_cast<float>(SpawnedNumInternal) / SpawnsNumInternal);
+
+	if (bIsCompleted)
+	{
+		OnFinishedSpawningGeneratedActors();
+		OnGeneratedLevelActors.Broadcast();
+	}
+}
+
+// Remembers how long the last generation was spawned
+void AGeneratedMap::OnFinishedSpawningGeneratedActors()
+{
+	// Is negative only if spawning was started by the generation
+	if (LastSpawnTimeInternal < 0.f)
+	{
+		LastSpawnTimeInternal = static_cast<float>(FPlatformTime::Seconds() - GenerationStartTimeInternal);
+	}
+
+	// Actors of the previous size that are not reused by the new level are left inactive in pools
+	if (bShrinkPoolsOnResizeInternal)
+	{
+		ShrinkPools();
+	}
+}
+
+// Sets the spawning progress and notifies listeners
+void AGeneratedMap::SetGenerationProgress(float NewProgress)
+{
+	NewProgress = FMath::Clamp(NewProgress, 0.f, 1.f);
+	if (NewProgress == GenerationProgressInternal)
+	{
+		return;
+	}
+
+	GenerationProgressInternal = NewProgress;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, GenerationProgressInternal, this);
+	OnRep_GenerationProgress();
+}
+
+// Is called on client to broadcast On Generation Progress Changed delegate
+void AGeneratedMap::OnRep_GenerationProgress()
+{
+	if (OnGenerationProgressChanged.IsBound())
+	{
+		OnGenerationProgressChanged.Broadcast(GenerationProgressInternal);
+	}
+}
+
+// The function that places the actor on the Generated Map, attaches it and writes this actor to the GridArray_
+void AGeneratedMap::AddToGrid(UMapComponent* AddedComponent)
+{
+	AActor* ComponentOwner = AddedComponent ? AddedComponent->GetOwner() : nullptr;
+	if (!HasAuthority()
+	    || !ComponentOwner
+	    || !ComponentOwner->HasAuthority())
+	{
+		return;
+	}
+
+	// Is searched only once per taking from the pool, since the owner is added to the grid before the spawn callback
+	if (!AddedComponent->GetPoolObjectHandle().IsValid())
+	{
+		AddedComponent->SetPoolObjectHandle(UPoolManagerSubsystem::Get().FindPoolHandleByObject(ComponentOwner));
+	}
+
+	const FPoolObjectHandle& Handle = AddedComponent->GetPoolObjectHandle();
+	if (!ensureMsgf(Handle.IsValid(), TEXT("ASSERT: [%i] %s:\n'Handle' is not valid, this object has to be known by Pool Manager!"), __LINE__, *FString(__FUNCTION__)))
 	{
 		return;
 	}
@@ -405,34 +1102,63 @@ void AGeneratedMap::AddToGrid(UMapComponent* AddedComponent)
 
 	// If found, means was spawned before, otherwise is taken from pool
 	FMapComponentSpec& NewSpec = MapComponentsInternal.FindOrAdd(Handle);
-	NewSpec.MapComponent = AddedComponent;
-	NewSpec.Cell = Cell;
-	MapComponentsInternal.MarkItemDirty(NewSpec);
+	MapComponentsInternal.SetMapComponent(NewSpec, AddedComponent, Cell);
+
+	UpdateCellActorTypes(Cell);
 
-	// Find transform
-	FRotator ActorRotation = GetActorRotation();
 	const EActorType ActorType = AddedComponent->GetActorType();
+
+	// Attach to the Generated Map actor
+	if (!ComponentOwner->IsAttachedTo(this)
+	    && ActorType != EAT::Player)
+	{
+		// Do not attach players to level since they have to move on level freely
+		ComponentOwner->AttachToActor(this, FAttachmentTransformRules::KeepWorldTransform);
+	}
+
+	// Locate actor on cell
+	ComponentOwner->SetActorTransform(GetLevelActorTransform(Cell, ActorType));
+
+	// Move its instance if is drawn by the Generated Map
+	AddedComponent->UpdateInstancedMesh();
+
+	// Level actors spawned while the server is idle, e.g: on regenerating the level in the Menu, do not tick until the server is active
+	AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(this);
+	if (MyGameState
+	    && MyGameState->IsServerIdle())
+	{
+		MyGameState->PauseTickWhileIdle(*ComponentOwner);
+	}
+}
+
+// Returns the transform of a level actor of given type located on specified cell
+FTransform AGeneratedMap::GetLevelActorTransform(const FCell& Cell, EActorType ActorType) const
+{
+	FRotator ActorRotation = GetActorRotation();
 	if (TO_FLAG(ActorType) & TO_FLAG(EAT::Box | EAT::Wall))
 	{
-		// Random rotate if is Box or Wall
+		// Random rotate if is Box or Wall, the stream is seeded by the cell to be the same on clients
 		static constexpr float RotationMultiplier = 90.f;
 		static constexpr int32 MinRange = 1;
 		static constexpr int32 MaxRange = 4;
-		ActorRotation.Yaw += FMath::RandRange(MinRange, MaxRange) * RotationMultiplier;
+		const FRandomStream CellStream = GetCellRandomStream(Cell);
+		ActorRotation.Yaw += CellStream.RandRange(MinRange, MaxRange) * RotationMultiplier;
 	}
 	static constexpr float HeightAdditive = 100.f;
 	const FVector ActorLocation{Cell.X(), Cell.Y(), Cell.Z() + HeightAdditive};
 
-	// Attach to the Generated Map actor
-	if (!ComponentOwner->IsAttachedTo(this)
-	    && ActorType != EAT::Player)
+	return FTransform(ActorRotation, ActorLocation, FVector::OneVector);
+}
+
+// Returns the stream seeded by the generation seed and given cell
+FRandomStream AGeneratedMap::GetCellRandomStream(const FCell& Cell, int32 Salt/* = 0*/) const
+{
+	uint32 Seed = HashCombine(GetTypeHash(GenerationSeedInternal), GetTypeHash(GetCellIndex(Cell)));
+	if (Salt)
 	{
-		// Do not attach players to level since they have to move on level freely
-		ComponentOwner->AttachToActor(this, FAttachmentTransformRules::KeepWorldTransform);
+		Seed = HashCombine(Seed, GetTypeHash(Salt));
 	}
-
-	// Locate actor on cell
-	ComponentOwner->SetActorTransform(FTransform(ActorRotation, ActorLocation, FVector::OneVector));
+	return FRandomStream(static_cast<int32>(Seed));
 }
 
 // The intersection of (OutCells ∩ ActorsTypesBitmask).
@@ -441,91 +1167,138 @@ void AGeneratedMap::IntersectCellsByTypes(
 	int32 ActorsTypesBitmask,
 	bool bIntersectAllIfEmpty) const
 {
+	GENERATED_MAP_STAT_SCOPE(IntersectCellsByTypes);
+
 	if (!GridCellsInternal.Num()                       // nothing to intersect
 	    || !bIntersectAllIfEmpty && !InOutCells.Num()) // should not intersect with all existed cells but the specified array is empty
 	{
 		return;
 	}
 
-	if (!ActorsTypesBitmask)
+	if (InOutCells.Num())
 	{
-		// Find all empty grid cell locations where non of actors are present
-		const FCells AllEmptyCells = FCells(
-			GridCellsInternal.FilterByPredicate([&MapComponents = MapComponentsInternal](const FCell& CellIt)
-			{
-				return !MapComponents.Contains(CellIt);
-			}));
-
-		if (InOutCells.Num())
-		{
-			InOutCells = InOutCells.Intersect(AllEmptyCells);
-		}
-		else
+		// Filter specified cells in place
+		for (FCells::TIterator It = InOutCells.CreateIterator(); It; ++It)
 		{
-			InOutCells = AllEmptyCells;
+			if (!DoesCellMatchActorTypes(*It, ActorsTypesBitmask))
+			{
+				It.RemoveCurrent();
+			}
 		}
-
 		return;
 	}
 
-	FMapComponents BitmaskedComponents;
-	GetMapComponents(BitmaskedComponents, ActorsTypesBitmask);
-	if (!BitmaskedComponents.Num())
+	// Specified set is empty, so take matching cells from the whole grid
+	FCellsBitboard MatchingCells;
+	GetCellsBitboard(MatchingCells, ActorsTypesBitmask);
+	InOutCells.Reserve(MatchingCells.CountSetBits());
+	MatchingCells.ForEachSetBit([this, &InOutCells](int32 CellIndex)
+	{
+		InOutCells.Emplace(GridCellsInternal[CellIndex]);
+	});
+}
+
+// Destroy all actors from the set of cells
+void AGeneratedMap::DestroyLevelActorsOnCells(const FCells& Cells, UObject* DestroyCauser/* = nullptr*/)
+{
+	GENERATED_MAP_STAT_SCOPE(DestroyLevelActorsOnCells);
+
+	if (!HasAuthority()
+	    || !MapComponentsInternal.Num()
+	    || !Cells.Num())
 	{
-		InOutCells.Empty(); // nothing found, returns empty OutCells array
 		return;
 	}
 
-	FCells BitmaskedCells;
-	for (const UMapComponent* MapCompIt : BitmaskedComponents)
+	const double StartTime = FPlatformTime::Seconds();
+
+	// --- Collect victims by their cells
+	TArray<int32, TInlineAllocator<32>> VictimIndices;
+	for (const FCell& CellIt : Cells)
 	{
-		if (MapCompIt)
-		{
-			BitmaskedCells.Emplace(MapCompIt->GetCell());
-		}
+		TArray<int32, TInlineAllocator<4>> FoundIndices;
+		MapComponentsInternal.FindIndices(CellIt, FoundIndices);
+		VictimIndices.Append(FoundIndices);
 	}
 
-	if (InOutCells.Num())
+	if (!VictimIndices.Num())
 	{
-		InOutCells = InOutCells.Intersect(BitmaskedCells);
+		return;
 	}
-	else
+
+	TArray<UMapComponent*, TInlineAllocator<32>> Victims;
+	for (const int32 VictimIndexIt : VictimIndices)
 	{
-		InOutCells = BitmaskedCells;
+		Victims.AddUnique(MapComponentsInternal[VictimIndexIt]);
 	}
-}
 
-// Destroy all actors from the set of cells
-void AGeneratedMap::DestroyLevelActorsOnCells(const FCells& Cells, UObject* DestroyCauser/* = nullptr*/)
-{
-	if (!HasAuthority()
-	    || !MapComponentsInternal.Num()
-	    || !Cells.Num())
+	// --- Remove all victims from the grid at once
+	// First removing, because after the box destroying the item can be spawned and starts searching for an empty cell
+	MapComponentsInternal.RemoveAtIndices(VictimIndices);
+	for (const FCell& CellIt : Cells)
 	{
-		return;
+		UpdateCellActorTypes(CellIt);
 	}
 
-	// Iterate and destroy
-	for (int32 Index = MapComponentsInternal.Num() - 1; Index >= 0; --Index)
+	// --- Deactivate victims and return them to the pool in one batch, actors spawned by victims (like items by boxes) are collected
+	++SpawnBatchDepthInternal;
+	const bool bIsInGame = AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame;
+	UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+	TArray<FPoolObjectHandle> HandlesToReturn;
+	int32 ReturnedActorTypes = 0;
+	bool bAnyCharacterDestroyed = false;
+	for (UMapComponent* VictimIt : Victims)
 	{
-		if (!MapComponentsInternal.IsValidIndex(Index)) // the element already was removed
+		AActor* OwnerToDestroy = DeactivateLevelActor(VictimIt, DestroyCauser);
+		if (!OwnerToDestroy)
 		{
 			continue;
 		}
 
-		UMapComponent* MapComponentIt = MapComponentsInternal[Index];
-		const AActor* OwnerIt = MapComponentIt ? MapComponentIt->GetOwner() : nullptr;
-		if (!OwnerIt                                                        // if is null, destroy that object from the array
-		    || MapComponentIt && Cells.Contains(MapComponentIt->GetCell())) // the cell is contained on the grid
+		bAnyCharacterDestroyed |= bIsInGame && VictimIt->GetActorType() == EAT::Player;
+
+		// The cached handle means the owner is taken from the pool
+		if (VictimIt->GetPoolObjectHandle().IsValid())
 		{
-			// Remove from the array
-			// First removing, because after the box destroying the item can be spawned and starts searching for an empty cell
-			// MapComponentIt can be invalid here
-			DestroyLevelActor(MapComponentIt, DestroyCauser);
+			HandlesToReturn.Emplace(VictimIt->GetPoolObjectHandle());
+			VictimIt->SetPoolObjectHandle(FPoolObjectHandle::EmptyHandle);
+			ReturnedActorTypes |= TO_FLAG(VictimIt->GetActorType());
+		}
+		else
+		{
+			OwnerToDestroy->Destroy();
 		}
 	}
-	MapComponentsInternal.Items.Shrink();
-	MapComponentsInternal.MarkArrayDirty();
+
+	if (HandlesToReturn.Num())
+	{
+		PoolManager.ReturnToPool(HandlesToReturn);
+		RequestPoolsShrink(ReturnedActorTypes);
+	}
+
+	--SpawnBatchDepthInternal;
+	if (!SpawnBatchDepthInternal)
+	{
+		SpawnBatchedActors();
+	}
+
+	for (const UMapComponent* VictimIt : Victims)
+	{
+		DestroyLevelActorDragged(VictimIt);
+	}
+
+	if (UMatchPerformanceSubsystem* MatchPerformanceSubsystem = UMatchPerformanceSubsystem::GetMatchPerformanceSubsystem(this))
+	{
+		MatchPerformanceSubsystem->AddDestroyLevelActorsTime(FPlatformTime::Seconds() - StartTime);
+	}
+
+	FBomberTelemetry::RecordStepTiming(TEXT("DestroyLevelActors"), FPlatformTime::Seconds() - StartTime);
+
+	if (bAnyCharacterDestroyed
+	    && OnAnyCharacterDestroyed.IsBound())
+	{
+		OnAnyCharacterDestroyed.Broadcast();
+	}
 }
 
 // Destroy level actor by specified Map Component from the level
@@ -541,37 +1314,35 @@ void AGeneratedMap::DestroyLevelActor(UMapComponent* MapComponent, UObject* Dest
 	// Remove from the array (MapComponent can be invalid)
 	MapComponentsInternal.Remove(MapComponent);
 
+	if (MapComponent)
+	{
+		UpdateCellActorTypes(MapComponent->GetCell());
+	}
+
 	if (!ComponentOwner)
 	{
 		return;
 	}
 
-	const bool bIsPlayer = MapComponent->GetActorType() == EAT::Player;
-	const bool bIsInGame = AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame;
-
-	if (bIsInGame
-	    && MapComponent->IsUndestroyable())
+	if (!DeactivateLevelActor(MapComponent, DestroyCauser))
 	{
-		// Do not destroy actor during the game session if required
 		return;
 	}
 
-	if (bIsPlayer)
+	if (MapComponent->GetActorType() == EAT::Player
+	    && AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame
+	    && OnAnyCharacterDestroyed.IsBound())
 	{
-		if (bIsInGame
-		    && OnAnyCharacterDestroyed.IsBound())
-		{
-			OnAnyCharacterDestroyed.Broadcast();
-		}
+		OnAnyCharacterDestroyed.Broadcast();
 	}
 
-	MapComponent->OnDeactivated(DestroyCauser);
-
-	// Deactivate the iterated owner
-	UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
-	if (PoolManager.ContainsObjectInPool(ComponentOwner))
+	// Deactivate the iterated owner, the cached handle means it is taken from the pool
+	const FPoolObjectHandle PoolObjectHandle = MapComponent->GetPoolObjectHandle();
+	if (PoolObjectHandle.IsValid())
 	{
-		PoolManager.ReturnToPool(ComponentOwner);
+		MapComponent->SetPoolObjectHandle(FPoolObjectHandle::EmptyHandle);
+		UPoolManagerSubsystem::Get().ReturnToPool(PoolObjectHandle);
+		RequestPoolsShrink(TO_FLAG(MapComponent->GetActorType()));
 	}
 	else
 	{
@@ -581,6 +1352,36 @@ void AGeneratedMap::DestroyLevelActor(UMapComponent* MapComponent, UObject* Dest
 	DestroyLevelActorDragged(MapComponent);
 }
 
+// Deactivates the owner of specified Map Component that is already removed from the grid
+AActor* AGeneratedMap::DeactivateLevelActor(UMapComponent* MapComponent, UObject* DestroyCauser)
+{
+	AActor* ComponentOwner = MapComponent ? MapComponent->GetOwner() : nullptr;
+	if (!ComponentOwner)
+	{
+		return nullptr;
+	}
+
+	const bool bIsInGame = AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame;
+	if (bIsInGame
+	    && MapComponent->IsUndestroyable())
+	{
+		// Do not destroy actor during the game session if required
+		return nullptr;
+	}
+
+	if (bIsInGame)
+	{
+		// Both single and batched destructions are reported here
+		const APlayerCharacter* Killer = MapComponent->GetActorType() == EAT::Player ? Cast<APlayerCharacter>(DestroyCauser) : nullptr;
+		const int32 KillerID = Killer ? Killer->GetCharacterID() : INDEX_NONE;
+		DispatchGridEvent(EGridReplayEventType::ActorDestroyed, MapComponent->GetCell(), INDEX_NONE, static_cast<uint8>(MapComponent->GetActorType()), ComponentOwner, KillerID);
+	}
+
+	MapComponent->OnDeactivated(DestroyCauser);
+
+	return ComponentOwner;
+}
+
 // Destroys level actor by specified handle
 void AGeneratedMap::DestroyLevelActorByHandle(const FPoolObjectHandle& Handle, UObject* DestroyCauser)
 {
@@ -608,16 +1409,78 @@ void AGeneratedMap::DestroyLevelActorByHandle(const FPoolObjectHandle& Handle, U
 	MapComponentsInternal.Remove(Handle);
 }
 
-// Finds the nearest cell pointer to the specified Map Component
-void AGeneratedMap::SetNearestCell(UMapComponent* MapComponent)
+// Reports the grid event to all its listeners, so gameplay code reports each event once
+void AGeneratedMap::DispatchGridEvent(EGridReplayEventType Type, const FCell& Cell, int32 Value/* = INDEX_NONE*/, uint8 Param/* = 0*/, UObject* Source/* = nullptr*/, int32 TelemetryData/* = INDEX_NONE*/)
 {
-	const AActor* ComponentOwner = MapComponent ? MapComponent->GetOwner() : nullptr;
-	if (!HasAuthority()
-	    || !ComponentOwner
-	    || !ComponentOwner->HasAuthority())
+	if (HasAuthority())
 	{
-		return;
-	}
+		if (UGridReplaySubsystem* GridReplaySubsystem = UGridReplaySubsystem::GetGridReplaySubsystem(this))
+		{
+			GridReplaySubsystem->RecordEvent(Type, Cell, Value, Param);
+		}
+
+		if (UGridSpectatorSubsystem* GridSpectatorSubsystem = UGridSpectatorSubsystem::GetGridSpectatorSubsystem(this))
+		{
+			GridSpectatorSubsystem->AddEvent(Type, Cell, Value, Param);
+		}
+
+		if (FBomberTelemetry::IsEnabled())
+		{
+			const int32 CellIndex = GetCellIndex(Cell);
+			switch (Type)
+			{
+				case EGridReplayEventType::BombPlaced:
+					FBomberTelemetry::RecordEvent(EBomberTelemetryEvent::BombPlaced, CellIndex, Value, TelemetryData);
+					break;
+				case EGridReplayEventType::BombDetonated:
+					FBomberTelemetry::RecordEvent(EBomberTelemetryEvent::BombDetonated, CellIndex, Value, TelemetryData);
+					break;
+				case EGridReplayEventType::ItemPicked:
+					FBomberTelemetry::RecordEvent(EBomberTelemetryEvent::ItemPickedUp, CellIndex, Value, Param);
+					break;
+				case EGridReplayEventType::ActorDestroyed:
+					if (const APlayerCharacter* DiedPlayer = Cast<APlayerCharacter>(Source))
+					{
+						FBomberTelemetry::RecordEvent(EBomberTelemetryEvent::PlayerDied, CellIndex, DiedPlayer->GetCharacterID(), TelemetryData);
+					}
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	UCosmeticEventsSubsystem* CosmeticEventsSubsystem = UCosmeticEventsSubsystem::GetCosmeticEventsSubsystem(this);
+	if (!CosmeticEventsSubsystem)
+	{
+		return;
+	}
+
+	switch (Type)
+	{
+		case EGridReplayEventType::ActorDestroyed:
+			CosmeticEventsSubsystem->AddEvent(ECosmeticEventType::ActorDestroyed, Cell, static_cast<EActorType>(Param), Source);
+			break;
+		case EGridReplayEventType::ItemPicked:
+			CosmeticEventsSubsystem->AddEvent(ECosmeticEventType::ItemPicked, Cell, EAT::Item, Source);
+			break;
+		default:
+			break;
+	}
+}
+
+// Finds the nearest cell pointer to the specified Map Component
+void AGeneratedMap::SetNearestCell(UMapComponent* MapComponent)
+{
+	GENERATED_MAP_STAT_SCOPE(SetNearestCell);
+
+	const AActor* ComponentOwner = MapComponent ? MapComponent->GetOwner() : nullptr;
+	if (!HasAuthority()
+	    || !ComponentOwner
+	    || !ComponentOwner->HasAuthority())
+	{
+		return;
+	}
 
 	const FCell CurrentCellByLocation = ComponentOwner->GetActorLocation();
 
@@ -634,6 +1497,11 @@ void AGeneratedMap::SetNearestCell(UMapComponent* MapComponent)
 	SetNearestCellDragged(MapComponent, FoundFreeCell);
 
 	MapComponent->SetCell(FoundFreeCell);
+	MapComponentsInternal.UpdateIndices(MapComponent);
+
+	// Move the owner in the occupancy grid
+	UpdateCellActorTypes(LastCell);
+	UpdateCellActorTypes(FoundFreeCell);
 }
 
 // Change level by type
@@ -645,9 +1513,83 @@ void AGeneratedMap::SetLevelType(ELevelType NewLevelType)
 	}
 
 	LevelTypeInternal = NewLevelType;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, LevelTypeInternal, this);
 	ApplyLevelType();
 }
 
+// Loads the streaming level of given type hidden in background and prestreams meshes of level actors for it
+void AGeneratedMap::PreloadLevelType(ELevelType LevelType)
+{
+	// Dedicated server never shows the Menu, so it loads only the level type that is applied and skips cosmetic preloads
+	UWorld* World = GetWorld();
+	if (!World
+	    || !World->IsGameWorld()
+	    || World->GetNetMode() == NM_DedicatedServer
+	    || LevelType == ELT::None)
+	{
+		return;
+	}
+
+	// Level types of not installed chunks are requested to be installed in background, so they could be preloaded next time
+	const UGeneratedMapDataAsset& GeneratedMapDataAsset = UGeneratedMapDataAsset::Get();
+	if (!GeneratedMapDataAsset.IsLevelTypeInstalled(LevelType))
+	{
+		GeneratedMapDataAsset.RequestLevelTypeInstall(LevelType);
+		return;
+	}
+
+	// Preloaded level is expected to be selected soon, so it's kept within the budget of loaded levels
+	TouchRecentLevelType(LevelType);
+
+	TArray<FLevelStreamRow> LevelStreamRows;
+	GeneratedMapDataAsset.GetLevelStreamRows(LevelStreamRows);
+	for (int32 Index = 0; Index < LevelStreamRows.Num(); ++Index)
+	{
+		const FLevelStreamRow& LevelStreamRowIt = LevelStreamRows[Index];
+		const FName PackageName = *LevelStreamRowIt.Level.GetLongPackageName();
+		if (LevelStreamRowIt.LevelType != LevelType
+		    || PackageName.IsNone())
+		{
+			continue;
+		}
+
+		const ULevelStreaming* LevelStreaming = UGameplayStatics::GetStreamingLevel(World, PackageName);
+		if (LevelStreaming
+		    && !LevelStreaming->IsLevelLoaded())
+		{
+			// Same UUID as in ApplyLevelType, so the latent load is shared if this level type is applied while it is still loading
+			FLatentActionInfo LatentInfo;
+			LatentInfo.UUID = Index;
+			constexpr bool bMakeVisibleAfterLoad = false;
+			constexpr bool bShouldBlockOnLoad = false;
+			UGameplayStatics::LoadStreamLevel(World, PackageName, bMakeVisibleAfterLoad, bShouldBlockOnLoad, LatentInfo);
+		}
+	}
+
+	// Meshes are hard referenced by rows, but their LODs are streamed in on first render, so request them in advance
+	const float PrestreamSeconds = CVarPrestreamMeshesSeconds.GetValueOnAnyThread();
+	if (PrestreamSeconds <= 0.f
+	    || !FApp::CanEverRender())
+	{
+		return;
+	}
+
+	TArray<ULevelActorDataAsset*> ActorsDataAssets;
+	UDataAssetsContainer::GetDataAssetsByActorTypes(ActorsDataAssets, TO_FLAG(EAT::All));
+	for (const ULevelActorDataAsset* DataAssetIt : ActorsDataAssets)
+	{
+		TArray<ULevelActorRow*> Rows;
+		DataAssetIt->GetRowsByLevelType(Rows, TO_FLAG(LevelType));
+		for (const ULevelActorRow* RowIt : Rows)
+		{
+			if (RowIt && RowIt->Mesh)
+			{
+				RowIt->Mesh->SetForceMipLevelsToBeResident(PrestreamSeconds);
+			}
+		}
+	}
+}
+
 // Returns true if specified map component has non-generated owner that is manually dragged to the scene
 bool AGeneratedMap::IsDraggedMapComponent(const UMapComponent* MapComponent) const
 {
@@ -701,6 +1643,37 @@ FTransform AGeneratedMap::ActorTransformToGridTransform(const FTransform& ActorT
 	return MoveTemp(NewTransform);
 }
 
+// Returns the row-major index of given cell on the grid or INDEX_NONE if the cell is not on the level
+int32 AGeneratedMap::GetCellIndex(const FCell& Cell) const
+{
+	const int32* FoundIndex = CellIndicesInternal.Find(Cell);
+	return FoundIndex ? *FoundIndex : INDEX_NONE;
+}
+
+// Returns the row-major index of the grid cell nearest to given location in constant time
+int32 AGeneratedMap::GetNearestCellIndex(const FVector& Location) const
+{
+	const int32 MaxWidth = GridSizeInternal.X;
+	const int32 MaxLength = GridSizeInternal.Y;
+	if (!MaxWidth
+	    || !MaxLength
+	    || GridCellsInternal.Num() != MaxWidth * MaxLength)
+	{
+		return INDEX_NONE;
+	}
+
+	// Grid axes are taken from neighbour cells, so they match the cells even on rotated grids
+	const FVector& FirstCell = GridCellsInternal[0].Location;
+	const FQuat GridRotation = GridTransformInternal.GetRotation();
+	const FVector AxisX = MaxWidth > 1 ? (GridCellsInternal[1].Location - FirstCell).GetSafeNormal2D() : GridRotation.GetForwardVector();
+	const FVector AxisY = MaxLength > 1 ? (GridCellsInternal[MaxWidth].Location - FirstCell).GetSafeNormal2D() : GridRotation.GetRightVector();
+
+	const FVector Offset = Location - FirstCell;
+	const int32 Column = FMath::Clamp(FMath::RoundToInt32(FVector::DotProduct(Offset, AxisX) / FCell::CellSize), 0, MaxWidth - 1);
+	const int32 Row = FMath::Clamp(FMath::RoundToInt32(FVector::DotProduct(Offset, AxisY) / FCell::CellSize), 0, MaxLength - 1);
+	return Row * MaxWidth + Column;
+}
+
 /* ---------------------------------------------------
  *		Generated Map protected functions
  * --------------------------------------------------- */
@@ -716,6 +1689,8 @@ void AGeneratedMap::OnConstruction(const FTransform& Transform)
 // Initialize this Generated Map actor, could be called multiple times
 void AGeneratedMap::OnConstructionGeneratedMap(const FTransform& Transform)
 {
+	STARTUP_TIMING_SCOPE(OnConstructionGeneratedMap);
+
 	if (IS_TRANSIENT(this)) // the Generated Map is transient
 	{
 		return;
@@ -727,7 +1702,7 @@ void AGeneratedMap::OnConstructionGeneratedMap(const FTransform& Transform)
 	    && !UMyUnrealEdEngine::GOnAnyDataAssetChanged.IsBoundToObject(this))
 	{
 		// Should be bind in construction in a case of object reconstructing after blueprint compile
-		UMyUnrealEdEngine::GOnAnyDataAssetChanged.AddUObject(this, &ThisClass::RerunConstructionScripts);
+		UMyUnrealEdEngine::GOnAnyDataAssetChanged.AddUObject(this, &ThisClass::OnAnyDataAssetChanged);
 	}
 #endif //WITH_EDITOR [GEditor]
 
@@ -791,14 +1766,28 @@ void AGeneratedMap::PostInitializeComponents()
 	// Update the gameplay GeneratedMap reference in the singleton library
 	UGeneratedMapSubsystem::Get().SetGeneratedMap(this);
 
+	// Is done before the first generation, so it takes already created actors
+	WarmUpPools();
+
 	ConstructGeneratedMap(GetActorTransform());
 
+	// Load level types in background within the budget of loaded levels, so switching them in the Menu does not wait for streaming
+	if (CVarPreloadLevelTypes.GetValueOnAnyThread()
+	    && GetNetMode() != NM_DedicatedServer)
+	{
+		const int32 MaxLoadedLevelTypes = UGeneratedMapDataAsset::Get().GetRecentLevelTypesNum() + 1;
+		for (int32 LevelFlag = ELT_FIRST_FLAG; LevelFlag <= ELT_LAST_FLAG && RecentLevelTypesInternal.Num() < MaxLoadedLevelTypes; LevelFlag <<= 1)
+		{
+			PreloadLevelType(TO_ENUM(ELevelType, LevelFlag));
+		}
+	}
+
 	if (HasAuthority())
 	{
 		// Listen states
 		if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 		{
-			MyGameState->OnGameStateChanged.AddDynamic(this, &ThisClass::OnGameStateChanged);
+			MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 			// Handle current game state if initialized with delay
 			if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -809,6 +1798,198 @@ void AGeneratedMap::PostInitializeComponents()
 	}
 }
 
+// Pre-creates inactive level actors in the pools
+void AGeneratedMap::WarmUpPools()
+{
+	WarmUpPoolsByTypes(UGeneratedMapDataAsset::Get().GetPoolWarmUpCounts());
+}
+
+// Pre-creates given number of inactive level actors of each type in the pools
+void AGeneratedMap::WarmUpPoolsByTypes(const TMap<EActorType, int32>& ActorsNumByTypes)
+{
+	UWorld* World = GetWorld();
+	if (!HasAuthority()
+	    || !World)
+	{
+		return;
+	}
+
+	UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+	for (const TTuple<EActorType, int32>& It : ActorsNumByTypes)
+	{
+		UClass* ActorClass = UDataAssetsContainer::GetActorClassByType(It.Key);
+		if (!ActorClass)
+		{
+			continue;
+		}
+
+		for (int32 Index = 0; Index < It.Value; ++Index)
+		{
+			AActor* SpawnedActor = World->SpawnActorDeferred<AActor>(ActorClass, FTransform::Identity, this);
+			if (!SpawnedActor)
+			{
+				continue;
+			}
+
+			SpawnedActor->SetFlags(RF_Transient); // Do not save generated actors into the map
+
+			// Is registered as inactive before the construction, so its map component is not added to the grid
+			FPoolObjectData ObjectData(SpawnedActor);
+			ObjectData.bIsActive = false;
+			PoolManager.RegisterObjectInPool(ObjectData);
+
+			SpawnedActor->FinishSpawning(FTransform::Identity);
+		}
+	}
+}
+
+// Remembers that level actors of given types are returned to pools and delays shrinking of these pools by their policies
+void AGeneratedMap::RequestPoolsShrink(int32 ActorTypesBitmask)
+{
+	UWorld* World = GetWorld();
+	if (!HasAuthority()
+	    || !World)
+	{
+		return;
+	}
+
+	// Pools limited only by the max count are shrunk shortly after, so returns of one chain reaction are handled at once
+	static constexpr float MaxInactiveShrinkDelay = 1.f;
+	float ShrinkDelay = MAX_flt;
+	const double CurrentTime = World->GetTimeSeconds();
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		const int32 ActorType = 1 << TypeIndex;
+		const ULevelActorDataAsset* DataAsset = (ActorType & ActorTypesBitmask) ? UDataAssetsContainer::GetDataAssetByActorType(TO_ENUM(EActorType, ActorType)) : nullptr;
+		if (!DataAsset)
+		{
+			continue;
+		}
+
+		PoolReturnTimesInternal[TypeIndex] = CurrentTime;
+
+		const FLevelActorPoolPolicy& PoolPolicy = DataAsset->GetPoolPolicy();
+		if (PoolPolicy.MaxInactiveNum > 0)
+		{
+			ShrinkDelay = FMath::Min(ShrinkDelay, MaxInactiveShrinkDelay);
+		}
+		if (PoolPolicy.ShrinkAfterIdleSeconds > 0.f)
+		{
+			ShrinkDelay = FMath::Min(ShrinkDelay, PoolPolicy.ShrinkAfterIdleSeconds);
+		}
+	}
+
+	// Is not postponed if already scheduled sooner
+	FTimerManager& TimerManager = World->GetTimerManager();
+	if (ShrinkDelay != MAX_flt
+	    && (!TimerManager.IsTimerActive(ShrinkPoolsTimerInternal) || TimerManager.GetTimerRemaining(ShrinkPoolsTimerInternal) > ShrinkDelay))
+	{
+		constexpr bool bLoop = false;
+		TimerManager.SetTimer(ShrinkPoolsTimerInternal, this, &ThisClass::ShrinkPools, ShrinkDelay, bLoop);
+	}
+}
+
+// Destroys inactive level actors in pools over limits of pool policies of their types
+void AGeneratedMap::ShrinkPools()
+{
+	UWorld* World = GetWorld();
+	if (!HasAuthority()
+	    || !World)
+	{
+		return;
+	}
+
+	// Inactive actors are about to be taken by the generation in progress, so pools are shrunk again once it's likely finished
+	if (!PendingSpawnsInternal.IsEmpty()
+	    || PendingSpawnBatchesNumInternal > 0)
+	{
+		static constexpr float GenerationRetryDelay = 1.f;
+		constexpr bool bLoop = false;
+		World->GetTimerManager().SetTimer(ShrinkPoolsTimerInternal, this, &ThisClass::ShrinkPools, GenerationRetryDelay, bLoop);
+		return;
+	}
+
+	// --- Find how many inactive actors are kept by each class
+	const TMap<EActorType, int32>& PoolWarmUpCounts = UGeneratedMapDataAsset::Get().GetPoolWarmUpCounts();
+	const double CurrentTime = World->GetTimeSeconds();
+	float NextShrinkDelay = MAX_flt;
+	TMap<const UClass*, int32, TInlineSetAllocator<ActorTypesNum>> KeptNumByClass;
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		const EActorType ActorType = TO_ENUM(EActorType, 1 << TypeIndex);
+		const ULevelActorDataAsset* DataAsset = UDataAssetsContainer::GetDataAssetByActorType(ActorType);
+		const UClass* ActorClass = UDataAssetsContainer::GetActorClassByType(ActorType);
+		if (!DataAsset
+		    || !ActorClass)
+		{
+			continue;
+		}
+
+		const FLevelActorPoolPolicy& PoolPolicy = DataAsset->GetPoolPolicy();
+		const int32* WarmUpNum = PoolWarmUpCounts.Find(ActorType);
+		const int32 MinKeptNum = WarmUpNum ? *WarmUpNum : 0;
+		int32 KeptNum = PoolPolicy.MaxInactiveNum > 0 ? FMath::Max(PoolPolicy.MaxInactiveNum, MinKeptNum) : MAX_int32;
+
+		if (PoolPolicy.ShrinkAfterIdleSeconds > 0.f)
+		{
+			const double IdleSeconds = CurrentTime - PoolReturnTimesInternal[TypeIndex];
+			if (IdleSeconds + KINDA_SMALL_NUMBER >= PoolPolicy.ShrinkAfterIdleSeconds)
+			{
+				KeptNum = MinKeptNum;
+			}
+			else
+			{
+				NextShrinkDelay = FMath::Min(NextShrinkDelay, static_cast<float>(PoolPolicy.ShrinkAfterIdleSeconds - IdleSeconds));
+			}
+		}
+
+		if (bShrinkPoolsOnResizeInternal
+		    && PoolPolicy.bShrinkOnLevelResize)
+		{
+			KeptNum = MinKeptNum;
+		}
+
+		if (KeptNum != MAX_int32)
+		{
+			KeptNumByClass.Emplace(ActorClass, KeptNum);
+		}
+	}
+	bShrinkPoolsOnResizeInternal = false;
+
+	// --- Destroy inactive actors over the kept number in one pass through all pools
+	if (!KeptNumByClass.IsEmpty())
+	{
+		UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+		TMap<const UClass*, int32, TInlineSetAllocator<ActorTypesNum>> InactiveNumByClass;
+		int32 DestroyedNum = 0;
+		PoolManager.EmptyAllByPredicate([&PoolManager, &KeptNumByClass, &InactiveNumByClass, &DestroyedNum](const UObject* Object)
+		{
+			const int32* KeptNum = Object ? KeptNumByClass.Find(Object->GetClass()) : nullptr;
+			if (!KeptNum
+			    || PoolManager.GetPoolObjectState(*Object) != EPoolObjectState::Inactive)
+			{
+				return false;
+			}
+
+			const bool bShouldDestroy = ++InactiveNumByClass.FindOrAdd(Object->GetClass()) > *KeptNum;
+			DestroyedNum += bShouldDestroy ? 1 : 0;
+			return bShouldDestroy;
+		});
+
+		if (DestroyedNum)
+		{
+			UE_LOG(LogBomber, Log, TEXT("Pools are shrunk by their policies: %i inactive level actors are destroyed"), DestroyedNum);
+		}
+	}
+
+	// Pools that are not idle long enough yet are shrunk later
+	if (NextShrinkDelay != MAX_flt)
+	{
+		constexpr bool bLoop = false;
+		World->GetTimerManager().SetTimer(ShrinkPoolsTimerInternal, this, &ThisClass::ShrinkPools, NextShrinkDelay, bLoop);
+	}
+}
+
 // Called when is explicitly being destroyed to destroy level actors, not called during level streaming or gameplay ending
 void AGeneratedMap::Destroyed()
 {
@@ -835,210 +2016,1703 @@ void AGeneratedMap::Destroyed()
 #endif //WITH_EDITOR [IsEditorNotPieWorld]
 	}
 
+	// Let other match instances of this world to be resolved without this map
+	if (UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this))
+	{
+		GeneratedMapSubsystem->UnregisterGeneratedMap(this);
+	}
+
 	Super::Destroyed();
 }
 
+// Called when this actor is removed from the level, waits for the layout computation that uses the grid of this actor
+void AGeneratedMap::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WaitForLevelLayoutTask();
+	StopListeningLevelTypeInstall();
+
+	// The computed layout is not spawned anymore
+	++LevelLayoutGenerationInternal;
+	PrebuiltLevelLayoutInternal.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Adds the memory of the grid and map components containers, so they are attributed to this actor by memory reports
+void AGeneratedMap::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetGridAllocatedSize() + GetMapComponentsAllocatedSize());
+}
+
+// Returns the heap memory used by cells of the grid, their indices, occupancy, chunks and the danger map
+SIZE_T AGeneratedMap::GetGridAllocatedSize() const
+{
+	SIZE_T AllocatedSize = GridCellsInternal.GetAllocatedSize()
+	                      + CellIndicesInternal.GetAllocatedSize()
+	                      + CellActorTypesInternal.GetAllocatedSize()
+	                      + GridChunksInternal.GetAllocatedSize()
+	                      + DangerTimesInternal.GetAllocatedSize()
+	                      + DangerousCellsInternal.GetAllocatedSize()
+	                      + BombsDangerInternal.GetAllocatedSize()
+	                      + WallsBitmaskInternal.GetAllocatedSize();
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		AllocatedSize += ActorTypesBitboardsInternal[TypeIndex].GetAllocatedSize()
+		    + ActorTypesColumnBitboardsInternal[TypeIndex].GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
+
+// Returns the heap memory used by map components container, its packed mirror and the client mirror of replicated specs
+SIZE_T AGeneratedMap::GetMapComponentsAllocatedSize() const
+{
+	const FPackedMapComponents& Packed = PackedMapComponentsInternal;
+	return MapComponentsInternal.GetAllocatedSize()
+	       + Packed.CellIndices.GetAllocatedSize()
+	       + Packed.ActorTypes.GetAllocatedSize()
+	       + ReplicatedActorTypesNumInternal.GetAllocatedSize();
+}
+
 // Returns properties that are replicated for the lifetime of the actor channel
 void AGeneratedMap::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ThisClass, GridCellsInternal);
+	// The fast array is delta-replicated by its own replication keys, so it stays compared by the net driver
 	DOREPLIFETIME(ThisClass, MapComponentsInternal);
-	DOREPLIFETIME(ThisClass, LevelTypeInternal);
-	DOREPLIFETIME(ThisClass, bIsGameRunningInternal);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, GridCellsInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, LevelTypeInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, bIsGameRunningInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, GenerationSeedInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, WallsBitmaskInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, GenerationProgressInternal, Params);
 }
 
-// Spawns and fills the Grid Array values by level actors
-void AGeneratedMap::GenerateLevelActors()
+// Returns true if given cell has an actor of specified types, or is empty if none of types is specified
+bool AGeneratedMap::DoesCellMatchActorTypes(const FCell& Cell, int32 ActorsTypesBitmask) const
 {
-	if (!ensureMsgf(GridCellsInternal.Num() > 0, TEXT("Is no cells for the actors generation"))
-	    || !HasAuthority())
+	const int32 CellIndex = GetCellIndex(Cell);
+	if (CellIndex == INDEX_NONE)
 	{
-		return;
-	}
-
-	// Destroy all actors first
-	// Iterate it by handles to cancel spawning even if the actor is not spawned yet
-	TArray<FMapComponentSpec>& MapComponentsToDestroy = MapComponentsInternal.Items;
-	for (int32 Idx = MapComponentsToDestroy.Num() - 1; Idx >= 0; Idx--)
-	{
-		DestroyLevelActorByHandle(MapComponentsToDestroy[Idx].PoolObjectHandle);
+		return false;
 	}
-	checkf(MapComponentsToDestroy.IsEmpty(), TEXT("ERROR: [%i] %s:\n'MapComponentsToDestroy' is not empty after removing all!"), __LINE__, *FString(__FUNCTION__));
 
-	// Calls before generation preview actors to updating of all dragged to the Generated Map actors
-	FCells DraggedCells, DraggedWalls, DraggedItems;
-	for (const TTuple<FCell, EActorType>& It : DraggedCellsInternal)
-	{
-		const FCell& Cell = It.Key;
-		const EActorType ActorType = It.Value;
+	const int32 ActorTypesOnCell = GetActorTypesOnCellIndex(CellIndex);
+	return ActorsTypesBitmask ? (ActorTypesOnCell & ActorsTypesBitmask) != 0 : ActorTypesOnCell == TO_FLAG(EAT::None);
+}
 
-		SpawnActorByType(ActorType, Cell);
+// Returns the bitboard of cells that have actors of specified types, or of empty cells if none of types is specified
+void AGeneratedMap::GetCellsBitboard(FCellsBitboard& OutBitboard, int32 ActorsTypesBitmask) const
+{
+	OutBitboard.Init(GridCellsInternal.Num());
 
-		// Store to avoid generation on their cells
-		DraggedCells.Emplace(Cell);
-		if (ActorType == EActorType::Wall)
-		{
-			DraggedWalls.Emplace(Cell);
-		}
-		else if (ActorType == EActorType::Item)
+	// If none of types is specified, find all occupied cells to invert them into empty cells
+	const int32 TypesToCombine = ActorsTypesBitmask ? ActorsTypesBitmask : TO_FLAG(EAT::All);
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		if (TypesToCombine & (1 << TypeIndex))
 		{
-			DraggedItems.Emplace(Cell);
+			OutBitboard |= ActorTypesBitboardsInternal[TypeIndex];
 		}
 	}
 
-	/* Steps:
-	*
-	* Part 0: Actors random filling to the ArrayToGenerate.
-	* 0.1) Finding all symmetrical cells for each iterated cell;
-	*
-	* Part 1: Checking if there is a path to the each bone. If not, go to the 0 step.
-	*
-	* Part 2: Spawning these actors
-	*/
+	if (!ActorsTypesBitmask)
+	{
+		OutBitboard.Invert();
+	}
+}
 
-	const UGeneratedMapDataAsset& LevelsDataAsset = UGeneratedMapDataAsset::Get();
-	float WallsChance = LevelsDataAsset.GetWallsChance(); // Copy to decrease chance after each failed generation
-	int32 BoxesChance = LevelsDataAsset.GetBoxesChance();
-	TMap<FCell, EActorType> ActorsToSpawn;
-	int32 Counter = 0;
-	bool bFoundPath = false;
-	while (WallsChance > KINDA_SMALL_NUMBER // exit if there is no chance to generate level
-	       && !bFoundPath)                  // exit if level was generated
+// Outputs row-major indices of cells within the square of given radius around the center cell that have actors of specified types
+void AGeneratedMap::GetCellIndicesInArea(FCellIndices& OutCellIndices, int32 CenterCellIndex, int32 Radius, int32 ActorsTypesBitmask) const
+{
+	OutCellIndices.Reset();
+	if (!CellActorTypesInternal.IsValidIndex(CenterCellIndex)
+	    || Radius < 0)
+	{
+		return;
+	}
+
+	const FIntPoint CenterCell(CenterCellIndex % GridSizeInternal.X, CenterCellIndex / GridSizeInternal.X);
+	const FIntRect CellsRect(CenterCell - FIntPoint(Radius), CenterCell + FIntPoint(Radius));
+	GridChunksInternal.ForEachCellInRect(CellsRect, ActorsTypesBitmask ? ActorsTypesBitmask : TO_FLAG(EAT::All), [&OutCellIndices](int32 CellIndex)
+	{
+		OutCellIndices.Emplace(CellIndex);
+	});
+}
+
+// Recalculates the occupancy of given cell by all Map Components that are located on it
+void AGeneratedMap::UpdateCellActorTypes(const FCell& Cell)
+{
+	UpdateCellActorTypesByIndex(GetCellIndex(Cell));
+}
+
+void AGeneratedMap::UpdateCellActorTypesByIndex(int32 CellIndex)
+{
+	if (!CellActorTypesInternal.IsValidIndex(CellIndex))
+	{
+		return;
+	}
+
+	int32 ActorTypesOnCell = GetClientActorTypes(CellIndex);
+	if (HasAuthority())
+	{
+		// Only items indexed by this cell are visited instead of walking all map components
+		TArray<int32, TInlineAllocator<4>> ItemIndices;
+		MapComponentsInternal.FindIndices(GridCellsInternal[CellIndex], ItemIndices);
+		for (const int32 ItemIndexIt : ItemIndices)
+		{
+			ActorTypesOnCell |= TO_FLAG(GetSpecActorType(MapComponentsInternal.Items[ItemIndexIt]));
+		}
+	}
+	else
+	{
+		// Client reads replicated map components from their mirror without walking them
+		ActorTypesOnCell |= GetReplicatedActorTypes(CellIndex);
+	}
+
+	if (CellActorTypesInternal[CellIndex] == ActorTypesOnCell)
+	{
+		// Nothing is changed on this cell
+		return;
+	}
+
+	const bool bWallsChanged = ((CellActorTypesInternal[CellIndex] ^ ActorTypesOnCell) & TO_FLAG(EAT::Wall)) != 0;
+	CellActorTypesInternal[CellIndex] = static_cast<uint8>(ActorTypesOnCell);
+	++StateVersionInternal;
+
+	const int32 ColumnIndex = (CellIndex % GridSizeInternal.X) * GridSizeInternal.Y + CellIndex / GridSizeInternal.X;
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		const bool bHasType = (ActorTypesOnCell & (1 << TypeIndex)) != 0;
+		ActorTypesBitboardsInternal[TypeIndex].SetBit(CellIndex, bHasType);
+		ActorTypesColumnBitboardsInternal[TypeIndex].SetBit(ColumnIndex, bHasType);
+	}
+	GridChunksInternal.SetCellActorTypes(CellIndex, ActorTypesOnCell);
+
+	if (bWallsChanged)
+	{
+		// Walls break explosions, so rays of bombs might be changed
+		RefreshBombsDanger();
+		UpdateWallsBitmask();
+	}
+
+	OnCellActorTypesChanged.Broadcast(CellIndex, ActorTypesOnCell);
+}
+
+// Returns the cell of given spec, is taken from replicated data on client if its map component is not resolved yet
+const FCell& AGeneratedMap::GetSpecCell(const FMapComponentSpec& Spec)
+{
+	return Spec.MapComponent ? Spec.MapComponent->GetCell() : Spec.Cell;
+}
+
+// Returns the actor type of given spec, is taken from replicated data on client if its map component is not resolved yet
+EActorType AGeneratedMap::GetSpecActorType(const FMapComponentSpec& Spec)
+{
+	return Spec.MapComponent ? Spec.MapComponent->GetActorType() : Spec.ActorType;
+}
+
+// Returns the packed mirror of map components, rebuilds it if items were added or removed since last request
+const AGeneratedMap::FPackedMapComponents& AGeneratedMap::GetPackedMapComponents() const
+{
+	FPackedMapComponents& Packed = PackedMapComponentsInternal;
+	const TArray<FMapComponentSpec>& Items = MapComponentsInternal.Items;
+	const int32 ItemsNum = Items.Num();
+	if (Packed.LayoutVersion == MapComponentsInternal.GetLayoutVersion()
+	    && Packed.ActorTypes.Num() == ItemsNum) // items could be changed directly
+	{
+		return Packed;
+	}
+
+	Packed.LayoutVersion = MapComponentsInternal.GetLayoutVersion();
+	Packed.CellIndices.SetNumUninitialized(ItemsNum, /*bAllowShrinking*/false);
+	Packed.ActorTypes.SetNumUninitialized(ItemsNum, /*bAllowShrinking*/false);
+	for (int32 ItemIndex = 0; ItemIndex < ItemsNum; ++ItemIndex)
+	{
+		const FMapComponentSpec& SpecIt = Items[ItemIndex];
+		Packed.CellIndices[ItemIndex] = GetCellIndex(GetSpecCell(SpecIt));
+		Packed.ActorTypes[ItemIndex] = static_cast<uint8>(GetSpecActorType(SpecIt));
+	}
+
+	return Packed;
+}
+
+// Updates the cell index of given map component in the packed mirror without rebuilding it
+void AGeneratedMap::UpdatePackedMapComponent(const UMapComponent& MapComponent) const
+{
+	FPackedMapComponents& Packed = PackedMapComponentsInternal;
+	if (Packed.LayoutVersion != MapComponentsInternal.GetLayoutVersion())
+	{
+		// The mirror is outdated anyway, it will be rebuilt with the new cell on next query
+		return;
+	}
+
+	// Lookup could rebuild indices of the container, so the version is checked again
+	const int32 ItemIndex = MapComponentsInternal.IndexOf(&MapComponent);
+	if (Packed.LayoutVersion == MapComponentsInternal.GetLayoutVersion()
+	    && Packed.CellIndices.IsValidIndex(ItemIndex))
+	{
+		Packed.CellIndices[ItemIndex] = GetCellIndex(MapComponent.GetCell());
+	}
+}
+
+// Recalculates the occupancy of the whole grid
+void AGeneratedMap::RebuildCellActorTypes()
+{
+	static_assert(TO_FLAG(EAT::All) == (1 << ActorTypesNum) - 1, "'ActorTypesNum' has to match the number of flags in EActorType::All");
+	static_assert(FGridChunks::ActorTypesNum == ActorTypesNum, "Chunks have to keep the same actor types as bitboards");
+
+	const int32 CellsNum = GridCellsInternal.Num();
+	CellActorTypesInternal.Init(TO_FLAG(EAT::None), CellsNum);
+	for (FCellsBitboard& BitboardIt : ActorTypesBitboardsInternal)
+	{
+		BitboardIt.Init(CellsNum);
+	}
+	for (FCellsBitboard& BitboardIt : ActorTypesColumnBitboardsInternal)
+	{
+		BitboardIt.Init(CellsNum);
+	}
+
+	// Replicated map components are recounted on client by the new grid
+	if (!HasAuthority())
+	{
+		RebuildReplicatedActorTypes();
+	}
+
+	// Walls, predicted and replicated actors are known on client even if their actors are not replicated yet
+	for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+	{
+		const int32 ClientActorTypes = GetClientActorTypes(CellIndex) | GetReplicatedActorTypes(CellIndex);
+		if (!ClientActorTypes)
+		{
+			continue;
+		}
+
+		CellActorTypesInternal[CellIndex] |= static_cast<uint8>(ClientActorTypes);
+		for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+		{
+			if (ClientActorTypes & (1 << TypeIndex))
+			{
+				ActorTypesBitboardsInternal[TypeIndex].SetBit(CellIndex, true);
+			}
+		}
+	}
+
+	const FPackedMapComponents& Packed = GetPackedMapComponents();
+	for (int32 ItemIndex = 0; HasAuthority() && ItemIndex < Packed.CellIndices.Num(); ++ItemIndex)
+	{
+		const int32 CellIndex = Packed.CellIndices[ItemIndex];
+		if (!CellActorTypesInternal.IsValidIndex(CellIndex))
+		{
+			continue;
+		}
+
+		const int32 ActorType = Packed.ActorTypes[ItemIndex];
+		CellActorTypesInternal[CellIndex] |= static_cast<uint8>(ActorType);
+		for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+		{
+			if (ActorType & (1 << TypeIndex))
+			{
+				ActorTypesBitboardsInternal[TypeIndex].SetBit(CellIndex, true);
+			}
+		}
+	}
+
+	// Chunks are filled from the final occupancy of each cell
+	GridChunksInternal.Init(GridSizeInternal);
+	for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+	{
+		if (CellActorTypesInternal[CellIndex])
+		{
+			GridChunksInternal.SetCellActorTypes(CellIndex, CellActorTypesInternal[CellIndex]);
+		}
+	}
+
+	// Column-major copies are filled from the row-major ones at once
+	const int32 MaxWidth = GridSizeInternal.X;
+	const int32 MaxLength = GridSizeInternal.Y;
+	if (MaxWidth * MaxLength == CellsNum)
+	{
+		for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+		{
+			FCellsBitboard& ColumnBitboard = ActorTypesColumnBitboardsInternal[TypeIndex];
+			ActorTypesBitboardsInternal[TypeIndex].ForEachSetBit([&ColumnBitboard, MaxWidth, MaxLength](int32 CellIndex)
+			{
+				ColumnBitboard.SetBit((CellIndex % MaxWidth) * MaxLength + CellIndex / MaxWidth, true);
+			});
+		}
+	}
+
+	++StateVersionInternal;
+
+	// Cell indices or walls might be changed, so explosions have to be cast again
+	RefreshBombsDanger();
+	UpdateWallsBitmask();
+}
+
+// Recalculates the danger map from cached explosions of all registered bombs
+void AGeneratedMap::RebuildDangerMap()
+{
+	const int32 CellsNum = GridCellsInternal.Num();
+	DangerTimesInternal.Init(MAX_flt, CellsNum);
+	DangerousCellsInternal.Init(CellsNum);
+	++StateVersionInternal;
+
+	for (int32 Index = BombsDangerInternal.Num() - 1; Index >= 0; --Index)
+	{
+		const FBombDanger& BombDangerIt = BombsDangerInternal[Index];
+		if (!BombDangerIt.Bomb.IsValid())
+		{
+			BombsDangerInternal.RemoveAtSwap(Index);
+			continue;
+		}
+
+		for (const int32 CellIndexIt : BombDangerIt.ExplosionCellIndices)
+		{
+			if (DangerTimesInternal.IsValidIndex(CellIndexIt))
+			{
+				DangerTimesInternal[CellIndexIt] = FMath::Min(DangerTimesInternal[CellIndexIt], BombDangerIt.DetonationTime);
+				DangerousCellsInternal.SetBit(CellIndexIt, true);
+			}
+		}
+	}
+}
+
+// Casts explosions of all registered bombs again
+void AGeneratedMap::RefreshBombsDanger()
+{
+	TArray<TWeakObjectPtr<const ABombActor>, TInlineAllocator<16>> Bombs;
+	for (const FBombDanger& BombDangerIt : BombsDangerInternal)
+	{
+		Bombs.Emplace(BombDangerIt.Bomb);
+	}
+
+	BombsDangerInternal.Reset();
+	for (const TWeakObjectPtr<const ABombActor>& BombIt : Bombs)
+	{
+		if (const ABombActor* Bomb = BombIt.Get())
+		{
+			// Is rebuilt on each bomb, but the number of bombs is small
+			UpdateBombDanger(Bomb);
+		}
+	}
+
+	RebuildDangerMap();
+}
+
+// Spawns and fills the Grid Array values by level actors
+void AGeneratedMap::GenerateLevelActors()
+{
+	STARTUP_TIMING_SCOPE(GenerateLevelActors);
+	BOMBER_PERF_BUDGET_SCOPE(GenerateLevelActors);
+
+	if (!ensureMsgf(GridCellsInternal.Num() > 0, TEXT("Is no cells for the actors generation"))
+	    || !HasAuthority())
+	{
+		return;
+	}
+
+	GenerateLevelLayout(/*bSpawnWhenComputed*/true);
+}
+
+// Computes the new layout from current inputs, spawns it or keeps it as prebuilt for the next round
+void AGeneratedMap::GenerateLevelLayout(bool bSpawnWhenComputed)
+{
+	// The layout of previous generation is replaced, so its spawn is skipped
+	WaitForLevelLayoutTask();
+
+	// Existing actors are not destroyed before the generation, so unchanged ones could be kept by the new layout
+	FCells DraggedCells, DraggedWalls, DraggedItems;
+	for (const TTuple<FCell, EActorType>& It : DraggedCellsInternal)
+	{
+		const FCell& Cell = It.Key;
+		const EActorType ActorType = It.Value;
+
+		// Store to avoid generation on their cells
+		DraggedCells.Emplace(Cell);
+		if (ActorType == EActorType::Wall)
+		{
+			DraggedWalls.Emplace(Cell);
+		}
+		else if (ActorType == EActorType::Item)
+		{
+			DraggedItems.Emplace(Cell);
+		}
+	}
+
+	/* Steps:
+	*
+	* Part 0: Actors random filling to the ArrayToGenerate.
+	* 0.1) Finding all symmetrical cells for each iterated cell;
+	*
+	* Part 1: Checking if there is a path to the each bone. If not, go to the 0 step.
+	*
+	* Part 2: Spawning these actors
+	*/
+
+	if (bSpawnWhenComputed)
+	{
+		GenerationStartTimeInternal = FPlatformTime::Seconds();
+		LastSpawnTimeInternal = -1.f;
+	}
+	const UGeneratedMapDataAsset& LevelsDataAsset = UGeneratedMapDataAsset::Get();
+
+	// Copy all inputs, so the layout could be computed without reading any actor or data asset
+	TSharedRef<FLevelLayoutGenerationData> Data = MakeShared<FLevelLayoutGenerationData>();
+
+	// The baked layout is spawned as is, so the generation and path validation are skipped
+	const bool bIsBaked = GetBakedActorsToSpawn(Data->ActorsToSpawn, DraggedCells);
+
+	// Initialize the random stream, the same seed reproduces the same layout
+	const int32 DataAssetSeed = GenerationSeedOverrideInternal ? GenerationSeedOverrideInternal : LevelsDataAsset.GetGenerationSeed();
+	Data->Seed = bIsBaked ? BakedLayoutSeedInternal : DataAssetSeed ? DataAssetSeed : FMath::Rand();
+	Data->RandomStream.Initialize(Data->Seed);
+
+	Data->MapScale = FIntVector(GetActorScale3D());
+	Data->WallsChance = WallsChanceOverrideInternal >= 0 ? WallsChanceOverrideInternal : LevelsDataAsset.GetWallsChance();
+	Data->BoxesChance = BoxesChanceOverrideInternal >= 0 ? BoxesChanceOverrideInternal : LevelsDataAsset.GetBoxesChance();
+	Data->MaxAttempts = FMath::Max(1, LevelsDataAsset.GetMaxGenerationAttempts());
+	Data->bIsConstructive = LevelsDataAsset.GetGenerationMode() == ELevelGenerationMode::Constructive;
+	Data->PlayersNum = LevelsDataAsset.GetPlayersNum();
+	Data->DraggedCells = MoveTemp(DraggedCells);
+	Data->DraggedWalls = MoveTemp(DraggedWalls);
+	Data->DraggedItems = MoveTemp(DraggedItems);
+
+	const uint32 LayoutGeneration = ++LevelLayoutGenerationInternal;
+	PrebuiltLevelLayoutInternal = bSpawnWhenComputed ? nullptr : TSharedPtr<FLevelLayoutGenerationData>(Data);
+
+	// Is called on the game thread when the layout is computed
+	auto OnLayoutComputed = [this, bSpawnWhenComputed](FLevelLayoutGenerationData& InOutData)
+	{
+		if (bSpawnWhenComputed)
+		{
+			ApplyLevelLayout(InOutData);
+		}
+		else
+		{
+			// Is kept until the next round starts, only pools are prepared for it
+			WarmUpPoolsForLayout(InOutData);
+		}
+	};
+
+	if (bIsBaked)
+	{
+		Data->bFoundPath = true;
+		OnLayoutComputed(*Data);
+		return;
+	}
+
+	const UWorld* World = GetWorld();
+	const bool bCanComputeAsync = CVarAsyncLevelLayout.GetValueOnGameThread()
+	                              && World && World->IsGameWorld()
+	                              && FPlatformProcess::SupportsMultithreading();
+	if (!bCanComputeAsync)
+	{
+		// Editor preview is generated synchronously, so the level is updated right after the change
+		ComputeLevelLayout(*Data);
+		OnLayoutComputed(*Data);
+		return;
+	}
+
+	// Compute on the worker thread, only the spawn is handed off to the game thread, so the starting countdown hides the latency
+	LevelLayoutTaskInternal = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Data, LayoutGeneration, OnLayoutComputed, WeakThis = TWeakObjectPtr<ThisClass>(this)]()
+	{
+		ComputeLevelLayout(*Data);
+
+		AsyncTask(ENamedThreads::GameThread, [Data, LayoutGeneration, OnLayoutComputed, WeakThis]()
+		{
+			const ThisClass* GeneratedMap = WeakThis.Get();
+			if (GeneratedMap
+			    && GeneratedMap->LevelLayoutGenerationInternal == LayoutGeneration) // is not replaced by next generation
+			{
+				OnLayoutComputed(*Data);
+			}
+		});
+	});
+}
+
+// Computes the layout of the next round and warms pools for it without spawning
+void AGeneratedMap::PrebuildLevelActors()
+{
+	if (!GridCellsInternal.Num()
+	    || !HasAuthority())
+	{
+		return;
+	}
+
+	GenerateLevelLayout(/*bSpawnWhenComputed*/false);
+}
+
+// Spawns the layout that was computed by ThisClass::PrebuildLevelActors()
+bool AGeneratedMap::SpawnPrebuiltLevelActors()
+{
+	if (!PrebuiltLevelLayoutInternal
+	    || !HasAuthority())
+	{
+		return false;
+	}
+
+	// Is usually finished during the end game screen
+	WaitForLevelLayoutTask();
+
+	// Skip the pending warm up, the spawn takes missing actors from pools by itself
+	++LevelLayoutGenerationInternal;
+	const TSharedPtr<FLevelLayoutGenerationData> Data = MoveTemp(PrebuiltLevelLayoutInternal);
+
+	GenerationStartTimeInternal = FPlatformTime::Seconds();
+	LastSpawnTimeInternal = -1.f;
+	ApplyLevelLayout(*Data);
+	return true;
+}
+
+// Pre-creates inactive level actors that are missing in the pools for given layout
+void AGeneratedMap::WarmUpPoolsForLayout(const FLevelLayoutGenerationData& Data)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	TMap<EActorType, int32> RequiredNums;
+	for (const TTuple<FCell, EActorType>& It : Data.ActorsToSpawn)
+	{
+		++RequiredNums.FindOrAdd(It.Value);
+	}
+
+	// Actors on the level are reused by the new layout, so only the rest is missing
+	const FPackedMapComponents& Packed = GetPackedMapComponents();
+	for (const uint8 ActorTypeIt : Packed.ActorTypes)
+	{
+		if (int32* RequiredNum = RequiredNums.Find(static_cast<EActorType>(ActorTypeIt)))
+		{
+			--*RequiredNum;
+		}
+	}
+
+	const UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+	for (TTuple<EActorType, int32>& It : RequiredNums)
+	{
+		UClass* ActorClass = It.Value > 0 ? UDataAssetsContainer::GetActorClassByType(It.Key) : nullptr;
+		if (!ActorClass)
+		{
+			continue;
+		}
+
+		for (TActorIterator<AActor> ActorIt(World, ActorClass); ActorIt && It.Value > 0; ++ActorIt)
+		{
+			if (PoolManager.GetPoolObjectState(*ActorIt) == EPoolObjectState::Inactive)
+			{
+				--It.Value;
+			}
+		}
+	}
+
+	WarmUpPoolsByTypes(RequiredNums);
+}
+
+// Generates the layout by given inputs: random fill, symmetry and path validation
+void AGeneratedMap::ComputeLevelLayout(FLevelLayoutGenerationData& InOutData)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(AGeneratedMap::ComputeLevelLayout);
+
+	const double ComputeStartTime = FPlatformTime::Seconds();
+	InOutData.PathCheckTime = 0.f;
+
+	FCells CellsToFind;
+	int32 Counter = 0;
+	bool bFoundPath = false;
+	while (InOutData.WallsChance > KINDA_SMALL_NUMBER // exit if there is no chance to generate level
+	       && !bFoundPath                             // exit if level was generated
+	       && Counter < InOutData.MaxAttempts)        // exit if the budget is exhausted
 	{
 		// Set Loop Locals
-		FCells LDraggedCells{DraggedCells};
-		FCells LCellsToFind{DraggedItems};
+		FCells LDraggedCells{InOutData.DraggedCells};
+		FCells LCellsToFind{InOutData.DraggedItems};
 		TMap<FCell, EActorType> LActorsToSpawn;
 
-		// Locals
-		const FIntVector MapScale(GetActorScale3D());
-		const FIntVector MapHalfScale(MapScale / 2);
-		FCells WallsToSpawn;
+		// Locals
+		const FIntVector& MapScale = InOutData.MapScale;
+		const FIntVector MapHalfScale(MapScale / 2);
+		FCells WallsToSpawn;
+
+		// Spawns of characters in the quarter of the level, each one is mirrored to all quarters
+		static constexpr int32 SymmetrySidesNum = 4;
+		const FIntPoint QuarterScale(MapHalfScale.X / 2, MapHalfScale.Y / 2);
+		const FIntPoint PlayerSpawnCandidates[] = {{0, 0}, {QuarterScale.X, 0}, {0, QuarterScale.Y}, {QuarterScale.X, QuarterScale.Y}};
+		const int32 PlayerSpawnsNum = FMath::Clamp(InOutData.PlayersNum / SymmetrySidesNum, 1, static_cast<int32>(UE_ARRAY_COUNT(PlayerSpawnCandidates)));
+		TArray<FIntPoint, TInlineAllocator<SymmetrySidesNum>> PlayerSpawns;
+		for (int32 Index = 0; Index < PlayerSpawnsNum; ++Index)
+		{
+			// Is skipped on small levels where the spawn coincides with another one
+			PlayerSpawns.AddUnique(PlayerSpawnCandidates[Index]);
+		}
+
+		// --- Part 0: Cells filling ---
+
+		for (int32 Y = 0; Y <= MapHalfScale.Y; ++Y) // Strings
+		{
+			for (int32 X = 0; X <= MapHalfScale.X; ++X) // Columns
+			{
+				const FIntPoint CellPoint(X, Y);
+				const bool IsSafeZone = PlayerSpawns.ContainsByPredicate([&CellPoint](const FIntPoint& SpawnIt)
+				{
+					return FMath::Abs(SpawnIt.X - CellPoint.X) + FMath::Abs(SpawnIt.Y - CellPoint.Y) == 1;
+				});
+				FCell CellIt = GridCellsInternal[MapScale.X * Y + X];
+
+				// --- Part 0: Actors random filling to the ArrayToGenerate._ ---
+
+				// In case all next conditions will be false
+				EActorType ActorTypeToSpawn = EAT::None;
+
+				// Player condition
+				if (PlayerSpawns.Contains(CellPoint)) // is the corner or another spawn
+				{
+					ActorTypeToSpawn = EAT::Player;
+				}
+
+				// Wall condition
+				if (ActorTypeToSpawn == EAT::None                           // all previous conditions are false
+				    && !IsSafeZone && InOutData.RandomStream.RandHelper(100) < InOutData.WallsChance) // chance of walls
+				{
+					ActorTypeToSpawn = EAT::Wall;
+				}
+
+				// Box condition
+				if (ActorTypeToSpawn == EAT::None                           // all previous conditions are false
+				    && !IsSafeZone && InOutData.RandomStream.RandHelper(100) < InOutData.BoxesChance) // Chance of boxes
+				{
+					ActorTypeToSpawn = EAT::Box;
+				}
+
+				if (ActorTypeToSpawn == EAT::None) // There is no types to spawn
+				{
+					continue;
+				}
+
+				// 0.1) Array symmetrization
+				const int32 Xs = MapScale.X - 1 - X, Ys = MapScale.Y - 1 - Y; // Symmetrized cell position
+				for (int32 I = 0; I < 4; ++I)                                 // 4 sides of symmetry
+				{
+					if (I > 0) // the 0 index is always current CellIt, otherwise needs to find symmetry
+					{
+						int32 Xi = X, Yi = Y; // Keeping the current coordinates
+						switch (I)
+						{
+							case 1: // (X1 = Xs; Y1 = Y)
+								Xi = Xs;
+								break;
+							case 2: // (X2 = X; Y2 = Ys)
+								Yi = Ys;
+								break;
+							case 3: // (X3 = Xs; Y3 = Ys)
+								Xi = Xs;
+								Yi = Ys;
+								break;
+							default:
+								break;
+						}
+
+						CellIt = GridCellsInternal[MapScale.X * Yi + Xi];
+					}
+
+					if (!LDraggedCells.Contains(CellIt)) // the cell is free
+					{
+						LActorsToSpawn.Emplace(CellIt, ActorTypeToSpawn);
+						if (ActorTypeToSpawn == EAT::Wall)
+						{
+							WallsToSpawn.Emplace(CellIt);
+						}
+						else if (ActorTypeToSpawn == EAT::Player
+						         || ActorTypeToSpawn == EAT::Box)
+						{
+							LCellsToFind.Emplace(CellIt);
+						}
+					}
+				} // Symmetry iterations
+			}     // X iterations
+		}         // Y iterations
+
+		// --- Part 1 : Checking if there is a path to the bottom and side edges. If not, go to the 0 step._ ---
+
+		if (InOutData.bIsConstructive)
+		{
+			// Remove isolating walls instead of validating and rerolling
+			ConnectCellsByWallGroups(LActorsToSpawn, LCellsToFind, InOutData.DraggedWalls, InOutData.RandomStream);
+			bFoundPath = true;
+		}
+		else
+		{
+			// Without any walls nothing could isolate cells, it also avoids reading walls of the level instead of path breakers
+			const FCells PathBreakers = WallsToSpawn.Union(InOutData.DraggedWalls);
+			const double PathCheckStartTime = FPlatformTime::Seconds();
+			bFoundPath = PathBreakers.IsEmpty() || DoesPathExistToCells(LCellsToFind, PathBreakers);
+			InOutData.PathCheckTime += static_cast<float>(FPlatformTime::Seconds() - PathCheckStartTime);
+		}
+
+		// Keep the last attempt to carve it if the budget is exhausted
+		InOutData.ActorsToSpawn = MoveTemp(LActorsToSpawn);
+		CellsToFind = MoveTemp(LCellsToFind);
+		++Counter;
+
+		// Go to the step 0 if don't found
+		if (!bFoundPath)
+		{
+			InOutData.WallsChance -= InOutData.WallsChance * 0.01f; // decrease local chance of walls to avoid forever loop
+		}
+	}
+
+	if (!bFoundPath)
+	{
+		// The budget is exhausted, make the last attempt valid instead of rerolling
+		CarvePathToCells(InOutData.ActorsToSpawn, CellsToFind, InOutData.DraggedWalls);
+	}
+
+	InOutData.Attempts = Counter;
+	InOutData.bFoundPath = bFoundPath;
+	InOutData.GenerationTime = static_cast<float>(FPlatformTime::Seconds() - ComputeStartTime);
+}
+
+// Spawns the computed layout on the game thread: keeps or moves existing actors and spawns the rest
+void AGeneratedMap::ApplyLevelLayout(FLevelLayoutGenerationData& InOutData)
+{
+	check(IsInGameThread());
+
+	GenerationSeedInternal = InOutData.Seed;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, GenerationSeedInternal, this);
+
+	FFrameSpikeCapture::OnRegeneration(this);
+
+	// Keep the stream state, so seeded randomness after the generation is the same for synchronous and asynchronous layouts
+	RandomStreamInternal = InOutData.RandomStream;
+	LastPathCheckTimeInternal = InOutData.PathCheckTime;
+	LastGenerationAttemptsInternal = InOutData.Attempts;
+	LastGenerationTimeInternal = InOutData.GenerationTime;
+	const bool bIsBaked = InOutData.Attempts == 0;
+	UE_LOG(LogBomber, Log, TEXT("Level is %s: seed %i, attempts %i, carved %s, time %.3f ms"), bIsBaked ? TEXT("spawned from the baked layout") : TEXT("generated"), GenerationSeedInternal, LastGenerationAttemptsInternal, InOutData.bFoundPath ? TEXT("false") : TEXT("true"), LastGenerationTimeInternal * 1000.f);
+
+	TMap<FCell, EActorType>& ActorsToSpawn = InOutData.ActorsToSpawn;
+
+	// --- Part 2: Spawning ---
+
+	// Keep or move existing actors that match the new layout, destroy the rest
+	TMap<FCell, EActorType> DraggedToSpawn{DraggedCellsInternal};
+	ReuseLevelActors(ActorsToSpawn, DraggedToSpawn);
+
+	// Calls before generation preview actors to updating of all dragged to the Generated Map actors
+	for (const TTuple<FCell, EActorType>& It : DraggedToSpawn)
+	{
+		SpawnActorByType(It.Value, It.Key);
+	}
+
+	SpawnActorsByTypes(ActorsToSpawn);
+}
+
+// Blocks until the layout computation is finished, is called before the grid is changed
+void AGeneratedMap::WaitForLevelLayoutTask()
+{
+	if (LevelLayoutTaskInternal.IsValid())
+	{
+		LevelLayoutTaskInternal.Wait();
+		LevelLayoutTaskInternal = {};
+	}
+}
+
+// Saves current walls, boxes, items and players of the level with its seed into this actor, so the level is spawned from them instead of being generated
+void AGeneratedMap::BakeLevelLayout()
+{
+	const FIntPoint GridSize = GetGridSize();
+	if (!ensureMsgf(GridCellsInternal.Num() == GridSize.X * GridSize.Y, TEXT("ASSERT: [%i] %s:\nThe grid is not built, can't bake the layout!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	FLevelLayout Layout;
+	GetCurrentLevelLayout(Layout);
+
+	Modify();
+	BakedLayoutInternal = MoveTemp(Layout.ActorTypes);
+	BakedLayoutSizeInternal = Layout.Size;
+	BakedLayoutSeedInternal = Layout.Seed;
+
+	UE_LOG(LogBomber, Log, TEXT("Level layout is baked: %ix%i grid, seed %i"), GridSize.X, GridSize.Y, BakedLayoutSeedInternal);
+}
+
+// Removes the baked layout, so the level is generated again
+void AGeneratedMap::ClearBakedLevelLayout()
+{
+	Modify();
+	BakedLayoutInternal.Empty();
+	BakedLayoutSizeInternal = FIntPoint::ZeroValue;
+	BakedLayoutSeedInternal = 0;
+}
+
+// Returns true if the level is spawned from the baked layout, it has to match current size of the grid
+bool AGeneratedMap::HasBakedLevelLayout() const
+{
+	return !BakedLayoutInternal.IsEmpty()
+	       && BakedLayoutSizeInternal == GetGridSize()
+	       && BakedLayoutInternal.Num() == GridCellsInternal.Num();
+}
+
+// Fills actors to spawn from the baked layout except given dragged cells
+bool AGeneratedMap::GetBakedActorsToSpawn(TMap<FCell, EActorType>& OutActorsToSpawn, const FCells& DraggedCells) const
+{
+	if (!HasBakedLevelLayout())
+	{
+		return false;
+	}
+
+	OutActorsToSpawn.Reset();
+	for (int32 CellIndex = 0; CellIndex < BakedLayoutInternal.Num(); ++CellIndex)
+	{
+		const EActorType ActorType = TO_ENUM(EActorType, BakedLayoutInternal[CellIndex]);
+		const FCell& Cell = GridCellsInternal[CellIndex];
+		if (ActorType != EAT::None
+		    && !DraggedCells.Contains(Cell))
+		{
+			OutActorsToSpawn.Emplace(Cell, ActorType);
+		}
+	}
+
+	return true;
+}
+
+// Fills given layout by current size, level type, seed and walls, boxes, items and players of the level except dragged ones
+void AGeneratedMap::GetCurrentLevelLayout(FLevelLayout& OutLayout) const
+{
+	// Bombs are never part of the layout, dragged actors are spawned by their own cells
+	constexpr int32 LayoutTypes = TO_FLAG(EAT::Wall | EAT::Box | EAT::Item | EAT::Player);
+
+	OutLayout.Size = GetGridSize();
+	OutLayout.LevelType = LevelTypeInternal;
+	OutLayout.Seed = GenerationSeedInternal;
+	OutLayout.ActorTypes.Init(static_cast<uint8>(EAT::None), GridCellsInternal.Num());
+
+	const FPackedMapComponents& Packed = GetPackedMapComponents();
+	for (int32 ItemIndex = 0; ItemIndex < Packed.CellIndices.Num(); ++ItemIndex)
+	{
+		const uint8 ActorType = Packed.ActorTypes[ItemIndex];
+		const int32 CellIndex = Packed.CellIndices[ItemIndex];
+		if ((ActorType & LayoutTypes)
+		    && OutLayout.ActorTypes.IsValidIndex(CellIndex)
+		    && !DraggedCellsInternal.Contains(GridCellsInternal[CellIndex]))
+		{
+			OutLayout.ActorTypes[CellIndex] = ActorType;
+		}
+	}
+}
+
+// Writes current layout of the level to the compact binary file that could be shared and imported on another machine
+bool AGeneratedMap::ExportLevelLayout(const FString& FilePath) const
+{
+	FLevelLayout Layout;
+	GetCurrentLevelLayout(Layout);
+	const bool bSaved = Layout.SaveToFile(FilePath);
+	UE_LOG(LogBomber, Log, TEXT("Level layout %s exported to '%s'"), bSaved ? TEXT("is") : TEXT("is not"), *FilePath);
+	return bSaved;
+}
+
+// Reads the layout from the compact binary file and spawns the level from it without any generation, the layout becomes baked
+bool AGeneratedMap::ImportLevelLayout(const FString& FilePath)
+{
+	FLevelLayout Layout;
+	if (!HasAuthority()
+	    || !Layout.LoadFromFile(FilePath))
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Level layout is not imported from '%s'"), *FilePath);
+		return false;
+	}
+
+	const UGeneratedMapDataAsset& GeneratedMapDataAsset = UGeneratedMapDataAsset::Get();
+	const FIntPoint& MaxLevelSize = GeneratedMapDataAsset.GetLevelSizeCostModel().MaxLevelSize;
+	if (Layout.Size.X > MaxLevelSize.X
+	    || Layout.Size.Y > MaxLevelSize.Y)
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Level layout is not imported from '%s': its %ix%i grid exceeds the max size %ix%i"), *FilePath, Layout.Size.X, Layout.Size.Y, MaxLevelSize.X, MaxLevelSize.Y);
+		return false;
+	}
+
+	// The layout is spawned only while it matches the grid size, so the clamped level is generated instead
+	const FIntPoint ClampedSize = GeneratedMapDataAsset.ClampLevelSize(Layout.Size);
+	if (ClampedSize != Layout.Size)
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Level layout from '%s' is clamped from %ix%i to %ix%i by the level size budget, the level is generated instead of the layout"), *FilePath, Layout.Size.X, Layout.Size.Y, ClampedSize.X, ClampedSize.Y);
+	}
+
+	BakedLayoutInternal = MoveTemp(Layout.ActorTypes);
+	BakedLayoutSizeInternal = Layout.Size;
+	BakedLayoutSeedInternal = Layout.Seed;
+
+	if (Layout.LevelType != ELevelType::None)
+	{
+		SetLevelType(Layout.LevelType);
+	}
+
+	// The authority spawns the level from the imported layout
+	SetLevelSize(Layout.Size);
+	return true;
+}
+
+// Writes the state of the running match to the compact binary blob in memory
+bool AGeneratedMap::CaptureMatchSnapshot(TArray<uint8>& OutSnapshot) const
+{
+	const UWorld* World = GetWorld();
+	if (!HasAuthority()
+	    || !World
+	    || GridCellsInternal.IsEmpty())
+	{
+		return false;
+	}
+
+	FMatchSnapshot Snapshot;
+	FLevelLayout& Layout = Snapshot.Layout;
+	Layout.Size = GetGridSize();
+	Layout.LevelType = LevelTypeInternal;
+	Layout.Seed = GenerationSeedInternal;
+
+	// Walls and boxes are taken from the occupancy grid as it is without walking their actors
+	constexpr int32 LayoutTypes = TO_FLAG(EAT::Wall | EAT::Box);
+	Layout.ActorTypes.SetNumUninitialized(CellActorTypesInternal.Num());
+	for (int32 CellIndex = 0; CellIndex < CellActorTypesInternal.Num(); ++CellIndex)
+	{
+		const int32 CellTypes = CellActorTypesInternal[CellIndex] & LayoutTypes;
+		Layout.ActorTypes[CellIndex] = static_cast<uint8>(CellTypes & TO_FLAG(EAT::Wall) ? EAT::Wall : static_cast<EActorType>(CellTypes));
+	}
+
+	// Only items, bombs and players have own state to read from their actors
+	// Types and cells are checked over packed memory, so walls and boxes are never touched
+	constexpr int32 StateTypes = TO_FLAG(EAT::Item | EAT::Bomb | EAT::Player);
+	const double CurrentTime = World->GetTimeSeconds();
+	const FPackedMapComponents& Packed = GetPackedMapComponents();
+	for (int32 ItemIndex = 0; ItemIndex < Packed.CellIndices.Num(); ++ItemIndex)
+	{
+		const int32 CellIndex = Packed.CellIndices[ItemIndex];
+		const UMapComponent* MapComponentIt = Packed.ActorTypes[ItemIndex] & StateTypes ? MapComponentsInternal[ItemIndex] : nullptr;
+		if (!MapComponentIt
+		    || CellIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const EActorType ActorType = static_cast<EActorType>(Packed.ActorTypes[ItemIndex]);
+
+		if (ActorType == EAT::Item)
+		{
+			const AItemActor& ItemActor = *CastChecked<AItemActor>(MapComponentIt->GetOwner());
+			Layout.ActorTypes[CellIndex] = static_cast<uint8>(EAT::Item);
+			Snapshot.Items.Add({CellIndex, static_cast<uint8>(ItemActor.GetItemType())});
+		}
+		else if (ActorType == EAT::Bomb)
+		{
+			const ABombActor& BombActor = *CastChecked<ABombActor>(MapComponentIt->GetOwner());
+			const float DetonationTime = BombActor.GetDetonationTime();
+			const float FuseSecondsRemain = DetonationTime != MAX_flt ? FMath::Max(static_cast<float>(DetonationTime - CurrentTime), 0.f) : 0.f;
+			Snapshot.Bombs.Add({CellIndex, BombActor.GetOwnerCharacterID(), BombActor.GetExplosionRadius(), FuseSecondsRemain});
+		}
+		else if (ActorType == EAT::Player)
+		{
+			const APlayerCharacter& PlayerCharacter = *CastChecked<APlayerCharacter>(MapComponentIt->GetOwner());
+			const FPowerUp& Powerups = PlayerCharacter.GetPowerups();
+			Snapshot.Players.Add({PlayerCharacter.GetCharacterID(), CellIndex, Powerups.SkateN, Powerups.BombN, Powerups.FireN});
+		}
+	}
+
+	if (AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame)
+	{
+		Snapshot.InGameSecondsRemain = AMyGameStateBase::Get().GetInGameTimerSecondsRemain();
+	}
+
+	Snapshot.SaveToBytes(OutSnapshot);
+	return true;
+}
+
+// Restores the state of the match from the blob captured on the grid of the same size
+bool AGeneratedMap::RestoreMatchSnapshot(const TArray<uint8>& Snapshot)
+{
+	FMatchSnapshot MatchSnapshot;
+	if (!HasAuthority()
+	    || !MatchSnapshot.LoadFromBytes(Snapshot)
+	    || MatchSnapshot.Layout.Size != GetGridSize()
+	    || MatchSnapshot.Layout.ActorTypes.Num() != GridCellsInternal.Num())
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Match snapshot is not restored: it is not valid for the current grid"));
+		return false;
+	}
+
+	// The layout of the running generation is replaced by the snapshot, so its pending warm up and spawn are skipped
+	WaitForLevelLayoutTask();
+	++LevelLayoutGenerationInternal;
+	PrebuiltLevelLayoutInternal.Reset();
+
+	const FLevelLayout& Layout = MatchSnapshot.Layout;
+	if (Layout.LevelType != ELevelType::None
+	    && Layout.LevelType != LevelTypeInternal)
+	{
+		SetLevelType(Layout.LevelType);
+	}
+
+	GenerationSeedInternal = Layout.Seed;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, GenerationSeedInternal, this);
+
+	// --- Walls and boxes go through the batch spawn path, existing ones are kept or moved, players are left untouched
+	TMap<FCell, EActorType> ActorsToSpawn;
+	for (int32 CellIndex = 0; CellIndex < Layout.ActorTypes.Num(); ++CellIndex)
+	{
+		const EActorType ActorType = static_cast<EActorType>(Layout.ActorTypes[CellIndex]);
+		if (TO_FLAG(ActorType) & TO_FLAG(EAT::Wall | EAT::Box))
+		{
+			ActorsToSpawn.Emplace(GridCellsInternal[CellIndex], ActorType);
+		}
+	}
+
+	TMap<FCell, EActorType> DraggedToSpawn;
+	ReuseLevelActors(ActorsToSpawn, DraggedToSpawn, TO_FLAG(EAT::Player));
+	SpawnActorsByTypes(ActorsToSpawn);
+
+	// --- Alive players are moved to their cells with their powerups, others are destroyed
+	TMap<int32, APlayerCharacter*> PlayersByID;
+	TArray<UMapComponent*> PlayersToDestroy;
+	for (UMapComponent* MapComponentIt : MapComponentsInternal)
+	{
+		if (!MapComponentIt
+		    || MapComponentIt->GetActorType() != EAT::Player)
+		{
+			continue;
+		}
+
+		APlayerCharacter* PlayerCharacter = CastChecked<APlayerCharacter>(MapComponentIt->GetOwner());
+		const FMatchSnapshot::FPlayer* SnapshotPlayer = MatchSnapshot.Players.FindByPredicate([PlayerCharacter](const FMatchSnapshot::FPlayer& PlayerIt)
+		{
+			return PlayerIt.CharacterID == PlayerCharacter->GetCharacterID();
+		});
+		if (!SnapshotPlayer
+		    || !GridCellsInternal.IsValidIndex(SnapshotPlayer->CellIndex))
+		{
+			PlayersToDestroy.Emplace(MapComponentIt);
+			continue;
+		}
+
+		PlayersByID.Emplace(SnapshotPlayer->CharacterID, PlayerCharacter);
+
+		FPowerUp Powerups;
+		Powerups.SkateN = SnapshotPlayer->SkateN;
+		Powerups.BombN = SnapshotPlayer->BombN;
+		Powerups.FireN = SnapshotPlayer->FireN;
+		PlayerCharacter->SetPowerups(Powerups);
+
+		const FCell& NewCell = GridCellsInternal[SnapshotPlayer->CellIndex];
+		const FCell PreviousCell = MapComponentIt->GetCell();
+		if (NewCell != PreviousCell)
+		{
+			const FVector NewLocation(NewCell.X(), NewCell.Y(), PlayerCharacter->GetActorLocation().Z);
+			PlayerCharacter->SetActorLocation(NewLocation, /*bSweep*/false, nullptr, ETeleportType::TeleportPhysics);
+			MapComponentIt->SetCell(NewCell);
+			AddToGrid(MapComponentIt);
+			UpdateCellActorTypes(PreviousCell);
+		}
+	}
+
+	for (UMapComponent* PlayerIt : PlayersToDestroy)
+	{
+		DestroyLevelActor(PlayerIt);
+	}
+
+	// --- Items, bombs and missing players are requested from pools by one batch, their state is applied by their cells once spawned
+	TArray<FSpawnRequest> SpawnRequests;
+	auto AddSpawnRequest = [this, &SpawnRequests](EActorType ActorType, int32 CellIndex)
+	{
+		if (GridCellsInternal.IsValidIndex(CellIndex))
+		{
+			FSpawnRequest& NewRequestRef = SpawnRequests.AddDefaulted_GetRef();
+			NewRequestRef.Class = UDataAssetsContainer::GetActorClassByType(ActorType);
+			NewRequestRef.Transform = FTransform(GridCellsInternal[CellIndex]);
+		}
+	};
+
+	for (const FMatchSnapshot::FPlayer& PlayerIt : MatchSnapshot.Players)
+	{
+		if (!PlayersByID.Contains(PlayerIt.CharacterID))
+		{
+			// The player was destroyed after the snapshot was captured
+			AddSpawnRequest(EAT::Player, PlayerIt.CellIndex);
+		}
+	}
+	for (const FMatchSnapshot::FItem& ItemIt : MatchSnapshot.Items)
+	{
+		AddSpawnRequest(EAT::Item, ItemIt.CellIndex);
+	}
+	for (const FMatchSnapshot::FBomb& BombIt : MatchSnapshot.Bombs)
+	{
+		AddSpawnRequest(EAT::Bomb, BombIt.CellIndex);
+	}
+
+	if (!SpawnRequests.IsEmpty())
+	{
+		const TWeakObjectPtr<ThisClass> WeakThis(this);
+		const FOnSpawnAllCallback OnCompleted = [WeakThis, Items = MatchSnapshot.Items, Bombs = MatchSnapshot.Bombs, Players = MatchSnapshot.Players](const TArray<FPoolObjectData>& CreatedObjects)
+		{
+			AGeneratedMap* GeneratedMap = WeakThis.Get();
+			if (!GeneratedMap)
+			{
+				return;
+			}
+
+			auto FindPlayer = [GeneratedMap](int32 CharacterID) -> APlayerCharacter*
+			{
+				for (const UMapComponent* MapComponentIt : GeneratedMap->MapComponentsInternal)
+				{
+					APlayerCharacter* PlayerCharacter = MapComponentIt && MapComponentIt->GetActorType() == EAT::Player ? Cast<APlayerCharacter>(MapComponentIt->GetOwner()) : nullptr;
+					if (PlayerCharacter
+					    && PlayerCharacter->GetCharacterID() == CharacterID)
+					{
+						return PlayerCharacter;
+					}
+				}
+				return nullptr;
+			};
+
+			// Players are set up first, so spawned bombs could be returned to respawned owners
+			TArray<TPair<AActor*, int32>, TInlineAllocator<16>> SpawnedByCells;
+			for (const FPoolObjectData& CreatedObject : CreatedObjects)
+			{
+				AActor& SpawnedActor = CreatedObject.GetChecked<AActor>();
+				SpawnedActor.SetFlags(RF_Transient); // Do not save generated actors into the map
+				SpawnedActor.SetOwner(GeneratedMap);
+
+				UMapComponent* MapComponent = UMapComponent::GetMapComponent(&SpawnedActor);
+				if (!MapComponent)
+				{
+					continue;
+				}
+
+				MapComponent->SetPoolObjectHandle(CreatedObject.Handle);
+				const int32 CellIndex = GeneratedMap->GetNearestCellIndex(SpawnedActor.GetActorLocation());
+
+				APlayerCharacter* PlayerCharacter = Cast<APlayerCharacter>(&SpawnedActor);
+				const FMatchSnapshot::FPlayer* SnapshotPlayer = PlayerCharacter ? Players.FindByPredicate([CellIndex](const FMatchSnapshot::FPlayer& PlayerIt) { return PlayerIt.CellIndex == CellIndex; }) : nullptr;
+				if (SnapshotPlayer)
+				{
+					PlayerCharacter->SetCharacterID(SnapshotPlayer->CharacterID);
+
+					FPowerUp Powerups;
+					Powerups.SkateN = SnapshotPlayer->SkateN;
+					Powerups.BombN = SnapshotPlayer->BombN;
+					Powerups.FireN = SnapshotPlayer->FireN;
+					PlayerCharacter->SetPowerups(Powerups);
+				}
+				else if (!PlayerCharacter)
+				{
+					SpawnedByCells.Emplace(&SpawnedActor, CellIndex);
+				}
+			}
+
+			for (const TPair<AActor*, int32>& SpawnedIt : SpawnedByCells)
+			{
+				const int32 CellIndex = SpawnedIt.Value;
+				if (AItemActor* ItemActor = Cast<AItemActor>(SpawnedIt.Key))
+				{
+					if (const FMatchSnapshot::FItem* SnapshotItem = Items.FindByPredicate([CellIndex](const FMatchSnapshot::FItem& ItemIt) { return ItemIt.CellIndex == CellIndex; }))
+					{
+						ItemActor->SetItemType(static_cast<EItemType>(SnapshotItem->ItemType));
+					}
+				}
+				else if (ABombActor* BombActor = Cast<ABombActor>(SpawnedIt.Key))
+				{
+					const FMatchSnapshot::FBomb* SnapshotBomb = Bombs.FindByPredicate([CellIndex](const FMatchSnapshot::FBomb& BombIt) { return BombIt.CellIndex == CellIndex; });
+					if (!SnapshotBomb)
+					{
+						continue;
+					}
+
+					APlayerCharacter* OwnerCharacter = FindPlayer(SnapshotBomb->OwnerCharacterID);
+					BombActor->InitBomb(OwnerCharacter, SnapshotBomb->FireRadius);
+					BombActor->SetFuseSecondsRemain(SnapshotBomb->FuseSecondsRemain);
+
+					// The bomb is returned to its owner once exploded, the same as it was put by the owner
+					if (OwnerCharacter)
+					{
+						OwnerCharacter->AddOwnBomb(*BombActor);
+					}
+				}
+			}
+		};
+
+		UPoolManagerSubsystem::Get().TakeFromPool(SpawnRequests, OnCompleted);
+
+		// --- Add handles if requested spawning, so they can be canceled if regenerate before spawning finished
+		for (const FSpawnRequest& It : SpawnRequests)
+		{
+			checkf(It.Handle.IsValid(), TEXT("ERROR: [%i] %s:\n'Handle' is not valid!"), __LINE__, *FString(__FUNCTION__));
+			MapComponentsInternal.FindOrAdd(It.Handle);
+		}
+	}
+
+	if (MatchSnapshot.InGameSecondsRemain > 0.f
+	    && AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame)
+	{
+		AMyGameStateBase::Get().SetInGameTimerSecondsRemain(MatchSnapshot.InGameSecondsRemain);
+	}
 
-		// --- Part 0: Cells filling ---
+	UE_LOG(LogBomber, Log, TEXT("Match snapshot is restored: %i players, %i items, %i bombs"), MatchSnapshot.Players.Num(), MatchSnapshot.Items.Num(), MatchSnapshot.Bombs.Num());
+	return true;
+}
 
-		for (int32 Y = 0; Y <= MapHalfScale.Y; ++Y) // Strings
+// Restores the match from its last checkpoint
+bool AGeneratedMap::RestoreMatchCheckpoint()
+{
+	if (MatchCheckpointInternal.IsEmpty())
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Match checkpoint is not restored: none was captured yet"));
+		return false;
+	}
+
+	return RestoreMatchSnapshot(MatchCheckpointInternal);
+}
+
+// Captures the match snapshot as the last checkpoint
+void AGeneratedMap::CaptureMatchCheckpoint()
+{
+	TArray<uint8> NewCheckpoint;
+	if (CaptureMatchSnapshot(NewCheckpoint))
+	{
+		MatchCheckpointInternal = MoveTemp(NewCheckpoint);
+	}
+}
+
+// Keeps existing walls and boxes that match the new layout, moves the rest of them to new cells of the same type and destroys others
+void AGeneratedMap::ReuseLevelActors(TMap<FCell, EActorType>& InOutActorsToSpawn, TMap<FCell, EActorType>& InOutDraggedToSpawn, int32 KeptActorTypes/* = 0*/)
+{
+	// Only walls and boxes are reused, since other actors have their own state (powerups, item types, bomb timers) to be reset by the pool
+	constexpr int32 ReusableTypes = TO_FLAG(EAT::Wall | EAT::Box);
+
+	auto FindNewType = [&InOutActorsToSpawn, &InOutDraggedToSpawn](const FCell& Cell)
+	{
+		const EActorType* FoundType = InOutDraggedToSpawn.Find(Cell);
+		FoundType = FoundType ? FoundType : InOutActorsToSpawn.Find(Cell);
+		return FoundType ? *FoundType : EAT::None;
+	};
+
+	// --- Find actors to keep as they are, to move and to destroy
+	TArray<FPoolObjectHandle> HandlesToDestroy;
+	TMap<EActorType, TArray<UMapComponent*>> ComponentsToMove;
+	for (const FMapComponentSpec& SpecIt : MapComponentsInternal.Items)
+	{
+		UMapComponent* MapComponent = SpecIt.MapComponent;
+		const EActorType ActorType = MapComponent ? MapComponent->GetActorType() : EAT::None;
+		if (TO_FLAG(ActorType) & KeptActorTypes)
 		{
-			for (int32 X = 0; X <= MapHalfScale.X; ++X) // Columns
+			continue;
+		}
+
+		if (!(TO_FLAG(ActorType) & ReusableTypes))
+		{
+			// Iterate it by handles to cancel spawning even if the actor is not spawned yet
+			HandlesToDestroy.Emplace(SpecIt.PoolObjectHandle);
+			continue;
+		}
+
+		const FCell& Cell = MapComponent->GetCell();
+		const EActorType NewType = FindNewType(Cell);
+		if (NewType == ActorType)
+		{
+			// Is the same actor on the same cell, only its rotation could be changed by the new seed
+			InOutActorsToSpawn.Remove(Cell);
+			InOutDraggedToSpawn.Remove(Cell);
+
+			AActor* Owner = MapComponent->GetOwner();
+			const FTransform NewTransform = GetLevelActorTransform(Cell, ActorType);
+			if (Owner
+			    && !Owner->GetActorTransform().Equals(NewTransform))
 			{
-				const bool IsSafeZone = X == 0 && Y == 1 || X == 1 && Y == 0;
-				FCell CellIt = GridCellsInternal[MapScale.X * Y + X];
+				Owner->SetActorTransform(NewTransform);
+				MapComponent->UpdateInstancedMesh();
+			}
+		}
+		else if (NewType == EAT::None)
+		{
+			// The cell becomes free, so this actor could be moved to another cell without overlapping any existing actor
+			ComponentsToMove.FindOrAdd(ActorType).Emplace(MapComponent);
+		}
+		else
+		{
+			HandlesToDestroy.Emplace(SpecIt.PoolObjectHandle);
+		}
+	}
 
-				// --- Part 0: Actors random filling to the ArrayToGenerate._ ---
+	// --- Find new cells for actors to move
+	TArray<TPair<UMapComponent*, FCell>> Moves;
+	for (TMap<FCell, EActorType>* ActorsToSpawnIt : {&InOutDraggedToSpawn, &InOutActorsToSpawn})
+	{
+		for (auto It = ActorsToSpawnIt->CreateIterator(); It; ++It)
+		{
+			TArray<UMapComponent*>* ComponentsOfType = ComponentsToMove.Find(It.Value());
+			if (ComponentsOfType && !ComponentsOfType->IsEmpty())
+			{
+				constexpr bool bAllowShrinking = false;
+				Moves.Emplace(ComponentsOfType->Pop(bAllowShrinking), It.Key());
+				It.RemoveCurrent();
+			}
+		}
+	}
 
-				// In case all next conditions will be false
-				EActorType ActorTypeToSpawn = EAT::None;
+	// Not needed actors to move are destroyed as well
+	for (const TTuple<EActorType, TArray<UMapComponent*>>& It : ComponentsToMove)
+	{
+		for (const UMapComponent* MapComponentIt : It.Value)
+		{
+			HandlesToDestroy.Emplace(MapComponentIt->GetPoolObjectHandle());
+		}
+	}
 
-				// Player condition
-				if (X == 0 && Y == 0) // is first corner
-				{
-					ActorTypeToSpawn = EAT::Player;
-				}
+	// --- Destroy first, so moved actors never overlap destroyed ones
+	for (const FPoolObjectHandle& HandleIt : HandlesToDestroy)
+	{
+		DestroyLevelActorByHandle(HandleIt);
+	}
 
-				// Wall condition
-				if (ActorTypeToSpawn == EAT::None                           // all previous conditions are false
-				    && !IsSafeZone && FMath::RandHelper(100) < WallsChance) // chance of walls
+	// --- Move reused actors
+	for (const TTuple<UMapComponent*, FCell>& MoveIt : Moves)
+	{
+		UMapComponent* MapComponent = MoveIt.Key;
+		const FCell PreviousCell = MapComponent->GetCell();
+		MapComponent->SetCell(MoveIt.Value);
+		AddToGrid(MapComponent);
+		UpdateCellActorTypes(PreviousCell);
+	}
+}
+
+// Removes the least number of generated walls to make all specified cells reachable from the first cell
+void AGeneratedMap::CarvePathToCells(TMap<FCell, EActorType>& InOutActorsToSpawn, const FCells& CellsToFind, const FCells& FixedWalls) const
+{
+	const int32 CellsNum = GridCellsInternal.Num();
+	const int32 MaxWidth = GridSizeInternal.X;
+	const int32 MaxLength = GridSizeInternal.Y;
+	if (!CellsNum
+	    || !MaxWidth)
+	{
+		return;
+	}
+
+	TBitArray<> FixedWallsBits(false, CellsNum);
+	for (const FCell& FixedWallIt : FixedWalls)
+	{
+		const int32 FixedWallIndex = GetCellIndex(FixedWallIt);
+		if (FixedWallIndex != INDEX_NONE)
+		{
+			FixedWallsBits[FixedWallIndex] = true;
+		}
+	}
+
+	auto IsGeneratedWall = [this, &InOutActorsToSpawn](int32 CellIndex)
+	{
+		const EActorType* ActorType = InOutActorsToSpawn.Find(GridCellsInternal[CellIndex]);
+		return ActorType && *ActorType == EAT::Wall;
+	};
+
+	// 0-1 breadth-first search: moving to a generated wall costs 1, to any other cell costs 0
+	TArray<int32> Costs;
+	Costs.Init(MAX_int32, CellsNum);
+	TArray<int32> Parents;
+	Parents.Init(INDEX_NONE, CellsNum);
+	TArray<int32> CurrentLayer{0};
+	TArray<int32> NextLayer;
+	Costs[0] = 0;
+	for (int32 LayerCost = 0; CurrentLayer.Num(); ++LayerCost)
+	{
+		for (int32 LayerIndex = 0; LayerIndex < CurrentLayer.Num(); ++LayerIndex)
+		{
+			const int32 CellIndex = CurrentLayer[LayerIndex];
+			if (Costs[CellIndex] != LayerCost)
+			{
+				// Was reached cheaper
+				continue;
+			}
+
+			const int32 Column = CellIndex % MaxWidth;
+			const int32 NeighbourIndices[] = {
+				Column > 0 ? CellIndex - 1 : INDEX_NONE,            // Left
+				Column < MaxWidth - 1 ? CellIndex + 1 : INDEX_NONE, // Right
+				CellIndex - MaxWidth,                               // Forward
+				CellIndex + MaxWidth                                // Backward
+			};
+
+			for (const int32 NeighbourIndexIt : NeighbourIndices)
+			{
+				if (NeighbourIndexIt < 0
+				    || NeighbourIndexIt >= CellsNum
+				    || FixedWallsBits[NeighbourIndexIt])
 				{
-					ActorTypeToSpawn = EAT::Wall;
+					continue;
 				}
 
-				// Box condition
-				if (ActorTypeToSpawn == EAT::None                           // all previous conditions are false
-				    && !IsSafeZone && FMath::RandHelper(100) < BoxesChance) // Chance of boxes
+				const int32 StepCost = IsGeneratedWall(NeighbourIndexIt) ? 1 : 0;
+				if (LayerCost + StepCost < Costs[NeighbourIndexIt])
 				{
-					ActorTypeToSpawn = EAT::Box;
+					Costs[NeighbourIndexIt] = LayerCost + StepCost;
+					Parents[NeighbourIndexIt] = CellIndex;
+					(StepCost ? NextLayer : CurrentLayer).Emplace(NeighbourIndexIt);
 				}
+			}
+		}
 
-				if (ActorTypeToSpawn == EAT::None) // There is no types to spawn
+		CurrentLayer = MoveTemp(NextLayer);
+		NextLayer.Reset();
+	}
+
+	// Remove generated walls on the cheapest path to each cell, together with their symmetrical walls
+	for (const FCell& CellToFindIt : CellsToFind)
+	{
+		for (int32 PathIndex = GetCellIndex(CellToFindIt); PathIndex != INDEX_NONE; PathIndex = Parents[PathIndex])
+		{
+			if (!IsGeneratedWall(PathIndex))
+			{
+				continue;
+			}
+
+			const int32 X = PathIndex % MaxWidth, Y = PathIndex / MaxWidth;
+			const int32 Xs = MaxWidth - 1 - X, Ys = MaxLength - 1 - Y;
+			const int32 SymmetricalIndices[] = {PathIndex, Y * MaxWidth + Xs, Ys * MaxWidth + X, Ys * MaxWidth + Xs};
+			for (const int32 SymmetricalIndexIt : SymmetricalIndices)
+			{
+				if (GridCellsInternal.IsValidIndex(SymmetricalIndexIt)
+				    && IsGeneratedWall(SymmetricalIndexIt))
 				{
-					continue;
+					InOutActorsToSpawn.Remove(GridCellsInternal[SymmetricalIndexIt]);
 				}
+			}
+		}
+	}
+}
 
-				// 0.1) Array symmetrization
-				const int32 Xs = MapScale.X - 1 - X, Ys = MapScale.Y - 1 - Y; // Symmetrized cell position
-				for (int32 I = 0; I < 4; ++I)                                 // 4 sides of symmetry
-				{
-					if (I > 0) // the 0 index is always current CellIt, otherwise needs to find symmetry
-					{
-						int32 Xi = X, Yi = Y; // Keeping the current coordinates
-						switch (I)
-						{
-							case 1: // (X1 = Xs; Y1 = Y)
-								Xi = Xs;
-								break;
-							case 2: // (X2 = X; Y2 = Ys)
-								Yi = Ys;
-								break;
-							case 3: // (X3 = Xs; Y3 = Ys)
-								Xi = Xs;
-								Yi = Ys;
-								break;
-							default:
-								break;
-						}
+// Makes all specified cells reachable from the first cell in one pass by union-find of free cells
+void AGeneratedMap::ConnectCellsByWallGroups(TMap<FCell, EActorType>& InOutActorsToSpawn, const FCells& CellsToFind, const FCells& FixedWalls, FRandomStream& RandomStream) const
+{
+	const int32 CellsNum = GridCellsInternal.Num();
+	const int32 MaxWidth = GridSizeInternal.X;
+	const int32 MaxLength = GridSizeInternal.Y;
+	if (!CellsNum
+	    || !MaxWidth)
+	{
+		return;
+	}
 
-						CellIt = GridCellsInternal[MapScale.X * Yi + Xi];
-					}
+	// Walls break areas: fixed ones are never removed, generated ones are grouped by their symmetry
+	TBitArray<> WallsBits(false, CellsNum);
+	for (const FCell& FixedWallIt : FixedWalls)
+	{
+		const int32 FixedWallIndex = GetCellIndex(FixedWallIt);
+		if (FixedWallIndex != INDEX_NONE)
+		{
+			WallsBits[FixedWallIndex] = true;
+		}
+	}
 
-					if (!LDraggedCells.Contains(CellIt)) // the cell is free
-					{
-						LActorsToSpawn.Emplace(CellIt, ActorTypeToSpawn);
-						if (ActorTypeToSpawn == EAT::Wall)
-						{
-							WallsToSpawn.Emplace(CellIt);
-						}
-						else if (ActorTypeToSpawn == EAT::Player
-						         || ActorTypeToSpawn == EAT::Box)
-						{
-							LCellsToFind.Emplace(CellIt);
-						}
-					}
-				} // Symmetry iterations
-			}     // X iterations
-		}         // Y iterations
+	TMap<int32, FCellIndices> WallGroups;
+	for (const TTuple<FCell, EActorType>& It : InOutActorsToSpawn)
+	{
+		const int32 WallIndex = It.Value == EAT::Wall ? GetCellIndex(It.Key) : INDEX_NONE;
+		if (WallIndex != INDEX_NONE)
+		{
+			WallsBits[WallIndex] = true;
 
-		// --- Part 1 : Checking if there is a path to the bottom and side edges. If not, go to the 0 step._ ---
+			// The key is the cell of the first quarter, it is the same for all symmetrical walls
+			const int32 X = WallIndex % MaxWidth, Y = WallIndex / MaxWidth;
+			const int32 GroupKey = FMath::Min(Y, MaxLength - 1 - Y) * MaxWidth + FMath::Min(X, MaxWidth - 1 - X);
+			WallGroups.FindOrAdd(GroupKey).Emplace(WallIndex);
+		}
+	}
 
-		const FCells PathBreakers = WallsToSpawn.Union(DraggedWalls);
-		bFoundPath = DoesPathExistToCells(LCellsToFind, PathBreakers);
+	// --- Union-find of free cells, each root keeps the number of required cells in its area
 
-		// Go to the step 0 if don't found
-		if (!bFoundPath)
+	TArray<int32> Parents;
+	Parents.SetNumUninitialized(CellsNum);
+	for (int32 Index = 0; Index < CellsNum; ++Index)
+	{
+		Parents[Index] = Index;
+	}
+
+	TArray<int32> RequiredNums;
+	RequiredNums.Init(0, CellsNum);
+	int32 RequiredTotal = 0;
+	for (const FCell& CellToFindIt : CellsToFind)
+	{
+		const int32 RequiredIndex = GetCellIndex(CellToFindIt);
+		if (RequiredIndex != INDEX_NONE
+		    && !WallsBits[RequiredIndex]
+		    && !RequiredNums[RequiredIndex])
 		{
-			++Counter;
-			WallsChance -= WallsChance * 0.01f; // decrease local chance of walls to avoid forever loop
-			continue;
+			RequiredNums[RequiredIndex] = 1;
+			++RequiredTotal;
+		}
+	}
+
+	auto FindRoot = [&Parents](int32 Index)
+	{
+		while (Parents[Index] != Index)
+		{
+			Parents[Index] = Parents[Parents[Index]]; // path halving
+			Index = Parents[Index];
+		}
+		return Index;
+	};
+
+	auto UnionCells = [&Parents, &RequiredNums, &FindRoot](int32 IndexA, int32 IndexB)
+	{
+		const int32 RootA = FindRoot(IndexA);
+		const int32 RootB = FindRoot(IndexB);
+		if (RootA != RootB)
+		{
+			Parents[RootB] = RootA;
+			RequiredNums[RootA] += RequiredNums[RootB];
+		}
+	};
+
+	auto GetNeighbours = [CellsNum, MaxWidth](int32 Index, int32 (&OutNeighbours)[4])
+	{
+		const int32 Column = Index % MaxWidth;
+		OutNeighbours[0] = Column > 0 ? Index - 1 : INDEX_NONE;            // Left
+		OutNeighbours[1] = Column < MaxWidth - 1 ? Index + 1 : INDEX_NONE; // Right
+		OutNeighbours[2] = Index - MaxWidth >= 0 ? Index - MaxWidth : INDEX_NONE;
+		OutNeighbours[3] = Index + MaxWidth < CellsNum ? Index + MaxWidth : INDEX_NONE;
+	};
+
+	auto OpenCell = [&WallsBits, &GetNeighbours, &UnionCells](int32 Index)
+	{
+		WallsBits[Index] = false;
+		int32 Neighbours[4];
+		GetNeighbours(Index, Neighbours);
+		for (const int32 NeighbourIt : Neighbours)
+		{
+			if (NeighbourIt != INDEX_NONE
+			    && !WallsBits[NeighbourIt])
+			{
+				UnionCells(Index, NeighbourIt);
+			}
 		}
+	};
 
-		// Paths were found, exit-loop condition (bFoundPath == true)
-		ActorsToSpawn = LActorsToSpawn;
+	for (int32 Index = 0; Index < CellsNum; ++Index)
+	{
+		if (!WallsBits[Index])
+		{
+			OpenCell(Index);
+		}
 	}
 
-	// --- Part 2: Spawning ---
+	auto IsConnected = [&RequiredNums, &FindRoot, RequiredTotal]()
+	{
+		return RequiredNums[FindRoot(0)] >= RequiredTotal;
+	};
 
-	SpawnActorsByTypes(ActorsToSpawn);
+	// --- Remove wall groups in random order while they join separated areas
+
+	TArray<int32> GroupKeys;
+	WallGroups.GetKeys(GroupKeys);
+	for (int32 Index = GroupKeys.Num() - 1; Index > 0; --Index)
+	{
+		GroupKeys.Swap(Index, RandomStream.RandRange(0, Index));
+	}
+
+	for (const int32 GroupKeyIt : GroupKeys)
+	{
+		if (IsConnected())
+		{
+			break;
+		}
+
+		// Find all areas around this group
+		const FCellIndices& GroupCells = WallGroups.FindChecked(GroupKeyIt);
+		TArray<int32, TInlineAllocator<16>> AreaRoots;
+		for (const int32 WallIndexIt : GroupCells)
+		{
+			int32 Neighbours[4];
+			GetNeighbours(WallIndexIt, Neighbours);
+			for (const int32 NeighbourIt : Neighbours)
+			{
+				if (NeighbourIt != INDEX_NONE
+				    && !WallsBits[NeighbourIt])
+				{
+					AreaRoots.AddUnique(FindRoot(NeighbourIt));
+				}
+			}
+		}
+
+		if (AreaRoots.Num() < 2)
+		{
+			// Removing this group would not connect anything
+			continue;
+		}
+
+		for (const int32 WallIndexIt : GroupCells)
+		{
+			OpenCell(WallIndexIt);
+			InOutActorsToSpawn.Remove(GridCellsInternal[WallIndexIt]);
+		}
+	}
+
+	if (!IsConnected())
+	{
+		// Some areas are separated by thick walls where no single group touches both sides, cut through them
+		CarvePathToCells(InOutActorsToSpawn, CellsToFind, FixedWalls);
+	}
 }
 
 //  Map components getter.
 void AGeneratedMap::GetMapComponents(FMapComponents& OutBitmaskedComponents, int32 ActorsTypesBitmask) const
 {
+	GENERATED_MAP_STAT_SCOPE(GetMapComponents);
+
 	if (!MapComponentsInternal.Num())
 	{
 		return;
 	}
 
-	for (UMapComponent* MapComponentIt : MapComponentsInternal)
+	// Types are checked over packed memory, so only matched map components are touched
+	const FPackedMapComponents& Packed = GetPackedMapComponents();
+	for (int32 ItemIndex = 0; ItemIndex < Packed.ActorTypes.Num(); ++ItemIndex)
 	{
-		if (MapComponentIt
-		    && EnumHasAnyFlags(MapComponentIt->GetActorType(), TO_ENUM(EActorType, ActorsTypesBitmask)))
+		if (!(Packed.ActorTypes[ItemIndex] & ActorsTypesBitmask))
+		{
+			continue;
+		}
+
+		if (UMapComponent* MapComponentIt = MapComponentsInternal[ItemIndex])
 		{
 			OutBitmaskedComponents.Emplace(MapComponentIt);
 		}
 	}
 }
 
+// Returns the first map component of specified actor types located on the cell by its row-major index
+UMapComponent* AGeneratedMap::GetMapComponentOnCellIndex(int32 CellIndex, int32 ActorsTypesBitmask) const
+{
+	if (!GridCellsInternal.IsValidIndex(CellIndex)
+	    || !(GetActorTypesOnCellIndex(CellIndex) & ActorsTypesBitmask))
+	{
+		// Nothing of these types on the cell, skip the search
+		return nullptr;
+	}
+
+	// Only items indexed by this cell are checked instead of walking all map components
+	TArray<int32, TInlineAllocator<4>> ItemIndices;
+	MapComponentsInternal.FindIndices(GridCellsInternal[CellIndex], ItemIndices);
+	for (const int32 ItemIndex : ItemIndices)
+	{
+		if (TO_FLAG(GetSpecActorType(MapComponentsInternal.Items[ItemIndex])) & ActorsTypesBitmask)
+		{
+			return MapComponentsInternal[ItemIndex];
+		}
+	}
+
+	return nullptr;
+}
+
 // Listen game states to generate level actors
 void AGeneratedMap::OnGameStateChanged(ECurrentGameState CurrentGameState)
 {
@@ -1047,13 +3721,34 @@ void AGeneratedMap::OnGameStateChanged(ECurrentGameState CurrentGameState)
 		return;
 	}
 
+	// Checkpoints are captured only while the match is in progress, the last one is kept for the rematch
+	if (UWorld* World = GetWorld())
+	{
+		FTimerManager& TimerManager = World->GetTimerManager();
+		const float CheckpointSeconds = CVarMatchCheckpointSeconds.GetValueOnGameThread();
+		if (CurrentGameState == ECurrentGameState::InGame
+		    && CheckpointSeconds > 0.f)
+		{
+			constexpr bool bLoop = true;
+			TimerManager.SetTimer(MatchCheckpointTimerInternal, this, &ThisClass::CaptureMatchCheckpoint, CheckpointSeconds, bLoop);
+		}
+		else
+		{
+			TimerManager.ClearTimer(MatchCheckpointTimerInternal);
+		}
+	}
+
 	switch (CurrentGameState)
 	{
 		case ECurrentGameState::Menu:
 		{
-			// on returning to menu case
-			GenerateLevelActors();
+			// on returning to menu case, the layout could be already prebuilt during the end game
+			if (!SpawnPrebuiltLevelActors())
+			{
+				GenerateLevelActors();
+			}
 			bIsGameRunningInternal = false;
+			MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, bIsGameRunningInternal, this);
 			break;
 		}
 
@@ -1061,12 +3756,23 @@ void AGeneratedMap::OnGameStateChanged(ECurrentGameState CurrentGameState)
 		{
 			if (bIsGameRunningInternal)
 			{
-				// on reset pressed case
-				GenerateLevelActors();
+				// on reset pressed case, the layout could be already prebuilt during the end game
+				if (!SpawnPrebuiltLevelActors())
+				{
+					GenerateLevelActors();
+				}
 			}
 
 			bIsGameRunningInternal = true;
-			AdditionalDangerousCells.Reset();
+			MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, bIsGameRunningInternal, this);
+			SetAdditionalDangerousCells({});
+			break;
+		}
+
+		case ECurrentGameState::EndGame:
+		{
+			// The server is idle on the end game screen, so compute the next round and warm pools for it
+			PrebuildLevelActors();
 			break;
 		}
 
@@ -1078,28 +3784,76 @@ void AGeneratedMap::OnGameStateChanged(ECurrentGameState CurrentGameState)
 // Align transform and build cells
 void AGeneratedMap::TransformGeneratedMap(const FTransform& Transform)
 {
+	STARTUP_TIMING_SCOPE(TransformGeneratedMap);
+
+	// The layout is computed on the current grid, so its pending warm up and spawn are skipped
+	WaitForLevelLayoutTask();
+	++LevelLayoutGenerationInternal;
+	PrebuiltLevelLayoutInternal.Reset();
+
 	const FTransform NewGridTransform = ActorTransformToGridTransform(Transform);
-	const FCells NewGridCells = FCell::MakeCellGridByTransform(NewGridTransform);
+	const FIntPoint NewGridSize(NewGridTransform.GetScale3D().X, NewGridTransform.GetScale3D().Y);
+
+	// Cells of unrotated grid are whole cells away from its first one, so if only its location is changed, they are moved instead of being rebuilt
+	const bool bIsTranslatedOnly = !GridCellsInternal.IsEmpty()
+	                               && NewGridSize == GridSizeInternal
+	                               && GridCellsInternal.Num() == NewGridSize.X * NewGridSize.Y
+	                               && FMath::IsNearlyZero(NewGridTransform.Rotator().Yaw)
+	                               && FMath::IsNearlyZero(GridTransformInternal.Rotator().Yaw);
+	if (bIsTranslatedOnly)
+	{
+		const FVector Offset = FCell::GetUnrotatedFirstCellByTransform(NewGridTransform).Location - GridCellsInternal[0].Location;
+		FCell::TranslateCellGrid(GridCellsInternal, Offset);
+	}
+	else
+	{
+		// The grid is built straight into its dense row-major layout
+		TArray<FCell> NewGridArray;
+		FCell::MakeCellGridByTransform(NewGridTransform, NewGridArray);
+
+		ScaleDraggedCellsOnGrid(GridCellsInternal, NewGridArray);
 
-	ScaleDraggedCellsOnGrid(FCells{GridCellsInternal}, NewGridCells);
+		GridCellsInternal = MoveTemp(NewGridArray);
+	}
 
 	SetActorTransform(NewGridTransform);
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, GridCellsInternal, this);
+
+	// Cache the geometry of the new grid
+	GridSizeInternal = NewGridSize;
+	GridTransformInternal = FCell::GetGridTransformNoScale(GridCellsInternal);
+	GridTransformInternal.SetScale3D(FVector(GridSizeInternal.X, GridSizeInternal.Y, 1.f));
+	const int32 CenterCellIndex = GridSizeInternal.Y / 2 * GridSizeInternal.X + GridSizeInternal.X / 2;
+	GridCenterCellInternal = GridCellsInternal.IsValidIndex(CenterCellIndex) ? GridCellsInternal[CenterCellIndex] : FCell::InvalidCell;
+
+	// Index cells of the new grid
+	CellIndicesInternal.Reset();
+	CellIndicesInternal.Reserve(GridCellsInternal.Num());
+	for (int32 CellIndex = 0; CellIndex < GridCellsInternal.Num(); ++CellIndex)
+	{
+		CellIndicesInternal.Emplace(GridCellsInternal[CellIndex], CellIndex);
+	}
 
-	GridCellsInternal = NewGridCells.Array();
+	// Packed cells of map components are indices of the previous grid
+	MarkPackedMapComponentsDirty();
+	RebuildCellActorTypes();
 }
 
 // Scales dragged cells according new grid if sizes are different
-void AGeneratedMap::ScaleDraggedCellsOnGrid(const FCells& OriginalGrid, const FCells& NewGrid)
+void AGeneratedMap::ScaleDraggedCellsOnGrid(const TArray<FCell>& OriginalGrid, const TArray<FCell>& NewGrid)
 {
 	if (OriginalGrid.IsEmpty()
-	    || OriginalGrid.Num() == NewGrid.Num())
+	    || OriginalGrid.Num() == NewGrid.Num()
+	    || DraggedCellsInternal.IsEmpty())
 	{
 		// Do not scale if the sizes are the same
 		return;
 	}
 
-	const FCells CornerCells = FCell::GetCornerCellsOnGrid(NewGrid);
-	const FCells NewGridWithoutCorners = NewGrid.Difference(CornerCells);
+	// Only the new grid is searched for nearest cells, so only it is copied into the set
+	const FCells NewGridCells(NewGrid);
+	const FCells CornerCells = FCell::GetCornerCellsOnGrid(NewGridCells);
+	const FCells NewGridWithoutCorners = NewGridCells.Difference(CornerCells);
 
 	for (TTuple<FCell, EActorType>& DraggedCellRefIt : DraggedCellsInternal)
 	{
@@ -1112,6 +3866,8 @@ void AGeneratedMap::ScaleDraggedCellsOnGrid(const FCells& OriginalGrid, const FC
 // Updates current level type
 void AGeneratedMap::ApplyLevelType()
 {
+	STARTUP_TIMING_SCOPE(ApplyLevelType);
+
 	UWorld* World = GetWorld();
 	TArray<FLevelStreamRow> LevelStreamRows;
 	UGeneratedMapDataAsset::Get().GetLevelStreamRows(LevelStreamRows);
@@ -1194,7 +3950,21 @@ void AGeneratedMap::ApplyLevelType()
 
 	// ---- Changing levels during the game ----
 
-	// show the specified level, hide other levels
+	// The level of not installed chunk can't be loaded, so the level type is applied again once its chunk is installed
+	StopListeningLevelTypeInstall();
+	const UGeneratedMapDataAsset& GeneratedMapDataAsset = UGeneratedMapDataAsset::Get();
+	if (!GeneratedMapDataAsset.IsLevelTypeInstalled(LevelTypeInternal))
+	{
+		if (IPlatformChunkInstall* ChunkInstall = FPlatformMisc::GetPlatformChunkInstall())
+		{
+			LevelTypeInstallHandleInternal = ChunkInstall->AddChunkInstallDelegate(FPlatformChunkInstallDelegate::CreateUObject(this, &ThisClass::OnLevelTypeChunkInstalled));
+		}
+
+		GeneratedMapDataAsset.RequestLevelTypeInstall(LevelTypeInternal);
+		return;
+	}
+
+	// show the specified level, hide other levels, levels that are not loaded are not loaded only to be hidden
 	for (int32 Index = 0; Index < LevelStreamRows.Num(); ++Index)
 	{
 		FName PackageName;
@@ -1212,6 +3982,11 @@ void AGeneratedMap::ApplyLevelType()
 
 		if (!LevelStreaming->IsLevelLoaded())
 		{
+			if (!bShouldBeVisibleIt)
+			{
+				continue;
+			}
+
 			LevelStreaming->OnLevelLoaded.AddUniqueDynamic(this, &ThisClass::ApplyLevelType);
 
 			FLatentActionInfo LatentInfo;
@@ -1226,17 +4001,167 @@ void AGeneratedMap::ApplyLevelType()
 		}
 	}
 
+	TouchRecentLevelType(LevelTypeInternal);
+
 	if (OnSetNewLevelType.IsBound())
 	{
 		OnSetNewLevelType.Broadcast(LevelTypeInternal);
 	}
 
 	// Once level is loading, prepare him
-	for (UMapComponent* MapComponentIt : MapComponentsInternal)
+	SwapLevelActorMeshes();
+}
+
+// Is called by the platform when any pak chunk is installed, applies current level type again if its chunk is installed
+void AGeneratedMap::OnLevelTypeChunkInstalled(uint32 ChunkId, bool bSuccess)
+{
+	const int32 LevelTypeChunkId = UGeneratedMapDataAsset::Get().GetLevelTypeChunkId(LevelTypeInternal);
+	if (!bSuccess
+	    || static_cast<int32>(ChunkId) != LevelTypeChunkId)
+	{
+		// Another chunk is installed or the install failed, keep waiting for the level type chunk
+		return;
+	}
+
+	StopListeningLevelTypeInstall();
+	ApplyLevelType();
+}
+
+// Stops listening the install of the level type chunk if it's still in progress
+void AGeneratedMap::StopListeningLevelTypeInstall()
+{
+	if (!LevelTypeInstallHandleInternal.IsValid())
+	{
+		return;
+	}
+
+	if (IPlatformChunkInstall* ChunkInstall = FPlatformMisc::GetPlatformChunkInstall())
+	{
+		ChunkInstall->RemoveChunkInstallDelegate(LevelTypeInstallHandleInternal);
+	}
+	LevelTypeInstallHandleInternal.Reset();
+}
+
+// Moves given level type to the front of recently used ones and delays unloading of level types over the budget
+void AGeneratedMap::TouchRecentLevelType(ELevelType LevelType)
+{
+	UWorld* World = GetWorld();
+	if (!World
+	    || LevelType == ELT::None)
+	{
+		return;
+	}
+
+	RecentLevelTypesInternal.Remove(LevelType);
+	RecentLevelTypesInternal.Insert(LevelType, 0);
+
+	// Is restarted on each switch, so levels are not unloaded while players are browsing level types
+	const UGeneratedMapDataAsset& GeneratedMapDataAsset = UGeneratedMapDataAsset::Get();
+	if (RecentLevelTypesInternal.Num() > GeneratedMapDataAsset.GetRecentLevelTypesNum() + 1)
+	{
+		constexpr bool bLoop = false;
+		const float UnloadDelay = FMath::Max(GeneratedMapDataAsset.GetLevelUnloadDelay(), KINDA_SMALL_NUMBER);
+		World->GetTimerManager().SetTimer(UnloadLevelTypesTimerInternal, this, &ThisClass::UnloadInactiveLevelTypes, UnloadDelay, bLoop);
+	}
+}
+
+// Unloads streaming levels of all level types except the current one and the most recently used ones within the budget
+void AGeneratedMap::UnloadInactiveLevelTypes()
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// The current level is always kept even if it was not touched last, e.g. another level type is just preloaded
+	const UGeneratedMapDataAsset& GeneratedMapDataAsset = UGeneratedMapDataAsset::Get();
+	RecentLevelTypesInternal.Remove(LevelTypeInternal);
+	RecentLevelTypesInternal.Insert(LevelTypeInternal, 0);
+	const int32 MaxLoadedLevelTypes = GeneratedMapDataAsset.GetRecentLevelTypesNum() + 1;
+	if (RecentLevelTypesInternal.Num() <= MaxLoadedLevelTypes)
+	{
+		return;
+	}
+	RecentLevelTypesInternal.SetNum(MaxLoadedLevelTypes);
+
+	TArray<FLevelStreamRow> LevelStreamRows;
+	GeneratedMapDataAsset.GetLevelStreamRows(LevelStreamRows);
+	for (int32 Index = 0; Index < LevelStreamRows.Num(); ++Index)
+	{
+		const FLevelStreamRow& LevelStreamRowIt = LevelStreamRows[Index];
+		const FName PackageName = *LevelStreamRowIt.Level.GetLongPackageName();
+		if (PackageName.IsNone()
+		    || RecentLevelTypesInternal.Contains(LevelStreamRowIt.LevelType))
+		{
+			continue;
+		}
+
+		const ULevelStreaming* LevelStreaming = UGameplayStatics::GetStreamingLevel(World, PackageName);
+		if (LevelStreaming
+		    && LevelStreaming->ShouldBeLoaded()
+		    && !LevelStreaming->ShouldBeVisible())
+		{
+			// Same UUID as in ApplyLevelType, so the level is not unloaded while its latent load is still in progress
+			FLatentActionInfo LatentInfo;
+			LatentInfo.UUID = Index;
+			constexpr bool bShouldBlockOnUnload = false;
+			UGameplayStatics::UnloadStreamLevel(World, PackageName, LatentInfo, bShouldBlockOnUnload);
+			UE_LOG(LogBomber, Log, TEXT("Level type streaming: '%s' is unloaded over the budget of %i loaded level types"), *PackageName.ToString(), MaxLoadedLevelTypes);
+		}
+	}
+}
+
+// Swaps meshes of all level actors to rows of current level type in one pass without placing them on the grid again
+void AGeneratedMap::SwapLevelActorMeshes(int32 ActorTypesBitmask/* = TO_FLAG(EAT::All)*/)
+{
+	// Meshes of players and items depend on their own state like skin or item type, so these are reconstructed
+	constexpr int32 ReconstructedTypes = TO_FLAG(EAT::Player | EAT::Item);
+
+	// Resolve the row of new level type once per actor type
+	TArray<const ULevelActorRow*, TInlineAllocator<ActorTypesNum>> RowsByTypeBit;
+	RowsByTypeBit.SetNumZeroed(ActorTypesNum);
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		const int32 ActorType = 1 << TypeIndex;
+		const ULevelActorDataAsset* DataAsset = !(ActorType & ReconstructedTypes) ? UDataAssetsContainer::GetDataAssetByActorType(TO_ENUM(EActorType, ActorType)) : nullptr;
+		RowsByTypeBit[TypeIndex] = DataAsset ? DataAsset->GetRowByLevelType(LevelTypeInternal) : nullptr;
+	}
+
+	// Copy components first, since reconstruction could change map components
+	const FPackedMapComponents& Packed = GetPackedMapComponents();
+	TArray<TPair<UMapComponent*, int32>, TInlineAllocator<256>> ComponentsToSwap;
+	ComponentsToSwap.Reserve(Packed.ActorTypes.Num());
+	for (int32 ItemIndex = 0; ItemIndex < Packed.ActorTypes.Num(); ++ItemIndex)
+	{
+		UMapComponent* MapComponentIt = MapComponentsInternal[ItemIndex];
+		if (MapComponentIt
+		    && (Packed.ActorTypes[ItemIndex] & ActorTypesBitmask))
+		{
+			ComponentsToSwap.Emplace(MapComponentIt, Packed.ActorTypes[ItemIndex]);
+		}
+	}
+
+	for (const TPair<UMapComponent*, int32>& It : ComponentsToSwap)
 	{
-		if (MapComponentIt)
+		UMapComponent* MapComponent = It.Key;
+		const int32 ActorType = It.Value;
+		const int32 TypeIndex = ActorType ? FMath::FloorLog2(ActorType) : INDEX_NONE;
+		const ULevelActorRow* Row = RowsByTypeBit.IsValidIndex(TypeIndex) ? RowsByTypeBit[TypeIndex] : nullptr;
+		if (!IsValid(MapComponent))
+		{
+			continue;
+		}
+
+		if (Row
+		    && !MapComponent->GetCustomMeshAsset())
+		{
+			MapComponent->SetDefaultMeshByRow(Row);
+		}
+		else
 		{
-			MapComponentIt->ConstructOwnerActor();
+			// The mesh is custom or depends on the owner, so let it to construct itself
+			MapComponent->ConstructOwnerActor();
 		}
 	}
 }
@@ -1245,15 +4170,35 @@ void AGeneratedMap::ApplyLevelType()
 void AGeneratedMap::OnRep_LevelType()
 {
 	ApplyLevelType();
+
+	// Walls drawn by the layout have to be updated to meshes of new level type
+	UpdateInstancedWallsLayout();
 }
 
 // Is called on client to broadcast On Generated Level Actors delegate
 void AGeneratedMap::OnRep_MapComponents()
 {
+	BOMBER_PERF_BUDGET_SCOPE(OnRepMapComponents);
+
+	// The occupancy grid is already updated per cell by replication callbacks of specs
+	ReconcilePredictedActorTypes();
+
+	// Remove instances of walls and boxes that are not on the level anymore
+	if (InstancedMeshesComponentInternal
+	    && UInstancedLevelMeshesComponent::IsInstancingEnabled())
+	{
+		TSet<const UMapComponent*> KeptMapComponents;
+		for (const UMapComponent* MapComponentIt : MapComponentsInternal)
+		{
+			KeptMapComponents.Emplace(MapComponentIt);
+		}
+		InstancedMeshesComponentInternal->RemoveInstancesExcept(KeptMapComponents);
+	}
+
 	// Array of level actors is just replicated, try to broadcast On Generated Level Actors delegate
 	if (OnGeneratedLevelActors.IsBound()
 	    && AMyGameStateBase::GetCurrentGameState() != ECGS::InGame
-	    && !MapComponentsInternal.ContainsByPredicate([](const FMapComponentSpec& It) { return !It.IsValid(); }))
+	    && !MapComponentsInternal.GetUnresolvedNum())
 	{
 		// It is not regular match, probably is Menu state or game is currently starting (3-2-1)
 		// and array contains only valid specs (all actors are spawned and replicated)
@@ -1261,9 +4206,255 @@ void AGeneratedMap::OnRep_MapComponents()
 	}
 }
 
+// Marks given cell on client as occupied by given actor type until its authoritative level actor is replicated there
+void AGeneratedMap::AddPredictedActorType(const FCell& Cell, EActorType ActorType)
+{
+	const int32 CellIndex = GetCellIndex(Cell);
+	if (HasAuthority()
+	    || CellIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	PredictedActorTypesInternal.FindOrAdd(CellIndex) |= TO_FLAG(ActorType);
+	UpdateCellActorTypes(Cell);
+}
+
+// Removes the prediction of given actor type on specified cell
+void AGeneratedMap::RemovePredictedActorType(const FCell& Cell, EActorType ActorType)
+{
+	const int32 CellIndex = GetCellIndex(Cell);
+	int32* FoundActorTypes = PredictedActorTypesInternal.Find(CellIndex);
+	if (!FoundActorTypes)
+	{
+		return;
+	}
+
+	*FoundActorTypes &= ~TO_FLAG(ActorType);
+	if (!*FoundActorTypes)
+	{
+		PredictedActorTypesInternal.Remove(CellIndex);
+	}
+	UpdateCellActorTypes(Cell);
+}
+
+// Returns true if given actor type is still predicted on the cell
+bool AGeneratedMap::IsPredictedActorType(const FCell& Cell, EActorType ActorType) const
+{
+	return (PredictedActorTypesInternal.FindRef(GetCellIndex(Cell)) & TO_FLAG(ActorType)) != 0;
+}
+
+// Packs current walls occupancy into the replicated walls bitmask, is called on the server when walls are changed
+void AGeneratedMap::UpdateWallsBitmask()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	const FCellsBitboard& WallsBitboard = ActorTypesBitboardsInternal[FMath::FloorLog2(TO_FLAG(EAT::Wall))];
+	const int32 CellsNum = WallsBitboard.Num();
+
+	TArray<uint8> NewWallsBitmask;
+	NewWallsBitmask.Init(0, FMath::DivideAndRoundUp(CellsNum, 8));
+	WallsBitboard.ForEachSetBit([&NewWallsBitmask](int32 CellIndex)
+	{
+		NewWallsBitmask[CellIndex / 8] |= 1 << (CellIndex % 8);
+	});
+
+	if (NewWallsBitmask != WallsBitmaskInternal)
+	{
+		// Is replicated only when the layout is actually changed
+		WallsBitmaskInternal = MoveTemp(NewWallsBitmask);
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, WallsBitmaskInternal, this);
+	}
+}
+
+// Returns actor types that are known on client without map components
+int32 AGeneratedMap::GetClientActorTypes(int32 CellIndex) const
+{
+	if (HasAuthority()
+	    || CellIndex == INDEX_NONE)
+	{
+		// Server knows all level actors by their map components
+		return TO_FLAG(EAT::None);
+	}
+
+	int32 ActorTypes = PredictedActorTypesInternal.FindRef(CellIndex);
+	if (WallsBitmaskInternal.IsValidIndex(CellIndex / 8)
+	    && WallsBitmaskInternal[CellIndex / 8] & (1 << (CellIndex % 8)))
+	{
+		ActorTypes |= TO_FLAG(EAT::Wall);
+	}
+
+	return ActorTypes;
+}
+
+// Removes predicted actor types that are already replicated by map components on their cells
+void AGeneratedMap::ReconcilePredictedActorTypes()
+{
+	// The occupancy of reconciled cells stays the same, since confirmed types are replicated there
+	for (TMap<int32, int32>::TIterator It = PredictedActorTypesInternal.CreateIterator(); It; ++It)
+	{
+		It.Value() &= ~GetReplicatedActorTypes(It.Key());
+		if (!It.Value())
+		{
+			// Prediction is confirmed by the server
+			It.RemoveCurrent();
+		}
+	}
+}
+
+// Is called on client by replication callbacks of given spec to move it in the occupancy mirror by its replicated cell and type
+void AGeneratedMap::MirrorReplicatedSpec(FMapComponentSpec& InOutSpec, bool bIsRemoved)
+{
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	if (ReplicatedActorTypesNumInternal.Num() != GridCellsInternal.Num() * ActorTypesNum)
+	{
+		// The grid is not mirrored yet, recount all specs with the whole occupancy at once, then continue with this spec if it is removed
+		RebuildCellActorTypes();
+	}
+
+	const int32 PreviousCellIndex = InOutSpec.MirroredCellIndex;
+	const EActorType PreviousActorType = InOutSpec.MirroredActorType;
+	const int32 NewCellIndex = bIsRemoved ? INDEX_NONE : GetCellIndex(InOutSpec.Cell);
+	const EActorType NewActorType = bIsRemoved ? EAT::None : InOutSpec.ActorType;
+
+	if (NewActorType == EAT::Bomb
+	    && FBombLatencyStats::IsEnabled())
+	{
+		// Ends the round trip of the local bomb input on this cell, is checked on any change since the bomb could be resolved after its cell
+		const UMapComponent* MapComponent = InOutSpec.MapComponent;
+		const ABombActor* BombActor = MapComponent ? MapComponent->GetOwner<ABombActor>() : nullptr;
+		if (BombActor)
+		{
+			FBombLatencyStats::OnBombVisible(NewCellIndex, BombActor->GetOwnerCharacterID());
+		}
+	}
+
+	if (PreviousCellIndex == NewCellIndex
+	    && PreviousActorType == NewActorType)
+	{
+		// Is changed by something else than its cell or type
+		return;
+	}
+
+	CountReplicatedActorType(PreviousCellIndex, PreviousActorType, -1);
+	CountReplicatedActorType(NewCellIndex, NewActorType, 1);
+	InOutSpec.MirroredCellIndex = NewCellIndex;
+	InOutSpec.MirroredActorType = NewActorType;
+
+	UpdateCellActorTypesByIndex(PreviousCellIndex);
+	if (NewCellIndex != PreviousCellIndex)
+	{
+		UpdateCellActorTypesByIndex(NewCellIndex);
+	}
+
+	if (bIsRemoved
+	    && GridCellsInternal.IsValidIndex(PreviousCellIndex)
+	    && AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame)
+	{
+		// Clients never destroy level actors themselves, so their cosmetics are queued once the removal is replicated
+		const UMapComponent* MapComponent = InOutSpec.MapComponent;
+		DispatchGridEvent(EGridReplayEventType::ActorDestroyed, GridCellsInternal[PreviousCellIndex], INDEX_NONE, static_cast<uint8>(PreviousActorType), MapComponent ? MapComponent->GetOwner() : nullptr);
+	}
+}
+
+// Recounts all replicated specs in the occupancy mirror on client
+void AGeneratedMap::RebuildReplicatedActorTypes()
+{
+	ReplicatedActorTypesNumInternal.Init(0, GridCellsInternal.Num() * ActorTypesNum);
+	for (FMapComponentSpec& SpecIt : MapComponentsInternal.Items)
+	{
+		SpecIt.MirroredCellIndex = GetCellIndex(SpecIt.Cell);
+		SpecIt.MirroredActorType = SpecIt.ActorType;
+		CountReplicatedActorType(SpecIt.MirroredCellIndex, SpecIt.MirroredActorType, 1);
+	}
+}
+
+// Adds given delta to the number of specs of given actor type on the cell in the occupancy mirror
+void AGeneratedMap::CountReplicatedActorType(int32 CellIndex, EActorType ActorType, int32 Delta)
+{
+	if (CellIndex == INDEX_NONE
+	    || ActorType == EAT::None)
+	{
+		return;
+	}
+
+	const int32 CountIndex = CellIndex * ActorTypesNum + FMath::FloorLog2(TO_FLAG(ActorType));
+	if (ReplicatedActorTypesNumInternal.IsValidIndex(CountIndex))
+	{
+		uint8& Count = ReplicatedActorTypesNumInternal[CountIndex];
+		Count = static_cast<uint8>(FMath::Clamp(Count + Delta, 0, static_cast<int32>(MAX_uint8)));
+	}
+}
+
+// Returns actor types of replicated specs located on the cell by the occupancy mirror
+int32 AGeneratedMap::GetReplicatedActorTypes(int32 CellIndex) const
+{
+	const int32 FirstCountIndex = CellIndex * ActorTypesNum;
+	if (CellIndex == INDEX_NONE
+	    || !ReplicatedActorTypesNumInternal.IsValidIndex(FirstCountIndex + ActorTypesNum - 1))
+	{
+		return TO_FLAG(EAT::None);
+	}
+
+	int32 ActorTypes = TO_FLAG(EAT::None);
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		if (ReplicatedActorTypesNumInternal[FirstCountIndex + TypeIndex])
+		{
+			ActorTypes |= 1 << TypeIndex;
+		}
+	}
+
+	return ActorTypes;
+}
+
+// Is called on client to apply replicated layout of walls to the occupancy and visuals
+void AGeneratedMap::OnRep_WallsBitmask()
+{
+	RebuildCellActorTypes();
+
+	UpdateInstancedWallsLayout();
+}
+
+// Draws walls by the replicated layout on client, if walls are drawn as instances
+void AGeneratedMap::UpdateInstancedWallsLayout()
+{
+	if (HasAuthority()
+	    || !InstancedMeshesComponentInternal
+	    || !UInstancedLevelMeshesComponent::IsInstancingEnabled())
+	{
+		return;
+	}
+
+	const ULevelActorDataAsset* WallDataAsset = UDataAssetsContainer::GetDataAssetByActorType(EAT::Wall);
+	const ULevelActorRow* WallRow = WallDataAsset ? WallDataAsset->GetRowByLevelType(LevelTypeInternal) : nullptr;
+	UStaticMesh* WallMesh = WallRow ? Cast<UStaticMesh>(WallRow->Mesh) : nullptr;
+
+	TArray<FTransform> WallTransforms;
+	for (int32 CellIndex = 0; CellIndex < GridCellsInternal.Num(); ++CellIndex)
+	{
+		if (GetClientActorTypes(CellIndex) & TO_FLAG(EAT::Wall))
+		{
+			WallTransforms.Emplace(GetLevelActorTransform(GridCellsInternal[CellIndex], EAT::Wall));
+		}
+	}
+
+	const ECollisionResponse WallCollisionResponse = WallDataAsset ? WallDataAsset->GetCollisionResponse() : ECR_Block;
+	InstancedMeshesComponentInternal->SetLayoutInstances(WallMesh, WallTransforms, WallCollisionResponse);
+}
+
 // Internal multicast function to set new size for generated map for all instances
 void AGeneratedMap::MulticastSetLevelSize_Implementation(const FIntPoint& LevelSize)
 {
+	bShrinkPoolsOnResizeInternal = HasAuthority();
+
 	FTransform CurrentTransform = GetActorTransform();
 	CurrentTransform.SetScale3D(FVector(LevelSize.X, LevelSize.Y, 1.f));
 	ConstructGeneratedMap(CurrentTransform);
@@ -1300,6 +4491,20 @@ void AGeneratedMap::PostLoad()
 		FEditorDelegates::OnMapOpened.AddWeakLambda(this, UpdateLevelType);
 	}
 }
+
+// Is called in editor on any data asset change to update only what depends on the changed data asset
+void AGeneratedMap::OnAnyDataAssetChanged(const UObject* ChangedDataAsset)
+{
+	if (const ULevelActorDataAsset* LevelActorDataAsset = Cast<ULevelActorDataAsset>(ChangedDataAsset))
+	{
+		// Only meshes of this actor type could be changed, so there is no need to regenerate the level
+		SwapLevelActorMeshes(TO_FLAG(LevelActorDataAsset->GetActorType()));
+		return;
+	}
+
+	// Chances, sizes or level streams could be changed, so regenerate the whole level
+	RerunConstructionScripts();
+}
 #endif	// WITH_EDITOR [GEditor]PostLoad();
 
 // The dragged version of the Add To Grid function to add the dragged actor on the level
@@ -1335,32 +4540,60 @@ void AGeneratedMap::AddToGridDragged(UMapComponent* AddedComponent)
 	const ULevel* OwnerLevel = ComponentOwner->GetLevel();
 	if (MainLevel != OwnerLevel)
 	{
-		const FTransform OwnerTransform = ComponentOwner->GetActorTransform();
+		// The whole selection is moved by one call, so other selected actors of the same frame are skipped
+		static uint64 LastMovedSelectionFrame = 0;
+		if (LastMovedSelectionFrame == GFrameCounter)
+		{
+			return;
+		}
+		LastMovedSelectionFrame = GFrameCounter;
+
+		// Copies keep labels of their originals, so transforms are matched by labels instead of relying on the order of the selection
+		TMap<FString, TArray<FTransform, TInlineAllocator<1>>> SelectedTransforms;
+		for (const AActor* SelectedActorIt : UEditorUtilityLibrary::GetSelectionSet())
+		{
+			if (SelectedActorIt)
+			{
+				SelectedTransforms.FindOrAdd(SelectedActorIt->GetActorLabel()).Emplace(SelectedActorIt->GetActorTransform());
+			}
+		}
 
 		UEditorLevelUtils::MoveSelectedActorsToLevel(MainLevel);
 
-		const TArray<AActor*> SelectedActors = UEditorUtilityLibrary::GetSelectionSet();
-		AActor* CopiedActor = SelectedActors.IsValidIndex(0) ? SelectedActors[0] : nullptr;
-		UMapComponent* CopiedComponent = CopiedActor ? UMapComponent::GetMapComponent(CopiedActor) : nullptr;
-		if (CopiedComponent
-		    && CopiedComponent != AddedComponent)
+		for (AActor* CopiedActor : UEditorUtilityLibrary::GetSelectionSet())
 		{
-			CopiedActor->SetActorTransform(OwnerTransform);
+			UMapComponent* CopiedComponent = CopiedActor ? UMapComponent::GetMapComponent(CopiedActor) : nullptr;
+			if (!CopiedComponent
+			    || CopiedComponent == AddedComponent)
+			{
+				continue;
+			}
+
+			// Actors with the same label are taken one by one, so each original transform is applied once
+			TArray<FTransform, TInlineAllocator<1>>* FoundTransforms = SelectedTransforms.Find(CopiedActor->GetActorLabel());
+			if (FoundTransforms
+			    && !FoundTransforms->IsEmpty())
+			{
+				CopiedActor->SetActorTransform((*FoundTransforms)[0]);
+				FoundTransforms->RemoveAt(0);
+			}
 			SetNearestCell(CopiedComponent);
 			AddToGrid(CopiedComponent);
 		}
 
-		return; // new actor will be copied, this one no need to add
+		return; // new actors will be copied, these ones no need to add
 	}
 
-	if (!DraggedCellsInternal.Contains(AddedComponent->GetCell()))
+	DraggedCellsInternal.FindOrAdd(AddedComponent->GetCell(), AddedComponent->GetActorType());
+
+	// Is constructed many times while dragged, but has to be registered only once
+	UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+	if (!PoolManager.ContainsObjectInPool(ComponentOwner))
 	{
-		DraggedCellsInternal.Emplace(AddedComponent->GetCell(), AddedComponent->GetActorType());
+		FPoolObjectData ObjectData(ComponentOwner);
+		ObjectData.bIsActive = true;
+		PoolManager.RegisterObjectInPool(ObjectData);
 	}
-
-	FPoolObjectData ObjectData(ComponentOwner);
-	ObjectData.bIsActive = true;
-	UPoolManagerSubsystem::Get().RegisterObjectInPool(ObjectData);
 #endif	//WITH_EDITOR [IsEditorNotPieWorld]
 }
 
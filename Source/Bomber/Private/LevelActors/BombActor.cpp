@@ -7,18 +7,31 @@
 #include "Components/MapComponent.h"
 #include "DataAssets/BombDataAsset.h"
 #include "DataAssets/DataAssetsContainer.h"
+#include "Engine/BombLatencyStats.h"
+#include "Engine/BomberNetStats.h"
+#include "Engine/BomberPerfBudget.h"
+#include "Engine/FrameSpikeCapture.h"
 #include "GameFramework/MyGameStateBase.h"
 #include "LevelActors/PlayerCharacter.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Structures/BombExplosion.h"
 #include "Structures/Cell.h"
-#include "Subsystems/SoundsSubsystem.h"
+#include "Subsystems/CosmeticEventsSubsystem.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "Subsystems/GridReplaySubsystem.h"
+#include "Subsystems/GridSimulationSubsystem.h"
+#include "Subsystems/MatchPerformanceSubsystem.h"
 #include "UtilityLibraries/CellsUtilsLibrary.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
-#include "NiagaraFunctionLibrary.h"
 #include "TimerManager.h"
 #include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/MeshComponent.h"
 #include "Engine/StaticMesh.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Serialization/BitWriter.h"
 //---
 #if WITH_EDITOR
 #include "MyUnrealEdEngine.h"
@@ -30,8 +43,8 @@
 // Sets default values
 ABombActor::ABombActor()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	// Is ticking on the server only while any character passes through this bomb, see ThisClass::Tick
+	PrimaryActorTick.bCanEverTick = true;
 	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	// Replicate an actor
@@ -47,17 +60,29 @@ ABombActor::ABombActor()
 	MapComponentInternal = CreateDefaultSubobject<UMapComponent>(TEXT("MapComponent"));
 }
 
+// Returns the map component of this actor, is created on its construction
+UMapComponent* ABombActor::GetOwnedMapComponent() const
+{
+	return MapComponentInternal;
+}
+
 // Initialize a bomb actor, could be called multiple times
 void ABombActor::ConstructBombActor()
 {
 	checkf(MapComponentInternal, TEXT("%s: 'MapComponentInternal' is null"), *FString(__FUNCTION__));
 	MapComponentInternal->OnOwnerWantsReconstruct.AddUniqueDynamic(this, &ThisClass::OnConstructionBombActor);
+	if (!MapComponentInternal->OnApplyCollisionResponses.IsBoundToObject(this))
+	{
+		MapComponentInternal->OnApplyCollisionResponses.AddUObject(this, &ThisClass::OnApplyCollisionResponses);
+	}
 	MapComponentInternal->ConstructOwnerActor();
 }
 
 // Returns cells that bombs is going to destroy
 FCells ABombActor::GetExplosionCells() const
 {
+	BOMBER_PERF_BUDGET_SCOPE(GetExplosionCells);
+
 	if (IsHidden()
 	    || FireRadiusInternal < MIN_FIRE_RADIUS
 	    || !MapComponentInternal)
@@ -65,11 +90,36 @@ FCells ABombActor::GetExplosionCells() const
 		return FCell::EmptyCells;
 	}
 
-	return UCellsUtilsLibrary::GetCellsAround(MapComponentInternal->GetCell(), EPathType::Explosion, FireRadiusInternal);
+	// Rays are cast by bit scans instead of walking each cell
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	return FBombExplosion(GeneratedMap, MapComponentInternal->GetCell(), FireRadiusInternal).GetExplosionCells(GeneratedMap);
+}
+
+// Returns the world time in seconds when this bomb is going to explode
+float ABombActor::GetDetonationTime() const
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return MAX_flt;
+	}
+
+	if (HasAuthority())
+	{
+		const UGridSimulationSubsystem* GridSimulationSubsystem = World->GetSubsystem<UGridSimulationSubsystem>();
+		return GridSimulationSubsystem ? GridSimulationSubsystem->GetBombDetonationTime(this) : MAX_flt;
+	}
+
+	if (!GetWorldTimerManager().IsTimerActive(TimerHandle_LifeSpanExpired))
+	{
+		return MAX_flt;
+	}
+
+	return World->GetTimeSeconds() + GetWorldTimerManager().GetTimerRemaining(TimerHandle_LifeSpanExpired);
 }
 
 // Sets the defaults of the bomb
-void ABombActor::InitBomb(const APlayerCharacter* Causer/* = nullptr*/)
+void ABombActor::InitBomb(const APlayerCharacter* Causer/* = nullptr*/, int32 FireRadiusOverride/* = -1*/)
 {
 	if (!HasAuthority())
 	{
@@ -95,29 +145,36 @@ void ABombActor::InitBomb(const APlayerCharacter* Causer/* = nullptr*/)
 		// Override mesh
 		checkf(MapComponentInternal, TEXT("ERROR: [%i] %s:\n'MapComponentInternal' is null!"), __LINE__, *FString(__FUNCTION__));
 		MapComponentInternal->SetCustomMeshAsset(BombMesh);
-
-		// Override material
-		BombMaterialInternal = BombMesh->GetMaterial(0);
 	}
 
+	// Use the default material of the mesh
+	BombColorIndexInternal = INDEX_NONE;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, BombColorIndexInternal, this);
+
 	if (PlayerType == ELevelType::None)
 	{
-		// Is bot character, set material for its default bomb with the same mesh
-		const int32 BombMaterialsNum = BombDataAsset.GetBombMaterialsNum();
+		// Is bot character, set color for its default bomb with the same mesh
+		const int32 BombColorsNum = BombDataAsset.GetBombColorsNum();
+		const int32 ColorsNum = BombColorsNum ? BombColorsNum : BombDataAsset.GetBombMaterialsNum();
 		if (CharacterID != INDEX_NONE // Is not debug character
-		    && BombMaterialsNum)      // As least one bomb material
+		    && ColorsNum)             // As least one bomb color
 		{
-			const int32 MaterialIndex = FMath::Abs(CharacterID) % BombMaterialsNum;
-			BombMaterialInternal = BombDataAsset.GetBombMaterial(MaterialIndex);
+			BombColorIndexInternal = static_cast<int8>(FMath::Abs(CharacterID) % FMath::Min<int32>(ColorsNum, MAX_int8));
 		}
 	}
 
 	ApplyMaterial();
 
-	FireRadiusInternal = InFireRadius;
+	OwnerCharacterIDInternal = CharacterID;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, OwnerCharacterIDInternal, this);
+
+	FireRadiusInternal = FireRadiusOverride >= MIN_FIRE_RADIUS ? FireRadiusOverride : InFireRadius;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, FireRadiusInternal, this);
 
 	UpdateCollisionResponseToAllPlayers();
 
+	UpdateDangerMap();
+
 	TryDisplayExplosionCells();
 }
 
@@ -161,7 +218,7 @@ void ABombActor::OnConstructionBombActor()
 	{
 		InitBomb();
 
-		UMyUnrealEdEngine::GOnAIUpdatedDelegate.Broadcast();
+		UMyUnrealEdEngine::MarkAIDirty();
 
 		if (MapComponentInternal->bShouldShowRenders)
 		{
@@ -187,7 +244,7 @@ void ABombActor::BeginPlay()
 	else if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
 		// This dragged bomb should start listening in-game state to set lifespan
-		MyGameState->OnGameStateChanged.AddDynamic(this, &ThisClass::OnGameStateChanged);
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 		// Handle current game state if initialized with delay
 		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -202,8 +259,12 @@ void ABombActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifeti
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ThisClass, FireRadiusInternal);
-	DOREPLIFETIME(ThisClass, BombMaterialInternal);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, FireRadiusInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, BombColorIndexInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, PassThroughPlayersInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, OwnerCharacterIDInternal, Params);
 }
 
 // Set the lifespan of this actor. When it expires the object will be destroyed
@@ -220,13 +281,43 @@ void ABombActor::SetLifeSpan(float InLifespan/* = DEFAULT_LIFESPAN*/)
 	InitialLifeSpan = InLifespan;
 
 	// Initialize a timer for the actors lifespan if there is one. Otherwise clear any existing timer
+	ClearLifeSpan();
 	if (InLifespan > 0.0f)
 	{
-		GetWorldTimerManager().SetTimer(TimerHandle_LifeSpanExpired, this, &AActor::LifeSpanExpired, InLifespan);
+		UGridSimulationSubsystem* GridSimulationSubsystem = HasAuthority() ? UGridSimulationSubsystem::GetGridSimulationSubsystem(this) : nullptr;
+		if (GridSimulationSubsystem)
+		{
+			// Server detonates the bomb in the simulation step to keep the order with other grid events
+			GridSimulationSubsystem->ScheduleBomb(this, GetWorld()->GetTimeSeconds() + InLifespan);
+		}
+		else
+		{
+			// Clients keep the timer to know the detonation time
+			GetWorldTimerManager().SetTimer(TimerHandle_LifeSpanExpired, this, &AActor::LifeSpanExpired, InLifespan);
+		}
 	}
-	else
+
+	UpdateDangerMap();
+}
+
+// Cancels the detonation of this bomb both in the timer and in the Grid Simulation Subsystem
+void ABombActor::ClearLifeSpan()
+{
+	GetWorldTimerManager().ClearTimer(TimerHandle_LifeSpanExpired);
+
+	if (UGridSimulationSubsystem* GridSimulationSubsystem = HasAuthority() ? UGridSimulationSubsystem::GetGridSimulationSubsystem(this) : nullptr)
+	{
+		GridSimulationSubsystem->UnscheduleBomb(this);
+	}
+}
+
+// Notifies the Generated Map to refresh explosion cells and detonation time of this bomb in its danger map
+void ABombActor::UpdateDangerMap()
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	if (AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr)
 	{
-		GetWorldTimerManager().ClearTimer(TimerHandle_LifeSpanExpired);
+		GeneratedMap->UpdateBombDanger(this);
 	}
 }
 
@@ -248,24 +339,50 @@ void ABombActor::SetActorHiddenInGame(bool bNewHidden)
 		ConstructBombActor();
 
 		SetLifeSpan();
-
-		// Binding to the event, that triggered when character end to overlaps the collision component
-		OnActorEndOverlap.AddUniqueDynamic(this, &ABombActor::OnBombEndOverlap);
 	}
 	else
 	{
-		// Bomb is removed from Generated Map, detonate it
-		DetonateBomb();
-
-		OnActorEndOverlap.RemoveDynamic(this, &ABombActor::OnBombEndOverlap);
+		// Bomb is removed from Generated Map, detonate it and cancel its fuse
+		if (UGridSimulationSubsystem* GridSimulationSubsystem = HasAuthority() ? UGridSimulationSubsystem::GetGridSimulationSubsystem(this) : nullptr)
+		{
+			GridSimulationSubsystem->DetonateBombNow(this);
+		}
+		else
+		{
+			DetonateBomb();
+		}
 	}
 
 	// Apply hidden flag
 	Super::SetActorHiddenInGame(bNewHidden);
+
+	if (bNewHidden)
+	{
+		// Unregister from the danger map if was not detonated
+		UpdateDangerMap();
+
+		// Return this bomb to its player by the counter of the player's own bombs
+		if (APlayerCharacter* ReturnCharacter = HasAuthority() ? ReturnCharacterInternal.Get() : nullptr)
+		{
+			ReturnCharacterInternal = nullptr;
+			ReturnCharacter->ReturnOwnBomb();
+		}
+
+		// Reset pass-through players for the next placing of this pooled bomb
+		SetPassThroughPlayers(0);
+	}
+}
+
+// Is not relevant for spectators of the grid stream, they rebuild the level by grid events
+bool ABombActor::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return IsLevelActorNetRelevantFor<Super>(*this, RealViewer, ViewTarget, SrcLocation);
 }
 
 void ABombActor::DetonateBomb()
 {
+	BOMBER_PERF_BUDGET_SCOPE(DetonateBomb);
+
 	if (!HasAuthority()
 	    || IsHidden()
 	    || FireRadiusInternal < MIN_FIRE_RADIUS
@@ -274,47 +391,143 @@ void ABombActor::DetonateBomb()
 		return;
 	}
 
-	const FCells ExplosionCells = GetExplosionCells();
+	TArray<FBombExplosion> Explosions;
+	FCells ExplosionCells;
+	TArray<ABombActor*> ChainBombs;
+	ResolveChainReaction(Explosions, ExplosionCells, ChainBombs);
 	if (ExplosionCells.IsEmpty())
 	{
 		// No cells to destroy
 		return;
 	}
 
-	MulticastDetonateBomb(ExplosionCells.Array());
+	// Reset Fire Radius of all bombs in the chain to avoid detonating them again once they are destroyed
+	for (ABombActor* ChainBombIt : ChainBombs)
+	{
+		ChainBombIt->FireRadiusInternal = INDEX_NONE;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, FireRadiusInternal, ChainBombIt);
+		ChainBombIt->ClearLifeSpan();
+		ChainBombIt->UpdateDangerMap();
+	}
+
+	AGeneratedMap::Get(this).DispatchGridEvent(EGridReplayEventType::BombDetonated, MapComponentInternal->GetCell(), ChainBombs.Num(), 0, this, Explosions.Num());
+
+	if (UMatchPerformanceSubsystem* MatchPerformanceSubsystem = UMatchPerformanceSubsystem::GetMatchPerformanceSubsystem(this))
+	{
+		MatchPerformanceSubsystem->AddExplosions(Explosions.Num());
+	}
+
+	FFrameSpikeCapture::OnChainReaction(this, ChainBombs.Num());
+
+	if (FBomberNetStats::IsEnabled())
+	{
+		// Measure the payload of the multicast the same way as explosions are written to the wire
+		FBitWriter ExplosionsWriter(0, /*bAllowResize*/true);
+		bool bSuccess = true;
+		for (FBombExplosion& ExplosionIt : Explosions)
+		{
+			ExplosionIt.NetSerialize(ExplosionsWriter, nullptr, bSuccess);
+		}
+		FBomberNetStats::Add(EBomberNetSource::MulticastDetonateBomb, ExplosionsWriter.GetNumBits());
+	}
+
+	MulticastDetonateBomb(Explosions);
+
+	// Destroy all actors from the union of cells at once
+	AGeneratedMap::Get(this).DestroyLevelActorsOnCells(ExplosionCells, this);
 }
 
-// Destroy bomb and burst explosion cells
-void ABombActor::MulticastDetonateBomb_Implementation(const TArray<FCell>& ExplosionCells)
+// Collects this bomb and all bombs that are triggered by its blast and by blasts of next triggered bombs
+void ABombActor::ResolveChainReaction(TArray<FBombExplosion>& OutExplosions, FCells& OutExplosionCells, TArray<ABombActor*>& OutChainBombs)
 {
-	// Reset Fire Radius to avoid destroying the bomb again
-	FireRadiusInternal = INDEX_NONE;
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	FMapComponents BombMapComponents;
+	GeneratedMap.GetMapComponents(BombMapComponents, TO_FLAG(EAT::Bomb));
 
-	// Spawn emitters
-	UNiagaraSystem* ExplosionParticle = UBombDataAsset::Get().GetExplosionVFX();
-	for (const FCell& Cell : ExplosionCells)
+	// Worklist of bombs, each of them is processed once, all rays are cast before anything is destroyed
+	OutChainBombs.Emplace(this);
+	for (int32 Index = 0; Index < OutChainBombs.Num(); ++Index)
 	{
-		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, ExplosionParticle, Cell.Location, GetActorRotation(), GetActorScale());
+		const ABombActor* ChainBombIt = OutChainBombs[Index];
+		if (ChainBombIt->IsHidden()
+		    || ChainBombIt->FireRadiusInternal < MIN_FIRE_RADIUS
+		    || !ChainBombIt->MapComponentInternal)
+		{
+			continue;
+		}
+
+		const FBombExplosion Explosion(GeneratedMap, ChainBombIt->MapComponentInternal->GetCell(), ChainBombIt->FireRadiusInternal);
+		if (!Explosion.IsValid())
+		{
+			continue;
+		}
+
+		const FCells BombCells = Explosion.GetExplosionCells(GeneratedMap);
+		OutExplosions.Emplace(Explosion);
+		OutExplosionCells.Append(BombCells);
+
+		for (const UMapComponent* MapComponentIt : BombMapComponents)
+		{
+			ABombActor* TriggeredBomb = MapComponentIt ? MapComponentIt->GetOwner<ABombActor>() : nullptr;
+			if (TriggeredBomb
+			    && !OutChainBombs.Contains(TriggeredBomb)
+			    && BombCells.Contains(MapComponentIt->GetCell()))
+			{
+				OutChainBombs.Emplace(TriggeredBomb);
+			}
+		}
 	}
+}
 
-	// Destroy all actors from array of cells
-	AGeneratedMap::Get().DestroyLevelActorsOnCells(FCells{ExplosionCells}, this);
+// Plays effects of all blasts in the chain reaction on each side
+void ABombActor::MulticastDetonateBomb_Implementation(const TArray<FBombExplosion>& Explosions)
+{
+	// Reset Fire Radius to avoid destroying the bomb again
+	FireRadiusInternal = INDEX_NONE;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, FireRadiusInternal, this);
+	UpdateDangerMap();
 
-	USoundsSubsystem::Get().PlayExplosionSFX();
+	// Effects and sounds are played by cosmetics once per frame, nobody sees or hears explosions on the dedicated server
+	QueueExplosionEvents(Explosions);
 
-	GetWorldTimerManager().ClearTimer(TimerHandle_LifeSpanExpired);
+	ClearLifeSpan();
 }
 
-// Triggers when character end to overlaps with this bomb.
-void ABombActor::OnBombEndOverlap(AActor* OverlappedActor, AActor* OtherActor)
+// Queues explosions of all specified blasts to be shown by cosmetics of this frame
+void ABombActor::QueueExplosionEvents(const TArray<FBombExplosion>& Explosions) const
 {
-	const bool bIsPlayerOverlap = Cast<APlayerCharacter>(OtherActor) != nullptr;
-	if (!bIsPlayerOverlap)
+	UCosmeticEventsSubsystem* CosmeticEventsSubsystem = UCosmeticEventsSubsystem::GetCosmeticEventsSubsystem(this);
+	if (!CosmeticEventsSubsystem)
 	{
 		return;
 	}
 
-	UpdateCollisionResponseToAllPlayers();
+	// Emitters are spawned once per exploded cell, or once per blast center, overlapped blasts of the chain are coalesced by the subsystem
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	const bool bPerCellEmission = UBombDataAsset::Get().GetExplosionVFXTier().bPerCellEmission;
+	for (const FBombExplosion& ExplosionIt : Explosions)
+	{
+		if (bPerCellEmission)
+		{
+			for (const FCell& CellIt : ExplosionIt.GetExplosionCells(GeneratedMap))
+			{
+				CosmeticEventsSubsystem->AddEvent(ECosmeticEventType::Explosion, CellIt, EAT::Bomb);
+			}
+		}
+		else if (ExplosionIt.IsValid())
+		{
+			CosmeticEventsSubsystem->AddEvent(ECosmeticEventType::Explosion, GeneratedMap.GetCellByIndex(ExplosionIt.OriginIndex), EAT::Bomb);
+		}
+	}
+}
+
+// Blocks characters that left this bomb
+void ABombActor::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Characters that left the bomb are only removed, nobody is added back
+	SetPassThroughPlayers(PassThroughPlayersInternal & GetOverlappingPlayersBitmask());
 }
 
 // Listen by dragged bombs to handle game resetting
@@ -328,116 +541,179 @@ void ABombActor::OnGameStateChanged(ECurrentGameState CurrentGameState)
 	}
 }
 
-// Sets actual collision responses to all players for this bomb
+// Queries players that overlap this bomb and lets them pass through it
 void ABombActor::UpdateCollisionResponseToAllPlayers()
 {
 	checkf(MapComponentInternal, TEXT("%s: 'MapComponentInternal' is null"), *FString(__FUNCTION__));
-	FCollisionResponseContainer CollisionResponses = MapComponentInternal->GetCollisionResponses();
 
-	TArray<AActor*> OverlappingPlayers;
-	GetOverlappingPlayers(OverlappingPlayers);
-	if (!OverlappingPlayers.Num())
+	SetPassThroughPlayers(GetOverlappingPlayersBitmask());
+
+	// Responses could be not applied yet, e.g. on construction
+	MapComponentInternal->ApplyCollisionResponse();
+}
+
+// Sets the bitmask of character IDs that pass through this bomb
+void ABombActor::SetPassThroughPlayers(int32 NewPassThroughPlayers)
+{
+	static_assert(MAX_PLAYERS_NUM <= sizeof(PassThroughPlayersInternal) * 8, "'PassThroughPlayersInternal' has not enough bits for all characters");
+	const uint16 PassThroughPlayers = static_cast<uint16>(NewPassThroughPlayers);
+	if (!HasAuthority()
+	    || PassThroughPlayers == PassThroughPlayersInternal)
 	{
-		// There are no characters on the bomb, block all
-		MakeCollisionResponseToAllPlayers(/*out*/CollisionResponses, ECR_Block);
-		OnActorEndOverlap.RemoveDynamic(this, &ABombActor::OnBombEndOverlap);
+		return;
 	}
-	else
+
+	PassThroughPlayersInternal = PassThroughPlayers;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, PassThroughPlayersInternal, this);
+
+	// There are no characters on the bomb, nothing to check anymore
+	SetActorTickEnabled(PassThroughPlayersInternal != 0);
+
+	ApplyPassThroughPlayers();
+}
+
+// Lets characters from the pass-through bitmask ignore this bomb on moving
+void ABombActor::ApplyPassThroughPlayers()
+{
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMapByContext(this) : nullptr;
+	if (!GeneratedMap)
 	{
-		// Add to bitmask overlapping players
-		int32 Bitmask = 0;
-		for (const AActor* OverlappingPlayerIt : OverlappingPlayers)
+		return;
+	}
+
+	FMapComponents PlayerComponents;
+	GeneratedMap->GetMapComponents(PlayerComponents, TO_FLAG(EAT::Player));
+	for (const UMapComponent* PlayerComponentIt : PlayerComponents)
+	{
+		const APlayerCharacter* PlayerCharacter = PlayerComponentIt ? PlayerComponentIt->GetOwner<APlayerCharacter>() : nullptr;
+		UCapsuleComponent* CapsuleComponent = PlayerCharacter ? PlayerCharacter->GetCapsuleComponent() : nullptr;
+		const int32 CharacterID = PlayerCharacter ? PlayerCharacter->GetCharacterID() : INDEX_NONE;
+		if (!CapsuleComponent
+		    || CharacterID < 0
+		    || CharacterID >= MAX_PLAYERS_NUM)
 		{
-			if (const APlayerCharacter* PlayerCharacter = Cast<APlayerCharacter>(OverlappingPlayerIt))
-			{
-				Bitmask |= 1 << PlayerCharacter->GetCharacterID();
-			}
+			continue;
 		}
 
-		// Set overlap response for overlapping players, block others
-		CollisionResponses = MapComponentInternal->GetCollisionResponses();
-		constexpr ECollisionResponse BitOnResponse = ECR_Overlap;
-		constexpr ECollisionResponse BitOffResponse = ECR_Block;
-		MakeCollisionResponseToPlayersInBitmask(/*out*/CollisionResponses, Bitmask, BitOnResponse, BitOffResponse);
+		const bool bShouldIgnore = (PassThroughPlayersInternal & 1 << CharacterID) != 0;
+		CapsuleComponent->IgnoreActorWhenMoving(this, bShouldIgnore);
 	}
-
-	MapComponentInternal->SetCollisionResponses(CollisionResponses);
 }
 
-// Takes your container and returns is with new specified response for player by its specified ID
-void ABombActor::MakeCollisionResponseToPlayerByID(FCollisionResponseContainer& InOutCollisionResponses, int32 CharacterID, ECollisionResponse NewResponse)
+// Blocks the player channel right before collision responses are applied
+void ABombActor::OnApplyCollisionResponses(FCollisionResponseContainer& InOutResponses) const
 {
-	if (CharacterID < 0)
+	if (InOutResponses == ECR_Ignore)
 	{
+		// The bomb is deactivated, keep ignoring everything
 		return;
 	}
 
-	ECollisionChannel CollisionChannel = ECC_WorldDynamic;
-	switch (CharacterID)
-	{
-		case 0:
-			CollisionChannel = ECC_Player0;
-			break;
-		case 1:
-			CollisionChannel = ECC_Player1;
-			break;
-		case 2:
-			CollisionChannel = ECC_Player2;
-			break;
-		case 3:
-			CollisionChannel = ECC_Player3;
-			break;
-		default:
-			break;
-	}
+	// Characters from the pass-through bitmask ignore this bomb on moving, so all of them are blocked here
+	MakeCollisionResponseToAllPlayers(/*out*/InOutResponses, ECR_Block);
+}
 
-	InOutCollisionResponses.SetResponse(CollisionChannel, NewResponse);
+// Is called on client to update characters by the new pass-through bitmask
+void ABombActor::OnRep_PassThroughPlayers()
+{
+	ApplyPassThroughPlayers();
 }
 
 // Takes your container and returns new specified response for all players
 void ABombActor::MakeCollisionResponseToAllPlayers(FCollisionResponseContainer& InOutCollisionResponses, ECollisionResponse NewResponse)
 {
-	static constexpr int32 BitsOffOnly = 0;
-	constexpr ECollisionResponse BitOnResponse = ECR_MAX;
-	MakeCollisionResponseToPlayersInBitmask(InOutCollisionResponses, BitsOffOnly, BitOnResponse, NewResponse);
+	InOutCollisionResponses.SetResponse(ECC_Player, NewResponse);
 }
 
-// Takes your container and returns new specified response for those players who match their ID in specified bitmask
-void ABombActor::MakeCollisionResponseToPlayersInBitmask(FCollisionResponseContainer& InOutCollisionResponses, int32 Bitmask, ECollisionResponse BitOnResponse, ECollisionResponse BitOffResponse)
+// Returns the bitmask of character IDs whose capsules overlap this bomb
+int32 ABombActor::GetOverlappingPlayersBitmask() const
 {
-	static constexpr int32 MaxPlayerID = 3;
-	for (int32 CharacterID = 0; CharacterID <= MaxPlayerID; ++CharacterID)
+	const UBoxComponent* BombCollisionComponent = MapComponentInternal ? MapComponentInternal->GetBoxCollisionComponent() : nullptr;
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMapByContext(this) : nullptr;
+	if (!BombCollisionComponent
+	    || !GeneratedMap)
 	{
-		const bool bIsBitOn = ((1 << CharacterID) & Bitmask) != 0;
-		const ECollisionResponse Response = bIsBitOn ? BitOnResponse : BitOffResponse;
-		MakeCollisionResponseToPlayerByID(InOutCollisionResponses, CharacterID, Response);
+		return 0;
 	}
-}
 
-// Returns all players overlapping with this bomb
-void ABombActor::GetOverlappingPlayers(TArray<AActor*>& OutPlayers) const
-{
-	const UBoxComponent* BombCollisionComponent = MapComponentInternal ? MapComponentInternal->GetBoxCollisionComponent() : nullptr;
-	if (BombCollisionComponent)
+	const FTransform& BombTransform = BombCollisionComponent->GetComponentTransform();
+	const FVector BombExtent = BombCollisionComponent->GetScaledBoxExtent();
+
+	FMapComponents PlayerComponents;
+	GeneratedMap->GetMapComponents(PlayerComponents, TO_FLAG(EAT::Player));
+
+	int32 Bitmask = 0;
+	for (const UMapComponent* PlayerComponentIt : PlayerComponents)
 	{
-		BombCollisionComponent->GetOverlappingActors(OutPlayers, UDataAssetsContainer::GetActorClassByType(EAT::Player));
+		const APlayerCharacter* PlayerCharacter = PlayerComponentIt ? PlayerComponentIt->GetOwner<APlayerCharacter>() : nullptr;
+		const UCapsuleComponent* CapsuleComponent = PlayerCharacter ? PlayerCharacter->GetCapsuleComponent() : nullptr;
+		const int32 CharacterID = PlayerCharacter ? PlayerCharacter->GetCharacterID() : INDEX_NONE;
+		if (!CapsuleComponent
+		    || CharacterID < 0
+		    || CharacterID >= MAX_PLAYERS_NUM)
+		{
+			continue;
+		}
+
+		// Characters never leave the plane of the level, so the box expanded by the capsule radius is tested in 2D
+		const FVector LocalLocation = BombTransform.InverseTransformPositionNoScale(CapsuleComponent->GetComponentLocation());
+		const float CapsuleRadius = CapsuleComponent->GetScaledCapsuleRadius();
+		if (FMath::Abs(LocalLocation.X) < BombExtent.X + CapsuleRadius
+		    && FMath::Abs(LocalLocation.Y) < BombExtent.Y + CapsuleRadius)
+		{
+			Bitmask |= 1 << CharacterID;
+		}
 	}
+
+	return Bitmask;
 }
 
 // Updates current material for this bomb actor
 void ABombActor::ApplyMaterial()
 {
-	if (!BombMaterialInternal
-	    || !MapComponentInternal)
+	UMeshComponent* MeshComponent = MapComponentInternal ? MapComponentInternal->GetMeshComponent() : nullptr;
+	if (!MeshComponent
+	    || UUtilsLibrary::IsDedicatedServer()) // Materials are cosmetics, the color index is still replicated
+	{
+		return;
+	}
+
+	const UBombDataAsset& BombDataAsset = UBombDataAsset::Get();
+	const bool bHasColor = BombColorIndexInternal != INDEX_NONE;
+	if (bHasColor
+	    && !BombDataAsset.GetBombColorsNum())
 	{
+		// Per-bomb material if colors are not set
+		MapComponentInternal->SetMaterial(BombDataAsset.GetBombMaterial(BombColorIndexInternal));
 		return;
 	}
 
-	MapComponentInternal->SetMaterial(BombMaterialInternal);
+	// All bombs share the material of their mesh, so they could be batched, the override is cleared since bombs are pooled
+	MeshComponent->SetMaterial(0, nullptr);
+
+	if (bHasColor)
+	{
+		const FLinearColor BombColor = BombDataAsset.GetBombColor(BombColorIndexInternal);
+		MeshComponent->SetCustomPrimitiveDataVector4(BombDataAsset.GetBombColorCustomDataIndex(), FVector4(BombColor));
+	}
 }
 
-// Is called on client to respond on changes in material of the bomb
-void ABombActor::OnRep_BombMaterial()
+// Is called on client to respond on changes in color of the bomb
+void ABombActor::OnRep_BombColorIndex()
 {
 	ApplyMaterial();
 }
+
+// Is called on client when the owner of this bomb is replicated to end the round trip of the local bomb input
+void ABombActor::OnRep_OwnerCharacterID()
+{
+	if (FBombLatencyStats::IsEnabled()
+	    && MapComponentInternal
+	    && MapComponentInternal->GetCell().IsValid())
+	{
+		// Otherwise the round trip is ended once the cell of this bomb is replicated, @see AGeneratedMap::MirrorReplicatedSpec
+		FBombLatencyStats::OnBombVisible(AGeneratedMap::Get(this).GetCellIndex(MapComponentInternal->GetCell()), OwnerCharacterIDInternal);
+	}
+}
@@ -33,6 +33,12 @@ ABoxActor::ABoxActor()
 	MapComponentInternal = CreateDefaultSubobject<UMapComponent>(TEXT("MapComponent"));
 }
 
+// Returns the map component of this actor, is created on its construction
+UMapComponent* ABoxActor::GetOwnedMapComponent() const
+{
+	return MapComponentInternal;
+}
+
 // Initialize a box actor, could be called multiple times
 void ABoxActor::ConstructBoxActor()
 {
@@ -75,7 +81,7 @@ void ABoxActor::BeginPlay()
 	// Listen states
 	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
-		MyGameState->OnGameStateChanged.AddDynamic(this, &ThisClass::OnGameStateChanged);
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 		// Handle current game state if initialized with delay
 		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -96,6 +102,12 @@ void ABoxActor::SetActorHiddenInGame(bool bNewHidden)
 	}
 }
 
+// Is not relevant for spectators of the grid stream, they rebuild the level by grid events
+bool ABoxActor::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return IsLevelActorNetRelevantFor<Super>(*this, RealViewer, ViewTarget, SrcLocation);
+}
+
 // Called when owned map component is destroyed on the Generated Map
 void ABoxActor::OnDeactivatedMapComponent(UMapComponent* MapComponent, UObject* DestroyCauser)
 {
@@ -115,11 +127,13 @@ void ABoxActor::TrySpawnItem()
 		return;
 	}
 
-	// Spawn item with the chance
+	// Spawn item with the chance, is seeded by the cell to be reproduced by the same generation seed
 	static constexpr int32 Max = 100;
-	if (FMath::RandHelper(Max) < SpawnItemChanceInternal)
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	const FCell& Cell = MapComponentInternal->GetCell();
+	if (GeneratedMap.GetCellRandomStream(Cell, TO_FLAG(EAT::Box)).RandHelper(Max) < SpawnItemChanceInternal)
 	{
-		AGeneratedMap::Get().SpawnActorByType(EAT::Item, MapComponentInternal->GetCell());
+		GeneratedMap.SpawnActorByType(EAT::Item, Cell);
 	}
 }
 
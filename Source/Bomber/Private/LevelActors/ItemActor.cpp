@@ -5,12 +5,16 @@
 #include "Bomber.h"
 #include "GeneratedMap.h"
 #include "Components/MapComponent.h"
-#include "DataAssets/DataAssetsContainer.h"
 #include "DataAssets/ItemDataAsset.h"
-#include "Subsystems/SoundsSubsystem.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "LevelActors/PlayerCharacter.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "Subsystems/GridReplaySubsystem.h"
+#include "Subsystems/GridSpectatorSubsystem.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(ItemActor)
 
@@ -34,11 +38,21 @@ AItemActor::AItemActor()
 	MapComponentInternal = CreateDefaultSubobject<UMapComponent>(TEXT("MapComponent"));
 }
 
+// Returns the map component of this actor, is created on its construction
+UMapComponent* AItemActor::GetOwnedMapComponent() const
+{
+	return MapComponentInternal;
+}
+
 // Initialize an item actor, could be called multiple times
 void AItemActor::ConstructItemActor()
 {
 	checkf(MapComponentInternal, TEXT("%s: 'MapComponentInternal' is null"), *FString(__FUNCTION__));
 	MapComponentInternal->OnOwnerWantsReconstruct.AddUniqueDynamic(this, &ThisClass::OnConstructionItemActor);
+	if (!MapComponentInternal->OnApplyCollisionResponses.IsBoundToObject(this))
+	{
+		MapComponentInternal->OnApplyCollisionResponses.AddUObject(this, &ThisClass::OnApplyCollisionResponses);
+	}
 	MapComponentInternal->ConstructOwnerActor();
 }
 
@@ -59,11 +73,24 @@ void AItemActor::OnConstructionItemActor()
 		return;
 	}
 
-	// Rand the item type if not set yet
+	// Rand the item type if not set yet, is seeded by the cell to be reproduced by the same generation seed
 	if (ItemTypeInternal == EItemType::None)
 	{
-		const int32 RandomIndex = FMath::RandRange(EIT_FIRST_FLAG, EIT_LAST_FLAG);
+		const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+		const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+		const int32 RandomIndex = GeneratedMap
+			                          ? GeneratedMap->GetCellRandomStream(MapComponentInternal->GetCell(), TO_FLAG(EAT::Item)).RandRange(EIT_FIRST_FLAG, EIT_LAST_FLAG)
+			                          : FMath::RandRange(EIT_FIRST_FLAG, EIT_LAST_FLAG);
 		ItemTypeInternal = static_cast<EItemType>(RandomIndex);
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ItemTypeInternal, this);
+
+		// Spectators know only actor types of cells, so the type of the item that appeared during the match is sent separately
+		UGridSpectatorSubsystem* GridSpectatorSubsystem = HasAuthority() ? UGridSpectatorSubsystem::GetGridSpectatorSubsystem(this) : nullptr;
+		if (GridSpectatorSubsystem
+		    && AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame)
+		{
+			GridSpectatorSubsystem->AddEvent(EGridReplayEventType::ItemSpawned, MapComponentInternal->GetCell(), INDEX_NONE, static_cast<uint8>(ItemTypeInternal));
+		}
 	}
 
 	// Override mesh
@@ -73,14 +100,6 @@ void AItemActor::OnConstructionItemActor()
 	}
 }
 
-// Called when the game starts or when spawned
-void AItemActor::BeginPlay()
-{
-	Super::BeginPlay();
-
-	OnActorBeginOverlap.AddDynamic(this, &AItemActor::OnItemBeginOverlap);
-}
-
 // Sets the actor to be hidden in the game. Alternatively used to avoid destroying
 void AItemActor::SetActorHiddenInGame(bool bNewHidden)
 {
@@ -97,25 +116,65 @@ void AItemActor::SetActorHiddenInGame(bool bNewHidden)
 	ResetItemType();
 }
 
+// Is not relevant for spectators of the grid stream, they rebuild the level by grid events
+bool AItemActor::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return IsLevelActorNetRelevantFor<Super>(*this, RealViewer, ViewTarget, SrcLocation);
+}
+
 // Returns properties that are replicated for the lifetime of the actor channel
 void AItemActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ThisClass, ItemTypeInternal);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, ItemTypeInternal, Params);
+}
+
+// Makes the item ignore all collisions, since it is picked up by the grid when the player steps on its cell
+void AItemActor::OnApplyCollisionResponses(FCollisionResponseContainer& InOutResponses) const
+{
+	InOutResponses.SetAllChannels(ECR_Ignore);
+}
+
+// Applies this item to given player and removes it from the level
+void AItemActor::PickUp(APlayerCharacter& Player)
+{
+	if (!HasAuthority()
+	    || IsHidden())
+	{
+		return;
+	}
+
+	Player.PickUpItem(ItemTypeInternal);
+
+	AGeneratedMap::Get(this).DispatchGridEvent(EGridReplayEventType::ItemPicked, MapComponentInternal->GetCell(), Player.GetCharacterID(), static_cast<uint8>(ItemTypeInternal), &Player);
+
+	// Destroy itself on picking up
+	AGeneratedMap::Get(this).DestroyLevelActor(MapComponentInternal, &Player);
 }
 
-// Triggers when this item starts overlap a player character to destroy itself
-void AItemActor::OnItemBeginOverlap(AActor* OverlappedActor, AActor* OtherActor)
+// Calls to uninitialize item type
+EItemType AItemActor::ResetItemType()
 {
-	if (!OtherActor
-	    || !OtherActor->IsA(UDataAssetsContainer::GetActorClassByType(EAT::Player)))
+	ItemTypeInternal = EItemType::None;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ItemTypeInternal, this);
+	return ItemTypeInternal;
+}
+
+// Overrides the random item type and updates the mesh
+void AItemActor::SetItemType(EItemType NewItemType)
+{
+	if (!HasAuthority()
+	    || NewItemType == EItemType::None)
 	{
 		return;
 	}
 
-	USoundsSubsystem::Get().PlayItemPickUpSFX();
+	ItemTypeInternal = NewItemType;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ItemTypeInternal, this);
 
-	// Destroy itself on overlapping
-	AGeneratedMap::Get().DestroyLevelActor(MapComponentInternal, OtherActor);
+	// The type is set, so only the mesh is updated
+	ConstructItemActor();
 }
@@ -4,26 +4,44 @@
 //---
 #include "Bomber.h"
 #include "GeneratedMap.h"
+#include "Components/GridMovementComponent.h"
 #include "Components/MapComponent.h"
 #include "Components/MySkeletalMeshComponent.h"
 #include "Controllers/MyAIController.h"
 #include "Controllers/MyPlayerController.h"
+#include "DataAssets/BombDataAsset.h"
 #include "DataAssets/ItemDataAsset.h"
 #include "DataAssets/PlayerDataAsset.h"
+#include "DataAssets/UIDataAsset.h"
+#include "Engine/BombLatencyStats.h"
+#include "Engine/BomberNetStats.h"
 #include "GameFramework/MyGameStateBase.h"
 #include "GameFramework/MyPlayerState.h"
 #include "LevelActors/BombActor.h"
 #include "LevelActors/ItemActor.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/AISimulationSubsystem.h"
+#include "Subsystems/GridReplaySubsystem.h"
+#include "Subsystems/GridSimulationSubsystem.h"
+#include "Subsystems/LoadTestSubsystem.h"
+#include "Subsystems/SoakTestSubsystem.h"
 #include "UtilityLibraries/CellsUtilsLibrary.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
 #include "InputActionValue.h"
 #include "Animation/AnimInstance.h"
+#include "Blueprint/UserWidget.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
+#include "Components/TextRenderComponent.h"
+#include "Components/WidgetComponent.h"
+#include "Engine/SkeletalMesh.h"
 #include "Engine/World.h"
+#include "TimerManager.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 //---
 #if WITH_EDITOR
 #include "MyEditorUtilsLibraries/EditorUtilsLibrary.h"
@@ -36,9 +54,12 @@ const FPowerUp FPowerUp::DefaultData = FPowerUp();
 
 // Sets default values
 APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer)
-	: Super(ObjectInitializer.SetDefaultSubobjectClass<UMySkeletalMeshComponent>(MeshComponentName)) // Init UMySkeletalMeshComponent instead of USkeletalMeshComponent
+	: Super(ObjectInitializer
+	        .SetDefaultSubobjectClass<UMySkeletalMeshComponent>(MeshComponentName) // Init UMySkeletalMeshComponent instead of USkeletalMeshComponent
+	        .SetDefaultSubobjectClass<UGridMovementComponent>(CharacterMovementComponentName)) // Init grid-locked movement instead of free 3D movement
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// Cell of the player is tracked by movement updates, see ThisClass::OnCharacterMovementUpdatedCell
+	PrimaryActorTick.bCanEverTick = false;
 	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	// Replicate an actor
@@ -65,6 +86,9 @@ APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer)
 		SkeletalMeshComponent->SetRelativeRotation_Direct(MeshRelativeRotation);
 
 		SkeletalMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+		// Is overridden by the character to always tick the pose, while players do not need bones when they are not rendered
+		SkeletalMeshComponent->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
 	}
 
 	// Initialize the nameplate mesh component
@@ -76,6 +100,15 @@ APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer)
 	NameplateMeshInternal->SetRelativeScale3D_Direct(NameplateRelativeScale);
 	NameplateMeshInternal->SetUsingAbsoluteRotation(true);
 
+	// Initialize the nickname text, its settings are applied on begin play from the player data asset
+	NicknameTextInternal = CreateDefaultSubobject<UTextRenderComponent>(TEXT("NicknameTextComponent"));
+	NicknameTextInternal->SetupAttachment(NameplateMeshInternal);
+	NicknameTextInternal->SetUsingAbsoluteScale(true); // Is not stretched by the nameplate scale
+	NicknameTextInternal->SetHorizontalAlignment(EHTA_Center);
+	NicknameTextInternal->SetVerticalAlignment(EVRTA_TextCenter);
+	NicknameTextInternal->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	NicknameTextInternal->SetCastShadow(false);
+
 	if (UCharacterMovementComponent* MovementComponent = GetCharacterMovement())
 	{
 		// Rotate player by movement
@@ -88,6 +121,12 @@ APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer)
 	}
 }
 
+// Returns the map component of this actor, is created on its construction
+UMapComponent* APlayerCharacter::GetOwnedMapComponent() const
+{
+	return MapComponentInternal;
+}
+
 // Initialize a player actor, could be called multiple times
 void APlayerCharacter::ConstructPlayerCharacter()
 {
@@ -96,8 +135,22 @@ void APlayerCharacter::ConstructPlayerCharacter()
 	MapComponentInternal->ConstructOwnerActor();
 }
 
-// Spawns bomb on character position
+// Spawns bomb on character position without the client prediction
 void APlayerCharacter::ServerSpawnBomb_Implementation()
+{
+	BOMBER_NET_STAT(ServerSpawnBomb, 0);
+	SpawnBombOnServer(INDEX_NONE);
+}
+
+// Spawns bomb predicted by the owning client on character position
+void APlayerCharacter::ServerSpawnPredictedBomb_Implementation(uint8 PredictionId)
+{
+	BOMBER_NET_STAT(ServerSpawnBomb, sizeof(PredictionId) * 8);
+	SpawnBombOnServer(PredictionId);
+}
+
+// Spawns bomb on character position on the server
+void APlayerCharacter::SpawnBombOnServer(int32 PredictionId)
 {
 #if WITH_EDITOR	 // [IsEditorNotPieWorld]
 	if (FEditorUtilsLibrary::IsEditorNotPieWorld())
@@ -107,18 +160,20 @@ void APlayerCharacter::ServerSpawnBomb_Implementation()
 	}
 #endif	//WITH_EDITOR [IsEditorNotPieWorld]
 
-	const AController* OwnedController = GetController();
-	if (!MapComponentInternal                     // The Map Component is not valid or transient
-	    || PowerupsInternal.FireN <= 0            // Null length of explosion
-	    || PowerupsInternal.BombN <= 0            // No more bombs
-	    || !OwnedController                       // controller is not valid
-	    || OwnedController->IsMoveInputIgnored()) // controller is blocked
+	if (!CanSpawnBomb())
 	{
+		if (PredictionId != INDEX_NONE)
+		{
+			// Let the client roll back its predicted bomb
+			ClientRejectSpawnBomb(static_cast<uint8>(PredictionId));
+		}
 		return;
 	}
 
+	const FCell& Cell = MapComponentInternal->GetCell();
 	const TWeakObjectPtr<ThisClass> WeakThis = this;
-	const TFunction<void(AActor*)> OnBombSpawned = [WeakThis](AActor* SpawnedActor)
+	const double ReceiptTime = FPlatformTime::Seconds();
+	const TFunction<void(AActor*)> OnBombSpawned = [WeakThis, ReceiptTime, Cell](AActor* SpawnedActor)
 	{
 		APlayerCharacter* PlayerCharacter = WeakThis.Get();
 		if (!PlayerCharacter)
@@ -130,21 +185,218 @@ void APlayerCharacter::ServerSpawnBomb_Implementation()
 		UMapComponent* MapComponent = UMapComponent::GetMapComponent(BombActor);
 		checkf(MapComponent, TEXT("ERROR: [%i] %s:\n'MapComponent' is null!"), __LINE__, *FString(__FUNCTION__));
 
+		// The bomb occupies its cell now, so next requests are validated by the grid
+		const int32 PendingIndex = PlayerCharacter->PendingBombSpawnsInternal.IndexOfByPredicate([&Cell](const FPendingBombSpawn& It) { return It.Cell == Cell; });
+		if (PendingIndex != INDEX_NONE)
+		{
+			PlayerCharacter->PendingBombSpawnsInternal.RemoveAtSwap(PendingIndex);
+		}
+
 		// Updating explosion cells
 		PlayerCharacter->PowerupsInternal.BombN--;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, PowerupsInternal, PlayerCharacter);
 
 		// Init Bomb
 		BombActor->InitBomb(PlayerCharacter);
 
-		// Start listening this bomb
-		if (!MapComponent->OnDeactivatedMapComponent.IsAlreadyBound(PlayerCharacter, &ThisClass::OnBombDestroyed))
+		AGeneratedMap::Get(PlayerCharacter).DispatchGridEvent(EGridReplayEventType::BombPlaced, MapComponent->GetCell(), PlayerCharacter->GetCharacterID(), 0, BombActor, PlayerCharacter->GetPowerups().FireN);
+
+		PlayerCharacter->AddOwnBomb(*BombActor);
+
+		if (FBombLatencyStats::IsEnabled())
 		{
-			MapComponent->OnDeactivatedMapComponent.AddDynamic(PlayerCharacter, &ThisClass::OnBombDestroyed);
+			FBombLatencyStats::AddSample(EBombLatencyStage::ReceiptToSpawn, FPlatformTime::Seconds() - ReceiptTime);
+
+			// The host sees its bomb right away, remote clients see it once it's replicated
+			if (PlayerCharacter->IsLocallyControlled())
+			{
+				FBombLatencyStats::OnBombVisible(AGeneratedMap::Get(PlayerCharacter).GetCellIndex(MapComponent->GetCell()), PlayerCharacter->GetCharacterID());
+			}
 		}
 	};
 
-	// Spawn bomb
-	AGeneratedMap::Get().SpawnActorByType(EAT::Bomb, MapComponentInternal->GetCell(), OnBombSpawned);
+	// Spawn bomb, duplicated requests are rejected until it is spawned, expired requests are forgotten
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	PendingBombSpawnsInternal.RemoveAllSwap([CurrentTime](const FPendingBombSpawn& It) { return CurrentTime - It.RequestTime >= PendingBombTimeout; });
+	PendingBombSpawnsInternal.Add({Cell, CurrentTime});
+	AGeneratedMap::Get(this).SpawnActorByType(EAT::Bomb, Cell, OnBombSpawned);
+}
+
+// Spawns bomb on character position, is predicted on the owning client
+void APlayerCharacter::SpawnBomb()
+{
+	// Is bound to the input action by the player controller, so it's where the input latency starts
+	const bool bMeasureLatency = FBombLatencyStats::IsEnabled() && MapComponentInternal;
+	const int32 InputCellIndex = bMeasureLatency ? AGeneratedMap::Get(this).GetCellIndex(MapComponentInternal->GetCell()) : INDEX_NONE;
+	if (bMeasureLatency)
+	{
+		FBombLatencyStats::OnInput(InputCellIndex, CharacterIDInternal);
+	}
+	const double InputTime = FPlatformTime::Seconds();
+
+	if (HasAuthority())
+	{
+		// Host and bots are validated right away, nothing to predict
+		if (bMeasureLatency)
+		{
+			FBombLatencyStats::AddSample(EBombLatencyStage::InputToSend, FPlatformTime::Seconds() - InputTime);
+		}
+		ServerSpawnBomb();
+		return;
+	}
+
+	if (!IsLocallyControlled()
+	    || !CanSpawnBomb())
+	{
+		// Nothing is predicted, so the server would reject the request anyway
+		return;
+	}
+
+	const uint8 PredictionId = PredictBomb(MapComponentInternal->GetCell());
+
+	if (bMeasureLatency)
+	{
+		FBombLatencyStats::AddSample(EBombLatencyStage::InputToPrediction, FPlatformTime::Seconds() - InputTime);
+		FBombLatencyStats::AddSample(EBombLatencyStage::InputToSend, FPlatformTime::Seconds() - InputTime);
+	}
+
+	ServerSpawnPredictedBomb(PredictionId);
+}
+
+// Returns true if this character is able to spawn the bomb on its current cell
+bool APlayerCharacter::CanSpawnBomb() const
+{
+	// Bombs that are not confirmed yet are already taken on client, the same is for bombs that are not spawned yet on the server
+	const int32 AvailableBombsNum = PowerupsInternal.BombN - PredictedBombsInternal.Num() - GetPendingBombSpawnsNum();
+
+	const AController* OwnedController = GetController();
+	return MapComponentInternal                                                                                          // The Map Component is valid
+	       && PowerupsInternal.FireN > 0                                                                                 // Not null length of explosion
+	       && AvailableBombsNum > 0                                                                                      // There are bombs left
+	       && OwnedController                                                                                            // controller is valid
+	       && !OwnedController->IsMoveInputIgnored()                                                                     // controller is not blocked
+	       && !GetPendingBombSpawnsNum(MapComponentInternal->GetCell())                                                  // the bomb is not requested on this cell already
+	       && !AGeneratedMap::Get(this).DoesCellMatchActorTypes(MapComponentInternal->GetCell(), TO_FLAG(~EAT::Player)); // cell is free, is the single bit test
+}
+
+// Returns the number of bombs that are requested on the server, but are not placed on their cells yet
+int32 APlayerCharacter::GetPendingBombSpawnsNum(const FCell& OnCell/* = FCell::InvalidCell*/) const
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return 0;
+	}
+
+	int32 PendingBombsNum = 0;
+	const double CurrentTime = World->GetTimeSeconds();
+	for (const FPendingBombSpawn& It : PendingBombSpawnsInternal)
+	{
+		if (CurrentTime - It.RequestTime < PendingBombTimeout // is not expired yet
+		    && (!OnCell.IsValid() || It.Cell == OnCell))
+		{
+			++PendingBombsNum;
+		}
+	}
+
+	return PendingBombsNum;
+}
+
+// Shows local bomb on the cell and marks it as occupied until the server confirms or rejects it
+uint8 APlayerCharacter::PredictBomb(const FCell& Cell)
+{
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	GeneratedMap.AddPredictedActorType(Cell, EAT::Bomb);
+
+	FPredictedBomb& PredictedBomb = PredictedBombsInternal.AddDefaulted_GetRef();
+	PredictedBomb.Cell = Cell;
+	PredictedBomb.PredictionTime = GetWorld()->GetTimeSeconds();
+	PredictedBomb.PredictionId = NextBombPredictionIdInternal++;
+
+	// Spawn local visual of the same mesh as the authoritative bomb has
+	const ULevelActorRow* BombRow = UBombDataAsset::Get().GetRowByLevelType(UMyBlueprintFunctionLibrary::GetLevelType());
+	UStreamableRenderAsset* BombMesh = BombRow ? BombRow->Mesh : nullptr;
+	if (BombMesh)
+	{
+		UMeshComponent* VisualComponent = BombMesh->IsA<USkeletalMesh>()
+			                                  ? static_cast<UMeshComponent*>(NewObject<USkeletalMeshComponent>(this, NAME_None, RF_Transient))
+			                                  : static_cast<UMeshComponent*>(NewObject<UStaticMeshComponent>(this, NAME_None, RF_Transient));
+		VisualComponent->SetUsingAbsoluteLocation(true);
+		VisualComponent->SetUsingAbsoluteRotation(true);
+		VisualComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		VisualComponent->SetupAttachment(RootComponent);
+		VisualComponent->RegisterComponent();
+		VisualComponent->SetWorldTransform(GeneratedMap.GetLevelActorTransform(Cell, EAT::Bomb));
+		UUtilsLibrary::SetMesh(VisualComponent, BombMesh);
+		PredictedBomb.VisualComponent = VisualComponent;
+	}
+
+	if (!PredictedBombsTimerInternal.IsValid())
+	{
+		static constexpr float CheckInterval = 0.05f;
+		constexpr bool bLoop = true;
+		GetWorldTimerManager().SetTimer(PredictedBombsTimerInternal, this, &ThisClass::UpdatePredictedBombs, CheckInterval, bLoop);
+	}
+
+	return PredictedBomb.PredictionId;
+}
+
+// Removes predicted bombs that are confirmed by replicated bombs or not confirmed in time
+void APlayerCharacter::UpdatePredictedBombs()
+{
+	// Is much longer than any playable ping, so only lost requests are rolled back by time
+	static constexpr double PredictionTimeout = 1.0;
+
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	for (int32 Index = PredictedBombsInternal.Num() - 1; Index >= 0; --Index)
+	{
+		const FPredictedBomb& PredictedBombIt = PredictedBombsInternal[Index];
+		if (!GeneratedMap.IsPredictedActorType(PredictedBombIt.Cell, EAT::Bomb))
+		{
+			// Authoritative bomb is replicated, the Generated Map already reconciled the cell
+			RemovePredictedBomb(Index, /*bRollback*/false);
+		}
+		else if (CurrentTime - PredictedBombIt.PredictionTime > PredictionTimeout)
+		{
+			RemovePredictedBomb(Index, /*bRollback*/true);
+		}
+	}
+
+	if (PredictedBombsInternal.IsEmpty())
+	{
+		GetWorldTimerManager().ClearTimer(PredictedBombsTimerInternal);
+	}
+}
+
+// Removes the local visual and the predicted occupancy of given bomb
+void APlayerCharacter::RemovePredictedBomb(int32 PredictedBombIndex, bool bRollback)
+{
+	if (!PredictedBombsInternal.IsValidIndex(PredictedBombIndex))
+	{
+		return;
+	}
+
+	const FPredictedBomb& PredictedBomb = PredictedBombsInternal[PredictedBombIndex];
+	if (UMeshComponent* VisualComponent = PredictedBomb.VisualComponent.Get())
+	{
+		VisualComponent->DestroyComponent();
+	}
+
+	if (bRollback)
+	{
+		AGeneratedMap::Get(this).RemovePredictedActorType(PredictedBomb.Cell, EAT::Bomb);
+	}
+
+	PredictedBombsInternal.RemoveAt(PredictedBombIndex);
+}
+
+// Is called on the owning client when the server rejected its predicted bomb placing
+void APlayerCharacter::ClientRejectSpawnBomb_Implementation(uint8 PredictionId)
+{
+	// Other predictions could be confirmed or timed out in between, so the rejected one is found by its id
+	const int32 PredictedBombIndex = PredictedBombsInternal.IndexOfByPredicate([PredictionId](const FPredictedBomb& It) { return It.PredictionId == PredictionId; });
+	RemovePredictedBomb(PredictedBombIndex, /*bRollback*/true);
 }
 
 // Returns the Skeletal Mesh of bombers
@@ -164,6 +416,7 @@ void APlayerCharacter::UpdateNicknameOnNameplate()
 		NewNickname = MyPlayerState->GetPlayerFNameCustom();
 	}
 
+	// Text nameplate is updated by the native part of this event
 	SetNicknameOnNameplate(NewNickname);
 }
 
@@ -185,6 +438,7 @@ const FGameplayTag& APlayerCharacter::GetPlayerTag() const
 void APlayerCharacter::ServerSetCustomPlayerMeshData_Implementation(const FCustomPlayerMeshData& CustomPlayerMeshData)
 {
 	PlayerMeshDataInternal = CustomPlayerMeshData;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, PlayerMeshDataInternal, this);
 	ApplyCustomPlayerMeshData();
 }
 
@@ -207,21 +461,22 @@ void APlayerCharacter::BeginPlay()
 
 	TryPossessController();
 
-	if (HasAuthority())
+	InitNicknameText();
+
+	// The owning client also tracks its cell to play pickup cosmetics
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
-		OnActorBeginOverlap.AddDynamic(this, &ThisClass::OnPlayerBeginOverlap);
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
-		if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
+		// Handle current game state if initialized with delay
+		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
 		{
-			MyGameState->OnGameStateChanged.AddDynamic(this, &ThisClass::OnGameStateChanged);
-
-			// Handle current game state if initialized with delay
-			if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
-			{
-				OnGameStateChanged(ECurrentGameState::Menu);
-			}
+			OnGameStateChanged(ECurrentGameState::Menu);
 		}
+	}
 
+	if (HasAuthority())
+	{
 		// Listen to handle possessing logic
 		FGameModeEvents::GameModePostLoginEvent.AddUObject(this, &ThisClass::OnPostLogin);
 	}
@@ -255,6 +510,7 @@ void APlayerCharacter::OnConstructionPlayerCharacter()
 	{
 		const FCells PlayerCells = UCellsUtilsLibrary::GetAllCellsWithActors(TO_FLAG(EAT::Player));
 		CharacterIDInternal = PlayerCells.Num() - 1;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CharacterIDInternal, this);
 		ApplyCharacterID();
 	}
 
@@ -285,17 +541,76 @@ void APlayerCharacter::OnConstructionPlayerCharacter()
 #endif	// WITH_EDITOR [IsEditorNotPieWorld]
 }
 
-// Called every frame, is disabled on start, tick interval is decreased
-void APlayerCharacter::Tick(float DeltaTime)
+// Is bound to the character movement while in game to update a player cell only when a cell boundary is crossed
+void APlayerCharacter::OnCharacterMovementUpdatedCell(float DeltaSeconds, FVector OldLocation, FVector OldVelocity)
+{
+	if (!MapComponentInternal)
+	{
+		return;
+	}
+
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	const int32 NewCellIndex = GeneratedMap.GetNearestCellIndex(GetActorLocation());
+	if (NewCellIndex == TrackedCellIndexInternal)
+	{
+		// Still on the same cell, nothing to update
+		return;
+	}
+
+	TrackedCellIndexInternal = NewCellIndex;
+
+	PickUpItemOnCell(NewCellIndex);
+
+	if (!HasAuthority())
+	{
+		// The owning client only plays pickup cosmetics, its cell is replicated by the server
+		return;
+	}
+
+	// Update a player location on the Generated Map, UMapComponent::OnCellChanged is broadcasted if the cell is changed
+	GeneratedMap.SetNearestCell(MapComponentInternal);
+
+	if (UGridReplaySubsystem* GridReplaySubsystem = UGridReplaySubsystem::GetGridReplaySubsystem(this))
+	{
+		GridReplaySubsystem->RecordEvent(EGridReplayEventType::PlayerCellChanged, MapComponentInternal->GetCell(), CharacterIDInternal);
+	}
+}
+
+// Picks up the item that lies on the cell the player has just stepped on
+void APlayerCharacter::PickUpItemOnCell(int32 CellIndex)
 {
-	Super::Tick(DeltaTime);
+	const UMapComponent* ItemMapComponent = AGeneratedMap::Get(this).GetMapComponentOnCellIndex(CellIndex, TO_FLAG(EAT::Item));
+	AItemActor* Item = ItemMapComponent ? ItemMapComponent->GetOwner<AItemActor>() : nullptr;
+	if (!Item)
+	{
+		return;
+	}
 
-	if (MapComponentInternal)
+	if (!HasAuthority())
 	{
-		// Update a player location on the Generated Map
-		AGeneratedMap::Get().SetNearestCell(MapComponentInternal);
+		// The item is picked up by the server, clients only play its cosmetics, the dispatch records nothing else on clients
+		AGeneratedMap::Get(this).DispatchGridEvent(EGridReplayEventType::ItemPicked, ItemMapComponent->GetCell(), CharacterIDInternal, static_cast<uint8>(Item->GetItemType()), this);
+		return;
+	}
+
+	// Is picked up on the next simulation step to be ordered with other grid events
+	UGridSimulationSubsystem::Get(this).QueuePickup(Item, this);
+}
+
+// Starts or stops tracking a player cell on the Generated Map by character movement updates
+void APlayerCharacter::SetCellTrackingEnabled(bool bEnabled)
+{
+	// Force the next movement update to snap the cell
+	TrackedCellIndexInternal = INDEX_NONE;
 
-		MapComponentInternal->TryDisplayOwnedCell();
+	if (bEnabled)
+	{
+		OnCharacterMovementUpdated.AddUniqueDynamic(this, &ThisClass::OnCharacterMovementUpdatedCell);
+		OnCharacterMovementUpdatedCell(0.f, GetActorLocation(), GetVelocity());
+	}
+	else
+	{
+		OnCharacterMovementUpdated.RemoveDynamic(this, &ThisClass::OnCharacterMovementUpdatedCell);
 	}
 }
 
@@ -304,9 +619,11 @@ void APlayerCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Out
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ThisClass, PowerupsInternal);
-	DOREPLIFETIME(ThisClass, CharacterIDInternal);
-	DOREPLIFETIME(ThisClass, PlayerMeshDataInternal);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, PowerupsInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, CharacterIDInternal, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, PlayerMeshDataInternal, Params);
 }
 
 // Is overriden to handle the client login when is set new player state
@@ -348,6 +665,12 @@ void APlayerCharacter::SetActorHiddenInGame(bool bNewHidden)
 	}
 }
 
+// Is not relevant for spectators of the grid stream, they rebuild the level by grid events
+bool APlayerCharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return IsLevelActorNetRelevantFor<Super>(*this, RealViewer, ViewTarget, SrcLocation);
+}
+
 // Called when this Pawn is possessed. Only called on the server (or in standalone)
 void APlayerCharacter::PossessedBy(AController* NewController)
 {
@@ -358,11 +681,51 @@ void APlayerCharacter::PossessedBy(AController* NewController)
 	UpdateNicknameOnNameplate();
 }
 
-// Triggers when this player character starts something overlap.
-void APlayerCharacter::OnPlayerBeginOverlap(AActor* OverlappedActor, AActor* OtherActor)
+// Overrides all powerups at once
+void APlayerCharacter::SetPowerups(const FPowerUp& NewPowerups)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	PowerupsInternal = NewPowerups;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, PowerupsInternal, this);
+	ApplyPowerups();
+}
+
+// Overrides the personal ID and possesses the controller of this ID
+void APlayerCharacter::SetCharacterID(int32 NewCharacterID)
+{
+	if (!HasAuthority()
+	    || NewCharacterID == INDEX_NONE
+	    || NewCharacterID == CharacterIDInternal)
+	{
+		return;
+	}
+
+	CharacterIDInternal = NewCharacterID;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, CharacterIDInternal, this);
+	ApplyCharacterID();
+	TryPossessController();
+}
+
+// Registers given bomb as put by this character, so the bomb is returned to the character once it is deactivated
+void APlayerCharacter::AddOwnBomb(ABombActor& BombActor)
+{
+	if (!HasAuthority()
+	    || BombActor.GetReturnCharacter() == this)
+	{
+		return;
+	}
+
+	BombActor.SetReturnCharacter(this);
+	++OwnBombsNumInternal;
+}
+
+// Increases +1 to numbers of character's powerups by given item type
+void APlayerCharacter::PickUpItem(EItemType ItemType)
 {
-	const AItemActor* OverlappedItem = Cast<AItemActor>(OtherActor);
-	const EItemType ItemType = OverlappedItem ? OverlappedItem->GetItemType() : EItemType::None;
 	if (ItemType == EItemType::None) // item is not valid
 	{
 		return;
@@ -400,34 +763,33 @@ void APlayerCharacter::OnPlayerBeginOverlap(AActor* OverlappedActor, AActor* Oth
 			break;
 	}
 
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, PowerupsInternal, this);
 	ApplyPowerups();
 }
 
-// Event triggered when the bomb has been explicitly destroyed.
-void APlayerCharacter::OnBombDestroyed(UMapComponent* MapComponent, UObject* DestroyCauser/* = nullptr*/)
+// Is called by own bomb once it is deactivated to give the bomb back to this character
+void APlayerCharacter::ReturnOwnBomb()
 {
-	if (!MapComponent
-	    || MapComponent->GetActorType() != EAT::Bomb)
+	if (OwnBombsNumInternal <= 0)
 	{
+		// Every own bomb is already given back, so the bomb would be given twice
 		return;
 	}
 
-	// Stop listening this bomb
-	if (MapComponent->OnDeactivatedMapComponent.IsAlreadyBound(this, &ThisClass::OnBombDestroyed))
-	{
-		MapComponent->OnDeactivatedMapComponent.RemoveDynamic(this, &ThisClass::OnBombDestroyed);
-	}
+	--OwnBombsNumInternal;
 
 	if (PowerupsInternal.BombN < UItemDataAsset::Get().GetMaxAllowedItemsNum())
 	{
 		++PowerupsInternal.BombN;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, PowerupsInternal, this);
 	}
 }
 
-// Listen to manage the tick
+// Listen to manage the cell tracking on the server and on the owning client
 void APlayerCharacter::OnGameStateChanged(ECurrentGameState CurrentGameState)
 {
-	if (!HasAuthority())
+	if (!HasAuthority()
+	    && !IsLocallyControlled())
 	{
 		return;
 	}
@@ -437,12 +799,12 @@ void APlayerCharacter::OnGameStateChanged(ECurrentGameState CurrentGameState)
 		case ECurrentGameState::Menu: // fallthrough
 		case ECurrentGameState::GameStarting:
 		{
-			SetActorTickEnabled(false);
+			SetCellTrackingEnabled(false);
 			break;
 		}
 		case ECurrentGameState::InGame:
 		{
-			SetActorTickEnabled(true);
+			SetCellTrackingEnabled(true);
 			break;
 		}
 		default:
@@ -469,22 +831,84 @@ void APlayerCharacter::ApplyPowerups()
 void APlayerCharacter::ResetPowerups()
 {
 	PowerupsInternal = FPowerUp::DefaultData;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, PowerupsInternal, this);
 	ApplyPowerups();
 }
 
 // Is called on clients to apply powerups
 void APlayerCharacter::OnRep_Powerups()
 {
+	BOMBER_NET_STAT(PlayerPowerups, sizeof(PowerupsInternal) * 8);
+
 	ApplyPowerups();
 }
 
 // Update player name on a 3D widget component
 void APlayerCharacter::SetNicknameOnNameplate_Implementation(FName NewName)
 {
+	SetNicknameText(NewName);
+
 	// BP implementation
 	// ...
 }
 
+// Applies text nameplate settings: draws the nickname by text or by 3D widget components
+void APlayerCharacter::InitNicknameText()
+{
+	if (!ensureMsgf(NicknameTextInternal, TEXT("ASSERT: [%i] %s:\n'NicknameTextInternal' is not valid!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	const UPlayerDataAsset& PlayerDataAsset = UPlayerDataAsset::Get();
+	const bool bTextNameplates = PlayerDataAsset.IsTextNameplatesEnabled();
+	NicknameTextInternal->SetVisibility(bTextNameplates);
+	if (!bTextNameplates)
+	{
+		return;
+	}
+
+	NicknameTextInternal->SetRelativeTransform(PlayerDataAsset.GetNicknameTextTransform());
+	NicknameTextInternal->SetWorldSize(PlayerDataAsset.GetNicknameTextSize());
+	if (UMaterialInterface* TextMaterial = PlayerDataAsset.GetNicknameTextMaterial())
+	{
+		NicknameTextInternal->SetTextMaterial(TextMaterial);
+	}
+
+	// Nickname is drawn by text, so disable 3D nameplate widgets to stop updating their render targets every frame, other widget components are kept
+	const UClass* NicknameWidgetClass = UUIDataAsset::Get().GetNicknameWidgetClass();
+	TInlineComponentArray<UWidgetComponent*> WidgetComponents(this);
+	for (UWidgetComponent* WidgetComponentIt : WidgetComponents)
+	{
+		const UUserWidget* Widget = WidgetComponentIt->GetWidget();
+		const UClass* WidgetClass = Widget ? Widget->GetClass() : WidgetComponentIt->GetWidgetClass().Get();
+		if (NicknameWidgetClass
+		    && WidgetClass
+		    && WidgetClass->IsChildOf(NicknameWidgetClass))
+		{
+			WidgetComponentIt->SetVisibility(false);
+			WidgetComponentIt->SetComponentTickEnabled(false);
+		}
+	}
+}
+
+// Sets new player name on the text nameplate, does nothing if the name is the same
+void APlayerCharacter::SetNicknameText(FName NewName)
+{
+	if (!NicknameTextInternal
+	    || !UPlayerDataAsset::Get().IsTextNameplatesEnabled())
+	{
+		return;
+	}
+
+	if (NicknameTextNameInternal != NewName)
+	{
+		// Rebuilds text geometry only when the nickname is changed
+		NicknameTextNameInternal = NewName;
+		NicknameTextInternal->SetText(FText::FromName(NewName));
+	}
+}
+
 // Updates collision object type by current character ID
 void APlayerCharacter::UpdateCollisionObjectType()
 {
@@ -495,27 +919,8 @@ void APlayerCharacter::UpdateCollisionObjectType()
 		return;
 	}
 
-	// Set the object collision type
-	ECollisionChannel CollisionObjectType = CapsuleComp->GetCollisionObjectType();
-	switch (CharacterIDInternal)
-	{
-		case 0:
-			CollisionObjectType = ECC_Player0;
-			break;
-		case 1:
-			CollisionObjectType = ECC_Player1;
-			break;
-		case 2:
-			CollisionObjectType = ECC_Player2;
-			break;
-		case 3:
-			CollisionObjectType = ECC_Player3;
-			break;
-		default:
-			break;
-	}
-
-	CapsuleComp->SetCollisionObjectType(CollisionObjectType);
+	// All characters share the same object type, bombs let own characters pass through by the character ID instead, see ABombActor::ApplyPassThroughPlayers
+	CapsuleComp->SetCollisionObjectType(ECC_Player);
 }
 
 // Possess a player or AI controller in dependence of current Character ID
@@ -543,7 +948,10 @@ void APlayerCharacter::TryPossessController()
 
 	AController* ControllerToPossess = nullptr;
 
-	if (AMyPlayerController* MyPC = UMyBlueprintFunctionLibrary::GetMyPlayerController(CharacterIDInternal))
+	// All characters are bots in the simulated bot-only matches, in the soak test and in the load test
+	const bool bIsBotOnly = UAISimulationSubsystem::IsSimulationEnabled() || USoakTestSubsystem::IsSoakTestEnabled() || ULoadTestSubsystem::IsLoadTestEnabled();
+	AMyPlayerController* MyPC = !bIsBotOnly ? UMyBlueprintFunctionLibrary::GetMyPlayerController(CharacterIDInternal) : nullptr;
+	if (MyPC)
 	{
 		if (MyPC->bCinematicMode)
 		{
@@ -642,6 +1050,8 @@ void APlayerCharacter::SetDefaultPlayerMeshData()
 // Respond on changes in player mesh data to reset to set the mesh on client
 void APlayerCharacter::OnRep_PlayerMeshData()
 {
+	BOMBER_NET_STAT(PlayerMeshData, 0);
+
 	ApplyCustomPlayerMeshData();
 }
 
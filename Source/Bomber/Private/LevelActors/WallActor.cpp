@@ -26,6 +26,12 @@ AWallActor::AWallActor()
 	MapComponentInternal = CreateDefaultSubobject<UMapComponent>(TEXT("MapComponent"));
 }
 
+// Returns the map component of this actor, is created on its construction
+UMapComponent* AWallActor::GetOwnedMapComponent() const
+{
+	return MapComponentInternal;
+}
+
 // Initialize a wall actor, could be called multiple times
 void AWallActor::ConstructWallActor()
 {
@@ -53,3 +59,9 @@ void AWallActor::SetActorHiddenInGame(bool bNewHidden)
 		ConstructWallActor();
 	}
 }
+
+// Is not relevant for spectators of the grid stream, they rebuild the level by grid events
+bool AWallActor::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return IsLevelActorNetRelevantFor<Super>(*this, RealViewer, ViewTarget, SrcLocation);
+}
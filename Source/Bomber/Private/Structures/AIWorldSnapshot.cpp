@@ -0,0 +1,492 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/AIWorldSnapshot.h"
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+
+// Takes all the state from given Generated Map that is needed for bots
+void FAIWorldSnapshot::Build(const AGeneratedMap& GeneratedMap)
+{
+	const FIntPoint PrevGridSize = GridSize;
+	GridSize = GeneratedMap.GetGridSize();
+	const int32 CellsNum = GridSize.X * GridSize.Y;
+
+	// Remember where the safe path was broken to update only changed rows and columns of the crossway map
+	TBitArray<> PrevSafeBreaks;
+	if (PrevGridSize == GridSize
+	    && CrosswayMap.Num() == CellsNum
+	    && CellActorTypes.Num() == CellsNum)
+	{
+		PrevSafeBreaks.Init(false, CellsNum);
+		for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+		{
+			PrevSafeBreaks[CellIndex] = IsSafeBreak(CellIndex);
+		}
+	}
+
+	// Previous state is kept to find changed rows and columns
+	const TArray<uint8> PrevCellActorTypes = MoveTemp(CellActorTypes);
+	const TArray<float> PrevDetonationTimes = MoveTemp(DetonationTimes);
+	const FCellsBitboard PrevDangerousCells = MoveTemp(DangerousCells);
+
+	GridCells.Reset(CellsNum);
+	CellActorTypes.Reset(CellsNum);
+	DetonationTimes.Reset(CellsNum);
+	for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+	{
+		GridCells.Emplace(GeneratedMap.GetCellByIndex(CellIndex));
+		CellActorTypes.Emplace(static_cast<uint8>(GeneratedMap.GetActorTypesOnCellIndex(CellIndex)));
+		DetonationTimes.Emplace(GeneratedMap.GetDetonationTimeOnCellIndex(CellIndex));
+	}
+
+	// Few players could stand on the same cell, so they are counted by their map components instead of cells
+	PlayersNum = GeneratedMap.GetAlivePlayersNum();
+
+	GeneratedMap.GetDangerousCellsBitboard(DangerousCells);
+
+	++BuildNumber;
+	const bool bIsSameGrid = PrevGridSize == GridSize
+	                         && PrevCellActorTypes.Num() == CellsNum
+	                         && PrevDetonationTimes.Num() == CellsNum
+	                         && PrevDangerousCells.Num() == CellsNum;
+	if (!bIsSameGrid)
+	{
+		RowChangedBuilds.Init(BuildNumber, GridSize.Y);
+		ColumnChangedBuilds.Init(BuildNumber, GridSize.X);
+	}
+	else
+	{
+		for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+		{
+			if (PrevCellActorTypes[CellIndex] != CellActorTypes[CellIndex]
+			    || PrevDetonationTimes[CellIndex] != DetonationTimes[CellIndex]
+			    || PrevDangerousCells.IsSet(CellIndex) != DangerousCells.IsSet(CellIndex))
+			{
+				RowChangedBuilds[CellIndex / GridSize.X] = BuildNumber;
+				ColumnChangedBuilds[CellIndex % GridSize.X] = BuildNumber;
+			}
+		}
+	}
+
+	UpdateCrosswayMap(PrevSafeBreaks);
+
+	BuildDistancesToSafety();
+}
+
+// Takes the state from given board layout without any level, is used to measure bots on scripted boards
+void FAIWorldSnapshot::BuildFromLayout(const FIntPoint& InGridSize, TConstArrayView<uint8> InCellActorTypes, const FCellsBitboard& InDangerousCells)
+{
+	const int32 CellsNum = InGridSize.X * InGridSize.Y;
+	if (!ensureMsgf(InCellActorTypes.Num() == CellsNum, TEXT("ASSERT: 'InCellActorTypes' has %i cells while the board has %i"), InCellActorTypes.Num(), CellsNum)
+	    || !ensureMsgf(InDangerousCells.Num() == CellsNum, TEXT("ASSERT: 'InDangerousCells' has %i cells while the board has %i"), InDangerousCells.Num(), CellsNum))
+	{
+		return;
+	}
+
+	GridSize = InGridSize;
+	CellActorTypes.Reset(CellsNum);
+	CellActorTypes.Append(InCellActorTypes.GetData(), CellsNum);
+	DangerousCells = InDangerousCells;
+	DetonationTimes.Init(MAX_flt, CellsNum);
+
+	GridCells.Reset(CellsNum);
+	PlayersNum = 0;
+	for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+	{
+		GridCells.Emplace(FVector(CellIndex % GridSize.X, CellIndex / GridSize.X, 0.f) * FCell::CellSize);
+		PlayersNum += CellActorTypes[CellIndex] & TO_FLAG(EAT::Player) ? 1 : 0;
+	}
+
+	++BuildNumber;
+	RowChangedBuilds.Init(BuildNumber, GridSize.Y);
+	ColumnChangedBuilds.Init(BuildNumber, GridSize.X);
+
+	UpdateCrosswayMap(TBitArray<>());
+
+	BuildDistancesToSafety();
+}
+
+// Returns true if any cell is changed since given build in rows and columns around given cell
+bool FAIWorldSnapshot::IsChangedAround(int32 CellIndex, int32 Radius, uint32 SinceBuildNumber) const
+{
+	const int32 MaxWidth = GridSize.X;
+	if (!IsValidIndex(CellIndex)
+	    || !MaxWidth
+	    || RowChangedBuilds.Num() != GridSize.Y
+	    || ColumnChangedBuilds.Num() != MaxWidth)
+	{
+		return true;
+	}
+
+	const int32 Row = CellIndex / MaxWidth;
+	const int32 Column = CellIndex % MaxWidth;
+
+	for (int32 RowIt = FMath::Max(0, Row - Radius); RowIt <= FMath::Min(GridSize.Y - 1, Row + Radius); ++RowIt)
+	{
+		if (RowChangedBuilds[RowIt] > SinceBuildNumber)
+		{
+			return true;
+		}
+	}
+
+	for (int32 ColumnIt = FMath::Max(0, Column - Radius); ColumnIt <= FMath::Min(MaxWidth - 1, Column + Radius); ++ColumnIt)
+	{
+		if (ColumnChangedBuilds[ColumnIt] > SinceBuildNumber)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Returns the distance in cells to the nearest threat in the square around given cell
+int32 FAIWorldSnapshot::GetThreatDistance(int32 CellIndex, int32 MaxRadius) const
+{
+	const int32 MaxWidth = GridSize.X;
+	if (!IsValidIndex(CellIndex)
+	    || !MaxWidth)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Row = CellIndex / MaxWidth;
+	const int32 Column = CellIndex % MaxWidth;
+	int32 ThreatDistance = INDEX_NONE;
+
+	for (int32 RowIt = FMath::Max(0, Row - MaxRadius); RowIt <= FMath::Min(GridSize.Y - 1, Row + MaxRadius); ++RowIt)
+	{
+		for (int32 ColumnIt = FMath::Max(0, Column - MaxRadius); ColumnIt <= FMath::Min(MaxWidth - 1, Column + MaxRadius); ++ColumnIt)
+		{
+			const int32 CellIndexIt = RowIt * MaxWidth + ColumnIt;
+			const bool bIsOwnCell = CellIndexIt == CellIndex;
+
+			// The bot itself is the player on its own cell, so only bombs and explosions are threats there
+			const int32 ThreatTypes = bIsOwnCell ? TO_FLAG(EAT::Bomb) : TO_FLAG(EAT::Bomb | EAT::Player);
+			if (!(CellActorTypes[CellIndexIt] & ThreatTypes)
+			    && !DangerousCells.IsSet(CellIndexIt))
+			{
+				continue;
+			}
+
+			const int32 Distance = FMath::Max(FMath::Abs(RowIt - Row), FMath::Abs(ColumnIt - Column));
+			if (ThreatDistance == INDEX_NONE
+			    || Distance < ThreatDistance)
+			{
+				ThreatDistance = Distance;
+			}
+		}
+	}
+
+	return ThreatDistance;
+}
+
+// Sets the bitboard to the cells by four sides of given center cell
+void FAIWorldSnapshot::GetCellsAround(FCellsBitboard& OutCells, int32 CellIndex, EPathType Pathfinder, int32 Radius) const
+{
+	OutCells.Init(GridCells.Num());
+
+	// Explosions break lines only for paths that have to be safe
+	const bool bBreakByDanger = Pathfinder == EPathType::Safe || Pathfinder == EPathType::Secure;
+
+	FCellIndices FoundCellIndices;
+	constexpr int32 AllDirections = TO_FLAG(ECellDirection::All);
+	AGeneratedMap::GetSidesCellIndices(FoundCellIndices, CellIndex, GridSize, CellActorTypes, AGeneratedMap::GetBreakActorTypes(Pathfinder), bBreakByDanger ? &DangerousCells : nullptr, Radius, AllDirections);
+
+	for (const int32 FoundCellIndexIt : FoundCellIndices)
+	{
+		OutCells.SetBit(FoundCellIndexIt, true);
+	}
+}
+
+// Finds the soonest reachable cell that is not going to be exploded by time-expanded breadth-first search from given cell
+int32 FAIWorldSnapshot::FindEscapeCell(int32 CellIndex, float CurrentTime, float SecondsPerCell, float SafetyMargin, int32 MaxSteps) const
+{
+	const int32 CellsNum = GridCells.Num();
+	const int32 MaxWidth = GridSize.X;
+	if (!IsValidIndex(CellIndex)
+	    || !MaxWidth
+	    || SecondsPerCell <= 0.f
+	    || CellActorTypes.Num() != CellsNum
+	    || DetonationTimes.Num() != CellsNum)
+	{
+		return INDEX_NONE;
+	}
+
+	if (!DangerousCells.IsSet(CellIndex))
+	{
+		return CellIndex;
+	}
+
+	// Returns true if the bot standing on given cell during given step is exploded
+	auto IsExplodedOnStep = [this, CurrentTime, SecondsPerCell, SafetyMargin](int32 InCellIndex, int32 Step)
+	{
+		if (!DangerousCells.IsSet(InCellIndex))
+		{
+			return false;
+		}
+
+		const float DetonationTime = DetonationTimes[InCellIndex];
+		if (DetonationTime == MAX_flt)
+		{
+			// The time is unknown, so the cell is dangerous at any moment
+			return true;
+		}
+
+		const float TimeLeft = DetonationTime - CurrentTime;
+		const float EnterTime = Step * SecondsPerCell - SafetyMargin;
+		const float LeaveTime = (Step + 1) * SecondsPerCell + SafetyMargin;
+		return TimeLeft >= EnterTime && TimeLeft <= LeaveTime;
+	};
+
+	const int32 BlockingActorTypes = AGeneratedMap::GetBreakActorTypes(EPathType::Free);
+
+	// Cells where the bot could be on the current step, is rolled over steps
+	FCellsBitboard Frontier(CellsNum);
+	FCellsBitboard NextFrontier;
+	Frontier.SetBit(CellIndex, true);
+
+	for (int32 Step = 1; Step <= MaxSteps; ++Step)
+	{
+		NextFrontier.Init(CellsNum);
+		for (TConstSetBitIterator<> It(Frontier.Bits); It; ++It)
+		{
+			const int32 FrontierIndex = It.GetIndex();
+			const int32 Column = FrontierIndex % MaxWidth;
+
+			// Waiting on the same cell is the first option, so the bot could let the explosion pass
+			const int32 Candidates[] = {
+				FrontierIndex,
+				Column > 0 ? FrontierIndex - 1 : INDEX_NONE,
+				Column < MaxWidth - 1 ? FrontierIndex + 1 : INDEX_NONE,
+				FrontierIndex - MaxWidth,
+				FrontierIndex + MaxWidth
+			};
+
+			for (const int32 CandidateIt : Candidates)
+			{
+				if (!IsValidIndex(CandidateIt)
+				    || CandidateIt != FrontierIndex && CellActorTypes[CandidateIt] & BlockingActorTypes
+				    || IsExplodedOnStep(CandidateIt, Step))
+				{
+					continue;
+				}
+
+				NextFrontier.SetBit(CandidateIt, true);
+			}
+		}
+
+		if (NextFrontier.IsEmpty())
+		{
+			// The bot is exploded anyway
+			return INDEX_NONE;
+		}
+
+		for (TConstSetBitIterator<> It(NextFrontier.Bits); It; ++It)
+		{
+			if (!DangerousCells.IsSet(It.GetIndex()))
+			{
+				return It.GetIndex();
+			}
+		}
+
+		Swap(Frontier, NextFrontier);
+	}
+
+	return INDEX_NONE;
+}
+
+// Sets the bitboard to the safe cells by four sides of given center cell taken from the crossway map
+void FAIWorldSnapshot::GetSafeCellsAround(FCellsBitboard& OutCells, int32 CellIndex, int32 Radius) const
+{
+	OutCells.Init(GridCells.Num());
+	if (!CrosswayMap.IsValidIndex(CellIndex))
+	{
+		return;
+	}
+
+	// The center is added even if it has an obstacle (like own bomb) but not if it is going to be exploded
+	OutCells.SetBit(CellIndex, !DangerousCells.IsSet(CellIndex));
+
+	const int32 IndexSteps[FCellCrossway::SidesNum] = {-1, 1, -GridSize.X, GridSize.X};
+	const FCellCrossway& Crossway = CrosswayMap[CellIndex];
+	for (int32 SideIndex = 0; SideIndex < FCellCrossway::SidesNum; ++SideIndex)
+	{
+		const int32 StepsNum = FMath::Min<int32>(Crossway.SideLengths[SideIndex], Radius);
+		for (int32 Step = 1; Step <= StepsNum; ++Step)
+		{
+			OutCells.SetBit(CellIndex + Step * IndexSteps[SideIndex], true);
+		}
+	}
+}
+
+// Keeps in the bitboard only cells that match specified actor types
+void FAIWorldSnapshot::FilterCellsByActors(FCellsBitboard& InOutCells, int32 ActorsTypesBitmask) const
+{
+	for (TConstSetBitIterator<> It(InOutCells.Bits); It; ++It)
+	{
+		const int32 CellIndex = It.GetIndex();
+		if (!DoesCellMatchActorTypes(CellIndex, ActorsTypesBitmask))
+		{
+			InOutCells.SetBit(CellIndex, false);
+		}
+	}
+}
+
+// Updates the crossway map by comparing given previous state with the current one
+void FAIWorldSnapshot::UpdateCrosswayMap(const TBitArray<>& PrevSafeBreaks)
+{
+	const int32 MaxWidth = GridSize.X;
+	const int32 MaxLength = GridSize.Y;
+	const int32 CellsNum = MaxWidth * MaxLength;
+	if (CellActorTypes.Num() != CellsNum)
+	{
+		CrosswayMap.Reset();
+		return;
+	}
+
+	// ----- Finding rows and columns to update -----
+
+	TBitArray<> DirtyRows(false, MaxLength);
+	TBitArray<> DirtyColumns(false, MaxWidth);
+	if (PrevSafeBreaks.Num() != CellsNum)
+	{
+		CrosswayMap.SetNum(CellsNum);
+		DirtyRows.Init(true, MaxLength);
+		DirtyColumns.Init(true, MaxWidth);
+	}
+	else
+	{
+		for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+		{
+			if (PrevSafeBreaks[CellIndex] != IsSafeBreak(CellIndex))
+			{
+				DirtyRows[CellIndex / MaxWidth] = true;
+				DirtyColumns[CellIndex % MaxWidth] = true;
+			}
+		}
+	}
+
+	// ----- Walking dirty lines -----
+
+	// Each line is walked twice (forward and back) counting free cells since the last break
+	for (TConstSetBitIterator<> RowIt(DirtyRows); RowIt; ++RowIt)
+	{
+		const int32 RowStart = RowIt.GetIndex() * MaxWidth;
+		uint8 FreeCellsNum = 0;
+		for (int32 Column = 0; Column < MaxWidth; ++Column)
+		{
+			CrosswayMap[RowStart + Column].SideLengths[0] = FreeCellsNum;
+			FreeCellsNum = IsSafeBreak(RowStart + Column) ? 0 : static_cast<uint8>(FMath::Min<int32>(FreeCellsNum + 1, MAX_uint8));
+		}
+
+		FreeCellsNum = 0;
+		for (int32 Column = MaxWidth - 1; Column >= 0; --Column)
+		{
+			CrosswayMap[RowStart + Column].SideLengths[1] = FreeCellsNum;
+			FreeCellsNum = IsSafeBreak(RowStart + Column) ? 0 : static_cast<uint8>(FMath::Min<int32>(FreeCellsNum + 1, MAX_uint8));
+		}
+	}
+
+	for (TConstSetBitIterator<> ColumnIt(DirtyColumns); ColumnIt; ++ColumnIt)
+	{
+		const int32 Column = ColumnIt.GetIndex();
+		uint8 FreeCellsNum = 0;
+		for (int32 Row = 0; Row < MaxLength; ++Row)
+		{
+			CrosswayMap[Row * MaxWidth + Column].SideLengths[2] = FreeCellsNum;
+			FreeCellsNum = IsSafeBreak(Row * MaxWidth + Column) ? 0 : static_cast<uint8>(FMath::Min<int32>(FreeCellsNum + 1, MAX_uint8));
+		}
+
+		FreeCellsNum = 0;
+		for (int32 Row = MaxLength - 1; Row >= 0; --Row)
+		{
+			CrosswayMap[Row * MaxWidth + Column].SideLengths[3] = FreeCellsNum;
+			FreeCellsNum = IsSafeBreak(Row * MaxWidth + Column) ? 0 : static_cast<uint8>(FMath::Min<int32>(FreeCellsNum + 1, MAX_uint8));
+		}
+	}
+}
+
+// Returns true if the safe path is broken on the cell by given index
+bool FAIWorldSnapshot::IsSafeBreak(int32 CellIndex) const
+{
+	return (CellActorTypes[CellIndex] & AGeneratedMap::GetBreakActorTypes(EPathType::Safe)) || DangerousCells.IsSet(CellIndex);
+}
+
+// Fills the number of steps by free cells from each cell to the nearest of given target cells
+void FAIWorldSnapshot::BuildDistanceField(TArray<int32>& OutDistances, TConstArrayView<int32> TargetCellIndices) const
+{
+	const int32 CellsNum = GridCells.Num();
+	OutDistances.Init(INDEX_NONE, CellsNum);
+	const int32 MaxWidth = GridSize.X;
+	if (!MaxWidth
+	    || CellActorTypes.Num() != CellsNum)
+	{
+		return;
+	}
+
+	// Bombs are passable only for the player that stands on it, so they keep the distance but do not continue the path
+	const int32 BlockingActorTypes = AGeneratedMap::GetBreakActorTypes(EPathType::Free);
+	const int32 ObstacleActorTypes = BlockingActorTypes & ~TO_FLAG(EAT::Bomb);
+
+	TArray<int32> Queue;
+	Queue.Reserve(CellsNum);
+	for (const int32 TargetCellIndexIt : TargetCellIndices)
+	{
+		if (OutDistances.IsValidIndex(TargetCellIndexIt)
+		    && OutDistances[TargetCellIndexIt] == INDEX_NONE)
+		{
+			OutDistances[TargetCellIndexIt] = 0;
+			Queue.Emplace(TargetCellIndexIt);
+		}
+	}
+
+	for (int32 QueueIndex = 0; QueueIndex < Queue.Num(); ++QueueIndex)
+	{
+		const int32 CellIndex = Queue[QueueIndex];
+		const int32 NextDistance = OutDistances[CellIndex] + 1;
+		const int32 Column = CellIndex % MaxWidth;
+
+		const int32 Neighbours[] = {
+			Column > 0 ? CellIndex - 1 : INDEX_NONE,
+			Column < MaxWidth - 1 ? CellIndex + 1 : INDEX_NONE,
+			CellIndex - MaxWidth,
+			CellIndex + MaxWidth
+		};
+
+		for (const int32 NeighbourIt : Neighbours)
+		{
+			if (!OutDistances.IsValidIndex(NeighbourIt)
+			    || OutDistances[NeighbourIt] != INDEX_NONE
+			    || CellActorTypes[NeighbourIt] & ObstacleActorTypes)
+			{
+				continue;
+			}
+
+			OutDistances[NeighbourIt] = NextDistance;
+			if (!(CellActorTypes[NeighbourIt] & BlockingActorTypes))
+			{
+				Queue.Emplace(NeighbourIt);
+			}
+		}
+	}
+}
+
+// Fills distances to the nearest safe cell by breadth-first search started from all safe cells at once
+void FAIWorldSnapshot::BuildDistancesToSafety()
+{
+	const int32 BlockingActorTypes = AGeneratedMap::GetBreakActorTypes(EPathType::Free);
+
+	FCellIndices SafeCellIndices;
+	for (int32 CellIndex = 0; CellIndex < CellActorTypes.Num(); ++CellIndex)
+	{
+		if (!(CellActorTypes[CellIndex] & BlockingActorTypes)
+		    && !DangerousCells.IsSet(CellIndex))
+		{
+			SafeCellIndices.Emplace(CellIndex);
+		}
+	}
+
+	BuildDistanceField(DistancesToSafety, SafeCellIndices);
+}
@@ -0,0 +1,71 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/BombExplosion.h"
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Structures/CellsAllocationTracker.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BombExplosion)
+
+// Casts the blast on the given level from the specified cell by given radius
+FBombExplosion::FBombExplosion(const AGeneratedMap& GeneratedMap, const FCell& InOrigin, int32 InRadius)
+{
+	OriginIndex = GeneratedMap.GetCellIndex(InOrigin);
+	if (OriginIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// The order is the same as steps are iterated in GetExplosionCells()
+	GeneratedMap.GetSideRayLengths(RayLengths, OriginIndex, AGeneratedMap::GetBreakActorTypes(EPathType::Explosion), InRadius);
+}
+
+// Returns cells that are exploded by this blast on the given level, the center included
+FCells FBombExplosion::GetExplosionCells(const AGeneratedMap& GeneratedMap) const
+{
+	const int32 MaxWidth = GeneratedMap.GetGridSize().X;
+	if (!IsValid()
+	    || !MaxWidth)
+	{
+		return FCell::EmptyCells;
+	}
+
+	const int32 IndexSteps[RaysNum] = {-1, 1, -MaxWidth, MaxWidth};
+
+	CELLS_ALLOCATION_SCOPE();
+	FCells OutCells;
+	OutCells.Reserve(1 + RayLengths[0] + RayLengths[1] + RayLengths[2] + RayLengths[3]);
+	OutCells.Emplace(GeneratedMap.GetCellByIndex(OriginIndex));
+	for (int32 RayIndex = 0; RayIndex < RaysNum; ++RayIndex)
+	{
+		for (int32 Step = 1; Step <= RayLengths[RayIndex]; ++Step)
+		{
+			const FCell& ExplosionCell = GeneratedMap.GetCellByIndex(OriginIndex + Step * IndexSteps[RayIndex]);
+			if (ExplosionCell.IsValid())
+			{
+				OutCells.Emplace(ExplosionCell);
+			}
+		}
+	}
+
+	TRACK_CELLS_ALLOCATION(GetExplosionCells, OutCells);
+	return OutCells;
+}
+
+// Packs the grid index and ray lengths to be sent over network
+bool FBombExplosion::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// Index is shifted to keep INDEX_NONE in unsigned packed integer
+	uint32 PackedIndex = static_cast<uint32>(OriginIndex + 1);
+	Ar.SerializeIntPacked(PackedIndex);
+	OriginIndex = static_cast<int32>(PackedIndex) - 1;
+
+	for (uint8& RayLengthIt : RayLengths)
+	{
+		Ar << RayLengthIt;
+	}
+
+	bOutSuccess = true;
+	return true;
+}
@@ -2,6 +2,9 @@
 
 #include "Structures/Cell.h"
 //---
+#include "Bomber.h"
+#include "Structures/CellsAllocationTracker.h"
+//---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(Cell)
 
 const FCell FCell::InvalidCell = FCell(0.f, 0.f, -1.f);
@@ -11,6 +14,56 @@ const FCell FCell::RightCell = FCell(0.f, 1.f, 0.f);
 const FCell FCell::LeftCell = FCell(0.f, -1.f, 0.f);
 const FCells FCell::EmptyCells = FCells{};
 
+namespace CellRotation
+{
+	/** The yaw rotation around the origin as 2D basis in vector registers, is computed once to rotate many cells the same way as FCell::RotateCellAroundOrigin. */
+	struct FBasis
+	{
+		VectorRegister4Double Origin;
+		VectorRegister4Double AxisX;
+		VectorRegister4Double AxisY;
+		VectorRegister4Double AxisUp;
+
+		FBasis(float AxisZ, const FTransform& OriginTransformNoScale)
+		{
+			// Is the same as FVector::RotateAngleAxis around (0, 0, AxisZ)
+			double Sin = 0.0;
+			double Cos = 1.0;
+			FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(OriginTransformNoScale.GetRotation().Rotator().Yaw));
+			Sin *= AxisZ;
+
+			const FVector OriginLocation = OriginTransformNoScale.GetLocation();
+			Origin = MakeVectorRegisterDouble(OriginLocation.X, OriginLocation.Y, OriginLocation.Z, 0.0);
+			AxisX = MakeVectorRegisterDouble(Cos, Sin, 0.0, 0.0);
+			AxisY = MakeVectorRegisterDouble(-Sin, Cos, 0.0, 0.0);
+			AxisUp = MakeVectorRegisterDouble(0.0, 0.0, 1.0, 0.0);
+		}
+
+		/** Returns given offset from the origin rotated by this basis. */
+		FORCEINLINE VectorRegister4Double RotateOffset(const VectorRegister4Double& Offset) const
+		{
+			VectorRegister4Double Result = VectorMultiply(VectorReplicate(Offset, 0), AxisX);
+			Result = VectorMultiplyAdd(VectorReplicate(Offset, 1), AxisY, Result);
+			return VectorMultiplyAdd(VectorReplicate(Offset, 2), AxisUp, Result);
+		}
+
+		/** Returns given location rotated around the origin by this basis. */
+		FORCEINLINE VectorRegister4Double RotateLocation(const FVector& Location) const
+		{
+			const VectorRegister4Double Offset = VectorSubtract(VectorLoadFloat3_W0(&Location.X), Origin);
+			return VectorAdd(Origin, RotateOffset(Offset));
+		}
+	};
+
+	/** Makes the cell from given vector register, the same as the cell from FVector. */
+	FORCEINLINE FCell MakeCell(const VectorRegister4Double& Location)
+	{
+		FVector Vector;
+		VectorStoreFloat3(Location, &Vector.X);
+		return FCell(Vector);
+	}
+}
+
 // Vector to cell constructor
 FCell::FCell(const FVector& Vector)
 {
@@ -87,6 +140,79 @@ FCell FCell::GetCellArrayNearest(const FCells& Cells, const FCell& CellToCheck)
 	return NearestCell;
 }
 
+// Returns the max distance in units between cells within specified set
+double FCell::GetCellArrayMaxLength(const FCells& Cells)
+{
+	if (Cells.Num() < 2)
+	{
+		return 0.0;
+	}
+
+	// The farthest pair of cells is always on their convex hull, and any hull vertex is the leftmost or the rightmost cell of its row,
+	// since a cell between two others of the same row can't be extreme, so only these few cells are compared with each other.
+	// Rows are taken in the unrotated grid space, so the rotated level is grouped by its rows instead of a row per cell
+	const FVector Origin = Cells.CreateConstIterator()->Location;
+	double Sin = 0.0;
+	double Cos = 1.0;
+	FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(GetCellArrayRotation(Cells).Yaw));
+
+	struct FRowExtremes
+	{
+		double MinX = 0.0;
+		double MaxX = 0.0;
+		FVector MinLocation = FVector::ZeroVector;
+		FVector MaxLocation = FVector::ZeroVector;
+	};
+
+	TMap<int64, FRowExtremes, TInlineSetAllocator<64>> RowExtremes;
+	for (const FCell& CellIt : Cells)
+	{
+		const FVector& Location = CellIt.Location;
+		const FVector Offset = Location - Origin;
+		const double LocalX = Offset.X * Cos + Offset.Y * Sin;
+		const int64 Row = FMath::RoundToInt64(Offset.Y * Cos - Offset.X * Sin); // cells of one row differ only by float errors
+		if (FRowExtremes* FoundExtremes = RowExtremes.Find(Row))
+		{
+			if (LocalX < FoundExtremes->MinX)
+			{
+				FoundExtremes->MinX = LocalX;
+				FoundExtremes->MinLocation = Location;
+			}
+			else if (LocalX > FoundExtremes->MaxX)
+			{
+				FoundExtremes->MaxX = LocalX;
+				FoundExtremes->MaxLocation = Location;
+			}
+		}
+		else
+		{
+			RowExtremes.Emplace(Row, FRowExtremes{LocalX, LocalX, Location, Location});
+		}
+	}
+
+	TArray<FVector, TInlineAllocator<128>> Candidates;
+	Candidates.Reserve(RowExtremes.Num() * 2);
+	for (const TTuple<int64, FRowExtremes>& It : RowExtremes)
+	{
+		Candidates.Emplace(It.Value.MinLocation);
+		if (It.Value.MaxLocation != It.Value.MinLocation)
+		{
+			Candidates.Emplace(It.Value.MaxLocation);
+		}
+	}
+
+	double MaxLengthSquared = 0.0;
+	for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+	{
+		for (int32 OtherIndex = Index + 1; OtherIndex < Candidates.Num(); ++OtherIndex)
+		{
+			MaxLengthSquared = FMath::Max(MaxLengthSquared, FVector::DistSquared(Candidates[Index], Candidates[OtherIndex]));
+		}
+	}
+
+	return FMath::Sqrt(MaxLengthSquared);
+}
+
 // Allows rotate or unrotated given grid around its origin
 FCells FCell::RotateCellArray(float AxisZ, const FCells& InCells)
 {
@@ -105,49 +231,81 @@ FCells FCell::RotateCellArray(float AxisZ, const FCells& InCells)
 		return EmptyCells;
 	}
 
-	const FTransform CellArrayTransformNoScale = GetCellArrayTransformNoScale(InCells);
+	CELLS_ALLOCATION_SCOPE();
+	const CellRotation::FBasis Basis(AxisZ, GetCellArrayTransformNoScale(InCells));
 
 	FCells RotatedCells = EmptyCells;
+	RotatedCells.Reserve(InCells.Num());
 	for (const FCell& CellIt : InCells)
 	{
-		const FCell RotatedCell = RotateCellAroundOrigin(CellIt, AxisZ, CellArrayTransformNoScale);
-		FCell SnappedCell = SnapCell(RotatedCell);
-		RotatedCells.Emplace(MoveTemp(SnappedCell));
+		RotatedCells.Emplace(SnapCell(CellRotation::MakeCell(Basis.RotateLocation(CellIt.Location))));
 	}
 
+	TRACK_CELLS_ALLOCATION(RotateCellArray, RotatedCells);
 	return MoveTemp(RotatedCells);
 }
 
 // Constructs and returns new grid from given transform
 FCells FCell::MakeCellGridByTransform(const FTransform& OriginTransform)
+{
+	TArray<FCell> GridArray;
+	MakeCellGridByTransform(OriginTransform, GridArray);
+
+	FCells GridCells;
+	GridCells.Append(GridArray);
+	return MoveTemp(GridCells);
+}
+
+// Batch version that constructs new grid into the dense row-major array
+void FCell::MakeCellGridByTransform(const FTransform& OriginTransform, TArray<FCell>& OutGrid)
 {
 	const FVector LevelLocation = OriginTransform.GetLocation();
 	const FVector LevelScale = OriginTransform.GetScale3D();
 	const FIntPoint LevelSize(LevelScale.X, LevelScale.Y);
 
-	FCells GridCells;
-	GridCells.Reserve(LevelSize.X * LevelSize.Y);
+	OutGrid.Reset(LevelSize.X * LevelSize.Y);
+	if (LevelSize.X <= 0
+	    || LevelSize.Y <= 0)
+	{
+		return;
+	}
+
+	// Next cells are offsets of the first one by whole cells, so they are snapped as well
+	const FCell FirstCell = GetUnrotatedFirstCellByTransform(OriginTransform);
+
+	// Columns and rows of the grid are rotated once around its origin
+	const CellRotation::FBasis Basis(1.f, OriginTransform);
+	const VectorRegister4Double FirstLocation = Basis.RotateLocation(FirstCell.Location);
+	const VectorRegister4Double ColumnStep = Basis.RotateOffset(MakeVectorRegisterDouble(static_cast<double>(CellSize), 0.0, 0.0, 0.0));
+	const VectorRegister4Double RowStep = Basis.RotateOffset(MakeVectorRegisterDouble(0.0, static_cast<double>(CellSize), 0.0, 0.0));
+
+	OutGrid.SetNumUninitialized(LevelSize.X * LevelSize.Y);
+	FCell* GridData = OutGrid.GetData();
 	for (int32 Y = 0; Y < LevelSize.Y; ++Y)
 	{
+		const VectorRegister4Double RowLocation = VectorMultiplyAdd(VectorSetFloat1(static_cast<double>(Y)), RowStep, FirstLocation);
 		for (int32 X = 0; X < LevelSize.X; ++X)
 		{
-			FVector FoundVector(X, Y, 0.f);
-			// Calculate a length of iteration cell
-			FoundVector *= CellSize;
-			// Locate the cell relative to the Generated Map
-			FoundVector += LevelLocation;
-			// Subtract the deviation from the center
-			FoundVector -= (LevelScale / 2.f) * CellSize;
-			// Snap to the cell
-			const FCell SnappedCell = SnapCell(FoundVector);
-			// Cell was found, add rotated cell to the array
-			FCell RotatedCell = RotateCellAroundOrigin(SnappedCell, 1.f, OriginTransform);
-
-			GridCells.Emplace(MoveTemp(RotatedCell));
+			const VectorRegister4Double CellLocation = VectorMultiplyAdd(VectorSetFloat1(static_cast<double>(X)), ColumnStep, RowLocation);
+			GridData[Y * LevelSize.X + X] = CellRotation::MakeCell(CellLocation);
 		}
 	}
+}
 
-	return MoveTemp(GridCells);
+// Returns the first cell (column 0, row 0) of the grid constructed from given transform before the grid is rotated around its origin
+FCell FCell::GetUnrotatedFirstCellByTransform(const FTransform& OriginTransform)
+{
+	// The first cell is located relative to the Generated Map without the deviation from the center and snapped
+	return SnapCell(OriginTransform.GetLocation() - (OriginTransform.GetScale3D() / 2.f) * CellSize);
+}
+
+// Moves all cells of given row-major grid by the same offset in place
+void FCell::TranslateCellGrid(TArrayView<FCell> InOutGrid, const FVector& Offset)
+{
+	for (FCell& CellIt : InOutGrid)
+	{
+		CellIt = FCell(CellIt.Location + Offset);
+	}
 }
 
 // Returns the cell by specified column (X) and row (Y) on given grid if exists, invalid cell otherwise
@@ -155,43 +313,103 @@ FCell FCell::GetCellByPositionOnGrid(const FIntPoint& CellPosition, const FCells
 {
 	const int32 MaxWidth = FMath::FloorToInt32(GetCellArrayWidth(InGrid));
 	const int32 CellIndex = CellPosition.Y/*Row*/ * MaxWidth/*ColumnsNum*/ + CellPosition.X/*Column*/;
-	const TArray<FCell>& GridArray = InGrid.Array();
-	return GridArray.IsValidIndex(CellIndex) ? GridArray[CellIndex] : InvalidCell;
+	if (CellIndex < 0
+	    || CellIndex >= InGrid.Num())
+	{
+		return InvalidCell;
+	}
+
+	// The set is iterated in the same order as its array, so the array is not copied
+	int32 Index = 0;
+	for (const FCell& CellIt : InGrid)
+	{
+		if (Index++ == CellIndex)
+		{
+			return CellIt;
+		}
+	}
+	return InvalidCell;
+}
+
+// Returns the cell by specified column (X) and row (Y) on given row-major grid of known width in O(1), invalid cell otherwise
+FCell FCell::GetCellByPositionOnGrid(const FIntPoint& CellPosition, TConstArrayView<FCell> InGrid, int32 GridWidth)
+{
+	const int32 CellIndex = CellPosition.Y/*Row*/ * GridWidth/*ColumnsNum*/ + CellPosition.X/*Column*/;
+	return InGrid.IsValidIndex(CellIndex) ? InGrid[CellIndex] : InvalidCell;
 }
 
 // Takes the cell and returns its column (X) and row (Y) position on given grid if exists, -1 otherwise
 FIntPoint FCell::GetPositionByCellOnGrid(const FCell& InCell, const FCells& InGrid)
 {
 	const int32 MaxWidth = GetCellArrayWidth(InGrid);
-	const int32 CellIdx = InGrid.Array().IndexOfByPredicate([&InCell](const FCell& CellIt) { return CellIt == InCell; });
+	int32 CellIdx = INDEX_NONE;
+	int32 Index = 0;
+	for (const FCell& CellIt : InGrid)
+	{
+		if (CellIt == InCell)
+		{
+			CellIdx = Index;
+			break;
+		}
+		++Index;
+	}
+
 	const bool bFound = CellIdx != INDEX_NONE && MaxWidth > 0;
 	return FIntPoint(
 		bFound ? CellIdx % MaxWidth : INDEX_NONE,  // Column
 		bFound ? CellIdx / MaxWidth : INDEX_NONE); // Row
 }
 
+// Takes the cell and returns its column (X) and row (Y) position on given row-major grid of known width if exists, -1 otherwise
+FIntPoint FCell::GetPositionByCellOnGrid(const FCell& InCell, TConstArrayView<FCell> InGrid, int32 GridWidth)
+{
+	const int32 CellIdx = InGrid.IndexOfByKey(InCell);
+	const bool bFound = CellIdx != INDEX_NONE && GridWidth > 0;
+	return FIntPoint(
+		bFound ? CellIdx % GridWidth : INDEX_NONE,  // Column
+		bFound ? CellIdx / GridWidth : INDEX_NONE); // Row
+}
+
 // Returns the center column (X) and row (Y) position on given grid
 FIntPoint FCell::GetCenterCellPositionOnGrid(const FCells& InGrid)
 {
+	const FVector2D GridSize = GetCellArraySize(InGrid);
 	return FIntPoint(
-		FMath::FloorToInt32(GetCellArrayWidth(InGrid) / 2.f),
-		FMath::FloorToInt32(GetCellArrayLength(InGrid) / 2.f));
+		FMath::FloorToInt32(GridSize.X / 2.f),
+		FMath::FloorToInt32(GridSize.Y / 2.f));
 }
 
 // Returns 4 corner cells on given cells grid
 FCells FCell::GetCornerCellsOnGrid(const FCells& InGrid)
+{
+	// The grid is copied and measured once for all corners
+	const TArray<FCell> GridArray = InGrid.Array();
+	const int32 GridWidth = FMath::FloorToInt32(GetCellArrayWidth(InGrid));
+	return GetCornerCellsOnGrid(GridArray, GridWidth);
+}
+
+// Returns 4 corner cells on given row-major grid of known width
+FCells FCell::GetCornerCellsOnGrid(TConstArrayView<FCell> InGrid, int32 GridWidth)
 {
 	return FCells
 	{
-		GetCellByCornerOnGrid(EGridCorner::TopLeft, InGrid),
-		GetCellByCornerOnGrid(EGridCorner::TopRight, InGrid),
-		GetCellByCornerOnGrid(EGridCorner::BottomLeft, InGrid),
-		GetCellByCornerOnGrid(EGridCorner::BottomRight, InGrid)
+		GetCellByCornerOnGrid(EGridCorner::TopLeft, InGrid, GridWidth),
+		GetCellByCornerOnGrid(EGridCorner::TopRight, InGrid, GridWidth),
+		GetCellByCornerOnGrid(EGridCorner::BottomLeft, InGrid, GridWidth),
+		GetCellByCornerOnGrid(EGridCorner::BottomRight, InGrid, GridWidth)
 	};
 }
 
 // Returns specified corner cell in given grid
 FCell FCell::GetCellByCornerOnGrid(EGridCorner CornerType, const FCells& InGrid)
+{
+	const TArray<FCell> GridArray = InGrid.Array();
+	const int32 GridWidth = FMath::FloorToInt32(GetCellArrayWidth(InGrid));
+	return GetCellByCornerOnGrid(CornerType, GridArray, GridWidth);
+}
+
+// Returns specified corner cell in given row-major grid of known width
+FCell FCell::GetCellByCornerOnGrid(EGridCorner CornerType, TConstArrayView<FCell> InGrid, int32 GridWidth)
 {
 	// +---+---+---+
 	// | X |   | X |
@@ -201,20 +419,25 @@ FCell FCell::GetCellByCornerOnGrid(EGridCorner CornerType, const FCells& InGrid)
 	// | X |   | X |
 	// +---+---+---+
 
+	if (GridWidth <= 0)
+	{
+		return InvalidCell;
+	}
+
 	constexpr int32 FirstCellIndex = 0;
-	const int32 LastColumnIndex = GetCellArrayWidth(InGrid) - 1;
-	const int32 LastRowIndex = GetCellArrayLength(InGrid) - 1;
+	const int32 LastColumnIndex = GridWidth - 1;
+	const int32 LastRowIndex = InGrid.Num() / GridWidth - 1;
 
 	switch (CornerType)
 	{
 		case EGridCorner::TopLeft:
-			return GetCellByPositionOnGrid(FIntPoint(FirstCellIndex, FirstCellIndex), InGrid);
+			return GetCellByPositionOnGrid(FIntPoint(FirstCellIndex, FirstCellIndex), InGrid, GridWidth);
 		case EGridCorner::TopRight:
-			return GetCellByPositionOnGrid(FIntPoint(LastColumnIndex, FirstCellIndex), InGrid);
+			return GetCellByPositionOnGrid(FIntPoint(LastColumnIndex, FirstCellIndex), InGrid, GridWidth);
 		case EGridCorner::BottomLeft:
-			return GetCellByPositionOnGrid(FIntPoint(FirstCellIndex, LastRowIndex), InGrid);
+			return GetCellByPositionOnGrid(FIntPoint(FirstCellIndex, LastRowIndex), InGrid, GridWidth);
 		case EGridCorner::BottomRight:
-			return GetCellByPositionOnGrid(FIntPoint(LastColumnIndex, LastRowIndex), InGrid);
+			return GetCellByPositionOnGrid(FIntPoint(LastColumnIndex, LastRowIndex), InGrid, GridWidth);
 		default:
 			return InvalidCell;
 	}
@@ -264,6 +487,32 @@ FTransform FCell::GetCellArrayTransformNoScale(const FCells& InCells)
 	return MoveTemp(OriginTransform);
 }
 
+// Makes origin transform without scale for given row-major grid
+FTransform FCell::GetGridTransformNoScale(TConstArrayView<FCell> InGrid)
+{
+	FTransform OriginTransform = FTransform::Identity;
+	if (InGrid.IsEmpty())
+	{
+		return MoveTemp(OriginTransform);
+	}
+
+	// The center is the average of all cells the same as for the set
+	FVector Sum = FVector::ZeroVector;
+	for (const FCell& CellIt : InGrid)
+	{
+		Sum += CellIt.Location;
+	}
+	OriginTransform.SetLocation(FCell(Sum / static_cast<float>(InGrid.Num())));
+
+	// The rotation is the direction between first two cells, the set is iterated in the same order
+	if (InGrid.Num() >= 2)
+	{
+		const FVector Direction = InGrid[1] - InGrid[0];
+		OriginTransform.SetRotation(Direction.Rotation().Quaternion());
+	}
+	return MoveTemp(OriginTransform);
+}
+
 // Find the average of an array of vectors
 FCell FCell::GetCellArrayCenter(const FCells& Cells)
 {
@@ -300,25 +549,38 @@ FRotator FCell::GetCellArrayRotation(const FCells& InCells)
 // Returns the width (columns X) and the length (rows Y) in specified cells, where each 1 unit means 1 cell
 FVector2D FCell::GetCellArraySize(const FCells& InCells)
 {
-	const float WidthX = GetCellArrayWidth(InCells);
-	const float LengthY = GetCellArrayLength(InCells);
-	return FVector2D(WidthX, LengthY);
+	const FVector CellsBoxSize = GetCellArrayUnrotatedBox(InCells).GetSize();
+	return FVector2D(CellsBoxSize.X / CellSize + 1.f, CellsBoxSize.Y / CellSize + 1.f);
 }
 
 // Returns number of columns (X) in specified cells array, where each 1 unit means 1 cell
 float FCell::GetCellArrayWidth(const FCells& InCells)
 {
-	const FCells UnrotatedCells = RotateCellArray(-1.f, InCells);
-	const FBox CellsBox(CellsToVectors(UnrotatedCells));
-	return CellsBox.GetSize().X / CellSize + 1.f;
+	return GetCellArrayUnrotatedBox(InCells).GetSize().X / CellSize + 1.f;
 }
 
 // Returns number of rows (Y) in specified cells array, where each 1 unit means 1 cell
 float FCell::GetCellArrayLength(const FCells& InCells)
 {
-	const FCells UnrotatedCells = RotateCellArray(-1.f, InCells);
-	const FBox CellsBox(CellsToVectors(UnrotatedCells));
-	return CellsBox.GetSize().Y / CellSize + 1.f;
+	return GetCellArrayUnrotatedBox(InCells).GetSize().Y / CellSize + 1.f;
+}
+
+// Returns the bounding box of given cells when their grid is unrotated, cells are rotated one by one without copying the set
+FBox FCell::GetCellArrayUnrotatedBox(const FCells& InCells)
+{
+	FBox CellsBox(ForceInit);
+	if (InCells.IsEmpty())
+	{
+		// Is the same as the box of no vectors
+		return CellsBox;
+	}
+
+	const CellRotation::FBasis Basis(-1.f, GetCellArrayTransformNoScale(InCells));
+	for (const FCell& CellIt : InCells)
+	{
+		CellsBox += SnapCell(CellRotation::MakeCell(Basis.RotateLocation(CellIt.Location))).Location;
+	}
+	return CellsBox;
 }
 
 // Sums cells
@@ -398,3 +660,37 @@ FCells FCell::VectorsToCells(const TArray<FVector>& Vectors)
 	}
 	return MoveTemp(Cells);
 }
+
+// Writes integral components as packed integers instead of three doubles
+bool FCell::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	auto IsIntegral = [](double Value)
+	{
+		return Value == FMath::RoundToDouble(Value)
+		       && FMath::Abs(Value) < static_cast<double>(MAX_int32 >> 1);
+	};
+
+	uint8 bIsIntegral = IsIntegral(Location.X) && IsIntegral(Location.Y) && IsIntegral(Location.Z);
+	Ar.SerializeBits(&bIsIntegral, 1);
+
+	if (!bIsIntegral)
+	{
+		Ar << Location;
+		bOutSuccess = true;
+		return true;
+	}
+
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		// Zigzag encoding keeps small negative values small
+		uint32 Packed = FZigzag::Encode(FMath::RoundToInt32(Location[Axis]));
+		Ar.SerializeIntPacked(Packed);
+		if (Ar.IsLoading())
+		{
+			Location[Axis] = static_cast<double>(FZigzag::Decode(Packed));
+		}
+	}
+
+	bOutSuccess = true;
+	return true;
+}
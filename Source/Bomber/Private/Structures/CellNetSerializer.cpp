@@ -0,0 +1,192 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/CellNetSerializer.h"
+//---
+#include "Bomber.h"
+#include "Structures/Cell.h"
+//---
+#if UE_WITH_IRIS
+#include "Iris/ReplicationState/PropertyNetSerializerInfoRegistry.h"
+#include "Iris/Serialization/NetBitStreamReader.h"
+#include "Iris/Serialization/NetBitStreamWriter.h"
+#include "Iris/Serialization/NetSerializerDelegates.h"
+#endif // UE_WITH_IRIS
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CellNetSerializer)
+
+#if UE_WITH_IRIS
+namespace UE::Net
+{
+	struct FCellNetSerializer
+	{
+		static constexpr uint32 Version = 0;
+
+		/** Is the same as the source, since cells are already rounded. */
+		struct FQuantizedType
+		{
+			double Location[3];
+		};
+
+		typedef FCell SourceType;
+		typedef FQuantizedType QuantizedType;
+		typedef FCellNetSerializerConfig ConfigType;
+		static const ConfigType DefaultConfig;
+
+		static void Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args);
+		static void Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args);
+
+		static void Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args);
+		static void Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args);
+
+		static bool IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args);
+
+	private:
+		/** Bits to write the number of significant bits of a packed component. */
+		static constexpr uint32 BitCountBitsNum = 6;
+
+		/** Returns true if given component could be sent as a packed integer. */
+		static bool IsIntegral(double Value);
+
+		/** Writes and reads a double as two 32-bit words. */
+		static void WriteDouble(FNetBitStreamWriter& Writer, double Value);
+		static double ReadDouble(FNetBitStreamReader& Reader);
+	};
+
+	const FCellNetSerializer::ConfigType FCellNetSerializer::DefaultConfig;
+
+	UE_NET_IMPLEMENT_SERIALIZER(FCellNetSerializer);
+
+	// Writes integral components as zigzag-encoded integers of the minimal bit count
+	void FCellNetSerializer::Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args)
+	{
+		const QuantizedType& Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+		FNetBitStreamWriter& Writer = *Context.GetBitStreamWriter();
+
+		const bool bIsIntegral = IsIntegral(Value.Location[0]) && IsIntegral(Value.Location[1]) && IsIntegral(Value.Location[2]);
+		Writer.WriteBool(bIsIntegral);
+
+		for (const double Component : Value.Location)
+		{
+			if (!bIsIntegral)
+			{
+				WriteDouble(Writer, Component);
+				continue;
+			}
+
+			// Zigzag encoding keeps small negative values small
+			const uint32 Packed = FZigzag::Encode(FMath::RoundToInt32(Component));
+			const uint32 BitCount = Packed ? FMath::FloorLog2(Packed) + 1 : 0;
+			Writer.WriteBits(BitCount, BitCountBitsNum);
+			if (BitCount)
+			{
+				Writer.WriteBits(Packed, BitCount);
+			}
+		}
+	}
+
+	// Reads components written by Serialize
+	void FCellNetSerializer::Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args)
+	{
+		QuantizedType& Target = *reinterpret_cast<QuantizedType*>(Args.Target);
+		FNetBitStreamReader& Reader = *Context.GetBitStreamReader();
+
+		const bool bIsIntegral = Reader.ReadBool();
+
+		for (double& Component : Target.Location)
+		{
+			if (!bIsIntegral)
+			{
+				Component = ReadDouble(Reader);
+				continue;
+			}
+
+			const uint32 BitCount = Reader.ReadBits(BitCountBitsNum);
+			const uint32 Packed = BitCount ? Reader.ReadBits(BitCount) : 0;
+			Component = static_cast<double>(FZigzag::Decode(Packed));
+		}
+	}
+
+	// Copies the location of the cell into the quantized state
+	void FCellNetSerializer::Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args)
+	{
+		const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+		QuantizedType& Target = *reinterpret_cast<QuantizedType*>(Args.Target);
+
+		Target.Location[0] = Source.Location.X;
+		Target.Location[1] = Source.Location.Y;
+		Target.Location[2] = Source.Location.Z;
+	}
+
+	// Copies the quantized state back into the location of the cell
+	void FCellNetSerializer::Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args)
+	{
+		const QuantizedType& Source = *reinterpret_cast<const QuantizedType*>(Args.Source);
+		SourceType& Target = *reinterpret_cast<SourceType*>(Args.Target);
+
+		Target.Location = FVector(Source.Location[0], Source.Location[1], Source.Location[2]);
+	}
+
+	// Returns true if both cells are the same, so the cell is not sent
+	bool FCellNetSerializer::IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args)
+	{
+		if (Args.bStateIsQuantized)
+		{
+			const QuantizedType& Value0 = *reinterpret_cast<const QuantizedType*>(Args.Source0);
+			const QuantizedType& Value1 = *reinterpret_cast<const QuantizedType*>(Args.Source1);
+			return FMemory::Memcmp(&Value0, &Value1, sizeof(QuantizedType)) == 0;
+		}
+
+		const SourceType& Value0 = *reinterpret_cast<const SourceType*>(Args.Source0);
+		const SourceType& Value1 = *reinterpret_cast<const SourceType*>(Args.Source1);
+		return Value0 == Value1;
+	}
+
+	// Returns true if given component could be sent as a packed integer
+	bool FCellNetSerializer::IsIntegral(double Value)
+	{
+		return Value == FMath::RoundToDouble(Value)
+		       && FMath::Abs(Value) < static_cast<double>(MAX_int32 >> 1);
+	}
+
+	// Writes a double as two 32-bit words
+	void FCellNetSerializer::WriteDouble(FNetBitStreamWriter& Writer, double Value)
+	{
+		const uint64 Bits = BitCast<uint64>(Value);
+		Writer.WriteBits(static_cast<uint32>(Bits), 32);
+		Writer.WriteBits(static_cast<uint32>(Bits >> 32), 32);
+	}
+
+	// Reads a double written by WriteDouble
+	double FCellNetSerializer::ReadDouble(FNetBitStreamReader& Reader)
+	{
+		const uint64 LowBits = Reader.ReadBits(32);
+		const uint64 HighBits = Reader.ReadBits(32);
+		return BitCast<double>(LowBits | HighBits << 32);
+	}
+
+	/*********************************************************************************************
+	 * Registration of the serializer for all replicated FCell properties
+	 ********************************************************************************************* */
+
+	static const FName PropertyNetSerializerRegistry_NAME_Cell("Cell");
+	UE_NET_IMPLEMENT_NAMED_STRUCT_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_Cell, FCellNetSerializer);
+
+	/** Replaces the legacy FCell::NetSerialize by FCellNetSerializer once Iris freezes its registry. */
+	class FCellNetSerializerRegistryDelegates final : private FNetSerializerRegistryDelegates
+	{
+	public:
+		virtual ~FCellNetSerializerRegistryDelegates() override
+		{
+			UE_NET_UNREGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_Cell);
+		}
+
+	private:
+		virtual void OnPreFreezeNetSerializerRegistry() override
+		{
+			UE_NET_REGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_Cell);
+		}
+	};
+
+	static FCellNetSerializerRegistryDelegates CellNetSerializerRegistryDelegates;
+}
+#endif // UE_WITH_IRIS
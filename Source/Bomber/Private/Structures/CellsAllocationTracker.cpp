@@ -0,0 +1,142 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/CellsAllocationTracker.h"
+//---
+#include "Bomber.h"
+//---
+#include "HAL/IConsoleManager.h"
+
+LLM_DEFINE_TAG(Bomber_Cells);
+
+// Counts cells that are returned by value from the grid API
+static TAutoConsoleVariable<bool> CVarTrackCellsAllocations(
+	TEXT("Bomber.Cells.TrackAllocations"),
+	false,
+	TEXT("Count cells that are returned by value from the grid API: 1 (Track) OR 0 (Do not track)"),
+	ECVF_Default);
+
+namespace CellsAllocationTracker
+{
+/** Counters of one function during one second. */
+struct FCounters
+{
+	int32 Calls = 0;
+	int32 AllocatingCalls = 0;
+	int32 Allocations = 0;
+	int64 AllocatedBytes = 0;
+	int64 Cells = 0;
+};
+
+/** Counters of all functions during one second. */
+struct FSecondBucket
+{
+	int64 Second = INDEX_NONE;
+	FCounters Counters[static_cast<int32>(ECellsAllocationSource::Num)];
+};
+
+/** Ring of the last seconds, where each bucket is taken by the second modulo its size. */
+static FSecondBucket Buckets[FCellsAllocationTracker::MaxTrackedSeconds];
+
+/** Names of functions by their source. */
+static const TCHAR* SourceNames[] = {
+	TEXT("GetCellsAround"),
+	TEXT("FilterCellsByActors"),
+	TEXT("GetAllCellsWithActors"),
+	TEXT("GetExplosionCells"),
+	TEXT("RotateCellArray"),
+	TEXT("Conv_CellMaskToCells")
+};
+static_assert(UE_ARRAY_COUNT(SourceNames) == static_cast<int32>(ECellsAllocationSource::Num), "Each source has to be named");
+}
+
+// Returns true if returned cells are counted
+bool FCellsAllocationTracker::IsEnabled()
+{
+	return CVarTrackCellsAllocations.GetValueOnAnyThread();
+}
+
+// Counts the returned cells of given function with heap blocks and bytes they own, is ignored outside of the game thread
+void FCellsAllocationTracker::AddResult(ECellsAllocationSource Source, const FCells& Cells)
+{
+	if (!IsInGameThread())
+	{
+		return;
+	}
+
+	using namespace CellsAllocationTracker;
+	const int64 Second = static_cast<int64>(FPlatformTime::Seconds());
+	FSecondBucket& Bucket = Buckets[Second % MaxTrackedSeconds];
+	if (Bucket.Second != Second)
+	{
+		// Is the bucket of the older second, start it from scratch
+		Bucket = FSecondBucket();
+		Bucket.Second = Second;
+	}
+
+	const int32 AllocationsNum = GetHeapAllocationsNum(Cells);
+	FCounters& Counters = Bucket.Counters[static_cast<int32>(Source)];
+	++Counters.Calls;
+	Counters.AllocatingCalls += AllocationsNum > 0 ? 1 : 0;
+	Counters.Allocations += AllocationsNum;
+	Counters.AllocatedBytes += static_cast<int64>(Cells.GetAllocatedSize());
+	Counters.Cells += Cells.Num();
+}
+
+// Returns the number of heap blocks owned by given set according to the default set allocator
+int32 FCellsAllocationTracker::GetHeapAllocationsNum(const FCells& Cells)
+{
+	// Elements are always on the heap, allocation flags are inline for the first 4 words of bits
+	const int32 MaxElementsNum = Cells.GetMaxIndex();
+	constexpr int32 InlineFlagsNum = 4 * NumBitsPerDWORD;
+	int32 AllocationsNum = MaxElementsNum > 0 ? 1 : 0;
+	AllocationsNum += MaxElementsNum > InlineFlagsNum ? 1 : 0;
+
+	// Only one hash bucket is inline
+	const uint32 HashBucketsNum = FDefaultSetAllocator::GetNumberOfHashBuckets(static_cast<uint32>(MaxElementsNum));
+	AllocationsNum += HashBucketsNum > 1 ? 1 : 0;
+	return AllocationsNum;
+}
+
+// Logs the number of calls, allocating calls and cells of each function during the last given seconds
+void FCellsAllocationTracker::Dump(int32 Seconds)
+{
+	using namespace CellsAllocationTracker;
+	Seconds = FMath::Clamp(Seconds, 1, MaxTrackedSeconds);
+	const int64 CurrentSecond = static_cast<int64>(FPlatformTime::Seconds());
+
+	FCounters Totals[static_cast<int32>(ECellsAllocationSource::Num)];
+	for (const FSecondBucket& BucketIt : Buckets)
+	{
+		if (BucketIt.Second == INDEX_NONE
+		    || CurrentSecond - BucketIt.Second >= Seconds)
+		{
+			continue;
+		}
+
+		for (int32 SourceIndex = 0; SourceIndex < static_cast<int32>(ECellsAllocationSource::Num); ++SourceIndex)
+		{
+			Totals[SourceIndex].Calls += BucketIt.Counters[SourceIndex].Calls;
+			Totals[SourceIndex].AllocatingCalls += BucketIt.Counters[SourceIndex].AllocatingCalls;
+			Totals[SourceIndex].Allocations += BucketIt.Counters[SourceIndex].Allocations;
+			Totals[SourceIndex].AllocatedBytes += BucketIt.Counters[SourceIndex].AllocatedBytes;
+			Totals[SourceIndex].Cells += BucketIt.Counters[SourceIndex].Cells;
+		}
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Cells allocations during the last %i seconds%s:"), Seconds, IsEnabled() ? TEXT("") : TEXT(" (tracking is disabled by Bomber.Cells.TrackAllocations)"));
+	for (int32 SourceIndex = 0; SourceIndex < static_cast<int32>(ECellsAllocationSource::Num); ++SourceIndex)
+	{
+		const FCounters& Counters = Totals[SourceIndex];
+		UE_LOG(LogBomber, Log, TEXT("\t%s: %i calls, %i allocating calls, %i allocations (%.1f per second), %lld bytes, %lld cells"),
+		       SourceNames[SourceIndex], Counters.Calls, Counters.AllocatingCalls, Counters.Allocations, static_cast<float>(Counters.Allocations) / Seconds, Counters.AllocatedBytes, Counters.Cells);
+	}
+}
+
+static FAutoConsoleCommand DumpCellsAllocationsCommand(
+	TEXT("Bomber.Cells.DumpAllocations"),
+	TEXT("Logs cells returned by value from the grid API during the last seconds, 10 by default: Bomber.Cells.DumpAllocations [Seconds]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		constexpr int32 DefaultSeconds = 10;
+		FCellsAllocationTracker::Dump(Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : DefaultSeconds);
+	}));
@@ -0,0 +1,93 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/CellsBitboard.h"
+
+// Creates bitboard for specified number of cells where each bit is set to given value
+FCellsBitboard::FCellsBitboard(int32 InCellsNum, bool bValue/* = false*/)
+{
+	Init(InCellsNum, bValue);
+}
+
+// Returns the lowest contained cell index in given inclusive range, INDEX_NONE if there is no such cell
+int32 FCellsBitboard::FindFirstSetBit(int32 StartIndex, int32 EndIndex) const
+{
+	StartIndex = FMath::Max(StartIndex, 0);
+	EndIndex = FMath::Min(EndIndex, Bits.Num() - 1);
+	if (StartIndex > EndIndex)
+	{
+		return INDEX_NONE;
+	}
+
+	const uint32* Words = Bits.GetData();
+	const int32 LastWordIndex = EndIndex / NumBitsPerDWORD;
+	int32 WordIndex = StartIndex / NumBitsPerDWORD;
+	uint32 Word = Words[WordIndex] & (MAX_uint32 << (StartIndex % NumBitsPerDWORD));
+	while (WordIndex < LastWordIndex)
+	{
+		if (Word)
+		{
+			return WordIndex * NumBitsPerDWORD + FMath::CountTrailingZeros(Word);
+		}
+		Word = Words[++WordIndex];
+	}
+
+	// Bits after the end of the range are not taken
+	Word &= MAX_uint32 >> (NumBitsPerDWORD - 1 - EndIndex % NumBitsPerDWORD);
+	return Word ? WordIndex * NumBitsPerDWORD + FMath::CountTrailingZeros(Word) : INDEX_NONE;
+}
+
+// Returns the highest contained cell index in given inclusive range, INDEX_NONE if there is no such cell
+int32 FCellsBitboard::FindLastSetBit(int32 StartIndex, int32 EndIndex) const
+{
+	StartIndex = FMath::Max(StartIndex, 0);
+	EndIndex = FMath::Min(EndIndex, Bits.Num() - 1);
+	if (StartIndex > EndIndex)
+	{
+		return INDEX_NONE;
+	}
+
+	const uint32* Words = Bits.GetData();
+	const int32 FirstWordIndex = StartIndex / NumBitsPerDWORD;
+	int32 WordIndex = EndIndex / NumBitsPerDWORD;
+	uint32 Word = Words[WordIndex] & (MAX_uint32 >> (NumBitsPerDWORD - 1 - EndIndex % NumBitsPerDWORD));
+	while (WordIndex > FirstWordIndex)
+	{
+		if (Word)
+		{
+			return WordIndex * NumBitsPerDWORD + FMath::FloorLog2(Word);
+		}
+		Word = Words[--WordIndex];
+	}
+
+	// Bits before the start of the range are not taken
+	Word &= MAX_uint32 << (StartIndex % NumBitsPerDWORD);
+	return Word ? WordIndex * NumBitsPerDWORD + FMath::FloorLog2(Word) : INDEX_NONE;
+}
+
+// Union of bitboards
+FCellsBitboard& FCellsBitboard::operator|=(const FCellsBitboard& Other)
+{
+	Bits.CombineWithBitwiseOR(Other.Bits, EBitwiseOperatorFlags::MaxSize);
+	return *this;
+}
+
+// Intersection of bitboards
+FCellsBitboard& FCellsBitboard::operator&=(const FCellsBitboard& Other)
+{
+	Bits.CombineWithBitwiseAND(Other.Bits, EBitwiseOperatorFlags::MinSize);
+	return *this;
+}
+
+// Difference of bitboards, so cells contained in other bitboard are removed from this one
+FCellsBitboard& FCellsBitboard::Subtract(const FCellsBitboard& Other)
+{
+	const int32 MaxIndex = Bits.Num();
+	Other.ForEachSetBit([this, MaxIndex](int32 CellIndex)
+	{
+		if (CellIndex < MaxIndex)
+		{
+			Bits[CellIndex] = false;
+		}
+	});
+	return *this;
+}
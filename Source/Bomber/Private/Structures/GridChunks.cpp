@@ -0,0 +1,79 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/GridChunks.h"
+
+static_assert(FGridChunks::ChunkSize * FGridChunks::ChunkSize == 64, "All cells of the chunk have to fit one 64-bit word");
+
+// Resets all chunks to empty ones by given number of columns (X) and rows (Y) of the grid
+void FGridChunks::Init(const FIntPoint& InGridSize)
+{
+	GridSize = InGridSize.ComponentMax(FIntPoint::ZeroValue);
+	ChunksSize = FIntPoint(FMath::DivideAndRoundUp(GridSize.X, ChunkSize), FMath::DivideAndRoundUp(GridSize.Y, ChunkSize));
+	ChunkBits.Init(0, Num() * ActorTypesNum);
+}
+
+// Returns the chunk coordinate of given row-major cell index
+FIntPoint FGridChunks::GetChunkCoord(int32 CellIndex) const
+{
+	if (CellIndex < 0
+	    || CellIndex >= GridSize.X * GridSize.Y)
+	{
+		return FIntPoint::NoneValue;
+	}
+
+	return FIntPoint(CellIndex % GridSize.X / ChunkSize, CellIndex / GridSize.X / ChunkSize);
+}
+
+// Returns the row-major chunk index of given row-major cell index
+int32 FGridChunks::GetChunkIndex(int32 CellIndex) const
+{
+	const FIntPoint ChunkCoord = GetChunkCoord(CellIndex);
+	return ChunkCoord != FIntPoint::NoneValue ? ChunkCoord.Y * ChunksSize.X + ChunkCoord.X : INDEX_NONE;
+}
+
+// Sets the occupancy of given cell by specified EActorType bitmask
+void FGridChunks::SetCellActorTypes(int32 CellIndex, int32 ActorTypesBitmask)
+{
+	const int32 ChunkIndex = GetChunkIndex(CellIndex);
+	if (ChunkIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	const int32 LocalX = CellIndex % GridSize.X % ChunkSize;
+	const int32 LocalY = CellIndex / GridSize.X % ChunkSize;
+	const uint64 CellBit = 1ull << (LocalY * ChunkSize + LocalX);
+	uint64* TypeBits = &ChunkBits[ChunkIndex * ActorTypesNum];
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		if (ActorTypesBitmask & (1 << TypeIndex))
+		{
+			TypeBits[TypeIndex] |= CellBit;
+		}
+		else
+		{
+			TypeBits[TypeIndex] &= ~CellBit;
+		}
+	}
+}
+
+// Returns bits of cells of the chunk that have actors of specified types
+uint64 FGridChunks::GetChunkBits(int32 ChunkIndex, int32 ActorsTypesBitmask) const
+{
+	if (ChunkIndex < 0
+	    || ChunkIndex >= Num())
+	{
+		return 0;
+	}
+
+	uint64 Bits = 0;
+	const uint64* TypeBits = &ChunkBits[ChunkIndex * ActorTypesNum];
+	for (int32 TypeIndex = 0; TypeIndex < ActorTypesNum; ++TypeIndex)
+	{
+		if (ActorsTypesBitmask & (1 << TypeIndex))
+		{
+			Bits |= TypeBits[TypeIndex];
+		}
+	}
+	return Bits;
+}
@@ -0,0 +1,88 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/GridSpectatorStream.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GridSpectatorStream)
+
+// Is the maximum number of events sent in one batch, is much more than happens in one step
+static constexpr uint32 GridSpectatorMaxEvents = 1024;
+
+// Is the maximum number of players sent in one batch
+static constexpr uint32 GridSpectatorMaxPlayers = 64;
+
+// Packs steps as deltas and indices as shifted integers to be sent over network
+bool FGridSpectatorEvents::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 EventsNum = Events.Num();
+	Ar.SerializeIntPacked(EventsNum);
+	if (EventsNum > GridSpectatorMaxEvents)
+	{
+		bOutSuccess = false;
+		return false;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Events.SetNum(EventsNum);
+	}
+
+	// The first step is sent as it is, next ones as deltas since events are ordered
+	int64 PreviousStep = 0;
+	for (FGridReplayEvent& EventIt : Events)
+	{
+		uint64 StepDelta = static_cast<uint64>(EventIt.Step - PreviousStep);
+		uint8 TypeByte = static_cast<uint8>(EventIt.Type);
+		uint32 PackedCellIndex = static_cast<uint32>(EventIt.CellIndex + 1);
+		uint32 PackedValue = static_cast<uint32>(EventIt.Value + 1);
+
+		Ar.SerializeIntPacked64(StepDelta);
+		Ar << TypeByte;
+		Ar.SerializeIntPacked(PackedCellIndex);
+		Ar.SerializeIntPacked(PackedValue);
+		Ar << EventIt.Param;
+
+		EventIt.Step = PreviousStep + static_cast<int64>(StepDelta);
+		EventIt.Type = static_cast<EGridReplayEventType>(TypeByte);
+		EventIt.CellIndex = static_cast<int32>(PackedCellIndex) - 1;
+		EventIt.Value = static_cast<int32>(PackedValue) - 1;
+		PreviousStep = EventIt.Step;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+// Packs IDs and planar locations to be sent over network
+bool FGridSpectatorPlayers::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PlayersNum = Players.Num();
+	Ar.SerializeIntPacked(PlayersNum);
+	if (PlayersNum > GridSpectatorMaxPlayers)
+	{
+		bOutSuccess = false;
+		return false;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Players.SetNum(PlayersNum);
+	}
+
+	for (FGridSpectatorPlayer& PlayerIt : Players)
+	{
+		uint8 CharacterID = static_cast<uint8>(PlayerIt.CharacterID);
+		int32 X = FMath::RoundToInt32(PlayerIt.Location.X);
+		int32 Y = FMath::RoundToInt32(PlayerIt.Location.Y);
+
+		Ar << CharacterID;
+		Ar << X;
+		Ar << Y;
+
+		PlayerIt.CharacterID = CharacterID;
+		PlayerIt.Location.X = X;
+		PlayerIt.Location.Y = Y;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
@@ -0,0 +1,128 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/LevelLayout.h"
+//---
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// The extension of layout files
+const TCHAR* FLevelLayout::FileExtension = TEXT(".bomberlayout");
+
+// Returns true if the layout has a type for each cell of its size
+bool FLevelLayout::IsValid() const
+{
+	return Size.GetMin() > 0
+	       && ActorTypes.Num() == Size.X * Size.Y;
+}
+
+// Returns true if given value is none or only one of the actor types
+bool FLevelLayout::IsValidActorType(uint8 ActorType)
+{
+	return !(ActorType & ~TO_FLAG(EAT::All))
+	       && (ActorType & (ActorType - 1)) == 0;
+}
+
+// Writes or reads the layout, returns false if read data is not a valid layout
+bool FLevelLayout::Serialize(FArchive& Ar)
+{
+	uint32 FileMagic = Magic;
+	uint16 FileVersion = Version;
+	Ar << FileMagic;
+	Ar << FileVersion;
+	if (Ar.IsLoading()
+	    && (FileMagic != Magic || FileVersion != Version))
+	{
+		return false;
+	}
+
+	uint16 Columns = static_cast<uint16>(Size.X);
+	uint16 Rows = static_cast<uint16>(Size.Y);
+	uint8 LevelTypeValue = static_cast<uint8>(LevelType);
+	Ar << Columns;
+	Ar << Rows;
+	Ar << LevelTypeValue;
+	Ar << Seed;
+
+	if (Ar.IsSaving())
+	{
+		// Each run is the actor type followed by the number of its cells in a row, walls and empty cells usually go in long runs
+		for (int32 CellIndex = 0; CellIndex < ActorTypes.Num();)
+		{
+			uint8 RunType = ActorTypes[CellIndex];
+			uint8 RunLength = 0;
+			while (CellIndex < ActorTypes.Num()
+			       && ActorTypes[CellIndex] == RunType
+			       && RunLength < MAX_uint8)
+			{
+				++RunLength;
+				++CellIndex;
+			}
+			Ar << RunType;
+			Ar << RunLength;
+		}
+		return true;
+	}
+
+	// Both sides have to be unpaired (odd) as the level is generated, the number of cells is computed wide to never overflow
+	const int64 CellsNum64 = static_cast<int64>(Columns) * Rows;
+	if (Ar.IsError()
+	    || Columns % 2 == 0
+	    || Rows % 2 == 0
+	    || CellsNum64 > MAX_int32)
+	{
+		return false;
+	}
+
+	Size = FIntPoint(Columns, Rows);
+	LevelType = static_cast<ELevelType>(LevelTypeValue);
+	const int32 CellsNum = static_cast<int32>(CellsNum64);
+	ActorTypes.Reset(CellsNum);
+	while (ActorTypes.Num() < CellsNum
+	       && !Ar.AtEnd()
+	       && !Ar.IsError())
+	{
+		uint8 RunType = 0;
+		uint8 RunLength = 0;
+		Ar << RunType;
+		Ar << RunLength;
+		if (!RunLength
+		    || ActorTypes.Num() + RunLength > CellsNum
+		    || !IsValidActorType(RunType))
+		{
+			return false;
+		}
+
+		ActorTypes.SetNumUninitialized(ActorTypes.Num() + RunLength, /*bAllowShrinking*/false);
+		FMemory::Memset(&ActorTypes[ActorTypes.Num() - RunLength], RunType, RunLength);
+	}
+
+	return !Ar.IsError() && IsValid();
+}
+
+// Writes the layout to given file, returns false if is not written
+bool FLevelLayout::SaveToFile(const FString& FilePath)
+{
+	if (!ensureMsgf(IsValid(), TEXT("ASSERT: [%i] %s:\nThe layout is not valid, can't save it to '%s'!"), __LINE__, *FString(__FUNCTION__), *FilePath))
+	{
+		return false;
+	}
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	Serialize(Writer);
+	return FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+}
+
+// Reads the layout from given file by one bulk read, returns false if the file is missing or is not a valid layout
+bool FLevelLayout::LoadFromFile(const FString& FilePath)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	return Serialize(Reader);
+}
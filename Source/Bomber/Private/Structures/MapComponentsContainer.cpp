@@ -2,10 +2,31 @@
 
 #include "Structures/MapComponentsContainer.h"
 //---
+#include "GeneratedMap.h"
 #include "Components/MapComponent.h"
+#include "Engine/BomberNetStats.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+//---
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/PackageMapClient.h"
+//---
+#if UE_WITH_IRIS
+#include "Iris/ReplicationState/PropertyNetSerializerInfoRegistry.h"
+#include "Serialization/InternalNetSerializers.h"
+#endif // UE_WITH_IRIS
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MapComponentsContainer)
 
+#if UE_WITH_IRIS
+namespace UE::Net
+{
+	// Iris keeps calling FMapComponentSpec::NetSerialize, since it resolves the map component by the package map.
+	// The cell is sent fully there, because the Iris package map is not bound to the connection and its grid
+	UE_NET_IMPLEMENT_NAMED_STRUCT_LASTRESORT_NETSERIALIZER_AND_REGISTRY_DELEGATES(MapComponentSpec);
+}
+#endif // UE_WITH_IRIS
+
 bool operator==(const FMapComponentSpec& A, const FCell& B)
 {
 	const FCell& Cell = A.MapComponent ? A.MapComponent->GetCell() : FCell::InvalidCell;
@@ -22,12 +43,105 @@ FMapComponentSpec::FMapComponentSpec(FPoolObjectHandle InPoolObjectHandle)
 // Updates the cell of the map component according current data
 void FMapComponentSpec::UpdateCellInComponent()
 {
-	if (MapComponent)
+	if (MapComponent
+	    && Cell.IsValid())
 	{
 		MapComponent->SetCell(Cell);
 	}
 }
 
+// Writes the cell as its index on the grid and the actor type in few bits instead of the full cell
+bool FMapComponentSpec::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	if (Map)
+	{
+		UObject* Object = MapComponent;
+		bOutSuccess &= Map->SerializeObject(Ar, UMapComponent::StaticClass(), Object);
+		if (Ar.IsLoading())
+		{
+			MapComponent = Cast<UMapComponent>(Object);
+		}
+	}
+
+	// All actor types fit into 5 bits
+	static constexpr uint32 ActorTypeBitsNum = 5;
+	static_assert(TO_FLAG(EActorType::All) < (1 << ActorTypeBitsNum), "'ActorTypeBitsNum' is not enough to serialize all actor types");
+	uint8 ActorTypeBits = TO_FLAG(ActorType);
+	Ar.SerializeBits(&ActorTypeBits, ActorTypeBitsNum);
+
+	// The grid is replicated before map components, so the cell could be found by its index on the client, the map of the component owns the cell
+	UPackageMapClient* PackageMapClient = Cast<UPackageMapClient>(Map);
+	const UNetConnection* Connection = PackageMapClient ? PackageMapClient->GetConnection() : nullptr;
+	const UWorld* World = Connection && Connection->Driver ? Connection->Driver->GetWorld() : nullptr;
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = World ? UGeneratedMapSubsystem::GetGeneratedMapSubsystem(World) : nullptr;
+	const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMapByContext(MapComponent) : nullptr;
+
+	uint32 CellIndexPacked = 0; // 0 means the cell is not on the grid, otherwise is the index + 1
+	if (Ar.IsSaving())
+	{
+		const int32 CellIndex = GeneratedMap ? GeneratedMap->GetCellIndex(Cell) : INDEX_NONE;
+		CellIndexPacked = static_cast<uint32>(CellIndex + 1);
+	}
+	Ar.SerializeIntPacked(CellIndexPacked);
+
+	if (!CellIndexPacked)
+	{
+		// Invalid or not aligned cell is sent fully
+		bool bCellSuccess = true;
+		Cell.NetSerialize(Ar, Map, bCellSuccess);
+		bOutSuccess &= bCellSuccess;
+	}
+
+	if (Ar.IsLoading())
+	{
+		ActorType = static_cast<EActorType>(ActorTypeBits);
+		if (CellIndexPacked)
+		{
+			Cell = GeneratedMap ? GeneratedMap->GetCellByIndex(static_cast<int32>(CellIndexPacked) - 1) : FCell::InvalidCell;
+		}
+	}
+
+	return true;
+}
+
+void FMapComponentSpec::PreReplicatedRemove(const FMapComponentsContainer& InMapComponentsContainer)
+{
+	UpdateCellInComponent();
+	InMapComponentsContainer.MarkIndicesDirty();
+	InMapComponentsContainer.UpdateUnresolvedNum(*this, /*bIsRemoved*/true);
+
+	if (AGeneratedMap* GeneratedMap = InMapComponentsContainer.GetOwnerMap())
+	{
+		GeneratedMap->MirrorReplicatedSpec(*this, /*bIsRemoved*/true);
+	}
+}
+
+void FMapComponentSpec::PostReplicatedAdd(const FMapComponentsContainer& InMapComponentsContainer)
+{
+	UpdateCellInComponent();
+	InMapComponentsContainer.MarkIndicesDirty();
+	InMapComponentsContainer.UpdateUnresolvedNum(*this, /*bIsRemoved*/false);
+
+	if (AGeneratedMap* GeneratedMap = InMapComponentsContainer.GetOwnerMap())
+	{
+		GeneratedMap->MirrorReplicatedSpec(*this, /*bIsRemoved*/false);
+	}
+}
+
+void FMapComponentSpec::PostReplicatedChange(const FMapComponentsContainer& InMapComponentsContainer)
+{
+	UpdateCellInComponent();
+	InMapComponentsContainer.MarkIndicesDirty();
+	InMapComponentsContainer.UpdateUnresolvedNum(*this, /*bIsRemoved*/false);
+
+	if (AGeneratedMap* GeneratedMap = InMapComponentsContainer.GetOwnerMap())
+	{
+		GeneratedMap->MirrorReplicatedSpec(*this, /*bIsRemoved*/false);
+	}
+}
+
 FMapComponentsIterator::FMapComponentsIterator(const TArray<FMapComponentSpec>& InItems)
 	: Items(InItems)
 	, Index(0) {}
@@ -56,6 +170,44 @@ UMapComponent* FMapComponentsIterator::operator*() const
 	return Items[Index].MapComponent;
 }
 
+// Custom delta serialization for the map components array, measures the size of each delta when network profiling is enabled
+bool FMapComponentsContainer::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	if (!FBomberNetStats::IsEnabled())
+	{
+		return FastArrayDeltaSerialize<FMapComponentSpec, FMapComponentsContainer>(Items, DeltaParms, *this);
+	}
+
+	const int64 WriterBitsBefore = DeltaParms.Writer ? DeltaParms.Writer->GetNumBits() : 0;
+	const int64 ReaderBitsBefore = DeltaParms.Reader ? DeltaParms.Reader->GetPosBits() : 0;
+
+	const bool bResult = FastArrayDeltaSerialize<FMapComponentSpec, FMapComponentsContainer>(Items, DeltaParms, *this);
+
+	const int64 DeltaBits = DeltaParms.Writer ? DeltaParms.Writer->GetNumBits() - WriterBitsBefore
+		                        : DeltaParms.Reader ? DeltaParms.Reader->GetPosBits() - ReaderBitsBefore
+		                        : 0;
+	if (DeltaBits > 0)
+	{
+		FBomberNetStats::Add(EBomberNetSource::MapComponentsDelta, DeltaBits);
+	}
+
+	return bResult;
+}
+
+void FMapComponentsContainer::FindIndices(const FCell& Cell, TArray<int32, TInlineAllocator<4>>& OutIndices) const
+{
+	EnsureIndices();
+	for (TMultiMap<FCell, int32>::TConstKeyIterator It = CellIndices.CreateConstKeyIterator(Cell); It; ++It)
+	{
+		const int32 ItemIndex = It.Value();
+		if (Items.IsValidIndex(ItemIndex)
+		    && Items[ItemIndex] == Cell) // the cell of map component could be changed by replication
+		{
+			OutIndices.Emplace(ItemIndex);
+		}
+	}
+}
+
 FMapComponentSpec& FMapComponentsContainer::FindOrAdd(UMapComponent& MapComponent)
 {
 	if (FMapComponentSpec* FoundSpec = Find(&MapComponent))
@@ -63,8 +215,13 @@ FMapComponentSpec& FMapComponentsContainer::FindOrAdd(UMapComponent& MapComponen
 		return *FoundSpec;
 	}
 
-	FMapComponentSpec& AddedSpecRef = Items.Emplace_GetRef(MapComponent);
+	const int32 AddedIndex = Items.Emplace(MapComponent);
+	FMapComponentSpec& AddedSpecRef = Items[AddedIndex];
 	AddedSpecRef.Cell = MapComponent.GetCell();
+	AddedSpecRef.ActorType = MapComponent.GetActorType();
+	IndexedCells.SetNum(Items.Num());
+	AddIndices(AddedIndex);
+	++LayoutVersion;
 	MarkItemDirty(AddedSpecRef);
 	return AddedSpecRef;
 }
@@ -78,39 +235,251 @@ FMapComponentSpec& FMapComponentsContainer::FindOrAdd(const FPoolObjectHandle& P
 		return *FoundSpec;
 	}
 
-	FMapComponentSpec& AddedSpecRef = Items.Emplace_GetRef(PoolObjectHandle);
+	const int32 AddedIndex = Items.Emplace(PoolObjectHandle);
+	FMapComponentSpec& AddedSpecRef = Items[AddedIndex];
+	IndexedCells.SetNum(Items.Num());
+	AddIndices(AddedIndex);
+	++LayoutVersion;
 	MarkItemDirty(AddedSpecRef);
 	return AddedSpecRef;
 }
 
+void FMapComponentsContainer::SetMapComponent(FMapComponentSpec& InOutSpec, UMapComponent* MapComponent, const FCell& Cell)
+{
+	const int32 ItemIndex = static_cast<int32>(&InOutSpec - Items.GetData());
+	checkf(Items.IsValidIndex(ItemIndex), TEXT("ERROR: [%i] %s:\n'InOutSpec' is not owned by this container!"), __LINE__, *FString(__FUNCTION__));
+
+	EnsureIndices();
+	RemoveIndices(ItemIndex);
+	InOutSpec.MapComponent = MapComponent;
+	InOutSpec.Cell = Cell;
+	InOutSpec.ActorType = MapComponent ? MapComponent->GetActorType() : EActorType::None;
+	AddIndices(ItemIndex);
+	++LayoutVersion;
+	MarkItemDirty(InOutSpec);
+}
+
 void FMapComponentsContainer::Remove(const UMapComponent* MapComponent)
 {
-	if (const FMapComponentSpec* FoundSpec = Find(MapComponent))
+	// Remove first occurrence since there is only one Map Component
+	const int32 FoundIndex = IndexOf(MapComponent);
+	if (FoundIndex != INDEX_NONE)
 	{
-		// Remove first occurrence since there is only one Map Component
-		const int8 bRemoved = Items.RemoveSingleSwap(*FoundSpec);
-		checkf(bRemoved, TEXT("ERROR: [%i] %s:\nFailed to remove next Map Component: %s"), __LINE__, *FString(__FUNCTION__), *GetNameSafe(MapComponent));
+		RemoveAtSwap(FoundIndex);
 		MarkArrayDirty();
 	}
 }
 
 void FMapComponentsContainer::Remove(const FCell& Cell)
 {
-	if (const FMapComponentSpec* FoundSpec = Find(Cell))
+	const int32 FoundIndex = IndexOf(Cell);
+	if (FoundIndex != INDEX_NONE)
 	{
-		const int8 bRemoved = Items.RemoveSwap(*FoundSpec);
-		checkf(bRemoved, TEXT("ERROR: [%i] %s:\nFailed to remove next Cell: %s"), __LINE__, *FString(__FUNCTION__), *Cell.ToString());
+		RemoveAtSwap(FoundIndex);
 		MarkArrayDirty();
 	}
 }
 
 void FMapComponentsContainer::Remove(const FPoolObjectHandle& PoolObjectHandle)
 {
-	if (const FMapComponentSpec* FoundSpec = Find(PoolObjectHandle))
+	// Remove first occurrence since there is only one Handle
+	const int32 FoundIndex = IndexOf(PoolObjectHandle);
+	if (FoundIndex != INDEX_NONE)
 	{
-		// Remove first occurrence since there is only one Handle
-		const int8 bRemoved = Items.RemoveSingleSwap(*FoundSpec);
-		checkf(bRemoved, TEXT("ERROR: [%i] %s:\nFailed to remove next Handle: %s"), __LINE__, *FString(__FUNCTION__), *PoolObjectHandle.GetHash().ToString());
+		RemoveAtSwap(FoundIndex);
 		MarkArrayDirty();
 	}
 }
+
+void FMapComponentsContainer::RemoveAtIndices(TArray<int32, TInlineAllocator<32>>& InOutIndices)
+{
+	if (!InOutIndices.Num())
+	{
+		return;
+	}
+
+	// Remove from the highest index, so swapped items don't affect next indices
+	InOutIndices.Sort(TGreater<int32>());
+	int32 PrevIndex = INDEX_NONE;
+	for (const int32 IndexIt : InOutIndices)
+	{
+		if (IndexIt != PrevIndex
+		    && Items.IsValidIndex(IndexIt))
+		{
+			RemoveAtSwap(IndexIt);
+		}
+		PrevIndex = IndexIt;
+	}
+
+	MarkArrayDirty();
+}
+
+// Counts or uncounts given replicated item as unresolved according its current map component
+void FMapComponentsContainer::UpdateUnresolvedNum(FMapComponentSpec& InOutSpec, bool bIsRemoved) const
+{
+	// Slim actors are not replicated, so they are never resolved and clients rely on the replicated type and cell
+	const bool bUnresolved = !bIsRemoved
+	                         && !InOutSpec.IsValid()
+	                         && !UMapComponent::IsSlimActorType(InOutSpec.ActorType);
+	if (InOutSpec.bCountedUnresolved != bUnresolved)
+	{
+		InOutSpec.bCountedUnresolved = bUnresolved;
+		UnresolvedNum += bUnresolved ? 1 : -1;
+	}
+}
+
+void FMapComponentsContainer::UpdateIndices(const UMapComponent* MapComponent)
+{
+	const int32 FoundIndex = IndexOf(MapComponent);
+	if (FoundIndex != INDEX_NONE)
+	{
+		RemoveIndices(FoundIndex);
+		AddIndices(FoundIndex);
+
+		// Replicate the new cell with the item, so clients don't wait for the component
+		FMapComponentSpec& Spec = Items[FoundIndex];
+		if (Spec.Cell != MapComponent->GetCell())
+		{
+			Spec.Cell = MapComponent->GetCell();
+			MarkItemDirty(Spec);
+		}
+	}
+}
+
+// Returns the heap memory used by items and their side-indices
+SIZE_T FMapComponentsContainer::GetAllocatedSize() const
+{
+	return Items.GetAllocatedSize()
+	       + ComponentIndices.GetAllocatedSize()
+	       + HandleIndices.GetAllocatedSize()
+	       + CellIndices.GetAllocatedSize()
+	       + IndexedCells.GetAllocatedSize();
+}
+
+void FMapComponentsContainer::EnsureIndices() const
+{
+	if (!bIndicesDirty
+	    && IndexedCells.Num() == Items.Num()) // items could be changed directly
+	{
+		return;
+	}
+
+	bIndicesDirty = false;
+	++LayoutVersion;
+	ComponentIndices.Reset();
+	HandleIndices.Reset();
+	CellIndices.Reset();
+	IndexedCells.Reset();
+	PlayersNum = 0;
+	IndexedCells.SetNum(Items.Num());
+	for (int32 ItemIndex = 0; ItemIndex < Items.Num(); ++ItemIndex)
+	{
+		AddIndices(ItemIndex);
+	}
+}
+
+void FMapComponentsContainer::AddIndices(int32 ItemIndex) const
+{
+	++ItemsVersion;
+
+	const FMapComponentSpec& Spec = Items[ItemIndex];
+	if (Spec.MapComponent)
+	{
+		ComponentIndices.Add(Spec.MapComponent, ItemIndex);
+	}
+
+	if (Spec.PoolObjectHandle.IsValid())
+	{
+		HandleIndices.Add(Spec.PoolObjectHandle.GetHash(), ItemIndex);
+	}
+
+	if (Spec.ActorType == EActorType::Player)
+	{
+		++PlayersNum;
+	}
+
+	const FCell& Cell = Spec.MapComponent ? Spec.MapComponent->GetCell() : FCell::InvalidCell;
+	if (Cell.IsValid())
+	{
+		CellIndices.Add(Cell, ItemIndex);
+	}
+	IndexedCells[ItemIndex] = Cell;
+}
+
+void FMapComponentsContainer::RemoveIndices(int32 ItemIndex) const
+{
+	++ItemsVersion;
+
+	const FMapComponentSpec& Spec = Items[ItemIndex];
+	if (Spec.MapComponent)
+	{
+		ComponentIndices.Remove(Spec.MapComponent);
+	}
+
+	if (Spec.PoolObjectHandle.IsValid())
+	{
+		HandleIndices.Remove(Spec.PoolObjectHandle.GetHash());
+	}
+
+	if (Spec.ActorType == EActorType::Player)
+	{
+		--PlayersNum;
+	}
+
+	FCell& IndexedCell = IndexedCells[ItemIndex];
+	if (IndexedCell.IsValid())
+	{
+		CellIndices.RemoveSingle(IndexedCell, ItemIndex);
+	}
+	IndexedCell = FCell::InvalidCell;
+}
+
+void FMapComponentsContainer::RemoveAtSwap(int32 ItemIndex)
+{
+	EnsureIndices();
+
+	const int32 LastIndex = Items.Num() - 1;
+	RemoveIndices(ItemIndex);
+	if (ItemIndex != LastIndex)
+	{
+		// Last item is moved to the removed place
+		RemoveIndices(LastIndex);
+	}
+
+	constexpr bool bAllowShrinking = false;
+	Items.RemoveAtSwap(ItemIndex, 1, bAllowShrinking);
+	IndexedCells.RemoveAtSwap(ItemIndex, 1, bAllowShrinking);
+	++LayoutVersion;
+
+	if (ItemIndex != LastIndex)
+	{
+		AddIndices(ItemIndex);
+	}
+}
+
+int32 FMapComponentsContainer::IndexOf(const UMapComponent* MapComponent) const
+{
+	EnsureIndices();
+	const int32* FoundIndex = MapComponent ? ComponentIndices.Find(MapComponent) : nullptr;
+	if (FoundIndex)
+	{
+		return *FoundIndex;
+	}
+
+	// Null components are not indexed, but could be iterated to be removed
+	return MapComponent ? INDEX_NONE : Items.IndexOfByKey(MapComponent);
+}
+
+int32 FMapComponentsContainer::IndexOf(const FCell& Cell) const
+{
+	TArray<int32, TInlineAllocator<4>> FoundIndices;
+	FindIndices(Cell, FoundIndices);
+	return FoundIndices.Num() ? FMath::Min(FoundIndices) : INDEX_NONE;
+}
+
+int32 FMapComponentsContainer::IndexOf(const FPoolObjectHandle& PoolObjectHandle) const
+{
+	EnsureIndices();
+	const int32* FoundIndex = PoolObjectHandle.IsValid() ? HandleIndices.Find(PoolObjectHandle.GetHash()) : nullptr;
+	return FoundIndex ? *FoundIndex : INDEX_NONE;
+}
@@ -0,0 +1,108 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Structures/MatchSnapshot.h"
+//---
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// Writes or reads the snapshot, returns false if read data is not a valid snapshot
+bool FMatchSnapshot::Serialize(FArchive& Ar)
+{
+	uint32 SnapshotMagic = Magic;
+	uint16 SnapshotVersion = Version;
+	Ar << SnapshotMagic;
+	Ar << SnapshotVersion;
+	if (Ar.IsLoading()
+	    && (SnapshotMagic != Magic || SnapshotVersion != Version))
+	{
+		return false;
+	}
+
+	if (!Layout.Serialize(Ar))
+	{
+		return false;
+	}
+
+	// Cells are written as 16 bits and small counters as 8 bits, since grids and powerups never exceed them
+	const int32 CellsNum = Layout.ActorTypes.Num();
+	int32 ItemsNum = Items.Num();
+	Ar << ItemsNum;
+	if (ItemsNum < 0 || ItemsNum > CellsNum)
+	{
+		return false;
+	}
+	Items.SetNum(ItemsNum);
+	for (FItem& ItemIt : Items)
+	{
+		uint16 CellIndex = static_cast<uint16>(ItemIt.CellIndex);
+		Ar << CellIndex;
+		Ar << ItemIt.ItemType;
+		ItemIt.CellIndex = CellIndex;
+	}
+
+	int32 BombsNum = Bombs.Num();
+	Ar << BombsNum;
+	if (BombsNum < 0 || BombsNum > CellsNum)
+	{
+		return false;
+	}
+	Bombs.SetNum(BombsNum);
+	for (FBomb& BombIt : Bombs)
+	{
+		uint16 CellIndex = static_cast<uint16>(BombIt.CellIndex);
+		int8 OwnerCharacterID = static_cast<int8>(BombIt.OwnerCharacterID);
+		uint8 FireRadius = static_cast<uint8>(BombIt.FireRadius);
+		Ar << CellIndex;
+		Ar << OwnerCharacterID;
+		Ar << FireRadius;
+		Ar << BombIt.FuseSecondsRemain;
+		BombIt.CellIndex = CellIndex;
+		BombIt.OwnerCharacterID = OwnerCharacterID;
+		BombIt.FireRadius = FireRadius;
+	}
+
+	int32 PlayersNum = Players.Num();
+	Ar << PlayersNum;
+	if (PlayersNum < 0 || PlayersNum > CellsNum)
+	{
+		return false;
+	}
+	Players.SetNum(PlayersNum);
+	for (FPlayer& PlayerIt : Players)
+	{
+		int8 CharacterID = static_cast<int8>(PlayerIt.CharacterID);
+		uint16 CellIndex = static_cast<uint16>(PlayerIt.CellIndex);
+		uint8 SkateN = static_cast<uint8>(PlayerIt.SkateN);
+		uint8 BombN = static_cast<uint8>(PlayerIt.BombN);
+		uint8 FireN = static_cast<uint8>(PlayerIt.FireN);
+		Ar << CharacterID;
+		Ar << CellIndex;
+		Ar << SkateN;
+		Ar << BombN;
+		Ar << FireN;
+		PlayerIt.CharacterID = CharacterID;
+		PlayerIt.CellIndex = CellIndex;
+		PlayerIt.SkateN = SkateN;
+		PlayerIt.BombN = BombN;
+		PlayerIt.FireN = FireN;
+	}
+
+	Ar << InGameSecondsRemain;
+
+	return !Ar.IsError();
+}
+
+// Writes the snapshot to given bytes
+void FMatchSnapshot::SaveToBytes(TArray<uint8>& OutBytes)
+{
+	OutBytes.Reset();
+	FMemoryWriter Writer(OutBytes);
+	Serialize(Writer);
+}
+
+// Reads the snapshot from given bytes, returns false if they are not a valid snapshot
+bool FMatchSnapshot::LoadFromBytes(const TArray<uint8>& Bytes)
+{
+	FMemoryReader Reader(Bytes);
+	return Serialize(Reader);
+}
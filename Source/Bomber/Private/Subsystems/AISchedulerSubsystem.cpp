@@ -0,0 +1,347 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/AISchedulerSubsystem.h"
+//---
+#include "GeneratedMap.h"
+#include "Controllers/MyAIController.h"
+#include "DataAssets/AIDataAsset.h"
+#include "Engine/BomberTelemetry.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+//---
+#include "Async/ParallelFor.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(AISchedulerSubsystem)
+
+// Spread the update of all bots across frames
+static TAutoConsoleVariable<int32> CVarAIStaggerFrames(
+	TEXT("Bomber.AI.StaggerFrames"),
+	1,
+	TEXT("Number of frames the update of all bots is spread across: 1 (All bots in one frame) OR more"),
+	ECVF_Default);
+
+// Limit the time spent on bots per frame
+static TAutoConsoleVariable<float> CVarAIFrameBudgetMs(
+	TEXT("Bomber.AI.FrameBudgetMs"),
+	0.f,
+	TEXT("Time budget in milliseconds per frame for updating bots, the rest is postponed: 0 (Budget of the AI data asset) OR more"),
+	ECVF_Default);
+
+// Make decisions of bots in parallel
+static TAutoConsoleVariable<bool> CVarAIParallel(
+	TEXT("Bomber.AI.Parallel"),
+	false,
+	TEXT("Make decisions of all bots of the frame in parallel over the shared AI snapshot: 1 (Parallel) OR 0 (One by one on the game thread)"),
+	ECVF_Default);
+
+// Bots with their inputs and decisions that are made together over the same snapshot
+struct FAIDecisionsBatch
+{
+	struct FBotDecision
+	{
+		TWeakObjectPtr<AMyAIController> AIController = nullptr;
+		FAIDecisionInput Input;
+		FAIDecision Decision;
+		double DecisionSeconds = 0.0;
+
+		// Level state of the bot's own Generated Map, is resolved on the game thread before decisions are made
+		const FAIWorldSnapshot* Snapshot = nullptr;
+	};
+
+	TArray<FBotDecision, TInlineAllocator<8>> BotDecisions;
+
+	// Is kept alive by the batch for the launched task, is not set when the decisions are made by the game thread
+	TSharedPtr<const FAIWorldSnapshot, ESPMode::ThreadSafe> SharedSnapshot = nullptr;
+
+	// Wall time of making all decisions of the batch
+	double DecisionsSeconds = 0.0;
+};
+
+// Returns the AI Scheduler Subsystem, is checked and wil crash if can't be obtained
+UAISchedulerSubsystem& UAISchedulerSubsystem::Get(const UObject* WorldContextObject/* = nullptr*/)
+{
+	UAISchedulerSubsystem* AISchedulerSubsystem = GetAISchedulerSubsystem(WorldContextObject);
+	checkf(AISchedulerSubsystem, TEXT("%s: 'AISchedulerSubsystem' is null"), *FString(__FUNCTION__));
+	return *AISchedulerSubsystem;
+}
+
+// Returns the pointer to the AI Scheduler Subsystem
+UAISchedulerSubsystem* UAISchedulerSubsystem::GetAISchedulerSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<UAISchedulerSubsystem>() : nullptr;
+}
+
+// Starts updating given bot
+void UAISchedulerSubsystem::RegisterBot(AMyAIController* AIController)
+{
+	if (!ensureMsgf(AIController, TEXT("ASSERT: [%i] %s:\n'AIController' is not valid!"), __LINE__, *FString(__FUNCTION__))
+	    || BotsInternal.ContainsByPredicate([AIController](const FAIScheduledBot& BotIt) { return BotIt.AIController == AIController; }))
+	{
+		return;
+	}
+
+	// New bot is updated as soon as possible as it was done by the timer with the smallest first delay
+	BotsInternal.Emplace(FAIScheduledBot{AIController, GetWorld()->GetTimeSeconds()});
+}
+
+// Stops updating given bot
+void UAISchedulerSubsystem::UnregisterBot(AMyAIController* AIController)
+{
+	BotsInternal.RemoveAllSwap([AIController](const FAIScheduledBot& BotIt) { return BotIt.AIController == AIController; });
+	PendingBotsInternal.RemoveSingle(AIController);
+}
+
+// Returns the time budget in milliseconds per frame for updating bots, 0 if is not limited
+float UAISchedulerSubsystem::GetFrameBudgetMs()
+{
+	const float FrameBudgetMs = CVarAIFrameBudgetMs.GetValueOnAnyThread();
+	return FMath::Max(0.f, FrameBudgetMs > 0.f ? FrameBudgetMs : UAIDataAsset::Get().GetFrameBudgetMs());
+}
+
+// Queues due bots and updates pending ones, is called by the Grid Simulation Subsystem on each step
+void UAISchedulerSubsystem::UpdateBots(float DeltaTime)
+{
+	if (BotsInternal.IsEmpty()
+	    && PendingBotsInternal.IsEmpty())
+	{
+		LastFrameUpdateMsInternal = 0.f;
+		return;
+	}
+
+	if (PendingBotsInternal.IsEmpty())
+	{
+		QueueDueBots();
+	}
+
+	if (PendingBotsInternal.IsEmpty())
+	{
+		LastFrameUpdateMsInternal = 0.f;
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (CVarAIParallel.GetValueOnGameThread())
+	{
+		UpdatePendingBotsParallel();
+	}
+	else
+	{
+		UpdatePendingBots(StartTime);
+	}
+
+	LastFrameUpdateMsInternal = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+// Updates pending bots one by one until the number of bots per frame or the frame budget is reached
+void UAISchedulerSubsystem::UpdatePendingBots(double StartTime)
+{
+	const double BudgetSeconds = GetFrameBudgetMs() / 1000.0;
+
+	// At least one bot is updated per frame, so the batch is always finished even with too small budget
+	int32 UpdatedBotsNum = 0;
+	while (!PendingBotsInternal.IsEmpty()
+	       && UpdatedBotsNum < BotsPerFrameInternal)
+	{
+		// Pending bots are stored in reverse order, so the last one is the next to update
+		constexpr bool bAllowShrinking = false;
+		AMyAIController* AIController = PendingBotsInternal.Pop(bAllowShrinking).Get();
+		if (!AIController)
+		{
+			continue;
+		}
+
+		AIController->UpdateAI();
+		ScheduleNextUpdate(AIController);
+		++UpdatedBotsNum;
+
+		if (BudgetSeconds > 0.0
+		    && FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+		{
+			break;
+		}
+	}
+}
+
+// Makes decisions of pending bots of this frame in parallel and applies them on the game thread
+void UAISchedulerSubsystem::UpdatePendingBotsParallel()
+{
+	FAIDecisionsBatch Batch;
+	GatherPendingDecisions(Batch);
+	if (Batch.BotDecisions.IsEmpty())
+	{
+		return;
+	}
+
+	// Snapshots are built before the parallel section, so all workers only read them, each bot sees the level of its own pawn
+	for (FAIDecisionsBatch::FBotDecision& BotDecisionIt : Batch.BotDecisions)
+	{
+		const AMyAIController* AIController = BotDecisionIt.AIController.Get();
+		BotDecisionIt.Snapshot = &AGeneratedMap::Get(AIController ? AIController->GetPawn() : nullptr).GetAIWorldSnapshot();
+	}
+	MakeDecisions(Batch);
+	LastDecisionsMsInternal = static_cast<float>(Batch.DecisionsSeconds * 1000.0);
+
+	ApplyDecisions(Batch);
+}
+
+// Queues due bots, gathers their inputs on the game thread and launches the task that makes their decisions
+void UAISchedulerSubsystem::LaunchDecisions(const TSharedRef<const FAIWorldSnapshot, ESPMode::ThreadSafe>& Snapshot)
+{
+	// Only one batch is in flight, the previous one has to be applied first
+	ApplyLaunchedDecisions();
+
+	if (BotsInternal.IsEmpty()
+	    && PendingBotsInternal.IsEmpty())
+	{
+		return;
+	}
+
+	if (PendingBotsInternal.IsEmpty())
+	{
+		QueueDueBots();
+	}
+
+	const TSharedRef<FAIDecisionsBatch, ESPMode::ThreadSafe> Batch = MakeShared<FAIDecisionsBatch, ESPMode::ThreadSafe>();
+	GatherPendingDecisions(*Batch);
+	if (Batch->BotDecisions.IsEmpty())
+	{
+		return;
+	}
+
+	// The task owns the batch and the snapshot, so nothing it reads is changed or freed by the game thread
+	Batch->SharedSnapshot = Snapshot;
+	for (FAIDecisionsBatch::FBotDecision& BotDecisionIt : Batch->BotDecisions)
+	{
+		BotDecisionIt.Snapshot = &Snapshot.Get();
+	}
+	LaunchedBatchInternal = Batch;
+	LaunchedDecisionsTaskInternal = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Batch]()
+	{
+		MakeDecisions(*Batch);
+	});
+}
+
+// Waits for the launched decisions if they are not made yet and applies them on the game thread
+void UAISchedulerSubsystem::ApplyLaunchedDecisions()
+{
+	if (!LaunchedBatchInternal.IsValid())
+	{
+		LastDecisionsWaitMsInternal = 0.f;
+		return;
+	}
+
+	const double WaitStartTime = FPlatformTime::Seconds();
+	LaunchedDecisionsTaskInternal.Wait();
+	LastDecisionsWaitMsInternal = static_cast<float>((FPlatformTime::Seconds() - WaitStartTime) * 1000.0);
+	LastDecisionsMsInternal = static_cast<float>(LaunchedBatchInternal->DecisionsSeconds * 1000.0);
+
+	const TSharedPtr<FAIDecisionsBatch, ESPMode::ThreadSafe> Batch = MoveTemp(LaunchedBatchInternal);
+	LaunchedBatchInternal.Reset();
+	LaunchedDecisionsTaskInternal = UE::Tasks::FTask();
+
+	ApplyDecisions(*Batch);
+}
+
+// Waits for the launched decisions, so workers don't read the batch of destroyed world
+void UAISchedulerSubsystem::Deinitialize()
+{
+	if (LaunchedBatchInternal.IsValid())
+	{
+		LaunchedDecisionsTaskInternal.Wait();
+		LaunchedBatchInternal.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+// Takes pending bots of this frame and gathers their inputs on the game thread
+void UAISchedulerSubsystem::GatherPendingDecisions(FAIDecisionsBatch& OutBatch)
+{
+	while (!PendingBotsInternal.IsEmpty()
+	       && OutBatch.BotDecisions.Num() < BotsPerFrameInternal)
+	{
+		constexpr bool bAllowShrinking = false;
+		AMyAIController* AIController = PendingBotsInternal.Pop(bAllowShrinking).Get();
+		if (!AIController)
+		{
+			continue;
+		}
+
+		FAIDecisionInput Input;
+		if (AIController->PrepareDecision(Input))
+		{
+			OutBatch.BotDecisions.Emplace(FAIDecisionsBatch::FBotDecision{AIController, Input});
+		}
+		else
+		{
+			ScheduleNextUpdate(AIController);
+		}
+	}
+}
+
+// Makes decisions of all bots of given batch in parallel over their snapshots, is safe to call from any thread
+void UAISchedulerSubsystem::MakeDecisions(FAIDecisionsBatch& InOutBatch)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	ParallelFor(InOutBatch.BotDecisions.Num(), [&InOutBatch](int32 Index)
+	{
+		FAIDecisionsBatch::FBotDecision& BotDecision = InOutBatch.BotDecisions[Index];
+		if (!BotDecision.Snapshot)
+		{
+			return;
+		}
+
+		const double DecisionStartTime = FPlatformTime::Seconds();
+		AMyAIController::MakeDecision(*BotDecision.Snapshot, BotDecision.Input, BotDecision.Decision);
+		BotDecision.DecisionSeconds = FPlatformTime::Seconds() - DecisionStartTime;
+	});
+	InOutBatch.DecisionsSeconds = FPlatformTime::Seconds() - StartTime;
+}
+
+// Applies made decisions of given batch on the game thread and schedules next updates of their bots
+void UAISchedulerSubsystem::ApplyDecisions(const FAIDecisionsBatch& Batch)
+{
+	for (const FAIDecisionsBatch::FBotDecision& BotDecisionIt : Batch.BotDecisions)
+	{
+		// Bot could be destroyed by previously applied decisions or while its decision was made
+		AMyAIController* AIController = BotDecisionIt.AIController.Get();
+		if (IsValid(AIController))
+		{
+			AIController->DecisionStatsInternal.AddDecision(BotDecisionIt.DecisionSeconds);
+			AIController->RecordDecisionTelemetry(BotDecisionIt.Decision, BotDecisionIt.DecisionSeconds);
+			AIController->ApplyDecision(BotDecisionIt.Decision);
+			ScheduleNextUpdate(AIController);
+		}
+	}
+}
+
+// Queues all registered bots whose update time has come
+void UAISchedulerSubsystem::QueueDueBots()
+{
+	BotsInternal.RemoveAllSwap([](const FAIScheduledBot& BotIt) { return !BotIt.AIController.IsValid(); });
+
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	PendingBotsInternal.Reset();
+	for (int32 Index = BotsInternal.Num() - 1; Index >= 0; --Index)
+	{
+		const FAIScheduledBot& BotIt = BotsInternal[Index];
+		if (BotIt.NextUpdateTime <= CurrentTime)
+		{
+			PendingBotsInternal.Emplace(BotIt.AIController);
+		}
+	}
+
+	const int32 StaggerFrames = FMath::Max(1, CVarAIStaggerFrames.GetValueOnAnyThread());
+	BotsPerFrameInternal = FMath::DivideAndRoundUp(PendingBotsInternal.Num(), StaggerFrames);
+}
+
+// Schedules the next update of given bot by its current level of detail
+void UAISchedulerSubsystem::ScheduleNextUpdate(const AMyAIController* AIController)
+{
+	FAIScheduledBot* ScheduledBot = BotsInternal.FindByPredicate([AIController](const FAIScheduledBot& BotIt) { return BotIt.AIController == AIController; });
+	if (ScheduledBot)
+	{
+		ScheduledBot->NextUpdateTime = GetWorld()->GetTimeSeconds() + AIController->GetUpdateInterval();
+	}
+}
@@ -0,0 +1,245 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/AISimulationSubsystem.h"
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Controllers/MyAIController.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "LevelActors/PlayerCharacter.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
+//---
+#include "EngineUtils.h"
+#include "TimerManager.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/FileHelper.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(AISimulationSubsystem)
+
+// Returns the pointer to the AI Simulation Subsystem, is null if the game is not simulated
+UAISimulationSubsystem* UAISimulationSubsystem::GetAISimulationSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<UAISimulationSubsystem>() : nullptr;
+}
+
+// Returns true if the game is launched to simulate bot-only matches
+bool UAISimulationSubsystem::IsSimulationEnabled()
+{
+	static const bool bIsSimulationEnabled = FParse::Param(FCommandLine::Get(), TEXT("AISimulation"))
+	                                         || FCString::Strifind(FCommandLine::Get(), TEXT("-AISimulation=")) != nullptr;
+	return bIsSimulationEnabled;
+}
+
+// Is created only for game worlds launched with the -AISimulation argument
+bool UAISimulationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && IsSimulationEnabled()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Applies the time dilation and starts listening the game states
+void UAISimulationSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	MatchesNumInternal = 1;
+	FParse::Value(CommandLine, TEXT("AISimulation="), MatchesNumInternal);
+	MatchesNumInternal = FMath::Max(1, MatchesNumInternal);
+
+	float TimeDilation = 1.f;
+	if (FParse::Value(CommandLine, TEXT("AISimulationDilation="), TimeDilation))
+	{
+		// Is clamped by the world settings, 20 by default
+		InWorld.GetWorldSettings()->SetTimeDilation(TimeDilation);
+	}
+
+	if (!FParse::Value(CommandLine, TEXT("AISimulationOutput="), OutputFilePathInternal))
+	{
+		OutputFilePathInternal = FPaths::ProjectSavedDir() / TEXT("AISimulation") / FString::Printf(TEXT("AISimulation_%s.csv"), *FDateTime::Now().ToString());
+	}
+	OutputCSVInternal = TEXT("Match,CharacterID,Result,DeathTime,MatchLength,Decisions,AverageDecisionMs,MaxDecisionMs\n");
+
+	if (AGeneratedMap* GeneratedMap = UGeneratedMapSubsystem::Get().GetGeneratedMap())
+	{
+		GeneratedMap->OnAnyCharacterDestroyed.AddUniqueDynamic(this, &ThisClass::OnAnyCharacterDestroyed);
+	}
+
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(&InWorld))
+	{
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
+
+		// Handle current game state if initialized with delay
+		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
+		{
+			OnGameStateChanged(ECurrentGameState::Menu);
+		}
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("AI Simulation: %i matches, time dilation %.2f, results are written to '%s'"), MatchesNumInternal, TimeDilation, *OutputFilePathInternal);
+}
+
+// Starts the next match or records results of the finished one
+void UAISimulationSubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
+{
+	switch (CurrentGameState)
+	{
+		case ECurrentGameState::Menu:
+			StartNextMatch();
+			break;
+		case ECurrentGameState::InGame:
+			OnMatchStarted();
+			break;
+		case ECurrentGameState::EndGame:
+			OnMatchEnded();
+			break;
+		default:
+			break;
+	}
+}
+
+// Remembers when bots are blasted
+void UAISimulationSubsystem::OnAnyCharacterDestroyed()
+{
+	const UWorld* World = GetWorld();
+	if (!World
+	    || AMyGameStateBase::GetCurrentGameState() != ECurrentGameState::InGame)
+	{
+		return;
+	}
+
+	const float MatchTime = static_cast<float>(World->GetTimeSeconds() - MatchStartTimeInternal);
+	for (FAISimulationBotResult& BotResultIt : BotResultsInternal)
+	{
+		// Blasted character is unpossessed
+		const APlayerCharacter* PlayerCharacter = BotResultIt.PlayerCharacter.Get();
+		if (BotResultIt.DeathTime < 0.f
+		    && (!PlayerCharacter || !PlayerCharacter->GetController()))
+		{
+			BotResultIt.DeathTime = MatchTime;
+		}
+	}
+}
+
+// Sets the Game Starting state on the next tick, so all listeners of the current state are notified first
+void UAISimulationSubsystem::StartNextMatch()
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	World->GetTimerManager().SetTimerForNextTick([WeakThis = TWeakObjectPtr<ThisClass>(this)]()
+	{
+		if (WeakThis.IsValid())
+		{
+			if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(WeakThis.Get()))
+			{
+				MyGameState->ServerSetGameState(ECurrentGameState::GameStarting);
+			}
+		}
+	});
+}
+
+// Remembers all bots that take part in the match and starts counting their decisions
+void UAISimulationSubsystem::OnMatchStarted()
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	MatchStartTimeInternal = World->GetTimeSeconds();
+	BotResultsInternal.Reset();
+
+	for (TActorIterator<APlayerCharacter> It(World); It; ++It)
+	{
+		const APlayerCharacter* PlayerCharacter = *It;
+		AMyAIController* AIController = PlayerCharacter ? Cast<AMyAIController>(PlayerCharacter->GetController()) : nullptr;
+		if (!AIController
+		    || PlayerCharacter->GetCharacterID() == INDEX_NONE)
+		{
+			continue;
+		}
+
+		AIController->ResetDecisionStats();
+
+		FAISimulationBotResult& BotResult = BotResultsInternal.AddDefaulted_GetRef();
+		BotResult.CharacterID = PlayerCharacter->GetCharacterID();
+		BotResult.PlayerCharacter = PlayerCharacter;
+		BotResult.AIController = AIController;
+	}
+}
+
+// Writes results of the finished match and closes the game after the last one
+void UAISimulationSubsystem::OnMatchEnded()
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	++FinishedMatchesNumInternal;
+	const float MatchLength = static_cast<float>(World->GetTimeSeconds() - MatchStartTimeInternal);
+
+	int32 AliveBotsNum = 0;
+	for (FAISimulationBotResult& BotResultIt : BotResultsInternal)
+	{
+		// Controllers of blasted bots are kept by their characters, so timings are still available
+		if (const AMyAIController* AIController = BotResultIt.AIController.Get())
+		{
+			const FAIDecisionStats& DecisionStats = AIController->GetDecisionStats();
+			BotResultIt.DecisionsNum = DecisionStats.DecisionsNum;
+			BotResultIt.AverageDecisionMs = DecisionStats.GetAverageMs();
+			BotResultIt.MaxDecisionMs = DecisionStats.MaxSeconds * 1000.0;
+		}
+
+		AliveBotsNum += BotResultIt.DeathTime < 0.f ? 1 : 0;
+	}
+
+	for (const FAISimulationBotResult& BotResultIt : BotResultsInternal)
+	{
+		const bool bIsAlive = BotResultIt.DeathTime < 0.f;
+		const TCHAR* Result = !bIsAlive ? TEXT("Lose") : AliveBotsNum == 1 ? TEXT("Win") : TEXT("Draw");
+		if (bIsAlive && AliveBotsNum == 1)
+		{
+			WinsByCharacterIDInternal.FindOrAdd(BotResultIt.CharacterID)++;
+		}
+
+		OutputCSVInternal += FString::Printf(TEXT("%i,%i,%s,%.2f,%.2f,%i,%.4f,%.4f\n"),
+		                                     FinishedMatchesNumInternal, BotResultIt.CharacterID, Result,
+		                                     bIsAlive ? MatchLength : BotResultIt.DeathTime, MatchLength,
+		                                     BotResultIt.DecisionsNum, BotResultIt.AverageDecisionMs, BotResultIt.MaxDecisionMs);
+	}
+
+	// The whole file is rewritten, so results of finished matches are not lost if the process is killed
+	FFileHelper::SaveStringToFile(OutputCSVInternal, *OutputFilePathInternal);
+
+	if (FinishedMatchesNumInternal < MatchesNumInternal)
+	{
+		StartNextMatch();
+		return;
+	}
+
+	for (const TTuple<int32, int32>& WinsIt : WinsByCharacterIDInternal)
+	{
+		UE_LOG(LogBomber, Log, TEXT("AI Simulation: character %i won %i of %i matches (%.1f%%)"), WinsIt.Key, WinsIt.Value, FinishedMatchesNumInternal, 100.f * WinsIt.Value / FinishedMatchesNumInternal);
+	}
+
+	constexpr bool bForce = false;
+	FPlatformMisc::RequestExit(bForce);
+}
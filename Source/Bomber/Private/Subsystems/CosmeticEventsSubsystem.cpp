@@ -0,0 +1,215 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/CosmeticEventsSubsystem.h"
+//---
+#include "GeneratedMap.h"
+#include "Components/MapComponent.h"
+#include "DataAssets/BombDataAsset.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/LoadTestSubsystem.h"
+#include "Subsystems/SoundsSubsystem.h"
+//---
+#include "NiagaraComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "Algo/StableSort.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CosmeticEventsSubsystem)
+
+// Process cosmetics in batches once per frame
+static TAutoConsoleVariable<bool> CVarCosmeticsEnabled(
+	TEXT("Bomber.Cosmetics.Enabled"),
+	true,
+	TEXT("Batch cosmetic events by frames: 1 (Consume once per frame) OR 0 (Consume each event right away)"),
+	ECVF_Default);
+
+// Returns the pointer to the Cosmetic Events Subsystem
+UCosmeticEventsSubsystem* UCosmeticEventsSubsystem::GetCosmeticEventsSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<UCosmeticEventsSubsystem>() : nullptr;
+}
+
+// Queues the event to be consumed with other events of this frame
+void UCosmeticEventsSubsystem::AddEvent(ECosmeticEventType Type, const FCell& Cell, EActorType ActorType, UObject* Source/* = nullptr*/)
+{
+	FCosmeticEvent NewEvent;
+	NewEvent.Type = Type;
+	NewEvent.Cell = Cell;
+	NewEvent.ActorType = ActorType;
+	NewEvent.Source = Source;
+
+	if (!CVarCosmeticsEnabled.GetValueOnGameThread())
+	{
+		ConsumeEvents({NewEvent});
+		return;
+	}
+
+	// Explosions of overlapped blasts are the same no matter which bomb exploded the cell, while moved actors are displayed only on their last cell
+	FCosmeticEventKey Key;
+	Key.Type = Type;
+	Key.Cell = Type == ECosmeticEventType::CellChanged ? FCell::InvalidCell : Cell;
+	Key.Source = Type == ECosmeticEventType::Explosion ? nullptr : Source;
+
+	if (const int32* QueuedIndex = QueuedEventIndicesInternal.Find(Key))
+	{
+		QueuedEventsInternal[*QueuedIndex] = MoveTemp(NewEvent);
+		return;
+	}
+
+	QueuedEventIndicesInternal.Add(Key, QueuedEventsInternal.Emplace(MoveTemp(NewEvent)));
+}
+
+// Is created only for game worlds that are not the dedicated server
+bool UCosmeticEventsSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && !IsRunningDedicatedServer()
+	       && World->GetNetMode() != NM_DedicatedServer
+	       && !ULoadTestSubsystem::IsLoadTestClient()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Is ticked only while any event is queued
+bool UCosmeticEventsSubsystem::IsTickable() const
+{
+	return !QueuedEventsInternal.IsEmpty();
+}
+
+// Consumes all events queued for this frame
+void UCosmeticEventsSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Consumers could queue new events, so they are taken to the next frame
+	TArray<FCosmeticEvent> Events = MoveTemp(QueuedEventsInternal);
+	QueuedEventsInternal.Reset();
+	QueuedEventIndicesInternal.Reset();
+
+	// Group by types, keeping the order of queueing within each type
+	Algo::StableSortBy(Events, &FCosmeticEvent::Type);
+	ConsumeEvents(Events);
+}
+
+// Returns the stat id of this tickable object
+TStatId UCosmeticEventsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCosmeticEventsSubsystem, STATGROUP_Tickables);
+}
+
+// Is called when the world is torn down, drops all queued events
+void UCosmeticEventsSubsystem::Deinitialize()
+{
+	QueuedEventsInternal.Empty();
+	QueuedEventIndicesInternal.Empty();
+	OnCosmeticEvents.Clear();
+
+	Super::Deinitialize();
+}
+
+// Passes given events to all consumers
+void UCosmeticEventsSubsystem::ConsumeEvents(TConstArrayView<FCosmeticEvent> Events)
+{
+	int32 FirstIndex = 0;
+	while (FirstIndex < Events.Num())
+	{
+		const ECosmeticEventType Type = Events[FirstIndex].Type;
+		int32 LastIndex = FirstIndex + 1;
+		while (LastIndex < Events.Num()
+		       && Events[LastIndex].Type == Type)
+		{
+			++LastIndex;
+		}
+
+		const TConstArrayView<FCosmeticEvent> TypeEvents = Events.Slice(FirstIndex, LastIndex - FirstIndex);
+		switch (Type)
+		{
+			case ECosmeticEventType::Explosion:
+				ConsumeExplosions(TypeEvents);
+				break;
+			case ECosmeticEventType::ItemPicked:
+				ConsumeItemPickups(TypeEvents);
+				break;
+			case ECosmeticEventType::CellChanged:
+				ConsumeCellChanges(TypeEvents);
+				break;
+			default:
+				break;
+		}
+
+		FirstIndex = LastIndex;
+	}
+
+	OnCosmeticEvents.Broadcast(Events);
+}
+
+// Spawns explosion emitters of all exploded cells by the explosion tier of current game settings and plays explosion sound once
+void UCosmeticEventsSubsystem::ConsumeExplosions(TConstArrayView<FCosmeticEvent> Events)
+{
+	USoundsSubsystem::Get().PlayExplosionSFX();
+
+	const UBombDataAsset& BombDataAsset = UBombDataAsset::Get();
+	UNiagaraSystem* ExplosionParticle = BombDataAsset.GetExplosionVFX();
+	if (!ExplosionParticle)
+	{
+		return;
+	}
+
+	// Events are consumed once per frame, but the budget is still tracked by frames for events that are consumed right away
+	if (ExplosionsBudgetFrameInternal != GFrameCounter)
+	{
+		ExplosionsBudgetFrameInternal = GFrameCounter;
+		ExplosionsSpawnedInFrameInternal = 0;
+	}
+
+	const FExplosionVFXTier& VFXTier = BombDataAsset.GetExplosionVFXTier();
+	const int32 CellsNum = Events.Num();
+	const int32 SpawnNum = VFXTier.MaxSystemsPerFrame > 0 ? FMath::Min(CellsNum, VFXTier.MaxSystemsPerFrame - ExplosionsSpawnedInFrameInternal) : CellsNum;
+	if (SpawnNum <= 0)
+	{
+		return;
+	}
+	ExplosionsSpawnedInFrameInternal += SpawnNum;
+
+	// When the budget is exceeded, cells are taken evenly through all chains instead of the first ones only
+	const float CellsStep = static_cast<float>(CellsNum) / SpawnNum;
+
+	// Components are taken from the world Niagara pool and are released back once finished, so no new components are created on each blast
+	constexpr bool bAutoDestroy = false;
+	constexpr bool bAutoActivate = true;
+	const FRotator Rotation = AGeneratedMap::Get(this).GetActorRotation();
+	for (int32 SpawnIndex = 0; SpawnIndex < SpawnNum; ++SpawnIndex)
+	{
+		const FCell& CellIt = Events[FMath::Min(FMath::FloorToInt32(SpawnIndex * CellsStep), CellsNum - 1)].Cell;
+		UNiagaraComponent* NiagaraComponent = UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, ExplosionParticle, CellIt.Location, Rotation, FVector::OneVector, bAutoDestroy, bAutoActivate, ENCPoolMethod::AutoRelease);
+		if (NiagaraComponent)
+		{
+			NiagaraComponent->SetVariableFloat(TEXT("ParticlesScale"), VFXTier.ParticlesScale);
+			NiagaraComponent->SetVariableBool(TEXT("EmitLight"), VFXTier.bEmitLight);
+		}
+	}
+}
+
+// Plays the pickup sound once for all items picked up in this frame
+void UCosmeticEventsSubsystem::ConsumeItemPickups(TConstArrayView<FCosmeticEvent> Events)
+{
+	if (!Events.IsEmpty())
+	{
+		USoundsSubsystem::Get().PlayItemPickUpSFX();
+	}
+}
+
+// Displays new cells of moved level actors once per frame
+void UCosmeticEventsSubsystem::ConsumeCellChanges(TConstArrayView<FCosmeticEvent> Events)
+{
+#if !UE_BUILD_SHIPPING
+	for (const FCosmeticEvent& EventIt : Events)
+	{
+		if (UMapComponent* MapComponent = Cast<UMapComponent>(EventIt.Source.Get()))
+		{
+			MapComponent->TryDisplayOwnedCell();
+		}
+	}
+#endif // !UE_BUILD_SHIPPING
+}
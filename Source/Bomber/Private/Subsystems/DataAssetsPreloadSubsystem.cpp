@@ -0,0 +1,88 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/DataAssetsPreloadSubsystem.h"
+//---
+#include "Bomber.h"
+#include "DataAssets/DataAssetsContainer.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+//---
+#include "Engine/AssetManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StreamableManager.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(DataAssetsPreloadSubsystem)
+
+// Returns the pointer to the Data Assets Preload Subsystem
+UDataAssetsPreloadSubsystem* UDataAssetsPreloadSubsystem::GetDataAssetsPreloadSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	const UGameInstance* GameInstance = FoundWorld ? FoundWorld->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<UDataAssetsPreloadSubsystem>() : nullptr;
+}
+
+// Calls given function once all data assets are loaded, calls it right away if they are loaded already
+void UDataAssetsPreloadSubsystem::CallOrWaitPreloaded(const FOnDataAssetsPreloaded::FDelegate& Callback)
+{
+	if (bIsPreloadedInternal)
+	{
+		Callback.ExecuteIfBound();
+		return;
+	}
+
+	OnDataAssetsPreloaded.Add(Callback);
+}
+
+// Requests all data assets of the container asynchronously
+void UDataAssetsPreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TArray<FSoftObjectPath> DataAssetPaths;
+	UDataAssetsContainer::GetAllDataAssetPaths(/*out*/DataAssetPaths);
+
+	PreloadStartTimeInternal = FPlatformTime::Seconds();
+	if (DataAssetPaths.IsEmpty()
+	    || !UAssetManager::IsInitialized())
+	{
+		OnPreloaded();
+		return;
+	}
+
+	FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+	PreloadHandleInternal = StreamableManager.RequestAsyncLoad(DataAssetPaths, FStreamableDelegate::CreateUObject(this, &ThisClass::OnPreloaded), FStreamableManager::AsyncLoadHighPriority);
+	if (!PreloadHandleInternal.IsValid())
+	{
+		// Nothing to load, e.g. all assets are already in memory
+		OnPreloaded();
+	}
+}
+
+// Releases preloaded data assets
+void UDataAssetsPreloadSubsystem::Deinitialize()
+{
+	if (PreloadHandleInternal.IsValid())
+	{
+		PreloadHandleInternal->ReleaseHandle();
+		PreloadHandleInternal.Reset();
+	}
+
+	OnDataAssetsPreloaded.Clear();
+
+	Super::Deinitialize();
+}
+
+// Is called once all data assets are loaded
+void UDataAssetsPreloadSubsystem::OnPreloaded()
+{
+	if (bIsPreloadedInternal)
+	{
+		return;
+	}
+
+	bIsPreloadedInternal = true;
+	PreloadSecondsInternal = static_cast<float>(FPlatformTime::Seconds() - PreloadStartTimeInternal);
+	UE_LOG(LogBomber, Log, TEXT("Data assets are preloaded in %.3f ms"), PreloadSecondsInternal * 1000.f);
+
+	OnDataAssetsPreloaded.Broadcast();
+	OnDataAssetsPreloaded.Clear();
+}
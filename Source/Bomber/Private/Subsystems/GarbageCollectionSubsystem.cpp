@@ -0,0 +1,166 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/GarbageCollectionSubsystem.h"
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
+//---
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GarbageCollectionSubsystem)
+
+// If true, garbage collection is postponed during the match and happens on safe points instead
+static TAutoConsoleVariable<bool> CVarGCEnabled(
+	TEXT("Bomber.GC.Enabled"),
+	true,
+	TEXT("If true, automatic garbage collection is postponed during the match and garbage is collected once the match is ended or the level is regenerated."),
+	ECVF_Default);
+
+// Seconds between automatic purges during the match
+static TAutoConsoleVariable<float> CVarGCInGamePurgeInterval(
+	TEXT("Bomber.GC.InGamePurgeInterval"),
+	600.f,
+	TEXT("Seconds between automatic garbage collections during the match, is applied to 'gc.TimeBetweenPurgingPendingKillObjects'."),
+	ECVF_Default);
+
+// Time limit of each incremental reachability step during the match
+static TAutoConsoleVariable<float> CVarGCIncrementalReachabilityTimeLimit(
+	TEXT("Bomber.GC.IncrementalReachabilityTimeLimit"),
+	0.002f,
+	TEXT("Seconds of each incremental reachability step during the match, is applied only if the engine supports incremental reachability analysis."),
+	ECVF_Default);
+
+// Returns the pointer to the Garbage Collection Subsystem
+UGarbageCollectionSubsystem* UGarbageCollectionSubsystem::GetGarbageCollectionSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<UGarbageCollectionSubsystem>() : nullptr;
+}
+
+// Requests the full garbage collection on the next tick
+void UGarbageCollectionSubsystem::CollectGarbageAtSafePoint()
+{
+	if (!GEngine
+	    || !CVarGCEnabled.GetValueOnAnyThread())
+	{
+		return;
+	}
+
+	constexpr bool bFullPurge = true;
+	GEngine->ForceGarbageCollection(bFullPurge);
+	UE_LOG(LogBomber, Log, TEXT("Garbage collection is requested on the safe point"));
+}
+
+// Is created only for game worlds
+bool UGarbageCollectionSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Starts listening the game states and the level generation
+void UGarbageCollectionSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (AGeneratedMap* GeneratedMap = UGeneratedMapSubsystem::Get().GetGeneratedMap())
+	{
+		GeneratedMap->OnGeneratedLevelActors.AddUniqueDynamic(this, &ThisClass::OnGeneratedLevelActors);
+	}
+
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(&InWorld))
+	{
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
+	}
+}
+
+// Restores engine settings if the world is left during the match
+void UGarbageCollectionSubsystem::Deinitialize()
+{
+	RestoreCollection();
+
+	Super::Deinitialize();
+}
+
+// Postpones collection on the In-Game state and collects garbage once the match is ended
+void UGarbageCollectionSubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
+{
+	if (CurrentGameState == ECurrentGameState::InGame)
+	{
+		PostponeCollection();
+		return;
+	}
+
+	if (!IsCollectionPostponed())
+	{
+		return;
+	}
+
+	RestoreCollection();
+
+	// Results are shown, so the hitch is not noticeable
+	if (CurrentGameState == ECurrentGameState::EndGame)
+	{
+		CollectGarbageAtSafePoint();
+	}
+}
+
+// Collects garbage once the level is regenerated outside of the match
+void UGarbageCollectionSubsystem::OnGeneratedLevelActors()
+{
+	if (AMyGameStateBase::GetCurrentGameState() != ECurrentGameState::InGame)
+	{
+		CollectGarbageAtSafePoint();
+	}
+}
+
+// Overrides engine settings, so garbage is not collected automatically during the match
+void UGarbageCollectionSubsystem::PostponeCollection()
+{
+	if (!CVarGCEnabled.GetValueOnAnyThread()
+	    || IsCollectionPostponed())
+	{
+		return;
+	}
+
+	OverrideConsoleVariable(TEXT("gc.TimeBetweenPurgingPendingKillObjects"), FString::SanitizeFloat(CVarGCInGamePurgeInterval.GetValueOnAnyThread()));
+
+	// Is not registered by engine versions without incremental reachability analysis, then is skipped
+	OverrideConsoleVariable(TEXT("gc.AllowIncrementalReachability"), TEXT("1"));
+	OverrideConsoleVariable(TEXT("gc.IncrementalReachabilityTimeLimit"), FString::SanitizeFloat(CVarGCIncrementalReachabilityTimeLimit.GetValueOnAnyThread()));
+}
+
+// Restores engine settings overridden by the match
+void UGarbageCollectionSubsystem::RestoreCollection()
+{
+	IConsoleManager& ConsoleManager = IConsoleManager::Get();
+	for (const TTuple<FString, FString>& It : OverriddenConsoleVariablesInternal)
+	{
+		if (IConsoleVariable* ConsoleVariable = ConsoleManager.FindConsoleVariable(*It.Key))
+		{
+			ConsoleVariable->Set(*It.Value, ECVF_SetByCode);
+		}
+	}
+	OverriddenConsoleVariablesInternal.Empty();
+}
+
+// Sets the engine console variable if it exists and remembers its previous value to be restored
+void UGarbageCollectionSubsystem::OverrideConsoleVariable(const TCHAR* Name, const FString& Value)
+{
+	IConsoleVariable* ConsoleVariable = IConsoleManager::Get().FindConsoleVariable(Name);
+	if (!ConsoleVariable)
+	{
+		return;
+	}
+
+	OverriddenConsoleVariablesInternal.Emplace(Name, ConsoleVariable->GetString());
+	ConsoleVariable->Set(*Value, ECVF_SetByCode);
+}
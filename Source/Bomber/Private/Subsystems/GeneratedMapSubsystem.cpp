@@ -4,6 +4,7 @@
 //---
 #include "GeneratedMap.h"
 #include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/PlayWorldSubsystem.h"
 //---
 #if WITH_EDITOR
 #include "MyEditorUtilsLibraries/EditorUtilsLibrary.h"
@@ -22,6 +23,12 @@ UGeneratedMapSubsystem& UGeneratedMapSubsystem::Get()
 // Returns the pointer to the Generated Map Subsystem
 UGeneratedMapSubsystem* UGeneratedMapSubsystem::GetGeneratedMapSubsystem(const UObject* WorldContextObject/* = nullptr*/)
 {
+	if (const UPlayWorldSubsystem* PlayWorldSubsystem = UPlayWorldSubsystem::GetPlayWorldSubsystem(WorldContextObject))
+	{
+		return PlayWorldSubsystem->GetGeneratedMapSubsystem();
+	}
+
+	// Is not a game world, e.g. the editor one
 	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
 	return FoundWorld ? FoundWorld->GetSubsystem<UGeneratedMapSubsystem>() : nullptr;
 }
@@ -41,5 +48,61 @@ void UGeneratedMapSubsystem::SetGeneratedMap(AGeneratedMap* InGeneratedMap)
 	if (ensureMsgf(InGeneratedMap, TEXT("%s: 'InGeneratedMap' is not valid"), *FString(__FUNCTION__)))
 	{
 		GeneratedMapInternal = InGeneratedMap;
+		GeneratedMapsInternal.AddUnique(InGeneratedMap);
+	}
+}
+
+// Removes given Generated Map from registered ones, the next registered map becomes the primary one if it was removed
+void UGeneratedMapSubsystem::UnregisterGeneratedMap(AGeneratedMap* InGeneratedMap)
+{
+	GeneratedMapsInternal.RemoveSwap(InGeneratedMap);
+	if (GeneratedMapInternal == InGeneratedMap)
+	{
+		GeneratedMapInternal = GeneratedMapsInternal.IsEmpty() ? nullptr : GeneratedMapsInternal[0];
+	}
+}
+
+// Returns the Generated Map of the match instance that owns given context object, the primary one if it can't be resolved
+AGeneratedMap* UGeneratedMapSubsystem::GetGeneratedMapByContext(const UObject* ContextObject) const
+{
+	if (GeneratedMapsInternal.Num() <= 1)
+	{
+		// Single match instance, skip the lookup
+		return GetGeneratedMap();
 	}
+
+	const AActor* ContextActor = Cast<AActor>(ContextObject);
+	if (!ContextActor)
+	{
+		const UActorComponent* ContextComponent = Cast<UActorComponent>(ContextObject);
+		ContextActor = ContextComponent ? ContextComponent->GetOwner() : nullptr;
+	}
+
+	if (!ContextActor)
+	{
+		return GetGeneratedMap();
+	}
+
+	// Level actors are spawned by their Generated Map, so the owner chain is the cheapest way
+	for (const AActor* It = ContextActor; It; It = It->GetOwner())
+	{
+		if (AGeneratedMap* OwnerMap = Cast<AGeneratedMap>(const_cast<AActor*>(It)))
+		{
+			return OwnerMap;
+		}
+	}
+
+	// Possessed characters are owned by controllers, so find the grid that contains the actor
+	const FVector Location = ContextActor->GetActorLocation();
+	for (AGeneratedMap* GeneratedMapIt : GeneratedMapsInternal)
+	{
+		const int32 NearestIndex = GeneratedMapIt ? GeneratedMapIt->GetNearestCellIndex(Location) : INDEX_NONE;
+		if (NearestIndex != INDEX_NONE
+		    && FVector::DistSquared2D(GeneratedMapIt->GetCellByIndex(NearestIndex).Location, Location) <= FMath::Square(FCell::CellSize))
+		{
+			return GeneratedMapIt;
+		}
+	}
+
+	return GetGeneratedMap();
 }
@@ -0,0 +1,509 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/GridReplaySubsystem.h"
+//---
+#include "GeneratedMap.h"
+#include "Components/MapComponent.h"
+#include "Controllers/MyAIController.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "LevelActors/PlayerCharacter.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Structures/Cell.h"
+#include "Subsystems/AISchedulerSubsystem.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "Subsystems/GridSimulationSubsystem.h"
+#include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
+//---
+#include "EngineUtils.h"
+#include "TimerManager.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GridReplaySubsystem)
+
+// Is written at the beginning of each replay file: 'GRPL'
+static constexpr uint32 GridReplayMagic = 0x4C505247;
+
+// Is increased on each change of the format
+static constexpr uint8 GridReplayVersion = 1;
+
+// Returns the event as string for logging
+FString FGridReplayEvent::ToString() const
+{
+	return FString::Printf(TEXT("step %lld %s cell %i value %i param %u"), Step, *UEnum::GetValueAsString(Type), CellIndex, Value, Param);
+}
+
+// Reads or writes the replay in the packed binary format
+bool FGridReplay::Serialize(FArchive& Ar)
+{
+	uint32 Magic = GridReplayMagic;
+	uint8 Version = GridReplayVersion;
+	Ar << Magic;
+	Ar << Version;
+	if (Ar.IsError()
+	    || Magic != GridReplayMagic
+	    || Version != GridReplayVersion)
+	{
+		return false;
+	}
+
+	uint8 LevelTypeByte = static_cast<uint8>(LevelType);
+	Ar << Seed;
+	Ar << GridSize;
+	Ar << LevelTypeByte;
+	Ar << StepSeconds;
+	Ar << SlowestStep;
+	Ar << SlowestStepMs;
+	LevelType = static_cast<ELevelType>(LevelTypeByte);
+
+	uint32 EventsNum = Events.Num();
+	Ar.SerializeIntPacked(EventsNum);
+	if (Ar.IsLoading())
+	{
+		Events.SetNum(EventsNum);
+	}
+
+	// Steps are stored as deltas and indices are shifted by one, so most of fields take a single byte
+	int64 PreviousStep = 0;
+	for (FGridReplayEvent& EventIt : Events)
+	{
+		uint32 StepDelta = static_cast<uint32>(EventIt.Step - PreviousStep);
+		uint8 TypeByte = static_cast<uint8>(EventIt.Type);
+		uint32 PackedCellIndex = static_cast<uint32>(EventIt.CellIndex + 1);
+		uint32 PackedValue = static_cast<uint32>(EventIt.Value + 1);
+
+		Ar.SerializeIntPacked(StepDelta);
+		Ar << TypeByte;
+		Ar.SerializeIntPacked(PackedCellIndex);
+		Ar.SerializeIntPacked(PackedValue);
+		Ar << EventIt.Param;
+
+		EventIt.Step = PreviousStep + StepDelta;
+		EventIt.Type = static_cast<EGridReplayEventType>(TypeByte);
+		EventIt.CellIndex = static_cast<int32>(PackedCellIndex) - 1;
+		EventIt.Value = static_cast<int32>(PackedValue) - 1;
+		PreviousStep = EventIt.Step;
+	}
+
+	return !Ar.IsError();
+}
+
+// Returns the pointer to the Grid Replay Subsystem, is null if the game is not recorded or played
+UGridReplaySubsystem* UGridReplaySubsystem::GetGridReplaySubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<UGridReplaySubsystem>() : nullptr;
+}
+
+// Returns true if the game is launched to record matches
+bool UGridReplaySubsystem::IsRecordingEnabled()
+{
+	static const bool bIsRecordingEnabled = FParse::Param(FCommandLine::Get(), TEXT("GridReplayRecord"))
+	                                        || FCString::Strifind(FCommandLine::Get(), TEXT("-GridReplayRecord=")) != nullptr;
+	return bIsRecordingEnabled;
+}
+
+// Returns true if the game is launched to play the replay
+bool UGridReplaySubsystem::IsPlaybackEnabled()
+{
+	static const bool bIsPlaybackEnabled = FCString::Strifind(FCommandLine::Get(), TEXT("-GridReplayPlay=")) != nullptr;
+	return bIsPlaybackEnabled;
+}
+
+// Writes given replay to the file
+bool UGridReplaySubsystem::SaveReplay(FGridReplay& Replay, const FString& FilePath)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	return Replay.Serialize(Writer)
+	       && FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+}
+
+// Reads the replay from the file
+bool UGridReplaySubsystem::LoadReplay(const FString& FilePath, FGridReplay& OutReplay)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	return OutReplay.Serialize(Reader);
+}
+
+// Adds the event of the current simulation step if the match is recorded or played
+void UGridReplaySubsystem::RecordEvent(EGridReplayEventType Type, const FCell& Cell, int32 Value/* = INDEX_NONE*/, uint8 Param/* = 0*/)
+{
+	const UGridSimulationSubsystem* GridSimulationSubsystem = UGridSimulationSubsystem::GetGridSimulationSubsystem(this);
+	if (!IsMatchRunning()
+	    || !GridSimulationSubsystem)
+	{
+		return;
+	}
+
+	// Events between steps belong to the next step, since inputs are applied before the step on playback
+	FGridReplayEvent& Event = RecordedReplayInternal.Events.AddDefaulted_GetRef();
+	Event.Step = GridSimulationSubsystem->GetStepNumber() + 1 - StartStepInternal;
+	Event.Type = Type;
+	Event.CellIndex = AGeneratedMap::Get().GetCellIndex(Cell);
+	Event.Value = Value;
+	Event.Param = Param;
+}
+
+// Is created only for game worlds launched with the -GridReplayRecord or -GridReplayPlay argument
+bool UGridReplaySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && (IsRecordingEnabled() || IsPlaybackEnabled())
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Loads the replay to be played and starts listening the game states
+void UGridReplaySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	if (IsPlaybackEnabled())
+	{
+		FParse::Value(CommandLine, TEXT("GridReplayPlay="), FilePathInternal);
+		if (!LoadReplay(FilePathInternal, PlaybackReplayInternal))
+		{
+			UE_LOG(LogBomber, Error, TEXT("Grid Replay: failed to load '%s'"), *FilePathInternal);
+			return;
+		}
+
+		// Generate the same level as recorded
+		AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+		GeneratedMap.SetGenerationSeedOverride(PlaybackReplayInternal.Seed);
+		GeneratedMap.SetLevelType(PlaybackReplayInternal.LevelType);
+		GeneratedMap.SetLevelSize(PlaybackReplayInternal.GridSize);
+
+		if (!FMath::IsNearlyEqual(PlaybackReplayInternal.StepSeconds, UGridSimulationSubsystem::GetStepSeconds()))
+		{
+			UE_LOG(LogBomber, Warning, TEXT("Grid Replay: is recorded with %.4f seconds per step, but %.4f is set, results could diverge"), PlaybackReplayInternal.StepSeconds, UGridSimulationSubsystem::GetStepSeconds());
+		}
+
+		UE_LOG(LogBomber, Log, TEXT("Grid Replay: playing '%s', seed %i, %i events, %lld steps"), *FilePathInternal, PlaybackReplayInternal.Seed, PlaybackReplayInternal.Events.Num(), PlaybackReplayInternal.GetLastStep());
+	}
+	else if (!FParse::Value(CommandLine, TEXT("GridReplayRecord="), FilePathInternal))
+	{
+		FilePathInternal = FPaths::ProjectSavedDir() / TEXT("GridReplays") / FString::Printf(TEXT("GridReplay_%s.grp"), *FDateTime::Now().ToString());
+	}
+
+	if (UGridSimulationSubsystem* GridSimulationSubsystem = UGridSimulationSubsystem::GetGridSimulationSubsystem(&InWorld))
+	{
+		PreSimulationStepHandle = GridSimulationSubsystem->OnPreSimulationStep.AddUObject(this, &ThisClass::OnPreSimulationStep);
+		SimulationStepHandle = GridSimulationSubsystem->OnSimulationStep.AddUObject(this, &ThisClass::OnSimulationStep);
+	}
+
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(&InWorld))
+	{
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
+
+		// Handle current game state if initialized with delay
+		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
+		{
+			OnGameStateChanged(ECurrentGameState::Menu);
+		}
+	}
+}
+
+// Stops listening simulation steps
+void UGridReplaySubsystem::Deinitialize()
+{
+	if (UGridSimulationSubsystem* GridSimulationSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UGridSimulationSubsystem>() : nullptr)
+	{
+		GridSimulationSubsystem->OnPreSimulationStep.Remove(PreSimulationStepHandle);
+		GridSimulationSubsystem->OnSimulationStep.Remove(SimulationStepHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+// Starts or ends the recording of the match
+void UGridReplaySubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
+{
+	switch (CurrentGameState)
+	{
+		case ECurrentGameState::Menu:
+			if (IsPlaybackEnabled())
+			{
+				StartPlaybackMatch();
+			}
+			break;
+		case ECurrentGameState::InGame:
+			OnMatchStarted();
+			break;
+		case ECurrentGameState::EndGame:
+			OnMatchEnded();
+			break;
+		default:
+			break;
+	}
+}
+
+// Sets the Game Starting state on the next tick to start the playback
+void UGridReplaySubsystem::StartPlaybackMatch()
+{
+	UWorld* World = GetWorld();
+	if (!World
+	    || PlaybackReplayInternal.Events.IsEmpty())
+	{
+		return;
+	}
+
+	World->GetTimerManager().SetTimerForNextTick([WeakThis = TWeakObjectPtr<ThisClass>(this)]()
+	{
+		if (WeakThis.IsValid())
+		{
+			if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(WeakThis.Get()))
+			{
+				MyGameState->ServerSetGameState(ECurrentGameState::GameStarting);
+			}
+		}
+	});
+}
+
+// Remembers the start step and characters of the match, takes the control from characters on playback
+void UGridReplaySubsystem::OnMatchStarted()
+{
+	UWorld* World = GetWorld();
+	const UGridSimulationSubsystem* GridSimulationSubsystem = UGridSimulationSubsystem::GetGridSimulationSubsystem(this);
+	if (!World
+	    || !GridSimulationSubsystem)
+	{
+		return;
+	}
+
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	RecordedReplayInternal = FGridReplay();
+	RecordedReplayInternal.Seed = GeneratedMap.GetGenerationSeed();
+	RecordedReplayInternal.GridSize = GeneratedMap.GetGridSize();
+	RecordedReplayInternal.LevelType = GeneratedMap.GetLevelType();
+	RecordedReplayInternal.StepSeconds = UGridSimulationSubsystem::GetStepSeconds();
+	StartStepInternal = GridSimulationSubsystem->GetStepNumber();
+	NextPlaybackEventInternal = 0;
+
+	CharactersInternal.Reset();
+	for (TActorIterator<APlayerCharacter> It(World); It; ++It)
+	{
+		APlayerCharacter* PlayerCharacter = *It;
+		if (PlayerCharacter
+		    && PlayerCharacter->GetCharacterID() != INDEX_NONE)
+		{
+			CharactersInternal.Emplace(PlayerCharacter->GetCharacterID(), PlayerCharacter);
+		}
+	}
+
+	if (!IsPlaybackEnabled())
+	{
+		return;
+	}
+
+	// Take the control on the next tick, so controllers that enable themselves in-game are handled first
+	World->GetTimerManager().SetTimerForNextTick([WeakThis = TWeakObjectPtr<ThisClass>(this)]()
+	{
+		ThisClass* This = WeakThis.Get();
+		if (!This)
+		{
+			return;
+		}
+
+		UAISchedulerSubsystem* AISchedulerSubsystem = UAISchedulerSubsystem::GetAISchedulerSubsystem(This);
+		for (const TTuple<int32, TWeakObjectPtr<APlayerCharacter>>& CharacterIt : This->CharactersInternal)
+		{
+			APlayerCharacter* PlayerCharacter = CharacterIt.Value.Get();
+			AController* Controller = PlayerCharacter ? PlayerCharacter->GetController() : nullptr;
+			if (AMyAIController* AIController = Cast<AMyAIController>(Controller))
+			{
+				if (AISchedulerSubsystem)
+				{
+					AISchedulerSubsystem->UnregisterBot(AIController);
+				}
+			}
+			else if (APlayerController* PlayerController = Cast<APlayerController>(Controller))
+			{
+				PlayerCharacter->DisableInput(PlayerController);
+				PlayerController->SetIgnoreMoveInput(true);
+			}
+		}
+	});
+}
+
+// Writes the recorded match to the file
+void UGridReplaySubsystem::OnMatchEnded()
+{
+	if (!IsMatchRunning())
+	{
+		return;
+	}
+
+	if (IsPlaybackEnabled())
+	{
+		FinishPlayback();
+		return;
+	}
+
+	StartStepInternal = INDEX_NONE;
+	++RecordedMatchesNumInternal;
+
+	// Next matches are written next to the first one
+	FString MatchFilePath = FilePathInternal;
+	if (RecordedMatchesNumInternal > 1)
+	{
+		MatchFilePath = FPaths::GetPath(FilePathInternal) / FString::Printf(TEXT("%s_%i.%s"), *FPaths::GetBaseFilename(FilePathInternal), RecordedMatchesNumInternal, *FPaths::GetExtension(FilePathInternal));
+	}
+
+	if (SaveReplay(RecordedReplayInternal, MatchFilePath))
+	{
+		UE_LOG(LogBomber, Log, TEXT("Grid Replay: %i events of %lld steps are written to '%s' (%lld bytes), the slowest step %lld took %.3f ms"),
+		       RecordedReplayInternal.Events.Num(), RecordedReplayInternal.GetLastStep(), *MatchFilePath, IFileManager::Get().FileSize(*MatchFilePath),
+		       RecordedReplayInternal.SlowestStep, RecordedReplayInternal.SlowestStepMs);
+	}
+	else
+	{
+		UE_LOG(LogBomber, Error, TEXT("Grid Replay: failed to write '%s'"), *MatchFilePath);
+	}
+}
+
+// Applies recorded inputs of the starting step on playback
+void UGridReplaySubsystem::OnPreSimulationStep(int64 StepNumber)
+{
+	if (!IsMatchRunning()
+	    || !IsPlaybackEnabled())
+	{
+		return;
+	}
+
+	const int64 ReplayStep = StepNumber - StartStepInternal;
+	const TArray<FGridReplayEvent>& Events = PlaybackReplayInternal.Events;
+	while (Events.IsValidIndex(NextPlaybackEventInternal)
+	       && Events[NextPlaybackEventInternal].Step <= ReplayStep)
+	{
+		const FGridReplayEvent& Event = Events[NextPlaybackEventInternal];
+		if (Event.IsInput())
+		{
+			ApplyPlaybackEvent(Event);
+		}
+		++NextPlaybackEventInternal;
+	}
+
+	if (ReplayStep > PlaybackReplayInternal.GetLastStep())
+	{
+		FinishPlayback();
+	}
+}
+
+// Remembers the slowest step of the match
+void UGridReplaySubsystem::OnSimulationStep(int64 StepNumber)
+{
+	const UGridSimulationSubsystem* GridSimulationSubsystem = UGridSimulationSubsystem::GetGridSimulationSubsystem(this);
+	if (!IsMatchRunning()
+	    || !GridSimulationSubsystem)
+	{
+		return;
+	}
+
+	const float StepMs = GridSimulationSubsystem->GetLastStepStats().TotalMs;
+	if (StepMs > RecordedReplayInternal.SlowestStepMs)
+	{
+		RecordedReplayInternal.SlowestStepMs = StepMs;
+		RecordedReplayInternal.SlowestStep = StepNumber - StartStepInternal;
+	}
+}
+
+// Applies recorded input to its character
+void UGridReplaySubsystem::ApplyPlaybackEvent(const FGridReplayEvent& Event)
+{
+	const TWeakObjectPtr<APlayerCharacter>* FoundCharacter = CharactersInternal.Find(Event.Value);
+	APlayerCharacter* PlayerCharacter = FoundCharacter ? FoundCharacter->Get() : nullptr;
+	UMapComponent* MapComponent = UMapComponent::GetMapComponent(PlayerCharacter);
+	if (!MapComponent)
+	{
+		return;
+	}
+
+	AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const FCell& Cell = GeneratedMap.GetCellByIndex(Event.CellIndex);
+	switch (Event.Type)
+	{
+		case EGridReplayEventType::PlayerCellChanged:
+		{
+			// Characters are moved by cells, so the same grid events are reproduced without replaying the movement
+			const FVector NewLocation(Cell.X(), Cell.Y(), PlayerCharacter->GetActorLocation().Z);
+			PlayerCharacter->SetActorLocation(NewLocation);
+			GeneratedMap.SetNearestCell(MapComponent);
+			break;
+		}
+		case EGridReplayEventType::BombPlaced:
+		{
+			if (MapComponent->GetCell() != Cell)
+			{
+				UE_LOG(LogBomber, Warning, TEXT("Grid Replay: character %i is not on the cell of the recorded bomb, %s"), Event.Value, *Event.ToString());
+			}
+			PlayerCharacter->ServerSpawnBomb();
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+// Compares re-simulated results with recorded ones and closes the game if is headless
+void UGridReplaySubsystem::FinishPlayback()
+{
+	if (!IsMatchRunning())
+	{
+		return;
+	}
+
+	StartStepInternal = INDEX_NONE;
+
+	TArray<FGridReplayEvent> ExpectedResults = PlaybackReplayInternal.Events.FilterByPredicate([](const FGridReplayEvent& It) { return !It.IsInput(); });
+	TArray<FGridReplayEvent> ActualResults = RecordedReplayInternal.Events.FilterByPredicate([](const FGridReplayEvent& It) { return !It.IsInput(); });
+
+	int32 DivergedIndex = INDEX_NONE;
+	const int32 ComparedNum = FMath::Max(ExpectedResults.Num(), ActualResults.Num());
+	for (int32 Index = 0; Index < ComparedNum; ++Index)
+	{
+		if (!ExpectedResults.IsValidIndex(Index)
+		    || !ActualResults.IsValidIndex(Index)
+		    || !(ExpectedResults[Index] == ActualResults[Index]))
+		{
+			DivergedIndex = Index;
+			break;
+		}
+	}
+
+	if (DivergedIndex == INDEX_NONE)
+	{
+		UE_LOG(LogBomber, Log, TEXT("Grid Replay: %i results are reproduced exactly"), ExpectedResults.Num());
+	}
+	else
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Grid Replay: results diverge at %i of %i, expected '%s', got '%s'"), DivergedIndex, ExpectedResults.Num(),
+		       ExpectedResults.IsValidIndex(DivergedIndex) ? *ExpectedResults[DivergedIndex].ToString() : TEXT("none"),
+		       ActualResults.IsValidIndex(DivergedIndex) ? *ActualResults[DivergedIndex].ToString() : TEXT("none"));
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Grid Replay: the slowest step %lld took %.3f ms, recorded one %lld took %.3f ms"),
+	       RecordedReplayInternal.SlowestStep, RecordedReplayInternal.SlowestStepMs, PlaybackReplayInternal.SlowestStep, PlaybackReplayInternal.SlowestStepMs);
+
+	if (!FApp::CanEverRender())
+	{
+		constexpr bool bForce = false;
+		FPlatformMisc::RequestExit(bForce);
+	}
+}
@@ -0,0 +1,384 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/GridSimulationSubsystem.h"
+//---
+#include "GeneratedMap.h"
+#include "LevelActors/BombActor.h"
+#include "LevelActors/ItemActor.h"
+#include "LevelActors/PlayerCharacter.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/AISchedulerSubsystem.h"
+//---
+#include "Algo/StableSort.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GridSimulationSubsystem)
+
+// Set the number of simulation steps per second
+static TAutoConsoleVariable<float> CVarSimulationStepRate(
+	TEXT("Bomber.Simulation.StepRate"),
+	30.f,
+	TEXT("Number of grid simulation steps per second: 0 (One step per frame) OR more"),
+	ECVF_Default);
+
+// Limit the number of steps to catch up in one frame
+static TAutoConsoleVariable<int32> CVarSimulationMaxStepsPerFrame(
+	TEXT("Bomber.Simulation.MaxStepsPerFrame"),
+	4,
+	TEXT("Max number of grid simulation steps processed in one frame, the rest of the time is skipped: 1 OR more"),
+	ECVF_Default);
+
+// Run the step as the task graph
+static TAutoConsoleVariable<bool> CVarSimulationTaskPipeline(
+	TEXT("Bomber.Simulation.TaskPipeline"),
+	false,
+	TEXT("Make decisions of bots by the task that overlaps with the rest of the frame, they are applied by the next step: 1 (Task pipeline) OR 0 (Whole step on the game thread)"),
+	ECVF_Default);
+
+// The number of buckets of the fuse wheel, fuses that are longer than one turn wait in their bucket for next turns
+static constexpr int32 FuseWheelSize = 256;
+
+// The length of one slot of the fuse wheel when each frame is one step
+static constexpr double VariableFuseSlotSeconds = 1.0 / 60.0;
+
+// Returns the Grid Simulation Subsystem, is checked and wil crash if can't be obtained
+UGridSimulationSubsystem& UGridSimulationSubsystem::Get(const UObject* WorldContextObject/* = nullptr*/)
+{
+	UGridSimulationSubsystem* GridSimulationSubsystem = GetGridSimulationSubsystem(WorldContextObject);
+	checkf(GridSimulationSubsystem, TEXT("%s: 'GridSimulationSubsystem' is null"), *FString(__FUNCTION__));
+	return *GridSimulationSubsystem;
+}
+
+// Returns the pointer to the Grid Simulation Subsystem
+UGridSimulationSubsystem* UGridSimulationSubsystem::GetGridSimulationSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<UGridSimulationSubsystem>() : nullptr;
+}
+
+// Returns the length of one step in seconds, 0 if each frame is one step
+float UGridSimulationSubsystem::GetStepSeconds()
+{
+	const float StepRate = CVarSimulationStepRate.GetValueOnAnyThread();
+	return StepRate > 0.f ? 1.f / StepRate : 0.f;
+}
+
+// Detonates given bomb on the first step that reaches its detonation time
+void UGridSimulationSubsystem::ScheduleBomb(ABombActor* Bomb, double DetonationTime)
+{
+	if (!ensureMsgf(Bomb, TEXT("ASSERT: [%i] %s:\n'Bomb' is not valid!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	UnscheduleBomb(Bomb);
+
+	if (FusesInternal.IsEmpty())
+	{
+		// Slot length could be changed only while no fuse is burning, otherwise stored slots would be wrong
+		const float StepSeconds = GetStepSeconds();
+		FuseSlotSecondsInternal = StepSeconds > 0.f ? StepSeconds : VariableFuseSlotSeconds;
+		const double CurrentTime = SimulationTimeInternal >= 0.0 ? SimulationTimeInternal : GetWorld()->GetTimeSeconds();
+		LastFuseSlotInternal = GetFuseSlot(CurrentTime) - 1;
+		FuseWheelInternal.SetNum(FuseWheelSize);
+	}
+
+	// Fuses in the past are put to the next collected slot
+	FGridSimulationBomb& Fuse = FusesInternal.Add(Bomb);
+	Fuse.Bomb = Bomb;
+	Fuse.DetonationTime = DetonationTime;
+	Fuse.Slot = FMath::Max(GetFuseSlot(DetonationTime), LastFuseSlotInternal + 1);
+	FuseWheelInternal[Fuse.Slot % FuseWheelSize].Emplace(Bomb);
+}
+
+// Cancels the detonation of given bomb if it is scheduled
+void UGridSimulationSubsystem::UnscheduleBomb(const ABombActor* Bomb)
+{
+	FGridSimulationBomb Fuse;
+	if (FusesInternal.RemoveAndCopyValue(Bomb, Fuse))
+	{
+		FuseWheelInternal[Fuse.Slot % FuseWheelSize].RemoveSingle(Bomb);
+	}
+}
+
+// Cancels the fuse of given bomb and detonates it right away
+void UGridSimulationSubsystem::DetonateBombNow(ABombActor* Bomb)
+{
+	if (!Bomb)
+	{
+		return;
+	}
+
+	UnscheduleBomb(Bomb);
+	Bomb->DetonateBomb();
+}
+
+// Returns the world time in seconds when given bomb is going to explode
+float UGridSimulationSubsystem::GetBombDetonationTime(const ABombActor* Bomb) const
+{
+	const FGridSimulationBomb* Fuse = FusesInternal.Find(Bomb);
+	return Fuse ? static_cast<float>(Fuse->DetonationTime) : MAX_flt;
+}
+
+// Returns seconds left until given bomb explodes
+float UGridSimulationSubsystem::GetBombFuseRemaining(const ABombActor* Bomb) const
+{
+	const FGridSimulationBomb* Fuse = FusesInternal.Find(Bomb);
+	const UWorld* World = GetWorld();
+	return Fuse && World ? FMath::Max(0.f, static_cast<float>(Fuse->DetonationTime - World->GetTimeSeconds())) : MAX_flt;
+}
+
+// Picks up given item by given player on the next step
+void UGridSimulationSubsystem::QueuePickup(AItemActor* Item, APlayerCharacter* Player)
+{
+	if (!ensureMsgf(Item, TEXT("ASSERT: [%i] %s:\n'Item' is not valid!"), __LINE__, *FString(__FUNCTION__))
+	    || !ensureMsgf(Player, TEXT("ASSERT: [%i] %s:\n'Player' is not valid!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	FGridSimulationPickup& Pickup = PendingPickupsInternal.AddDefaulted_GetRef();
+	Pickup.Item = Item;
+	Pickup.Player = Player;
+}
+
+// Is created only for game worlds
+bool UGridSimulationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Is ticked only on the server
+bool UGridSimulationSubsystem::IsTickable() const
+{
+	const UWorld* World = GetWorld();
+	return World
+	       && World->GetNetMode() != NM_Client
+	       && !bIsSimulationPausedInternal;
+}
+
+// Stops or resumes processing of steps, so bots and fuses are not updated while the server is idle
+void UGridSimulationSubsystem::SetSimulationPaused(bool bPause)
+{
+	if (bIsSimulationPausedInternal == bPause)
+	{
+		return;
+	}
+
+	bIsSimulationPausedInternal = bPause;
+
+	if (!bPause)
+	{
+		// Align the next step to the time of resuming, so the paused time is not caught up
+		SimulationTimeInternal = -1.0;
+	}
+}
+
+// Runs all steps that are due by current world time
+void UGridSimulationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double WorldTime = GetWorld()->GetTimeSeconds();
+	if (SimulationTimeInternal < 0.0)
+	{
+		// The first step is aligned to the time when the simulation is started
+		SimulationTimeInternal = WorldTime;
+	}
+
+	const float StepSeconds = GetStepSeconds();
+	if (StepSeconds <= 0.f)
+	{
+		// Variable step: whole frame is one step
+		const float FrameSeconds = static_cast<float>(WorldTime - SimulationTimeInternal);
+		SimulationTimeInternal = WorldTime;
+		ProcessStep(FrameSeconds);
+		return;
+	}
+
+	const int32 MaxSteps = FMath::Max(1, CVarSimulationMaxStepsPerFrame.GetValueOnGameThread());
+	int32 StepsNum = 0;
+	while (SimulationTimeInternal + StepSeconds <= WorldTime)
+	{
+		if (StepsNum >= MaxSteps)
+		{
+			// Skip the rest of the hitch instead of spiraling
+			SimulationTimeInternal = WorldTime;
+			break;
+		}
+
+		SimulationTimeInternal += StepSeconds;
+		ProcessStep(StepSeconds);
+		++StepsNum;
+	}
+}
+
+// Returns the stat id of this tickable object
+TStatId UGridSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGridSimulationSubsystem, STATGROUP_Tickables);
+}
+
+// Processes all phases of one step in their order
+void UGridSimulationSubsystem::ProcessStep(float StepSeconds)
+{
+	FGridSimulationStepStats StepStats;
+	StepStats.StepNumber = LastStepStatsInternal.StepNumber + 1;
+
+	OnPreSimulationStep.Broadcast(StepStats.StepNumber);
+
+	const double StartTime = FPlatformTime::Seconds();
+	double PhaseTime = StartTime;
+	auto FinishPhase = [&PhaseTime]()
+	{
+		const double CurrentTime = FPlatformTime::Seconds();
+		const float PhaseMs = static_cast<float>((CurrentTime - PhaseTime) * 1000.0);
+		PhaseTime = CurrentTime;
+		return PhaseMs;
+	};
+
+	UAISchedulerSubsystem* AISchedulerSubsystem = UAISchedulerSubsystem::GetAISchedulerSubsystem(this);
+	const bool bTaskPipeline = CVarSimulationTaskPipeline.GetValueOnGameThread();
+
+	// ----- Apply -----
+	if (AISchedulerSubsystem)
+	{
+		// Decisions of the previous step are applied before anything is changed by this step, it's also done when the pipeline is just disabled
+		AISchedulerSubsystem->ApplyLaunchedDecisions();
+		StepStats.DecisionsMs = bTaskPipeline ? AISchedulerSubsystem->GetLastDecisionsMs() : 0.f;
+		StepStats.DecisionsWaitMs = bTaskPipeline ? AISchedulerSubsystem->GetLastDecisionsWaitMs() : 0.f;
+	}
+	StepStats.ApplyMs = FinishPhase();
+
+	// ----- Bomb timers -----
+	TArray<FGridSimulationBomb> DueBombs;
+	CollectDueBombs(DueBombs);
+	StepStats.BombTimersMs = FinishPhase();
+
+	// ----- Explosions -----
+	DetonateBombs(DueBombs);
+	StepStats.ExplosionsMs = FinishPhase();
+
+	// ----- Pickups -----
+	ProcessPickups();
+	StepStats.PickupsMs = FinishPhase();
+
+	// ----- Snapshot -----
+	TSharedPtr<const FAIWorldSnapshot, ESPMode::ThreadSafe> SharedSnapshot = nullptr;
+	if (bTaskPipeline
+	    && AISchedulerSubsystem
+	    && AISchedulerSubsystem->GetBotsNum())
+	{
+		SharedSnapshot = AGeneratedMap::Get(this).GetSharedWorldSnapshot();
+	}
+	StepStats.SnapshotMs = FinishPhase();
+
+	// ----- AI -----
+	if (AISchedulerSubsystem)
+	{
+		if (SharedSnapshot.IsValid())
+		{
+			AISchedulerSubsystem->LaunchDecisions(SharedSnapshot.ToSharedRef());
+		}
+		else if (!bTaskPipeline)
+		{
+			AISchedulerSubsystem->UpdateBots(StepSeconds);
+		}
+	}
+	StepStats.AIMs = FinishPhase();
+
+	StepStats.TotalMs = static_cast<float>((PhaseTime - StartTime) * 1000.0);
+	LastStepStatsInternal = StepStats;
+
+	OnSimulationStep.Broadcast(StepStats.StepNumber);
+}
+
+// Returns the absolute slot of the fuse wheel for given world time
+int64 UGridSimulationSubsystem::GetFuseSlot(double Time) const
+{
+	return FuseSlotSecondsInternal > 0.0 ? FMath::FloorToInt64(Time / FuseSlotSecondsInternal) : 0;
+}
+
+// Moves all bombs whose detonation time has come from the fuse wheel to given array sorted by their detonation time
+void UGridSimulationSubsystem::CollectDueBombs(TArray<FGridSimulationBomb>& OutDueBombs)
+{
+	const int64 CurrentSlot = GetFuseSlot(SimulationTimeInternal);
+	if (FusesInternal.IsEmpty())
+	{
+		LastFuseSlotInternal = CurrentSlot - 1;
+		return;
+	}
+
+	// Each bucket is visited once even after a long hitch, the slot of the fuse tells whether its turn has come
+	const int64 FirstSlot = FMath::Max(LastFuseSlotInternal + 1, CurrentSlot - FuseWheelSize + 1);
+	for (int64 SlotIt = FirstSlot; SlotIt <= CurrentSlot; ++SlotIt)
+	{
+		TArray<TObjectKey<ABombActor>>& BucketBombs = FuseWheelInternal[SlotIt % FuseWheelSize];
+		for (int32 Index = 0; Index < BucketBombs.Num();)
+		{
+			const FGridSimulationBomb* Fuse = FusesInternal.Find(BucketBombs[Index]);
+			const bool bIsDue = Fuse
+			                    && Fuse->Slot <= SlotIt
+			                    && (Fuse->Slot < CurrentSlot || Fuse->DetonationTime <= SimulationTimeInternal);
+			if (Fuse && !bIsDue)
+			{
+				// Waits for next turns of the wheel or for the end of the current slot
+				++Index;
+				continue;
+			}
+
+			if (Fuse)
+			{
+				OutDueBombs.Emplace(*Fuse);
+				FusesInternal.Remove(BucketBombs[Index]);
+			}
+			BucketBombs.RemoveAt(Index);
+		}
+	}
+
+	// The current slot could still have fuses that burn until its end
+	LastFuseSlotInternal = CurrentSlot - 1;
+
+	Algo::StableSortBy(OutDueBombs, &FGridSimulationBomb::DetonationTime);
+}
+
+// Detonates given bombs in their order
+void UGridSimulationSubsystem::DetonateBombs(const TArray<FGridSimulationBomb>& DueBombs)
+{
+	for (const FGridSimulationBomb& FuseIt : DueBombs)
+	{
+		// Bombs that were triggered by an earlier bomb of this step are already exploded and skip detonation by themselves
+		if (ABombActor* Bomb = FuseIt.Bomb.Get())
+		{
+			Bomb->DetonateBomb();
+		}
+	}
+}
+
+// Picks up all pending items in the order of overlapping
+void UGridSimulationSubsystem::ProcessPickups()
+{
+	if (PendingPickupsInternal.IsEmpty())
+	{
+		return;
+	}
+
+	// Swap to allow new pickups be queued while processing
+	TArray<FGridSimulationPickup> Pickups = MoveTemp(PendingPickupsInternal);
+	PendingPickupsInternal.Reset();
+
+	for (const FGridSimulationPickup& PickupIt : Pickups)
+	{
+		AItemActor* Item = PickupIt.Item.Get();
+		APlayerCharacter* Player = PickupIt.Player.Get();
+		if (Item
+		    && Player
+		    && !Item->IsHidden())
+		{
+			// Item is hidden once picked up, so other players that overlapped it in the same step are skipped
+			Item->PickUp(*Player);
+		}
+	}
+}
@@ -0,0 +1,359 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/GridSpectatorSubsystem.h"
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Components/MapComponent.h"
+#include "Controllers/MyPlayerController.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "LevelActors/ItemActor.h"
+#include "LevelActors/PlayerCharacter.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Structures/Cell.h"
+#include "Subsystems/GridSimulationSubsystem.h"
+#include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
+//---
+#include "EngineUtils.h"
+#include "TimerManager.h"
+#include "GameFramework/PlayerState.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(GridSpectatorSubsystem)
+
+// Allows clients to join as spectators that receive the match as the stream of grid events
+static TAutoConsoleVariable<bool> CVarSpectatorEnabled(
+	TEXT("Bomber.Spectator.Enabled"),
+	true,
+	TEXT("Allows clients to join with 'SpectatorOnly=1' to watch the match as the stream of grid events instead of replicated level actors, is read on world creation."),
+	ECVF_Default);
+
+// How many times per second positions of players are sent to spectators
+static TAutoConsoleVariable<float> CVarSpectatorPlayersRate(
+	TEXT("Bomber.Spectator.PlayersRate"),
+	5.f,
+	TEXT("How many times per second positions of players are sent to spectators, clients interpolate between them."),
+	ECVF_Default);
+
+// Returns the pointer to the Grid Spectator Subsystem, is null if spectators are disabled
+UGridSpectatorSubsystem* UGridSpectatorSubsystem::GetGridSpectatorSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<UGridSpectatorSubsystem>() : nullptr;
+}
+
+// Returns true if given viewer is the spectator that watches the stream
+bool UGridSpectatorSubsystem::IsStreamViewer(const AActor* RealViewer)
+{
+	const APlayerController* PlayerController = Cast<APlayerController>(RealViewer);
+	const APlayerState* PlayerState = PlayerController ? PlayerController->PlayerState : nullptr;
+	return PlayerState
+	       && PlayerState->IsOnlyASpectator();
+}
+
+// Server-only: starts streaming to given spectator beginning with the current layout
+void UGridSpectatorSubsystem::AddSpectator(AMyPlayerController* Spectator)
+{
+	UWorld* World = GetWorld();
+	if (!Spectator
+	    || !World
+	    || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	SpectatorsInternal.AddUnique(Spectator);
+	SendLayout(*Spectator);
+
+	if (!PlayersTimerInternal.IsValid())
+	{
+		const float PlayersRate = FMath::Max(CVarSpectatorPlayersRate.GetValueOnAnyThread(), 0.1f);
+		World->GetTimerManager().SetTimer(PlayersTimerInternal, this, &ThisClass::SendPlayers, 1.f / PlayersRate, /*bLoop*/true);
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Grid Spectator: '%s' joined, %i spectators"), *Spectator->GetName(), SpectatorsInternal.Num());
+}
+
+// Server-only: stops streaming to given spectator
+void UGridSpectatorSubsystem::RemoveSpectator(const AMyPlayerController* Spectator)
+{
+	SpectatorsInternal.RemoveAll([Spectator](const TWeakObjectPtr<AMyPlayerController>& SpectatorIt)
+	{
+		return !SpectatorIt.IsValid() || SpectatorIt.Get() == Spectator;
+	});
+
+	if (SpectatorsInternal.IsEmpty())
+	{
+		PendingEventsInternal.Events.Reset();
+		if (UWorld* World = GetWorld())
+		{
+			World->GetTimerManager().ClearTimer(PlayersTimerInternal);
+		}
+	}
+}
+
+// Server-only: adds the event to be sent to spectators at the end of the current simulation step
+void UGridSpectatorSubsystem::AddEvent(EGridReplayEventType Type, const FCell& Cell, int32 Value/* = INDEX_NONE*/, uint8 Param/* = 0*/)
+{
+	const UGridSimulationSubsystem* GridSimulationSubsystem = UGridSimulationSubsystem::GetGridSimulationSubsystem(this);
+	if (!HasSpectators()
+	    || !GridSimulationSubsystem)
+	{
+		return;
+	}
+
+	// Events between steps belong to the next step, the same as in the replay
+	FGridReplayEvent& Event = PendingEventsInternal.Events.AddDefaulted_GetRef();
+	Event.Step = GridSimulationSubsystem->GetStepNumber() + 1;
+	Event.Type = Type;
+	Event.CellIndex = AGeneratedMap::Get(this).GetCellIndex(Cell);
+	Event.Value = Value;
+	Event.Param = Param;
+}
+
+// Client-only: replaces the local grid by received layout
+void UGridSpectatorSubsystem::ApplyLayout(const FGridSpectatorLayout& Layout)
+{
+	if (!Layout.IsValid())
+	{
+		return;
+	}
+
+	LayoutInternal = Layout;
+	ItemTypesInternal.Reset();
+	PlayersInternal.Players.Reset();
+
+	if (OnSpectatorLayoutChanged.IsBound())
+	{
+		OnSpectatorLayoutChanged.Broadcast();
+	}
+}
+
+// Client-only: applies received events to the local grid in their order
+void UGridSpectatorSubsystem::ApplyEvents(const FGridSpectatorEvents& Events)
+{
+	for (const FGridReplayEvent& EventIt : Events.Events)
+	{
+		if (EventIt.Step < LayoutInternal.Step
+		    || !LayoutInternal.CellActorTypes.IsValidIndex(EventIt.CellIndex))
+		{
+			// Is already contained in the layout or is sent for another grid
+			continue;
+		}
+
+		uint8& CellActorTypes = LayoutInternal.CellActorTypes[EventIt.CellIndex];
+		switch (EventIt.Type)
+		{
+			case EGridReplayEventType::BombPlaced:
+				CellActorTypes |= TO_FLAG(EAT::Bomb);
+				break;
+			case EGridReplayEventType::ActorDestroyed:
+				CellActorTypes &= ~EventIt.Param;
+				if (EventIt.Param & TO_FLAG(EAT::Item))
+				{
+					ItemTypesInternal.Remove(EventIt.CellIndex);
+				}
+				break;
+			case EGridReplayEventType::ItemPicked:
+				CellActorTypes &= ~TO_FLAG(EAT::Item);
+				ItemTypesInternal.Remove(EventIt.CellIndex);
+				break;
+			case EGridReplayEventType::ItemSpawned:
+				CellActorTypes |= TO_FLAG(EAT::Item);
+				ItemTypesInternal.Emplace(EventIt.CellIndex, EventIt.Param);
+				break;
+			default:
+				// Detonations are only notified, exploded actors come as destroyed ones
+				break;
+		}
+
+		if (OnSpectatorEvent.IsBound())
+		{
+			OnSpectatorEvent.Broadcast(EventIt);
+		}
+	}
+}
+
+// Client-only: remembers received player positions
+void UGridSpectatorSubsystem::ApplyPlayers(const FGridSpectatorPlayers& Players)
+{
+	PlayersInternal = Players;
+}
+
+// Returns EActorType bitmask of the cell on the locally rebuilt grid
+int32 UGridSpectatorSubsystem::GetCellActorTypes(int32 CellIndex) const
+{
+	return LayoutInternal.CellActorTypes.IsValidIndex(CellIndex) ? LayoutInternal.CellActorTypes[CellIndex] : TO_FLAG(EAT::None);
+}
+
+// Is created for game worlds when the 'Bomber.Spectator.Enabled' is set
+bool UGridSpectatorSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && CVarSpectatorEnabled.GetValueOnAnyThread()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Starts listening simulation steps and game states on the server
+void UGridSpectatorSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	if (UGridSimulationSubsystem* GridSimulationSubsystem = UGridSimulationSubsystem::GetGridSimulationSubsystem(&InWorld))
+	{
+		SimulationStepHandle = GridSimulationSubsystem->OnSimulationStep.AddUObject(this, &ThisClass::OnSimulationStep);
+	}
+
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(&InWorld))
+	{
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
+	}
+}
+
+// Stops listening simulation steps
+void UGridSpectatorSubsystem::Deinitialize()
+{
+	if (UGridSimulationSubsystem* GridSimulationSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UGridSimulationSubsystem>() : nullptr)
+	{
+		GridSimulationSubsystem->OnSimulationStep.Remove(SimulationStepHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+// Resends the layout on match start since the level is regenerated
+void UGridSpectatorSubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
+{
+	if (CurrentGameState != ECurrentGameState::InGame)
+	{
+		return;
+	}
+
+	CharactersInternal.Reset();
+	for (TActorIterator<APlayerCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->GetCharacterID() != INDEX_NONE)
+		{
+			CharactersInternal.Emplace(*It);
+		}
+	}
+
+	// Events before the start are contained in the new layout
+	PendingEventsInternal.Events.Reset();
+	for (const TWeakObjectPtr<AMyPlayerController>& SpectatorIt : SpectatorsInternal)
+	{
+		if (AMyPlayerController* Spectator = SpectatorIt.Get())
+		{
+			SendLayout(*Spectator);
+		}
+	}
+}
+
+// Sends pending events of finished step to all spectators
+void UGridSpectatorSubsystem::OnSimulationStep(int64 StepNumber)
+{
+	if (PendingEventsInternal.Events.IsEmpty())
+	{
+		return;
+	}
+
+	for (const TWeakObjectPtr<AMyPlayerController>& SpectatorIt : SpectatorsInternal)
+	{
+		if (AMyPlayerController* Spectator = SpectatorIt.Get())
+		{
+			Spectator->ClientReceiveSpectatorEvents(PendingEventsInternal);
+		}
+	}
+
+	PendingEventsInternal.Events.Reset();
+}
+
+// Returns the current grid as the layout to be sent
+FGridSpectatorLayout UGridSpectatorSubsystem::MakeLayout() const
+{
+	FGridSpectatorLayout Layout;
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	Layout.GridSize = GeneratedMap.GetGridSize();
+
+	const UGridSimulationSubsystem* GridSimulationSubsystem = UGridSimulationSubsystem::GetGridSimulationSubsystem(this);
+	Layout.Step = GridSimulationSubsystem ? GridSimulationSubsystem->GetStepNumber() + 1 : 0;
+
+	const int32 CellsNum = Layout.GridSize.X * Layout.GridSize.Y;
+	Layout.CellActorTypes.SetNumUninitialized(CellsNum);
+	for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+	{
+		Layout.CellActorTypes[CellIndex] = static_cast<uint8>(GeneratedMap.GetActorTypesOnCellIndex(CellIndex));
+	}
+
+	return Layout;
+}
+
+// Sends the current grid to given spectator together with types of items that are already on the level
+void UGridSpectatorSubsystem::SendLayout(AMyPlayerController& Spectator) const
+{
+	const FGridSpectatorLayout Layout = MakeLayout();
+	if (!Layout.IsValid())
+	{
+		return;
+	}
+
+	Spectator.ClientReceiveSpectatorLayout(Layout);
+
+	// The layout keeps only actor types, so types of existing items are sent as their spawn events
+	FGridSpectatorEvents ItemEvents;
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get(this);
+	for (TActorIterator<AItemActor> It(GetWorld()); It; ++It)
+	{
+		const UMapComponent* MapComponent = UMapComponent::GetMapComponent(*It);
+		const int32 CellIndex = MapComponent && !It->IsHidden() ? GeneratedMap.GetCellIndex(MapComponent->GetCell()) : INDEX_NONE;
+		if (CellIndex != INDEX_NONE)
+		{
+			FGridReplayEvent& Event = ItemEvents.Events.AddDefaulted_GetRef();
+			Event.Step = Layout.Step;
+			Event.Type = EGridReplayEventType::ItemSpawned;
+			Event.CellIndex = CellIndex;
+			Event.Param = static_cast<uint8>(It->GetItemType());
+		}
+	}
+
+	if (!ItemEvents.Events.IsEmpty())
+	{
+		Spectator.ClientReceiveSpectatorEvents(ItemEvents);
+	}
+}
+
+// Sends positions of alive players to all spectators
+void UGridSpectatorSubsystem::SendPlayers()
+{
+	if (AMyGameStateBase::GetCurrentGameState() != ECurrentGameState::InGame)
+	{
+		return;
+	}
+
+	FGridSpectatorPlayers Players;
+	for (const TWeakObjectPtr<APlayerCharacter>& CharacterIt : CharactersInternal)
+	{
+		const APlayerCharacter* PlayerCharacter = CharacterIt.Get();
+		if (PlayerCharacter
+		    && !PlayerCharacter->IsHidden())
+		{
+			FGridSpectatorPlayer& Player = Players.Players.AddDefaulted_GetRef();
+			Player.CharacterID = PlayerCharacter->GetCharacterID();
+			Player.Location = PlayerCharacter->GetActorLocation();
+		}
+	}
+
+	for (const TWeakObjectPtr<AMyPlayerController>& SpectatorIt : SpectatorsInternal)
+	{
+		if (AMyPlayerController* Spectator = SpectatorIt.Get())
+		{
+			Spectator->ClientReceiveSpectatorPlayers(Players);
+		}
+	}
+}
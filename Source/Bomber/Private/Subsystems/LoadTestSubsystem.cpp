@@ -0,0 +1,347 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/LoadTestSubsystem.h"
+//---
+#include "Bomber.h"
+#include "Engine/BomberNetStats.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
+//---
+#include "TimerManager.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(LoadTestSubsystem)
+
+// Returns the pointer to the Load Test Subsystem, is null if the load test is not enabled
+ULoadTestSubsystem* ULoadTestSubsystem::GetLoadTestSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<ULoadTestSubsystem>() : nullptr;
+}
+
+// Returns true if the server is launched to run the load test
+bool ULoadTestSubsystem::IsLoadTestEnabled()
+{
+	static const bool bIsLoadTestEnabled = FParse::Param(FCommandLine::Get(), TEXT("LoadTest"))
+	                                       || FCString::Strifind(FCommandLine::Get(), TEXT("-LoadTest=")) != nullptr;
+	return bIsLoadTestEnabled;
+}
+
+// Returns true if the game is launched as the simulated client of the load test
+bool ULoadTestSubsystem::IsLoadTestClient()
+{
+	static const bool bIsLoadTestClient = FParse::Param(FCommandLine::Get(), TEXT("LoadTestClient"));
+	return bIsLoadTestClient;
+}
+
+// Returns the number of launched clients that are still running
+int32 ULoadTestSubsystem::GetRunningClientsNum() const
+{
+	int32 RunningNum = 0;
+	for (const FProcHandle& ProcessIt : ClientProcessesInternal)
+	{
+		FProcHandle Process = ProcessIt;
+		RunningNum += FPlatformProcess::IsProcRunning(Process) ? 1 : 0;
+	}
+	return RunningNum;
+}
+
+// Is created only for game worlds launched with the -LoadTest argument
+bool ULoadTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && IsLoadTestEnabled()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Launches clients, starts listening the game states and measuring ticks
+void ULoadTestSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client
+	    || InWorld.GetNetMode() == NM_Standalone)
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Load test: is skipped, the game has to be launched as the server"));
+		return;
+	}
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	FParse::Value(CommandLine, TEXT("LoadTest="), ClientsNumInternal);
+	ClientsNumInternal = FMath::Max(0, ClientsNumInternal);
+	FParse::Value(CommandLine, TEXT("LoadTestMinutes="), DurationMinutesInternal);
+	DurationMinutesInternal = FMath::Max(0.f, DurationMinutesInternal);
+
+	if (!FParse::Value(CommandLine, TEXT("LoadTestOutput="), OutputFilePathInternal))
+	{
+		OutputFilePathInternal = FPaths::ProfilingDir() / TEXT("LoadTest") / FString::Printf(TEXT("LoadTest_%s.csv"), *FDateTime::Now().ToString());
+	}
+
+	const FString Header = TEXT("Date,Seconds,Clients,Connections,GameState,Ticks,AverageTickMs,MaxTickMs,AverageReplicationMs,OutKBps,AverageConnectionOutKBps,MaxConnectionOutKBps,AverageConnectionInKBps\n");
+	FFileHelper::SaveStringToFile(Header, *OutputFilePathInternal);
+
+	// Traffic by its source is counted along, to show what takes the bandwidth measured here
+	if (IConsoleVariable* NetProfilingCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Bomber.Net.Profiling")))
+	{
+		NetProfilingCVar->Set(true);
+	}
+	FBomberNetStats::Reset();
+
+	LoadStartTimeInternal = FPlatformTime::Seconds();
+	LastSampleTimeInternal = LoadStartTimeInternal;
+	MenuStartTimeInternal = LoadStartTimeInternal;
+	const UNetDriver* NetDriver = InWorld.GetNetDriver();
+	LastOutBytesInternal = NetDriver ? NetDriver->OutTotalBytes : 0;
+
+	WorldTickStartHandleInternal = FWorldDelegates::OnWorldTickStart.AddUObject(this, &ThisClass::OnWorldTickStart);
+	TickFlushHandleInternal = InWorld.OnTickFlush().AddUObject(this, &ThisClass::OnTickFlush);
+	PostTickFlushHandleInternal = InWorld.OnPostTickFlush().AddUObject(this, &ThisClass::OnPostTickFlush);
+	FrameTickerHandleInternal = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnFrameTick));
+
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(&InWorld))
+	{
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
+	}
+
+	LaunchClients(InWorld);
+
+	UE_LOG(LogBomber, Log, TEXT("Load test: %i clients, %s, samples are written to '%s'"), ClientsNumInternal,
+	       DurationMinutesInternal > 0.f ? *FString::Printf(TEXT("%.1f minutes"), DurationMinutesInternal) : TEXT("not limited"), *OutputFilePathInternal);
+}
+
+// Stops measuring and closes launched clients
+void ULoadTestSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(FrameTickerHandleInternal);
+	FrameTickerHandleInternal.Reset();
+
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandleInternal);
+	if (UWorld* World = GetWorld())
+	{
+		World->OnTickFlush().Remove(TickFlushHandleInternal);
+		World->OnPostTickFlush().Remove(PostTickFlushHandleInternal);
+	}
+
+	if (LoadStartTimeInternal > 0.0)
+	{
+		FBomberNetStats::Dump();
+	}
+
+	for (FProcHandle& ProcessIt : ClientProcessesInternal)
+	{
+		if (FPlatformProcess::IsProcRunning(ProcessIt))
+		{
+			constexpr bool bKillTree = true;
+			FPlatformProcess::TerminateProc(ProcessIt, bKillTree);
+		}
+		FPlatformProcess::CloseProc(ProcessIt);
+	}
+	ClientProcessesInternal.Empty();
+
+	Super::Deinitialize();
+}
+
+// Launches given number of headless clients connected to this server
+void ULoadTestSubsystem::LaunchClients(const UWorld& InWorld)
+{
+	// The server executable can't run clients, so the game executable next to it is taken by default
+	FString ClientExecutable;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("LoadTestClientExe="), ClientExecutable))
+	{
+		ClientExecutable = FString(FPlatformProcess::ExecutablePath()).Replace(TEXT("Server"), TEXT(""));
+	}
+
+	if (!FPaths::FileExists(ClientExecutable))
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Load test: client executable '%s' is not found, set it by -LoadTestClientExe"), *ClientExecutable);
+		return;
+	}
+
+	const FString ServerAddress = FString::Printf(TEXT("127.0.0.1:%i"), InWorld.URL.Port);
+	for (int32 ClientIndex = 0; ClientIndex < ClientsNumInternal; ++ClientIndex)
+	{
+		// No rendering, audio and cosmetics on clients, they only receive the replication
+		const FString ClientParams = FString::Printf(TEXT("%s -game -nullrhi -nosound -unattended -nosplash -LoadTestClient -log=LoadTestClient_%i.log"), *ServerAddress, ClientIndex);
+
+		constexpr bool bLaunchDetached = true;
+		constexpr bool bLaunchHidden = true;
+		constexpr bool bLaunchReallyHidden = true;
+		FProcHandle Process = FPlatformProcess::CreateProc(*ClientExecutable, *ClientParams, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, nullptr, nullptr);
+		if (Process.IsValid())
+		{
+			ClientProcessesInternal.Emplace(Process);
+		}
+		else
+		{
+			UE_LOG(LogBomber, Warning, TEXT("Load test: client %i could not be launched by '%s'"), ClientIndex, *ClientExecutable);
+		}
+	}
+}
+
+// Moves the game to the next state of the cycle
+void ULoadTestSubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
+{
+	switch (CurrentGameState)
+	{
+		case ECurrentGameState::Menu:
+			// The match is started by the frame tick once all clients are connected
+			MenuStartTimeInternal = FPlatformTime::Seconds();
+			bIsMatchStartPendingInternal = false;
+			break;
+		case ECurrentGameState::EndGame:
+			SetGameStateDelayed(ECurrentGameState::Menu, MenuDelay);
+			break;
+		default:
+			break;
+	}
+}
+
+// Sets given game state after the delay, so all listeners of the current state are notified first
+void ULoadTestSubsystem::SetGameStateDelayed(ECurrentGameState NewGameState, float Delay)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	FTimerHandle TimerHandle;
+	World->GetTimerManager().SetTimer(TimerHandle, [WeakThis = TWeakObjectPtr<ThisClass>(this), NewGameState]()
+	{
+		if (WeakThis.IsValid())
+		{
+			if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(WeakThis.Get()))
+			{
+				MyGameState->ServerSetGameState(NewGameState);
+			}
+		}
+	}, Delay, /*bLoop*/false);
+}
+
+// Is called when the world starts ticking
+void ULoadTestSubsystem::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaTime)
+{
+	if (InWorld == GetWorld())
+	{
+		WorldTickStartTimeInternal = FPlatformTime::Seconds();
+	}
+}
+
+// Is called when the world starts flushing the net driver
+void ULoadTestSubsystem::OnTickFlush(float DeltaTime)
+{
+	TickFlushStartTimeInternal = FPlatformTime::Seconds();
+}
+
+// Is called when the net driver of the world is flushed, ends the measured world tick
+void ULoadTestSubsystem::OnPostTickFlush()
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+	if (TickFlushStartTimeInternal > 0.0)
+	{
+		ReplicationSecondsInternal += CurrentTime - TickFlushStartTimeInternal;
+		TickFlushStartTimeInternal = 0.0;
+	}
+
+	if (WorldTickStartTimeInternal > 0.0)
+	{
+		// Is the busy time of the server without the wait of its tick rate
+		const double TickSeconds = CurrentTime - WorldTickStartTimeInternal;
+		TickSecondsInternal += TickSeconds;
+		MaxTickSecondsInternal = FMath::Max(MaxTickSecondsInternal, TickSeconds);
+		++TicksNumInternal;
+		WorldTickStartTimeInternal = 0.0;
+	}
+}
+
+// Writes the sample once per second, starts the match once clients are connected and finishes the load test once the duration is passed
+bool ULoadTestSubsystem::OnFrameTick(float DeltaTime)
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+	if (CurrentTime - LastSampleTimeInternal < 1.0)
+	{
+		return true;
+	}
+
+	WriteSample();
+
+	const UWorld* World = GetWorld();
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	const int32 ConnectionsNum = NetDriver ? NetDriver->ClientConnections.Num() : 0;
+	if (!bIsMatchStartPendingInternal
+	    && AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::Menu
+	    && (ConnectionsNum >= ClientsNumInternal || CurrentTime - MenuStartTimeInternal >= ConnectTimeout))
+	{
+		bIsMatchStartPendingInternal = true;
+		SetGameStateDelayed(ECurrentGameState::GameStarting, MenuDelay);
+	}
+
+	if (DurationMinutesInternal > 0.f
+	    && CurrentTime - LoadStartTimeInternal >= DurationMinutesInternal * 60.0)
+	{
+		UE_LOG(LogBomber, Log, TEXT("Load test: finished after %.1f minutes"), DurationMinutesInternal);
+		constexpr bool bForce = false;
+		FPlatformMisc::RequestExit(bForce);
+		return false;
+	}
+
+	return true;
+}
+
+// Writes all measured values since the last sample to the CSV file and resets them
+void ULoadTestSubsystem::WriteSample()
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+	const double SampleSeconds = FMath::Max(CurrentTime - LastSampleTimeInternal, UE_SMALL_NUMBER);
+	LastSampleTimeInternal = CurrentTime;
+
+	const UWorld* World = GetWorld();
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+
+	// Rates of each connection are already averaged per second by the net driver
+	int32 ConnectionsNum = 0;
+	int64 ConnectionsOutBytesPerSecond = 0;
+	int64 ConnectionsInBytesPerSecond = 0;
+	int32 MaxConnectionOutBytesPerSecond = 0;
+	if (NetDriver)
+	{
+		for (const UNetConnection* ConnectionIt : NetDriver->ClientConnections)
+		{
+			if (ConnectionIt)
+			{
+				++ConnectionsNum;
+				ConnectionsOutBytesPerSecond += ConnectionIt->OutBytesPerSecond;
+				ConnectionsInBytesPerSecond += ConnectionIt->InBytesPerSecond;
+				MaxConnectionOutBytesPerSecond = FMath::Max(MaxConnectionOutBytesPerSecond, ConnectionIt->OutBytesPerSecond);
+			}
+		}
+	}
+
+	const uint64 OutBytes = NetDriver ? NetDriver->OutTotalBytes : 0;
+	const double OutKBps = static_cast<double>(OutBytes - FMath::Min(OutBytes, LastOutBytesInternal)) / 1024.0 / SampleSeconds;
+	LastOutBytesInternal = OutBytes;
+
+	const double AverageTickMs = TicksNumInternal ? TickSecondsInternal * 1000.0 / TicksNumInternal : 0.0;
+	const double AverageReplicationMs = TicksNumInternal ? ReplicationSecondsInternal * 1000.0 / TicksNumInternal : 0.0;
+	const double AverageConnectionOutKBps = ConnectionsNum ? ConnectionsOutBytesPerSecond / 1024.0 / ConnectionsNum : 0.0;
+	const double AverageConnectionInKBps = ConnectionsNum ? ConnectionsInBytesPerSecond / 1024.0 / ConnectionsNum : 0.0;
+
+	const FString Row = FString::Printf(TEXT("%s,%.1f,%i,%i,%i,%i,%.3f,%.3f,%.3f,%.2f,%.2f,%.2f,%.2f\n"),
+	                                    *FDateTime::Now().ToString(), CurrentTime - LoadStartTimeInternal, GetRunningClientsNum(), ConnectionsNum,
+	                                    static_cast<int32>(AMyGameStateBase::GetCurrentGameState()), TicksNumInternal,
+	                                    AverageTickMs, MaxTickSecondsInternal * 1000.0, AverageReplicationMs,
+	                                    OutKBps, AverageConnectionOutKBps, MaxConnectionOutBytesPerSecond / 1024.0, AverageConnectionInKBps);
+	FFileHelper::SaveStringToFile(Row, *OutputFilePathInternal, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	TickSecondsInternal = 0.0;
+	MaxTickSecondsInternal = 0.0;
+	TicksNumInternal = 0;
+	ReplicationSecondsInternal = 0.0;
+}
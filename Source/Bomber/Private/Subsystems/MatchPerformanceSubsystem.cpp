@@ -0,0 +1,241 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/MatchPerformanceSubsystem.h"
+//---
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Controllers/MyAIController.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
+//---
+#include "EngineUtils.h"
+#include "Engine/NetDriver.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(MatchPerformanceSubsystem)
+
+// Returns the pointer to the Match Performance Subsystem, is null if the report is not enabled
+UMatchPerformanceSubsystem* UMatchPerformanceSubsystem::GetMatchPerformanceSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<UMatchPerformanceSubsystem>() : nullptr;
+}
+
+// Returns true if the game is launched to write match performance reports
+bool UMatchPerformanceSubsystem::IsReportEnabled()
+{
+	static const bool bIsReportEnabled = FParse::Param(FCommandLine::Get(), TEXT("MatchPerfReport"))
+	                                     || FCString::Strifind(FCommandLine::Get(), TEXT("-MatchPerfReport=")) != nullptr;
+	return bIsReportEnabled;
+}
+
+// Is called by bombs to count resolved explosions of the current match
+void UMatchPerformanceSubsystem::AddExplosions(int32 ExplosionsNum)
+{
+	if (bIsMatchMeasuredInternal)
+	{
+		ExplosionsNumInternal += ExplosionsNum;
+	}
+}
+
+// Is called by the Generated Map to count the time of destroying level actors of the current match
+void UMatchPerformanceSubsystem::AddDestroyLevelActorsTime(double Seconds)
+{
+	if (bIsMatchMeasuredInternal)
+	{
+		++DestroyLevelActorsCallsInternal;
+		DestroyLevelActorsSecondsInternal += Seconds;
+	}
+}
+
+// Is created only for game worlds launched with the -MatchPerfReport argument
+bool UMatchPerformanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && IsReportEnabled()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Starts listening the game states
+void UMatchPerformanceSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	if (!FParse::Value(FCommandLine::Get(), TEXT("MatchPerfReport="), OutputFilePathInternal))
+	{
+		OutputFilePathInternal = FPaths::ProfilingDir() / TEXT("MatchPerformance") / TEXT("MatchPerformance.csv");
+	}
+
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(&InWorld))
+	{
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Match performance reports are appended to '%s'"), *OutputFilePathInternal);
+}
+
+// Stops sampling frames
+void UMatchPerformanceSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(FrameTickerHandleInternal);
+	FrameTickerHandleInternal.Reset();
+
+	Super::Deinitialize();
+}
+
+// Starts measuring on the In-Game state and writes the report on the End-Game state
+void UMatchPerformanceSubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
+{
+	switch (CurrentGameState)
+	{
+		case ECurrentGameState::InGame:
+			OnMatchStarted();
+			break;
+		case ECurrentGameState::EndGame:
+			OnMatchEnded();
+			break;
+		default:
+			break;
+	}
+}
+
+// Resets all counters and starts sampling frames
+void UMatchPerformanceSubsystem::OnMatchStarted()
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	bIsMatchMeasuredInternal = true;
+	MatchStartTimeInternal = FPlatformTime::Seconds();
+	FrameTimesInternal.Reset();
+	ExplosionsNumInternal = 0;
+	DestroyLevelActorsCallsInternal = 0;
+	DestroyLevelActorsSecondsInternal = 0.0;
+	PeakMapComponentsNumInternal = 0;
+	MatchStartOutBytesInternal = GetOutBytes();
+
+	for (TActorIterator<AMyAIController> It(World); It; ++It)
+	{
+		It->ResetDecisionStats();
+	}
+
+	if (!FrameTickerHandleInternal.IsValid())
+	{
+		FrameTickerHandleInternal = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnFrameTick));
+	}
+}
+
+// Writes the report of the finished match
+void UMatchPerformanceSubsystem::OnMatchEnded()
+{
+	const UWorld* World = GetWorld();
+	if (!World
+	    || !bIsMatchMeasuredInternal)
+	{
+		return;
+	}
+
+	bIsMatchMeasuredInternal = false;
+	FTSTicker::GetCoreTicker().RemoveTicker(FrameTickerHandleInternal);
+	FrameTickerHandleInternal.Reset();
+	++ReportedMatchesNumInternal;
+
+	const double MatchLength = FPlatformTime::Seconds() - MatchStartTimeInternal;
+
+	// ----- Frame times -----
+
+	double AverageFrameMs = 0.0;
+	double P99FrameMs = 0.0;
+	const int32 FramesNum = FrameTimesInternal.Num();
+	if (FramesNum)
+	{
+		double TotalSeconds = 0.0;
+		for (const float FrameTimeIt : FrameTimesInternal)
+		{
+			TotalSeconds += FrameTimeIt;
+		}
+
+		FrameTimesInternal.Sort();
+		const int32 P99Index = FMath::Min(FramesNum - 1, FMath::FloorToInt32(FramesNum * 0.99));
+		AverageFrameMs = TotalSeconds * 1000.0 / FramesNum;
+		P99FrameMs = FrameTimesInternal[P99Index] * 1000.0;
+	}
+
+	// ----- AI time per bot -----
+
+	int32 BotsNum = 0;
+	double TotalAIMs = 0.0;
+	double MaxDecisionMs = 0.0;
+	for (TActorIterator<AMyAIController> It(World); It; ++It)
+	{
+		const FAIDecisionStats& DecisionStats = It->GetDecisionStats();
+		if (!DecisionStats.DecisionsNum)
+		{
+			continue;
+		}
+
+		++BotsNum;
+		TotalAIMs += DecisionStats.TotalSeconds * 1000.0;
+		MaxDecisionMs = FMath::Max(MaxDecisionMs, DecisionStats.MaxSeconds * 1000.0);
+	}
+	const double AIMsPerBot = BotsNum ? TotalAIMs / BotsNum : 0.0;
+
+	// ----- Network -----
+
+	const uint64 OutBytes = GetOutBytes() - MatchStartOutBytesInternal;
+
+	// ----- Writing -----
+
+	const AGeneratedMap* GeneratedMap = UGeneratedMapSubsystem::Get().GetGeneratedMap();
+	const FIntPoint GridSize = GeneratedMap ? GeneratedMap->GetGridSize() : FIntPoint::ZeroValue;
+
+	FString Row;
+	if (!IFileManager::Get().FileExists(*OutputFilePathInternal))
+	{
+		Row = TEXT("Date,GridSize,MatchLength,Frames,AverageFrameMs,P99FrameMs,Bots,AIMsPerBot,MaxDecisionMs,Explosions,DestroyLevelActorsCalls,DestroyLevelActorsMs,PeakMapComponents,OutBytes\n");
+	}
+
+	Row += FString::Printf(TEXT("%s,%dx%d,%.2f,%i,%.3f,%.3f,%i,%.3f,%.4f,%i,%i,%.3f,%i,%llu\n"),
+	                       *FDateTime::Now().ToString(), GridSize.X, GridSize.Y, MatchLength, FramesNum, AverageFrameMs, P99FrameMs,
+	                       BotsNum, AIMsPerBot, MaxDecisionMs, ExplosionsNumInternal,
+	                       DestroyLevelActorsCallsInternal, DestroyLevelActorsSecondsInternal * 1000.0, PeakMapComponentsNumInternal, OutBytes);
+
+	FFileHelper::SaveStringToFile(Row, *OutputFilePathInternal, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	UE_LOG(LogBomber, Log, TEXT("Match performance: %.1f s, frame %.2f ms (p99 %.2f ms), AI %.2f ms per bot, %i explosions, destroying %.2f ms, peak %i level actors, %llu bytes sent"),
+	       MatchLength, AverageFrameMs, P99FrameMs, AIMsPerBot, ExplosionsNumInternal, DestroyLevelActorsSecondsInternal * 1000.0, PeakMapComponentsNumInternal, OutBytes);
+}
+
+// Samples the frame time and the number of level actors during the match
+bool UMatchPerformanceSubsystem::OnFrameTick(float DeltaTime)
+{
+	FrameTimesInternal.Emplace(DeltaTime);
+
+	if (const AGeneratedMap* GeneratedMap = UGeneratedMapSubsystem::Get().GetGeneratedMap())
+	{
+		PeakMapComponentsNumInternal = FMath::Max(PeakMapComponentsNumInternal, GeneratedMap->GetMapComponentsNum());
+	}
+
+	return true;
+}
+
+// Returns the number of bytes sent by the game net driver, 0 for the standalone game
+uint64 UMatchPerformanceSubsystem::GetOutBytes() const
+{
+	const UWorld* World = GetWorld();
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	return NetDriver ? NetDriver->OutTotalBytes : 0;
+}
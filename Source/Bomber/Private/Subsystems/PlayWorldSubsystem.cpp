@@ -0,0 +1,92 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/PlayWorldSubsystem.h"
+//---
+#include "DataAssets/SoundsDataAsset.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "Subsystems/SoundsSubsystem.h"
+//---
+#include "Engine/World.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(PlayWorldSubsystem)
+
+TArray<TWeakObjectPtr<UPlayWorldSubsystem>> UPlayWorldSubsystem::PlayWorldSubsystems;
+
+// Returns the subsystem of the world of given context object or of the current play world, nullptr if it is not a game world
+UPlayWorldSubsystem* UPlayWorldSubsystem::GetPlayWorldSubsystem(const UObject* OptionalWorldContext/* = nullptr*/)
+{
+	if (const UWorld* World = OptionalWorldContext ? OptionalWorldContext->GetWorld() : nullptr)
+	{
+		return World->GetSubsystem<UPlayWorldSubsystem>();
+	}
+
+	// The PIE instance is set by the engine for the world that is currently ticked
+	const int32 PlayWorldIndex = GPlayInEditorID + 1;
+	return PlayWorldSubsystems.IsValidIndex(PlayWorldIndex) ? PlayWorldSubsystems[PlayWorldIndex].Get() : nullptr;
+}
+
+// Returns the Bomber Game State of this world, nullptr if it is not spawned yet
+AMyGameStateBase* UPlayWorldSubsystem::GetMyGameState() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetGameState<AMyGameStateBase>() : nullptr;
+}
+
+// Returns the Sounds Subsystem of this world, is resolved on first request since its class is set in the data asset
+USoundsSubsystem* UPlayWorldSubsystem::GetSoundsSubsystem() const
+{
+	if (!SoundsSubsystemInternal)
+	{
+		const UWorld* World = GetWorld();
+		const TSubclassOf<USoundsSubsystem> SoundsSubsystemClass = USoundsDataAsset::Get().GetSoundsSubsystemClass();
+		SoundsSubsystemInternal = World ? Cast<USoundsSubsystem>(World->GetSubsystemBase(SoundsSubsystemClass)) : nullptr;
+	}
+
+	return SoundsSubsystemInternal;
+}
+
+// Returns the index of given world in PlayWorldSubsystems
+int32 UPlayWorldSubsystem::GetPlayWorldIndex(const UWorld& World)
+{
+	// Is INDEX_NONE out of PIE
+	const int32 PIEInstanceID = World.GetOutermost()->GetPIEInstanceID();
+	return FMath::Max(PIEInstanceID, INDEX_NONE) + 1;
+}
+
+// Is created only for game worlds, since the editor world is resolved by the editor context
+bool UPlayWorldSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+// Registers this world as current play world of its PIE instance
+void UPlayWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	GeneratedMapSubsystemInternal = Collection.InitializeDependency<UGeneratedMapSubsystem>();
+
+	const int32 PlayWorldIndex = GetPlayWorldIndex(*GetWorld());
+	if (!PlayWorldSubsystems.IsValidIndex(PlayWorldIndex))
+	{
+		PlayWorldSubsystems.SetNum(PlayWorldIndex + 1);
+	}
+	PlayWorldSubsystems[PlayWorldIndex] = this;
+}
+
+// Unregisters this world if it is still current one of its PIE instance
+void UPlayWorldSubsystem::Deinitialize()
+{
+	const int32 PlayWorldIndex = GetPlayWorldIndex(*GetWorld());
+	if (PlayWorldSubsystems.IsValidIndex(PlayWorldIndex)
+	    && PlayWorldSubsystems[PlayWorldIndex] == this) // a new world could be already registered during travel
+	{
+		PlayWorldSubsystems[PlayWorldIndex].Reset();
+	}
+
+	GeneratedMapSubsystemInternal = nullptr;
+	SoundsSubsystemInternal = nullptr;
+
+	Super::Deinitialize();
+}
@@ -0,0 +1,267 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/RenderWarmUpSubsystem.h"
+//---
+#include "Bomber.h"
+#include "DataAssets/BombDataAsset.h"
+#include "DataAssets/DataAssetsContainer.h"
+#include "DataAssets/GeneratedMapDataAsset.h"
+#include "DataAssets/LevelActorDataAsset.h"
+#include "DataAssets/PlayerDataAsset.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/DataAssetsPreloadSubsystem.h"
+#include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
+//---
+#include "NiagaraComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraSystem.h"
+#include "TimerManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(RenderWarmUpSubsystem)
+
+static TAutoConsoleVariable<bool> CVarWarmUpEnabled(
+	TEXT("Bomber.WarmUp.Enabled"),
+	true,
+	TEXT("If true, render states of level actors and explosions are warmed up on clients while the menu is shown to avoid PSO hitches on their first render."),
+	ECVF_Default);
+
+namespace RenderWarmUp
+{
+	/** Warm-up components are placed far below the level, so they are never seen. */
+	static const FVector HiddenLocation(0.f, 0.f, -100000.f);
+}
+
+// Returns the pointer to the Render Warm Up Subsystem, is null on the dedicated server
+URenderWarmUpSubsystem* URenderWarmUpSubsystem::GetRenderWarmUpSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<URenderWarmUpSubsystem>() : nullptr;
+}
+
+// Is created only for game worlds that render, so not on the dedicated server
+bool URenderWarmUpSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && !IsRunningDedicatedServer()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Starts the warm-up once all data assets are loaded and starts listening the game states
+void URenderWarmUpSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (!CVarWarmUpEnabled.GetValueOnAnyThread()
+	    || InWorld.GetNetMode() == NM_DedicatedServer)
+	{
+		bIsWarmedUpInternal = true;
+		return;
+	}
+
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(&InWorld))
+	{
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
+	}
+
+	UDataAssetsPreloadSubsystem* PreloadSubsystem = UDataAssetsPreloadSubsystem::GetDataAssetsPreloadSubsystem(&InWorld);
+	if (!PreloadSubsystem)
+	{
+		StartWarmUp();
+		return;
+	}
+
+	PreloadSubsystem->CallOrWaitPreloaded(UDataAssetsPreloadSubsystem::FOnDataAssetsPreloaded::FDelegate::CreateUObject(this, &ThisClass::StartWarmUp));
+}
+
+// Destroys the warm-up actor if it is still alive
+void URenderWarmUpSubsystem::Deinitialize()
+{
+	FinishWarmUp();
+
+	Super::Deinitialize();
+}
+
+// Creates warm-up components for all level types, precaches their PSOs and activates the explosion VFX
+void URenderWarmUpSubsystem::StartWarmUp()
+{
+	UWorld* World = GetWorld();
+	if (!World
+	    || WarmUpActorInternal)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	WarmUpActorInternal = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(RenderWarmUp::HiddenLocation), SpawnParameters);
+	if (!WarmUpActorInternal)
+	{
+		return;
+	}
+	WarmUpActorInternal->SetRootComponent(NewObject<USceneComponent>(WarmUpActorInternal, TEXT("WarmUpRoot")));
+	WarmUpActorInternal->GetRootComponent()->RegisterComponent();
+
+	// Only level types that are actually played are warmed up
+	int32 LevelTypesBitmask = 0;
+	TArray<FLevelStreamRow> LevelStreamRows;
+	UGeneratedMapDataAsset::Get().GetLevelStreamRows(LevelStreamRows);
+	for (const FLevelStreamRow& LevelStreamRowIt : LevelStreamRows)
+	{
+		LevelTypesBitmask |= TO_FLAG(LevelStreamRowIt.LevelType);
+	}
+
+	// --- Meshes of walls, boxes, items and players by all level types, bombs are warmed up with each of their materials
+	const UBombDataAsset& BombDataAsset = UBombDataAsset::Get();
+	static constexpr EActorType ActorTypes[] = {EAT::Wall, EAT::Box, EAT::Item, EAT::Bomb, EAT::Player};
+	for (const EActorType ActorTypeIt : ActorTypes)
+	{
+		const ULevelActorDataAsset* DataAsset = UDataAssetsContainer::GetDataAssetByActorType(ActorTypeIt);
+		if (!DataAsset)
+		{
+			continue;
+		}
+
+		TArray<ULevelActorRow*> Rows;
+		DataAsset->GetRowsByLevelType(Rows, LevelTypesBitmask);
+		for (const ULevelActorRow* RowIt : Rows)
+		{
+			UStreamableRenderAsset* Mesh = RowIt ? RowIt->Mesh : nullptr;
+			if (!Mesh)
+			{
+				continue;
+			}
+
+			WarmUpMesh(Mesh);
+
+			if (ActorTypeIt == EAT::Bomb)
+			{
+				for (int32 Index = 0; Index < BombDataAsset.GetBombMaterialsNum(); ++Index)
+				{
+					WarmUpMesh(Mesh, BombDataAsset.GetBombMaterial(Index));
+				}
+			}
+			else if (const UPlayerRow* PlayerRow = Cast<UPlayerRow>(RowIt))
+			{
+				for (int32 SkinIndex = 0; SkinIndex < PlayerRow->GetMaterialInstancesDynamicNum(); ++SkinIndex)
+				{
+					WarmUpMesh(Mesh, PlayerRow->GetMaterialInstanceDynamic(SkinIndex));
+				}
+			}
+		}
+	}
+
+	// --- The explosion VFX, is the most common hitch on the first bomb
+	if (UNiagaraSystem* ExplosionVFX = BombDataAsset.GetExplosionVFX())
+	{
+		UNiagaraComponent* NiagaraComponent = NewObject<UNiagaraComponent>(WarmUpActorInternal);
+		NiagaraComponent->SetupAttachment(WarmUpActorInternal->GetRootComponent());
+		NiagaraComponent->SetAsset(ExplosionVFX);
+		NiagaraComponent->RegisterComponent();
+		NiagaraComponent->PrecachePSOs();
+		NiagaraComponent->Activate(/*bReset*/true);
+		++WarmedUpComponentsNumInternal;
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Render warm-up: %i components are created in %.3f ms"), WarmedUpComponentsNumInternal, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	World->GetTimerManager().SetTimer(WarmUpTimerInternal, this, &ThisClass::FinishWarmUp, WarmUpSeconds, /*bLoop*/false);
+}
+
+// Creates the transient component out of view with given mesh and material, then precaches its PSOs
+void URenderWarmUpSubsystem::WarmUpMesh(UStreamableRenderAsset* Mesh, UMaterialInterface* Material/* = nullptr*/)
+{
+	UMeshComponent* MeshComponent = nullptr;
+	if (UStaticMesh* StaticMesh = Cast<UStaticMesh>(Mesh))
+	{
+		UStaticMeshComponent* StaticMeshComponent = NewObject<UStaticMeshComponent>(WarmUpActorInternal);
+		StaticMeshComponent->SetStaticMesh(StaticMesh);
+		MeshComponent = StaticMeshComponent;
+	}
+	else if (USkeletalMesh* SkeletalMesh = Cast<USkeletalMesh>(Mesh))
+	{
+		USkeletalMeshComponent* SkeletalMeshComponent = NewObject<USkeletalMeshComponent>(WarmUpActorInternal);
+		SkeletalMeshComponent->SetSkeletalMesh(SkeletalMesh);
+		MeshComponent = SkeletalMeshComponent;
+	}
+
+	if (!MeshComponent)
+	{
+		return;
+	}
+
+	if (Material)
+	{
+		for (int32 MaterialIndex = 0; MaterialIndex < MeshComponent->GetNumMaterials(); ++MaterialIndex)
+		{
+			MeshComponent->SetMaterial(MaterialIndex, Material);
+		}
+	}
+
+	MeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	MeshComponent->SetCastShadow(false);
+	MeshComponent->SetupAttachment(WarmUpActorInternal->GetRootComponent());
+	MeshComponent->RegisterComponent();
+	MeshComponent->PrecachePSOs();
+	++WarmedUpComponentsNumInternal;
+}
+
+// Destroys the warm-up actor with all its components
+void URenderWarmUpSubsystem::FinishWarmUp()
+{
+	const UWorld* World = GetWorld();
+	if (World)
+	{
+		World->GetTimerManager().ClearTimer(WarmUpTimerInternal);
+	}
+
+	if (IsValid(WarmUpActorInternal)
+	    && World
+	    && !World->bIsTearingDown)
+	{
+		WarmUpActorInternal->Destroy();
+	}
+	WarmUpActorInternal = nullptr;
+	bIsWarmedUpInternal = true;
+}
+
+// Prewarms explosions on the Game Starting state
+void URenderWarmUpSubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
+{
+	if (CurrentGameState == ECurrentGameState::GameStarting)
+	{
+		PrewarmExplosionVFX();
+	}
+}
+
+// Spawns pooled explosions out of view by the explosion tier of current game settings
+void URenderWarmUpSubsystem::PrewarmExplosionVFX()
+{
+	const UBombDataAsset& BombDataAsset = UBombDataAsset::Get();
+	UNiagaraSystem* ExplosionVFX = BombDataAsset.GetExplosionVFX();
+	const int32 PrewarmNum = BombDataAsset.GetExplosionVFXTier().PrewarmNum;
+	if (!ExplosionVFX
+	    || PrewarmNum <= 0)
+	{
+		return;
+	}
+
+	constexpr bool bAutoDestroy = false;
+	constexpr bool bAutoActivate = true;
+	for (int32 Index = 0; Index < PrewarmNum; ++Index)
+	{
+		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, ExplosionVFX, RenderWarmUp::HiddenLocation, FRotator::ZeroRotator, FVector::OneVector, bAutoDestroy, bAutoActivate, ENCPoolMethod::AutoRelease);
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Render warm-up: %i explosions are prewarmed in the Niagara pool"), PrewarmNum);
+}
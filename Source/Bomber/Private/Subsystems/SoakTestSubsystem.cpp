@@ -0,0 +1,290 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Subsystems/SoakTestSubsystem.h"
+//---
+#include "Bomber.h"
+#include "GameFramework/MyGameStateBase.h"
+#include "MyUtilsLibraries/UtilsLibrary.h"
+#include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
+//---
+#include "EngineUtils.h"
+#include "NiagaraComponent.h"
+#include "PoolManagerSubsystem.h"
+#include "TimerManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/TextRenderComponent.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "UObject/UObjectIterator.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(SoakTestSubsystem)
+
+namespace SoakTest
+{
+/** Names of metrics, are used both for the CSV header and logs. */
+static const TCHAR* MetricNames[] = {
+	TEXT("UsedMemoryMB"),
+	TEXT("UObjects"),
+	TEXT("PooledActors"),
+	TEXT("TextRenders"),
+	TEXT("NiagaraComponents"),
+	TEXT("MeshInstances"),
+	TEXT("AverageFrameMs")
+};
+static_assert(UE_ARRAY_COUNT(MetricNames) == static_cast<int32>(ESoakTestMetric::Num), "Each metric has to be named");
+
+/** Returns the number of components of given class that belong to given world. */
+template <typename T>
+int32 CountWorldComponents(const UWorld& World)
+{
+	int32 Num = 0;
+	for (TObjectIterator<T> It; It; ++It)
+	{
+		if (IsValid(*It)
+		    && It->GetWorld() == &World)
+		{
+			++Num;
+		}
+	}
+	return Num;
+}
+}
+
+// Returns the pointer to the Soak Test Subsystem, is null if the soak test is not enabled
+USoakTestSubsystem* USoakTestSubsystem::GetSoakTestSubsystem(const UObject* WorldContextObject/* = nullptr*/)
+{
+	const UWorld* FoundWorld = UUtilsLibrary::GetPlayWorld(WorldContextObject);
+	return FoundWorld ? FoundWorld->GetSubsystem<USoakTestSubsystem>() : nullptr;
+}
+
+// Returns true if the game is launched to run the soak test
+bool USoakTestSubsystem::IsSoakTestEnabled()
+{
+	static const bool bIsSoakTestEnabled = FParse::Param(FCommandLine::Get(), TEXT("SoakTest"))
+	                                       || FCString::Strifind(FCommandLine::Get(), TEXT("-SoakTest=")) != nullptr;
+	return bIsSoakTestEnabled;
+}
+
+// Is created only for game worlds launched with the -SoakTest argument
+bool USoakTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Outer ? Outer->GetWorld() : nullptr;
+	return World
+	       && World->IsGameWorld()
+	       && IsSoakTestEnabled()
+	       && Super::ShouldCreateSubsystem(Outer);
+}
+
+// Starts listening the game states and sampling frames
+void USoakTestSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	FParse::Value(CommandLine, TEXT("SoakTest="), DurationHoursInternal);
+	DurationHoursInternal = FMath::Max(0.f, DurationHoursInternal);
+
+	if (!FParse::Value(CommandLine, TEXT("SoakTestOutput="), OutputFilePathInternal))
+	{
+		OutputFilePathInternal = FPaths::ProfilingDir() / TEXT("SoakTest") / FString::Printf(TEXT("SoakTest_%s.csv"), *FDateTime::Now().ToString());
+	}
+
+	FString Header = TEXT("Date,Match,UptimeMinutes");
+	for (const TCHAR* MetricNameIt : SoakTest::MetricNames)
+	{
+		Header += FString::Printf(TEXT(",%s"), MetricNameIt);
+	}
+	Header += TEXT(",Growing\n");
+	FFileHelper::SaveStringToFile(Header, *OutputFilePathInternal);
+
+	SoakStartTimeInternal = FPlatformTime::Seconds();
+	FrameTickerHandleInternal = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnFrameTick));
+
+	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(&InWorld))
+	{
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
+
+		// Handle current game state if initialized with delay
+		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
+		{
+			OnGameStateChanged(ECurrentGameState::Menu);
+		}
+	}
+
+	UE_LOG(LogBomber, Log, TEXT("Soak test: %s, samples are written to '%s'"),
+	       DurationHoursInternal > 0.f ? *FString::Printf(TEXT("%.1f hours"), DurationHoursInternal) : TEXT("not limited"), *OutputFilePathInternal);
+}
+
+// Stops sampling frames
+void USoakTestSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(FrameTickerHandleInternal);
+	FrameTickerHandleInternal.Reset();
+
+	Super::Deinitialize();
+}
+
+// Moves the game to the next state of the cycle
+void USoakTestSubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
+{
+	switch (CurrentGameState)
+	{
+		case ECurrentGameState::Menu:
+			SetGameStateDelayed(ECurrentGameState::GameStarting, MenuDelay);
+			break;
+		case ECurrentGameState::InGame:
+			MatchFrameSecondsInternal = 0.0;
+			MatchFramesNumInternal = 0;
+			break;
+		case ECurrentGameState::EndGame:
+			OnMatchEnded();
+			break;
+		default:
+			break;
+	}
+}
+
+// Sets given game state after the delay, so all listeners of the current state are notified first
+void USoakTestSubsystem::SetGameStateDelayed(ECurrentGameState NewGameState, float Delay)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	FTimerHandle TimerHandle;
+	World->GetTimerManager().SetTimer(TimerHandle, [WeakThis = TWeakObjectPtr<ThisClass>(this), NewGameState]()
+	{
+		if (WeakThis.IsValid())
+		{
+			if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState(WeakThis.Get()))
+			{
+				MyGameState->ServerSetGameState(NewGameState);
+			}
+		}
+	}, Delay, /*bLoop*/false);
+}
+
+// Samples all metrics of the finished match, writes them and closes the game once the duration is passed
+void USoakTestSubsystem::OnMatchEnded()
+{
+	++FinishedMatchesNumInternal;
+	const double UptimeMinutes = (FPlatformTime::Seconds() - SoakStartTimeInternal) / 60.0;
+
+	FString Row = FString::Printf(TEXT("%s,%i,%.1f"), *FDateTime::Now().ToString(), FinishedMatchesNumInternal, UptimeMinutes);
+	FString GrowingMetrics;
+	for (int32 MetricIndex = 0; MetricIndex < static_cast<int32>(ESoakTestMetric::Num); ++MetricIndex)
+	{
+		const double Value = SampleMetric(static_cast<ESoakTestMetric>(MetricIndex));
+		Row += FString::Printf(TEXT(",%.2f"), Value);
+
+		TArray<double>& Samples = SamplesInternal[MetricIndex];
+		Samples.Emplace(Value);
+		if (Samples.Num() > GrowthWindow)
+		{
+			Samples.RemoveAt(0, Samples.Num() - GrowthWindow, /*bAllowShrinking*/false);
+		}
+
+		// Is flagged only when the whole window is filled and each sample is larger than the previous one
+		bool bIsGrowing = Samples.Num() == GrowthWindow;
+		for (int32 SampleIndex = 1; bIsGrowing && SampleIndex < Samples.Num(); ++SampleIndex)
+		{
+			bIsGrowing = Samples[SampleIndex] > Samples[SampleIndex - 1];
+		}
+
+		if (bIsGrowing)
+		{
+			GrowingMetrics += GrowingMetrics.IsEmpty() ? TEXT("") : TEXT(" ");
+			GrowingMetrics += SoakTest::MetricNames[MetricIndex];
+		}
+	}
+	Row += FString::Printf(TEXT(",%s\n"), *GrowingMetrics);
+
+	FFileHelper::SaveStringToFile(Row, *OutputFilePathInternal, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	if (!GrowingMetrics.IsEmpty())
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Soak test: '%s' grew after each of the last %i matches (match %i, %.1f minutes of uptime)"), *GrowingMetrics, GrowthWindow, FinishedMatchesNumInternal, UptimeMinutes);
+	}
+
+	if (DurationHoursInternal > 0.f
+	    && UptimeMinutes >= DurationHoursInternal * 60.0)
+	{
+		UE_LOG(LogBomber, Log, TEXT("Soak test: finished after %i matches"), FinishedMatchesNumInternal);
+		constexpr bool bForce = false;
+		FPlatformMisc::RequestExit(bForce);
+		return;
+	}
+
+	SetGameStateDelayed(ECurrentGameState::Menu, MenuDelay);
+}
+
+// Counts the frame time of the current match
+bool USoakTestSubsystem::OnFrameTick(float DeltaTime)
+{
+	if (AMyGameStateBase::GetCurrentGameState() == ECurrentGameState::InGame)
+	{
+		MatchFrameSecondsInternal += DeltaTime;
+		++MatchFramesNumInternal;
+	}
+
+	return true;
+}
+
+// Returns the current value of given metric
+double USoakTestSubsystem::SampleMetric(ESoakTestMetric Metric) const
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return 0.0;
+	}
+
+	switch (Metric)
+	{
+		case ESoakTestMetric::UsedMemoryMB:
+			return static_cast<double>(FPlatformMemory::GetStats().UsedPhysical) / (1024.0 * 1024.0);
+		case ESoakTestMetric::UObjectsNum:
+			return GUObjectArray.GetObjectArrayNumMinusAvailable();
+		case ESoakTestMetric::PooledActorsNum:
+		{
+			const UPoolManagerSubsystem& PoolManager = UPoolManagerSubsystem::Get();
+			int32 PooledActorsNum = 0;
+			for (TActorIterator<AActor> It(World); It; ++It)
+			{
+				PooledActorsNum += PoolManager.ContainsObjectInPool(*It) ? 1 : 0;
+			}
+			return PooledActorsNum;
+		}
+		case ESoakTestMetric::TextRendersNum:
+			return SoakTest::CountWorldComponents<UTextRenderComponent>(*World);
+		case ESoakTestMetric::NiagaraComponentsNum:
+			return SoakTest::CountWorldComponents<UNiagaraComponent>(*World);
+		case ESoakTestMetric::MeshInstancesNum:
+		{
+			// Includes instances of foot trails and level meshes
+			int32 InstancesNum = 0;
+			for (TObjectIterator<UInstancedStaticMeshComponent> It; It; ++It)
+			{
+				if (IsValid(*It)
+				    && It->GetWorld() == World)
+				{
+					InstancesNum += It->GetInstanceCount();
+				}
+			}
+			return InstancesNum;
+		}
+		case ESoakTestMetric::AverageFrameMs:
+			return MatchFramesNumInternal ? MatchFrameSecondsInternal * 1000.0 / MatchFramesNumInternal : 0.0;
+		default:
+			ensureMsgf(false, TEXT("ASSERT: [%i] %s:\n'Metric' is not supported!"), __LINE__, *FString(__FUNCTION__));
+			return 0.0;
+	}
+}
@@ -4,15 +4,22 @@
 //---
 #include "Bomber.h"
 #include "GeneratedMap.h"
+#include "DataAssets/GeneratedMapDataAsset.h"
 #include "DataAssets/SoundsDataAsset.h"
 #include "GameFramework/MyGameStateBase.h"
+#include "GameFramework/MyGameUserSettings.h"
 #include "GameFramework/MyPlayerState.h"
 #include "MyUtilsLibraries/UtilsLibrary.h"
+#include "Subsystems/PlayWorldSubsystem.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
 #include "Components/AudioComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
 #include "Engine/World.h"
 #include "Kismet/GameplayStatics.h"
+#include "Sound/SoundWave.h"
+#include "TimerManager.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(SoundsSubsystem)
 
@@ -27,24 +34,67 @@ USoundsSubsystem& USoundsSubsystem::Get()
 // Returns the pointer to the Sounds Manager
 USoundsSubsystem* USoundsSubsystem::GetSoundsSubsystem(const UObject* WorldContextObject)
 {
+	if (const UPlayWorldSubsystem* PlayWorldSubsystem = UPlayWorldSubsystem::GetPlayWorldSubsystem(WorldContextObject))
+	{
+		return PlayWorldSubsystem->GetSoundsSubsystem();
+	}
+
+	// Is not a game world, e.g. the editor one
 	const UWorld* World = UUtilsLibrary::GetPlayWorld(WorldContextObject);
 	const TSubclassOf<USoundsSubsystem> SoundsSubsystemClass = USoundsDataAsset::Get().GetSoundsSubsystemClass();
 	return World ? Cast<USoundsSubsystem>(World->GetSubsystemBase(SoundsSubsystemClass)) : nullptr;
 }
 
-// Set new sound volume
+// Set new sound volume, is applied once on the next frame
 void USoundsSubsystem::SetSoundVolumeByClass(USoundClass* InSoundClass, float InVolume)
+{
+	UWorld* World = GetWorld();
+	if (!InSoundClass
+	    || !World)
+	{
+		return;
+	}
+
+	const bool bIsFlushScheduled = !PendingVolumesInternal.IsEmpty();
+	PendingVolumesInternal.Add(InSoundClass, InVolume);
+	if (!bIsFlushScheduled)
+	{
+		World->GetTimerManager().SetTimerForNextTick(this, &ThisClass::ApplyPendingVolumes);
+	}
+}
+
+// Pushes all pending volumes to the main sound mix at once
+void USoundsSubsystem::ApplyPendingVolumes()
 {
 	USoundMix* MainSoundMix = USoundsDataAsset::Get().GetMainSoundMix();
 	static constexpr float Pitch = 1.f;
 	static constexpr float FadeInTime = 0.f;
-	UGameplayStatics::SetSoundMixClassOverride(GetWorld(), MainSoundMix, InSoundClass, InVolume, Pitch, FadeInTime);
+	for (const TTuple<TWeakObjectPtr<USoundClass>, float>& It : PendingVolumesInternal)
+	{
+		if (USoundClass* SoundClass = It.Key.Get())
+		{
+			UGameplayStatics::SetSoundMixClassOverride(GetWorld(), MainSoundMix, SoundClass, It.Value, Pitch, FadeInTime);
+		}
+	}
+	PendingVolumesInternal.Reset();
+}
+
+// Sets the config volume and requests deferred saving if it is changed
+void USoundsSubsystem::UpdateConfigVolume(double& InOutConfigVolume, double InVolume)
+{
+	if (InOutConfigVolume == InVolume)
+	{
+		return;
+	}
+
+	InOutConfigVolume = InVolume;
+	UMyGameUserSettings::Get().RequestSaveSettings(this);
 }
 
 // Set the general sound volume for all sound classes in game
 void USoundsSubsystem::SetMasterVolume(double InVolume)
 {
-	MasterVolumeInternal = InVolume;
+	UpdateConfigVolume(MasterVolumeInternal, InVolume);
 
 	USoundClass* MasterSoundClass = USoundsDataAsset::Get().GetMasterSoundClass();
 	SetSoundVolumeByClass(MasterSoundClass, InVolume);
@@ -53,7 +103,7 @@ void USoundsSubsystem::SetMasterVolume(double InVolume)
 // Set new sound volume for music sound class
 void USoundsSubsystem::SetMusicVolume(double InVolume)
 {
-	MusicVolumeInternal = InVolume;
+	UpdateConfigVolume(MusicVolumeInternal, InVolume);
 
 	USoundClass* MusicSoundClass = USoundsDataAsset::Get().GetMusicSoundClass();
 	SetSoundVolumeByClass(MusicSoundClass, InVolume);
@@ -62,7 +112,7 @@ void USoundsSubsystem::SetMusicVolume(double InVolume)
 // Set new sound volume for SFX sound class
 void USoundsSubsystem::SetSFXVolume(double InVolume)
 {
-	SFXVolumeInternal = InVolume;
+	UpdateConfigVolume(SFXVolumeInternal, InVolume);
 
 	USoundClass* SFXSoundClass = USoundsDataAsset::Get().GetSFXSoundClass();
 	SetSoundVolumeByClass(SFXSoundClass, InVolume);
@@ -112,10 +162,74 @@ void USoundsSubsystem::PlayExplosionSFX()
 		return;
 	}
 
-	if (USoundBase* ExplosionSFX = USoundsDataAsset::Get().GetExplosionSFX())
+	USoundBase* ExplosionSFX = USoundsDataAsset::Get().GetExplosionSFX();
+	const UWorld* World = GetWorld();
+	if (!ExplosionSFX
+	    || !World)
 	{
-		UGameplayStatics::PlaySound2D(GetWorld(), ExplosionSFX);
+		return;
 	}
+
+	const double CurrentTime = World->GetTimeSeconds();
+	if (LastExplosionSFXTimeInternal >= 0.0
+	    && CurrentTime - LastExplosionSFXTimeInternal <= USoundsDataAsset::Get().GetExplosionMergeWindow())
+	{
+		// Chain reaction: merge simultaneous explosions into already started sound
+		return;
+	}
+
+	UAudioComponent* AudioComponent = AcquireExplosionAudioComponent(ExplosionSFX);
+	if (!ensureMsgf(AudioComponent, TEXT("ASSERT: [%i] %s:\n'AudioComponent' is not valid!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	LastExplosionSFXTimeInternal = CurrentTime;
+	AudioComponent->Play();
+}
+
+// Returns the pooled component to play next explosion: idle one, newly created one or the oldest playing one
+UAudioComponent* USoundsSubsystem::AcquireExplosionAudioComponent(USoundBase* ExplosionSFX)
+{
+	const USoundsDataAsset& SoundsDataAsset = USoundsDataAsset::Get();
+	const int32 MaxVoices = FMath::Max(1, SoundsDataAsset.GetExplosionMaxVoices());
+
+	// Remove components that were destroyed outside, e.g. on level transition
+	ExplosionSFXPoolInternal.RemoveAll([](const TObjectPtr<UAudioComponent>& It) { return !IsValid(It); });
+
+	for (int32 Index = 0; Index < ExplosionSFXPoolInternal.Num(); ++Index)
+	{
+		UAudioComponent* It = ExplosionSFXPoolInternal[Index];
+		if (!It->IsPlaying())
+		{
+			NextExplosionVoiceIndexInternal = (Index + 1) % ExplosionSFXPoolInternal.Num();
+			It->SetSound(ExplosionSFX);
+			return It;
+		}
+	}
+
+	if (ExplosionSFXPoolInternal.Num() < MaxVoices)
+	{
+		static constexpr float VolumeMultiplier = 1.f;
+		static constexpr float PitchMultiplier = 1.f;
+		static constexpr float StartTime = 0.f;
+		static constexpr bool bPersistAcrossLevelTransition = false;
+		static constexpr bool bAutoDestroy = false;
+		UAudioComponent* NewComponent = UGameplayStatics::CreateSound2D(GetWorld(), ExplosionSFX, VolumeMultiplier, PitchMultiplier, StartTime, SoundsDataAsset.GetExplosionConcurrency(), bPersistAcrossLevelTransition, bAutoDestroy);
+		if (NewComponent)
+		{
+			ExplosionSFXPoolInternal.Emplace(NewComponent);
+		}
+		return NewComponent;
+	}
+
+	// All voices are busy, steal the oldest one: components are started in round-robin order
+	NextExplosionVoiceIndexInternal = NextExplosionVoiceIndexInternal % ExplosionSFXPoolInternal.Num();
+	UAudioComponent* StolenComponent = ExplosionSFXPoolInternal[NextExplosionVoiceIndexInternal];
+	NextExplosionVoiceIndexInternal = (NextExplosionVoiceIndexInternal + 1) % ExplosionSFXPoolInternal.Num();
+	StolenComponent->Stop();
+	StolenComponent->SetSound(ExplosionSFX);
+	return StolenComponent;
 }
 
 // Play the sound of the picked power-up
@@ -208,7 +322,7 @@ void USoundsSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 	// Listen states
 	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
-		MyGameState->OnGameStateChanged.AddUniqueDynamic(this, &ThisClass::OnGameStateChanged);
+		MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 		// Handle current game state if initialized with delay
 		if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -219,6 +333,168 @@ void USoundsSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 		AGeneratedMap::Get().OnSetNewLevelType.AddUniqueDynamic(this, &ThisClass::OnGameLevelChanged);
 	}
 
+	PreloadLevelMusic(UMyBlueprintFunctionLibrary::GetLevelType());
+	PlayCurrentBackgroundMusic();
+}
+
+// Releases all retained level music and writes pending volumes to config
+void USoundsSubsystem::Deinitialize()
+{
+	// Write the volumes changed during the quiet period, the subsystem is not available to be saved later
+	if (UMyGameUserSettings* MyGameUserSettings = UMyBlueprintFunctionLibrary::GetMyGameUserSettings())
+	{
+		MyGameUserSettings->FlushPendingSave();
+	}
+	PendingVolumesInternal.Empty();
+
+	if (LevelMusicHandleInternal.IsValid())
+	{
+		LevelMusicHandleInternal->CancelHandle();
+		LevelMusicHandleInternal.Reset();
+	}
+
+	for (USoundWave* SoundWaveIt : RetainedMusicInternal)
+	{
+		if (SoundWaveIt)
+		{
+			SoundWaveIt->ReleaseCompressedAudio();
+		}
+	}
+	RetainedMusicInternal.Empty();
+
+	Super::Deinitialize();
+}
+
+// Preloads music of specified level and its neighbours in the levels list
+void USoundsSubsystem::PreloadLevelMusic(ELevelType CurrentLevelType)
+{
+	if (UUtilsLibrary::IsDedicatedServer())
+	{
+		return;
+	}
+
+	TArray<TSoftObjectPtr<USoundBase>> NeededMusic;
+	GetNeededLevelMusic(CurrentLevelType, NeededMusic);
+
+	TArray<FSoftObjectPath> MusicToLoad;
+	for (const TSoftObjectPtr<USoundBase>& MusicIt : NeededMusic)
+	{
+		if (!MusicIt.IsNull()
+		    && !MusicIt.IsValid())
+		{
+			MusicToLoad.AddUnique(MusicIt.ToSoftObjectPath());
+		}
+	}
+
+	// Music of the level type is streamed in background, the loaded one is retained right away
+	if (MusicToLoad.Num()
+	    && UAssetManager::IsInitialized())
+	{
+		FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+		const FStreamableDelegate OnLoaded = FStreamableDelegate::CreateUObject(this, &ThisClass::OnLevelMusicLoaded, CurrentLevelType);
+		LevelMusicHandleInternal = StreamableManager.RequestAsyncLoad(MusicToLoad, OnLoaded);
+	}
+
+	RetainLevelMusic(CurrentLevelType);
+}
+
+// Returns the soft references to music of specified level and its neighbours in the levels list
+void USoundsSubsystem::GetNeededLevelMusic(ELevelType CurrentLevelType, TArray<TSoftObjectPtr<USoundBase>>& OutNeededMusic) const
+{
+	// The main menu switches levels one by one, so the next and previous ones are likely to be chosen
+	TArray<ELevelType, TInlineAllocator<3>> LevelTypes;
+	LevelTypes.Emplace(CurrentLevelType);
+	TArray<FLevelStreamRow> LevelStreamRows;
+	UGeneratedMapDataAsset::Get().GetLevelStreamRows(LevelStreamRows);
+	const int32 RowsNum = LevelStreamRows.Num();
+	const int32 CurrentIndex = LevelStreamRows.IndexOfByPredicate([CurrentLevelType](const FLevelStreamRow& RowIt) { return RowIt.LevelType == CurrentLevelType; });
+	if (CurrentIndex != INDEX_NONE)
+	{
+		LevelTypes.AddUnique(LevelStreamRows[(CurrentIndex + 1) % RowsNum].LevelType);
+		LevelTypes.AddUnique(LevelStreamRows[(CurrentIndex + RowsNum - 1) % RowsNum].LevelType);
+	}
+
+	const USoundsDataAsset& SoundsDataAsset = USoundsDataAsset::Get();
+	for (const ELevelType LevelTypeIt : LevelTypes)
+	{
+		OutNeededMusic.AddUnique(SoundsDataAsset.GetSoftLevelMainMenuMusic(LevelTypeIt));
+		OutNeededMusic.AddUnique(SoundsDataAsset.GetSoftLevelMusic(LevelTypeIt));
+	}
+}
+
+// Primes and retains loaded music of specified level and its neighbours, releases other music over the memory budget
+void USoundsSubsystem::RetainLevelMusic(ELevelType CurrentLevelType)
+{
+	TArray<TSoftObjectPtr<USoundBase>> NeededSoftMusic;
+	GetNeededLevelMusic(CurrentLevelType, NeededSoftMusic);
+
+	TArray<USoundBase*, TInlineAllocator<6>> NeededMusic;
+	for (const TSoftObjectPtr<USoundBase>& MusicIt : NeededSoftMusic)
+	{
+		if (USoundBase* LoadedMusic = MusicIt.Get())
+		{
+			NeededMusic.AddUnique(LoadedMusic);
+		}
+	}
+
+	for (USoundBase* MusicIt : NeededMusic)
+	{
+		// Streamed music starts from the primed first chunk while the rest is streamed
+		UGameplayStatics::PrimeSound(MusicIt);
+
+		USoundWave* SoundWave = Cast<USoundWave>(MusicIt);
+		if (!SoundWave)
+		{
+			continue;
+		}
+
+		// Is moved to the end as the most recently needed one
+		if (!RetainedMusicInternal.Remove(SoundWave))
+		{
+			SoundWave->RetainCompressedAudio();
+		}
+		RetainedMusicInternal.Emplace(SoundWave);
+	}
+
+	int64 RetainedBytes = 0;
+	for (const USoundWave* SoundWaveIt : RetainedMusicInternal)
+	{
+		RetainedBytes += SoundWaveIt ? SoundWaveIt->GetResourceSizeBytes(EResourceSizeMode::Exclusive) : 0;
+	}
+
+	// Release the least recently needed music while over the budget, the needed and playing ones are kept
+	const int64 BudgetBytes = static_cast<int64>(USoundsDataAsset::Get().GetMusicMemoryBudget()) * 1024 * 1024;
+	const USoundBase* PlayingMusic = BackgroundMusicComponentInternal ? BackgroundMusicComponentInternal->GetSound() : nullptr;
+	for (int32 Index = 0; Index < RetainedMusicInternal.Num() && RetainedBytes > BudgetBytes;)
+	{
+		USoundWave* SoundWave = RetainedMusicInternal[Index];
+		if (SoundWave
+		    && (NeededMusic.Contains(SoundWave) || SoundWave == PlayingMusic))
+		{
+			++Index;
+			continue;
+		}
+
+		if (SoundWave)
+		{
+			RetainedBytes -= SoundWave->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+			SoundWave->ReleaseCompressedAudio();
+		}
+		RetainedMusicInternal.RemoveAt(Index);
+	}
+}
+
+// Is called when the music requested by PreloadLevelMusic is loaded, retains it and plays the current music
+void USoundsSubsystem::OnLevelMusicLoaded(ELevelType LoadedLevelType)
+{
+	if (LoadedLevelType != UMyBlueprintFunctionLibrary::GetLevelType())
+	{
+		// The level was switched while its music was loading, the music of the new level is requested by its own
+		return;
+	}
+
+	LevelMusicHandleInternal.Reset();
+	RetainLevelMusic(LoadedLevelType);
 	PlayCurrentBackgroundMusic();
 }
 
@@ -246,5 +522,6 @@ void USoundsSubsystem::OnGameStateChanged(ECurrentGameState CurrentGameState)
 // Listen game levels to switch main menu background music
 void USoundsSubsystem::OnGameLevelChanged(ELevelType CurrentLevelType)
 {
+	PreloadLevelMusic(CurrentLevelType);
 	PlayCurrentBackgroundMusic();
 }
@@ -121,7 +121,7 @@ void UInGameMenuWidget::BindOnGameStateChanged(AMyGameStateBase* MyGameState)
 {
 	checkf(MyGameState, TEXT("ERROR: 'MyGameState' is null!"));
 
-	MyGameState->OnGameStateChanged.AddUniqueDynamic(this, &ThisClass::OnGameStateChanged);
+	MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 	// Handle current game state if initialized with delay
 	if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
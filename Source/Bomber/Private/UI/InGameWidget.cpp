@@ -3,10 +3,16 @@
 #include "UI/InGameWidget.h"
 //---
 #include "Bomber.h"
+#include "GeneratedMap.h"
 #include "Controllers/MyPlayerController.h"
 #include "GameFramework/MyGameStateBase.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
 #include "UtilityLibraries/MyBlueprintFunctionLibrary.h"
 //---
+#include "TimerManager.h"
+#include "Components/InvalidationBox.h"
+#include "Engine/World.h"
+//---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(InGameWidget)
 
 // Called after the underlying slate widget is constructed. May be called multiple times due to adding and removing from the hierarchy.
@@ -18,6 +24,12 @@ void UInGameWidget::NativeConstruct()
 	// Hide that widget by default
 	SetVisibility(ESlateVisibility::Collapsed);
 
+	// Static parts are painted once and reused until any of its children is invalidated
+	if (StaticContentInvalidationBox)
+	{
+		StaticContentInvalidationBox->SetCanCache(true);
+	}
+
 	// Listen states to spawn widgets
 	if (AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState())
 	{
@@ -27,10 +39,22 @@ void UInGameWidget::NativeConstruct()
 	{
 		MyPC->OnGameStateCreated.AddUniqueDynamic(this, &ThisClass::BindOnGameStateChanged);
 	}
+
+	// Listen level actors spawning to show its progress
+	if (AGeneratedMap* GeneratedMap = UGeneratedMapSubsystem::Get().GetGeneratedMap())
+	{
+		GeneratedMap->OnGenerationProgressChanged.AddUniqueDynamic(this, &ThisClass::OnGenerationProgressChanged);
+	}
 }
 
 // Launch 'Three-two-one-GO' timer.
 void UInGameWidget::LaunchStartingCountdown_Implementation()
+{
+	UpdateCountdown();
+}
+
+// Is called while level actors are spawned during the starting countdown to show the progress
+void UInGameWidget::OnGenerationProgressChanged_Implementation(float Progress)
 {
 	// Blueprint implementation
 	// ...
@@ -38,11 +62,73 @@ void UInGameWidget::LaunchStartingCountdown_Implementation()
 
 // Launch the main timer that count the seconds to the game ending.
 void UInGameWidget::LaunchInGameCountdown_Implementation()
+{
+	UpdateCountdown();
+}
+
+// Is called only when the displayed second of the current countdown is changed
+void UInGameWidget::OnCountdownSecondChanged_Implementation(int32 SecondsRemain)
 {
 	// Blueprint implementation
 	// ...
 }
 
+// Computes the remain seconds of the current countdown locally and schedules next update to the moment the displayed second changes
+void UInGameWidget::UpdateCountdown()
+{
+	const AMyGameStateBase* MyGameState = UMyBlueprintFunctionLibrary::GetMyGameState();
+	const UWorld* World = GetWorld();
+	if (!MyGameState
+	    || !World)
+	{
+		return;
+	}
+
+	float SecondsRemain = 0.f;
+	switch (MyGameState->GetCurrentGameState())
+	{
+		case ECGS::GameStarting:
+			SecondsRemain = MyGameState->GetStartingTimerSecondsRemain();
+			break;
+		case ECGS::InGame:
+			SecondsRemain = MyGameState->GetInGameTimerSecondsRemain();
+			break;
+		default:
+			StopCountdown();
+			return;
+	}
+
+	const int32 DisplayedSeconds = FMath::CeilToInt(SecondsRemain);
+	if (DisplayedSeconds != DisplayedCountdownSecondsInternal)
+	{
+		DisplayedCountdownSecondsInternal = DisplayedSeconds;
+		OnCountdownSecondChanged(DisplayedSeconds);
+	}
+
+	if (DisplayedSeconds <= 0)
+	{
+		// Nothing to count anymore, next countdown is launched by the game state change
+		World->GetTimerManager().ClearTimer(CountdownUpdateTimerInternal);
+		return;
+	}
+
+	// Wake up right after the displayed second is changed, small offset avoids firing just before the boundary
+	static constexpr float BoundaryOffset = 0.01f;
+	const float UntilNextSecond = SecondsRemain - static_cast<float>(DisplayedSeconds - 1) + BoundaryOffset;
+	World->GetTimerManager().SetTimer(CountdownUpdateTimerInternal, this, &ThisClass::UpdateCountdown, UntilNextSecond, /*bLoop*/false);
+}
+
+// Stops updating the countdown, e.g. when the match is ended
+void UInGameWidget::StopCountdown()
+{
+	DisplayedCountdownSecondsInternal = INDEX_NONE;
+
+	if (const UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(CountdownUpdateTimerInternal);
+	}
+}
+
 // Called when the current game state was changed
 void UInGameWidget::OnGameStateChanged_Implementation(ECurrentGameState CurrentGameState)
 {
@@ -50,6 +136,7 @@ void UInGameWidget::OnGameStateChanged_Implementation(ECurrentGameState CurrentG
 	{
 		case ECurrentGameState::Menu:
 		{
+			StopCountdown();
 			SetVisibility(ESlateVisibility::Collapsed);
 			break;
 		}
@@ -61,6 +148,7 @@ void UInGameWidget::OnGameStateChanged_Implementation(ECurrentGameState CurrentG
 		}
 		case ECurrentGameState::EndGame:
 		{
+			StopCountdown();
 			break;
 		}
 		case ECurrentGameState::InGame:
@@ -78,7 +166,7 @@ void UInGameWidget::BindOnGameStateChanged(AMyGameStateBase* MyGameState)
 {
 	checkf(MyGameState, TEXT("ERROR: 'MyGameState' is null!"));
 
-	MyGameState->OnGameStateChanged.AddUniqueDynamic(this, &ThisClass::OnGameStateChanged);
+	MyGameState->AddGameStateListener(this, &ThisClass::OnGameStateChanged);
 
 	// Handle current game state if initialized with delay
 	if (MyGameState->GetCurrentGameState() == ECurrentGameState::Menu)
@@ -49,20 +49,49 @@ void FInputCategoryData::GetCategoriesDataFromMappings(const UMyInputMappingCont
 // Sets the input context to be represented by this widget
 void UInputCategoryWidget::CreateInputButtons(const FInputCategoryData& InInputCategoryData)
 {
-	if (!ensureMsgf(InputButtonClassInternal, TEXT("%s: 'Input Button Class' is not set, can not create input buttons"), *FString(__FUNCTION__)))
+	const bool bIsDataChanged = InputCategoryDataInternal.InputMappingContext != InInputCategoryData.InputMappingContext
+	                            || InputCategoryDataInternal.Mappings != InInputCategoryData.Mappings;
+	InputCategoryDataInternal = InInputCategoryData;
+
+	if (bIsDataChanged)
 	{
-		return;
+		// Buttons of previous mappings are dropped, so they are created again by new mappings
+		for (UInputButtonWidget* InputButtonIt : InputButtonsInternal)
+		{
+			if (InputButtonIt)
+			{
+				InputButtonIt->RemoveFromParent();
+			}
+		}
+		InputButtonsInternal.Reset();
 	}
 
-	InputCategoryDataInternal = InInputCategoryData;
+	if (GetCachedWidget().IsValid())
+	{
+		// Is already shown, so create its buttons right away
+		CreateInputButtonsIfNeeded();
+		AttachInputButtons();
+	}
+}
 
-	for (const FEnhancedActionKeyMapping& MappableDataIt : InInputCategoryData.Mappings)
+// Creates input buttons for each mapping of own category data if they are not created yet
+void UInputCategoryWidget::CreateInputButtonsIfNeeded()
+{
+	if (!InputButtonsInternal.IsEmpty()
+	    || InputCategoryDataInternal.Mappings.IsEmpty()
+	    || !ensureMsgf(InputButtonClassInternal, TEXT("%s: 'Input Button Class' is not set, can not create input buttons"), *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	InputButtonsInternal.Reserve(InputCategoryDataInternal.Mappings.Num());
+	for (const FEnhancedActionKeyMapping& MappableDataIt : InputCategoryDataInternal.Mappings)
 	{
 		FSettingsPrimary NewPrimaryRow = PrimaryDataInternal;
 		UInputButtonWidget* InputButtonWidget = GetSettingsWidgetChecked().CreateSettingSubWidget<UInputButtonWidget>(NewPrimaryRow, InputButtonClassInternal);
 
 		InputButtonsInternal.Emplace(InputButtonWidget);
-		InputButtonWidget->InitButton(MappableDataIt, InInputCategoryData.InputMappingContext);
+		InputButtonWidget->InitButton(MappableDataIt, InputCategoryDataInternal.InputMappingContext);
 	}
 }
 
@@ -71,6 +100,9 @@ void UInputCategoryWidget::NativeConstruct()
 {
 	Super::NativeConstruct();
 
+	// Buttons are created once this category is shown for the first time, next constructions reuse them
+	CreateInputButtonsIfNeeded();
+
 	AttachInputButtons();
 
 	UpdateStyle();
@@ -107,6 +139,11 @@ void UInputCategoryWidget::AttachInputButtons()
 
 	for (UInputButtonWidget* InputButtonIt : InputButtonsInternal)
 	{
-		VerticalBoxInputButtons->AddChild(InputButtonIt);
+		// Reused buttons stay attached since the last opening, re-adding would rebuild their slots
+		if (InputButtonIt
+		    && InputButtonIt->GetParent() != VerticalBoxInputButtons)
+		{
+			VerticalBoxInputButtons->AddChild(InputButtonIt);
+		}
 	}
 }
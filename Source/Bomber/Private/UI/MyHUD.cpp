@@ -2,17 +2,50 @@
 
 #include "UI/MyHUD.h"
 //---
+#include "Bomber.h"
+#include "GeneratedMap.h"
 #include "DataAssets/UIDataAsset.h"
+#include "Engine/BomberPerfBudget.h"
+#include "Engine/StartupTimings.h"
 #include "MyUtilsLibraries/UtilsLibrary.h"
 #include "UI/InGameWidget.h"
 #include "UI/SettingsWidget.h"
 //---
+#include "TimerManager.h"
 #include "UnrealClient.h"
 #include "Blueprint/UserWidget.h"
 #include "Components/GameFrameworkComponentManager.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Engine.h"
+#include "Engine/NetDriver.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MyHUD)
 
+// Cache static UI instead of repainting all widgets every frame
+static TAutoConsoleVariable<bool> CVarUIInvalidationMode(
+	TEXT("Bomber.UI.InvalidationMode"),
+	true,
+	TEXT("Is applied on widgets initialization: 1 (Slate global invalidation) OR 0 (Repaint every frame)"),
+	ECVF_Default);
+
+// Settings are rarely opened, so its heavy construction is postponed to not extend the startup
+static TAutoConsoleVariable<float> CVarUISettingsConstructionDelay(
+	TEXT("Bomber.UI.SettingsConstructionDelay"),
+	2.f,
+	TEXT("Seconds after widgets initialization to construct the settings widget in background: 0 (Next frame) OR >0 (Delay), is constructed earlier if opened"),
+	ECVF_Default);
+
+#if WITH_BOMBER_PERF_BUDGETS
+// Seconds between refreshes of the performance overlay, so the overlay barely affects the numbers it shows
+static TAutoConsoleVariable<float> CVarUIPerfOverlayInterval(
+	TEXT("Bomber.UI.PerfOverlayInterval"),
+	0.5f,
+	TEXT("Seconds between refreshes of the performance overlay numbers"),
+	ECVF_Default);
+#endif // WITH_BOMBER_PERF_BUDGETS
+
 // Default constructor
 AMyHUD::AMyHUD()
 {
@@ -21,6 +54,69 @@ AMyHUD::AMyHUD()
 	PrimaryActorTick.bStartWithTickEnabled = false;
 }
 
+// Returns the settings widget object, creates and constructs it right away if it was not created yet
+USettingsWidget* AMyHUD::GetOrCreateSettingsWidget()
+{
+	if (SettingsWidgetInternal
+	    || !AreWidgetInitialized())
+	{
+		return SettingsWidgetInternal;
+	}
+
+	const TSoftClassPtr<USettingsWidget>& SettingsWidgetClass = UUIDataAsset::Get().GetSettingsWidgetClass();
+	if (SettingsWidgetClass.IsNull())
+	{
+		return nullptr;
+	}
+
+	// Is loaded synchronously only if requested before the background loading is finished
+	const TSubclassOf<USettingsWidget> LoadedClass = SettingsWidgetClass.IsValid() ? SettingsWidgetClass.Get() : SettingsWidgetClass.LoadSynchronous();
+	SettingsWidgetInternal = CreateWidgetByClass<USettingsWidget>(LoadedClass, /*bAddToViewport*/true, /*ZOrder*/4);
+	if (!ensureMsgf(SettingsWidgetInternal, TEXT("ASSERT: [%i] %s:\n'SettingsWidgetInternal' is not created!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return nullptr;
+	}
+
+	SettingsWidgetInternal->TryConstructSettings();
+
+	if (OnSettingsWidgetCreated.IsBound())
+	{
+		OnSettingsWidgetCreated.Broadcast(SettingsWidgetInternal);
+	}
+
+	return SettingsWidgetInternal;
+}
+
+// Returns the nickname widget by a player index, creates it on first request
+UUserWidget* AMyHUD::GetOrCreateNicknameWidget(int32 Index)
+{
+	if (Index < 0
+	    || Index >= MAX_PLAYERS_NUM
+	    || !AreWidgetInitialized())
+	{
+		return nullptr;
+	}
+
+	// Slots are grown only up to the requested player, so small matches do not reserve widgets for all possible players
+	if (NicknameWidgetsInternal.Num() <= Index)
+	{
+		NicknameWidgetsInternal.SetNum(Index + 1);
+	}
+
+	TObjectPtr<UUserWidget>& NicknameWidget = NicknameWidgetsInternal[Index];
+	if (!NicknameWidget)
+	{
+		NicknameWidget = CreateWidgetByClass(UUIDataAsset::Get().GetNicknameWidgetClass(), /*bAddToViewport*/false); // Is drawn by 3D user widget component, no need add it to viewport
+		if (NicknameWidget)
+		{
+			// Follows the player every frame, so it is not worth caching
+			NicknameWidget->ForceVolatile(true);
+		}
+	}
+
+	return NicknameWidget;
+}
+
 // Go back input for UI widgets
 void AMyHUD::BroadcastOnClose()
 {
@@ -33,12 +129,48 @@ void AMyHUD::BroadcastOnClose()
 // Set true to show the FPS counter widget on the HUD
 void AMyHUD::SetFPSCounterEnabled(bool bEnable)
 {
+	if (!FPSCounterWidgetInternal
+	    && bEnable
+	    && AreWidgetInitialized())
+	{
+		// Is created only when shown for the first time
+		FPSCounterWidgetInternal = CreateWidgetByClass(UUIDataAsset::Get().GetFPSCounterWidgetClass());
+		if (FPSCounterWidgetInternal)
+		{
+			// Its text is changed every frame, so it is not worth caching
+			FPSCounterWidgetInternal->ForceVolatile(true);
+		}
+	}
+
 	if (FPSCounterWidgetInternal)
 	{
 		const ESlateVisibility NewVisibility = bEnable ? ESlateVisibility::HitTestInvisible : ESlateVisibility::Collapsed;
 		FPSCounterWidgetInternal->SetVisibility(NewVisibility);
-		bIsFPSCounterEnabledInternal = bEnable;
 	}
+
+	bIsFPSCounterEnabledInternal = bEnable;
+}
+
+// Set true to show the live performance overlay on the HUD
+void AMyHUD::SetPerfOverlayEnabled(bool bEnable)
+{
+#if WITH_BOMBER_PERF_BUDGETS
+	if (bEnable
+	    && !FBomberPerfBudget::IsEnabled())
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Performance overlay shows function times only while 'Bomber.Budget.Enabled' is set"));
+	}
+
+	bIsPerfOverlayEnabledInternal = bEnable;
+	PerfOverlayLinesInternal.Reset();
+
+	// Start averaging from now, so the first refresh does not include the time since the launch
+	PerfOverlayUpdateTimeInternal = 0.0;
+	if (bEnable)
+	{
+		UpdatePerfOverlayLines();
+	}
+#endif // WITH_BOMBER_PERF_BUDGETS
 }
 
 // Init all widgets on gameplay starting before begin play
@@ -58,6 +190,107 @@ void AMyHUD::PostInitializeComponents()
 	TryInitWidgets();
 }
 
+// Restores global Slate settings that were changed by this HUD
+void AMyHUD::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	if (PrevGlobalInvalidationInternal.IsSet())
+	{
+		if (IConsoleVariable* GlobalInvalidationCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Slate.EnableGlobalInvalidation")))
+		{
+			GlobalInvalidationCVar->Set(PrevGlobalInvalidationInternal.GetValue(), ECVF_SetByCode);
+		}
+		PrevGlobalInvalidationInternal.Reset();
+	}
+}
+
+// Draws the performance overlay if it is enabled
+void AMyHUD::DrawHUD()
+{
+	Super::DrawHUD();
+
+#if WITH_BOMBER_PERF_BUDGETS
+	if (!bIsPerfOverlayEnabledInternal)
+	{
+		return;
+	}
+
+	if (FPlatformTime::Seconds() - PerfOverlayUpdateTimeInternal >= CVarUIPerfOverlayInterval.GetValueOnGameThread())
+	{
+		UpdatePerfOverlayLines();
+	}
+
+	UFont* Font = GEngine ? GEngine->GetSmallFont() : nullptr;
+	constexpr float OverlayX = 16.f;
+	constexpr float OverlayY = 96.f;
+	constexpr float LineHeight = 14.f;
+	for (int32 Index = 0; Index < PerfOverlayLinesInternal.Num(); ++Index)
+	{
+		DrawText(PerfOverlayLinesInternal[Index], FLinearColor::Yellow, OverlayX, OverlayY + Index * LineHeight, Font);
+	}
+#endif // WITH_BOMBER_PERF_BUDGETS
+}
+
+// Rebuilds text lines of the performance overlay by numbers measured since the last refresh
+void AMyHUD::UpdatePerfOverlayLines()
+{
+#if WITH_BOMBER_PERF_BUDGETS
+	constexpr int32 BudgetsNum = static_cast<int32>(EBomberPerfBudget::Num);
+	const bool bHasPreviousTotals = PerfOverlayUpdateTimeInternal > 0.0 && PerfOverlayTotalMsInternal.Num() == BudgetsNum;
+	const double FramesNum = FMath::Max<double>(1.0, static_cast<double>(GFrameCounter - PerfOverlayUpdateFrameInternal));
+
+	// Take differences of function totals since the last refresh
+	double DeltaMs[BudgetsNum];
+	uint64 DeltaCalls[BudgetsNum];
+	PerfOverlayTotalMsInternal.SetNumZeroed(BudgetsNum);
+	PerfOverlayTotalCallsInternal.SetNumZeroed(BudgetsNum);
+	for (int32 Index = 0; Index < BudgetsNum; ++Index)
+	{
+		double TotalMs = 0.0;
+		uint64 TotalCalls = 0;
+		FBomberPerfBudget::GetTotals(static_cast<EBomberPerfBudget>(Index), TotalMs, TotalCalls);
+		DeltaMs[Index] = bHasPreviousTotals ? TotalMs - PerfOverlayTotalMsInternal[Index] : 0.0;
+		DeltaCalls[Index] = bHasPreviousTotals ? TotalCalls - PerfOverlayTotalCallsInternal[Index] : 0;
+		PerfOverlayTotalMsInternal[Index] = TotalMs;
+		PerfOverlayTotalCallsInternal[Index] = TotalCalls;
+	}
+
+	PerfOverlayUpdateTimeInternal = FPlatformTime::Seconds();
+	PerfOverlayUpdateFrameInternal = GFrameCounter;
+
+	auto GetCalls = [&DeltaCalls](EBomberPerfBudget Budget) { return DeltaCalls[static_cast<int32>(Budget)]; };
+	auto GetMs = [&DeltaMs](EBomberPerfBudget Budget) { return DeltaMs[static_cast<int32>(Budget)]; };
+
+	PerfOverlayLinesInternal.Reset();
+	PerfOverlayLinesInternal.Emplace(TEXT("Bomber performance:"));
+	PerfOverlayLinesInternal.Emplace(FString::Printf(TEXT("AI: %.3f ms/frame, %.1f updates/frame"),
+	                                                 GetMs(EBomberPerfBudget::UpdateAI) / FramesNum, GetCalls(EBomberPerfBudget::UpdateAI) / FramesNum));
+	PerfOverlayLinesInternal.Emplace(FString::Printf(TEXT("Grid queries: %.1f GetSidesCells/frame, %.1f GetExplosionCells/frame"),
+	                                                 GetCalls(EBomberPerfBudget::GetSidesCells) / FramesNum, GetCalls(EBomberPerfBudget::GetExplosionCells) / FramesNum));
+
+	const uint64 DetonationsNum = GetCalls(EBomberPerfBudget::DetonateBomb);
+	PerfOverlayLinesInternal.Emplace(FString::Printf(TEXT("Explosions: %.3f ms per detonation, %llu detonations"),
+	                                                 DetonationsNum ? GetMs(EBomberPerfBudget::DetonateBomb) / DetonationsNum : 0.0, DetonationsNum));
+
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(this);
+	if (const AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr)
+	{
+		PerfOverlayLinesInternal.Emplace(FString::Printf(TEXT("Level actors: %i active, %i alive players"), GeneratedMap->GetMapComponentsNum(), GeneratedMap->GetAlivePlayersNum()));
+	}
+
+	const UWorld* World = GetWorld();
+	if (const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr)
+	{
+		PerfOverlayLinesInternal.Emplace(FString::Printf(TEXT("Replication: out %u B/s, in %u B/s"), NetDriver->OutBytesPerSecond, NetDriver->InBytesPerSecond));
+	}
+	else
+	{
+		PerfOverlayLinesInternal.Emplace(TEXT("Replication: standalone"));
+	}
+#endif // WITH_BOMBER_PERF_BUDGETS
+}
+
 // Internal UUserWidget::CreateWidget wrapper
 UUserWidget* AMyHUD::CreateWidgetByClass(APlayerController* PlayerController, TSubclassOf<UUserWidget> WidgetClass, bool bAddToViewport/*= true*/, int32 ZOrder/* = 0*/)
 {
@@ -94,29 +327,37 @@ void AMyHUD::TryInitWidgets()
 // Create and set widget objects once
 void AMyHUD::InitWidgets()
 {
+	STARTUP_TIMING_SCOPE(InitWidgets);
+
 	if (AreWidgetInitialized())
 	{
 		return;
 	}
 
-	const UUIDataAsset& UIDataAsset = UUIDataAsset::Get();
-
-	InGameWidgetInternal = CreateWidgetByClass<UInGameWidget>(UIDataAsset.GetInGameWidgetClass());
+	if (CVarUIInvalidationMode.GetValueOnAnyThread())
+	{
+		// Cache static UI, so only invalidated or volatile widgets are repainted
+		// The previous value is kept to be restored on end play, so editor and other worlds are not affected once this one is gone
+		IConsoleVariable* GlobalInvalidationCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Slate.EnableGlobalInvalidation"));
+		if (GlobalInvalidationCVar
+		    && !PrevGlobalInvalidationInternal.IsSet())
+		{
+			PrevGlobalInvalidationInternal = GlobalInvalidationCVar->GetBool();
+			GlobalInvalidationCVar->Set(true, ECVF_SetByCode);
+		}
+	}
 
-	FPSCounterWidgetInternal = CreateWidgetByClass(UIDataAsset.GetFPSCounterWidgetClass());
+	// Only the in-game widget is created right away, the rest are created on demand
+	InGameWidgetInternal = CreateWidgetByClass<UInGameWidget>(UUIDataAsset::Get().GetInGameWidgetClass());
 
-	SettingsWidgetInternal = CreateWidgetByClass<USettingsWidget>(UIDataAsset.GetSettingsWidgetClass(), /*bAddToViewport*/true, /*ZOrder*/4);
-	SettingsWidgetInternal->TryConstructSettings();
+	bAreWidgetInitializedInternal = true;
 
-	static constexpr int32 MaxPlayersNum = 4;
-	NicknameWidgetsInternal.Reserve(MaxPlayersNum);
-	for (int32 Index = 0; Index < MaxPlayersNum; ++Index)
+	if (bIsFPSCounterEnabledInternal)
 	{
-		UUserWidget* NicknameWidget = CreateWidgetByClass(UIDataAsset.GetNicknameWidgetClass(), /*bAddToViewport*/false); // Is drawn by 3D user widget component, no need add it to viewport
-		NicknameWidgetsInternal.Emplace(NicknameWidget);
+		SetFPSCounterEnabled(true);
 	}
 
-	bAreWidgetInitializedInternal = true;
+	RequestSettingsWidgetClass();
 
 	if (OnWidgetsInitialized.IsBound())
 	{
@@ -134,3 +375,51 @@ void AMyHUD::OnViewportResizedWhenInit(FViewport* Viewport, uint32 Index)
 
 	InitWidgets();
 }
+
+// Starts loading the settings widget class in background to create the widget later without hitches
+void AMyHUD::RequestSettingsWidgetClass()
+{
+	const TSoftClassPtr<USettingsWidget>& SettingsWidgetClass = UUIDataAsset::Get().GetSettingsWidgetClass();
+	if (SettingsWidgetClass.IsNull()
+	    || SettingsWidgetClassHandleInternal.IsValid())
+	{
+		return;
+	}
+
+	if (SettingsWidgetClass.IsValid()
+	    || !UAssetManager::IsInitialized())
+	{
+		OnSettingsWidgetClassLoaded();
+		return;
+	}
+
+	FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+	const FStreamableDelegate OnLoaded = FStreamableDelegate::CreateUObject(this, &ThisClass::OnSettingsWidgetClassLoaded);
+	SettingsWidgetClassHandleInternal = StreamableManager.RequestAsyncLoad(SettingsWidgetClass.ToSoftObjectPath(), OnLoaded);
+}
+
+// Is called when the settings widget class is loaded, creates the widget on next frame
+void AMyHUD::OnSettingsWidgetClassLoaded()
+{
+	if (SettingsWidgetInternal)
+	{
+		// Was already requested and created synchronously
+		return;
+	}
+
+	// Construct settings once the main menu is already shown, not in the same frame as other widgets
+	const FTimerDelegate ConstructDelegate = FTimerDelegate::CreateWeakLambda(this, [this]
+	{
+		GetOrCreateSettingsWidget();
+	});
+
+	const float ConstructionDelay = CVarUISettingsConstructionDelay.GetValueOnAnyThread();
+	if (ConstructionDelay <= 0.f)
+	{
+		GetWorldTimerManager().SetTimerForNextTick(ConstructDelegate);
+		return;
+	}
+
+	FTimerHandle ConstructTimerHandle;
+	GetWorldTimerManager().SetTimer(ConstructTimerHandle, ConstructDelegate, ConstructionDelay, /*bLoop*/false);
+}
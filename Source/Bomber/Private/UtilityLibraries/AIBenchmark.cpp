@@ -0,0 +1,298 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Bomber.h"
+#include "Controllers/MyAIController.h"
+#include "DataAssets/AIDataAsset.h"
+#include "Structures/AIWorldSnapshot.h"
+//---
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ * Measures decisions of bots on scripted boards without any level, rendering or world.
+ * Each board is the text file where each line is the row and each character is the cell:
+ * '#' Wall, 'x' Box, 'o' Bomb, 'i' Item, 'P' Player that is controlled by the bot, '*' dangerous cell, any other character is the empty cell.
+ * Cells around bombs are marked as dangerous automatically by the DefaultFireRadius.
+ * Boards are taken from Saved/AIBenchmark/*.txt or from the specified directory, built-in boards are used if none is found.
+ * Is started by the console command, e.g. with -nullrhi -ExecCmds="Bomber.Benchmark.AI 1000 4"
+ */
+struct FAIBenchmark
+{
+	/** The scripted board loaded from the text. */
+	struct FBoard
+	{
+		FString Name;
+		FIntPoint GridSize = FIntPoint::ZeroValue;
+		TArray<uint8> CellActorTypes;
+		FCellsBitboard DangerousCells;
+		TArray<int32> PlayerCellIndices;
+	};
+
+	/** Is used when the number of iterations is not specified by the command. */
+	static constexpr int32 DefaultIterations = 1000;
+
+	/** Explosion radius of bombs on boards and of bots that make decisions. */
+	static constexpr int32 DefaultFireRadius = 2;
+
+	/** The walking speed of bots to compute how long they move by one cell. */
+	static constexpr float DefaultWalkSpeed = 600.f;
+
+	/** Boards that are used when there are no files with boards. */
+	static TArray<TPair<FString, FString>> GetBuiltInBoards()
+	{
+		return {
+			{TEXT("BuiltIn_Opening"),
+			 TEXT("P.xxxxxxxxx.P\n")
+			 TEXT(".#x#x#x#x#x#.\n")
+			 TEXT("xxxxxxxxxxxxx\n")
+			 TEXT("x#x#x#x#x#x#x\n")
+			 TEXT("xxxxxxxxxxxxx\n")
+			 TEXT("x#x#x#x#x#x#x\n")
+			 TEXT("xxxxxxxxxxxxx\n")
+			 TEXT("x#x#x#x#x#x#x\n")
+			 TEXT("xxxxxxxxxxxxx\n")
+			 TEXT(".#x#x#x#x#x#.\n")
+			 TEXT("P.xxxxxxxxx.P")},
+			{TEXT("BuiltIn_Midgame"),
+			 TEXT("...x..i..xx..\n")
+			 TEXT(".#.#x#.#.#x#.\n")
+			 TEXT("..P..o..x....\n")
+			 TEXT("x#.#.#x#.#.#x\n")
+			 TEXT("..x...i...P..\n")
+			 TEXT(".#x#.#.#x#.#.\n")
+			 TEXT("....o....x...\n")
+			 TEXT("x#.#x#.#.#.#x\n")
+			 TEXT("..P.....x.o..\n")
+			 TEXT(".#.#.#x#.#.#.\n")
+			 TEXT("..x..i...P...")}
+		};
+	}
+
+	/** Parses the board from given text, returns false if rows have different lengths or there are no players. */
+	static bool ParseBoard(const FString& Name, const FString& Text, FBoard& OutBoard)
+	{
+		TArray<FString> Rows;
+		Text.ParseIntoArrayLines(Rows);
+		Rows.RemoveAll([](const FString& Row) { return Row.TrimStartAndEnd().IsEmpty(); });
+		if (!Rows.Num())
+		{
+			return false;
+		}
+
+		OutBoard.Name = Name;
+		OutBoard.GridSize = FIntPoint(Rows[0].TrimStartAndEnd().Len(), Rows.Num());
+		const int32 CellsNum = OutBoard.GridSize.X * OutBoard.GridSize.Y;
+		OutBoard.CellActorTypes.Init(0, CellsNum);
+		OutBoard.DangerousCells.Init(CellsNum);
+		OutBoard.PlayerCellIndices.Reset();
+
+		for (int32 Y = 0; Y < Rows.Num(); ++Y)
+		{
+			const FString Row = Rows[Y].TrimStartAndEnd();
+			if (Row.Len() != OutBoard.GridSize.X)
+			{
+				UE_LOG(LogBomber, Warning, TEXT("AI benchmark: row %i of '%s' board has %i cells instead of %i"), Y, *Name, Row.Len(), OutBoard.GridSize.X);
+				return false;
+			}
+
+			for (int32 X = 0; X < Row.Len(); ++X)
+			{
+				const int32 CellIndex = Y * OutBoard.GridSize.X + X;
+				switch (Row[X])
+				{
+					case TEXT('#'):
+						OutBoard.CellActorTypes[CellIndex] = TO_FLAG(EAT::Wall);
+						break;
+					case TEXT('x'):
+						OutBoard.CellActorTypes[CellIndex] = TO_FLAG(EAT::Box);
+						break;
+					case TEXT('o'):
+						OutBoard.CellActorTypes[CellIndex] = TO_FLAG(EAT::Bomb);
+						break;
+					case TEXT('i'):
+						OutBoard.CellActorTypes[CellIndex] = TO_FLAG(EAT::Item);
+						break;
+					case TEXT('P'):
+						OutBoard.CellActorTypes[CellIndex] = TO_FLAG(EAT::Player);
+						OutBoard.PlayerCellIndices.Emplace(CellIndex);
+						break;
+					case TEXT('*'):
+						OutBoard.DangerousCells.SetBit(CellIndex, true);
+						break;
+					default:
+						break;
+				}
+			}
+		}
+
+		// Mark explosions of bombs, are broken by walls and boxes same as the explosion path is
+		static const FIntPoint Directions[] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+		for (int32 CellIndex = 0; CellIndex < CellsNum; ++CellIndex)
+		{
+			if (!(OutBoard.CellActorTypes[CellIndex] & TO_FLAG(EAT::Bomb)))
+			{
+				continue;
+			}
+
+			OutBoard.DangerousCells.SetBit(CellIndex, true);
+			const FIntPoint BombPosition(CellIndex % OutBoard.GridSize.X, CellIndex / OutBoard.GridSize.X);
+			for (const FIntPoint& DirectionIt : Directions)
+			{
+				for (int32 Step = 1; Step <= DefaultFireRadius; ++Step)
+				{
+					const FIntPoint Position = BombPosition + DirectionIt * Step;
+					if (Position.X < 0
+					    || Position.X >= OutBoard.GridSize.X
+					    || Position.Y < 0
+					    || Position.Y >= OutBoard.GridSize.Y)
+					{
+						break;
+					}
+
+					const int32 PositionIndex = Position.Y * OutBoard.GridSize.X + Position.X;
+					if (OutBoard.CellActorTypes[PositionIndex] & TO_FLAG(EAT::Wall))
+					{
+						break;
+					}
+
+					OutBoard.DangerousCells.SetBit(PositionIndex, true);
+					if (OutBoard.CellActorTypes[PositionIndex] & TO_FLAG(EAT::Box))
+					{
+						break;
+					}
+				}
+			}
+		}
+
+		return OutBoard.PlayerCellIndices.Num() > 0;
+	}
+
+	/** Loads all boards from given directory or built-in boards if there are no files. */
+	static void LoadBoards(const FString& Directory, TArray<FBoard>& OutBoards)
+	{
+		TArray<FString> FileNames;
+		IFileManager::Get().FindFiles(FileNames, *(Directory / TEXT("*.txt")), /*Files*/true, /*Directories*/false);
+
+		TArray<TPair<FString, FString>> BoardTexts;
+		for (const FString& FileNameIt : FileNames)
+		{
+			FString Text;
+			if (FFileHelper::LoadFileToString(Text, *(Directory / FileNameIt)))
+			{
+				BoardTexts.Emplace(FPaths::GetBaseFilename(FileNameIt), MoveTemp(Text));
+			}
+		}
+
+		if (!BoardTexts.Num())
+		{
+			BoardTexts = GetBuiltInBoards();
+		}
+
+		for (const TPair<FString, FString>& BoardTextIt : BoardTexts)
+		{
+			FBoard Board;
+			if (ParseBoard(BoardTextIt.Key, BoardTextIt.Value, Board))
+			{
+				OutBoards.Emplace(MoveTemp(Board));
+			}
+		}
+	}
+
+	/** Makes decisions of bots on given board and adds mean and p99 time per decision to the CSV. */
+	static void MeasureBoard(FString& OutCSV, const FBoard& Board, int32 Iterations, int32 BotsNum, const FAIDecisionInput& InputTemplate)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(FAIBenchmark::MeasureBoard);
+
+		FAIWorldSnapshot Snapshot;
+		Snapshot.BuildFromLayout(Board.GridSize, Board.CellActorTypes, Board.DangerousCells);
+
+		const int32 BoardBotsNum = FMath::Min(BotsNum, Board.PlayerCellIndices.Num());
+		TArray<double> DecisionSeconds;
+		DecisionSeconds.Reserve(Iterations * BoardBotsNum);
+
+		FAIDecisionInput Input = InputTemplate;
+		for (int32 It = 0; It < Iterations; ++It)
+		{
+			for (int32 BotIndex = 0; BotIndex < BoardBotsNum; ++BotIndex)
+			{
+				Input.CellIndex = Board.PlayerCellIndices[BotIndex];
+				Input.RandomSeed = It * BoardBotsNum + BotIndex;
+
+				FAIDecision Decision;
+				const double StartSeconds = FPlatformTime::Seconds();
+				AMyAIController::MakeDecision(Snapshot, Input, Decision);
+				DecisionSeconds.Emplace(FPlatformTime::Seconds() - StartSeconds);
+			}
+		}
+
+		if (!DecisionSeconds.Num())
+		{
+			return;
+		}
+
+		double TotalSeconds = 0.0;
+		for (const double SecondsIt : DecisionSeconds)
+		{
+			TotalSeconds += SecondsIt;
+		}
+
+		DecisionSeconds.Sort();
+		const int32 P99Index = FMath::Min(DecisionSeconds.Num() - 1, FMath::FloorToInt32(DecisionSeconds.Num() * 0.99));
+		const double MeanUs = TotalSeconds * 1e6 / DecisionSeconds.Num();
+		const double P99Us = DecisionSeconds[P99Index] * 1e6;
+
+		OutCSV += FString::Printf(TEXT("%s,%dx%d,%d,%d,%.2f,%.2f\n"), *Board.Name, Board.GridSize.X, Board.GridSize.Y, BoardBotsNum, DecisionSeconds.Num(), MeanUs, P99Us);
+		UE_LOG(LogBomber, Log, TEXT("AI benchmark: '%s' %i bots, mean %.2f us, p99 %.2f us per decision"), *Board.Name, BoardBotsNum, MeanUs, P99Us);
+	}
+
+	/** Runs decisions on all boards and saves results to the CSV file in the profiling directory.
+	 * Arguments: [Iterations] [BotsNum] [BoardsDirectory] */
+	static void Run(const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.IsValidIndex(0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : DefaultIterations;
+		const int32 BotsNum = Args.IsValidIndex(1) ? FMath::Max(1, FCString::Atoi(*Args[1])) : MAX_int32;
+		const FString Directory = Args.IsValidIndex(2) ? Args[2] : FPaths::ProjectSavedDir() / TEXT("AIBenchmark");
+
+		TArray<FBoard> Boards;
+		LoadBoards(Directory, Boards);
+
+		FAIDecisionInput InputTemplate;
+		InputTemplate.FireRadius = DefaultFireRadius;
+		InputTemplate.SecondsPerCell = FCell::CellSize / DefaultWalkSpeed;
+
+		const UAIDataAsset& AIDataAsset = UAIDataAsset::Get();
+		InputTemplate.ItemSearchRadius = AIDataAsset.GetItemSearchRadius();
+		InputTemplate.CrosswaySearchRadius = AIDataAsset.GetCrosswaySearchRadius();
+		InputTemplate.NearDangerousRadius = AIDataAsset.GetNearDangerousRadius();
+		InputTemplate.NearFilterRadius = AIDataAsset.GetNearFilterRadius();
+		InputTemplate.DangerSafetyMargin = AIDataAsset.GetDangerSafetyMargin();
+
+		FString CSV = TEXT("Board,GridSize,Bots,Decisions,MeanUs,P99Us\n");
+		for (const FBoard& BoardIt : Boards)
+		{
+			MeasureBoard(CSV, BoardIt, Iterations, BotsNum, InputTemplate);
+		}
+
+		const FString FilePath = FPaths::ProfilingDir() / TEXT("AIBenchmark") / FString::Printf(TEXT("AIBenchmark_%s.csv"), *FDateTime::Now().ToString());
+		if (FFileHelper::SaveStringToFile(CSV, *FilePath))
+		{
+			UE_LOG(LogBomber, Log, TEXT("AI benchmark: %i boards are measured, results are saved to '%s'"), Boards.Num(), *FilePath);
+		}
+		else
+		{
+			UE_LOG(LogBomber, Warning, TEXT("AI benchmark: can't save results to '%s'"), *FilePath);
+		}
+	}
+};
+
+static FAutoConsoleCommandWithArgs AIBenchmarkCommand(
+	TEXT("Bomber.Benchmark.AI"),
+	TEXT("Measures bot decisions on scripted boards, saves mean and p99 time to CSV: Bomber.Benchmark.AI [Iterations] [BotsNum] [BoardsDirectory]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FAIBenchmark::Run));
+
+#endif // !UE_BUILD_SHIPPING
@@ -4,7 +4,8 @@
 //---
 #include "Bomber.h"
 #include "GeneratedMap.h"
-#include "Components/TextRenderComponent.h"
+#include "Components/DebugCellsComponent.h"
+#include "Structures/CellsAllocationTracker.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(CellsUtilsLibrary)
 
@@ -26,8 +27,8 @@ void UCellsUtilsLibrary::BreakCell(const FCell& InCell, double& X, double& Y, do
 // Returns transform of cells grid on current level
 FTransform UCellsUtilsLibrary::GetLevelGridTransform()
 {
-	// As alternative, GeneratedMap's transform could be taken, but array transform is more reliable
-	return GetCellArrayTransform(GetAllCellsOnLevel());
+	// Is cached on the grid rebuilding, so there is no need to calculate it from all cells
+	return AGeneratedMap::Get().GetGridTransform();
 }
 
 // Returns location of grid pivot on current level
@@ -47,8 +48,7 @@ float UCellsUtilsLibrary::GetCellHeightLocation()
 // Returns cell rotator that is the same for any cell on the Generated Map
 FRotator UCellsUtilsLibrary::GetLevelGridRotation()
 {
-	// As alternative, GeneratedMap's rotation could be taken, but cell array rotation is more reliable
-	return GetCellArrayRotation(GetAllCellsOnLevel());
+	return AGeneratedMap::Get().GetGridTransform().GetRotation().Rotator();
 }
 
 // Returns cell yaw angle in degrees that is the same for any cell on the Generated Map
@@ -60,21 +60,19 @@ float UCellsUtilsLibrary::GetCellYawDegree()
 // Returns the current grid size
 FIntPoint UCellsUtilsLibrary::GetLevelGridScale()
 {
-	// As alternative, GeneratedMap's scale could be taken, but cell array size is more reliable
-	const FVector2D GridSize = GetCellArraySize(GetAllCellsOnLevel());
-	return FIntPoint(GridSize.X, GridSize.Y);
+	return AGeneratedMap::Get().GetGridSize();
 }
 
 // Returns the width (number of columns X) of the Generated Map
 int32 UCellsUtilsLibrary::GetCellColumnsNumOnLevel()
 {
-	return FMath::FloorToInt32(GetCellArrayWidth(GetAllCellsOnLevel()));
+	return AGeneratedMap::Get().GetGridSize().X;
 }
 
 // Returns the length (number of rows Y) of the Generated Map
 int32 UCellsUtilsLibrary::GetCellRowsNumOnLevel()
 {
-	return FMath::FloorToInt32(GetCellArrayLength(GetAllCellsOnLevel()));
+	return AGeneratedMap::Get().GetGridSize().Y;
 }
 
 // Returns GetCellColumnsNumOnLevel - 1
@@ -93,12 +91,29 @@ int32 UCellsUtilsLibrary::GetLastRowIndexOnLevel()
 //		Generated Map related cell functions
 // ---------------------------------------------------
 
+// Returns the cell by specified column (X) and row (Y) on current level if exists, invalid cell otherwise
+FCell UCellsUtilsLibrary::GetCellByPositionOnLevel(int32 ColumnX, int32 RowY)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const FIntPoint& GridSize = GeneratedMap.GetGridSize();
+	if (ColumnX < 0 || ColumnX >= GridSize.X
+	    || RowY < 0 || RowY >= GridSize.Y)
+	{
+		return FCell::InvalidCell;
+	}
+
+	return GeneratedMap.GetCellByIndex(RowY * GridSize.X + ColumnX);
+}
+
 // Takes the cell and returns its row and column position on the level if exists, -1 otherwise
 void UCellsUtilsLibrary::GetPositionByCellOnLevel(const FCell& InCell, int32& OutColumnX, int32& OutRowY)
 {
-	const FIntPoint CellPosition = GetPositionByCellOnGrid(InCell, GetAllCellsOnLevel());
-	OutColumnX = CellPosition.X;
-	OutRowY = CellPosition.Y;
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const int32 MaxWidth = GeneratedMap.GetGridSize().X;
+	const int32 CellIndex = GeneratedMap.GetCellIndex(InCell);
+	const bool bFound = CellIndex != INDEX_NONE && MaxWidth > 0;
+	OutColumnX = bFound ? CellIndex % MaxWidth : INDEX_NONE;
+	OutRowY = bFound ? CellIndex / MaxWidth : INDEX_NONE;
 }
 
 // Returns all grid cell location on the Generated Map
@@ -110,18 +125,30 @@ const TArray<FCell>& UCellsUtilsLibrary::GetAllCellsOnLevelAsArray()
 // Returns the cell location of the Generated Map
 FCell UCellsUtilsLibrary::GetCenterCellOnLevel()
 {
-	int32 CenterColumn = INDEX_NONE;
-	int32 CenterRow = INDEX_NONE;
-	GetCenterCellPositionOnLevel(/*out*/CenterRow, /*out*/CenterColumn);
-	return GetCellByPositionOnLevel(CenterColumn, CenterRow);
+	return AGeneratedMap::Get().GetGridCenterCell();
 }
 
 // Returns the center row and column positions on the level
 void UCellsUtilsLibrary::GetCenterCellPositionOnLevel(int32& OutColumnX, int32& OutRowY)
 {
-	const FIntPoint CenterCellPosition = GetCenterCellPositionOnGrid(GetAllCellsOnLevel());
-	OutColumnX = CenterCellPosition.X;
-	OutRowY = CenterCellPosition.Y;
+	const FIntPoint& GridSize = AGeneratedMap::Get().GetGridSize();
+	OutColumnX = GridSize.X / 2;
+	OutRowY = GridSize.Y / 2;
+}
+
+// Returns 4 corner cells of the Generated Map respecting its current size
+FCells UCellsUtilsLibrary::GetCornerCellsOnLevel()
+{
+	// The level grid is already row-major array of known width, so corners are read without copying it
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	return FCell::GetCornerCellsOnGrid(GeneratedMap.GridCellsInternal, GeneratedMap.GetGridSize().X);
+}
+
+// Returns specified corner cell in given grid
+FCell UCellsUtilsLibrary::GetCellByCornerOnLevel(EGridCorner CornerType)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	return FCell::GetCellByCornerOnGrid(CornerType, GeneratedMap.GridCellsInternal, GeneratedMap.GetGridSize().X);
 }
 
 // Return closest corner cell to the given cell
@@ -131,6 +158,53 @@ FCell UCellsUtilsLibrary::GetNearestCornerCellOnLevel(const FCell& CellToCheck)
 	return GetCellArrayNearest(AllCornerCells, CellToCheck);
 }
 
+// Returns the max distance between cells of the level grid, where each 1 unit means one cell
+double UCellsUtilsLibrary::GetMaxDistanceOnLevel()
+{
+	const FIntPoint& GridSize = AGeneratedMap::Get().GetGridSize();
+	if (GridSize.X <= 0
+	    || GridSize.Y <= 0)
+	{
+		return 0.0;
+	}
+
+	return FVector2D(GridSize.X - 1, GridSize.Y - 1).Size();
+}
+
+// Returns true if specified cell is present on the Generated Map
+bool UCellsUtilsLibrary::IsCellExistsOnLevel(const FCell& Cell)
+{
+	return Cell.IsValid() && AGeneratedMap::Get().GetCellIndex(Cell) != INDEX_NONE;
+}
+
+// Returns true if at least one cell is present on the Generated Map
+bool UCellsUtilsLibrary::IsAnyCellExistsOnLevel(const FCells& Cells)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	for (const FCell& CellIt : Cells)
+	{
+		if (GeneratedMap.GetCellIndex(CellIt) != INDEX_NONE)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Returns true if all specified cells are present on the Generated Map
+bool UCellsUtilsLibrary::AreAllCellsExistOnLevel(const FCells& Cells)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	for (const FCell& CellIt : Cells)
+	{
+		if (GeneratedMap.GetCellIndex(CellIt) == INDEX_NONE)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 // Returns all empty grid cell locations on the Generated Map where non of actors are present
 FCells UCellsUtilsLibrary::GetAllEmptyCellsWithoutActors()
 {
@@ -141,12 +215,22 @@ FCells UCellsUtilsLibrary::GetAllEmptyCellsWithoutActors()
 // Returns all grid cell location on the Generated Map by specified actor types
 FCells UCellsUtilsLibrary::GetAllCellsWithActors(int32 ActorsTypesBitmask)
 {
+	CELLS_ALLOCATION_SCOPE();
 	constexpr bool bIntersectAllIfEmpty = true;
 	FCells OutCells = FCell::EmptyCells;
 	AGeneratedMap::Get().IntersectCellsByTypes(OutCells, ActorsTypesBitmask, bIntersectAllIfEmpty);
+	TRACK_CELLS_ALLOCATION(GetAllCellsWithActors, OutCells);
 	return OutCells;
 }
 
+// Returns the number of cells on the Generated Map that have actors of specified types
+int32 UCellsUtilsLibrary::GetCellsNumWithActors(int32 ActorsTypesBitmask)
+{
+	FCellsBitboard MatchingCells;
+	AGeneratedMap::Get().GetCellsBitboard(MatchingCells, ActorsTypesBitmask);
+	return MatchingCells.CountSetBits();
+}
+
 // Takes cells and returns only empty cells where non of actors are present
 FCells UCellsUtilsLibrary::FilterEmptyCellsWithoutActors(const FCells& InCells)
 {
@@ -157,9 +241,11 @@ FCells UCellsUtilsLibrary::FilterEmptyCellsWithoutActors(const FCells& InCells)
 // Takes cells and returns only matching with specified actor types
 FCells UCellsUtilsLibrary::FilterCellsByActors(const FCells& InCells, int32 ActorsTypesBitmask)
 {
+	CELLS_ALLOCATION_SCOPE();
 	constexpr bool bIntersectAllIfEmpty = false;
 	FCells OutCells = InCells;
 	AGeneratedMap::Get().IntersectCellsByTypes(OutCells, ActorsTypesBitmask, bIntersectAllIfEmpty);
+	TRACK_CELLS_ALLOCATION(FilterCellsByActors, OutCells);
 	return OutCells;
 }
 
@@ -173,10 +259,7 @@ bool UCellsUtilsLibrary::IsEmptyCellWithoutActor(const FCell& Cell)
 // Checking the containing of the specified cell among owners locations of the Map Components array
 bool UCellsUtilsLibrary::IsCellHasAnyMatchingActor(const FCell& Cell, int32 ActorsTypesBitmask)
 {
-	constexpr bool bIntersectAllIfEmpty = false;
-	FCells NonEmptyCells{Cell};
-	AGeneratedMap::Get().IntersectCellsByTypes(NonEmptyCells, ActorsTypesBitmask, bIntersectAllIfEmpty);
-	return NonEmptyCells.Contains(Cell);
+	return AGeneratedMap::Get().DoesCellMatchActorTypes(Cell, ActorsTypesBitmask);
 }
 
 // Returns true if at least one cell is empty, so it does not have own actor
@@ -189,10 +272,15 @@ bool UCellsUtilsLibrary::IsAnyCellEmptyWithoutActor(const FCells& Cells)
 // Returns true if at least one cell has actors of specified types
 bool UCellsUtilsLibrary::AreCellsHaveAnyMatchingActors(const FCells& Cells, int32 ActorsTypesBitmask)
 {
-	constexpr bool bIntersectAllIfEmpty = false;
-	FCells NonEmptyCells{Cells};
-	AGeneratedMap::Get().IntersectCellsByTypes(NonEmptyCells, ActorsTypesBitmask, bIntersectAllIfEmpty);
-	return !NonEmptyCells.IsEmpty();
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	for (const FCell& CellIt : Cells)
+	{
+		if (GeneratedMap.DoesCellMatchActorTypes(CellIt, ActorsTypesBitmask))
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 // Returns true if all cells are empty, so don't have own actors
@@ -205,18 +293,41 @@ bool UCellsUtilsLibrary::AreAllCellsEmptyWithoutActors(const FCells& Cells)
 // Returns true if all cells have actors of specified types
 bool UCellsUtilsLibrary::AreCellsHaveAllMatchingActors(const FCells& Cells, int32 ActorsTypesBitmask)
 {
-	constexpr bool bIntersectAllIfEmpty = false;
-	FCells NonEmptyCells{Cells};
-	AGeneratedMap::Get().IntersectCellsByTypes(NonEmptyCells, ActorsTypesBitmask, bIntersectAllIfEmpty);
-	return NonEmptyCells.Num() == Cells.Num();
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	for (const FCell& CellIt : Cells)
+	{
+		if (!GeneratedMap.DoesCellMatchActorTypes(CellIt, ActorsTypesBitmask))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Returns the number of steps by free cells from specified cell to the nearest cell with actors of specified types
+int32 UCellsUtilsLibrary::GetDistanceToActors(const FCell& Cell, int32 ActorsTypesBitmask)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const int32 CellIndex = GeneratedMap.GetCellIndex(Cell);
+	const TArray<int32>& Distances = GeneratedMap.GetDistanceMap(ActorsTypesBitmask);
+	return Distances.IsValidIndex(CellIndex) ? Distances[CellIndex] : INDEX_NONE;
+}
+
+// Returns the number of steps by free cells from specified cell to the nearest cell that is not going to be exploded
+int32 UCellsUtilsLibrary::GetDistanceToSafety(const FCell& Cell)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	return GeneratedMap.GetAIWorldSnapshot().GetDistanceToSafety(GeneratedMap.GetCellIndex(Cell));
 }
 
 // Returns cells around the center in specified radius and according desired type of breaks
 FCells UCellsUtilsLibrary::GetCellsAround(const FCell& CenterCell, EPathType Pathfinder, int32 Radius)
 {
+	CELLS_ALLOCATION_SCOPE();
 	constexpr int32 AllDirections = TO_FLAG(ECellDirection::All);
 	FCells OutCells = FCell::EmptyCells;
 	AGeneratedMap::Get().GetSidesCells(OutCells, CenterCell, Pathfinder, Radius, AllDirections);
+	TRACK_CELLS_ALLOCATION(GetCellsAround, OutCells);
 	return OutCells;
 }
 
@@ -225,7 +336,27 @@ FCells UCellsUtilsLibrary::GetCellsAroundWithActors(const FCell& CenterCell, EPa
 {
 	ensureMsgf(Pathfinder == EPathType::Any || !EnumHasAnyFlags(EAT::Wall, TO_ENUM(EAT, ActorsTypesBitmask)), TEXT("ASSERT: Is trying to find walls for a pathfinder that breaks a path by walls"));
 	const FCells CellsAround = GetCellsAround(CenterCell, Pathfinder, Radius);
-	return FilterCellsByActors(CellsAround, ActorsTypesBitmask);
+	if (!ActorsTypesBitmask)
+	{
+		// Empty cells are not tracked by chunks
+		return FilterCellsByActors(CellsAround, ActorsTypesBitmask);
+	}
+
+	// Only chunks overlapped by the radius are visited instead of intersecting found cells with actors of the whole grid
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	FCellIndices FoundCellIndices;
+	GeneratedMap.GetCellIndicesInArea(FoundCellIndices, GeneratedMap.GetCellIndex(CenterCell), Radius, ActorsTypesBitmask);
+
+	FCells OutCells = FCell::EmptyCells;
+	for (const int32 FoundCellIndexIt : FoundCellIndices)
+	{
+		const FCell& FoundCell = GeneratedMap.GetCellByIndex(FoundCellIndexIt);
+		if (CellsAround.Contains(FoundCell))
+		{
+			OutCells.Emplace(FoundCell);
+		}
+	}
+	return OutCells;
 }
 
 // Returns matching empty cells around without actors, according desired type of breaks
@@ -240,7 +371,7 @@ FCell UCellsUtilsLibrary::GetCellInDirection(const FCell& CenterCell, EPathType
 {
 	ensureMsgf(Direction != ECellDirection::All, TEXT("ASSERT: Is specified 'ECellDirection::All' while function could return only cell in 1 direction"));
 	constexpr int32 SideLength = 1;
-	FCells OutCells = FCell::EmptyCells;
+	FSmallCells OutCells; // at most the center and one side cell are found, so it does not allocate
 	AGeneratedMap::Get().GetSidesCells(OutCells, CenterCell, Pathfinder, SideLength, TO_FLAG(Direction));
 	OutCells.Remove(CenterCell);
 	return FCell::GetFirstCellInSet(OutCells);
@@ -284,23 +415,241 @@ bool UCellsUtilsLibrary::IsIslandCell(const FCell& Cell)
 // Rotates the given cell around the center of the Generated Map to the same yaw degree
 FCell UCellsUtilsLibrary::RotateCellAroundLevelOrigin(const FCell& Cell, float AxisZ)
 {
-	const FTransform GridTransformNoScale = FCell::GetCellArrayTransformNoScale(GetAllCellsOnLevel());
+	FTransform GridTransformNoScale = GetLevelGridTransform();
+	GridTransformNoScale.SetScale3D(FVector::OneVector);
 	return FCell::RotateCellAroundOrigin(Cell, AxisZ, GridTransformNoScale);
 }
 
+// Gets a copy of given cell snapped to nearest cell on the level grid
+FCell UCellsUtilsLibrary::SnapCellOnLevel(const FCell& Cell)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	return GeneratedMap.GetCellByIndex(GeneratedMap.GetNearestCellIndex(Cell.Location));
+}
+
 // Returns nearest free cell to given cell, where free means cell with no other level actors except players
 FCell UCellsUtilsLibrary::GetNearestFreeCell(const FCell& Cell)
 {
-	FCells FreeCells = GetAllEmptyCellsWithoutActors();
-	FreeCells.Append(GetAllCellsWithActors(TO_FLAG(EAT::Player))); // Players are also considered as free cells
-	return GetCellArrayNearest(FreeCells, Cell);
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const FIntPoint& GridSize = GeneratedMap.GetGridSize();
+	const int32 CenterIndex = GeneratedMap.GetNearestCellIndex(Cell.Location);
+	if (CenterIndex == INDEX_NONE)
+	{
+		return FCell::InvalidCell;
+	}
+
+	// Players are also considered as free cells
+	constexpr int32 NotFreeActorTypes = TO_FLAG(~EAT::Player & EAT::All);
+
+	// Search by expanding square rings around the snapped cell
+	const int32 CenterColumn = CenterIndex % GridSize.X;
+	const int32 CenterRow = CenterIndex / GridSize.X;
+	const int32 MaxRing = FMath::Max(GridSize.X, GridSize.Y);
+	int32 NearestIndex = INDEX_NONE;
+	float NearestDistance = TNumericLimits<float>::Max();
+	for (int32 Ring = 0; Ring <= MaxRing; ++Ring)
+	{
+		// Cells of this ring are at least (Ring - 1) cells far away from given cell, so nearer cell can't be found
+		if (NearestIndex != INDEX_NONE
+		    && Ring - 1 > NearestDistance)
+		{
+			break;
+		}
+
+		for (int32 Row = CenterRow - Ring; Row <= CenterRow + Ring; ++Row)
+		{
+			if (Row < 0 || Row >= GridSize.Y)
+			{
+				continue;
+			}
+
+			// Inner rows of the ring have only two cells: on the left and right edge
+			const bool bIsEdgeRow = FMath::Abs(Row - CenterRow) == Ring;
+			const int32 ColumnStep = bIsEdgeRow ? 1 : FMath::Max(1, Ring * 2);
+			for (int32 Column = CenterColumn - Ring; Column <= CenterColumn + Ring; Column += ColumnStep)
+			{
+				if (Column < 0 || Column >= GridSize.X)
+				{
+					continue;
+				}
+
+				const int32 CellIndex = Row * GridSize.X + Column;
+				if (GeneratedMap.GetActorTypesOnCellIndex(CellIndex) & NotFreeActorTypes)
+				{
+					continue;
+				}
+
+				// Keep the same tie-break as searching over all cells: the lowest index wins on equal distance
+				const float DistanceIt = FCell::Distance<float>(GeneratedMap.GetCellByIndex(CellIndex), Cell);
+				if (DistanceIt < NearestDistance
+				    || DistanceIt == NearestDistance && CellIndex < NearestIndex)
+				{
+					NearestIndex = CellIndex;
+					NearestDistance = DistanceIt;
+				}
+			}
+		}
+	}
+
+	return GeneratedMap.GetCellByIndex(NearestIndex);
+}
+
+// ---------------------------------------------------
+//		 Cell mask utilities
+// ---------------------------------------------------
+
+// Returns the mask of given cells, cells that don't exist on the level are skipped
+FCellMask UCellsUtilsLibrary::Conv_CellsToCellMask(const FCells& Cells)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const FIntPoint& GridSize = GeneratedMap.GetGridSize();
+	FCellMask OutMask(GridSize.X * GridSize.Y);
+	for (const FCell& CellIt : Cells)
+	{
+		const int32 CellIndex = GeneratedMap.GetCellIndex(CellIt);
+		if (CellIndex != INDEX_NONE)
+		{
+			OutMask.Bitboard.SetBit(CellIndex, true);
+		}
+	}
+	return OutMask;
+}
+
+// Returns cells of given mask, is the only operation on the mask that allocates the set
+FCells UCellsUtilsLibrary::Conv_CellMaskToCells(const FCellMask& Mask)
+{
+	CELLS_ALLOCATION_SCOPE();
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	FCells OutCells;
+	OutCells.Reserve(Mask.Bitboard.CountSetBits());
+	Mask.Bitboard.ForEachSetBit([&GeneratedMap, &OutCells](int32 CellIndex)
+	{
+		const FCell& CellIt = GeneratedMap.GetCellByIndex(CellIndex);
+		if (CellIt.IsValid())
+		{
+			OutCells.Emplace(CellIt);
+		}
+	});
+	TRACK_CELLS_ALLOCATION(Conv_CellMaskToCells, OutCells);
+	return OutCells;
+}
+
+// Returns cells of given mask as the array ordered by row-major index
+TArray<FCell> UCellsUtilsLibrary::CellMaskToArray(const FCellMask& Mask)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	TArray<FCell> OutCells;
+	OutCells.Reserve(Mask.Bitboard.CountSetBits());
+	Mask.Bitboard.ForEachSetBit([&GeneratedMap, &OutCells](int32 CellIndex)
+	{
+		const FCell& CellIt = GeneratedMap.GetCellByIndex(CellIndex);
+		if (CellIt.IsValid())
+		{
+			OutCells.Emplace(CellIt);
+		}
+	});
+	return OutCells;
+}
+
+// Returns the mask of all cells with actors of specified types on the level
+FCellMask UCellsUtilsLibrary::GetCellMaskWithActors(int32 ActorsTypesBitmask)
+{
+	FCellMask OutMask;
+	AGeneratedMap::Get().GetCellsBitboard(OutMask.Bitboard, ActorsTypesBitmask);
+	return OutMask;
+}
+
+// Is the same as GetCellsAround, but returns the mask instead of the set
+FCellMask UCellsUtilsLibrary::GetCellMaskAround(const FCell& CenterCell, EPathType Pathfinder, int32 Radius)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const FIntPoint& GridSize = GeneratedMap.GetGridSize();
+	FCellMask OutMask(GridSize.X * GridSize.Y);
+
+	const int32 CenterIndex = GeneratedMap.GetCellIndex(CenterCell);
+	if (CenterIndex == INDEX_NONE
+	    || Radius <= 0)
+	{
+		return OutMask;
+	}
+
+	// ----- A path without explosions -----
+	FCellsBitboard DangerousCells;
+	const bool bBreakByDanger = Pathfinder == EPathType::Safe || Pathfinder == EPathType::Secure;
+	if (bBreakByDanger)
+	{
+		GeneratedMap.GetDangerousCellsBitboard(DangerousCells);
+	}
+
+	constexpr int32 AllDirections = TO_FLAG(ECellDirection::All);
+	FCellIndices FoundCellIndices;
+	GeneratedMap.GetSidesCellIndices(FoundCellIndices, CenterIndex, AGeneratedMap::GetBreakActorTypes(Pathfinder), bBreakByDanger ? &DangerousCells : nullptr, Radius, AllDirections);
+	for (const int32 FoundCellIndexIt : FoundCellIndices)
+	{
+		OutMask.Bitboard.SetBit(FoundCellIndexIt, true);
+	}
+	return OutMask;
+}
+
+// Takes the mask and returns only cells with specified actor types
+FCellMask UCellsUtilsLibrary::FilterCellMaskByActors(const FCellMask& Mask, int32 ActorsTypesBitmask)
+{
+	FCellMask OutMask = GetCellMaskWithActors(ActorsTypesBitmask);
+	OutMask.Bitboard &= Mask.Bitboard;
+	return OutMask;
+}
+
+// Returns the mask of cells with actors of specified types within the square of given radius around the center cell
+FCellMask UCellsUtilsLibrary::GetCellMaskInArea(const FCell& CenterCell, int32 Radius, int32 ActorsTypesBitmask)
+{
+	const AGeneratedMap& GeneratedMap = AGeneratedMap::Get();
+	const FIntPoint& GridSize = GeneratedMap.GetGridSize();
+	FCellMask OutMask(GridSize.X * GridSize.Y);
+
+	FCellIndices FoundCellIndices;
+	GeneratedMap.GetCellIndicesInArea(FoundCellIndices, GeneratedMap.GetCellIndex(CenterCell), Radius, ActorsTypesBitmask);
+	for (const int32 FoundCellIndexIt : FoundCellIndices)
+	{
+		OutMask.Bitboard.SetBit(FoundCellIndexIt, true);
+	}
+	return OutMask;
+}
+
+// Returns cells that are contained in any of given masks
+FCellMask UCellsUtilsLibrary::CellMask_Union(const FCellMask& A, const FCellMask& B)
+{
+	FCellMask OutMask = A;
+	OutMask.Bitboard |= B.Bitboard;
+	return OutMask;
+}
+
+// Returns cells that are contained in both given masks
+FCellMask UCellsUtilsLibrary::CellMask_Intersect(const FCellMask& A, const FCellMask& B)
+{
+	FCellMask OutMask = A;
+	OutMask.Bitboard &= B.Bitboard;
+	return OutMask;
+}
+
+// Returns cells of the first mask that are not contained in the second one
+FCellMask UCellsUtilsLibrary::CellMask_Subtract(const FCellMask& A, const FCellMask& B)
+{
+	FCellMask OutMask = A;
+	OutMask.Bitboard.Subtract(B.Bitboard);
+	return OutMask;
+}
+
+// Returns true if given cell is contained in the mask
+bool UCellsUtilsLibrary::CellMask_Contains(const FCellMask& Mask, const FCell& Cell)
+{
+	return Mask.Bitboard.IsSet(AGeneratedMap::Get().GetCellIndex(Cell));
 }
 
 // ---------------------------------------------------
 //		 Debug cells utilities
 // ---------------------------------------------------
 
-// Remove all text renders of the Owner, is not available in shipping build
+// Remove all displayed cells of the Owner, is not available in shipping build
 void UCellsUtilsLibrary::ClearDisplayedCells(const UObject* Owner)
 {
 #if !UE_BUILD_SHIPPING
@@ -315,16 +664,9 @@ void UCellsUtilsLibrary::ClearDisplayedCells(const UObject* Owner)
 		}
 	}
 
-	TArray<UTextRenderComponent*> TextRendersArray;
-	OwnerActor->GetComponents<UTextRenderComponent>(TextRendersArray);
-	for (int32 Index = TextRendersArray.Num() - 1; Index >= 0; --Index)
+	if (UDebugCellsComponent* DebugCellsComponent = OwnerActor->FindComponentByClass<UDebugCellsComponent>())
 	{
-		UTextRenderComponent* TextRenderIt = TextRendersArray.IsValidIndex(Index) ? Cast<UTextRenderComponent>(TextRendersArray[Index]) : nullptr;
-		if (IsValid(TextRenderIt)                       // is not pending kill
-		    && TextRenderIt->HasAllFlags(RF_Transient)) // cell text renders have this flag
-		{
-			TextRenderIt->DestroyComponent();
-		}
+		DebugCellsComponent->ClearLabels();
 	}
 #endif // !UE_BUILD_SHIPPING
 }
@@ -355,10 +697,16 @@ void UCellsUtilsLibrary::DisplayCells(UObject* Owner, const FCells& Cells, const
 		ClearDisplayedCells(Owner);
 	}
 
+	// All labels of the owner are drawn by pooled text renders of one component
+	UDebugCellsComponent& DebugCellsComponent = UDebugCellsComponent::GetOrCreateDebugCellsComponent(*OwnerActor);
+
 	// Have the render text rotated
 	const FQuat CellGridQuaternion = Cells.Num() > 1
 		                                 ? GetCellArrayRotation(Cells).Quaternion() // Get rotator from array
 		                                 : GetLevelGridRotation().Quaternion();     // Get current level rotator
+	static const FQuat AdditiveQuat = FRotator(90.f, 0.f, -90.f).Quaternion();
+	const FQuat TextRotation = CellGridQuaternion * AdditiveQuat;
+	const FColor TextColor = Params.TextColor.ToFColor(true);
 
 	for (const FCell& CellIt : Cells)
 	{
@@ -382,63 +730,36 @@ void UCellsUtilsLibrary::DisplayCells(UObject* Owner, const FCells& Cells, const
 				continue;
 			}
 
-			UTextRenderComponent& RenderComp = *NewObject<UTextRenderComponent>(OwnerActor, NAME_None, RF_Transient);
-			RenderComp.RegisterComponent();
+			FDebugCellLabel Label;
+			Label.Rotation = TextRotation;
+			Label.Color = TextColor;
 
 			// Get text render location on each cell
-			FVector TextLocation = FVector::ZeroVector;
 			const FVector CellLocation(CellIt.X(), CellIt.Y(), GetCellHeightLocation() + Params.TextHeight);
 			if (bShowCoordinate)
 			{
-				TextLocation.X = CellLocation.X + Params.CoordinatePosition.X * -1.f;
-				TextLocation.Y = CellLocation.Y + Params.CoordinatePosition.Y * -1.f;
-				TextLocation.Z = CellLocation.Z + Params.CoordinatePosition.Z;
-			}
-			else if (bShowRenderString)
-			{
-				TextLocation = CellLocation + Params.CoordinatePosition;
-			}
-
-			// --- Init the text render
+				Label.Location.X = CellLocation.X + Params.CoordinatePosition.X * -1.f;
+				Label.Location.Y = CellLocation.Y + Params.CoordinatePosition.Y * -1.f;
+				Label.Location.Z = CellLocation.Z + Params.CoordinatePosition.Z;
 
-			if (bShowCoordinate)
-			{
 				const FString XString = FString::FromInt(FMath::FloorToInt32(CellLocation.X));
 				const FString YString = FString::FromInt(FMath::FloorToInt32(CellLocation.Y));
 				constexpr float DelimiterTextSize = 48.f;
 				const FString DelimiterString = Params.TextSize > DelimiterTextSize ? TEXT("\n") : TEXT("");
-				const FString RenderString = XString + DelimiterString + YString;
-				RenderComp.SetText(FText::FromString(RenderString));
-			}
-			else if (bShowRenderString)
-			{
-				// Display RenderString as is
-				FText NameToStringToText = FText::FromString(Params.RenderString.ToString());
-				RenderComp.SetText(NameToStringToText);
-			}
-
-			RenderComp.SetAbsolute(true, true, true);
+				Label.Text = XString + DelimiterString + YString;
 
-			if (bShowCoordinate)
-			{
 				constexpr float CoordinateSizeMultiplier = 0.4f;
-				RenderComp.SetWorldSize(Params.TextSize * CoordinateSizeMultiplier);
+				Label.WorldSize = Params.TextSize * CoordinateSizeMultiplier;
 			}
 			else if (bShowRenderString)
 			{
-				RenderComp.SetWorldSize(Params.TextSize);
+				// Display RenderString as is
+				Label.Location = CellLocation + Params.CoordinatePosition;
+				Label.Text = Params.RenderString.ToString();
+				Label.WorldSize = Params.TextSize;
 			}
 
-			RenderComp.SetHorizontalAlignment(EHTA_Center);
-			RenderComp.SetVerticalAlignment(EVRTA_TextCenter);
-
-			RenderComp.SetTextRenderColor(Params.TextColor.ToFColor(true));
-
-			FTransform RenderTransform = FTransform::Identity;
-			RenderTransform.SetLocation(TextLocation);
-			static const FQuat AdditiveQuat = FRotator(90.f, 0.f, -90.f).Quaternion();
-			RenderTransform.SetRotation(CellGridQuaternion * AdditiveQuat);
-			RenderComp.SetWorldTransform(RenderTransform);
+			DebugCellsComponent.AddLabel(Label);
 		}
 	}
 #endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,175 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+#include "UtilityLibraries/CellsUtilsLibrary.h"
+//---
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace GridBenchmark
+{
+/** Columns and rows of synthetic grids, are odd same as levels are. */
+static const FIntPoint GridSizes[] = {{9, 9}, {17, 13}, {33, 33}, {65, 65}};
+
+/** Is used when the number of iterations is not specified by the command. */
+static constexpr int32 DefaultIterations = 1000;
+
+/** Runs given operation specified number of times and adds its average time in nanoseconds to the CSV.
+ * Each operation is wrapped into the trace scope, so allocations could be inspected by running with '-trace=cpu,memalloc'. */
+static void Measure(FString& OutCSV, const TCHAR* OpName, const FIntPoint& GridSize, int32 Iterations, TFunctionRef<void()> Operation)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(OpName);
+
+	// Warm up caches and lazily built data before measuring
+	Operation();
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	for (int32 It = 0; It < Iterations; ++It)
+	{
+		Operation();
+	}
+	const double NsPerOp = (FPlatformTime::Seconds() - StartSeconds) * 1e9 / Iterations;
+
+	OutCSV += FString::Printf(TEXT("%s,%dx%d,%d,%.1f\n"), OpName, GridSize.X, GridSize.Y, Iterations, NsPerOp);
+}
+
+/** Measures the grid primitives that don't depend on the level by synthetic grids of different sizes. */
+static void MeasureSyntheticGrids(FString& OutCSV, int32 Iterations)
+{
+	for (const FIntPoint& GridSizeIt : GridSizes)
+	{
+		const FTransform GridTransform(FRotator::ZeroRotator, FVector::ZeroVector, FVector(GridSizeIt.X, GridSizeIt.Y, 1.f));
+		FCells GridCells;
+		Measure(OutCSV, TEXT("MakeCellGridByTransform"), GridSizeIt, Iterations, [&GridCells, &GridTransform]
+		{
+			GridCells = FCell::MakeCellGridByTransform(GridTransform);
+		});
+
+		TArray<FCell> GridArray;
+		Measure(OutCSV, TEXT("MakeCellGridByTransformDense"), GridSizeIt, Iterations, [&GridArray, &GridTransform]
+		{
+			FCell::MakeCellGridByTransform(GridTransform, GridArray);
+		});
+
+		FCells RotatedCells;
+		Measure(OutCSV, TEXT("RotateCellArray"), GridSizeIt, Iterations, [&RotatedCells, &GridCells]
+		{
+			RotatedCells = FCell::RotateCellArray(-1.f, GridCells);
+		});
+
+		float Width = 0.f;
+		Measure(OutCSV, TEXT("GetCellArrayWidth"), GridSizeIt, Iterations, [&Width, &GridCells]
+		{
+			Width = FCell::GetCellArrayWidth(GridCells);
+		});
+	}
+}
+
+/** Measures the grid queries by the current level, so its walls, boxes, bombs and players are used as they are placed. */
+static void MeasureLevelGrid(FString& OutCSV, int32 Iterations, AGeneratedMap& GeneratedMap)
+{
+	const FIntPoint GridSize = GeneratedMap.GetGridSize();
+	const FCell CenterCell = UCellsUtilsLibrary::GetCenterCellOnLevel();
+	const FCell CornerCell = UCellsUtilsLibrary::GetCellByCornerOnLevel(EGridCorner::TopLeft);
+	const FCells AllCells = UCellsUtilsLibrary::GetAllCellsOnLevel();
+	const int32 SideLength = FMath::Max(GridSize.X, GridSize.Y);
+
+	static const TPair<EPathType, const TCHAR*> PathTypes[] = {
+		{EPathType::Explosion, TEXT("GetSidesCells_Explosion")},
+		{EPathType::Free, TEXT("GetSidesCells_Free")},
+		{EPathType::Safe, TEXT("GetSidesCells_Safe")},
+		{EPathType::Secure, TEXT("GetSidesCells_Secure")},
+		{EPathType::Any, TEXT("GetSidesCells_Any")}
+	};
+
+	FCells OutCells;
+	for (const TPair<EPathType, const TCHAR*>& PathTypeIt : PathTypes)
+	{
+		Measure(OutCSV, PathTypeIt.Value, GridSize, Iterations, [&]
+		{
+			OutCells.Reset();
+			GeneratedMap.GetSidesCells(OutCells, CenterCell, PathTypeIt.Key, SideLength, TO_FLAG(ECD::All));
+		});
+	}
+
+	Measure(OutCSV, TEXT("IntersectCellsByTypes"), GridSize, Iterations, [&]
+	{
+		OutCells.Reset();
+		constexpr bool bIntersectAllIfEmpty = true;
+		GeneratedMap.IntersectCellsByTypes(OutCells, TO_FLAG(EAT::Wall | EAT::Box), bIntersectAllIfEmpty);
+	});
+
+	Measure(OutCSV, TEXT("FilterCellsByActors"), GridSize, Iterations, [&]
+	{
+		OutCells = UCellsUtilsLibrary::FilterCellsByActors(AllCells, TO_FLAG(EAT::Player | EAT::Bomb));
+	});
+
+	FCell FoundCell = FCell::InvalidCell;
+	Measure(OutCSV, TEXT("GetNearestFreeCell"), GridSize, Iterations, [&]
+	{
+		FoundCell = UCellsUtilsLibrary::GetNearestFreeCell(CenterCell);
+	});
+
+	const FCell OffsetCell(CenterCell.Location + FVector(FCell::CellSize * 0.4f, FCell::CellSize * 0.3f, 0.f));
+	Measure(OutCSV, TEXT("SnapCellOnLevel"), GridSize, Iterations, [&]
+	{
+		FoundCell = UCellsUtilsLibrary::SnapCellOnLevel(OffsetCell);
+	});
+
+	const FCells CellsToFind{CornerCell};
+	bool bPathExists = false;
+	Measure(OutCSV, TEXT("DoesPathExistToCells"), GridSize, Iterations, [&]
+	{
+		bPathExists = GeneratedMap.DoesPathExistToCells(CellsToFind);
+	});
+
+	float Width = 0.f;
+	Measure(OutCSV, TEXT("GetCellArrayWidth"), GridSize, Iterations, [&]
+	{
+		Width = FCell::GetCellArrayWidth(AllCells);
+	});
+}
+
+/** Runs all the grid benchmarks and saves results to the CSV file in the profiling directory. */
+static void Run(const TArray<FString>& Args, UWorld* World)
+{
+	const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : DefaultIterations;
+
+	FString CSV = TEXT("Op,GridSize,Iterations,NsPerOp\n");
+	MeasureSyntheticGrids(CSV, Iterations);
+
+	const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(World);
+	if (AGeneratedMap* GeneratedMap = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr)
+	{
+		MeasureLevelGrid(CSV, Iterations, *GeneratedMap);
+	}
+	else
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Grid benchmark: the Generated Map is not found, only synthetic grids are measured"));
+	}
+
+	const FString FilePath = FPaths::ProfilingDir() / TEXT("GridBenchmark") / FString::Printf(TEXT("GridBenchmark_%s.csv"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveStringToFile(CSV, *FilePath))
+	{
+		UE_LOG(LogBomber, Log, TEXT("Grid benchmark: results are saved to '%s'"), *FilePath);
+	}
+	else
+	{
+		UE_LOG(LogBomber, Warning, TEXT("Grid benchmark: can't save results to '%s'"), *FilePath);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs RunCommand(
+	TEXT("Bomber.Benchmark.Grid"),
+	TEXT("Measures grid primitives by synthetic grids and by the current level, saves results to CSV: Bomber.Benchmark.Grid [Iterations]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,182 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "Bomber.h"
+#include "GeneratedMap.h"
+#include "Subsystems/GeneratedMapSubsystem.h"
+//---
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ * Regenerates the current level by all combinations of sizes and chances of walls and boxes, waits until each generation is spawned
+ * and saves attempts, generation, path check and spawn times to the CSV file, so limits of the level size could be chosen by the results.
+ * Should be started in the Main Menu of the standalone game, the original level size and chances are restored at the end.
+ */
+struct FLevelGenerationBenchmark
+{
+	/** One measured combination. */
+	struct FRun
+	{
+		FIntPoint LevelSize = FIntPoint::ZeroValue;
+		int32 WallsChance = 0;
+		int32 BoxesChance = 0;
+	};
+
+	/** Odd sizes from the smallest to the largest level, is the same for columns and rows. */
+	static constexpr int32 LevelSizes[] = {9, 15, 21, 31, 41, 51};
+
+	/** Chances in percents to sweep. */
+	static constexpr int32 WallsChances[] = {15, 35, 55};
+	static constexpr int32 BoxesChances[] = {30, 50, 70};
+
+	/** Is used when the number of repeats of each combination is not specified by the command. */
+	static constexpr int32 DefaultRepeats = 3;
+
+	/** The longest time in seconds to wait for spawning of one generation before skipping it. */
+	static constexpr double SpawnTimeout = 30.0;
+
+	/** The map that is regenerated. */
+	TWeakObjectPtr<AGeneratedMap> GeneratedMap = nullptr;
+
+	/** All combinations to measure and the index of the current one. */
+	TArray<FRun> Runs;
+	int32 RunIndex = INDEX_NONE;
+
+	/** When the current run was started. */
+	double RunStartTime = 0.0;
+
+	/** The level size to restore at the end. */
+	FIntPoint OriginalLevelSize = FIntPoint::ZeroValue;
+
+	/** All rows written to the output file. */
+	FString CSV = TEXT("LevelSize,WallsChance,BoxesChance,Attempts,GenerationMs,PathCheckMs,SpawnMs\n");
+
+	/** Is kept to stop previous benchmark if started again. */
+	static FTSTicker::FDelegateHandle TickerHandle;
+
+	/** Starts the next run, returns false if all runs are finished. */
+	bool StartNextRun()
+	{
+		AGeneratedMap* Map = GeneratedMap.Get();
+		if (!Map
+		    || !Runs.IsValidIndex(++RunIndex))
+		{
+			return false;
+		}
+
+		const FRun& Run = Runs[RunIndex];
+		RunStartTime = FPlatformTime::Seconds();
+		Map->SetGenerationChancesOverride(Run.WallsChance, Run.BoxesChance);
+		Map->SetLevelSize(Run.LevelSize);
+		return true;
+	}
+
+	/** Writes results of the current run once its level actors are spawned. */
+	bool Tick(float DeltaTime)
+	{
+		const AGeneratedMap* Map = GeneratedMap.Get();
+		if (!Map)
+		{
+			UE_LOG(LogBomber, Warning, TEXT("Level generation benchmark: the Generated Map is destroyed, the benchmark is stopped"));
+			return false;
+		}
+
+		const bool bIsTimedOut = FPlatformTime::Seconds() - RunStartTime > SpawnTimeout;
+		if (Map->GetLastSpawnTime() < 0.f
+		    && !bIsTimedOut)
+		{
+			// Is still spawning
+			return true;
+		}
+
+		const FRun& Run = Runs[RunIndex];
+		CSV += FString::Printf(TEXT("%dx%d,%d,%d,%d,%.3f,%.3f,%.3f\n"),
+		                       Run.LevelSize.X, Run.LevelSize.Y, Run.WallsChance, Run.BoxesChance, Map->GetLastGenerationAttempts(),
+		                       Map->GetLastGenerationTime() * 1000.f, Map->GetLastPathCheckTime() * 1000.f, bIsTimedOut ? -1.f : Map->GetLastSpawnTime() * 1000.f);
+
+		if (StartNextRun())
+		{
+			return true;
+		}
+
+		Finish();
+		return false;
+	}
+
+	/** Restores the level and saves results. */
+	void Finish()
+	{
+		if (AGeneratedMap* Map = GeneratedMap.Get())
+		{
+			Map->SetGenerationChancesOverride(INDEX_NONE, INDEX_NONE);
+			Map->SetLevelSize(OriginalLevelSize);
+		}
+
+		const FString FilePath = FPaths::ProfilingDir() / TEXT("LevelGenerationBenchmark") / FString::Printf(TEXT("LevelGenerationBenchmark_%s.csv"), *FDateTime::Now().ToString());
+		if (FFileHelper::SaveStringToFile(CSV, *FilePath))
+		{
+			UE_LOG(LogBomber, Log, TEXT("Level generation benchmark: %i runs are measured, results are saved to '%s'"), Runs.Num(), *FilePath);
+		}
+		else
+		{
+			UE_LOG(LogBomber, Warning, TEXT("Level generation benchmark: can't save results to '%s'"), *FilePath);
+		}
+	}
+
+	/** Starts the benchmark by the console command, arguments: [Repeats] */
+	static void Start(const TArray<FString>& Args, UWorld* World)
+	{
+		const UGeneratedMapSubsystem* GeneratedMapSubsystem = UGeneratedMapSubsystem::GetGeneratedMapSubsystem(World);
+		AGeneratedMap* Map = GeneratedMapSubsystem ? GeneratedMapSubsystem->GetGeneratedMap() : nullptr;
+		if (!Map
+		    || !Map->HasAuthority())
+		{
+			UE_LOG(LogBomber, Warning, TEXT("Level generation benchmark: the Generated Map is not found or is not authoritative"));
+			return;
+		}
+
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+		const int32 Repeats = Args.IsValidIndex(0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : DefaultRepeats;
+		const TSharedRef<FLevelGenerationBenchmark> Benchmark = MakeShared<FLevelGenerationBenchmark>();
+		Benchmark->GeneratedMap = Map;
+		Benchmark->OriginalLevelSize = Map->GetGridSize();
+		for (const int32 SizeIt : LevelSizes)
+		{
+			for (const int32 WallsChanceIt : WallsChances)
+			{
+				for (const int32 BoxesChanceIt : BoxesChances)
+				{
+					for (int32 RepeatIt = 0; RepeatIt < Repeats; ++RepeatIt)
+					{
+						Benchmark->Runs.Add({FIntPoint(SizeIt), WallsChanceIt, BoxesChanceIt});
+					}
+				}
+			}
+		}
+
+		if (Benchmark->StartNextRun())
+		{
+			// The benchmark is kept alive by the ticker until the last run is finished
+			TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Benchmark](float DeltaTime)
+			{
+				return Benchmark->Tick(DeltaTime);
+			}));
+		}
+	}
+};
+
+FTSTicker::FDelegateHandle FLevelGenerationBenchmark::TickerHandle;
+
+static FAutoConsoleCommandWithWorldAndArgs LevelGenerationBenchmarkCommand(
+	TEXT("Bomber.Benchmark.LevelGeneration"),
+	TEXT("Regenerates the level by different sizes and chances of walls and boxes, saves attempts and timings to CSV: Bomber.Benchmark.LevelGeneration [Repeats]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FLevelGenerationBenchmark::Start));
+
+#endif // !UE_BUILD_SHIPPING
@@ -16,6 +16,7 @@
 #include "LevelActors/PlayerCharacter.h"
 #include "MyUtilsLibraries/UtilsLibrary.h"
 #include "Subsystems/GeneratedMapSubsystem.h"
+#include "Subsystems/PlayWorldSubsystem.h"
 #include "UI/InGameMenuWidget.h"
 #include "UI/InGameWidget.h"
 #include "UI/MyHUD.h"
@@ -33,7 +34,8 @@
 // Returns number of alive players
 int32 UMyBlueprintFunctionLibrary::GetAlivePlayersNum()
 {
-	return UCellsUtilsLibrary::GetAllCellsWithActors(TO_FLAG(EAT::Player)).Num();
+	const AGeneratedMap* GeneratedMap = UGeneratedMapSubsystem::Get().GetGeneratedMap();
+	return GeneratedMap ? GeneratedMap->GetAlivePlayersNum() : 0;
 }
 
 // Returns the type of the current level
@@ -50,13 +52,20 @@ ELevelType UMyBlueprintFunctionLibrary::GetLevelType()
 // Contains a data of Bomber Level, nullptr otherwise
 AMyGameModeBase* UMyBlueprintFunctionLibrary::GetMyGameMode(const UObject* OptionalWorldContext/* = nullptr*/)
 {
-	const UWorld* World = UUtilsLibrary::GetPlayWorld(OptionalWorldContext);
+	const UPlayWorldSubsystem* PlayWorldSubsystem = UPlayWorldSubsystem::GetPlayWorldSubsystem(OptionalWorldContext);
+	const UWorld* World = PlayWorldSubsystem ? PlayWorldSubsystem->GetWorld() : UUtilsLibrary::GetPlayWorld(OptionalWorldContext);
 	return World ? World->GetAuthGameMode<AMyGameModeBase>() : nullptr;
 }
 
 // Returns the Bomber Game state, nullptr otherwise.
 AMyGameStateBase* UMyBlueprintFunctionLibrary::GetMyGameState(const UObject* OptionalWorldContext/* = nullptr*/)
 {
+	if (const UPlayWorldSubsystem* PlayWorldSubsystem = UPlayWorldSubsystem::GetPlayWorldSubsystem(OptionalWorldContext))
+	{
+		return PlayWorldSubsystem->GetMyGameState();
+	}
+
+	// Is not a game world, e.g. the editor one
 	const UWorld* World = UUtilsLibrary::GetPlayWorld(OptionalWorldContext);
 	return World ? World->GetGameState<AMyGameStateBase>() : nullptr;
 }
@@ -101,11 +110,11 @@ UMyGameUserSettings* UMyBlueprintFunctionLibrary::GetMyGameUserSettings(const UO
 	return GEngine ? Cast<UMyGameUserSettings>(GEngine->GetGameUserSettings()) : nullptr;
 }
 
-// Returns the settings widget
+// Returns the settings widget, creates it if was not requested yet
 USettingsWidget* UMyBlueprintFunctionLibrary::GetSettingsWidget(const UObject* OptionalWorldContext/* = nullptr*/)
 {
-	const AMyHUD* MyHUD = GetMyHUD(OptionalWorldContext);
-	return MyHUD ? MyHUD->GetSettingsWidget() : nullptr;
+	AMyHUD* MyHUD = GetMyHUD(OptionalWorldContext);
+	return MyHUD ? MyHUD->GetOrCreateSettingsWidget() : nullptr;
 }
 
 // Returns the Camera Component used on level
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include "Stats/Stats.h"
+//---
 #include "Bomber.generated.h"
 
 #define IS_TRANSIENT(Obj) ( FTransientChecker::IsTransient(Obj) )
@@ -12,6 +14,15 @@ namespace FTransientChecker
 BOMBER_API bool IsTransient(const UObject* Obj);
 }
 
+/**
+ * Zigzag encoding maps signed integers to unsigned ones, so small negative values stay small when are written as packed integers.
+ */
+namespace FZigzag
+{
+FORCEINLINE uint32 Encode(int32 Value) { return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31); }
+FORCEINLINE int32 Decode(uint32 Packed) { return static_cast<int32>(Packed >> 1) ^ -static_cast<int32>(Packed & 1); }
+}
+
 /**
  * Is useful for work with bit flags.
  */
@@ -20,19 +31,23 @@ BOMBER_API bool IsTransient(const UObject* Obj);
 
 /**
  * Custom collision channels.
+ * All characters share one object channel, bombs let own characters pass through by ignoring them on moving instead of a channel per character.
  */
-#define ECC_Player0 ECollisionChannel::ECC_GameTraceChannel1
-#define ECC_Player1 ECollisionChannel::ECC_GameTraceChannel2
-#define ECC_Player2 ECollisionChannel::ECC_GameTraceChannel3
-#define ECC_Player3 ECollisionChannel::ECC_GameTraceChannel4
+#define ECC_Player ECollisionChannel::ECC_GameTraceChannel1
 #define ECC_UI ECollisionChannel::ECC_GameTraceChannel5
 
+/** The maximum number of characters on the level, each bit of character bitmasks represents one character ID. */
+#define MAX_PLAYERS_NUM 16
+
 /** Is init version of TEXT("None"). */
 #define TEXT_NONE FCoreTexts::Get().None
 
 /** Define Bomber log category. */
 BOMBER_API DECLARE_LOG_CATEGORY_EXTERN(LogBomber, Log, All);
 
+/** Define Bomber stat group, is shown by 'stat Bomber' console command. */
+DECLARE_STATS_GROUP(TEXT("Bomber"), STATGROUP_Bomber, STATCAT_Advanced);
+
 /**
 * Types of all actors on the Generated Map
 * Where Walls, Boxes and Bombs are the physical barriers for players
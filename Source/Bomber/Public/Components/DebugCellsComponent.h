@@ -0,0 +1,64 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+//---
+#include "DebugCellsComponent.generated.h"
+
+class UTextRenderComponent;
+
+/**
+ * Text of one displayed cell, is compared with the currently shown one to update the render only on changes.
+ */
+struct BOMBER_API FDebugCellLabel
+{
+	FString Text;
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	float WorldSize = 0.f;
+	FColor Color = FColor::White;
+
+	bool operator==(const FDebugCellLabel& Other) const;
+};
+
+/**
+ * Displays all debug cells of its owner by pooled text renders, so labels that are cleared and displayed again every frame are not recreated.
+ * Cleared labels are hidden only at the end of the frame if they were not displayed again, so unchanged labels are not re-rendered at all.
+ * Is created on demand by UCellsUtilsLibrary::DisplayCells(), is not used in shipping build.
+ */
+UCLASS(Transient, ClassGroup = (Custom))
+class BOMBER_API UDebugCellsComponent final : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	/** Sets default values for this component's properties. */
+	UDebugCellsComponent();
+
+	/** Returns the debug cells component of given actor, creates it if is not added yet. */
+	static UDebugCellsComponent& GetOrCreateDebugCellsComponent(AActor& Owner);
+
+	/** Marks all displayed labels as unused, are hidden at the end of the frame unless are displayed again. */
+	void ClearLabels();
+
+	/** Shows given label by next unused text render, the text render is updated only if it shows another label. */
+	void AddLabel(const FDebugCellLabel& Label);
+
+protected:
+	/** Pooled text renders, all of them after the used number are hidden. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Text Renders"))
+	TArray<TObjectPtr<UTextRenderComponent>> TextRendersInternal;
+
+	/** Labels that are shown by text renders of the same index. */
+	TArray<FDebugCellLabel> ShownLabelsInternal;
+
+	/** The number of text renders that are used since the last clear. */
+	int32 UsedNumInternal = 0;
+
+	/** Hides text renders that were not displayed again since the last clear. */
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Destroys all pooled text renders. */
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+};
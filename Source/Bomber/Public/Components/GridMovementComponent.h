@@ -0,0 +1,67 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "GameFramework/CharacterMovementComponent.h"
+//---
+#include "GridMovementComponent.generated.h"
+
+/**
+ * Network move of the grid movement, is sent by the autonomous client to the server.
+ * The character never leaves the plane of the level, so its location and acceleration are sent in 2D,
+ * and the control rotation is sent as yaw only, since it is not used to rotate the character.
+ */
+struct BOMBER_API FGridNetworkMoveData : public FCharacterNetworkMoveData
+{
+	/** Writes the move with planar location and acceleration, falls back to the full location if the character is not on its plane. */
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+};
+
+/**
+ * Holds the new, pending and old grid moves instead of default ones.
+ */
+struct BOMBER_API FGridNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FGridNetworkMoveDataContainer();
+
+	FGridNetworkMoveData GridMoveData[3];
+};
+
+/**
+ * Grid-locked movement of the Bomber character.
+ * Moves along one grid axis at once and steers the character onto the lane of the nearest cell, so it turns into corridors without pixel-perfect input.
+ * Has no vertical physics: the character is constrained to the plane of the level, can't jump, crouch, swim or fly,
+ * and floors are not checked while nothing is changed under the character.
+ * Owner is Player Character.
+ */
+UCLASS(Blueprintable, BlueprintType, ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class BOMBER_API UGridMovementComponent final : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	/** Sets default values for this component's properties. */
+	UGridMovementComponent();
+
+	/** Returns the fraction of the cell size across the movement, within which the character is steered onto the lane. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetCorneringAssist() const { return CorneringAssistInternal; }
+
+protected:
+	/** The fraction of the cell size across the movement, within which the character is steered onto the lane.
+	 * If 0, the input is only snapped to the grid axis without steering. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Cornering Assist", ClampMin = "0", ClampMax = "0.5"))
+	float CorneringAssistInternal = 0.4f;
+
+	/** The distance in UU from the center of the lane, within which the character is considered to be on the lane. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Lane Tolerance", ClampMin = "0", Units = "Centimeters"))
+	float LaneToleranceInternal = 2.f;
+
+	/** Holds grid moves, is set as the network move container of this component. */
+	FGridNetworkMoveDataContainer GridNetworkMoveDataContainer;
+
+	/** Snaps the input to the dominant grid axis and steers it onto the lane of the nearest cell.
+	 * Is applied both by the autonomous client and by the server for the received move, so both simulate the same path.
+	 * Is idempotent since the server constrains already constrained acceleration of the client again. */
+	virtual FVector ConstrainInputAcceleration(const FVector& InputAcceleration) const override;
+};
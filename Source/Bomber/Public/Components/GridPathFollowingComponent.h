@@ -0,0 +1,64 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+//---
+#include "Structures/Cell.h"
+//---
+#include "GridPathFollowingComponent.generated.h"
+
+class AController;
+class APawn;
+
+/**
+ * Grid-native path follower that moves the controlled pawn to the destination cell without the navmesh.
+ * Keeps the distance field from the destination over the occupancy of the level, is rebuilt only when the level state or the destination is changed.
+ * Each tick the pawn is steered by movement input to the neighbour cell that is closer to the destination.
+ * Owner is AI Controller.
+ */
+UCLASS(Blueprintable, BlueprintType, ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class BOMBER_API UGridPathFollowingComponent final : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	/** Sets default values for this component's properties. */
+	UGridPathFollowingComponent();
+
+	/** Returns the controller of this component. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	AController* GetController() const;
+
+	/** Starts moving the controlled pawn to given cell. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (AutoCreateRefTerm = "DestinationCell"))
+	void MoveToCell(const FCell& DestinationCell);
+
+	/** Stops moving the controlled pawn. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void StopMovement();
+
+	/** Returns true if the pawn is moving to the destination cell. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsMoving() const { return DestinationCellIndexInternal != INDEX_NONE; }
+
+protected:
+	/** Row-major index of the destination cell, INDEX_NONE if is not moving. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Destination Cell Index"))
+	int32 DestinationCellIndexInternal = INDEX_NONE;
+
+	/** Version of the level state the distance field was built with, @see FAIWorldSnapshot::StateVersion. */
+	uint32 DistanceFieldVersionInternal = 0;
+
+	/** Number of steps from each cell to the destination cell, @see FAIWorldSnapshot::BuildDistanceField. */
+	TArray<int32> DistanceFieldInternal;
+
+	/** Steers the pawn to the next cell on the way to the destination. */
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Rebuilds the distance field if it is outdated. */
+	void UpdateDistanceField();
+
+	/** Returns the neighbour of given cell that is closer to the destination, INDEX_NONE if there is no way. */
+	int32 FindNextCellIndex(int32 CellIndex) const;
+};
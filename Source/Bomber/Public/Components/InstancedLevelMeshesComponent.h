@@ -0,0 +1,117 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Components/SceneComponent.h"
+#include "UObject/ObjectKey.h"
+//---
+#include "InstancedLevelMeshesComponent.generated.h"
+
+class UMapComponent;
+class UStaticMesh;
+class UHierarchicalInstancedStaticMeshComponent;
+enum class EActorType : uint8;
+
+/**
+ * Draws meshes of walls and boxes as instances of hierarchical instanced static mesh components, one per mesh asset in each chunk of the grid.
+ * So the whole chunk is culled by bounds of its components, and changed instances rebuild only trees of their own chunk.
+ * The level actors themselves are kept for the gameplay logic and collisions, only their own mesh components are hidden.
+ * If instanced collision is enabled, instances block characters instead of collision boxes of level actors.
+ * If merged static walls are enabled and the layout is baked, all walls of one level type are drawn by a single component instead of chunked ones.
+ * Is attached to the Generated Map, is used only if enabled in the Generated Map Data Asset.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class BOMBER_API UInstancedLevelMeshesComponent final : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	/** Sets default values for this component's properties. */
+	UInstancedLevelMeshesComponent();
+
+	/** Returns true if walls and boxes should be drawn by this component. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsInstancingEnabled();
+
+	/** Returns true if collisions of walls and boxes are handled by instances of this component instead of level actors. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsInstancedCollisionEnabled();
+
+	/** Returns true if all walls of one level type are drawn by a single instanced component instead of one per chunk.
+	 * Is true only for baked layouts, where walls never change during the match, so the component is never rebuilt by gameplay.
+	 * @see UGeneratedMapDataAsset::bMergedStaticWallsInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	bool IsMergedStaticWallsEnabled() const;
+
+	/** Adds or updates the instance of given map component by its current mesh and transform, hides own mesh of level actor. */
+	void AddInstance(const UMapComponent* MapComponent);
+
+	/** Removes the instance of given map component if was added before. */
+	void RemoveInstance(const UMapComponent* MapComponent);
+
+	/** Removes all instances of map components that are not contained in given set. */
+	void RemoveInstancesExcept(const TSet<const UMapComponent*>& KeptMapComponents);
+
+	/** Replaces instances that are not owned by any map component: walls that are drawn on client by replicated layout.
+	 * @param Mesh The mesh of all given instances, if null, previous layout is just removed.
+	 * @param Transforms World transforms of new instances.
+	 * @param CollisionResponse Response of instances if instanced collision is enabled. */
+	void SetLayoutInstances(UStaticMesh* Mesh, const TArray<FTransform>& Transforms, ECollisionResponse CollisionResponse);
+
+protected:
+	/** The chunk index of merged static walls, all of them share one component per mesh, so per level type. */
+	static constexpr int32 MergedChunkIndex = MAX_int32;
+
+	/** Identifies the instanced component of one mesh asset in one chunk of the grid. */
+	struct FInstancedMeshKey
+	{
+		TObjectKey<UStaticMesh> Mesh;
+		int32 ChunkIndex = INDEX_NONE;
+
+		FORCEINLINE bool operator==(const FInstancedMeshKey& Other) const { return Mesh == Other.Mesh && ChunkIndex == Other.ChunkIndex; }
+		friend FORCEINLINE uint32 GetTypeHash(const FInstancedMeshKey& Key) { return HashCombine(GetTypeHash(Key.Mesh), GetTypeHash(Key.ChunkIndex)); }
+	};
+
+	/** Is stored for each added map component to find its instance. */
+	struct FLevelMeshInstance
+	{
+		TWeakObjectPtr<UStaticMesh> Mesh = nullptr;
+		int32 ChunkIndex = INDEX_NONE;
+		int32 InstanceIndex = INDEX_NONE;
+
+		FORCEINLINE FInstancedMeshKey GetKey() const { return {Mesh.Get(), ChunkIndex}; }
+	};
+
+	/** All created instanced components, are created on demand. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Instanced Meshes"))
+	TArray<TObjectPtr<UHierarchicalInstancedStaticMeshComponent>> InstancedMeshesInternal;
+
+	/** Instanced components by their mesh asset and chunk. */
+	TMap<FInstancedMeshKey, TWeakObjectPtr<UHierarchicalInstancedStaticMeshComponent>> InstancedMeshesByKeyInternal;
+
+	/** Instances of added map components. */
+	TMap<TWeakObjectPtr<const UMapComponent>, FLevelMeshInstance> InstancesInternal;
+
+	/** Indexes of hidden instances per mesh and chunk, are reused by next added instances.
+	 * Removed instances are hidden instead of being removed, so indexes of other instances are never shifted. */
+	TMap<FInstancedMeshKey, TArray<int32>> FreeInstancesInternal;
+
+	/** Instances that were added by the layout instead of map components. */
+	TArray<FLevelMeshInstance> LayoutInstancesInternal;
+
+	/** Returns the instanced component for given mesh in specified chunk, creates new one if not found.
+	 * @param CollisionResponse Response of instances of created component if instanced collision is enabled. */
+	UHierarchicalInstancedStaticMeshComponent* FindOrCreateInstancedMesh(UStaticMesh* Mesh, int32 ChunkIndex, ECollisionResponse CollisionResponse = ECR_Ignore);
+
+	/** Returns the chunk of the Generated Map that contains given world location, INDEX_NONE if it is outside the grid. */
+	int32 GetChunkIndexByLocation(const FVector& Location) const;
+
+	/** Returns the chunk of the instance of given actor type at given location, is MergedChunkIndex for merged static walls. */
+	int32 GetInstanceChunkIndex(const FVector& Location, EActorType ActorType) const;
+
+	/** Sets given instance of the component to specified transform, reuses a hidden instance of the same chunk if any. */
+	void PlaceInstance(FLevelMeshInstance& InOutInstance, const FTransform& InstanceTransform, ECollisionResponse CollisionResponse);
+
+	/** Hides the specified instance and marks it as free. */
+	void HideInstance(const FLevelMeshInstance& Instance);
+};
@@ -4,12 +4,12 @@
 
 #include "Components/ActorComponent.h"
 //---
+#include "Bomber.h"
 #include "Structures/Cell.h"
+#include "PoolManagerTypes.h" // FPoolObjectHandle
 //---
 #include "MapComponent.generated.h"
 
-enum class EActorType : uint8;
-
 /** Typedef to allow for some nicer looking sets of map components */
 typedef TSet<class UMapComponent*> FMapComponents;
 
@@ -42,6 +42,19 @@ public:
 	UPROPERTY(BlueprintCallable, BlueprintAssignable, BlueprintAuthorityOnly, Category = "C++")
 	FOnDeactivatedMapComponent OnDeactivatedMapComponent;
 
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnCellChanged, UMapComponent*, MapComponent, const FCell&, NewCell, const FCell&, PreviousCell);
+
+	/** Called when the owner moves to another cell on the Generated Map, is called both on the server and clients.
+	 * Is broadcasted only when the cell actually changes, so it could be used instead of polling the owner location every frame. */
+	UPROPERTY(BlueprintAssignable, Category = "C++")
+	FOnCellChanged OnCellChanged;
+
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnApplyCollisionResponses, FCollisionResponseContainer& /*InOutResponses*/);
+
+	/** Called on each side right before collision responses are applied to the Box Collision Component.
+	 * Allows the owner to adjust applied responses locally by its own replicated state without replicating the whole container. */
+	FOnApplyCollisionResponses OnApplyCollisionResponses;
+
 #if WITH_EDITORONLY_DATA  // bShouldShowRenders
 	/** Mark the editor updating visualization(text renders) */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "C++", meta = (DevelopmentOnly))
@@ -74,10 +87,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (DevelopmentOnly))
 	void TryDisplayOwnedCell();
 
+	/** Queues current cell to be shown by cosmetics of this frame, so the cell is displayed once even if the owner moved a few times.
+	 * @see UCosmeticEventsSubsystem::ConsumeCellChanges */
+	void QueueCellChangedEvent();
+
 	/** Updates current mesh to default by current level type. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void SetDefaultMesh();
 
+	/** Updates current mesh to default one of given row, is used to swap meshes of many components by once resolved row.
+	 * @see AGeneratedMap::SwapLevelActorMeshes */
+	void SetDefaultMeshByRow(const class ULevelActorRow* Row);
+
 	/** Returns mesh asset if changed or null if default. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	class UStreamableRenderAsset* GetCustomMeshAsset() const { return CustomMeshAssetInternal; }
@@ -92,13 +113,14 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void SetMaterial(class UMaterialInterface* Material);
 
-	/** Returns the map component of the specified owner. */
+	/** Returns the map component of the specified owner.
+	 * Is the cached pointer of level actors that implement IMapComponentOwner, other actors are searched by their components. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (DefaultToSelf = "Owner"))
 	static UMapComponent* GetMapComponent(const AActor* Owner);
 
-	/** Get the owner's data asset. */
+	/** Returns the type of an owner, is cached from its data asset on registering. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	EActorType GetActorType() const;
+	FORCEINLINE EActorType GetActorType() const { return ActorTypeInternal; }
 
 	/** Get the owner's data asset. */
 	UFUNCTION(BlueprintPure, Category = "C++")
@@ -106,6 +128,13 @@ public:
 
 	const ULevelActorDataAsset& GetActorDataAssetChecked() const;
 
+	/** Returns the handle of an owner in the Pool Manager, is invalid while the owner is not taken from the pool.
+	 * Is cached on the server, so placing and removing on the grid does not search the Pool Manager. */
+	const FORCEINLINE FPoolObjectHandle& GetPoolObjectHandle() const { return PoolObjectHandleInternal; }
+
+	/** Caches the handle of an owner in the Pool Manager, is set when the owner is taken from the pool and reset when returned. */
+	FORCEINLINE void SetPoolObjectHandle(const FPoolObjectHandle& InPoolObjectHandle) { PoolObjectHandleInternal = InPoolObjectHandle; }
+
 	/** Returns true if an owner is set by cheat manager or skills to be undestroyable in game. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE bool IsUndestroyable() const { return bIsUndestroyableInternal; }
@@ -126,6 +155,10 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++", meta = (AutoCreateRefTerm = "NewResponses"))
 	void SetCollisionResponses(const FCollisionResponseContainer& NewResponses);
 
+	/** Updates current collisions for the Box Collision Component, is called on each side. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void ApplyCollisionResponse();
+
 	/** Is called when an owner was destroyed on the Generated Map. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void OnDeactivated(UObject* DestroyCauser = nullptr);
@@ -134,19 +167,50 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE class UMeshComponent* GetMeshComponent() const { return MeshComponentInternal; }
 
+	/** Returns false if the mesh is only cosmetic on this side, so it is not set at all, e.g: on the dedicated server.
+	 * Replicated mesh state is updated anyway, so clients still receive the mesh. */
+	bool ShouldApplyMesh() const;
+
+	/** Sets given mesh to the mesh component if it should be applied on this side.
+	 * While the owner is constructed, only the last requested mesh is applied once at the end of ThisClass::ConstructOwnerActor(),
+	 * so the owner that overrides its default mesh during construction does not set the mesh twice on each activation. */
+	void ApplyMesh(class UStreamableRenderAsset* Mesh);
+
+	/** Applies the mesh requested by ThisClass::ApplyMesh(), the mesh component is not touched if it already has this mesh. */
+	void ApplyPendingMesh();
+
+	/** Adds or moves the instance of this wall or box if its meshes are drawn as instances by the Generated Map.
+	 * Does nothing for other level actors or if instancing is disabled in the Generated Map Data Asset. */
+	void UpdateInstancedMesh();
+
+	/** Removes the instance of this wall or box from the Generated Map if was added before. */
+	void RemoveInstancedMesh();
+
+	/** Returns true if level actors of given type are kept slim: without own collision component and without replication.
+	 * Is true for static actor types while their meshes and collisions are instanced by the Generated Map.
+	 * @see ULevelActorDataAsset::IsStatic */
+	static bool IsSlimActorType(EActorType ActorType);
+
+	/** Returns true if an owner is kept slim, @see UMapComponent::IsSlimActorType. */
+	FORCEINLINE bool IsSlim() const { return IsSlimActorType(ActorTypeInternal); }
+
 protected:
 	/* ---------------------------------------------------
 	*		Protected properties
 	* --------------------------------------------------- */
 
 	/** Owner's cell location on the Generated Map */
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Replicated, Transient, Category = "C++", meta = (BlueprintProtected, ShowOnlyInnerProperties, DisplayName = "Cell"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, ReplicatedUsing = "OnRep_Cell", Transient, Category = "C++", meta = (BlueprintProtected, ShowOnlyInnerProperties, DisplayName = "Cell"))
 	FCell CellInternal = FCell::InvalidCell;
 
 	/** Contains exposed for designers properties for the spawned owner. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "C++", meta = (BlueprintProtected, DisplayName = "Actor Data Asset"))
 	TObjectPtr<const class ULevelActorDataAsset> ActorDataAssetInternal = nullptr;
 
+	/** The type of an owner, is cached from the Actor Data Asset on registering, so type queries do not dereference the data asset. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Actor Type"))
+	EActorType ActorTypeInternal = EActorType::None;
+
 	/** Mesh of an owner. */
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Mesh Component"))
 	TObjectPtr<class UMeshComponent> MeshComponentInternal = nullptr;
@@ -157,10 +221,26 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, ReplicatedUsing = "OnRep_CustomMeshAsset", Category = "C++", meta = (BlueprintProtected, DisplayName = "Custom Mesh Asset"))
 	TObjectPtr<UStreamableRenderAsset> CustomMeshAssetInternal = nullptr;
 
+	/** The mesh that was last set to the mesh component, is compared on activations to skip the same mesh. */
+	TWeakObjectPtr<UStreamableRenderAsset> AppliedMeshInternal = nullptr;
+
+	/** The mesh requested during the owner construction, is applied at the end of ThisClass::ConstructOwnerActor(). */
+	TWeakObjectPtr<UStreamableRenderAsset> PendingMeshInternal = nullptr;
+
+	/** Is true if ThisClass::PendingMeshInternal has to be applied, since null mesh could be requested as well. */
+	bool bHasPendingMeshInternal = false;
+
+	/** Is true while ThisClass::ConstructOwnerActor() runs, so requested meshes are deferred. */
+	bool bIsConstructingOwnerInternal = false;
+
 	/** If true the owner is undestroyable, is used by skills and cheat manager. */
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Undestroyable"))
 	bool bIsUndestroyableInternal = false;
 
+	/** Handle of an owner in the Pool Manager, is not replicated and exists only on the server side.
+	 * @see UMapComponent::GetPoolObjectHandle */
+	FPoolObjectHandle PoolObjectHandleInternal = FPoolObjectHandle::EmptyHandle;
+
 	/** The Collision Component, is attached to an owner. */
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Box Collision Component"))
 	TObjectPtr<class UBoxComponent> BoxCollisionComponentInternal = nullptr;
@@ -190,14 +270,20 @@ protected:
 	UFUNCTION()
 	bool OnConstructionOwnerActor();
 
+	/** Forces dormant owner to replicate its next changes, is called on the server on each real change of replicated data. */
+	void FlushOwnerNetDormancy() const;
+
+	/** Is called on client to notify listeners that the owner has moved to another cell. */
+	UFUNCTION()
+	void OnRep_Cell(const FCell& PreviousCell);
+
+	/** Notifies the Generated Map to update the cell of this component in its packed mirror. */
+	void UpdatePackedState() const;
+
 	/** Is called on client to update custom mesh if changed. */
 	UFUNCTION()
 	void OnRep_CustomMeshAsset();
 
-	/** Updates current collisions for the Box Collision Component. */
-	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
-	void ApplyCollisionResponse();
-
 	/** Is called on client to respond on changes in collision responses. */
 	UFUNCTION()
 	void OnRep_CollisionResponse();
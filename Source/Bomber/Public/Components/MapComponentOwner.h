@@ -0,0 +1,41 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "UObject/Interface.h"
+//---
+#include "MapComponentOwner.generated.h"
+
+class UMapComponent;
+
+UINTERFACE(MinimalAPI, meta = (CannotImplementInterfaceInBlueprint))
+class UMapComponentOwner : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Is implemented by level actors that own the Map Component, so it is found by the cached pointer instead of walking all components of the actor.
+ * @see UMapComponent::GetMapComponent
+ */
+class BOMBER_API IMapComponentOwner
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the map component of this level actor, is created together with the actor. */
+	virtual UMapComponent* GetOwnedMapComponent() const = 0;
+
+	/** Is shared by IsNetRelevantFor overrides of all level actors, returns false for spectators of the grid stream, since they rebuild the level by grid events.
+	 * Otherwise, returns the relevancy of given parent class, e.g: return IsLevelActorNetRelevantFor<Super>(*this, RealViewer, ViewTarget, SrcLocation); */
+	template <typename TSuper>
+	static bool IsLevelActorNetRelevantFor(const TSuper& LevelActor, const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation)
+	{
+		return !IsGridStreamViewer(RealViewer)
+		       && LevelActor.TSuper::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+	}
+
+protected:
+	/** Returns true if given viewer is the spectator that watches the grid stream. */
+	static bool IsGridStreamViewer(const AActor* RealViewer);
+};
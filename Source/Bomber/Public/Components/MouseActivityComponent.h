@@ -61,10 +61,14 @@ public:
 	 * Protected properties
 	 ********************************************************************************************* */
 protected:
-	/** How long the mouse is inactive at this moment. Is calculated in Tick if only inactivity is enabled.
+	/** The world time of the last mouse activity, is compared once the auto-hide timer is fired.
 	 * @see FMouseVisibilitySettings::bHideOnInactivity */
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Inactive Time"))
-	float CurrentlyInactiveSecInternal = 0.f;
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Activity Time"))
+	double LastActivityTimeInternal = 0.0;
+
+	/** Fires once the mouse could be inactive long enough to be hidden, is running only while the mouse is shown and inactivity is enabled. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Auto-Hide Timer"))
+	FTimerHandle AutoHideTimerInternal;
 
 	/** Cached settings for mouse visibility.
 	 * @see UPlayerInputDataAsset::GetMouseVisibilitySettings() */
@@ -78,8 +82,15 @@ protected:
 	/** Called when the game starts. */
 	virtual void BeginPlay() override;
 
-	/** Called every frame to calculate Delta Time. */
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	/*********************************************************************************************
+	 * Protected functions
+	 ********************************************************************************************* */
+protected:
+	/** Starts the auto-hide timer if the mouse is shown and could be hidden on inactivity, otherwise stops it. */
+	void RestartAutoHideTimer();
+
+	/** Is called by the auto-hide timer to hide the mouse, or waits the rest of time if the mouse was moved meanwhile. */
+	void OnAutoHideTimer();
 
 	/*********************************************************************************************
 	 * Events
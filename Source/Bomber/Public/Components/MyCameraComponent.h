@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Camera/CameraComponent.h"
+#include "UObject/ObjectKey.h"
 //---
 #include "MyCameraComponent.generated.h"
 
@@ -132,6 +133,23 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Force Move To Start"))
 	bool bForceStartInternal = false;
 
+	/** Cached result of GetCameraLockedLocation, is recalculated only when the grid, FOV or aspect ratio is changed. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Cached Locked Location"))
+	mutable FVector CachedLockedLocationInternal = FVector::ZeroVector;
+
+	/** Grid transform and FOV for which the locked location was cached. */
+	mutable FTransform CachedLockedGridTransformInternal = FTransform::Identity;
+	mutable float CachedLockedFOVInternal = 0.f;
+
+	/** Is true when the locked location has to be recalculated on next request. */
+	mutable bool bIsLockedLocationDirtyInternal = true;
+
+	/** Current cells of tracked players, are updated by their cell-change events instead of querying the level every frame. */
+	TMap<TObjectKey<class UMapComponent>, FVector> TrackedPlayerLocationsInternal;
+
+	/** Sum of locations of all tracked players, so their center is found in constant time. */
+	FVector TrackedPlayersSumInternal = FVector::ZeroVector;
+
 	/* ---------------------------------------------------
 	*		Protected functions
 	* --------------------------------------------------- */
@@ -152,4 +170,27 @@ protected:
 	/** Listen to recalculate camera location when screen aspect ratio was changed. */
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void OnAspectRatioChanged(float NewAspectRatio, EAspectRatioAxisConstraint NewAxisConstraint);
+
+	/** Starts listening cells of all players on the level, so their center is updated incrementally. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void TrackPlayers();
+
+	/** Is called when any tracked player changes its cell to update the center between players. */
+	UFUNCTION()
+	void OnPlayerCellChanged(class UMapComponent* MapComponent, const struct FCell& NewCell, const struct FCell& PreviousCell);
+
+	/** Stops tracking players that are not on the level anymore, is cheap since only few players are tracked. */
+	void PruneTrackedPlayers();
+
+	/** Enables the tick again if the camera fell asleep on reaching its target, but the target might be changed. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void WakeUpCamera();
+
+	/** Is called when any character is destroyed to wake up the camera. */
+	UFUNCTION()
+	void OnAnyCharacterDestroyed();
+
+	/** Is called when the level is resized or moved to recalculate the locked location. */
+	UFUNCTION()
+	void OnGeneratedMapWantsReconstruct(const FTransform& Transform);
 };
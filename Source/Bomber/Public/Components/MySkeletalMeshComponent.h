@@ -82,6 +82,8 @@ protected:
  * The Bomber Skeletal Mesh Component.
  * Used not only with the main player logic, ...
  * but in different UI actors and widgets to visualize the player's mannequin.
+ * Its animation is throttled by update rate optimizations on camera distance, only montages are ticked while it is not rendered,
+ * and meshes of low significance like not active main menu spots are ticked at lower rate, see 'Bomber.Anim.InsignificantTickInterval'.
  */
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class BOMBER_API UMySkeletalMeshComponent final : public USkeletalMeshComponent
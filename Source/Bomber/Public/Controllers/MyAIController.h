@@ -5,10 +5,112 @@
 #include "AIController.h"
 //---
 #include "Structures/Cell.h"
+#include "Structures/CellsBitboard.h"
 //---
 #include "MyAIController.generated.h"
 
 enum class ECurrentGameState : uint8;
+struct FAIWorldSnapshot;
+
+/**
+ * Everything the bot needs to make its decision, is gathered on the game thread.
+ * @see AMyAIController::PrepareDecision
+ */
+struct FAIDecisionInput
+{
+	/** Row-major index of the cell where the bot is located. */
+	int32 CellIndex = INDEX_NONE;
+
+	/** Row-major index of the cell where the bot is currently moving, INDEX_NONE if it is not moving. */
+	int32 MoveToCellIndex = INDEX_NONE;
+
+	/** Current explosion radius of the bot bombs. */
+	int32 FireRadius = 0;
+
+	/** Is taken on the game thread, so the random choice does not touch the global random state. */
+	int32 RandomSeed = 0;
+
+	/** The world time in seconds to compare detonation times of dangerous cells with. */
+	float CurrentTime = 0.f;
+
+	/** How long the bot moves from one cell to another by its current speed. */
+	float SecondsPerCell = 0.f;
+
+	/** Copy of UAIDataAsset values. */
+	int32 ItemSearchRadius = 0;
+	int32 CrosswaySearchRadius = 0;
+	int32 NearDangerousRadius = 0;
+	int32 NearFilterRadius = 0;
+	float DangerSafetyMargin = 0.f;
+
+#if WITH_EDITOR
+	/** Is true to keep data for cells visualization. */
+	bool bShouldShowRenders = false;
+#endif
+};
+
+/**
+ * Result of the bot decision, is applied on the game thread.
+ * @see AMyAIController::ApplyDecision
+ */
+struct FAIDecision
+{
+	/** Row-major index of the cell where the bot has to move, INDEX_NONE to keep current movement. */
+	int32 MoveToCellIndex = INDEX_NONE;
+
+	/** Is true if the bot has to put the bomb. */
+	bool bSpawnBomb = false;
+
+#if WITH_EDITOR
+	/** Found cells to visualize, are set only if FAIDecisionInput::bShouldShowRenders is true. */
+	FCellsBitboard AllCrossways;
+	FCellsBitboard SecureCrossways;
+	FCellsBitboard Filtered;
+#endif
+};
+
+/**
+ * Key of the last decision made by the bot, while it is the same and nothing is changed around the bot, the decision is not made again.
+ * @see AMyAIController::PrepareDecision
+ */
+struct FAIDecisionCache
+{
+	/** Row-major index of the cell where the bot was located. */
+	int32 CellIndex = INDEX_NONE;
+
+	/** Explosion radius of the bot bombs. */
+	int32 FireRadius = 0;
+
+	/** FAIWorldSnapshot::BuildNumber the decision was made with. */
+	uint32 BuildNumber = 0;
+};
+
+/**
+ * Timings of decisions made by the bot, are used to compare the cost of AI between bots and matches.
+ * @see UAISimulationSubsystem
+ */
+struct FAIDecisionStats
+{
+	/** The number of made decisions. */
+	int32 DecisionsNum = 0;
+
+	/** Summary time in seconds of all made decisions. */
+	double TotalSeconds = 0.0;
+
+	/** The longest decision in seconds. */
+	double MaxSeconds = 0.0;
+
+	/** Adds the time of the next made decision. */
+	FORCEINLINE void AddDecision(double Seconds)
+	{
+		++DecisionsNum;
+		TotalSeconds += Seconds;
+		MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+	}
+
+	/** Returns the average time of one decision in milliseconds. */
+	FORCEINLINE double GetAverageMs() const { return DecisionsNum ? TotalSeconds * 1000.0 / DecisionsNum : 0.0; }
+};
 
 /**
  * Characters controlled by bots.
@@ -31,19 +133,37 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void MoveToCell(const FCell& DestinationCell);
 
+	/** Returns timings of decisions made by this bot since the last reset. */
+	FORCEINLINE const FAIDecisionStats& GetDecisionStats() const { return DecisionStatsInternal; }
+
+	/** Starts counting timings of decisions from scratch. */
+	FORCEINLINE void ResetDecisionStats() { DecisionStatsInternal = FAIDecisionStats(); }
+
 protected:
 	/* ---------------------------------------------------
 	*		Protected properties
 	* --------------------------------------------------- */
 
-	/** Timer to update AI. */
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "AI Update Handle"))
-	FTimerHandle AIUpdateHandleInternal;
+	/** Gives access for the scheduler to update AI of all bots in one batch. */
+	friend class UAISchedulerSubsystem;
+
+	/** Gives access for the benchmark to make decisions on scripted boards. */
+	friend struct FAIBenchmark;
 
 	/** Cell position of current path segment's end */
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, ShowOnlyInnerProperties, DisplayName = "AI Move To"))
 	FCell AIMoveToInternal = FCell::InvalidCell;
 
+	/** Moves the controlled character by cells of the Generated Map without the navmesh. */
+	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Grid Path Following Component"))
+	TObjectPtr<class UGridPathFollowingComponent> GridPathFollowingInternal = nullptr;
+
+	/** Key of the last decision, is reset to make the decision again. */
+	FAIDecisionCache DecisionCacheInternal;
+
+	/** Timings of decisions made by this bot. */
+	FAIDecisionStats DecisionStatsInternal;
+
 	/** Controlled character */
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Owner Character"))
 	TObjectPtr<class APlayerCharacter> OwnerInternal = nullptr;
@@ -58,9 +178,6 @@ protected:
 	/** This is called only in the gameplay before calling begin play. */
 	virtual void PostInitializeComponents() override;
 
-	/** Called when the game starts or when spawned */
-	virtual void BeginPlay() override;
-
 	/** Allows the controller to react on possessing the pawn to enable AI. */
 	virtual void OnPossess(APawn* InPawn) override;
 
@@ -73,11 +190,29 @@ protected:
 	/** Stops running to target. */
 	virtual void Reset() override;
 
-	/** The main AI logic */
+	/** The main AI logic, prepares, makes and applies the decision at once. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void UpdateAI();
 
-	/** Enable or disable AI for this bot. */
+	/** Gathers on the game thread everything that is needed to make the decision.
+	 * @return false if the bot can't make any decision right now or the previous decision is still actual. */
+	bool PrepareDecision(FAIDecisionInput& OutInput);
+
+	/** Decides where to move and whether to put the bomb.
+	 * Reads only given snapshot and input without touching any object, so could be called for many bots in parallel. */
+	static void MakeDecision(const FAIWorldSnapshot& Snapshot, const FAIDecisionInput& Input, FAIDecision& OutDecision);
+
+	/** Applies the decision on the game thread: moves the bot and puts the bomb. */
+	void ApplyDecision(const FAIDecision& Decision);
+
+	/** Writes the made decision to the telemetry if enabled, @see FBomberTelemetry. */
+	void RecordDecisionTelemetry(const FAIDecision& Decision, double DecisionSeconds) const;
+
+	/** Returns how often in seconds this bot has to be updated by its distance to the nearest threat and the game phase.
+	 * @see UAIDataAsset::NearThreatTickIntervalInternal and UAIDataAsset::IsolatedTickIntervalInternal. */
+	float GetUpdateInterval() const;
+
+	/** Enable or disable AI for this bot, enabled bot is updated by the UAISchedulerSubsystem. */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, meta = (BlueprintProtected))
 	void SetAI(bool bShouldEnable);
 
@@ -4,6 +4,8 @@
 
 #include "GameFramework/PlayerController.h"
 //---
+#include "Structures/GridSpectatorStream.h"
+//---
 #include "MyPlayerController.generated.h"
 
 enum class ECurrentGameState : uint8;
@@ -55,6 +57,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void SetMenuState();
 
+	/** Is called on the spectator client to rebuild the grid from the layout of the server. */
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveSpectatorLayout(const FGridSpectatorLayout& Layout);
+
+	/** Is called on the spectator client for grid events of each simulation step in their order. */
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveSpectatorEvents(const FGridSpectatorEvents& Events);
+
+	/** Is called on the spectator client at reduced frequency with positions of players, older positions could be dropped. */
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveSpectatorPlayers(const FGridSpectatorPlayers& Players);
+
 	/** Returns the component that responsible for mouse-related logic like showing and hiding itself. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	class UMouseActivityComponent* GetMouseActivityComponent() const { return MouseComponentInternal; }
@@ -81,6 +95,10 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "All Input Contexts"))
 	TArray<TObjectPtr<const UMyInputMappingContext>> AllInputContextsInternal;
 
+	/** Contexts of AllInputContextsInternal that are chosen for each game state, is cached on first request of a state and reset when the list is changed.
+	 * @see AMyPlayerController::GetInputContextsByState */
+	TMap<ECurrentGameState, TArray<const UMyInputMappingContext*>> InputContextsByStateInternal;
+
 	/** Component that responsible for mouse-related logic like showing and hiding itself. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = ""))
 	TObjectPtr<class UMouseActivityComponent> MouseComponentInternal = nullptr;
@@ -120,6 +138,10 @@ protected:
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void OnWidgetsInitialized();
 
+	/** Is called when the Settings widget is created on demand. */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void OnSettingsWidgetCreated(class USettingsWidget* SettingsWidget);
+
 	/** Listen to toggle movement input. */
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void OnGameStateChanged(ECurrentGameState CurrentGameState);
@@ -154,6 +176,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void SetInputContextEnabled(bool bEnable, const UMyInputMappingContext* InInputContext);
 
+	/** Returns contexts of AllInputContextsInternal that are chosen for given game state, is cached per state. */
+	const TArray<const UMyInputMappingContext*>& GetInputContextsByState(ECurrentGameState GameState);
+
+	/** Collects contexts to turn on or off according given game state without applying them.
+	 * @see AMyPlayerController::SetAllInputContextsEnabled */
+	void GatherInputContextsByState(bool bEnable, ECurrentGameState CurrentGameState, bool bInvertRest, TArray<const UMyInputMappingContext*>& InOutToEnable, TArray<const UMyInputMappingContext*>& InOutToDisable);
+
+	/** Applies all changes of input contexts as one diff: contexts that are already in required state are skipped, and mappings are rebuilt only once.
+	 * @param ToEnable Contexts to enable, their input actions are bound if not yet.
+	 * @param ToDisable Contexts to disable. */
+	void ApplyInputContexts(const TArray<const UMyInputMappingContext*>& ToEnable, const TArray<const UMyInputMappingContext*>& ToDisable);
+
 	/** Set up input bindings in given contexts. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void BindInputActionsInContext(const UMyInputMappingContext* InInputContext);
@@ -38,6 +38,41 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE int32 GetNearDangerousRadius() const { return NearDangerousRadiusInternal; }
 
+	/** Returns the time in seconds the bot keeps away from cells around their detonation.
+	* @see UAIDataAsset::DangerSafetyMarginInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetDangerSafetyMargin() const { return DangerSafetyMarginInternal; }
+
+	/** Returns the distance in cells to the threat when the bot is updated most often.
+	* @see UAIDataAsset::NearThreatRadiusInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetNearThreatRadius() const { return NearThreatRadiusInternal; }
+
+	/** Returns how often in seconds the bot is updated while any threat is near.
+	* @see UAIDataAsset::NearThreatTickIntervalInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetNearThreatTickInterval() const { return NearThreatTickIntervalInternal; }
+
+	/** Returns the distance in cells to the threat beyond which the bot is isolated.
+	* @see UAIDataAsset::IsolatedRadiusInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetIsolatedRadius() const { return IsolatedRadiusInternal; }
+
+	/** Returns how often in seconds the bot is updated while it is isolated.
+	* @see UAIDataAsset::IsolatedTickIntervalInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetIsolatedTickInterval() const { return IsolatedTickIntervalInternal; }
+
+	/** Returns the number of alive players from which isolated bots are not slowed down anymore.
+	* @see UAIDataAsset::FinalPlayersNumInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetFinalPlayersNum() const { return FinalPlayersNumInternal; }
+
+	/** Returns the time budget in milliseconds per frame for updating all bots, 0 if is not limited.
+	* @see UAIDataAsset::FrameBudgetMsInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetFrameBudgetMs() const { return FrameBudgetMsInternal; }
+
 protected:
 	/** The search radius of items. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Item Search Radius", ShowOnlyInnerProperties))
@@ -47,11 +82,41 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Crossway Search Radius", ShowOnlyInnerProperties))
 	int32 CrosswaySearchRadiusInternal = 2;
 
-	/** Determine radius of near dangerous cells (length <= near dangerous radius). */
+	/** Determine radius of near dangerous cells (length <= near dangerous radius).
+	 * Is used only if the bot can't find any escape by detonation times of dangerous cells. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Near Dangerous Radius", ShowOnlyInnerProperties))
 	int32 NearDangerousRadiusInternal = 3;
 
 	/** Determine filter radius of near cells (length <= near radius). */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Near Filter Radius", ShowOnlyInnerProperties))
 	int32 NearFilterRadiusInternal = 3;
+
+	/** Time in seconds before and after the detonation of the cell when the bot does not step on this cell while escaping. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Danger Safety Margin", ShowOnlyInnerProperties))
+	float DangerSafetyMarginInternal = 0.2f;
+
+	/** Bomb, another player or dangerous cell within this distance in cells makes the bot updated by the Near Threat Tick Interval. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Near Threat Radius", ShowOnlyInnerProperties, ClampMin = "0"))
+	int32 NearThreatRadiusInternal = 2;
+
+	/** How often in seconds the bot is updated while any threat is near, is faster than the general tick interval of the game. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Near Threat Tick Interval", ShowOnlyInnerProperties, ClampMin = "0"))
+	float NearThreatTickIntervalInternal = 0.1f;
+
+	/** There is no threat within this distance in cells, the bot is isolated and updated by the Isolated Tick Interval. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Isolated Radius", ShowOnlyInnerProperties, ClampMin = "0"))
+	int32 IsolatedRadiusInternal = 5;
+
+	/** How often in seconds the bot is updated while it is isolated, is slower than the general tick interval of the game. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Isolated Tick Interval", ShowOnlyInnerProperties, ClampMin = "0"))
+	float IsolatedTickIntervalInternal = 0.4f;
+
+	/** When this or less players are alive, the game is in its final phase and isolated bots are updated by the general tick interval of the game. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Final Players Num", ShowOnlyInnerProperties, ClampMin = "0"))
+	int32 FinalPlayersNumInternal = 2;
+
+	/** Time budget in milliseconds per frame for updating all bots, the rest is postponed to next frames: 0 (Unlimited).
+	 * Is overridden by Bomber.AI.FrameBudgetMs if it is set. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Frame Budget Ms", ShowOnlyInnerProperties, ClampMin = "0"))
+	float FrameBudgetMsInternal = 0.f;
 };
\ No newline at end of file
@@ -6,6 +6,39 @@
 //---
 #include "BombDataAsset.generated.h"
 
+/**
+ * Describes how explosions are emitted on one scalability level of game settings.
+ * Lower tiers keep big chain reactions in the fixed budget of Niagara systems.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FExplosionVFXTier
+{
+	GENERATED_BODY()
+
+	/** The default tier that is used when no tier is set: each exploded cell spawns its own system without a limit. */
+	static const FExplosionVFXTier Default;
+
+	/** The max amount of explosion systems spawned by all blasts in one frame, so chain reactions stay in the budget, if 0, is not limited. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0"))
+	int32 MaxSystemsPerFrame = 0;
+
+	/** If true, the system is spawned on each exploded cell, otherwise the only one system is spawned in the center of each blast. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++")
+	bool bPerCellEmission = true;
+
+	/** Is passed to the 'ParticlesScale' user parameter of the system to scale spawn counts of its emitters. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0"))
+	float ParticlesScale = 1.f;
+
+	/** Is passed to the 'EmitLight' user parameter of the system to enable its light renderers. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++")
+	bool bEmitLight = true;
+
+	/** The amount of pooled systems that are spawned out of view once the match is starting, so the first blasts do not create components. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0"))
+	int32 PrewarmNum = 0;
+};
+
 /**
  * Describes common data for all bombs.
  */
@@ -34,20 +67,57 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	class UMaterialInterface* GetBombMaterial(int32 Index) const { return BombMaterialsInternal.IsValidIndex(Index) ? BombMaterialsInternal[Index] : nullptr; }
 
+	/** Returns the amount of bomb colors.
+	 * @see UBombDataAsset::BombColorsInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetBombColorsNum() const { return BombColorsInternal.Num(); }
+
+	/** Returns the bomb color by specified index.
+	 * @see UBombDataAsset::BombColorsInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE FLinearColor GetBombColor(int32 Index) const { return BombColorsInternal.IsValidIndex(Index) ? BombColorsInternal[Index] : FLinearColor::White; }
+
+	/** Returns the first index of custom primitive data where the bomb color is written.
+	 * @see UBombDataAsset::BombColorCustomDataIndexInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetBombColorCustomDataIndex() const { return BombColorCustomDataIndexInternal; }
+
 	/** Get the bomb explosion VFX. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE class UNiagaraSystem* GetExplosionVFX() const { return ExplosionVFXInternal; }
 
+	/** Returns the explosion tier of the current overall scalability level of game settings.
+	 * @see UBombDataAsset::ExplosionVFXTiersInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FExplosionVFXTier& GetExplosionVFXTier() const;
+
 protected:
+	/** Strips cosmetic references when is cooked for the dedicated server, @see FCosmeticCookScope. */
+	virtual void Serialize(FArchive& Ar) override;
+
 	/** The lifetime of a bomb. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Life Span", ShowOnlyInnerProperties))
 	float LifeSpanInternal = 2.f;
 
 	/** All bomb materials. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Bomb Materials", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Bomb Materials", ShowOnlyInnerProperties))
 	TArray<TObjectPtr<class UMaterialInterface>> BombMaterialsInternal;
 
+	/** Colors of bombs that are written to custom primitive data, so all bombs share the material of their mesh and could be batched.
+	 * If set, is used instead of Bomb Materials, the material has to read the color from custom primitive data. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Bomb Colors", ShowOnlyInnerProperties))
+	TArray<FLinearColor> BombColorsInternal;
+
+	/** The first index of custom primitive data where RGBA of the bomb color is written, takes 4 floats. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Bomb Color Custom Data Index", ClampMin = "0", ShowOnlyInnerProperties))
+	int32 BombColorCustomDataIndexInternal = 0;
+
 	/** The emitter of the bomb explosion */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Explosion Particle", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Explosion Particle", ShowOnlyInnerProperties))
 	TObjectPtr<class UNiagaraSystem> ExplosionVFXInternal = nullptr;
+
+	/** Explosion tiers by overall scalability levels starting from Low, the Custom level uses the last tier.
+	 * If the level is higher than set tiers, the last tier is used. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Explosion VFX Tiers", ShowOnlyInnerProperties))
+	TArray<FExplosionVFXTier> ExplosionVFXTiersInternal;
 };
\ No newline at end of file
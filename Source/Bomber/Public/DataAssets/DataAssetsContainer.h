@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Engine/DeveloperSettings.h"
+#include "UObject/ObjectKey.h"
 //---
 #include "DataAssetsContainer.generated.h"
 
@@ -55,6 +56,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	static const class UGameStateDataAsset* GetGameStateDataAsset();
 
+	/** Returns paths of all data assets of this container, is used to preload them asynchronously.
+	 * @see UDataAssetsPreloadSubsystem */
+	static void GetAllDataAssetPaths(TArray<FSoftObjectPath>& OutDataAssetPaths);
+
 	/*********************************************************************************************
 	 * Getters of Level Actor's data assets
 	 ********************************************************************************************* */
@@ -90,6 +95,34 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	static UClass* GetActorClassByType(EActorType ActorType);
 
+	/** Forgets resolved lookup tables of level actor data assets, so they are built again on next request.
+	 * Is called in editor when data assets are changed. */
+	static void ResetResolvedDataAssets();
+
+protected:
+	/** Is true once lookup tables of level actor data assets are built. */
+	mutable bool bActorsDataAssetsResolvedInternal = false;
+
+	/** Loaded level actor data assets in order of ActorsDataAssets array, are resolved once on first request. */
+	mutable TArray<TWeakObjectPtr<ULevelActorDataAsset>> ResolvedActorsDataAssetsInternal;
+
+	/** Level actor data assets by bit index of their actor type, are resolved once on first request. */
+	mutable TArray<TWeakObjectPtr<ULevelActorDataAsset>> DataAssetsByTypeBitInternal;
+
+	/** Found data assets by requested actor class, is filled on demand, null entries cache classes without data asset. */
+	mutable TMap<TObjectKey<UClass>, TWeakObjectPtr<ULevelActorDataAsset>> DataAssetsByActorClassInternal;
+
+	/** Found data assets by requested data asset class, is filled on demand. */
+	mutable TMap<TObjectKey<UClass>, TWeakObjectPtr<ULevelActorDataAsset>> DataAssetsByDataAssetClassInternal;
+
+	/** Loads all level actor data assets once and builds lookup tables by their actor types. */
+	void ResolveActorsDataAssets() const;
+
+#if WITH_EDITOR
+	/** Is called when any property of this container is changed in editor. */
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif //WITH_EDITOR
+
 	/*********************************************************************************************
 	 * Data Assets
 	 ********************************************************************************************* */
@@ -6,6 +6,18 @@
 //---
 #include "GeneratedMapDataAsset.generated.h"
 
+/**
+ * Defines how level actors are generated on the Generated Map.
+ */
+UENUM(BlueprintType)
+enum class ELevelGenerationMode : uint8
+{
+	///< Fills the level randomly and rerolls it until all required cells are reachable
+	Random,
+	///< Fills the level randomly once and removes walls that isolate required cells, never rerolls
+	Constructive
+};
+
 /**
  * Unique data about one separated level.
  */
@@ -31,6 +43,69 @@ struct BOMBER_API FLevelStreamRow
 	/** The name of a level on UI. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Level")
 	FText LevelName = TEXT_NONE;
+
+	/** The pak chunk where all assets of this level type are cooked by its Level Type Asset Label, so it could be installed later.
+	 * If none, the level type is cooked into the base chunk and is always installed, @see ULevelTypeAssetLabel. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Level", meta = (ClampMin = "-1"))
+	int32 ChunkId = INDEX_NONE;
+};
+
+/**
+ * Coefficients to estimate the cost of regenerating the level of given size, should be tuned by results of 'Bomber.Benchmark.LevelGeneration'.
+ * Defaults keep the max level size affordable with default chances even if spawning is not spread over frames.
+ * Is used by the server to clamp level sizes that would exceed the frame budget or the replication limit.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FLevelSizeCostModel
+{
+	GENERATED_BODY()
+
+	/** Levels larger than this size are always clamped. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++")
+	FIntPoint MaxLevelSize = FIntPoint(51, 51);
+
+	/** The time of one random fill and its path check per cell. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0", Units = "Milliseconds"))
+	float GenerationMsPerCell = 0.001f;
+
+	/** The expected number of random fills in the Random generation mode, the Constructive mode always takes one. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "1"))
+	float ExpectedGenerationAttempts = 3.f;
+
+	/** The time of taking one generated level actor from the pool and placing it on the grid. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0", Units = "Milliseconds"))
+	float SpawnMsPerActor = 0.003f;
+
+	/** Bytes sent to each client for one spawned level actor, includes the actor channel and its map component delta. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0", Units = "Bytes"))
+	int32 ReplicatedBytesPerActor = 120;
+
+	/** The time of the regeneration frame that should not be exceeded. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0", Units = "Milliseconds"))
+	float FrameBudgetMs = 16.f;
+
+	/** Bytes that could be sent to each client for the whole regeneration, is not limited if 0. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0", Units = "Bytes"))
+	int32 MaxReplicatedBytes = 0;
+};
+
+/**
+ * Estimated cost of regenerating the level of some size.
+ * @see UGeneratedMapDataAsset::EstimateLevelSizeCost()
+ */
+struct BOMBER_API FLevelSizeCost
+{
+	/** The expected number of generated level actors. */
+	int32 ActorsNum = 0;
+
+	/** The time of the regeneration frame: generation and the part of spawning that is not spread over next frames. */
+	float FrameMs = 0.f;
+
+	/** The total time of spawning all generated level actors. */
+	float SpawnMs = 0.f;
+
+	/** Bytes sent to each client for all generated level actors. */
+	int64 ReplicatedBytes = 0;
 };
 
 /**
@@ -49,6 +124,19 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	void GetLevelStreamRows(TArray<FLevelStreamRow>& OutRows) const { OutRows = LevelsInternal; }
 
+	/** Returns the pak chunk of given level type, is none if the level type is cooked into the base chunk.
+	 * @see FLevelStreamRow::ChunkId */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	int32 GetLevelTypeChunkId(ELevelType LevelType) const;
+
+	/** Returns true if the pak chunk of given level type is installed, so the level type can be loaded. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	bool IsLevelTypeInstalled(ELevelType LevelType) const;
+
+	/** Requests the platform to install the pak chunk of given level type in background with high priority if it's not installed yet. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void RequestLevelTypeInstall(ELevelType LevelType) const;
+
 	/** Get UGeneratedMapDataAsset::WallsChanceInternal. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE int32 GetWallsChance() const { return WallsChanceInternal; }
@@ -57,6 +145,22 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE int32 GetBoxesChance() const { return BoxesChanceInternal; }
 
+	/** Get UGeneratedMapDataAsset::GenerationSeedInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetGenerationSeed() const { return GenerationSeedInternal; }
+
+	/** Get UGeneratedMapDataAsset::MaxGenerationAttemptsInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetMaxGenerationAttempts() const { return MaxGenerationAttemptsInternal; }
+
+	/** Get UGeneratedMapDataAsset::GenerationModeInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE ELevelGenerationMode GetGenerationMode() const { return GenerationModeInternal; }
+
+	/** Get UGeneratedMapDataAsset::PlayersNumInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetPlayersNum() const { return PlayersNumInternal; }
+
 	/** Get UGeneratedMapDataAsset::CollisionsAssetInternal. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE TSubclassOf<class AActor> GetCollisionsAssetClass() const { return CollisionsAssetInternal; }
@@ -65,6 +169,47 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE bool IsLockedOnZero() const { return LockOnZeroInternal; }
 
+	/** Get UGeneratedMapDataAsset::PoolWarmUpCountsInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE TMap<EActorType, int32>& GetPoolWarmUpCounts() const { return PoolWarmUpCountsInternal; }
+
+	/** Get UGeneratedMapDataAsset::SpawnBudgetMsInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetSpawnBudgetMs() const { return SpawnBudgetMsInternal; }
+
+	/** Get UGeneratedMapDataAsset::bInstancedWallsAndBoxesInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsInstancedWallsAndBoxes() const { return bInstancedWallsAndBoxesInternal; }
+
+	/** Get UGeneratedMapDataAsset::bInstancedCollisionInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsInstancedCollision() const { return bInstancedCollisionInternal; }
+
+	/** Get UGeneratedMapDataAsset::bMergedStaticWallsInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsMergedStaticWalls() const { return bMergedStaticWallsInternal; }
+
+	/** Get UGeneratedMapDataAsset::RecentLevelTypesNumInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetRecentLevelTypesNum() const { return RecentLevelTypesNumInternal; }
+
+	/** Get UGeneratedMapDataAsset::LevelUnloadDelayInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetLevelUnloadDelay() const { return LevelUnloadDelayInternal; }
+
+	/** Get UGeneratedMapDataAsset::LevelSizeCostModelInternal. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FLevelSizeCostModel& GetLevelSizeCostModel() const { return LevelSizeCostModelInternal; }
+
+	/** Returns the estimated cost of regenerating the level of given size by current chances and the cost model. */
+	FLevelSizeCost EstimateLevelSizeCost(const FIntPoint& LevelSize) const;
+
+	/** Returns true if the level of given size could be regenerated within the frame budget and the replication limit. */
+	bool IsLevelSizeAffordable(const FIntPoint& LevelSize) const;
+
+	/** Returns given size shrunk to the largest affordable one, sides are shrunk by two cells to keep them unpaired (odd). */
+	FIntPoint ClampLevelSize(const FIntPoint& LevelSize) const;
+
 protected:
 	/** Contains all used levels. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Levels", TitleProperty = "LevelType", ShowOnlyInnerProperties))
@@ -78,6 +223,24 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Boxes Chance", ShowOnlyInnerProperties, Units = "Percent", ClampMin = "0", ClampMax = "100"))
 	int32 BoxesChanceInternal = 70;
 
+	/** The seed of level actors generation, is useful to reproduce the same layout.
+	 * If 0, the new random seed is picked for each generation. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Generation Seed", ShowOnlyInnerProperties))
+	int32 GenerationSeedInternal = 0;
+
+	/** The maximum number of random fills before the path to all required cells is carved through generated walls. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Max Generation Attempts", ShowOnlyInnerProperties, ClampMin = "1"))
+	int32 MaxGenerationAttemptsInternal = 20;
+
+	/** Defines how level actors are generated, the constructive mode takes linear time on any level size. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Generation Mode", ShowOnlyInnerProperties))
+	ELevelGenerationMode GenerationModeInternal = ELevelGenerationMode::Random;
+
+	/** The number of characters spawned on the generated level, is rounded down to the multiple of 4 since spawns are mirrored to each quarter of the level.
+	 * Beyond 4, characters are spread between corners along edges and quarters, so the level has to be large enough for all of them. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Players Num", ShowOnlyInnerProperties, ClampMin = "4", ClampMax = "16"))
+	int32 PlayersNumInternal = 4;
+
 	/** Asset that contains scalable collision. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Collisions Asset", ShowOnlyInnerProperties))
 	TSubclassOf<class AActor> CollisionsAssetInternal = nullptr;
@@ -85,4 +248,44 @@ protected:
 	/** If true, the level position will be locked on the (0,0,0) location. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Lock Location On Zero", ShowOnlyInnerProperties))
 	bool LockOnZeroInternal = true;
+
+	/** The number of inactive level actors of each type that are created in pools on the map load.
+	 * Should be the expected count of each type on the largest level, so the match start does not spawn new actors. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Pool Warm Up Counts", ShowOnlyInnerProperties))
+	TMap<EActorType, int32> PoolWarmUpCountsInternal;
+
+	/** The time in milliseconds per frame for spawning generated level actors, the rest is spawned on next frames.
+	 * If 0, all level actors are requested from pools at once. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Spawn Budget Ms", ShowOnlyInnerProperties, ClampMin = "0", Units = "Milliseconds"))
+	float SpawnBudgetMsInternal = 2.f;
+
+	/** If true, meshes of walls and boxes are drawn as instances by the Generated Map instead of a mesh component per level actor.
+	 * Level actors are still spawned for the gameplay logic and collisions. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Instanced Walls And Boxes", ShowOnlyInnerProperties))
+	bool bInstancedWallsAndBoxesInternal = false;
+
+	/** If true, collisions of walls and boxes are handled by instances of the Generated Map as well, so own collision boxes of these level actors are disabled.
+	 * Each mesh component registers all its instance bodies in one batch, removed boxes release their bodies by hidden instances.
+	 * Is used only if 'Instanced Walls And Boxes' is enabled, meshes of walls and boxes have to contain simple collisions. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Instanced Collision", ShowOnlyInnerProperties, EditCondition = "bInstancedWallsAndBoxesInternal"))
+	bool bInstancedCollisionInternal = false;
+
+	/** If true, walls of baked layouts are drawn by one instanced mesh per level type instead of one per chunk of the grid.
+	 * Walls never change on baked layouts, so the merged mesh is built once and costs the least draw calls, while chunks are still used by boxes.
+	 * Is used only if 'Instanced Walls And Boxes' is enabled, generated layouts keep chunked walls. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Merged Static Walls", ShowOnlyInnerProperties, EditCondition = "bInstancedWallsAndBoxesInternal"))
+	bool bMergedStaticWallsInternal = false;
+
+	/** Coefficients to estimate the cost of regenerating the level, the server clamps level sizes that exceed its budget. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Level Size Cost Model", ShowOnlyInnerProperties))
+	FLevelSizeCostModel LevelSizeCostModelInternal;
+
+	/** The memory budget of streaming levels: the number of most recently used level types that are kept loaded besides the current one.
+	 * Other level types are unloaded once the level type is not switched for 'Level Unload Delay', are loaded back on switching to them. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Recent Level Types Num", ShowOnlyInnerProperties, ClampMin = "0"))
+	int32 RecentLevelTypesNumInternal = 3;
+
+	/** The time in seconds without switching level types after which level types over the budget are unloaded. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Level Unload Delay", ShowOnlyInnerProperties, ClampMin = "0", Units = "s"))
+	float LevelUnloadDelayInternal = 5.f;
 };
\ No newline at end of file
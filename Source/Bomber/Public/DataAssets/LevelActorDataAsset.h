@@ -5,7 +5,7 @@
 #include "Engine/DataAsset.h"
 //---
 #include "Bomber.h"
-#include "Engine/EngineTypes.h" // ECollisionResponse
+#include "Engine/EngineTypes.h" // ECollisionResponse, ENetDormancy
 //---
 #include "LevelActorDataAsset.generated.h"
 
@@ -37,6 +37,71 @@ protected:
 #endif //WITH_EDITOR
 };
 
+/**
+ * Network settings of level actors of the same type, are applied by the Map Component on the server.
+ * Default values keep the replication settings of the actor class.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FLevelActorNetPolicy
+{
+	GENERATED_BODY()
+
+	/** How often per second the actor is considered for replication, if 0, class default is used. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0", Units = "Hertz"))
+	float NetUpdateFrequency = 0.f;
+
+	/** Priority of the actor for the bandwidth, if 0, class default is used. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0"))
+	float NetPriority = 0.f;
+
+	/** If true, the actor is relevant for all connections regardless of its location. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++")
+	bool bAlwaysRelevant = true;
+
+	/** Dormancy of the actor once it is placed on the level.
+	 * Static actors should be dormant, so they are replicated once and woken only when changed or destroyed. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++")
+	TEnumAsByte<ENetDormancy> NetDormancy = DORM_Awake;
+
+	/** Name of the Iris filter for not always relevant actors, e.g: 'Spatial' as it is named in the Iris filter definitions.
+	 * If none, the default filter of the replication system is used. Is ignored by the legacy replication. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++")
+	FName IrisFilterName = NAME_None;
+
+	/** Applies update frequency, priority and relevancy of this policy to given actor, dormancy is applied separately on placing. */
+	void ApplyToActor(AActor& Actor) const;
+
+	/** Applies the filter and the static priority of this policy to given actor in the Iris replication system.
+	 * Has to be called once the actor is replicated, does nothing on the legacy replication. */
+	void ApplyToReplicationSystem(const AActor& Actor) const;
+};
+
+/**
+ * Limits of the pool of inactive level actors of the same type, are applied by the Generated Map on the server.
+ * Default values keep all inactive level actors in the pool for the whole session.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FLevelActorPoolPolicy
+{
+	GENERATED_BODY()
+
+	/** The max number of inactive level actors kept in the pool, others are destroyed once returned, if 0, is not limited. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0"))
+	int32 MaxInactiveNum = 0;
+
+	/** Once no level actors are returned to the pool for this time, inactive ones are destroyed down to the warm-up count, if 0, is never shrunk by idle.
+	 * @see UGeneratedMapDataAsset::PoolWarmUpCountsInternal */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (ClampMin = "0", Units = "s"))
+	float ShrinkAfterIdleSeconds = 0.f;
+
+	/** If true, once the level of another size is generated, inactive level actors are destroyed down to the warm-up count. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++")
+	bool bShrinkOnLevelResize = false;
+
+	/** Returns true if any limit is set. */
+	FORCEINLINE bool IsLimited() const { return MaxInactiveNum > 0 || ShrinkAfterIdleSeconds > 0.f || bShrinkOnLevelResize; }
+};
+
 /**
  * The base data asset for the Bomber's data.
  */
@@ -73,9 +138,9 @@ public:
 	template <typename T>
 	const FORCEINLINE T* GetRowByPredicate(const TFunctionRef<bool(const ULevelActorRow&)>& Predicate) const { return Cast<T>(GetRowByPredicate(Predicate)); }
 
-	/** Return first found row by specified level types. */
+	/** Return first found row by specified level types, is constant-time lookup in the precomputed table. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	const FORCEINLINE ULevelActorRow* GetRowByLevelType(ELevelType LevelType) const { return GetRowByPredicate([LevelType](const ULevelActorRow& RowIt) { return RowIt.LevelType == LevelType || RowIt.LevelType == ELT::Max; }); }
+	const ULevelActorRow* GetRowByLevelType(ELevelType LevelType) const;
 
 	template <typename T>
 	const FORCEINLINE T* GetRowByLevelType(ELevelType LevelType) const { return Cast<T>(GetRowByLevelType(LevelType)); }
@@ -84,6 +149,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	const FORCEINLINE ULevelActorRow* GetRowByMesh(const class UStreamableRenderAsset* Mesh) const { return GetRowByPredicate([Mesh](const ULevelActorRow& RowIt) { return RowIt.Mesh == Mesh; }); }
 
+	/** Precomputes the first found row for each level type, is called on first lookup and on any change of rows.
+	 * Is overridden by child data assets to rebuild their own lookups together with this one. */
+	virtual void RebuildRowsByLevelType() const;
+
 	/** Returns overall number of contained rows. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE int32 GetRowsNum() const { return RowsInternal.Num(); }
@@ -104,6 +173,19 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE ECollisionResponse GetCollisionResponse() const { return CollisionResponseInternal; }
 
+	/** Returns true if an actor, whose data is described by this data asset, never changes once it is placed on the level.
+	 * @see UMapComponent::IsSlimActorType */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsStatic() const { return bIsStaticInternal; }
+
+	/** Returns network settings of an actor, whose data is described by this data asset. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FLevelActorNetPolicy& GetNetPolicy() const { return NetPolicyInternal; }
+
+	/** Returns limits of the pool of inactive actors, whose data is described by this data asset. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FLevelActorPoolPolicy& GetPoolPolicy() const { return PoolPolicyInternal; }
+
 protected:
 	/** DevelopmentOnly: internal class of rows, is overriden by child data assets, used on adding new row. */
 	UPROPERTY(BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Row Class", DevelopmentOnly))
@@ -113,6 +195,10 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Instanced, meta = (BlueprintProtected, DisplayName = "Rows", ShowOnlyInnerProperties))
 	TArray<TObjectPtr<class ULevelActorRow>> RowsInternal;
 
+	/** First found row for each value of ELevelType including combined flags, is rebuilt from RowsInternal.
+	 * @see ULevelActorDataAsset::RebuildRowsByLevelType */
+	mutable TArray<TWeakObjectPtr<const ULevelActorRow>> RowsByLevelTypeInternal;
+
 	/** Class of an actor, whose data is described by this data asset. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Actor Class", ShowOnlyInnerProperties))
 	TSoftClassPtr<class AActor> ActorClassInternal = nullptr;
@@ -129,6 +215,20 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Collision Response", ShowOnlyInnerProperties))
 	TEnumAsByte<ECollisionResponse> CollisionResponseInternal = ECR_Overlap;
 
+	/** If true, an actor, whose data is described by this data asset, never changes once it is placed on the level, e.g: walls.
+	 * While its meshes and collisions are instanced by the Generated Map, its actor is kept slim:
+	 * without own collision component and without replication, since clients know its cells from the replicated layout. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Is Static", ShowOnlyInnerProperties))
+	bool bIsStaticInternal = false;
+
+	/** Network settings of an actor, whose data is described by this data asset: update frequency, relevancy and dormancy. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Net Policy", ShowOnlyInnerProperties))
+	FLevelActorNetPolicy NetPolicyInternal;
+
+	/** Limits of the pool of inactive actors, whose data is described by this data asset: max count and shrinking. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Pool Policy", ShowOnlyInnerProperties))
+	FLevelActorPoolPolicy PoolPolicyInternal;
+
 #if WITH_EDITOR
 	/** Handle adding new rows. */
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
@@ -0,0 +1,47 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Engine/PrimaryAssetLabel.h"
+//---
+#include "Bomber.h"
+//---
+#include "LevelTypeAssetLabel.generated.h"
+
+/**
+ * Labels all assets of one level type, so they are cooked into the pak chunk of this level type instead of the base one.
+ * Collects the streaming level, meshes of level actor rows, player props and animations, and music of its level type from data assets on saving.
+ * Rows that are shared by several level types are not labeled, so they stay in the base chunk.
+ * The chunk is taken from FLevelStreamRow::ChunkId of the Generated Map Data Asset, where the game checks whether the level type is installed.
+ */
+UCLASS(Blueprintable, BlueprintType)
+class BOMBER_API ULevelTypeAssetLabel final : public UPrimaryAssetLabel
+{
+	GENERATED_BODY()
+
+public:
+	/** Default constructor. */
+	ULevelTypeAssetLabel();
+
+	/** Returns the level type of all labeled assets.
+	 * @see ULevelTypeAssetLabel::LevelTypeInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE ELevelType GetLevelType() const { return LevelTypeInternal; }
+
+protected:
+	/** The level type of all labeled assets. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Level Type", ShowOnlyInnerProperties))
+	ELevelType LevelTypeInternal = ELT::None;
+
+#if WITH_EDITOR
+	/** Collects assets of the level type before saving, so the label is always up to date with data assets. */
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+	/** Collects assets of the level type once it is changed. */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	/** Fills explicit assets and the chunk of this label by all assets of the level type. */
+	UFUNCTION(CallInEditor, Category = "C++", meta = (BlueprintProtected))
+	void RefreshLevelTypeAssets();
+#endif // WITH_EDITOR
+};
@@ -43,7 +43,7 @@ public:
 	FPlayerTag PlayerTag = FPlayerTag::None;
 
 	/** All meshes that will be attached to the player. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Row", meta = (ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Row", meta = (CosmeticOnly, ShowOnlyInnerProperties))
 	TArray<FAttachedMesh> PlayerProps;
 
 	/** The own movement animation for the each character. */
@@ -59,6 +59,7 @@ public:
 	FORCEINLINE int32 GetMaterialInstancesDynamicNum() const { return MaterialInstancesDynamicInternal.Num(); }
 
 	/** Returns the dynamic material instance of a player with specified skin.
+	 * Is created once per row and skin and shared by all characters, menu spots and props that use this skin.
 	 * @param SkinIndex The skin position to get.
 	 * @see UPlayerRow::MaterialInstancesDynamicInternal */
 	UFUNCTION(BlueprintPure, Category = "C++")
@@ -80,6 +81,10 @@ protected:
 	UPROPERTY(BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Material Instances Dynamic"))
 	TArray<TObjectPtr<class UMaterialInstanceDynamic>> MaterialInstancesDynamicInternal;
 
+	/** Strips props when is cooked for the dedicated server, @see FCosmeticCookScope.
+	 * Materials are kept since skins are validated by the number of dynamic materials on the server. */
+	virtual void Serialize(FArchive& Ar) override;
+
 #if WITH_EDITOR
 	/** Handle adding and changing material instance to prepare dynamic materials. */
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
@@ -117,6 +122,26 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	class UMaterialInterface* GetNameplateMaterial(int32 Index) const;
 
+	/** Returns true if nicknames are drawn by text render components through the shared font atlas instead of 3D widget components.
+	 * @see UPlayerDataAsset::bTextNameplatesInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsTextNameplatesEnabled() const { return bTextNameplatesInternal; }
+
+	/** Returns the optional material of nickname texts, the default text material is used if null.
+	 * @see UPlayerDataAsset::NicknameTextMaterialInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE class UMaterialInterface* GetNicknameTextMaterial() const { return NicknameTextMaterialInternal; }
+
+	/** Returns the world size of nickname texts.
+	 * @see UPlayerDataAsset::NicknameTextSizeInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetNicknameTextSize() const { return NicknameTextSizeInternal; }
+
+	/** Returns the transform of nickname texts relative to the nameplate mesh.
+	 * @see UPlayerDataAsset::NicknameTextTransformInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FTransform& GetNicknameTextTransform() const { return NicknameTextTransformInternal; }
+
 	/** Returns the Anim Blueprint class to use.
 	 * @see UPlayerDataAsset::AnimInstanceClassInternal. */
 	UFUNCTION(BlueprintPure, Category = "C++")
@@ -132,15 +157,35 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE FName GetSkinIndexParameter() const { return SkinIndexParameterInternal; }
 
-	/** Return first found row by specified player tag. */
+	/** Return first found row by specified player tag, is constant-time lookup in the precomputed map. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	const UPlayerRow* GetRowByPlayerTag(const FPlayerTag& PlayerTag) const;
 
+	/** Precomputes player rows by tags together with the base table of level types. */
+	virtual void RebuildRowsByLevelType() const override;
+
 protected:
 	/** All materials that are used by nameplate meshes. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Nameplate Materials", ShowOnlyInnerProperties))
 	TArray<TObjectPtr<class UMaterialInterface>> NameplateMaterialsInternal;
 
+	/** If true, nicknames are drawn by text render components that share one font atlas and are updated only on nickname change,
+	 * so 3D widget components of players are disabled and do not redraw their render targets. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Text Nameplates", ShowOnlyInnerProperties))
+	bool bTextNameplatesInternal = false;
+
+	/** The optional material of nickname texts, the default text material is used if null. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Nickname Text Material", EditCondition = "bTextNameplatesInternal", ShowOnlyInnerProperties))
+	TObjectPtr<class UMaterialInterface> NicknameTextMaterialInternal = nullptr;
+
+	/** The world size of nickname texts. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Nickname Text Size", ClampMin = "1", EditCondition = "bTextNameplatesInternal", ShowOnlyInnerProperties))
+	float NicknameTextSizeInternal = 32.f;
+
+	/** The transform of nickname texts relative to the nameplate mesh, by default faces up to the top-down camera. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Nickname Text Transform", EditCondition = "bTextNameplatesInternal", ShowOnlyInnerProperties))
+	FTransform NicknameTextTransformInternal = FTransform(FRotator(90.f, 180.f, 0.f), FVector(0.f, 0.f, 5.f));
+
 	/** The AnimBlueprint class to use, can set it only in the gameplay. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Anim Instance Class", ShowOnlyInnerProperties))
 	TSubclassOf<class UAnimInstance> AnimInstanceClassInternal = nullptr;
@@ -152,4 +197,8 @@ protected:
 	/** The name of a material parameter with a diffuse index. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Skin Index Parameter", ShowOnlyInnerProperties))
 	FName SkinIndexParameterInternal = TEXT("DiffuseIndex");
+
+	/** First found row for each player tag, is rebuilt from RowsInternal.
+	 * @see UPlayerDataAsset::RebuildRowsByLevelType */
+	mutable TMap<FPlayerTag, TWeakObjectPtr<const UPlayerRow>> RowsByPlayerTagInternal;
 };
@@ -10,6 +10,7 @@ class USoundsSubsystem;
 class USoundBase;
 class USoundClass;
 class USoundMix;
+class USoundConcurrency;
 
 enum class EEndGameState : uint8;
 enum class ELevelType : uint8;
@@ -52,16 +53,24 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "Get SFX Sound Class"))
 	FORCEINLINE USoundClass* GetSFXSoundClass() const { return SFXSoundClassInternal; }
 
-	/** Returns the music of specified level.
+	/** Returns the music of specified level if it's loaded.
 	 * @see USoundsDataAsset::LevelsMusicInternal */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	USoundBase* GetLevelMusic(ELevelType LevelType) const;
 
-	/** Returns the main menu music of specified level.
+	/** Returns the soft reference to the music of specified level, is loaded on demand with its level type.
+	 * @see USoundsDataAsset::LevelsMusicInternal */
+	TSoftObjectPtr<USoundBase> GetSoftLevelMusic(ELevelType LevelType) const;
+
+	/** Returns the main menu music of specified level if it's loaded.
 	 * @see USoundsDataAsset::LevelsMainMenuMusicInternal */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	USoundBase* GetLevelMainMenuMusic(ELevelType LevelType) const;
 
+	/** Returns the soft reference to the main menu music of specified level, is loaded on demand with its level type.
+	 * @see USoundsDataAsset::LevelsMainMenuMusicInternal */
+	TSoftObjectPtr<USoundBase> GetSoftLevelMainMenuMusic(ELevelType LevelType) const;
+
 	/** Return the background music by specified game state and level type. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	USoundBase* GetBackgroundMusic(ECurrentGameState CurrentGameState, ELevelType LevelType) const;
@@ -71,6 +80,26 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE USoundBase* GetExplosionSFX() const { return ExplosionSFXInternal; }
 
+	/** Returns the memory budget in megabytes of compressed level music that is kept retained.
+	 * @see USoundsDataAsset::MusicMemoryBudgetInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetMusicMemoryBudget() const { return MusicMemoryBudgetInternal; }
+
+	/** Returns the maximum number of explosion sounds that can be heard at the same time.
+	 * @see USoundsDataAsset::ExplosionMaxVoicesInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetExplosionMaxVoices() const { return ExplosionMaxVoicesInternal; }
+
+	/** Returns the time window in seconds during which new explosions are merged into the already playing sound.
+	 * @see USoundsDataAsset::ExplosionMergeWindowInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetExplosionMergeWindow() const { return ExplosionMergeWindowInternal; }
+
+	/** Returns the concurrency settings applied to pooled explosion sounds.
+	 * @see USoundsDataAsset::ExplosionConcurrencyInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE USoundConcurrency* GetExplosionConcurrency() const { return ExplosionConcurrencyInternal; }
+
 	/** Returns the sound that is played on gathering any power-up.
 	 * @see USoundsDataAsset::ItemPickUpInternal */
 	UFUNCTION(BlueprintPure, Category = "C++")
@@ -97,6 +126,9 @@ public:
 	FORCEINLINE USoundBase* GetUIClickSFX() const { return UIClickSFXInternal; }
 
 protected:
+	/** Strips cosmetic references when is cooked for the dedicated server, @see FCosmeticCookScope. */
+	virtual void Serialize(FArchive& Ar) override;
+
 	/** The Sound Manager that is responsible for audio in game. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Sounds Manager Class", ShowOnlyInnerProperties))
 	TSubclassOf<USoundsSubsystem> SoundsSubsystemClassInternal = nullptr;
@@ -117,35 +149,52 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "SFX Sound Class", ShowOnlyInnerProperties))
 	TObjectPtr<USoundClass> SFXSoundClassInternal = nullptr;
 
-	/** Contains all sounds of each level in the game. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Levels Music", ShowOnlyInnerProperties))
-	TMap<ELevelType, TObjectPtr<USoundBase>> LevelsMusicInternal;
+	/** Contains all sounds of each level in the game, are soft referenced to be cooked into the chunk of their level type. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Levels Music", ShowOnlyInnerProperties))
+	TMap<ELevelType, TSoftObjectPtr<USoundBase>> LevelsMusicInternal;
 
-	/** Contains all sounds of each level in the main menu. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Levels Main Menu Music", ShowOnlyInnerProperties))
-	TMap<ELevelType, TObjectPtr<USoundBase>> LevelsMainMenuMusicInternal;
+	/** Contains all sounds of each level in the main menu, are soft referenced to be cooked into the chunk of their level type. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Levels Main Menu Music", ShowOnlyInnerProperties))
+	TMap<ELevelType, TSoftObjectPtr<USoundBase>> LevelsMainMenuMusicInternal;
 
 	/** Returns the blast SFX. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Explosion Sound", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Explosion Sound", ShowOnlyInnerProperties))
 	TObjectPtr<USoundBase> ExplosionSFXInternal = nullptr;
 
+	/** The memory budget in megabytes of compressed level music that is kept retained.
+	 * Music of the current level and its neighbours is always retained, music of other levels is released once the budget is exceeded. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Music Memory Budget", ClampMin = "0", Units = "Megabytes", ShowOnlyInnerProperties))
+	int32 MusicMemoryBudgetInternal = 16;
+
+	/** The maximum number of explosion sounds that can be heard at the same time, the oldest one is restarted when all are busy. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Explosion Max Voices", ClampMin = "1", ShowOnlyInnerProperties))
+	int32 ExplosionMaxVoicesInternal = 3;
+
+	/** The time window in seconds during which new explosions are merged into the already playing sound instead of starting a new one. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Explosion Merge Window", ClampMin = "0", Units = "s", ShowOnlyInnerProperties))
+	float ExplosionMergeWindowInternal = 0.05f;
+
+	/** Optional concurrency settings applied to pooled explosion sounds, is useful to limit voices across other explosion-like sounds. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Explosion Concurrency", ShowOnlyInnerProperties))
+	TObjectPtr<USoundConcurrency> ExplosionConcurrencyInternal = nullptr;
+
 	/** The sound that is played on gathering any power-up. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Item Pick-Up SFX", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Item Pick-Up SFX", ShowOnlyInnerProperties))
 	TObjectPtr<USoundBase> ItemPickUpSFXInternal = nullptr;
 
 	/** The sound that is played right before the match ends. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "End-Game Countdown SFX", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "End-Game Countdown SFX", ShowOnlyInnerProperties))
 	TObjectPtr<USoundBase> EndGameCountdownSFXInternal = nullptr;
 
 	/** The sound that is played before the match starts. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Start Game Countdown SFX", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Start Game Countdown SFX", ShowOnlyInnerProperties))
 	TObjectPtr<USoundBase> StartGameCountdownSFXInternal = nullptr;
 
 	/** Contains all sounds of End-Game states. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "End-Game SFX", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "End-Game SFX", ShowOnlyInnerProperties))
 	TMap<EEndGameState, TObjectPtr<USoundBase>> EndGameSFXInternal;
 
 	/** The sound that is played on clicking any UI element. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "UI Click SFX", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "UI Click SFX", ShowOnlyInnerProperties))
 	TObjectPtr<USoundBase> UIClickSFXInternal = nullptr;
 };
@@ -25,10 +25,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE TSubclassOf<class UInGameWidget> GetInGameWidgetClass() const { return InGameWidgetClassInternal; }
 
-	/** Returns a class of the settings widget.
+	/** Returns a soft class of the settings widget, is not loaded until the widget is requested.
 	 * @see UUIDataAsset::SettingsWidgetClassInternal.*/
 	UFUNCTION(BlueprintPure, Category = "C++")
-	FORCEINLINE TSubclassOf<class USettingsWidget> GetSettingsWidgetClass() const { return SettingsWidgetClassInternal; }
+	const FORCEINLINE TSoftClassPtr<class USettingsWidget>& GetSettingsWidgetClass() const { return SettingsWidgetClassInternal; }
 
 	/** Returns a class of the nickname widget.
 	 * @see UUIDataAsset::NicknameWidgetClassInternal.*/
@@ -46,20 +46,23 @@ public:
 	const FORCEINLINE FText& GetEndGameText(EEndGameState EndGameState) const { return EndGameTextsInternal.FindChecked(EndGameState); }
 
 protected:
+	/** Strips cosmetic references when is cooked for the dedicated server, @see FCosmeticCookScope. */
+	virtual void Serialize(FArchive& Ar) override;
+
 	/** The class of a In-Game Widget blueprint. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "In-Game Widget Class", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "In-Game Widget Class", ShowOnlyInnerProperties))
 	TSubclassOf<class UInGameWidget> InGameWidgetClassInternal = nullptr;
 
-	/** The class of a Settings Widget blueprint. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Settings Widget Class", ShowOnlyInnerProperties))
-	TSubclassOf<class USettingsWidget> SettingsWidgetClassInternal = nullptr;
+	/** The class of a Settings Widget blueprint, is soft referenced since it is heavy and rarely opened. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Settings Widget Class", ShowOnlyInnerProperties))
+	TSoftClassPtr<class USettingsWidget> SettingsWidgetClassInternal = nullptr;
 
 	/** The class of a Nickname Widget blueprint. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "Nickname Widget Class", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "Nickname Widget Class", ShowOnlyInnerProperties))
 	TSubclassOf<class UUserWidget> NicknameWidgetClassInternal = nullptr;
 
 	/** The class of a FPS counter widget blueprint. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected, DisplayName = "FPS Counter Widget Class", ShowOnlyInnerProperties))
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (CosmeticOnly, BlueprintProtected, DisplayName = "FPS Counter Widget Class", ShowOnlyInnerProperties))
 	TSubclassOf<class UUserWidget> FPSCounterWidgetClassInternal = nullptr;
 
 	/** Contains the localized texts about specified end game to display on UI. */
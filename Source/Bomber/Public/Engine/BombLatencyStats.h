@@ -0,0 +1,54 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BOMBER_API, BomberLatency);
+
+/**
+ * Measured parts of the path from the bomb input to the placed bomb.
+ * Stages are measured on the machine where both their ends happen, so clocks of different machines are never compared.
+ */
+enum class EBombLatencyStage : uint8
+{
+	///< From the bound input action of the player controller to sending the ServerSpawnBomb request, on the owning client
+	InputToSend,
+	///< From the input to showing the predicted bomb, on the owning client
+	InputToPrediction,
+	///< From receiving the ServerSpawnBomb request to the bomb taken from the pool and placed on its cell, on the server
+	ReceiptToSpawn,
+	///< From the input to the authoritative bomb replicated on its cell, the whole round trip on the owning client
+	InputToVisible,
+	Num
+};
+
+/**
+ * Collects latency histograms of bomb placing, so prediction and pooling improvements could be quantified and regressions caught.
+ * Is disabled by default, is enabled by 'Bomber.Latency.Profiling 1'.
+ * Each sample is recorded as CSV stat of the BomberLatency category, histograms with percentiles are printed by 'Bomber.Latency.DumpStats' and reset by 'Bomber.Latency.ResetStats'.
+ */
+struct BOMBER_API FBombLatencyStats
+{
+	/** Returns true if latencies are measured. */
+	static bool IsEnabled();
+
+	/** Adds the sample of given stage in seconds. */
+	static void AddSample(EBombLatencyStage Stage, double Seconds);
+
+	/** Remembers the time of the bomb input of given character on given cell, is called on the owning machine of the player. */
+	static void OnInput(int32 CellIndex, int32 CharacterID);
+
+	/** Returns the time of the remembered input on given cell, 0 if there was no input. */
+	static double GetInputTime(int32 CellIndex);
+
+	/** Is called on the owning machine when the authoritative bomb appears on given cell,
+	 * adds the round trip sample if the input on this cell is remembered for the character who put this bomb, so bombs of other players are never counted. */
+	static void OnBombVisible(int32 CellIndex, int32 OwnerCharacterID);
+
+	/** Logs the histogram and percentiles of each stage since the last reset. */
+	static void Dump();
+
+	/** Starts measuring from scratch. */
+	static void Reset();
+};
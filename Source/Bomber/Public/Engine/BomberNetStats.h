@@ -0,0 +1,53 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BOMBER_API, BomberNet);
+
+/**
+ * Sources of the network traffic of the game.
+ */
+enum class EBomberNetSource : uint8
+{
+	///< Delta of level actors on the grid, bits are measured by the delta serializer on both sides
+	MapComponentsDelta,
+	///< Explosions of the bomb chain, bits of explosions are measured on the server
+	MulticastDetonateBomb,
+	///< Bomb placing requests, are counted when received by the server
+	ServerSpawnBomb,
+	///< Level size changes sent to all instances
+	MulticastSetLevelSize,
+	///< Powerups of characters, updates are counted when received by clients
+	PlayerPowerups,
+	///< Meshes and skins of characters, updates are counted when received by clients
+	PlayerMeshData,
+	///< End times of countdowns, changes are counted on the server
+	GameStateCountdowns,
+	Num
+};
+
+/**
+ * Counts replicated bits and RPCs of the game by their source, so networking costs could be seen without Network Insights.
+ * Is disabled by default, is enabled by 'Bomber.Net.Profiling 1'.
+ * Each counted event is recorded as CSV stat of the BomberNet category, totals are printed by 'Bomber.Net.DumpStats' and reset by 'Bomber.Net.ResetStats'.
+ */
+struct BOMBER_API FBomberNetStats
+{
+	/** Returns true if the network traffic is counted. */
+	static bool IsEnabled();
+
+	/** Counts one event of given source and its bits if they are known. */
+	static void Add(EBomberNetSource Source, int64 Bits = 0);
+
+	/** Logs the number of events and bytes of each source since the last reset. */
+	static void Dump();
+
+	/** Starts counting from scratch. */
+	static void Reset();
+};
+
+/** Is written wherever the replicated data of the game is sent or received. */
+#define BOMBER_NET_STAT(Source, Bits) \
+	do { if (FBomberNetStats::IsEnabled()) { FBomberNetStats::Add(EBomberNetSource::Source, Bits); } } while (0)
@@ -0,0 +1,67 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+/** Budgets are checked in all builds except shipping, where their scopes are compiled out. */
+#define WITH_BOMBER_PERF_BUDGETS !UE_BUILD_SHIPPING
+
+/**
+ * Critical functions of the game that are checked against their time budgets.
+ */
+enum class EBomberPerfBudget : uint8
+{
+	///< Cells around the cell by the pathfinder, is the most frequent grid query
+	GetSidesCells,
+	///< Blast cells of the bomb
+	GetExplosionCells,
+	///< Regeneration of all level actors on the Generated Map
+	GenerateLevelActors,
+	///< One update of the bot
+	UpdateAI,
+	///< Applying the replicated map components on clients
+	OnRepMapComponents,
+	///< Resolving and applying the whole chain reaction of the bomb
+	DetonateBomb,
+	Num
+};
+
+#if WITH_BOMBER_PERF_BUDGETS
+/**
+ * Compares the time of critical functions against their budgets and logs the warning with the level context once the budget is exceeded,
+ * so regressions are caught during usual playtests without watching profilers.
+ * Budgets are set in milliseconds by 'Bomber.Budget.[Function]Ms' console variables, all checks are disabled by 'Bomber.Budget.Enabled 0'.
+ * The warning of the same function is logged at most once per second, the number of skipped warnings is added to the next one.
+ */
+struct BOMBER_API FBomberPerfBudget
+{
+	/** Measures the scope where it is created and checks its time against the budget of given function. */
+	struct BOMBER_API FScope
+	{
+		explicit FScope(EBomberPerfBudget InBudget);
+		~FScope();
+
+	private:
+		EBomberPerfBudget Budget = EBomberPerfBudget::Num;
+		uint64 StartCycles = 0;
+	};
+
+	/** Returns true if budgets are checked. */
+	static bool IsEnabled();
+
+	/** Returns the budget of given function in milliseconds, 0 if the function is not checked. */
+	static float GetBudgetMs(EBomberPerfBudget Budget);
+
+	/** Returns the total time in milliseconds and the number of calls of given function measured since the launch.
+	 * Is counted while budgets are checked, is used by the performance overlay to show live numbers. */
+	static void GetTotals(EBomberPerfBudget Budget, double& OutTotalMs, uint64& OutCallsNum);
+
+	/** Logs the warning about exceeded budget of given function with the map size and the number of level actors. */
+	static void OnBudgetExceeded(EBomberPerfBudget Budget, double ElapsedMs);
+};
+
+/** Is written at the beginning of the critical function to check its time against the budget. */
+#define BOMBER_PERF_BUDGET_SCOPE(Budget) \
+	const FBomberPerfBudget::FScope BomberPerfBudgetScope(EBomberPerfBudget::Budget)
+#else
+#define BOMBER_PERF_BUDGET_SCOPE(Budget)
+#endif // WITH_BOMBER_PERF_BUDGETS
@@ -0,0 +1,83 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+/**
+ * Types of gameplay events that are written by the telemetry.
+ */
+enum class EBomberTelemetryEvent : uint8
+{
+	None,
+	///< Subject is the character ID of the owner, Data is the fire radius.
+	BombPlaced,
+	///< Subject is the number of bombs in the chain reaction, Data is the number of explosions.
+	BombDetonated,
+	///< Subject is the character ID of the player, Data is the character ID of the killer if known.
+	PlayerDied,
+	///< Subject is the character ID of the player, Data is the item type.
+	ItemPickedUp,
+	///< Subject is the character ID of the bot, Data is the cell index to move, Value is the decision time in milliseconds.
+	AIDecision,
+	///< Name is the measured step, Value is its time in milliseconds.
+	StepTiming
+};
+
+/**
+ * One gameplay event of the telemetry, is small enough to be copied into the preallocated slot of the queue.
+ */
+struct BOMBER_API FBomberTelemetryEvent
+{
+	/** Seconds since the telemetry was started. */
+	double Time = 0.0;
+
+	/** Name of the measured step, is set only for timings. */
+	FName Name = NAME_None;
+
+	/** Row-major index of the cell on the grid where the event happened, INDEX_NONE if the event is not bound to a cell. */
+	int32 CellIndex = INDEX_NONE;
+
+	/** Meaning depends on the event type, @see EBomberTelemetryEvent. */
+	int32 Subject = INDEX_NONE;
+	int32 Data = INDEX_NONE;
+	float Value = 0.f;
+
+	EBomberTelemetryEvent Type = EBomberTelemetryEvent::None;
+};
+
+/**
+ * Writes gameplay telemetry to a file without touching the frame time, so it could be enabled in production for balancing and performance dashboards.
+ * Events are pushed from any thread into the preallocated lock-free ring buffer and are written by the background thread with buffered file writes.
+ * Pushing never allocates, events are dropped if the buffer is full until the next write.
+ * Is enabled by 'Bomber.Telemetry.Enabled 1' or by the -BomberTelemetry argument, e.g:
+ * BomberServer.exe -BomberTelemetry=D:/Telemetry.jsonl
+ * - Bomber.Telemetry.Format: 0 (JSON lines) OR 1 (compact binary records).
+ * Files are saved to the Saved/Telemetry folder if the path is not specified.
+ */
+struct BOMBER_API FBomberTelemetry
+{
+	/** Starts the writer if enabled, is called when the module is loaded. */
+	static void Initialize();
+
+	/** Stops the writer and flushes all queued events. */
+	static void Deinitialize();
+
+	/** Returns true while events are written, is cheap to check before preparing the event. */
+	static bool IsEnabled();
+
+	/** Pushes the event into the queue, does nothing if the telemetry is disabled.
+	 * Is thread-safe, the writer is stopped only once all producers that are pushing right now are finished. */
+	static void RecordEvent(EBomberTelemetryEvent Type, int32 CellIndex = INDEX_NONE, int32 Subject = INDEX_NONE, int32 Data = INDEX_NONE, float Value = 0.f);
+
+	/** Pushes the time of given step into the queue in milliseconds, does nothing if the telemetry is disabled. */
+	static void RecordStepTiming(FName Step, double Seconds);
+
+protected:
+	/** Creates the file and the background thread that writes queued events. */
+	static void StartWriter();
+
+	/** Stops the background thread, remaining events are written before the file is closed. */
+	static void StopWriter();
+
+	/** Starts or stops the writer once 'Bomber.Telemetry.Enabled' is changed. */
+	static void OnEnabledChanged(class IConsoleVariable* ConsoleVariable);
+};
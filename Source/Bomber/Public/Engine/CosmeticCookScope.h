@@ -0,0 +1,38 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Templates/Function.h"
+
+/**
+ * Clears references to cosmetic assets while the object is saved into the package cooked for the dedicated server, restores them on destruction.
+ * So VFX, sounds, widgets and props referenced only by cosmetic properties are neither cooked into server builds nor loaded by the server.
+ * Properties to strip are marked by the 'CosmeticOnly' metadata, so the scope is the only place that knows how to strip them:
+ * UPROPERTY(EditDefaultsOnly, meta = (CosmeticOnly))
+ * Is created on the stack in the Serialize() override before calling Super::Serialize().
+ * References that are replicated to clients, like meshes of level actors, must never be stripped.
+ */
+struct BOMBER_API FCosmeticCookScope
+{
+	/** The metadata of properties that are stripped. */
+	static const FName CosmeticOnlyMetaName;
+
+	/** Strips all 'CosmeticOnly' properties of given object if given archive cooks for the dedicated server. */
+	FCosmeticCookScope(const FArchive& Ar, UObject& Object);
+
+	/** Restores all stripped references. */
+	~FCosmeticCookScope();
+
+	/** Returns true if given archive saves the package cooked for the server-only platform. */
+	static bool IsCookingForServer(const FArchive& Ar);
+
+protected:
+	/** Clears all 'CosmeticOnly' properties of given object until this scope is destroyed. */
+	void StripCosmeticProperties(UObject& Object);
+
+	/** Is true if the archive cooks for the server, so references are stripped. */
+	bool bIsCookingForServer = false;
+
+	/** Functions that return stripped references back. */
+	TArray<TFunction<void()>> Restores;
+};
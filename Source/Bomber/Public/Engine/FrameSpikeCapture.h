@@ -0,0 +1,40 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+/**
+ * Starts a short Insights trace to a file when a frame spike is likely or has just happened, so rare spikes could be studied without reproducing them by hand.
+ * Is triggered by any of next console variables, all of them are disabled by default:
+ * - Bomber.SpikeCapture.FrameMs: the frame time above which the next frames are traced.
+ * - Bomber.SpikeCapture.ChainBombs: the number of bombs in a chain reaction from which its explosions are traced.
+ * - Bomber.SpikeCapture.Regeneration: traces each regeneration of level actors.
+ * Traces are saved to the Profiling/SpikeCapture folder, the file name contains the trigger and the generation seed of the match.
+ * If a trace is already running, only a bookmark is added to it.
+ */
+struct BOMBER_API FFrameSpikeCapture
+{
+	/** Starts watching frame times, is called when the module is loaded. */
+	static void Initialize();
+
+	/** Stops watching frame times and stops the running capture. */
+	static void Deinitialize();
+
+	/** Is called by bombs right before explosions of the chain reaction are applied. */
+	static void OnChainReaction(const UObject* WorldContextObject, int32 BombsNum);
+
+	/** Is called by the Generated Map right before level actors are regenerated. */
+	static void OnRegeneration(const UObject* WorldContextObject);
+
+	/** Returns true while the trace is written by this capture. */
+	static bool IsCapturing();
+
+protected:
+	/** Starts the trace or adds the bookmark if it is already running. */
+	static void StartCapture(const TCHAR* Reason);
+
+	/** Stops the trace started by this capture. */
+	static bool StopCapture(float DeltaTime);
+
+	/** Triggers the capture once the frame time goes over the threshold. */
+	static bool OnFrameTick(float DeltaTime);
+};
@@ -0,0 +1,146 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "ReplicationGraph.h"
+//---
+#include "MyReplicationGraph.generated.h"
+
+class UMapComponent;
+
+/**
+ * Replicates level actors by regions of cells on the Generated Map around each viewer, each region is one chunk of the grid, @see FGridChunks.
+ * Regions near the viewer are replicated each frame, farther ones less often, so large levels do not cost the bandwidth of their whole area.
+ * Level actors are bucketed by the cell of their Map Component, they are rebucketed when moved or taken from the pool.
+ * Actors that are not placed on the level yet (e.g. inactive in pools) are not replicated at all.
+ * Dormant level actors like walls stay in their region lists, the graph skips them per connection until they are flushed.
+ */
+UCLASS()
+class BOMBER_API UMyReplicationGraphNode_LevelGrid final : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	/** Sets default values for this node's properties. */
+	UMyReplicationGraphNode_LevelGrid();
+
+	/** The number of regions around the viewer's region that are replicated each frame, if negative, all regions are. */
+	int32 RegionViewRadius = 2;
+
+	/** The number of regions around the viewer's region that are replicated once per 'Far Region Replication Period' frames beyond the view radius.
+	 * If negative, all other regions are replicated less often, if not greater than the view radius, other regions are not relevant at all. */
+	int32 FarRegionViewRadius = -1;
+
+	/** Far regions are replicated once per this number of replication frames.
+	 * Should be less than the actor channel frame timeout of class settings, so channels of far actors are not closed between their frames. */
+	int32 FarRegionReplicationPeriod = 3;
+
+	/*********************************************************************************************
+	 * UReplicationGraphNode implementation
+	 ********************************************************************************************* */
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+protected:
+	/** Is stored for each added level actor to find its region. */
+	struct FLevelGridActor
+	{
+		TWeakObjectPtr<const UMapComponent> MapComponent = nullptr;
+		int32 CellIndex = INDEX_NONE;
+	};
+
+	/** All added level actors with their last known cells. */
+	TMap<FActorRepListType, FLevelGridActor> LevelActorsInternal;
+
+	/** Level actors by their regions of cells. */
+	TMap<FIntPoint, FActorRepListRefView> RegionsInternal;
+
+	/** Returns the region of specified cell index on the grid, or INDEX_NONE point if the cell is not on the grid. */
+	FIntPoint GetRegionByCellIndex(int32 CellIndex) const;
+
+	/** Version of map components of the Generated Map by which actors were rebucketed last time.
+	 * Level actors change their cells only by being added, removed or moved on the level, so nothing is checked while it is the same. */
+	uint32 MapComponentsVersionInternal = MAX_uint32;
+
+	/** Moves given actor from the region of its previous cell into the region of new cell. */
+	void MoveActorToCell(FActorRepListType Actor, FLevelGridActor& InOutLevelActor, int32 NewCellIndex);
+};
+
+/**
+ * Replicates actors that are relevant only to their owners to the owning connection only.
+ * The owning connection is taken from each actor on gathering, since the owner could be set or changed after the actor is added.
+ * Player controllers and their view targets are not added, they are gathered by UReplicationGraphNode_AlwaysRelevant_ForConnection.
+ */
+UCLASS()
+class BOMBER_API UMyReplicationGraphNode_OwnerOnly final : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	/*********************************************************************************************
+	 * UReplicationGraphNode implementation
+	 ********************************************************************************************* */
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+protected:
+	/** All added owner only actors. */
+	TArray<FActorRepListType> ActorsInternal;
+
+	/** Gathered actors of each connection, are rebuilt on each gathering. */
+	TMap<TObjectKey<UNetConnection>, FActorRepListRefView> ConnectionListsInternal;
+};
+
+/**
+ * Replication graph of the Bomber, is used instead of relevancy checks of each actor for each connection.
+ * - Level actors are replicated by regions of the Generated Map around viewers, unless they are always relevant.
+ * - The Generated Map, players and other always relevant actors are replicated to all connections.
+ * - Actors that are relevant only to their owners are replicated only to the owning connection.
+ * - Each replicated class keeps its own update frequency, each actor takes the one it has on adding.
+ * Is created by the Bomber module for each net driver if enabled by the 'Bomber.Net.ReplicationGraph' console variable, is disabled by default.
+ */
+UCLASS(Transient)
+class BOMBER_API UMyReplicationGraph final : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns true if the replication graph should be used by net drivers. */
+	static bool IsReplicationGraphEnabled();
+
+	/*********************************************************************************************
+	 * UReplicationGraph implementation
+	 ********************************************************************************************* */
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+protected:
+	/** Replicates level actors by regions of cells. */
+	UPROPERTY(Transient)
+	TObjectPtr<UMyReplicationGraphNode_LevelGrid> LevelGridNodeInternal = nullptr;
+
+	/** Replicates always relevant actors to all connections. */
+	UPROPERTY(Transient)
+	TObjectPtr<class UReplicationGraphNode_ActorList> AlwaysRelevantNodeInternal = nullptr;
+
+	/** Replicates owner only actors to their owning connections. */
+	UPROPERTY(Transient)
+	TObjectPtr<UMyReplicationGraphNode_OwnerOnly> OwnerOnlyNodeInternal = nullptr;
+
+	/** Returns true if given actor is a level actor that is replicated by its cell. */
+	static bool IsLevelGridActor(const AActor* Actor);
+
+	/** Returns true if given actor is gathered by the per connection node of its owner. */
+	static bool IsConnectionActor(const AActor* Actor);
+};
@@ -0,0 +1,48 @@
+﻿// Copyright (c) Yevhenii Selivanov.
+
+#pragma once
+
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BOMBER_API, BomberStartup);
+
+/**
+ * Measures the time of the startup phases: module load, data assets loading, map generation, game features activation and widgets creation.
+ * Each phase is visible in Unreal Insights and in CSV profiles, the summary is printed to the log once the Menu state is reached.
+ * Is recorded on the game thread only and stops recording after the summary is printed, so it costs nothing during the match.
+ */
+struct BOMBER_API FStartupTimings
+{
+	/** Measures the scope where it is created and adds its time to the specified phase. */
+	struct BOMBER_API FScope
+	{
+		explicit FScope(FName InPhase);
+		~FScope();
+
+	private:
+		FName Phase = NAME_None;
+		double StartSeconds = 0.0;
+	};
+
+	/** Adds the time to the specified phase, the same phase can be measured multiple times. */
+	static void AddPhaseSeconds(FName Phase, double Seconds);
+
+	/** Starts measuring the phase that ends asynchronously, e.g: map loading or game features activation. */
+	static void BeginPhase(FName Phase);
+
+	/** Finishes measuring the phase started by BeginPhase, does nothing if it was not started. */
+	static void EndPhase(FName Phase);
+
+	/** Prints all measured phases and the total time since the launch, does it only once. */
+	static void PrintSummary();
+
+	/** Returns true while the startup is measured, false after the summary is printed. */
+	static bool IsRecording();
+};
+
+/** Is used to measure the startup phase by the scope it is written in. */
+#define STARTUP_TIMING_SCOPE(Phase) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Bomber_Startup_##Phase); \
+	CSV_SCOPED_TIMING_STAT(BomberStartup, Phase); \
+	const FStartupTimings::FScope StartupTimingScope_##Phase(TEXT(#Phase))
@@ -94,6 +94,11 @@ public:
 	 *		Debug
 	 * --------------------------------------------------- */
 
+	/** Shows or hides the live performance overlay on the HUD, its numbers are refreshed by 'Bomber.UI.PerfOverlayInterval'.
+	 * Bomber.Debug.PerfOverlay 1 - show the overlay. */
+	UFUNCTION(meta = (CheatName = "Bomber.Debug.PerfOverlay"))
+	static void SetPerfOverlayEnabled(bool bShouldEnable);
+
 	/**
 	 * Shows coordinates of all level actors by specified types, ex: 'Box Item'.
 	 * Bomber.Debug.DisplayCells Wall - show walls.
@@ -115,6 +120,52 @@ public:
 	UFUNCTION(meta = (CheatName = "Bomber.Level.SetSize"))
 	static void SetLevelSize(const FString& LevelSize);
 
+	/** Writes current layout of the level to the file, the name without a path is saved to the Saved/Levels folder.
+	 * Bomber.Level.Export MyLevel - save the layout to Saved/Levels/MyLevel.bomberlayout. */
+	UFUNCTION(meta = (CheatName = "Bomber.Level.Export"))
+	static void ExportLevel(const FString& FilePath);
+
+	/** Spawns the level from the layout file without any generation, the name without a path is read from the Saved/Levels folder.
+	 * Bomber.Level.Import MyLevel - load the layout from Saved/Levels/MyLevel.bomberlayout. */
+	UFUNCTION(meta = (CheatName = "Bomber.Level.Import"))
+	static void ImportLevel(const FString& FilePath);
+
+	/* ---------------------------------------------------
+	 *		Match
+	 * --------------------------------------------------- */
+
+	/** Restores the running match from its last checkpoint that is captured by the server every few seconds.
+	 * Bomber.Match.Restore - restore the match to test crash recovery or an instant rematch on the same board. */
+	UFUNCTION(meta = (CheatName = "Bomber.Match.Restore"))
+	static void RestoreMatch();
+
+	/* ---------------------------------------------------
+	 *		Stress
+	 * --------------------------------------------------- */
+
+	/** Spawns given number of bombs on random free cells to reproduce the worst-case load, prints the time of requests to the log.
+	 * Bomber.Stress.SpawnBombs 30 - spawn 30 bombs. */
+	UFUNCTION(meta = (CheatName = "Bomber.Stress.SpawnBombs"))
+	static void SpawnBombs(int32 BombsNum);
+
+	/** Sets the maximum level of each powerup for all bots, prints the time to the log. */
+	UFUNCTION(meta = (CheatName = "Bomber.Stress.MaxBotsPowerups"))
+	static void MaxBotsPowerups();
+
+	/** Spawns boxes on all free cells of the level, prints the time of requests to the log. */
+	UFUNCTION(meta = (CheatName = "Bomber.Stress.FillBoxes"))
+	static void FillBoxes();
+
+	/** Detonates all bombs on the level at once to trigger the map-wide chain reaction, prints the time to the log.
+	 * Is better to be called after Bomber.Stress.SpawnBombs. */
+	UFUNCTION(meta = (CheatName = "Bomber.Stress.ChainReaction"))
+	static void ChainReaction();
+
+	/** Regenerates the level given number of times in a row, prints min, average and max time of regenerations to the log.
+	 * Bomber.Stress.Regenerate 10 - regenerate the level 10 times. */
+	UFUNCTION(meta = (CheatName = "Bomber.Stress.Regenerate"))
+	static void Regenerate(int32 Times);
+
 	/* ---------------------------------------------------
 	 *		Camera
 	 * --------------------------------------------------- */
@@ -24,7 +24,8 @@ public:
 
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGameStateChanged, ECurrentGameState, CurrentGameState);
 
-	/** Called when the current game state was changed. */
+	/** Called when the current game state was changed.
+	 * Is broadcast after native listeners, see AMyGameStateBase::AddGameStateListener(). */
 	UPROPERTY(BlueprintCallable, BlueprintAssignable, Category = "C++")
 	FOnGameStateChanged OnGameStateChanged;
 
@@ -38,6 +39,15 @@ public:
 	/** Returns the current game state, it will crash if can't be obtained, should be used only when the game is running. */
 	static AMyGameStateBase& Get();
 	
+	/** Adds code listener of game state changes, is notified without reflection before OnGameStateChanged delegate.
+	 * Listeners are grouped by their class, so e.g. all boxes are notified in one loop, including ones that are inactive in the Pool Manager.
+	 * There is no need to remove it, since destroyed listeners are dropped on the next change, adding the same listener twice does nothing.
+	 * @param Listener The object to notify.
+	 * @param Callback The function of the listener to call, all listeners of the same class share the callback of the first added one,
+	 * so each class has to always pass the same function, it is checked in debug builds. */
+	template <typename T>
+	void AddGameStateListener(T* Listener, void (T::*Callback)(ECurrentGameState));
+
 	/** Set the new game state for the current game. */
 	UFUNCTION(BlueprintCallable, Server, Reliable, Category = "C++")
 	void ServerSetGameState(ECurrentGameState NewGameState);
@@ -54,26 +64,45 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	int32 GetPlayersInMultiplayerNum() const { return PlayerArray.Num(); }
 
-	/** Returns the left second of the 'Three-two-one-GO' timer. */
+	/** Returns the left second of the 'Three-two-one-GO' timer, is computed locally from the replicated end time. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	FORCEINLINE float GetStartingTimerSecondsRemain() const { return StartingTimerSecRemainInternal; }
+	float GetStartingTimerSecondsRemain() const;
 
-	/** Returns the left second to the end of the match. */
+	/** Returns the left second to the end of the match, is computed locally from the replicated end time. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	FORCEINLINE float GetInGameTimerSecondsRemain() const { return InGameTimerSecRemainInternal; }
+	float GetInGameTimerSecondsRemain() const;
+
+	/** Moves the end of the match, so given seconds remain, e.g: on restoring the match snapshot. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void SetInGameTimerSecondsRemain(float SecondsRemain);
 
 	/** Returns true if 'Three-two-one-GO' timer was already finished, so the match was started. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	FORCEINLINE bool IsStartingTimerElapsed() const { return FMath::IsNearlyZero(StartingTimerSecRemainInternal) || StartingTimerSecRemainInternal < 0.f; }
+	FORCEINLINE bool IsStartingTimerElapsed() const { return FMath::IsNearlyZero(GetStartingTimerSecondsRemain()); }
 
 	/** Returns true if there are no seconds remain to the end of the match, so the match was ended. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	FORCEINLINE bool IsInGameTimerElapsed() const { return FMath::IsNearlyZero(InGameTimerSecRemainInternal) || InGameTimerSecRemainInternal < 0.f; }
+	FORCEINLINE bool IsInGameTimerElapsed() const { return FMath::IsNearlyZero(GetInGameTimerSecondsRemain()); }
 
 	/** Returns true if there request to update the End-Game state for players. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE bool DoesWantUpdateEndState() const { return bWantsUpdateEndStateInternal; }
 
+	/** Throttles the dedicated server while it is idle: in the Menu or EndGame state or without connected players.
+	 * Lowers the server tick rate by 'Bomber.Server.IdleTickRate', pauses the grid simulation with bots and stops ticking of level actors.
+	 * Everything is restored right away once the server is not idle anymore, e.g: on GameStarting or when a player connects.
+	 * Is called on game state changes and by the game mode on players login and logout. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void UpdateServerIdleState();
+
+	/** Returns true if the dedicated server is throttled as idle. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsServerIdle() const { return bIsServerIdleInternal; }
+
+	/** Stops ticking of given level actor while the server is idle, it is restored with others once the server is not idle anymore.
+	 * Is called for all level actors on becoming idle and by the Generated Map for level actors that are added to the grid while idle. */
+	void PauseTickWhileIdle(AActor& LevelActor);
+
 protected:
 	/* ---------------------------------------------------
 	*		Protected properties
@@ -87,13 +116,42 @@ protected:
 	UPROPERTY(BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Countdown Timer"))
 	FTimerHandle CountdownTimerInternal;
 
-	/** The summary seconds of launching 'Three-two-one-GO' timer that is used on game starting. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Transient, Replicated, meta = (BlueprintProtected, DisplayName = "Starting Timer Seconds Remain"))
-	float StartingTimerSecRemainInternal = 0.F;
+	/** The server world time when 'Three-two-one-GO' timer ends, is replicated once per game starting, 0 if not started. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Replicated, meta = (BlueprintProtected, DisplayName = "Starting Timer End Time"))
+	double StartingTimerEndTimeInternal = 0.0;
+
+	/** The server world time when the round ends, is replicated once per match, 0 if not started. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Replicated, meta = (BlueprintProtected, DisplayName = "In-Game Timer End Time"))
+	double InGameTimerEndTimeInternal = 0.0;
+
+	/** Code listeners of the same class that share the same callback. */
+	struct FGameStateListenersBucket
+	{
+		const UClass* ListenerClass = nullptr;
+		TFunction<void(UObject&, ECurrentGameState)> Callback = nullptr;
+		TArray<TWeakObjectPtr<UObject>> Listeners;
+
+		/** The same listeners to add each one in constant time only once. */
+		TSet<TWeakObjectPtr<UObject>> ListenerKeys;
+
+#if DO_CHECK
+		/** The address of the member callback, to check that the class always passes the same one. */
+		TArray<uint8, TInlineAllocator<16>> CallbackBytes;
+#endif
+	};
 
-	/** Seconds to the end of the round. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Transient, Replicated, meta = (BlueprintProtected, DisplayName = "In-Game Timer Seconds Remain"))
-	float InGameTimerSecRemainInternal = 0.F;
+	/** Code listeners of game state changes grouped by their class, see AMyGameStateBase::AddGameStateListener(). */
+	TArray<FGameStateListenersBucket> GameStateListenersInternal;
+
+	/** Is true while the dedicated server is throttled as idle, @see AMyGameStateBase::UpdateServerIdleState. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Server Idle"))
+	bool bIsServerIdleInternal = false;
+
+	/** The max tick rate of the server before it became idle, is restored once the server is not idle anymore. */
+	int32 ServerMaxTickRateInternal = 0;
+
+	/** Level actors whose ticking was stopped while the server is idle, only actors that were ticking are kept to be restored. */
+	TArray<TWeakObjectPtr<AActor>> IdlePausedActorsInternal;
 
 	/** Is true where there request to update the End-Game state for players */
 	UPROPERTY(BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Wants Update End State"))
@@ -116,6 +174,12 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void ApplyGameState();
 
+	/** Returns the bucket of code listeners of specified class, creates it on first request. */
+	FGameStateListenersBucket& FindOrAddGameStateListenersBucket(const UClass* ListenerClass);
+
+	/** Notifies all code listeners about the current game state, is called before OnGameStateChanged delegate. */
+	void BroadcastGameStateListeners();
+
 	/** Called on the AMyGameStateBase::CurrentGameState property updating. */
 	UFUNCTION()
 	void OnRep_CurrentGameState();
@@ -128,6 +192,10 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void OnCountdownTimerTicked();
 
+	/** Sets the end time of the match countdown once the In-Game state is started. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++", meta = (BlueprintProtected))
+	void StartInGameCountdown();
+
 	/** Is called during the Game Starting state to handle the 'Three-two-one-GO' timer. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void DecrementStartingCountdown();
@@ -149,3 +217,34 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void SetGameFeaturesEnabled(bool bEnable);
 };
+
+template <typename T>
+void AMyGameStateBase::AddGameStateListener(T* Listener, void (T::*Callback)(ECurrentGameState))
+{
+	if (!ensureMsgf(Listener && Callback, TEXT("ASSERT: [%i] %s:\n'Listener' or 'Callback' is null!"), __LINE__, *FString(__FUNCTION__)))
+	{
+		return;
+	}
+
+	FGameStateListenersBucket& Bucket = FindOrAddGameStateListenersBucket(T::StaticClass());
+	if (!Bucket.Callback)
+	{
+		Bucket.Callback = [Callback](UObject& ListenerIt, ECurrentGameState CurrentGameState)
+		{
+			(static_cast<T&>(ListenerIt).*Callback)(CurrentGameState);
+		};
+#if DO_CHECK
+		Bucket.CallbackBytes.Append(reinterpret_cast<const uint8*>(&Callback), sizeof(Callback));
+#endif
+	}
+
+	checkf(Bucket.CallbackBytes.Num() == sizeof(Callback) && !FMemory::Memcmp(Bucket.CallbackBytes.GetData(), &Callback, sizeof(Callback)),
+	       TEXT("ERROR: [%i] %s:\n'%s' listeners have to share the same callback!"), __LINE__, *FString(__FUNCTION__), *GetNameSafe(T::StaticClass()));
+
+	bool bIsAlreadyAdded = false;
+	Bucket.ListenerKeys.Add(Listener, &bIsAlreadyAdded);
+	if (!bIsAlreadyAdded)
+	{
+		Bucket.Listeners.Emplace(Listener);
+	}
+}
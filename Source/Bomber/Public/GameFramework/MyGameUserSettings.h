@@ -4,8 +4,27 @@
 
 #include "GameFramework/GameUserSettings.h"
 //---
+#include "Containers/Ticker.h"
+//---
 #include "MyGameUserSettings.generated.h"
 
+/**
+ * Presets of the internal resolution that is upscaled by TSR to the screen resolution.
+ * Is the upper bound of the dynamic resolution when it is enabled.
+ */
+UENUM(BlueprintType)
+enum class EUpscalerMode : uint8
+{
+	///< Renders at the screen resolution, TSR is used for anti-aliasing only
+	Native,
+	///< Renders at 67% of the screen resolution
+	Quality,
+	///< Renders at 58% of the screen resolution
+	Balanced,
+	///< Renders at 50% of the screen resolution
+	Performance
+};
+
 /**
  * The Bomber settings.
  */
@@ -37,6 +56,16 @@ public:
 	/** Mark current video mode settings (fullscreenmode/resolution) as being confirmed by the user. */
 	virtual void ConfirmVideoMode() override;
 
+	/** Saves settings once no other change is requested during the quiet period, so dragged sliders don't write config every frame.
+	 * @param ConfigObject Optional object with config properties to be saved together with settings, e.g: sounds subsystem.
+	 * @see Bomber.Settings.SaveDelay */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (AdvancedDisplay = "ConfigObject"))
+	void RequestSaveSettings(UObject* ConfigObject = nullptr);
+
+	/** Saves requested settings right away if the quiet period is not finished yet. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void FlushPendingSave();
+
 	/** Returns the min allowed resolution width. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE int32 GetMinResolutionSizeX() const { return MinResolutionSizeXInternal; }
@@ -45,25 +74,32 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE int32 GetMinResolutionSizeY() const { return MinResolutionSizeYInternal; }
 
-	/** Get all supported resolutions of the primary monitor in the text format. */
-	UFUNCTION(BlueprintPure, Category = "C++")
-	void GetTextResolutions(TArray<FText>& OutTextResolutions) const { OutTextResolutions = TextResolutionsInternal; }
+	/** Get all supported resolutions of the primary monitor in the text format, are enumerated on first request.
+	 * Is not pure since the enumeration changes the state of settings. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void GetTextResolutions(TArray<FText>& OutTextResolutions);
 
-	/** Get all supported resolutions of the primary monitor in the int point format.. */
-	UFUNCTION(BlueprintPure, Category = "C++")
-	void GetIntResolutions(TArray<FIntPoint>& OutIntResolutions) const { OutIntResolutions = IntResolutionsInternal; }
+	/** Get all supported resolutions of the primary monitor in the int point format, are enumerated on first request.
+	 * Is not pure since the enumeration changes the state of settings. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void GetIntResolutions(TArray<FIntPoint>& OutIntResolutions);
 
 	/** Call to update supported resolutions in arrays. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void UpdateSupportedResolutions();
 
+	/** Enumerates supported resolutions only if it was not done before, is not called on startup since it's needed only by settings. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void TryUpdateSupportedResolutions();
+
 	/** Set and apply a new resolution by index. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void SetResolutionByIndex(int32 Index);
 
-	/** Returns the index of chosen resolution*/
-	UFUNCTION(BlueprintPure, Category = "C++")
-	FORCEINLINE int32 GetResolutionIndex() const { return CurrentResolutionIndexInternal; }
+	/** Returns the index of chosen resolution, resolutions are enumerated on first request.
+	 * Is not pure since the enumeration changes the state of settings. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	int32 GetResolutionIndex();
 
 	/** Returns true if the game is in fullscreen mode. */
 	UFUNCTION(BlueprintPure, Category = "C++")
@@ -85,6 +121,61 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void SetFPSLockByIndex(int32 Index);
 
+	/** Returns the frame rate of the FPS lock by specified member index, 0 means uncapped, INDEX_NONE if the member is unknown, e.g: settings widget is not created yet. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	int32 GetFPSLockByIndex(int32 Index) const;
+
+	/** Returns true if the overall quality and FPS lock are tuned automatically by measured frame time.
+	 * @see UMyGameUserSettings::bAutoScalabilityInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsAutoScalabilityEnabled() const { return bAutoScalabilityInternal; }
+
+	/** Set true to tune the overall quality and FPS lock automatically to hold the target frame rate. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void SetAutoScalabilityEnabled(bool bIsEnabled);
+
+	/** Starts measuring frame times from scratch, is called on match start, so the first window is sampled right away and then periodically. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void RestartAutoScalability();
+
+	/** Stops measuring frame times until the next restart, is called when the match is over, the tuned quality and FPS lock are kept. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void StopAutoScalability();
+
+	/** Applies all settings besides resolution ones, the upscaler and dynamic resolution are applied after the scalability. */
+	virtual void ApplyNonResolutionSettings() override;
+
+	/** Returns the index of chosen upscaler mode, is the same as the index of combobox member.
+	 * @see UMyGameUserSettings::UpscalerModeInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetUpscalerModeIndex() const { return static_cast<int32>(UpscalerModeInternal); }
+
+	/** Set and apply the upscaler mode by its index. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void SetUpscalerModeByIndex(int32 Index);
+
+	/** Returns the frame time in milliseconds the dynamic resolution tries to hold.
+	 * @see UMyGameUserSettings::DynamicResolutionFrameBudgetMsInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetDynamicResolutionFrameBudgetMs() const { return DynamicResolutionFrameBudgetMsInternal; }
+
+	/** Set and apply the frame time in milliseconds the dynamic resolution tries to hold, e.g: 16.6 for 60 FPS. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void SetDynamicResolutionFrameBudgetMs(float InFrameBudgetMs);
+
+	/** Set and apply the dynamic resolution that drops the internal resolution while frames are slower than the budget, e.g: during chain reactions. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void SetDynamicResolutionEnabledNow(bool bIsEnabled);
+
+	/** Returns true if frames are queued as little as possible to reduce the input latency.
+	 * @see UMyGameUserSettings::bLowLatencyModeInternal */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsLowLatencyModeEnabled() const { return bLowLatencyModeInternal; }
+
+	/** Set true to reduce queued frames and pace them slightly below the refresh rate, it costs some frame rate for lower input latency. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void SetLowLatencyModeEnabled(bool bIsEnabled);
+
 protected:
 	/* ---------------------------------------------------
 	 *		Protected properties
@@ -123,10 +214,101 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "FPS Lock Index"))
 	int32 FPSLockIndexInternal;
 
+	/** If true, the overall quality and FPS lock are tuned automatically by measured frame time, the tuned result is saved to config. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Auto Scalability"))
+	bool bAutoScalabilityInternal = false;
+
+	/** The frame rate the auto scalability tries to hold and lock. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Auto Target FPS", ClampMin = "1"))
+	int32 AutoTargetFPSInternal = 60;
+
+	/** The frame rate that is locked if the target one can't be held even on the min quality. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Auto Fallback FPS", ClampMin = "1"))
+	int32 AutoFallbackFPSInternal = 30;
+
+	/** The overall quality bounds the auto scalability moves within, 1:low ... 5:ultra. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Auto Quality Bounds"))
+	FIntPoint AutoQualityBoundsInternal = FIntPoint(1, 5);
+
+	/** The chosen preset of the internal resolution that is upscaled by TSR, is config property. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Upscaler Mode"))
+	EUpscalerMode UpscalerModeInternal = EUpscalerMode::Native;
+
+	/** The frame time in milliseconds the dynamic resolution tries to hold, is config property. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Dynamic Resolution Frame Budget Ms", ClampMin = "4", ClampMax = "100", Units = "ms"))
+	float DynamicResolutionFrameBudgetMsInternal = 16.6f;
+
+	/** The lowest screen percentage the dynamic resolution can drop to, the highest one is set by the upscaler mode. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Dynamic Resolution Min Screen Percentage", ClampMin = "10", ClampMax = "100"))
+	float DynamicResolutionMinScreenPercentageInternal = 50.f;
+
+	/** If true, the game thread waits for the rendering, so no frame is queued ahead, and the frame rate is locked slightly below the refresh rate.
+	 * Vendor latency reduction (like NVIDIA Reflex) is enabled too when its plugin is present. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Low Latency Mode"))
+	bool bLowLatencyModeInternal = false;
+
+	/** The frame rate is locked by this amount below the refresh rate in the low latency mode, so frames never wait in the present queue. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Low Latency FPS Margin", ClampMin = "0"))
+	int32 LowLatencyFPSMarginInternal = 3;
+
+	/** The last frame rate requested to be locked, 0 means uncapped.
+	 * Is saved to config as the frame rate limit, while only the applied console variable is capped by the refresh rate in the low latency mode. */
+	int32 RequestedFrameRateLimitInternal = 0;
+
+	/** Sum of measured frame times in milliseconds in current window. */
+	double AutoSampledFrameMsInternal = 0.0;
+
+	/** Amount of measured frames in current window. */
+	int32 AutoSampledFramesNumInternal = 0;
+
+	/** Seconds passed since current window is started. */
+	float AutoSampleElapsedSecondsInternal = 0.f;
+
+	/** The handle of the per-frame sampling or of the delayed start of the next window, is world-independent since settings live for the whole session.
+	 * Is reset when the match is over, so nothing is ticked outside of the match. */
+	FTSTicker::FDelegateHandle AutoScalabilityTickerHandleInternal;
+
+	/** Objects with config properties requested to be saved with settings.
+	 * @see UMyGameUserSettings::RequestSaveSettings */
+	TArray<TWeakObjectPtr<UObject>> PendingSaveObjectsInternal;
+
+	/** Seconds left until requested settings are saved. */
+	float PendingSaveSecondsInternal = 0.f;
+
+	/** The handle of the deferred saving, is valid while the save is pending. */
+	FTSTicker::FDelegateHandle SaveTickerHandleInternal;
+
 	/* ---------------------------------------------------
 	 *		Protected functions
 	 * --------------------------------------------------- */
 
 	/** Loads the user settings from persistent storage */
 	virtual void LoadSettings(bool bForceReload) override;
+
+	/** Is called every frame while the save is pending to count down the quiet period. */
+	bool OnSaveSettingsTick(float DeltaTime);
+
+	/** Is called every frame during the sampling window to measure frame times, is removed once the window is finished. */
+	bool OnAutoScalabilityTick(float DeltaTime);
+
+	/** Starts the per-frame sampling of the next window from scratch. */
+	void StartAutoScalabilityWindow();
+
+	/** Moves the overall quality or FPS lock by given average frame time of the finished window. */
+	void ApplyAutoScalability(float AverageFrameMs);
+
+	/** Locks the frame rate without changing the chosen FPS lock index, is capped below the refresh rate in the low latency mode. */
+	void ApplyFrameRateLimit(int32 MaxFPS);
+
+	/** Returns given frame rate capped below the refresh rate in the low latency mode, 0 means uncapped. */
+	int32 GetPacedFrameRateLimit(int32 MaxFPS) const;
+
+	/** Applies console variables of the chosen upscaler mode and the dynamic resolution bounds. */
+	void ApplyUpscalerSettings();
+
+	/** Applies render queue console variables of the current low latency mode. */
+	void ApplyLowLatencyMode();
+
+	/** Returns the highest refresh rate of current resolution, 0 if unknown. */
+	int32 GetDisplayRefreshRate() const;
 };
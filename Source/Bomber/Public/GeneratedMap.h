@@ -1,17 +1,110 @@
-// Copyright (c) Yevhenii Selivanov.
+﻿// Copyright (c) Yevhenii Selivanov.
 
 #pragma once
 
 #include "GameFramework/Actor.h"
 //---
 #include "Bomber.h"
+#include "Structures/AIWorldSnapshot.h"
 #include "Structures/Cell.h"
+#include "Structures/CellsBitboard.h"
+#include "Structures/GridChunks.h"
 #include "Structures/MapComponentsContainer.h"
 //---
+#include "Containers/StaticArray.h"
+#include "Tasks/Task.h"
+//---
 #include "GeneratedMap.generated.h"
 
 class UMapComponent;
 
+enum class EGridReplayEventType : uint8;
+
+/**
+ * Cached explosion of the bomb that is registered in the danger map of the Generated Map.
+ * @see AGeneratedMap::UpdateBombDanger
+ */
+struct FBombDanger
+{
+	/** The bomb that is going to explode. */
+	TWeakObjectPtr<const class ABombActor> Bomb = nullptr;
+
+	/** Row-major indices of cells that are going to be exploded by the bomb. */
+	FCellIndices ExplosionCellIndices;
+
+	/** World time in seconds when the bomb is going to explode, MAX_flt if its lifespan is not started yet. */
+	float DetonationTime = MAX_flt;
+};
+
+/**
+ * Cached distances on the grid to the nearest cell with actors of one query, is reused until the level state is changed.
+ * @see AGeneratedMap::GetDistanceMap
+ */
+struct FGridDistanceMap
+{
+	/** Version of the level state the distances were found with. */
+	uint32 StateVersion = 0;
+
+	/** Dense row-major number of steps to the nearest target cell, INDEX_NONE for unreachable cells. */
+	TArray<int32> Distances;
+};
+
+/**
+ * Inputs and result of one level layout generation, is copied on the game thread,
+ * so the layout could be computed on a worker thread without reading any actor or data asset.
+ * @see AGeneratedMap::ComputeLevelLayout
+ */
+struct FLevelLayoutGenerationData
+{
+	/** The scale of the grid the layout is generated for. */
+	FIntVector MapScale = FIntVector::ZeroValue;
+
+	/** Chance of walls, is decreased after each failed attempt. */
+	float WallsChance = 0.f;
+
+	/** Chance of boxes. */
+	int32 BoxesChance = 0;
+
+	/** The budget of random fills before the last attempt is carved. */
+	int32 MaxAttempts = 1;
+
+	/** Remove isolating walls instead of validating and rerolling. */
+	bool bIsConstructive = false;
+
+	/** The number of players the spawns are generated for. */
+	int32 PlayersNum = 0;
+
+	/** Cells of dragged actors, are skipped by the generation. */
+	FCells DraggedCells;
+
+	/** Cells of dragged walls, break the path and can't be removed. */
+	FCells DraggedWalls;
+
+	/** Cells of dragged items, have to be reachable. */
+	FCells DraggedItems;
+
+	/** The generation seed, is applied to the Generated Map when the layout is spawned. */
+	int32 Seed = 0;
+
+	/** The stream the layout is randomized by, is initialized by the generation seed. */
+	FRandomStream RandomStream;
+
+	/** The generated layout. */
+	TMap<FCell, EActorType> ActorsToSpawn;
+
+	/** The number of random fills that were done. */
+	int32 Attempts = 0;
+
+	/** Is false if the budget is exhausted and the last attempt was carved. */
+	bool bFoundPath = false;
+
+	/** The time in seconds that was spent by path checks of all attempts. */
+	float PathCheckTime = 0.f;
+
+	/** The time in seconds that was spent by the computation. */
+	float GenerationTime = 0.f;
+};
+
 /**
  * Procedurally generated grid of cells and actors on the scene.
  * @see Access its data with UGeneratedMapDataAsset (Content/Bomber/DataAssets/DA_Levels).
@@ -45,15 +138,28 @@ public:
 	UPROPERTY(BlueprintCallable, BlueprintAssignable, Category = "C++")
 	FOnGeneratedLevelActors OnGeneratedLevelActors;
 
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGenerationProgressChanged, float, Progress);
+
+	/** Called on server and clients each frame while level actors are spawned, is useful to show the progress of regeneration. */
+	UPROPERTY(BlueprintCallable, BlueprintAssignable, Category = "C++")
+	FOnGenerationProgressChanged OnGenerationProgressChanged;
+
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnAnyPlayerDestroyed);
 
 	/** Called when any player or bot was exploded. */
 	UPROPERTY(BlueprintCallable, BlueprintAssignable, Category = "C++")
 	FOnAnyPlayerDestroyed OnAnyCharacterDestroyed;
 
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnCellActorTypesChanged, int32 /*CellIndex*/, int32 /*ActorTypesBitmask*/);
+
+	/** Called on server and clients when level actors on the cell are changed, e.g. a box was destroyed, its row-major index and new EActorType bitmask are passed.
+	 * Is not called when the whole grid is rebuilt, listen OnGeneratedLevelActors for that. */
+	FOnCellActorTypesChanged OnCellActorTypesChanged;
+
 	/** Contains outside added dangerous cells, is useful for Game Features to notify bots that some cells are not safe.
+	 * Has to be changed by SetAdditionalDangerousCells, so the AI snapshot knows it is outdated.
 	 * @todo JanSeliv 3JBOo7L8 Remove after NewAI implementation. */
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Category = "C++")
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
 	TSet<FCell> AdditionalDangerousCells;
 
 	/* ---------------------------------------------------
@@ -67,6 +173,10 @@ public:
 	 * Is created only once, can not be destroyed and always exist in persistent level. */
 	static AGeneratedMap& Get();
 
+	/** Returns the generated map of the match instance that owns given context object, the primary one if it can't be resolved.
+	 * @see UGeneratedMapSubsystem::GetGeneratedMapByContext */
+	static AGeneratedMap& Get(const UObject* ContextObject);
+
 	/** Initialize this Generated Map actor, could be called multiple times. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void ConstructGeneratedMap(const FTransform& Transform);
@@ -82,10 +192,18 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE ELevelType GetLevelType() const { return LevelTypeInternal; }
 
+	/** Returns the number of alive players and bots on the level, is kept up to date on their spawn and destroy. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetAlivePlayersNum() const { return MapComponentsInternal.GetPlayersNum(); }
+
 	/** Returns the camera component of the level. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE class UMyCameraComponent* GetCameraComponent() const { return CameraComponentInternal; }
 
+	/** Returns the component that draws walls and boxes as instances. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE class UInstancedLevelMeshesComponent* GetInstancedMeshesComponent() const { return InstancedMeshesComponentInternal; }
+
 	/** Spawns a level actor on the Generated Map by the specified type. Then calls AddToGrid().
 	 * @param Type Which type of level actors
 	 * @param Cell Actors location
@@ -93,19 +211,26 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++", meta = (DisplayName = "Spawn Actor by Type", AutoCreateRefTerm = "Cell"))
 	void BPSpawnActorByType(EActorType Type, const FCell& Cell) { SpawnActorByType(Type, Cell, nullptr); }
 
-	/** Code alternative function with OnSpawn callback. */
+	/** Code alternative function with OnSpawn callback.
+	 * If is called while level actors are destroyed in one batch, e.g: items by destroyed boxes, the spawn without callback is collected and requested together with the rest of this batch. */
 	void SpawnActorByType(EActorType Type, const FCell& Cell, const TFunction<void(AActor*)>& OnSpawned = nullptr);
 
-	/** Spawns many level actors at once, used for level generation. */
+	/** Spawns many level actors, used for level generation.
+	 * Walls are spawned first, then boxes, items and players, spawning is spread across frames by UGeneratedMapDataAsset::GetSpawnBudgetMs(). */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
 	void SpawnActorsByTypes(const TMap<FCell, EActorType>& ActorsToSpawn);
 
+	/** Returns the progress of spawning generated level actors from 0 to 1, is 1 when all actors are spawned. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetGenerationProgress() const { return GenerationProgressInternal; }
+
 	/** Adding and attaching the specified Map Component to the Level
 	 * @param AddedComponent The Map Component of the generated or dragged level actor. */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
 	void AddToGrid(UMapComponent* AddedComponent);
 
 	/** Destroy all actors from the level on specified cells.
+	 * Is batched: all found actors are removed from the grid at once and returned to the pool in one call.
 	 * @param Cells The set of cells for destroying the found actors.
 	 * @param DestroyCauser The actor that caused the destruction of the level actor. */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++", meta = (DefaultToSelf = "DestroyCauser"))
@@ -123,6 +248,16 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++", meta = (DefaultToSelf = "DestroyCauser"))
 	void DestroyLevelActorByHandle(const FPoolObjectHandle& Handle, UObject* DestroyCauser = nullptr);
 
+	/** Reports the grid event to all its listeners, so gameplay code reports each event once.
+	 * Is recorded by the replay, spectators and telemetry only on the server, while cosmetics are queued on any machine.
+	 * @param Type The event to report.
+	 * @param Cell The cell where the event happened.
+	 * @param Value The character ID of the player that caused the event, the chain size of detonations or INDEX_NONE.
+	 * @param Param The actor type or the item type the event is about.
+	 * @param Source The object the event is about, e.g: the destroyed actor or the player that picked up the item.
+	 * @param TelemetryData Additional telemetry value, e.g: the fire radius of the placed bomb, the explosions number of detonations or the character ID of the killer. */
+	void DispatchGridEvent(EGridReplayEventType Type, const FCell& Cell, int32 Value = INDEX_NONE, uint8 Param = 0, UObject* Source = nullptr, int32 TelemetryData = INDEX_NONE);
+
 	/** Finds the nearest cell pointer to the specified Map Component
 	 *
 	 * @param MapComponent The component whose owner is being searched
@@ -137,6 +272,12 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
 	void SetLevelType(ELevelType NewLevelType);
 
+	/** Loads the streaming level of given type hidden in background and prestreams meshes of level actors for it,
+	 * so switching to this level type later only toggles visibility instead of loading.
+	 * Could be called by UI to preload the predicted selection, is called for all level types on starting the game. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void PreloadLevelType(ELevelType LevelType);
+
 	/** Returns true if specified map component has non-generated owner that is manually dragged to the scene. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	bool IsDraggedMapComponent(const UMapComponent* MapComponent) const;
@@ -150,6 +291,241 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	static FTransform ActorTransformToGridTransform(const FTransform& ActorTransform);
 
+	/** Returns the cached transform of the grid, where location is the average of all cells, rotation is the grid rotation and scale-X/Y are the number of columns/rows.
+	 * Is updated only when the grid is rebuilt, so it is cheap to call it at any moment. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FTransform& GetGridTransform() const { return GridTransformInternal; }
+
+	/** Returns the number of columns (X) and rows (Y) of the grid. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FIntPoint& GetGridSize() const { return GridSizeInternal; }
+
+	/** Returns the center cell of the grid. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FCell& GetGridCenterCell() const { return GridCenterCellInternal; }
+
+	/** Returns the row-major index (Row * Columns + Column) of given cell on the grid or INDEX_NONE if the cell is not on the level. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "Cell"))
+	int32 GetCellIndex(const FCell& Cell) const;
+
+	/** Forces the packed mirror of map components to be rebuilt on next query, e.g. when cell indices are changed by the new grid. */
+	FORCEINLINE void MarkPackedMapComponentsDirty() const { PackedMapComponentsInternal.LayoutVersion = MAX_uint32; }
+
+	/** Updates the cell index of given map component in the packed mirror without rebuilding it,
+	 * is called by map components when their cell is changed, e.g. on movement or on replicated cell. */
+	void UpdatePackedMapComponent(const UMapComponent& MapComponent) const;
+
+	/** Returns the first map component of specified actor types located on the cell by its row-major index, nullptr if there is no such one.
+	 * Is checked over packed memory, so only the matched map component is touched. */
+	UMapComponent* GetMapComponentOnCellIndex(int32 CellIndex, int32 ActorsTypesBitmask) const;
+
+	/** Returns the row-major index of the grid cell nearest to given location in constant time, INDEX_NONE if the grid is empty.
+	 * The location is projected on grid axes, rounded to the column and row and clamped by the grid size. */
+	int32 GetNearestCellIndex(const FVector& Location) const;
+
+	/** Returns the cell by its row-major index on the grid if exists, invalid cell otherwise. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FCell& GetCellByIndex(int32 CellIndex) const { return GridCellsInternal.IsValidIndex(CellIndex) ? GridCellsInternal[CellIndex] : FCell::InvalidCell; }
+
+	/** Returns EActorType bitmask of all level actors that are currently located on the cell by its row-major index. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetActorTypesOnCellIndex(int32 CellIndex) const { return CellActorTypesInternal.IsValidIndex(CellIndex) ? CellActorTypesInternal[CellIndex] : TO_FLAG(EAT::None); }
+
+	/** Returns the world time when the cell by its row-major index is exploded by the earliest bomb, MAX_flt if it is unknown or the cell is not dangerous. */
+	FORCEINLINE float GetDetonationTimeOnCellIndex(int32 CellIndex) const { return DangerTimesInternal.IsValidIndex(CellIndex) ? DangerTimesInternal[CellIndex] : MAX_flt; }
+
+	/** Returns EActorType bitmask of level actors that break lines for specified type of cells searching.
+	 * Is constexpr, so the blocker mask of known pathfinder is resolved at compile time. */
+	static constexpr int32 GetBreakActorTypes(EPathType Pathfinder)
+	{
+		switch (Pathfinder)
+		{
+			case EPathType::Explosion:
+				return TO_FLAG(EAT::Wall);
+			case EPathType::Free:
+			case EPathType::Safe:
+				return TO_FLAG(EAT::Wall | EAT::Bomb | EAT::Box);
+			case EPathType::Secure:
+				return TO_FLAG(EAT::Wall | EAT::Bomb | EAT::Box | EAT::Player);
+			default:
+				return TO_FLAG(EAT::None);
+		}
+	}
+
+	/** Allocation-free version of GetSidesCells that works with row-major indices of cells.
+	 * Is useful for hot paths like AI or explosions that call it many times per update.
+	 *
+	 * @param OutCellIndices Will be appended by indices of found cells, small results don't allocate since the buffer is inline.
+	 * @param CellIndex The start of searching by the sides, is added to found cells if it is not in BreakCells.
+	 * @param BreakActorTypes EActorType bitmask of level actors that break lines, @see GetBreakActorTypes.
+	 * @param BreakCells Optional bitboard of cells that break lines as well, e.g: explosions or already found cells.
+	 * @param SideLength Distance in number of cells from a center.
+	 * @param DirectionsBitmask All sides need to iterate.
+	 */
+	void GetSidesCellIndices(
+		FCellIndices& OutCellIndices,
+		int32 CellIndex,
+		int32 BreakActorTypes,
+		const FCellsBitboard* BreakCells,
+		int32 SideLength,
+		int32 DirectionsBitmask) const;
+
+	/** Returns the number of free cells by each side of given cell until the line is broken, without the center: Left, Right, Forward, Backward.
+	 * Is the same as GetSidesCellIndices for each side separately, but each ray is a bit scan on the occupancy bitboards:
+	 * rows are scanned on row-major bitboards and columns on their column-major copies.
+	 * @param OutRayLengths Found lengths, are limited by 255 cells.
+	 * @param CellIndex The row-major index of the center cell.
+	 * @param BreakActorTypes EActorType bitmask of level actors that break lines, @see GetBreakActorTypes.
+	 * @param SideLength Distance in number of cells from a center. */
+	void GetSideRayLengths(uint8 (&OutRayLengths)[4], int32 CellIndex, int32 BreakActorTypes, int32 SideLength) const;
+
+	/** Static implementation of GetSidesCellIndices() that works with any given occupancy of the grid instead of the current one.
+	 * Is useful for copies of the level state like the AI snapshot that could be read outside of the Generated Map.
+	 * @param GridSize The number of columns (X) and rows (Y) of the grid.
+	 * @param CellActorTypes Dense row-major EActorType bitmask of each cell on the grid. */
+	static void GetSidesCellIndices(
+		FCellIndices& OutCellIndices,
+		int32 CellIndex,
+		const FIntPoint& GridSize,
+		TConstArrayView<uint8> CellActorTypes,
+		int32 BreakActorTypes,
+		const FCellsBitboard* BreakCells,
+		int32 SideLength,
+		int32 DirectionsBitmask);
+
+	/** Returns the bitboard of cells that are going to be exploded by bombs or marked as dangerous from outside. */
+	void GetDangerousCellsBitboard(FCellsBitboard& OutBitboard) const;
+
+	/** Registers, refreshes or unregisters given bomb in the danger map.
+	 * Is called by the bomb itself when it is initialized, its lifespan is started or it is detonated.
+	 * The bomb is unregistered if it does not have any explosion cells anymore. */
+	void UpdateBombDanger(const class ABombActor* BombActor);
+
+	/** Returns the number of seconds left until given cell is exploded by the earliest bomb,
+	 * -1 if there is no bomb that is going to explode given cell. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "Cell"))
+	float GetCellDangerTime(const FCell& Cell) const;
+
+	/** Replaces outside added dangerous cells, bots take them into account on their next update.
+	 * @see AGeneratedMap::AdditionalDangerousCells */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void SetAdditionalDangerousCells(const TSet<FCell>& InCells);
+
+	/** Returns the shared read-only state of the level for bots.
+	 * Is rebuilt only when occupancy, danger or outside dangerous cells are changed since the last call, so all bots share one build. */
+	const FAIWorldSnapshot& GetAIWorldSnapshot() const;
+
+	/** Returns the immutable ref-counted copy of the AI snapshot that could be kept and read by worker threads, is callable only on the game thread.
+	 * Copies are double-buffered: the next build is written to the back copy if no worker holds it anymore, otherwise a new copy is allocated,
+	 * so the copy is never changed under any reader. */
+	TSharedRef<const FAIWorldSnapshot, ESPMode::ThreadSafe> GetSharedWorldSnapshot() const;
+
+	/** Returns the number of steps by free cells from each cell to the nearest cell with actors of specified types, INDEX_NONE for unreachable cells.
+	 * Is one multi-source breadth-first search started from all target cells at once, the result is cached per bitmask until the level state is changed,
+	 * so any number of queries per tick cost one search per change.
+	 * @param ActorsTypesBitmask Bitmask of actors types to find the distance to, e.g: items or players.
+	 * @see FAIWorldSnapshot::BuildDistanceField */
+	const TArray<int32>& GetDistanceMap(int32 ActorsTypesBitmask) const;
+
+	/** Returns the number that is changed each time any map component is added, removed or moved to another cell. */
+	FORCEINLINE uint32 GetMapComponentsVersion() const { return MapComponentsInternal.GetItemsVersion(); }
+
+	/** Returns the seed of the last level actors generation. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetGenerationSeed() const { return GenerationSeedInternal; }
+
+	/** Forces the seed of next generations, e.g. to reproduce the recorded match, 0 to use the seed of the data asset. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void SetGenerationSeedOverride(int32 Seed) { GenerationSeedOverrideInternal = Seed; }
+
+	/** Forces chances of walls and boxes of next generations, e.g. to benchmark the generation, negative values to use chances of the data asset. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void SetGenerationChancesOverride(int32 WallsChance, int32 BoxesChance);
+
+	/** Returns the number of level actors on the grid. */
+	FORCEINLINE int32 GetMapComponentsNum() const { return MapComponentsInternal.Num(); }
+
+	/** Returns the heap memory used by cells of the grid, their indices, occupancy, chunks and the danger map. */
+	SIZE_T GetGridAllocatedSize() const;
+
+	/** Returns the heap memory used by map components container, its packed mirror and the client mirror of replicated specs. */
+	SIZE_T GetMapComponentsAllocatedSize() const;
+
+	/** Returns the number of random fills that were done by the last level actors generation. */
+	FORCEINLINE int32 GetLastGenerationAttempts() const { return LastGenerationAttemptsInternal; }
+
+	/** Returns the time in seconds that was spent by the last level actors generation before spawning. */
+	FORCEINLINE float GetLastGenerationTime() const { return LastGenerationTimeInternal; }
+
+	/** Returns the time in seconds that was spent by path checks of all attempts of the last level actors generation. */
+	FORCEINLINE float GetLastPathCheckTime() const { return LastPathCheckTimeInternal; }
+
+	/** Returns the time in seconds since the last generation was started until all its level actors were spawned, is negative while spawning. */
+	FORCEINLINE float GetLastSpawnTime() const { return LastSpawnTimeInternal; }
+
+	/** Returns the stream seeded by the generation seed and given cell, so random events of the cell are reproduced by the same seed.
+	 * @param Cell The cell where the random event happens.
+	 * @param Salt Distinguishes different events on the same cell. */
+	FRandomStream GetCellRandomStream(const FCell& Cell, int32 Salt = 0) const;
+
+	/** Returns the transform of a level actor of given type located on specified cell.
+	 * Walls and boxes are rotated by the generation seed, so clients get the same rotation without its replication. */
+	FTransform GetLevelActorTransform(const FCell& Cell, EActorType ActorType) const;
+
+	/** Marks given cell on client as occupied by given actor type until its authoritative level actor is replicated there.
+	 * Is used to predict actions of the local player, like bomb placing, does nothing on the server. */
+	void AddPredictedActorType(const FCell& Cell, EActorType ActorType);
+
+	/** Removes the prediction of given actor type on specified cell, e.g: when it was rejected by the server. */
+	void RemovePredictedActorType(const FCell& Cell, EActorType ActorType);
+
+	/** Returns true if given actor type is still predicted on the cell, so its authoritative level actor is not replicated yet. */
+	bool IsPredictedActorType(const FCell& Cell, EActorType ActorType) const;
+
+	/** Returns the bits of all cells occupied by walls, where each byte holds 8 cells in row-major order. */
+	const FORCEINLINE TArray<uint8>& GetWallsBitmask() const { return WallsBitmaskInternal; }
+
+	/** Returns true if given cell has an actor of specified types (any of them if more than one type is set),
+	 * if none of types is specified, returns true if the cell is empty. */
+	bool DoesCellMatchActorTypes(const FCell& Cell, int32 ActorsTypesBitmask) const;
+
+	/** Returns the bitboard of cells that have actors of specified types, or of empty cells if none of types is specified.
+	 * Types are combined by word-wise OR, so multi-type masks like EAT::Bomb | EAT::Box cost nothing extra. */
+	void GetCellsBitboard(FCellsBitboard& OutBitboard, int32 ActorsTypesBitmask) const;
+
+	/** Returns the occupancy of the grid split into chunks, is used by area queries, instanced meshes and the replication graph. */
+	const FORCEINLINE FGridChunks& GetGridChunks() const { return GridChunksInternal; }
+
+	/** Outputs row-major indices of cells within the square of given radius around the center cell that have actors of specified types.
+	 * Only chunks overlapped by the square are visited, so the cost does not grow with the level size. */
+	void GetCellIndicesInArea(FCellIndices& OutCellIndices, int32 CenterCellIndex, int32 Radius, int32 ActorsTypesBitmask) const;
+
+	/** Writes the state of the running match to the compact binary blob in memory: layout, items, bombs with their fuses, players and the countdown.
+	 * Reads only the grid and its level actors without any allocation per actor, so it could be taken every few seconds on the server.
+	 * @return false if is not the server or the grid is empty. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	bool CaptureMatchSnapshot(TArray<uint8>& OutSnapshot) const;
+
+	/** Restores the state of the match from the blob captured on the grid of the same size, e.g: for crash recovery or an instant rematch.
+	 * Walls and boxes are kept or moved where they match and the rest is spawned by the batch spawn path,
+	 * alive players are moved to their cells with their powerups, destroyed players are respawned,
+	 * items and bombs are requested from pools by one batch and get their types and fuses once spawned.
+	 * @return false if is not the server or the snapshot is not valid for current grid. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	bool RestoreMatchSnapshot(const TArray<uint8>& Snapshot);
+
+	/** Returns the last checkpoint of the running match that is captured by the server every few seconds, is empty if none was captured.
+	 * @see 'Bomber.Match.CheckpointSeconds' */
+	const FORCEINLINE TArray<uint8>& GetMatchCheckpoint() const { return MatchCheckpointInternal; }
+
+	/** Restores the match from its last checkpoint, e.g: by the cheat to test crash recovery or an instant rematch.
+	 * @return false if no checkpoint was captured yet or it's not valid for current grid. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	bool RestoreMatchCheckpoint();
+
+	/** Captures the match snapshot as the last checkpoint, is called by the timer on the server while the match is in progress. */
+	void CaptureMatchCheckpoint();
+
 protected:
 	/* ---------------------------------------------------
 	 *		Protected properties
@@ -161,6 +537,9 @@ protected:
 	/** Gives access for helper utilities to expand cells operations on the Generated Map. */
 	friend class UCellsUtilsLibrary;
 
+	/** Gives access for replication callbacks of map components to mirror them into the occupancy on client. */
+	friend struct FMapComponentSpec;
+
 	/** The blueprint background actor  */
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Collision Component"))
 	TObjectPtr<class UChildActorComponent> CollisionComponentInternal = nullptr;
@@ -171,6 +550,79 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Replicated, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Grid Cells", ShowOnlyInnerProperties))
 	TArray<FCell> GridCellsInternal;
 
+	/** Cached transform of the grid: is refreshed only in ThisClass::TransformGeneratedMap() instead of recomputing it from all cells on each request. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Grid Transform"))
+	FTransform GridTransformInternal = FTransform::Identity;
+
+	/** Cached number of columns (X) and rows (Y) of the grid. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Grid Size"))
+	FIntPoint GridSizeInternal = FIntPoint::ZeroValue;
+
+	/** Cached center cell of the grid. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Grid Center Cell"))
+	FCell GridCenterCellInternal = FCell::InvalidCell;
+
+	/** Row-major index of each cell from GridCellsInternal, allows to find the position of any cell on the grid without iterating it.
+	 * Is rebuilt together with the grid in ThisClass::TransformGeneratedMap(). */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Cell Indices"))
+	TMap<FCell, int32> CellIndicesInternal;
+
+	/** Dense row-major occupancy of the grid: each element is EActorType bitmask of level actors located on the cell with the same index in GridCellsInternal.
+	 * Is kept in step with Map Components on adding, moving and removing level actors, so cell queries are array reads instead of building sets. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Cell Actor Types"))
+	TArray<uint8> CellActorTypesInternal;
+
+	/** Number of actor types in EActorType::All, each of them has own bitboard. */
+	static constexpr int32 ActorTypesNum = 5;
+
+	/** Per actor type occupancy of the grid, where bitboard index is the bit index of the EActorType flag.
+	 * Is updated together with CellActorTypesInternal. */
+	TStaticArray<FCellsBitboard, ActorTypesNum> ActorTypesBitboardsInternal;
+
+	/** Column-major copies of ActorTypesBitboardsInternal, so cells of one column are neighbour bits as well.
+	 * @see ThisClass::GetSideRayLengths */
+	TStaticArray<FCellsBitboard, ActorTypesNum> ActorTypesColumnBitboardsInternal;
+
+	/** The same occupancy as ActorTypesBitboardsInternal, but split into chunks of 8x8 cells.
+	 * Is updated together with CellActorTypesInternal. */
+	FGridChunks GridChunksInternal;
+
+	/** Client mirror of replicated map components: the number of specs of each actor type on each cell, where index is CellIndex * ActorTypesNum + bit index of the type.
+	 * Is fed directly by replication callbacks of specs, so the occupancy of a cell is known in O(1) without walking all map components.
+	 * Is empty on the server. */
+	TArray<uint8> ReplicatedActorTypesNumInternal;
+
+	/** Explosions of all bombs that are currently placed on the level, is maintained by bombs themselves. */
+	TArray<FBombDanger> BombsDangerInternal;
+
+	/** Dense row-major danger map: each element is the world time when the cell with the same index in GridCellsInternal is exploded by the earliest bomb.
+	 * MAX_flt if the cell is not dangerous or if the bomb lifespan is not started yet, in last case the cell is still set in DangerousCellsInternal. */
+	TArray<float> DangerTimesInternal;
+
+	/** Bitboard of cells that are going to be exploded by any bomb, is updated together with DangerTimesInternal. */
+	FCellsBitboard DangerousCellsInternal;
+
+	/** Is incremented each time the occupancy or the danger map is changed, so cached copies of the level state know when they are outdated. */
+	uint32 StateVersionInternal = 0;
+
+	/** Cached level state for bots, @see ThisClass::GetAIWorldSnapshot. */
+	mutable FAIWorldSnapshot AIWorldSnapshotInternal;
+
+	/** Is incremented each time AdditionalDangerousCells are changed, so they are not rehashed on each snapshot request. */
+	uint32 AdditionalDangerousCellsVersionInternal = 0;
+
+	/** Version of AdditionalDangerousCells the AI snapshot was built with. */
+	mutable uint32 AIWorldSnapshotDangerVersionInternal = 0;
+
+	/** Cached distance maps by actor types bitmask they were found to, @see ThisClass::GetDistanceMap. */
+	mutable TMap<int32, FGridDistanceMap> DistanceMapsInternal;
+
+	/** Front and back copies of the AI snapshot published for worker threads, @see ThisClass::GetSharedWorldSnapshot. */
+	mutable TSharedPtr<FAIWorldSnapshot, ESPMode::ThreadSafe> SharedWorldSnapshotsInternal[2];
+
+	/** Index of the front copy in SharedWorldSnapshotsInternal that was published last. */
+	mutable int32 SharedWorldSnapshotIndexInternal = 0;
+
 	/** Map components of all level actors currently spawned on the Generated Map.
 	 * Is changing during the game on explosions and on the level regeneration.
 	 * Array of components is wrapped by FMapComponentsContainer.
@@ -178,6 +630,25 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, ReplicatedUsing = "OnRep_MapComponents", Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Map Components"))
 	FMapComponentsContainer MapComponentsInternal;
 
+	/** Structure-of-arrays mirror of MapComponentsInternal, every array is parallel to its items.
+	 * Allows iteration-heavy queries to run over packed memory, so map components are touched only for found results. */
+	struct FPackedMapComponents
+	{
+		/** Row-major index of the cell of each item on the grid, INDEX_NONE if it is not on the grid. */
+		TArray<int32> CellIndices;
+
+		/** EActorType bitmask of each item. */
+		TArray<uint8> ActorTypes;
+
+		/** Layout version of the container from which this mirror was built, @see FMapComponentsContainer::GetLayoutVersion. */
+		uint32 LayoutVersion = MAX_uint32;
+	};
+
+	/** Packed mirror of MapComponentsInternal, is rebuilt lazily on first query after items are added or removed,
+	 * while moved map components update only their own cell index, @see AGeneratedMap::UpdatePackedMapComponent.
+	 * @see AGeneratedMap::GetPackedMapComponents */
+	mutable FPackedMapComponents PackedMapComponentsInternal;
+
 	/** Contains map components that were dragged to the scene
 	 * Is set in editor by adding and dragging actors, but can be changed during the game. */
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Category = "C++", meta = (BlueprintProtected, DisplayName = "Dragged Cells"))
@@ -191,10 +662,145 @@ protected:
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Camera Component"))
 	TObjectPtr<class UMyCameraComponent> CameraComponentInternal = nullptr;
 
+	/** Attached component that draws walls and boxes as instances, if enabled in the Generated Map Data Asset. */
+	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Instanced Meshes Component"))
+	TObjectPtr<class UInstancedLevelMeshesComponent> InstancedMeshesComponentInternal = nullptr;
+
 	/** Is true when current state is Game Starting. */
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Replicated, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Game Running"))
 	bool bIsGameRunningInternal = false;
 
+	/** The seed of the last level actors generation, is replicated to let clients reproduce the same layout. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Replicated, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Generation Seed"))
+	int32 GenerationSeedInternal = 0;
+
+	/** The seed that overrides the seed of the data asset for next generations, 0 if is not overridden. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Generation Seed Override"))
+	int32 GenerationSeedOverrideInternal = 0;
+
+	/** The chance of walls that overrides the chance of the data asset for next generations, is negative if is not overridden. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Walls Chance Override"))
+	int32 WallsChanceOverrideInternal = INDEX_NONE;
+
+	/** The chance of boxes that overrides the chance of the data asset for next generations, is negative if is not overridden. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Boxes Chance Override"))
+	int32 BoxesChanceOverrideInternal = INDEX_NONE;
+
+	/** EActorType bitmask of predicted level actors by their cell index, exists only on client.
+	 * Is merged into the occupancy until authoritative actors are replicated. */
+	TMap<int32, int32> PredictedActorTypesInternal;
+
+	/** Compressed layout of walls, each bit is a cell in row-major order that is occupied by a wall.
+	 * Walls are static for the whole match, so clients know their cells as soon as this small array is replicated
+	 * together with the level type and the seed, before own wall actors are replicated. */
+	UPROPERTY(VisibleInstanceOnly, ReplicatedUsing = "OnRep_WallsBitmask", Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Walls Bitmask"))
+	TArray<uint8> WallsBitmaskInternal;
+
+	/** EActorType of each cell in row-major order that was baked in editor by BakeLevelLayout(), is empty if the level is generated.
+	 * Is saved with the level, so it is the same on all machines without any generation. */
+	UPROPERTY(VisibleInstanceOnly, Category = "C++", AdvancedDisplay, meta = (BlueprintProtected, DisplayName = "Baked Layout"))
+	TArray<uint8> BakedLayoutInternal;
+
+	/** The grid size for which the layout was baked, the baked layout is ignored if the level is resized. */
+	UPROPERTY(VisibleInstanceOnly, Category = "C++", AdvancedDisplay, meta = (BlueprintProtected, DisplayName = "Baked Layout Size"))
+	FIntPoint BakedLayoutSizeInternal = FIntPoint::ZeroValue;
+
+	/** The seed of the baked generation, is applied as the generation seed to keep seeded randomness of the match the same. */
+	UPROPERTY(VisibleInstanceOnly, Category = "C++", AdvancedDisplay, meta = (BlueprintProtected, DisplayName = "Baked Layout Seed"))
+	int32 BakedLayoutSeedInternal = 0;
+
+	/** The random stream of level actors generation, is initialized by the generation seed. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Random Stream"))
+	FRandomStream RandomStreamInternal;
+
+	/** The number of random fills that were done by the last level actors generation. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Generation Attempts"))
+	int32 LastGenerationAttemptsInternal = 0;
+
+	/** The time in seconds that was spent by the last level actors generation. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Generation Time", Units = "Seconds"))
+	float LastGenerationTimeInternal = 0.f;
+
+	/** The time in seconds that was spent by path checks of all attempts of the last level actors generation. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Path Check Time", Units = "Seconds"))
+	float LastPathCheckTimeInternal = 0.f;
+
+	/** The time in seconds since the last generation was started until all its level actors were spawned, is negative while spawning. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Spawn Time", Units = "Seconds"))
+	float LastSpawnTimeInternal = 0.f;
+
+	/** The platform time when the last level actors generation was started. */
+	double GenerationStartTimeInternal = 0.0;
+
+	/** The progress of spawning generated level actors from 0 to 1, is replicated to show it on clients. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, ReplicatedUsing = "OnRep_GenerationProgress", Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Generation Progress"))
+	float GenerationProgressInternal = 1.f;
+
+	/** Generated level actors that are not requested from pools yet, are sorted by the spawn order. */
+	TArray<TPair<FCell, EActorType>> PendingSpawnsInternal;
+
+	/** The number of generated level actors that are requested by the last generation. */
+	int32 SpawnsNumInternal = 0;
+
+	/** The number of generated level actors that are already spawned by the last generation. */
+	int32 SpawnedNumInternal = 0;
+
+	/** The number of pool requests that are not completed yet by the last generation. */
+	int32 PendingSpawnBatchesNumInternal = 0;
+
+	/** Is incremented on each generation to ignore spawn callbacks of previous generations. */
+	uint32 SpawnGenerationInternal = 0;
+
+	/** The next tick request to continue spawning pending level actors, is cleared when a new generation starts.
+	 * @see AGeneratedMap::SpawnPendingActors */
+	FTimerHandle SpawnPendingTimerInternal;
+
+	/** Level actors requested to be spawned while level actors are destroyed in one batch, are requested from pools together once the batch is finished.
+	 * @see ThisClass::DestroyLevelActorsOnCells */
+	TArray<TPair<FCell, EActorType>> BatchedSpawnsInternal;
+
+	/** Is more than zero while a destruction batch is in progress, so single spawns are collected into BatchedSpawnsInternal. */
+	int32 SpawnBatchDepthInternal = 0;
+
+	/** Level types that were applied or preloaded, the most recently used one is the first.
+	 * @see UGeneratedMapDataAsset::RecentLevelTypesNumInternal */
+	TArray<ELevelType> RecentLevelTypesInternal;
+
+	/** Unloads level types over the budget once level types are not switched for a while. */
+	FTimerHandle UnloadLevelTypesTimerInternal;
+
+	/** The last snapshot of the running match, is captured by the timer on the server.
+	 * @see AGeneratedMap::CaptureMatchCheckpoint */
+	TArray<uint8> MatchCheckpointInternal;
+
+	/** Captures checkpoints of the running match every few seconds. */
+	FTimerHandle MatchCheckpointTimerInternal;
+
+	/** Is valid while the chunk of current level type is installed in background, the level type is applied again once it's completed.
+	 * @see AGeneratedMap::OnLevelTypeChunkInstalled */
+	FDelegateHandle LevelTypeInstallHandleInternal;
+
+	/** The world time when level actors were last returned to the pool, by bit index of their actor type.
+	 * @see FLevelActorPoolPolicy::ShrinkAfterIdleSeconds */
+	TStaticArray<double, ActorTypesNum> PoolReturnTimesInternal = TStaticArray<double, ActorTypesNum>(InPlace, 0.0);
+
+	/** Shrinks pools by their policies once level actors are not returned for a while. */
+	FTimerHandle ShrinkPoolsTimerInternal;
+
+	/** Is true when the level of another size is generating, so pools are shrunk once its actors are spawned.
+	 * @see FLevelActorPoolPolicy::bShrinkOnLevelResize */
+	bool bShrinkPoolsOnResizeInternal = false;
+
+	/** The worker task that computes the layout of the last generation, the grid must not be changed while it runs. */
+	UE::Tasks::TTask<void> LevelLayoutTaskInternal;
+
+	/** Is incremented on each generation to ignore computed layouts of previous generations. */
+	uint32 LevelLayoutGenerationInternal = 0;
+
+	/** The layout of the next round that is computed during the end game, is spawned on the next round start.
+	 * @see AGeneratedMap::PrebuildLevelActors */
+	TSharedPtr<FLevelLayoutGenerationData> PrebuiltLevelLayoutInternal = nullptr;
+
 	/** Specify for which level actors should show debug renders, is not available in shipping build. */
 	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category = "C++", meta = (DevelopmentOnly, Bitmask, BitmaskEnum = "/Script/Bomber.EActorType"))
 	int32 DisplayCellsActorTypes = TO_FLAG(EAT::None);
@@ -220,12 +826,29 @@ protected:
 	/** This is called only in the gameplay before calling begin play to generate level actors */
 	virtual void PostInitializeComponents() override;
 
+	/** Pre-creates inactive level actors in the pools by UGeneratedMapDataAsset::GetPoolWarmUpCounts(),
+	 * so level generation on the match start only activates already pooled actors. */
+	void WarmUpPools();
+
+	/** Pre-creates given number of inactive level actors of each type in the pools. */
+	void WarmUpPoolsByTypes(const TMap<EActorType, int32>& ActorsNumByTypes);
+
+	/** Pre-creates inactive level actors that are missing in the pools for given layout,
+	 * actors that are already on the level or inactive in the pools are not created again. */
+	void WarmUpPoolsForLayout(const FLevelLayoutGenerationData& Data);
+
 	/** Called when is explicitly being destroyed to destroy level actors, not called during level streaming or gameplay ending. */
 	virtual void Destroyed() override;
 
+	/** Called when this actor is removed from the level, waits for the layout computation that uses the grid of this actor. */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Returns properties that are replicated for the lifetime of the actor channel. */
 	virtual void GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const override;
 
+	/** Adds the memory of the grid and map components containers, so they are attributed to this actor by memory reports. */
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 	/** The intersection of (OutCells ∩ ActorsTypesBitmask).
 	 *	Is not public blueprintable since all needed ufunctions are already use this method.
 	 *	@see UCellsUtilsLibrary
@@ -240,15 +863,16 @@ protected:
 	 *	Is not public blueprintable since all needed ufunctions are already use this method.
 	 *	@see UCellsUtilsLibrary
 	 *
-	 * @param OutCells Will contain found cells.
+	 * @param OutCells Will contain found cells, could be FSmallCells for results of a few cells.
 	 * @param Cell The start of searching by the sides.
 	 * @param Pathfinder Type of cells searching.
 	 * @param SideLength Distance in number of cells from a center.
 	 * @param DirectionsBitmask All sides need to iterate.
 	 * @param bBreakInputCells In case, specified OutCells is not empty, these cells break lines as the Wall behavior, will not be removed from the array.
 	 */
+	template <typename SetAllocator>
 	void GetSidesCells(
-		TSet<FCell>& OutCells,
+		TSet<FCell, DefaultKeyFuncs<FCell>, SetAllocator>& OutCells,
 		const FCell& Cell,
 		EPathType Pathfinder,
 		int32 SideLength,
@@ -261,14 +885,113 @@ protected:
 	 * @see UCellsUtilsLibrary
 	 *
 	 * @param CellsToFind Cells to which needs to find any path.
-	 * @param OptionalPathBreakers Optional value for a cells that make an island, if empty, all walls on the level will break the path.
+	 * @param OptionalPathBreakers Optional value for a cells that make an island, if empty, all walls currently spawned on the level will break the path.
+	 * While the level is generated, spawned walls still belong to the previous layout (some of them are reused), so generation never relies on this fallback:
+	 * it passes walls of the new layout and skips the check if the new layout has no walls at all.
 	 */
 	bool DoesPathExistToCells(const FCells& CellsToFind, const FCells& OptionalPathBreakers = FCell::EmptyCells);
 
+	/** Diffs existing level actors with the new layout to avoid destroying and spawning of unchanged actors on regeneration.
+	 * Walls and boxes on the same cells are kept, others of these types are moved to new cells of the same type, the rest is destroyed.
+	 * @param InOutActorsToSpawn Generated layout, kept and moved actors are removed from it, so only the rest has to be spawned.
+	 * @param InOutDraggedToSpawn Layout of dragged actors, is handled the same way.
+	 * @param KeptActorTypes EActorType bitmask of actors that are left untouched, e.g: players on restoring the match snapshot. */
+	void ReuseLevelActors(TMap<FCell, EActorType>& InOutActorsToSpawn, TMap<FCell, EActorType>& InOutDraggedToSpawn, int32 KeptActorTypes = 0);
+
+	/** Recalculates the occupancy of given cell by all Map Components that are located on it. */
+	void UpdateCellActorTypes(const FCell& Cell);
+	void UpdateCellActorTypesByIndex(int32 CellIndex);
+
+	/** Recalculates the occupancy of the whole grid, is used when the grid is rebuilt or all Map Components are changed at once. */
+	void RebuildCellActorTypes();
+
+	/** Returns the cell of given spec, is taken from replicated data on client if its map component is not resolved yet. */
+	static const FCell& GetSpecCell(const FMapComponentSpec& Spec);
+
+	/** Returns the actor type of given spec, is taken from replicated data on client if its map component is not resolved yet. */
+	static EActorType GetSpecActorType(const FMapComponentSpec& Spec);
+
+	/** Returns the packed mirror of map components, rebuilds it if map components were changed since last request. */
+	const FPackedMapComponents& GetPackedMapComponents() const;
+
+	/** Recalculates the danger map from cached explosions of all registered bombs without casting their explosions again. */
+	void RebuildDangerMap();
+
+	/** Casts explosions of all registered bombs again, is used when walls that break explosions are changed or the grid is rebuilt. */
+	void RefreshBombsDanger();
+
 	/** Spawns and fills the Grid Array values by level actors */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, CallInEditor, Category = "C++", meta = (BlueprintProtected))
 	void GenerateLevelActors();
 
+	/** Computes the new layout from current inputs, spawns it or keeps it as prebuilt for the next round.
+	 * @param bSpawnWhenComputed If false, the layout is kept by ThisClass::PrebuiltLevelLayoutInternal and only pools are warmed for it. */
+	void GenerateLevelLayout(bool bSpawnWhenComputed);
+
+	/** Computes the layout of the next round and warms pools for it without spawning, is called on the end game when the server is idle. */
+	void PrebuildLevelActors();
+
+	/** Spawns the layout that was computed by ThisClass::PrebuildLevelActors(), so the next round starts without the generation.
+	 * @return false if there is no prebuilt layout, so the level has to be generated. */
+	bool SpawnPrebuiltLevelActors();
+
+	/** Generates the layout by given inputs: random fill, symmetry and path validation.
+	 * Reads only the grid of this actor, so it is safe to be called on a worker thread while the grid is not changed. */
+	void ComputeLevelLayout(FLevelLayoutGenerationData& InOutData);
+
+	/** Spawns the computed layout on the game thread: keeps or moves existing actors and spawns the rest. */
+	void ApplyLevelLayout(FLevelLayoutGenerationData& InOutData);
+
+	/** Blocks until the layout computation is finished, is called before the grid is changed. */
+	void WaitForLevelLayoutTask();
+
+	/** Saves current walls, boxes, items and players of the level with its seed into this actor, so the level is spawned from them instead of being generated.
+	 * Is used for curated maps: the layout is saved with the level asset and is identical on all machines. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, CallInEditor, Category = "C++", meta = (BlueprintProtected, DevelopmentOnly))
+	void BakeLevelLayout();
+
+	/** Removes the baked layout, so the level is generated again. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, CallInEditor, Category = "C++", meta = (BlueprintProtected, DevelopmentOnly))
+	void ClearBakedLevelLayout();
+
+	/** Returns true if the level is spawned from the baked layout, it has to match current size of the grid. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	bool HasBakedLevelLayout() const;
+
+	/** Fills actors to spawn from the baked layout except given dragged cells.
+	 * @return false if there is no baked layout of current grid size. */
+	bool GetBakedActorsToSpawn(TMap<FCell, EActorType>& OutActorsToSpawn, const FCells& DraggedCells) const;
+
+	/** Fills given layout by current size, level type, seed and walls, boxes, items and players of the level except dragged ones. */
+	void GetCurrentLevelLayout(struct FLevelLayout& OutLayout) const;
+
+	/** Writes current layout of the level to the compact binary file that could be shared and imported on another machine.
+	 * @return false if the file is not written. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	bool ExportLevelLayout(const FString& FilePath) const;
+
+	/** Reads the layout from the compact binary file and spawns the level from it without any generation, the layout becomes baked.
+	 * @return false if the file is missing or is not a valid layout. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	bool ImportLevelLayout(const FString& FilePath);
+
+	/** Removes the least number of generated walls to make all specified cells reachable from the first cell,
+	 * is used when the generation budget is exhausted instead of rerolling the level endlessly.
+	 * Removed walls are mirrored to keep the level symmetric.
+	 * @param InOutActorsToSpawn Generated actors, their walls could be removed.
+	 * @param CellsToFind Cells to which the path has to exist.
+	 * @param FixedWalls Dragged walls that can't be removed. */
+	void CarvePathToCells(TMap<FCell, EActorType>& InOutActorsToSpawn, const FCells& CellsToFind, const FCells& FixedWalls) const;
+
+	/** Makes all specified cells reachable from the first cell in one pass by union-find of free cells:
+	 * generated wall groups are visited in random order and each group that joins separated areas is removed.
+	 * Groups are mirrored walls, so the level stays symmetric, thick walls that are left are cut by ThisClass::CarvePathToCells().
+	 * @param InOutActorsToSpawn Generated actors, their walls could be removed.
+	 * @param CellsToFind Cells that have to be connected.
+	 * @param FixedWalls Dragged walls that can't be removed.
+	 * @param RandomStream The stream wall groups are shuffled by. */
+	void ConnectCellsByWallGroups(TMap<FCell, EActorType>& InOutActorsToSpawn, const FCells& CellsToFind, const FCells& FixedWalls, FRandomStream& RandomStream) const;
+
 	/** Map components getter.
 	 *
 	 * @param OutBitmaskedComponents Will contains map components of owners having the specified types.
@@ -290,12 +1013,30 @@ protected:
 
 	/** Scales dragged cells according new grid if sizes are different. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
-	void ScaleDraggedCellsOnGrid(const TSet<FCell>& OriginalGrid, const TSet<FCell>& NewGrid);
+	void ScaleDraggedCellsOnGrid(const TArray<FCell>& OriginalGrid, const TArray<FCell>& NewGrid);
 
 	/** Updates current level type. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void ApplyLevelType();
 
+	/** Is called by the platform when any pak chunk is installed, applies current level type again if its chunk is installed. */
+	void OnLevelTypeChunkInstalled(uint32 ChunkId, bool bSuccess);
+
+	/** Stops listening the install of the level type chunk if it's still in progress. */
+	void StopListeningLevelTypeInstall();
+
+	/** Moves given level type to the front of recently used ones and delays unloading of level types over the budget. */
+	void TouchRecentLevelType(ELevelType LevelType);
+
+	/** Unloads streaming levels of all level types except the current one and the most recently used ones within the budget.
+	 * @see UGeneratedMapDataAsset::RecentLevelTypesNumInternal */
+	void UnloadInactiveLevelTypes();
+
+	/** Swaps meshes of all level actors to rows of current level type in one pass without placing them on the grid again.
+	 * The row is resolved once per actor type, players and items are still reconstructed since their meshes depend on own state.
+	 * @param ActorTypesBitmask Only level actors of these types are swapped, e.g: when the data asset of one type is changed in editor. */
+	void SwapLevelActorMeshes(int32 ActorTypesBitmask = TO_FLAG(EAT::All));
+
 	/** Is called on client to load new level. */
 	UFUNCTION()
 	void OnRep_LevelType();
@@ -304,10 +1045,72 @@ protected:
 	UFUNCTION()
 	void OnRep_MapComponents();
 
+	/** Packs current walls occupancy into the replicated walls bitmask, is called on the server when walls are changed. */
+	void UpdateWallsBitmask();
+
+	/** Returns actor types that are known on client without map components: walls of the replicated walls bitmask and predicted actors.
+	 * Always returns none on the server. */
+	int32 GetClientActorTypes(int32 CellIndex) const;
+
+	/** Removes predicted actor types that are already replicated by map components on their cells. */
+	void ReconcilePredictedActorTypes();
+
+	/** Is called on client by replication callbacks of given spec to move it in the occupancy mirror by its replicated cell and type.
+	 * Its previous contribution is removed first, so only its old and new cells are updated instead of the whole grid.
+	 * @param bIsRemoved true if the spec is going to be removed from the array, so it is not counted anymore. */
+	void MirrorReplicatedSpec(FMapComponentSpec& InOutSpec, bool bIsRemoved);
+
+	/** Recounts all replicated specs in the occupancy mirror on client, e.g: when the grid is rebuilt. */
+	void RebuildReplicatedActorTypes();
+
+	/** Adds given delta to the number of specs of given actor type on the cell in the occupancy mirror. */
+	void CountReplicatedActorType(int32 CellIndex, EActorType ActorType, int32 Delta);
+
+	/** Returns actor types of replicated specs located on the cell by the occupancy mirror, always returns none on the server. */
+	int32 GetReplicatedActorTypes(int32 CellIndex) const;
+
+	/** Is called on client to apply replicated layout of walls to the occupancy and visuals. */
+	UFUNCTION()
+	void OnRep_WallsBitmask();
+
+	/** Draws walls by the replicated layout on client, if walls are drawn as instances. */
+	void UpdateInstancedWallsLayout();
+
+	/** Requests next pending level actors from pools until the spawn budget of this frame is reached, continues on the next frame. */
+	void SpawnPendingActors();
+
+	/** Validates all spawns collected during the finished destruction batch in one pass and requests them from pools by one request. */
+	void SpawnBatchedActors();
+
+	/** Is called when pools have spawned requested level actors of given generation. */
+	void OnSpawnedPendingActors(const TArray<struct FPoolObjectData>& CreatedObjects, uint32 SpawnGeneration);
+
+	/** Remembers how long the last generation was spawned. */
+	void OnFinishedSpawningGeneratedActors();
+
+	/** Sets the spawning progress and notifies listeners. */
+	void SetGenerationProgress(float NewProgress);
+
+	/** Is called on client to broadcast On Generation Progress Changed delegate. */
+	UFUNCTION()
+	void OnRep_GenerationProgress();
+
 	/** Internal multicast function to set new size for generated map for all instances. */
 	UFUNCTION(BlueprintCallable, NetMulticast, Reliable, Category = "C++", meta = (BlueprintProtected))
 	void MulticastSetLevelSize(const FIntPoint& LevelSize);
 
+	/** Deactivates the owner of specified Map Component that is already removed from the grid.
+	 * @return The owner that has to be returned to the pool or destroyed, nullptr if it must stay on the level. */
+	AActor* DeactivateLevelActor(UMapComponent* MapComponent, UObject* DestroyCauser);
+
+	/** Remembers that level actors of given types are returned to pools and delays shrinking of these pools by their policies.
+	 * @see FLevelActorPoolPolicy */
+	void RequestPoolsShrink(int32 ActorTypesBitmask);
+
+	/** Destroys inactive level actors in pools over limits of pool policies of their types.
+	 * Is retried later while the generation is spawning, since inactive actors are about to be taken. */
+	void ShrinkPools();
+
 	/* ---------------------------------------------------
 	 *					Editor development
 	 * --------------------------------------------------- */
@@ -315,6 +1118,11 @@ protected:
 #if WITH_EDITOR	 // [GEditor]PostLoad();
 	/** Do any object-specific cleanup required immediately after loading an object. This is not called for newly-created objects. */
 	virtual void PostLoad() override;
+
+	/** Is called in editor on any data asset change to update only what depends on the changed data asset:
+	 * - Level actor data asset: meshes of its actor type are swapped.
+	 * - Other data assets like the Generated Map Data Asset: the level is regenerated. */
+	void OnAnyDataAssetChanged(const UObject* ChangedDataAsset);
 #endif	// WITH_EDITOR [GEditor]PostLoad();
 
 	/** The dragged version of the Add To Grid function to add the dragged actor on the level. */
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "GameFramework/Actor.h"
+#include "Components/MapComponentOwner.h"
 //---
 #include "BombActor.generated.h"
 
@@ -16,7 +17,7 @@ enum class ECurrentGameState : uint8;
  * @see Access its data with UBombDataAsset (Content/Bomber/DataAssets/DA_Bomb).
  */
 UCLASS()
-class BOMBER_API ABombActor final : public AActor
+class BOMBER_API ABombActor final : public AActor, public IMapComponentOwner
 {
 	GENERATED_BODY()
 
@@ -28,6 +29,9 @@ public:
 	/** Sets default values for this actor's properties */
 	ABombActor();
 
+	/** Returns the map component of this actor, is created on its construction. */
+	virtual UMapComponent* GetOwnedMapComponent() const override;
+
 	/** Preinitialize a bomb actor, could be called multiple times. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void ConstructBombActor();
@@ -40,9 +44,30 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE int32 GetExplosionRadius() const { return FireRadiusInternal; }
 
-	/** Sets the defaults of the bomb. */
+	/** Returns the world time in seconds when this bomb is going to explode, MAX_flt if its lifespan is not started yet. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	float GetDetonationTime() const;
+
+	/** Sets the defaults of the bomb.
+	 * @param Causer The player who put this bomb, its powerups define the fire radius.
+	 * @param FireRadiusOverride The radius to use instead of the causer's one if set, e.g: on restoring the match snapshot. */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
-	void InitBomb(const class APlayerCharacter* Causer = nullptr);
+	void InitBomb(const class APlayerCharacter* Causer = nullptr, int32 FireRadiusOverride = -1);
+
+	/** Returns the character ID of the player who put this bomb, INDEX_NONE if was put without the player. Is set only on the server. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetOwnerCharacterID() const { return OwnerCharacterIDInternal; }
+
+	/** Returns the player to whom this bomb is returned once it is deactivated, is set only on the server. */
+	FORCEINLINE class APlayerCharacter* GetReturnCharacter() const { return ReturnCharacterInternal.Get(); }
+
+	/** Sets the player to whom this bomb is returned once it is deactivated, is called by the player on putting own bomb.
+	 * Is tracked natively by this bomb instead of binding the player to the deactivation delegate of each bomb. */
+	void SetReturnCharacter(class APlayerCharacter* InReturnCharacter) { ReturnCharacterInternal = InReturnCharacter; }
+
+	/** Restarts the detonation, so this bomb explodes in given seconds, e.g: on restoring the match snapshot. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void SetFuseSecondsRemain(float SecondsRemain) { SetLifeSpan(SecondsRemain > 0.f ? SecondsRemain : DEFAULT_LIFESPAN); }
 
 	/** Show current explosion cells if the bomb type is allowed to be displayed, is not available in shipping build. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (DevelopmentOnly))
@@ -53,6 +78,12 @@ protected:
 	 *		Protected properties
 	 * --------------------------------------------------- */
 
+	/** Gives access for the grid simulation to detonate due bombs in its step. */
+	friend class UGridSimulationSubsystem;
+
+	/** Gives access for the Cheat Manager to detonate bombs. */
+	friend class UMyCheatManager;
+
 	/** The MapComponent manages this actor on the Generated Map */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Map Component"))
 	TObjectPtr<class UMapComponent> MapComponentInternal = nullptr;
@@ -61,9 +92,25 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "C++", meta = (BlueprintProtected, DisplayName = "Fire Radius"))
 	int32 FireRadiusInternal = INDEX_NONE;
 
-	/** Current material of this bomb, is different for each player. */
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, ReplicatedUsing = "OnRep_BombMaterial", Category = "C++", meta = (BlueprintProtected, DisplayName = "Bomb Material"))
-	TObjectPtr<class UMaterialInterface> BombMaterialInternal = nullptr;
+	/** The character ID of the player who put this bomb, is set by InitBomb on the server and is replicated, so the owning client recognizes its own bomb. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, ReplicatedUsing = "OnRep_OwnerCharacterID", Category = "C++", meta = (BlueprintProtected, DisplayName = "Owner Character ID"))
+	int32 OwnerCharacterIDInternal = INDEX_NONE;
+
+	/** The player to whom this bomb is returned once it is deactivated, is reset on returning, so the bomb is returned only once.
+	 * @see ABombActor::SetReturnCharacter */
+	TWeakObjectPtr<class APlayerCharacter> ReturnCharacterInternal = nullptr;
+
+	/** Index of the color of this bomb, is different for each bot, none means the default material of the bomb mesh.
+	 * Is replicated instead of the material, each side resolves the color or material by itself.
+	 * Is not exposed to blueprints since int8 is not supported there, it is replicated in one byte.
+	 * @see UBombDataAsset::BombColorsInternal */
+	UPROPERTY(VisibleInstanceOnly, Transient, ReplicatedUsing = "OnRep_BombColorIndex", Category = "C++", meta = (DisplayName = "Bomb Color Index"))
+	int8 BombColorIndexInternal = INDEX_NONE;
+
+	/** Bitmask of character IDs that still overlap this bomb since it was placed, so they could pass through it while others are blocked.
+	 * Only the bitmask of up to MAX_PLAYERS_NUM characters is replicated, each side lets these characters ignore this bomb on moving by itself. */
+	UPROPERTY(VisibleInstanceOnly, Transient, ReplicatedUsing = "OnRep_PassThroughPlayers", Category = "C++", meta = (DisplayName = "Pass Through Players"))
+	uint16 PassThroughPlayersInternal = 0;
 
 	/* ---------------------------------------------------
  	 *		Protected functions
@@ -87,46 +134,72 @@ protected:
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	/** Set the lifespan of this actor. When it expires the object will be destroyed.
+	 * On the server the detonation is scheduled in the Grid Simulation Subsystem instead of the actor timer.
 	 * @param InLifespan overriden with a default value, time will be got from the data asset. */
 	virtual void SetLifeSpan(float InLifespan = DEFAULT_LIFESPAN) override;
 
+	/** Cancels the detonation of this bomb both in the timer and in the Grid Simulation Subsystem. */
+	void ClearLifeSpan();
+
 	/** Called when the lifespan of an actor expires (if he has one). */
 	virtual void LifeSpanExpired() override;
 
+	/** Notifies the Generated Map to refresh explosion cells and detonation time of this bomb in its danger map. */
+	void UpdateDangerMap();
+
 	/** Sets the actor to be hidden in the game. Alternatively used to avoid destroying. */
 	virtual void SetActorHiddenInGame(bool bNewHidden) override;
 
-	/** Destroy bomb and burst explosion cells, calls multicast event.*/
+	/** Is not relevant for spectators of the grid stream, they rebuild the level by grid events. */
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	/** Destroy bomb and burst explosion cells, calls multicast event.
+	 * Resolves the whole chain reaction at once: all bombs triggered by this one are detonated in the same step,
+	 * their cells are destroyed in one batch and all blasts are sent by one multicast event. */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++", meta = (BlueprintProtected, DefaultToSelf = "DestroyedActor"))
 	void DetonateBomb();
 
-	/** Destroy bomb and burst explosion cells.
-	  * Calls destroying request of all actors by cells in explosion cells array.*/
+	/** Collects this bomb and all bombs that are triggered by its blast and by blasts of next triggered bombs.
+	 * @param OutExplosions Blasts of all bombs in the chain.
+	 * @param OutExplosionCells Union of cells exploded by all bombs in the chain.
+	 * @param OutChainBombs All bombs in the chain, including this one. */
+	void ResolveChainReaction(TArray<struct FBombExplosion>& OutExplosions, TSet<struct FCell>& OutExplosionCells, TArray<ABombActor*>& OutChainBombs);
+
+	/** Plays effects of all blasts in the chain reaction on each side.
+	 * Blasts are sent as packed grid indices with ray lengths, cells are expanded locally. */
 	UFUNCTION(BlueprintCallable, NetMulticast, Reliable, Category = "C++", meta = (BlueprintProtected))
-	void MulticastDetonateBomb(const TArray<FCell>& ExplosionCells);
+	void MulticastDetonateBomb(const TArray<struct FBombExplosion>& Explosions);
 
-	/**
-	 * Triggers when character end to overlaps with this bomb.
-	 * Sets the collision preset to block all dynamics.
-	 */
-	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
-	void OnBombEndOverlap(AActor* OverlappedActor, AActor* OtherActor);
+	/** Queues explosions of all specified blasts to be shown by cosmetics of this frame, cells are taken by the explosion tier of current game settings.
+	 * @see UCosmeticEventsSubsystem::ConsumeExplosions */
+	void QueueExplosionEvents(const TArray<struct FBombExplosion>& Explosions) const;
+
+	/** Is ticking on the server only while any character passes through this bomb.
+	 * Blocks characters that left this bomb, since blocked characters do not generate end overlap events. */
+	virtual void Tick(float DeltaSeconds) override;
 
 	/** Listen by dragged bombs to handle game resetting. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void OnGameStateChanged(ECurrentGameState CurrentGameState);
 
 #pragma region CustomCollisionResponse
-	/** Sets actual collision response to all players for this bomb. */
+	/** Queries players that overlap this bomb and lets them pass through it, is called once the bomb is placed. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void UpdateCollisionResponseToAllPlayers();
 
-	/** Takes your container and returns is with new specified response for player by its specified ID.
-	 * @param InOutCollisionResponses Will contain requested response.
-	 * @param CharacterID Player to set response.
-	 * @param NewResponse New response to set. */
-	UFUNCTION(BlueprintPure, Category = "C++", meta = (BlueprintProtected))
-	static void MakeCollisionResponseToPlayerByID(FCollisionResponseContainer& InOutCollisionResponses, int32 CharacterID, ECollisionResponse NewResponse);
+	/** Sets the bitmask of character IDs that pass through this bomb, characters are updated only if the bitmask is changed. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++", meta = (BlueprintProtected))
+	void SetPassThroughPlayers(int32 NewPassThroughPlayers);
+
+	/** Lets characters from the pass-through bitmask ignore this bomb on moving, other characters are blocked by it. */
+	void ApplyPassThroughPlayers();
+
+	/** Blocks the player channel right before collision responses are applied, characters pass through this bomb by ignoring it on moving. */
+	void OnApplyCollisionResponses(FCollisionResponseContainer& InOutResponses) const;
+
+	/** Is called on client to update characters by the new pass-through bitmask. */
+	UFUNCTION()
+	void OnRep_PassThroughPlayers();
 
 	/** Takes your container and returns new specified response for all players.
 	  * @param InOutCollisionResponses Will contain requested responses.
@@ -134,29 +207,21 @@ protected:
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (BlueprintProtected))
 	static void MakeCollisionResponseToAllPlayers(FCollisionResponseContainer& InOutCollisionResponses, ECollisionResponse NewResponse);
 
-	/** Takes your container and returns new specified response for those players who match their ID in specified bitmask.
-	  * @param InOutCollisionResponses Will contain requested responses.
-	  * @param Bitmask Each bit represents the character ID.
-	  * @param BitOnResponse Applies response for toggles bits.
-	  * @param BitOffResponse Applies response for clear bits.
-	  * Set 'ECollisionResponse::ECR_MAX' to avoid changing response for toggled or clear bits.
-	  * E.g: Bitmask = 11, BitOnResponse = ECR_Block, BitOffResponse = ECR_MAX:
-	  * specified '11' in binary is '1 0 1 1',
-	  * so characters with IDs '0', '1' and '3' will apply 'ECR_Block' response,
-	  * player with Character ID '2' won't change its response since it's specified as 'ECR_MAX'. */
+	/** Returns the bitmask of character IDs whose capsules overlap this bomb.
+	 * Is tested geometrically on the plane of the level, since characters are blocked by the bomb instead of overlapping it. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (BlueprintProtected))
-	static void MakeCollisionResponseToPlayersInBitmask(FCollisionResponseContainer& InOutCollisionResponses, int32 Bitmask, ECollisionResponse BitOnResponse, ECollisionResponse BitOffResponse);
-
-	/** Returns all players overlapping with this bomb. */
-	UFUNCTION(BlueprintPure, Category = "C++", meta = (BlueprintProtected))
-	void GetOverlappingPlayers(TArray<AActor*>& OutPlayers) const;
+	int32 GetOverlappingPlayersBitmask() const;
 #pragma endregion CustomCollisionResponse
 
 	/** Updates current material for this bomb actor. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void ApplyMaterial();
 
-	/** Is called on client to respond on changes in material of the bomb. */
+	/** Is called on client to respond on changes in color of the bomb. */
+	UFUNCTION()
+	void OnRep_BombColorIndex();
+
+	/** Is called on client when the owner of this bomb is replicated to end the round trip of the local bomb input. */
 	UFUNCTION()
-	void OnRep_BombMaterial();
+	void OnRep_OwnerCharacterID();
 };
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "GameFramework/Actor.h"
+#include "Components/MapComponentOwner.h"
 //---
 #include "BoxActor.generated.h"
 
@@ -11,7 +12,7 @@
  * @see Access its data with UBoxDataAsset (Content/Bomber/DataAssets/DA_Box).
  */
 UCLASS()
-class BOMBER_API ABoxActor final : public AActor
+class BOMBER_API ABoxActor final : public AActor, public IMapComponentOwner
 {
 	GENERATED_BODY()
 
@@ -19,6 +20,9 @@ public:
 	/** Sets default values for this actor's properties */
 	ABoxActor();
 
+	/** Returns the map component of this actor, is created on its construction. */
+	virtual UMapComponent* GetOwnedMapComponent() const override;
+
 	/** Initialize a box actor, could be called multiple times. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void ConstructBoxActor();
@@ -59,6 +63,9 @@ protected:
 	/** Sets the actor to be hidden in the game. Alternatively used to avoid destroying. */
 	virtual void SetActorHiddenInGame(bool bNewHidden) override;
 
+	/** Is not relevant for spectators of the grid stream, they rebuild the level by grid events. */
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
 	/** Called when owned map component is destroyed on the Generated Map. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void OnDeactivatedMapComponent(UMapComponent* MapComponent, UObject* DestroyCauser);
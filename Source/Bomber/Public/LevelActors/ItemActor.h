@@ -3,6 +3,7 @@
 #pragma once
 
 #include "GameFramework/Actor.h"
+#include "Components/MapComponentOwner.h"
 //---
 #include "Bomber.h"
 //---
@@ -13,7 +14,7 @@
  * @see Access its data with UItemDataAsset (Content/Bomber/DataAssets/DA_Item).
  */
 UCLASS()
-class BOMBER_API AItemActor final : public AActor
+class BOMBER_API AItemActor final : public AActor, public IMapComponentOwner
 {
 	GENERATED_BODY()
 
@@ -25,6 +26,9 @@ public:
 	/** Sets default values for this actor's properties */
 	AItemActor();
 
+	/** Returns the map component of this actor, is created on its construction. */
+	virtual UMapComponent* GetOwnedMapComponent() const override;
+
 	/** Initialize an item actor, could be called multiple times. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void ConstructItemActor();
@@ -33,6 +37,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE EItemType GetItemType() const { return ItemTypeInternal; }
 
+	/** Overrides the random item type and updates the mesh, e.g: on restoring the match snapshot. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void SetItemType(EItemType NewItemType);
+
 protected:
 	/* ---------------------------------------------------
 	*		Protected properties
@@ -65,20 +73,24 @@ protected:
 	UFUNCTION()
 	void OnConstructionItemActor();
 
-	/** Called when the game starts or when spawned */
-	virtual void BeginPlay() override;
-
 	/** Sets the actor to be hidden in the game. Alternatively used to avoid destroying. */
 	virtual void SetActorHiddenInGame(bool bNewHidden) override;
 
+	/** Is not relevant for spectators of the grid stream, they rebuild the level by grid events. */
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
 	/** Returns properties that are replicated for the lifetime of the actor channel. */
 	virtual void GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const override;
 
-	/** Triggers when this item starts overlap a player character to destroy itself. */
-	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
-	void OnItemBeginOverlap(AActor* OverlappedActor, AActor* OtherActor);
+	/** Makes the item ignore all collisions, since it is picked up by the grid when the player steps on its cell.
+	 * @see APlayerCharacter::PickUpItemOnCell */
+	void OnApplyCollisionResponses(FCollisionResponseContainer& InOutResponses) const;
+
+	/** Applies this item to given player and removes it from the level, is called on the pickup step of the Grid Simulation Subsystem. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void PickUp(class APlayerCharacter& Player);
 
 	/** Calls to uninitialize item type. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
-	EItemType ResetItemType() { return ItemTypeInternal = EItemType::None; }
+	EItemType ResetItemType();
 };
@@ -3,12 +3,15 @@
 #pragma once
 
 #include "GameFramework/Character.h"
+#include "Components/MapComponentOwner.h"
 //---
+#include "Structures/Cell.h"
 #include "Structures/CustomPlayerMeshData.h"
 #include "Structures/PlayerTag.h"
 //---
 #include "PlayerCharacter.generated.h"
 
+enum class EItemType : uint8;
 enum class ELevelType : uint8;
 
 /**
@@ -42,7 +45,7 @@ struct BOMBER_API FPowerUp
  * @see Access AI's data with UAIDataAsset (Content/Bomber/DataAssets/DA_AI).
  */
 UCLASS()
-class BOMBER_API APlayerCharacter final : public ACharacter
+class BOMBER_API APlayerCharacter final : public ACharacter, public IMapComponentOwner
 {
 	GENERATED_BODY()
 
@@ -60,6 +63,9 @@ public:
 	/** Sets default values for this character's properties */
 	APlayerCharacter(const FObjectInitializer& ObjectInitializer);
 
+	/** Returns the map component of this actor, is created on its construction. */
+	virtual UMapComponent* GetOwnedMapComponent() const override;
+
 	/** Initialize a player actor, could be called multiple times. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void ConstructPlayerCharacter();
@@ -72,10 +78,39 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE int32 GetCharacterID() const { return CharacterIDInternal; }
 
-	/** Spawns bomb on character position */
+	/** Spawns bomb on character position, is predicted on the owning client to show the bomb without waiting for the server.
+	 * Should be bound to the input instead of ServerSpawnBomb(). */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void SpawnBomb();
+
+	/** Spawns bomb on character position without the client prediction, e.g: for bots and replays on the server. */
 	UFUNCTION(Server, Reliable, BlueprintCallable, Category = "C++")
 	void ServerSpawnBomb();
 
+	/** Returns true if this character is able to spawn the bomb on its current cell. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	bool CanSpawnBomb() const;
+
+	/** Increases +1 to numbers of character's powerups (Skate/Bomb/Fire) by given item type.
+	 * Is called by the item on the pickup step of the Grid Simulation Subsystem. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void PickUpItem(EItemType ItemType);
+
+	/** Overrides all powerups at once, e.g: on restoring the match snapshot. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void SetPowerups(const FPowerUp& NewPowerups);
+
+	/** Overrides the personal ID and possesses the controller of this ID, e.g: on respawning the player by the match snapshot. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void SetCharacterID(int32 NewCharacterID);
+
+	/** Registers given bomb as put by this character, so the bomb is returned to the character once it is deactivated.
+	 * Is tracked by the counter of own bombs instead of binding to the deactivation delegate of each bomb. */
+	void AddOwnBomb(class ABombActor& BombActor);
+
+	/** Is called by own bomb once it is deactivated to give the bomb back to this character, only bombs counted as own ones are given back. */
+	void ReturnOwnBomb();
+
 	/** Returns the Skeletal Mesh of bombers. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	class UMySkeletalMeshComponent* GetMySkeletalMeshComponent() const;
@@ -116,10 +151,22 @@ protected:
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Nameplate Mesh Component"))
 	TObjectPtr<class UStaticMeshComponent> NameplateMeshInternal = nullptr;
 
+	/** The nickname text on the nameplate, is drawn through the shared font atlas and updated only on nickname change.
+	 * @see UPlayerDataAsset::bTextNameplatesInternal */
+	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "C++", meta = (BlueprintProtected, DisplayName = "Nickname Text Component"))
+	TObjectPtr<class UTextRenderComponent> NicknameTextInternal = nullptr;
+
+	/** The nickname that is currently shown by the nickname text component, is used to skip the same updates. */
+	FName NicknameTextNameInternal = NAME_None;
+
 	/** Count of items that affect on a player during gameplay. Can be overriden by the Cheat Manager. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Transient, ReplicatedUsing = "OnRep_Powerups", Category = "C++", meta = (BlueprintProtected, DisplayName = "Powerups", ShowOnlyInnerProperties))
 	FPowerUp PowerupsInternal = FPowerUp::DefaultData;
 
+	/** The number of bombs put by this character that are not deactivated yet, is changed only on the server.
+	 * @see APlayerCharacter::AddOwnBomb */
+	int32 OwnBombsNumInternal = 0;
+
 	/** The ID identification of each character */
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, ReplicatedUsing = "OnRep_CharacterID", Category = "C++", meta = (BlueprintProtected, DisplayName = "Character ID"))
 	int32 CharacterIDInternal = INDEX_NONE;
@@ -132,6 +179,46 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, ReplicatedUsing = "OnRep_PlayerMeshData", Category = "C++", meta = (BlueprintProtected, DisplayName = "Player Mesh Data"))
 	FCustomPlayerMeshData PlayerMeshDataInternal = FCustomPlayerMeshData::Empty;
 
+	/** Is stored on the owning client for each predicted bomb until its authoritative bomb is replicated. */
+	struct FPredictedBomb
+	{
+		FCell Cell = FCell::InvalidCell;
+		TWeakObjectPtr<class UMeshComponent> VisualComponent = nullptr;
+		double PredictionTime = 0.0;
+
+		/** Is sent with the spawn request, so the server rejects exactly this prediction. */
+		uint8 PredictionId = 0;
+	};
+
+	/** Bombs that were placed locally, but are not confirmed by the server yet. */
+	TArray<FPredictedBomb> PredictedBombsInternal;
+
+	/** Checks predicted bombs while there are any of them. */
+	FTimerHandle PredictedBombsTimerInternal;
+
+	/** The id of the next predicted bomb, wraps around since only few requests could be in flight at once. */
+	uint8 NextBombPredictionIdInternal = 0;
+
+	/** Is stored on the server for each bomb that is requested, but is not spawned from the pool yet. */
+	struct FPendingBombSpawn
+	{
+		FCell Cell = FCell::InvalidCell;
+
+		/** The world time when the bomb was requested, the pending spawn is forgotten if it takes too long. */
+		double RequestTime = 0.0;
+	};
+
+	/** Bombs that are requested on the server, but are not spawned from the pool yet.
+	 * Each one takes the bomb from available ones and duplicated spawn requests are coalesced by its cell until the bomb occupies it. */
+	TArray<FPendingBombSpawn, TInlineAllocator<4>> PendingBombSpawnsInternal;
+
+	/** The pending spawn is forgotten if it was not completed in time, e.g: the cell became occupied before the bomb was taken from the pool. */
+	static constexpr double PendingBombTimeout = 0.5;
+
+	/** The last snapped cell index on the Generated Map, is used to skip movement updates that do not cross a cell boundary. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Tracked Cell Index"))
+	int32 TrackedCellIndexInternal = INDEX_NONE;
+
 	/** ---------------------------------------------------
 	 *		Protected functions
 	 * --------------------------------------------------- */
@@ -150,8 +237,20 @@ protected:
 	UFUNCTION()
 	void OnConstructionPlayerCharacter();
 
-	/** Called every frame, is disabled on start, tick interval is decreased. */
-	virtual void Tick(float DeltaTime) override;
+	/** Is bound to the character movement while in game to update a player cell on the Generated Map only when a cell boundary is crossed.
+	 * Is used instead of ticking every frame, others could listen UMapComponent::OnCellChanged to react on the cell change. */
+	UFUNCTION()
+	void OnCharacterMovementUpdatedCell(float DeltaSeconds, FVector OldLocation, FVector OldVelocity);
+
+	/** Picks up the item that lies on the cell the player has just stepped on.
+	 * Is resolved by the item bit of the grid instead of physics overlaps, so items don't need any collision.
+	 * The pickup is queued on the server to be ordered with other grid events, clients only play the sound. */
+	void PickUpItemOnCell(int32 CellIndex);
+
+	/** Starts or stops tracking a player cell on the Generated Map by character movement updates.
+	 * Is enabled on the server and on the owning client, where only pickup cosmetics are played. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void SetCellTrackingEnabled(bool bEnabled);
 
 	/** Returns properties that are replicated for the lifetime of the actor channel. */
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
@@ -162,23 +261,42 @@ protected:
 	/** Sets the actor to be hidden in the game. Alternatively used to avoid destroying. */
 	virtual void SetActorHiddenInGame(bool bNewHidden) override;
 
+	/** Is not relevant for spectators of the grid stream, they rebuild the level by grid events. */
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
 	/** Called when this Pawn is possessed. Only called on the server (or in standalone).
 	 * @param NewController The controller possessing this pawn. */
 	virtual void PossessedBy(AController* NewController) override;
 
-	/**
-	 * Triggers when this player character starts something overlap.
-	 * With item overlapping Increases +1 to numbers of character's powerups (Skate/Bomb/Fire).
-	 */
-	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
-	void OnPlayerBeginOverlap(AActor* OverlappedActor, AActor* OtherActor);
+	/** Shows local bomb on the cell and marks it as occupied on the Generated Map until the server confirms or rejects it.
+	 * @return The id of the prediction to be sent with the spawn request. */
+	uint8 PredictBomb(const FCell& Cell);
 
-	/** Event triggered when the bomb has been explicitly destroyed. */
-	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
-	void OnBombDestroyed(class UMapComponent* MapComponent, UObject* DestroyCauser = nullptr);
+	/** Removes predicted bombs that are confirmed by replicated bombs or not confirmed in time. */
+	void UpdatePredictedBombs();
 
-	/** Listen to manage the tick. */
-	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++", meta = (BlueprintProtected))
+	/** Removes the local visual and the predicted occupancy of given bomb.
+	 * @param bRollback If true, the prediction is cancelled on the Generated Map. */
+	void RemovePredictedBomb(int32 PredictedBombIndex, bool bRollback);
+
+	/** Returns the number of bombs that are requested on the server, but are not placed on their cells yet.
+	 * @param OnCell If valid, only the bomb pending on this cell is counted. */
+	int32 GetPendingBombSpawnsNum(const FCell& OnCell = FCell::InvalidCell) const;
+
+	/** Spawns bomb predicted by the owning client on character position, is sent only if the bomb was predicted. */
+	UFUNCTION(Server, Reliable)
+	void ServerSpawnPredictedBomb(uint8 PredictionId);
+
+	/** Spawns bomb on character position on the server.
+	 * @param PredictionId The id of the client prediction to be rejected if the bomb can't be spawned, INDEX_NONE if it was not predicted. */
+	void SpawnBombOnServer(int32 PredictionId);
+
+	/** Is called on the owning client when the server rejected its predicted bomb placing. */
+	UFUNCTION(Client, Reliable)
+	void ClientRejectSpawnBomb(uint8 PredictionId);
+
+	/** Listen to manage the cell tracking on the server and on the owning client. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void OnGameStateChanged(ECurrentGameState CurrentGameState);
 
 	/** Apply effect of picked up powerups. */
@@ -197,7 +315,15 @@ protected:
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "C++", meta = (BlueprintProtected))
 	void SetNicknameOnNameplate(FName NewName);
 
-	/** Updates collision object type by current character ID. */
+	/** Applies text nameplate settings: draws the nickname by text or by 3D widget components. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void InitNicknameText();
+
+	/** Sets new player name on the text nameplate, does nothing if the name is the same. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void SetNicknameText(FName NewName);
+
+	/** Updates collision object type to the shared player channel, is the same for any character ID. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void UpdateCollisionObjectType();
 
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "GameFramework/Actor.h"
+#include "Components/MapComponentOwner.h"
 //---
 #include "WallActor.generated.h"
 
@@ -11,7 +12,7 @@
  * @see Access its data with UWallDataAsset (Content/Bomber/DataAssets/DA_Wall).
  */
 UCLASS()
-class BOMBER_API AWallActor final : public AActor
+class BOMBER_API AWallActor final : public AActor, public IMapComponentOwner
 {
 	GENERATED_BODY()
 
@@ -19,6 +20,9 @@ public:
 	/** Sets default values for this actor's properties */
 	AWallActor();
 
+	/** Returns the map component of this actor, is created on its construction. */
+	virtual UMapComponent* GetOwnedMapComponent() const override;
+
 	/** Initialize a wall actor, could be called multiple times. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void ConstructWallActor();
@@ -49,4 +53,7 @@ protected:
 
 	/** Sets the actor to be hidden in the game. Alternatively used to avoid destroying. */
 	virtual void SetActorHiddenInGame(bool bNewHidden) override;
+
+	/** Is not relevant for spectators of the grid stream, they rebuild the level by grid events. */
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
 };
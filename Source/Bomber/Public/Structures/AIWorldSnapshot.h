@@ -0,0 +1,162 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Structures/Cell.h"
+#include "Structures/CellsBitboard.h"
+
+enum class EPathType : uint8;
+
+/**
+ * Number of free cells by each side of the cell until the safe path is broken by walls, boxes, bombs or explosions.
+ * Sides are ordered as Left, Right, Forward and Backward.
+ * @see FAIWorldSnapshot::CrosswayMap
+ */
+struct FCellCrossway
+{
+	/** Number of sides of the cell. */
+	static constexpr int32 SidesNum = 4;
+
+	/** Number of cells by each side, is limited by 255 cells. */
+	uint8 SideLengths[SidesNum] = {0, 0, 0, 0};
+
+	/** Returns true if the cell has any free neighbour by the side perpendicular to the line specified by the direction to another cell.
+	 * @param bHorizontalLine true if the line is the row (Left-Right), false if it is the column (Forward-Backward).
+	 * @param Radius Maximal number of cells to check by each side. */
+	FORCEINLINE bool HasPerpendicularSide(bool bHorizontalLine, int32 Radius) const
+	{
+		return Radius > 0 && (bHorizontalLine ? SideLengths[2] || SideLengths[3] : SideLengths[0] || SideLengths[1]);
+	}
+};
+
+/**
+ * Read-only copy of the level state that is shared by all bots during one AI update.
+ * Is built once by the Generated Map when the level state is changed, so bots don't re-derive the same walls, boxes, players and danger data.
+ * Does not reference any level actor, so it could be read outside of the Generated Map.
+ * Const functions only read the snapshot, so they could be called from worker threads on the copy taken by AGeneratedMap::GetSharedWorldSnapshot.
+ * @see AGeneratedMap::GetAIWorldSnapshot
+ */
+struct BOMBER_API FAIWorldSnapshot
+{
+	/** Returns true if the snapshot was built for the grid with at least one cell. */
+	FORCEINLINE bool IsValid() const { return GridCells.Num() > 0; }
+
+	/** Returns true if given row-major index belongs to the grid. */
+	FORCEINLINE bool IsValidIndex(int32 CellIndex) const { return GridCells.IsValidIndex(CellIndex); }
+
+	/** Returns the number of cells on the grid. */
+	FORCEINLINE int32 Num() const { return GridCells.Num(); }
+
+	/** Returns EActorType bitmask of level actors located on the cell by given index. */
+	FORCEINLINE int32 GetActorTypes(int32 CellIndex) const { return CellActorTypes.IsValidIndex(CellIndex) ? CellActorTypes[CellIndex] : 0; }
+
+	/** Returns true if the cell by given index has an actor of specified types, or is empty if none of types is specified. */
+	FORCEINLINE bool DoesCellMatchActorTypes(int32 CellIndex, int32 ActorsTypesBitmask) const;
+
+	/** Returns the number of steps from the cell by given index to the nearest reachable safe cell, INDEX_NONE if there is no way to be safe. */
+	FORCEINLINE int32 GetDistanceToSafety(int32 CellIndex) const { return DistancesToSafety.IsValidIndex(CellIndex) ? DistancesToSafety[CellIndex] : INDEX_NONE; }
+
+	/** Takes all the state from given Generated Map that is needed for bots. */
+	void Build(const class AGeneratedMap& GeneratedMap);
+
+	/** Takes the state from given board layout without any level, is used to measure bots on scripted boards.
+	 * The snapshot is built from scratch, detonation times are unknown for all dangerous cells.
+	 * @param InGridSize The number of columns (X) and rows (Y) of the board.
+	 * @param InCellActorTypes Dense row-major EActorType bitmask of each cell.
+	 * @param InDangerousCells Cells that are going to be exploded. */
+	void BuildFromLayout(const FIntPoint& InGridSize, TConstArrayView<uint8> InCellActorTypes, const FCellsBitboard& InDangerousCells);
+
+	/** Returns true if any cell is changed since given build in rows and columns around given cell.
+	 * Checked region is the cross by the row and the column of the cell widened by given radius to each side,
+	 * so it covers all cells that could be seen by the bot searching by sides from this cell.
+	 * @param SinceBuildNumber The BuildNumber of the snapshot the previous decision was made with. */
+	bool IsChangedAround(int32 CellIndex, int32 Radius, uint32 SinceBuildNumber) const;
+
+	/** Returns the distance in cells to the nearest threat (bomb, another player or dangerous cell) in the square around given cell.
+	 * @return 0 if the cell itself is dangerous or has a bomb, INDEX_NONE if there is no threat within given radius. */
+	int32 GetThreatDistance(int32 CellIndex, int32 MaxRadius) const;
+
+	/** Sets the bitboard to the cells by four sides of given center cell, same as UCellsUtilsLibrary::GetCellsAround but by the snapshot state. */
+	void GetCellsAround(FCellsBitboard& OutCells, int32 CellIndex, EPathType Pathfinder, int32 Radius) const;
+
+	/** Keeps in the bitboard only cells that match specified actor types, same as UCellsUtilsLibrary::FilterCellsByActors but by the snapshot state. */
+	void FilterCellsByActors(FCellsBitboard& InOutCells, int32 ActorsTypesBitmask) const;
+
+	/** Fills the number of steps by free cells from each cell to the nearest of given target cells by breadth-first search started from all targets at once.
+	 * Walls and boxes are never reached, bombs are reached but the path is not continued through them, INDEX_NONE is set for unreachable cells.
+	 * Is used both for the distance to safety and for grid navigation towards the destination cell. */
+	void BuildDistanceField(TArray<int32>& OutDistances, TConstArrayView<int32> TargetCellIndices) const;
+
+	/** Finds the soonest reachable cell that is not going to be exploded by time-expanded breadth-first search from given cell.
+	 * Each step the bot either moves to a free neighbour or waits, but never stays on the cell around its detonation time.
+	 * @param CellIndex The cell where the bot is located.
+	 * @param CurrentTime The world time in seconds to compare detonation times with.
+	 * @param SecondsPerCell How long the bot moves from one cell to another.
+	 * @param SafetyMargin Seconds before and after the detonation when the cell is not stepped on.
+	 * @param MaxSteps The maximal number of steps to search.
+	 * @return The row-major index of found safe cell, INDEX_NONE if there is no escape. */
+	int32 FindEscapeCell(int32 CellIndex, float CurrentTime, float SecondsPerCell, float SafetyMargin, int32 MaxSteps) const;
+
+	/** Sets the bitboard to the safe cells by four sides of given center cell taken from the crossway map,
+	 * is the same as GetCellsAround for EPathType::Safe without walking the grid. */
+	void GetSafeCellsAround(FCellsBitboard& OutCells, int32 CellIndex, int32 Radius) const;
+
+	/** Returns the crossway classification of the cell by given index. */
+	FORCEINLINE const FCellCrossway& GetCrossway(int32 CellIndex) const { return CrosswayMap[CellIndex]; }
+
+	/** Copy of all cells on the grid, where array index is the row-major index of the cell. */
+	TArray<FCell> GridCells;
+
+	/** The number of columns (X) and rows (Y) of the grid. */
+	FIntPoint GridSize = FIntPoint::ZeroValue;
+
+	/** Dense row-major EActorType bitmask of each cell. */
+	TArray<uint8> CellActorTypes;
+
+	/** Cells that are going to be exploded by bombs or marked as dangerous from outside. */
+	FCellsBitboard DangerousCells;
+
+	/** Dense row-major world time when each cell is exploded by the earliest bomb,
+	 * MAX_flt if the time is unknown (bomb timer is not started or the cell is marked as dangerous from outside) or if the cell is not dangerous. */
+	TArray<float> DetonationTimes;
+
+	/** The number of alive players on the level, is the number of cells with players if the snapshot is built from a layout. */
+	int32 PlayersNum = 0;
+
+	/** Dense row-major number of steps by free cells to the nearest safe cell, INDEX_NONE for unreachable or blocked cells. */
+	TArray<int32> DistancesToSafety;
+
+	/** Dense row-major lengths of safe sides of each cell.
+	 * Is updated incrementally on each build: only rows and columns of cells where walls, boxes, bombs or explosions are changed are walked again. */
+	TArray<FCellCrossway> CrosswayMap;
+
+	/** Is incremented on each build, even if only outside dangerous cells are changed. */
+	uint32 BuildNumber = 0;
+
+	/** The last BuildNumber when any cell in each row was changed. */
+	TArray<uint32> RowChangedBuilds;
+
+	/** The last BuildNumber when any cell in each column was changed. */
+	TArray<uint32> ColumnChangedBuilds;
+
+	/** Version of the level state this snapshot was built from, @see AGeneratedMap::GetAIWorldSnapshot. */
+	uint32 StateVersion = 0;
+
+protected:
+	/** Updates the crossway map by comparing given previous state with the current one.
+	 * @param PrevSafeBreaks Previous dense row-major flags whether the safe path is broken on the cell, is empty to rebuild the whole map. */
+	void UpdateCrosswayMap(const TBitArray<>& PrevSafeBreaks);
+
+	/** Returns true if the safe path is broken on the cell by given index. */
+	bool IsSafeBreak(int32 CellIndex) const;
+
+	/** Fills distances to the nearest safe cell by breadth-first search started from all safe cells at once. */
+	void BuildDistancesToSafety();
+};
+
+// Returns true if the cell by given index has an actor of specified types, or is empty if none of types is specified
+bool FAIWorldSnapshot::DoesCellMatchActorTypes(int32 CellIndex, int32 ActorsTypesBitmask) const
+{
+	const int32 ActorTypesOnCell = GetActorTypes(CellIndex);
+	return ActorsTypesBitmask ? (ActorTypesOnCell & ActorsTypesBitmask) != 0 : ActorTypesOnCell == 0;
+}
@@ -0,0 +1,53 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Structures/Cell.h"
+//---
+#include "BombExplosion.generated.h"
+
+/**
+ * Compact description of the blast of one bomb, is enough to rebuild its explosion cells on any side.
+ * Is sent by the chain-reaction resolver for all triggered bombs at once,
+ * so it is serialized as a packed grid index and four ray lengths instead of an array of cells.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FBombExplosion
+{
+	GENERATED_BODY()
+
+	/** Number of rays of each blast: Left, Right, Forward, Backward. */
+	static constexpr int32 RaysNum = 4;
+
+	/** Default constructor. */
+	FBombExplosion() = default;
+
+	/** Casts the blast on the given level from the specified cell by given radius. */
+	FBombExplosion(const class AGeneratedMap& GeneratedMap, const FCell& InOrigin, int32 InRadius);
+
+	/** Row-major index of the cell where the bomb was placed. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "C++")
+	int32 OriginIndex = INDEX_NONE;
+
+	/** Number of exploded cells on each side without a center: Left, Right, Forward, Backward. */
+	UPROPERTY(VisibleAnywhere, Category = "C++")
+	uint8 RayLengths[RaysNum] = {0, 0, 0, 0};
+
+	/** Returns true if the blast was cast on the level. */
+	FORCEINLINE bool IsValid() const { return OriginIndex != INDEX_NONE; }
+
+	/** Returns cells that are exploded by this blast on the given level, the center included. */
+	FCells GetExplosionCells(const class AGeneratedMap& GeneratedMap) const;
+
+	/** Packs the grid index and ray lengths to be sent over network. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+/**
+ * Enables custom network serialization for FBombExplosion.
+ */
+template <>
+struct BOMBER_API TStructOpsTypeTraits<FBombExplosion> : public TStructOpsTypeTraitsBase2<FBombExplosion>
+{
+	enum { WithNetSerializer = true };
+};
@@ -7,6 +7,9 @@
 /** Typedef to allow for some nicer looking sets of cells. */
 typedef TSet<struct FCell> FCells;
 
+/** Typedef for sets of a few cells like a single cell or the result of one direction, up to 8 cells are kept inline without heap allocations. */
+typedef TSet<struct FCell, DefaultKeyFuncs<struct FCell>, TInlineSetAllocator<8>> FSmallCells;
+
 /**
  * Represents one of direction of a cell.
  */
@@ -112,21 +115,42 @@ public:
 	 * @param OriginTransform its location and rotation is the center of new grid, its scale-X is number of columns, scale-Y is number of rows. */
 	static TSet<FCell> MakeCellGridByTransform(const FTransform& OriginTransform);
 
+	/** Batch version that constructs new grid into the dense row-major array, where the cell of column X and row Y is at index Y * Width + X.
+	 * Only the first cell is snapped, others are its offsets by the rotated basis of columns and rows, so no cell is rotated by its own. */
+	static void MakeCellGridByTransform(const FTransform& OriginTransform, TArray<FCell>& OutGrid);
+
+	/** Returns the first cell (column 0, row 0) of the grid constructed from given transform before the grid is rotated around its origin.
+	 * Is the first cell of the row-major array as it is for unrotated grids. */
+	static FCell GetUnrotatedFirstCellByTransform(const FTransform& OriginTransform);
+
+	/** Moves all cells of given row-major grid by the same offset in place.
+	 * Is the cheap way to rebuild the unrotated grid when only its location is changed, since its size and cell order stay the same. */
+	static void TranslateCellGrid(TArrayView<FCell> InOutGrid, const FVector& Offset);
+
 	/** Returns the cell by specified column (X) and row (Y) on given grid if exists, invalid cell otherwise. */
 	static FCell GetCellByPositionOnGrid(const FIntPoint& CellPosition, const FCells& InGrid);
 
+	/** Returns the cell by specified column (X) and row (Y) on given row-major grid of known width in O(1), invalid cell otherwise.
+	 * Is used for grids that are already arrays like the level grid, so the grid is neither copied nor measured. */
+	static FCell GetCellByPositionOnGrid(const FIntPoint& CellPosition, TConstArrayView<FCell> InGrid, int32 GridWidth);
+
 	/** Takes the cell and returns its column (X) and row (Y) position on given grid if exists, -1 otherwise. */
 	static FIntPoint GetPositionByCellOnGrid(const FCell& InCell, const FCells& InGrid);
 
+	/** Takes the cell and returns its column (X) and row (Y) position on given row-major grid of known width if exists, -1 otherwise. */
+	static FIntPoint GetPositionByCellOnGrid(const FCell& InCell, TConstArrayView<FCell> InGrid, int32 GridWidth);
+
 	/** Returns the center column (X) and row (Y) position on given grid.
 	 * E.g: for grid with 5 rows and 5 columns, the center cell will be (2,2). */
 	static FIntPoint GetCenterCellPositionOnGrid(const FCells& InGrid);
 
 	/** Returns 4 corner cells on given cells grid. */
 	static FCells GetCornerCellsOnGrid(const FCells& InGrid);
+	static FCells GetCornerCellsOnGrid(TConstArrayView<FCell> InGrid, int32 GridWidth);
 
 	/** Returns specified corner cell in given grid. */
 	static FCell GetCellByCornerOnGrid(EGridCorner CornerType, const FCells& InGrid);
+	static FCell GetCellByCornerOnGrid(EGridCorner CornerType, TConstArrayView<FCell> InGrid, int32 GridWidth);
 
 	/** Scales specified cell maintaining relative distance from the corners of the new grid.
 	 * @param OriginalCell The cell to scale.
@@ -134,8 +158,13 @@ public:
 	 * @return scaled cell, is not aligned to any existed cell, make sure to snap it to the grid. */
 	static FCell ScaleCellToNewGrid(const FCell& OriginalCell, const FCells& NewCornerCells);
 
-	/** Extracts first cell from specified cells set.*/
-	static FORCEINLINE FCell GetFirstCellInSet(const FCells& InCells) { return !InCells.IsEmpty() ? InCells.Array()[0] : InvalidCell; }
+	/** Extracts first cell from specified cells set, is read by the iterator without copying the set into the array. */
+	template <typename SetAllocator>
+	static FORCEINLINE FCell GetFirstCellInSet(const TSet<FCell, DefaultKeyFuncs<FCell>, SetAllocator>& InCells)
+	{
+		const auto It = InCells.CreateConstIterator();
+		return It ? *It : InvalidCell;
+	}
 
 	/** Gets a copy of given cell snapped its location to a grid while it does not respect rotated grids. */
 	static FORCEINLINE FCell SnapCell(const FCell& InCell) { return InCell.Location.GridSnap(CellSize); }
@@ -148,6 +177,9 @@ public:
 	static FTransform GetCellArrayTransform(const FCells& InCells);
 	static FTransform GetCellArrayTransformNoScale(const FCells& InCells);
 
+	/** Makes origin transform without scale for given row-major grid, is the same as for its set but the grid is not copied into the set. */
+	static FTransform GetGridTransformNoScale(TConstArrayView<FCell> InGrid);
+
 	/** Find the average of an set of cells. */
 	static FCell GetCellArrayCenter(const FCells& Cells);
 
@@ -160,6 +192,9 @@ public:
 	static float GetCellArrayWidth(const FCells& InCells);
 	static float GetCellArrayLength(const FCells& InCells);
 
+	/** Returns the bounding box of given cells when their grid is unrotated, cells are rotated one by one without copying the set. */
+	static FBox GetCellArrayUnrotatedBox(const FCells& InCells);
+
 	/*********************************************************************************************
 	 * Distance
 	 ********************************************************************************************* */
@@ -168,9 +203,13 @@ public:
 	template <typename T>
 	static FORCEINLINE T Distance(const FCell& C1, const FCell& C2) { return FMath::Abs<T>((C1.Location - C2.Location).Size()) / CellSize; }
 
-	/** Find the max distance between cells within specified set, where each 1 unit means one cell. */
+	/** Find the max distance between cells within specified set, where each 1 unit means one cell.
+	 * Is linear: only the leftmost and rightmost cells of each row are compared, since the farthest pair is always among them. */
 	template <typename T>
-	static T GetCellArrayMaxDistance(const FCells& Cells);
+	static T GetCellArrayMaxDistance(const FCells& Cells) { return static_cast<T>(GetCellArrayMaxLength(Cells) / CellSize); }
+
+	/** Returns the max distance in units between cells within specified set, @see FCell::GetCellArrayMaxDistance. */
+	static double GetCellArrayMaxLength(const FCells& Cells);
 
 	/*********************************************************************************************
 	 * Math operators
@@ -198,9 +237,15 @@ public:
 	FORCEINLINE FCell operator*(FArg Scale) const { return FCell(Location * Scale); }
 
 	/** Creates a hash value from a FCell.
+	 * Components are rounded by constructors, so integers are hashed instead of CRC of three doubles,
+	 * it also gives the same hash for equal -0 and +0 components.
 	 * @param Vector the cell to create a hash value for
 	 * @return The hash value from the components. */
-	friend FORCEINLINE uint32 GetTypeHash(const FCell& Vector) { return GetTypeHash(Vector.Location); }
+	friend FORCEINLINE uint32 GetTypeHash(const FCell& Vector)
+	{
+		const uint32 HashXY = HashCombineFast(::GetTypeHash(FMath::FloorToInt32(Vector.Location.X)), ::GetTypeHash(FMath::FloorToInt32(Vector.Location.Y)));
+		return HashCombineFast(HashXY, ::GetTypeHash(FMath::FloorToInt32(Vector.Location.Z)));
+	}
 
 	/*********************************************************************************************
 	 * Conversion
@@ -223,23 +268,20 @@ public:
 	/** Converts set of cells to array of vectors and vice versa. */
 	static TArray<FVector> CellsToVectors(const FCells& Cells);
 	static FCells VectorsToCells(const TArray<FVector>& Vectors);
+
+	/*********************************************************************************************
+	 * Network
+	 ********************************************************************************************* */
+public:
+	/** Writes integral components as packed integers instead of three doubles, falls back to full precision for not rounded cells. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
 };
 
-// Find the max distance between cells within specified set, where each 1 unit means one cell
-template <typename T>
-T FCell::GetCellArrayMaxDistance(const FCells& Cells)
+/**
+ * Enables custom network serialization for FCell.
+ */
+template <>
+struct BOMBER_API TStructOpsTypeTraits<FCell> : public TStructOpsTypeTraitsBase2<FCell>
 {
-	T MaxDistance{};
-	for (const FCell& C1 : Cells)
-	{
-		for (const FCell& C2 : Cells)
-		{
-			const T LengthIt = FCell::Distance<T>(C1, C2);
-			if (LengthIt > MaxDistance)
-			{
-				MaxDistance = LengthIt;
-			}
-		}
-	}
-	return MaxDistance;
-}
+	enum { WithNetSerializer = true, WithNetSharedSerialization = true };
+};
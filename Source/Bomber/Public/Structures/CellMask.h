@@ -0,0 +1,35 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Structures/CellsBitboard.h"
+//---
+#include "CellMask.generated.h"
+
+/**
+ * Blueprint handle of the set of cells on the level grid, where each cell is one bit by its row-major index.
+ * Unlike TSet<FCell>, union, intersection and counting are word-wise operations without hashing,
+ * so chained queries like 'Get Cells Around' -> 'Filter By Actors' don't allocate sets on each node.
+ * Cells are converted to the array only on demand, e.g: to display or iterate them.
+ * Is valid only for the grid it was created on, so it should not be kept after the level is resized.
+ * @see UCellsUtilsLibrary
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FCellMask
+{
+	GENERATED_BODY()
+
+	/** Default constructor. */
+	FCellMask() = default;
+
+	/** Creates the mask of specified number of cells where each cell is set to given value. */
+	explicit FCellMask(int32 CellsNum, bool bValue = false)
+		: Bitboard(CellsNum, bValue) {}
+
+	/** Creates the mask from given bitboard. */
+	explicit FCellMask(FCellsBitboard&& InBitboard)
+		: Bitboard(MoveTemp(InBitboard)) {}
+
+	/** Bits of contained cells, where index of each bit is the index of the cell on the grid. */
+	FCellsBitboard Bitboard;
+};
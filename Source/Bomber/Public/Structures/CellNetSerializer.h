@@ -0,0 +1,27 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#if UE_WITH_IRIS
+#include "Iris/Serialization/NetSerializer.h"
+#endif // UE_WITH_IRIS
+//---
+#include "CellNetSerializer.generated.h"
+
+#if UE_WITH_IRIS
+/**
+ * Config of the Iris serializer of FCell, has no settings.
+ * Iris is used instead of the legacy replication when 'net.Iris.UseIrisReplication' is enabled.
+ */
+USTRUCT()
+struct FCellNetSerializerConfig : public FNetSerializerConfig
+{
+	GENERATED_BODY()
+};
+
+namespace UE::Net
+{
+	/** Writes integral components as packed integers like FCell::NetSerialize, but natively for the Iris replication. */
+	UE_NET_DECLARE_SERIALIZER(FCellNetSerializer, BOMBER_API);
+}
+#endif // UE_WITH_IRIS
@@ -0,0 +1,54 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "HAL/LowLevelMemTracker.h"
+#include "Structures/Cell.h"
+
+/** Tag of all cells that are allocated by the grid API, is shown by running with -LLM and 'stat LLMFULL'. */
+LLM_DECLARE_TAG_API(Bomber_Cells, BOMBER_API);
+
+/**
+ * Functions of the grid API that return new cells by value.
+ */
+enum class ECellsAllocationSource : uint8
+{
+	GetCellsAround,
+	FilterCellsByActors,
+	GetAllCellsWithActors,
+	GetExplosionCells,
+	RotateCellArray,
+	Conv_CellMaskToCells,
+	Num
+};
+
+/**
+ * Counts cells that are returned by value from the grid API, so hot allocations of temporary cells could be found and compared with allocation-free APIs.
+ * Allocations are taken from heap blocks that are owned by each returned set: its elements, its allocation flags and its hash,
+ * so reserved but empty sets are counted too, while small sets with inline flags and hash count only their elements.
+ * Is disabled by default, is enabled by 'Bomber.Cells.TrackAllocations 1', results are printed by 'Bomber.Cells.DumpAllocations [Seconds]'.
+ */
+struct BOMBER_API FCellsAllocationTracker
+{
+	/** The longest time in seconds that is kept for dumping. */
+	static constexpr int32 MaxTrackedSeconds = 60;
+
+	/** Returns true if returned cells are counted. */
+	static bool IsEnabled();
+
+	/** Counts the returned cells of given function with heap blocks and bytes they own, is ignored outside of the game thread. */
+	static void AddResult(ECellsAllocationSource Source, const FCells& Cells);
+
+	/** Returns the number of heap blocks owned by given set according to the default set allocator. */
+	static int32 GetHeapAllocationsNum(const FCells& Cells);
+
+	/** Logs the number of calls, allocating calls and cells of each function during the last given seconds. */
+	static void Dump(int32 Seconds);
+};
+
+/** Is written in the function of the grid API that returns cells by value to tag its allocations. */
+#define CELLS_ALLOCATION_SCOPE() LLM_SCOPE_BYTAG(Bomber_Cells)
+
+/** Is written right before returning cells of the grid API by value. */
+#define TRACK_CELLS_ALLOCATION(Source, Cells) \
+	do { if (FCellsAllocationTracker::IsEnabled()) { FCellsAllocationTracker::AddResult(ECellsAllocationSource::Source, (Cells)); } } while (0)
@@ -0,0 +1,79 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Containers/BitArray.h"
+
+/** Typedef for row-major indices of cells found on the grid, small results are kept on the stack without heap allocations. */
+typedef TArray<int32, TInlineAllocator<32>> FCellIndices;
+
+/**
+ * Dense set of cells on the grid where each bit represents one cell by its row-major index.
+ * Is used by the Generated Map to keep occupancy of each actor type,
+ * so queries by multiple types are word-wise AND/OR operations instead of building cell sets.
+ */
+struct BOMBER_API FCellsBitboard
+{
+	/** Default constructor. */
+	FCellsBitboard() = default;
+
+	/** Creates bitboard for specified number of cells where each bit is set to given value. */
+	explicit FCellsBitboard(int32 InCellsNum, bool bValue = false);
+
+	/** Resets the bitboard to specified number of cells where each bit is set to given value. */
+	void Init(int32 InCellsNum, bool bValue = false) { Bits.Init(bValue, InCellsNum); }
+
+	/** Returns the number of cells (bits) in this bitboard. */
+	FORCEINLINE int32 Num() const { return Bits.Num(); }
+
+	/** Returns true if the cell by given index is contained in this bitboard. */
+	FORCEINLINE bool IsSet(int32 CellIndex) const { return Bits.IsValidIndex(CellIndex) && Bits[CellIndex]; }
+
+	/** Adds or removes the cell by given index. */
+	FORCEINLINE void SetBit(int32 CellIndex, bool bValue) { Bits[CellIndex] = bValue; }
+
+	/** Returns true if none of cells is contained. */
+	FORCEINLINE bool IsEmpty() const { return Bits.Find(true) == INDEX_NONE; }
+
+	/** Returns the number of contained cells. */
+	FORCEINLINE int32 CountSetBits() const { return Bits.CountSetBits(); }
+
+	/** Returns the heap memory used by the bits. */
+	FORCEINLINE SIZE_T GetAllocatedSize() const { return Bits.GetAllocatedSize(); }
+
+	/** Returns the lowest contained cell index in given inclusive range, INDEX_NONE if there is no such cell.
+	 * Scans whole 32-bit words by the bit scan, so a ray along the bitboard takes a few instructions instead of a check per cell. */
+	int32 FindFirstSetBit(int32 StartIndex, int32 EndIndex) const;
+
+	/** Returns the highest contained cell index in given inclusive range, INDEX_NONE if there is no such cell. */
+	int32 FindLastSetBit(int32 StartIndex, int32 EndIndex) const;
+
+	/** Union of bitboards. */
+	FCellsBitboard& operator|=(const FCellsBitboard& Other);
+
+	/** Intersection of bitboards. */
+	FCellsBitboard& operator&=(const FCellsBitboard& Other);
+
+	/** Difference of bitboards, so cells contained in other bitboard are removed from this one. */
+	FCellsBitboard& Subtract(const FCellsBitboard& Other);
+
+	/** Inverts all bits, so contained cells become not contained and vice versa. */
+	void Invert() { Bits.BitwiseNOT(); }
+
+	/** Calls given function for each contained cell index. */
+	template <typename FunctorType>
+	void ForEachSetBit(FunctorType&& Func) const;
+
+	/** Underlying bits, where index of each bit is the index of the cell on the grid. */
+	TBitArray<> Bits;
+};
+
+// Calls given function for each contained cell index
+template <typename FunctorType>
+void FCellsBitboard::ForEachSetBit(FunctorType&& Func) const
+{
+	for (TConstSetBitIterator<> It(Bits); It; ++It)
+	{
+		Func(It.GetIndex());
+	}
+}
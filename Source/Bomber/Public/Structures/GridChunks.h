@@ -0,0 +1,93 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Structures/CellsBitboard.h"
+
+/**
+ * Splits the grid into fixed square chunks of 8x8 cells, so each chunk keeps the occupancy of one actor type in a single 64-bit word.
+ * Area queries touch only overlapping chunks and skip whole chunks without requested types,
+ * the same chunks are used by instanced meshes to cull and rebuild walls and boxes per chunk and by the replication graph as relevancy buckets.
+ * Is kept by the Generated Map in step with its per-cell occupancy.
+ */
+struct BOMBER_API FGridChunks
+{
+	/** The length of the chunk side in cells, so all cells of the chunk fit one 64-bit word. */
+	static constexpr int32 ChunkSize = 8;
+
+	/** Number of actor types in EActorType::All, each of them has own word per chunk. */
+	static constexpr int32 ActorTypesNum = 5;
+
+	/** Resets all chunks to empty ones by given number of columns (X) and rows (Y) of the grid. */
+	void Init(const FIntPoint& InGridSize);
+
+	/** Returns the number of chunks. */
+	FORCEINLINE int32 Num() const { return ChunksSize.X * ChunksSize.Y; }
+
+	/** Returns the heap memory used by occupancy words of all chunks. */
+	FORCEINLINE SIZE_T GetAllocatedSize() const { return ChunkBits.GetAllocatedSize(); }
+
+	/** Returns the number of chunk columns (X) and rows (Y). */
+	FORCEINLINE const FIntPoint& GetChunksSize() const { return ChunksSize; }
+
+	/** Returns the chunk coordinate of given row-major cell index, or INDEX_NONE point if the cell is not on the grid. */
+	FIntPoint GetChunkCoord(int32 CellIndex) const;
+
+	/** Returns the row-major chunk index of given row-major cell index, or INDEX_NONE if the cell is not on the grid. */
+	int32 GetChunkIndex(int32 CellIndex) const;
+
+	/** Sets the occupancy of given cell by specified EActorType bitmask. */
+	void SetCellActorTypes(int32 CellIndex, int32 ActorTypesBitmask);
+
+	/** Returns bits of cells of the chunk that have actors of specified types (any of them if more than one type is set), bit index is 'LocalY * ChunkSize + LocalX'. */
+	uint64 GetChunkBits(int32 ChunkIndex, int32 ActorsTypesBitmask) const;
+
+	/** Calls given function for each row-major cell index within inclusive rect of cells that has an actor of specified types.
+	 * Chunks that are not overlapped by the rect or do not contain any of types are skipped without visiting their cells. */
+	template <typename FunctorType>
+	void ForEachCellInRect(const FIntRect& CellsRect, int32 ActorsTypesBitmask, FunctorType&& Func) const;
+
+protected:
+	/** Cached number of columns (X) and rows (Y) of the grid. */
+	FIntPoint GridSize = FIntPoint::ZeroValue;
+
+	/** Cached number of chunk columns (X) and rows (Y). */
+	FIntPoint ChunksSize = FIntPoint::ZeroValue;
+
+	/** Occupancy words of all chunks, where index is ChunkIndex * ActorTypesNum + bit index of the type. */
+	TArray<uint64> ChunkBits;
+};
+
+// Calls given function for each row-major cell index within inclusive rect of cells that has an actor of specified types
+template <typename FunctorType>
+void FGridChunks::ForEachCellInRect(const FIntRect& CellsRect, int32 ActorsTypesBitmask, FunctorType&& Func) const
+{
+	const FIntPoint MinCell(FMath::Max(CellsRect.Min.X, 0), FMath::Max(CellsRect.Min.Y, 0));
+	const FIntPoint MaxCell(FMath::Min(CellsRect.Max.X, GridSize.X - 1), FMath::Min(CellsRect.Max.Y, GridSize.Y - 1));
+	if (MinCell.X > MaxCell.X
+	    || MinCell.Y > MaxCell.Y)
+	{
+		return;
+	}
+
+	for (int32 ChunkY = MinCell.Y / ChunkSize; ChunkY <= MaxCell.Y / ChunkSize; ++ChunkY)
+	{
+		for (int32 ChunkX = MinCell.X / ChunkSize; ChunkX <= MaxCell.X / ChunkSize; ++ChunkX)
+		{
+			uint64 Bits = GetChunkBits(ChunkY * ChunksSize.X + ChunkX, ActorsTypesBitmask);
+			while (Bits)
+			{
+				const int32 LocalIndex = static_cast<int32>(FMath::CountTrailingZeros64(Bits));
+				Bits &= Bits - 1;
+
+				const int32 X = ChunkX * ChunkSize + LocalIndex % ChunkSize;
+				const int32 Y = ChunkY * ChunkSize + LocalIndex / ChunkSize;
+				if (X >= MinCell.X && X <= MaxCell.X
+				    && Y >= MinCell.Y && Y <= MaxCell.Y)
+				{
+					Func(Y * GridSize.X + X);
+				}
+			}
+		}
+	}
+}
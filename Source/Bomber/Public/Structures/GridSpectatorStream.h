@@ -0,0 +1,95 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/GridReplaySubsystem.h"
+//---
+#include "GridSpectatorStream.generated.h"
+
+/**
+ * The state of the grid the spectator starts watching from.
+ * Is the bitmask of actor types of each cell, so the whole level takes one byte per cell instead of replicated level actors.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridSpectatorLayout
+{
+	GENERATED_BODY()
+
+	/** The number of columns (X) and rows (Y) of the grid. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	FIntPoint GridSize = FIntPoint::ZeroValue;
+
+	/** The simulation step the layout is taken on, events of next steps are applied on top of it. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	int64 Step = 0;
+
+	/** EActorType bitmask of each cell by its row-major index. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	TArray<uint8> CellActorTypes;
+
+	/** Returns true if the layout is taken from the grid. */
+	FORCEINLINE bool IsValid() const { return !CellActorTypes.IsEmpty() && CellActorTypes.Num() == GridSize.X * GridSize.Y; }
+};
+
+/**
+ * The ordered batch of grid events sent to spectators at once, is usually the result of one simulation step.
+ * Is serialized the same packed way as the replay file, so most of events take a few bytes.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridSpectatorEvents
+{
+	GENERATED_BODY()
+
+	/** Events in the order of happening. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	TArray<FGridReplayEvent> Events;
+
+	/** Packs steps as deltas and indices as shifted integers to be sent over network. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct BOMBER_API TStructOpsTypeTraits<FGridSpectatorEvents> : public TStructOpsTypeTraitsBase2<FGridSpectatorEvents>
+{
+	enum { WithNetSerializer = true };
+};
+
+/**
+ * The position of one player sent to spectators.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridSpectatorPlayer
+{
+	GENERATED_BODY()
+
+	/** The ID of the character. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	int32 CharacterID = INDEX_NONE;
+
+	/** The location of the character on the level. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	FVector Location = FVector::ZeroVector;
+};
+
+/**
+ * Positions of all alive players sent to spectators at reduced frequency, clients interpolate between them.
+ * The grid lies on the horizontal plane, so only X and Y are sent rounded to centimeters.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridSpectatorPlayers
+{
+	GENERATED_BODY()
+
+	/** Alive players of the match. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	TArray<FGridSpectatorPlayer> Players;
+
+	/** Packs IDs and planar locations to be sent over network. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct BOMBER_API TStructOpsTypeTraits<FGridSpectatorPlayers> : public TStructOpsTypeTraitsBase2<FGridSpectatorPlayers>
+{
+	enum { WithNetSerializer = true };
+};
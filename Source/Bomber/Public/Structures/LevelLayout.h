@@ -0,0 +1,51 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Bomber.h"
+
+/**
+ * Compact binary layout of the level that could be shared as a file, e.g: by community maps:
+ * - Header: magic, version, grid size, level type and generation seed.
+ * - Body: EActorType of each cell in row-major order compressed by runs of the same type.
+ * Typical level takes few dozens of bytes, it is read by one bulk read and spawned by the Generated Map without any generation.
+ * @see AGeneratedMap::ImportLevelLayout()
+ */
+struct BOMBER_API FLevelLayout
+{
+	/** 'BMLL' that starts each layout file. */
+	static constexpr uint32 Magic = 0x4C4C4D42;
+
+	/** Is incremented on each change of the format. */
+	static constexpr uint16 Version = 1;
+
+	/** The extension of layout files. */
+	static const TCHAR* FileExtension;
+
+	/** The number of columns and rows. */
+	FIntPoint Size = FIntPoint::ZeroValue;
+
+	/** The level type to apply. */
+	ELevelType LevelType = ELevelType::None;
+
+	/** The generation seed to keep seeded randomness of the match the same. */
+	int32 Seed = 0;
+
+	/** EActorType of each cell in row-major order. */
+	TArray<uint8> ActorTypes;
+
+	/** Returns true if the layout has a type for each cell of its size. */
+	bool IsValid() const;
+
+	/** Returns true if given value is none or only one of the actor types. */
+	static bool IsValidActorType(uint8 ActorType);
+
+	/** Writes or reads the layout, returns false if read data is not a valid layout. */
+	bool Serialize(FArchive& Ar);
+
+	/** Writes the layout to given file, returns false if is not written. */
+	bool SaveToFile(const FString& FilePath);
+
+	/** Reads the layout from given file by one bulk read, returns false if the file is missing or is not a valid layout. */
+	bool LoadFromFile(const FString& FilePath);
+};
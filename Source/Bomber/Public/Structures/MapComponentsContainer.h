@@ -4,6 +4,7 @@
 
 #include "Net/Serialization/FastArraySerializer.h"
 //---
+#include "Bomber.h"
 #include "Cell.h"
 #include "PoolManagerTypes.h" // FPoolObjectHandle
 //---
@@ -18,6 +19,7 @@
 
 struct FMapComponentsContainer;
 
+class AGeneratedMap;
 class UMapComponent;
 
 /**
@@ -48,6 +50,20 @@ struct BOMBER_API FMapComponentSpec : public FFastArraySerializerItem
 	 * Is NOT replicated and exists only on the server side. */
 	FPoolObjectHandle PoolObjectHandle = FPoolObjectHandle::EmptyHandle;
 
+	/** The type of the map component owner.
+	 * Is replicated together with the cell, so clients know the occupancy even before the map component is resolved. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "C++")
+	EActorType ActorType = EActorType::None;
+
+	/** Cell index and actor type by which this spec is counted in the client occupancy mirror of the Generated Map.
+	 * Allow to remove its previous contribution on change or removal, so only cells of this spec are updated.
+	 * Are NOT replicated and are set only on the client side. */
+	int32 MirroredCellIndex = INDEX_NONE;
+	EActorType MirroredActorType = EActorType::None;
+
+	/** Is true while this spec is counted by its container as not resolved yet on the client side, is NOT replicated. */
+	bool bCountedUnresolved = false;
+
 	/** Updates the cell of the map component according current data.
 	 * Allows to set the cell much faster than waiting for its replication. */
 	void UpdateCellInComponent();
@@ -55,13 +71,17 @@ struct BOMBER_API FMapComponentSpec : public FFastArraySerializerItem
 	/** Returns if current data is valid. If not, probably it's pending spawn or not replicated yet. */
 	bool IsValid() const { return MapComponent != nullptr; }
 
+	/** Writes the cell as its index on the grid and the actor type in few bits instead of the full cell.
+	 * Falls back to the full cell if it is not found on the grid. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 	/*********************************************************************************************
 	 * FFastArraySerializerItem implementation
 	 ********************************************************************************************* */
 
-	void PreReplicatedRemove(const FMapComponentsContainer& InMapComponentsContainer) { UpdateCellInComponent(); }
-	void PostReplicatedAdd(const FMapComponentsContainer& InMapComponentsContainer) { UpdateCellInComponent(); }
-	void PostReplicatedChange(const FMapComponentsContainer& InMapComponentsContainer) { UpdateCellInComponent(); }
+	void PreReplicatedRemove(const FMapComponentsContainer& InMapComponentsContainer);
+	void PostReplicatedAdd(const FMapComponentsContainer& InMapComponentsContainer);
+	void PostReplicatedChange(const FMapComponentsContainer& InMapComponentsContainer);
 
 	/*********************************************************************************************
 	 * Convenience operators to treat FMapComponentSpec as a UMapComponent*
@@ -73,6 +93,15 @@ struct BOMBER_API FMapComponentSpec : public FFastArraySerializerItem
 	friend BOMBER_API bool operator==(const FMapComponentSpec& A, const FPoolObjectHandle& B) { return A.PoolObjectHandle == B; }
 };
 
+/**
+ * Enables custom network serialization for FMapComponentSpec.
+ */
+template <>
+struct BOMBER_API TStructOpsTypeTraits<FMapComponentSpec> : public TStructOpsTypeTraitsBase2<FMapComponentSpec>
+{
+	enum { WithNetSerializer = true };
+};
+
 /**
  * Iterator structure for FMapComponentsContainer, designed to simplify the traversal of the container's items.
  * Facilitates cleaner and safer access to elements.
@@ -99,6 +128,7 @@ public:
  * to utilize Unreal's fast array serialization mechanics. This ensures reliable network replication 
  * even when the number of components in the array remains unchanged.
  * PostReplicatedChange can be added to handle custom logic after the array has been replicated.
+ * Iris replicates it by its native fast array fragment with the same item callbacks, so NetDeltaSerialize is used only by the legacy replication.
  */
 USTRUCT(BlueprintType)
 struct BOMBER_API FMapComponentsContainer : public FFastArraySerializer
@@ -114,7 +144,7 @@ struct BOMBER_API FMapComponentsContainer : public FFastArraySerializer
 	 ********************************************************************************************* */
 
 	/** Custom delta serialization for the map components array. Enables network transmission of changes. */
-	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms) { return FastArrayDeltaSerialize<FMapComponentSpec, FMapComponentsContainer>(Items, DeltaParms, *this); }
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
 
 	/** Checks if an item should be written during delta serialization, considering client or server context. */
 	template <typename Type, typename SerializerType>
@@ -130,25 +160,128 @@ public:
 
 	FORCEINLINE int32 Num() const { return Items.Num(); }
 
-	FORCEINLINE bool Contains(const UMapComponent* Item) const { return Items.Contains(Item); }
-	FORCEINLINE bool Contains(const FCell& Cell) const { return Items.Contains(Cell); }
-	FORCEINLINE bool Contains(const FPoolObjectHandle& PoolObjectHandle) const { return Items.Contains(PoolObjectHandle); }
+	/** Returns the heap memory used by items and their side-indices. */
+	SIZE_T GetAllocatedSize() const;
+
+	FORCEINLINE bool Contains(const UMapComponent* Item) const { return IndexOf(Item) != INDEX_NONE; }
+	FORCEINLINE bool Contains(const FCell& Cell) const { return IndexOf(Cell) != INDEX_NONE; }
+	FORCEINLINE bool Contains(const FPoolObjectHandle& PoolObjectHandle) const { return IndexOf(PoolObjectHandle) != INDEX_NONE; }
 	FORCEINLINE bool ContainsByPredicate(const TFunctionRef<bool(const FMapComponentSpec&)>& Predicate) const { return Items.ContainsByPredicate(Predicate); }
 
-	FMapComponentSpec* Find(const UMapComponent* Item) { return Items.FindByKey(Item); }
-	FMapComponentSpec* Find(const FCell& Cell) { return Items.FindByKey(Cell); }
-	FMapComponentSpec* Find(const FPoolObjectHandle& PoolObjectHandle) { return Items.FindByKey(PoolObjectHandle); }
+	FMapComponentSpec* Find(const UMapComponent* Item) { return FindByIndex(IndexOf(Item)); }
+	FMapComponentSpec* Find(const FCell& Cell) { return FindByIndex(IndexOf(Cell)); }
+	FMapComponentSpec* Find(const FPoolObjectHandle& PoolObjectHandle) { return FindByIndex(IndexOf(PoolObjectHandle)); }
+
+	/** Returns indices of all items located on specified cell. */
+	void FindIndices(const FCell& Cell, TArray<int32, TInlineAllocator<4>>& OutIndices) const;
 
 	FMapComponentSpec& FindOrAdd(UMapComponent& MapComponent);
 	FMapComponentSpec& FindOrAdd(const FPoolObjectHandle& PoolObjectHandle);
 
+	/** Sets the map component and its cell into the specified item and keeps indices in sync, the item must be owned by this container. */
+	void SetMapComponent(FMapComponentSpec& InOutSpec, UMapComponent* MapComponent, const FCell& Cell);
+
 	void Remove(const UMapComponent* MapComponent);
 	void Remove(const FCell& Cell);
 	void Remove(const FPoolObjectHandle& PoolObjectHandle);
 
+	/** Removes all items by specified indices in one swap-compaction pass without shrinking and marks the array dirty once. */
+	void RemoveAtIndices(TArray<int32, TInlineAllocator<32>>& InOutIndices);
+
+	/** Has to be called when the map component changed its cell, so it could be found by new cell.
+	 * The new cell is replicated with the item, so clients move it in their occupancy before the component itself is replicated. */
+	void UpdateIndices(const UMapComponent* MapComponent);
+
+	/** Marks indices to be rebuilt on next lookup, is used when items are changed by replication. */
+	FORCEINLINE void MarkIndicesDirty() const
+	{
+		bIndicesDirty = true;
+		++ItemsVersion;
+		++LayoutVersion;
+	}
+
+	/** Returns the number of items owned by players, is counted on indexing, so it costs nothing instead of walking all items. */
+	FORCEINLINE int32 GetPlayersNum() const
+	{
+		EnsureIndices();
+		return PlayersNum;
+	}
+
+	/** Returns the number of replicated items whose map components are not resolved yet on client.
+	 * Is counted by replication callbacks of items, so it costs nothing instead of walking all items on each replication. */
+	FORCEINLINE int32 GetUnresolvedNum() const { return UnresolvedNum; }
+
+	/** Counts or uncounts given replicated item as unresolved according its current map component. */
+	void UpdateUnresolvedNum(FMapComponentSpec& InOutSpec, bool bIsRemoved) const;
+
+	/** Returns the number that is changed on any change of items or their cells, allows to cache data derived from items. */
+	FORCEINLINE uint32 GetItemsVersion() const { return ItemsVersion; }
+
+	/** Returns the number that is changed only when items are added, removed, reordered or get another map component, but not when their cells are changed.
+	 * Allows to keep data parallel to items and update it per item when only cells are moved. */
+	FORCEINLINE uint32 GetLayoutVersion() const { return LayoutVersion; }
+
 	FORCEINLINE bool IsValidIndex(int32 Index) const { return Items.IsValidIndex(Index); }
 
+	/** Sets the Generated Map that owns this container, it receives replicated items on client to keep its occupancy in sync. */
+	FORCEINLINE void SetOwnerMap(AGeneratedMap* InOwnerMap) { OwnerMap = InOwnerMap; }
+
+	/** Returns the Generated Map that owns this container, could be null. */
+	FORCEINLINE AGeneratedMap* GetOwnerMap() const { return OwnerMap.Get(); }
+
 	UMapComponent* operator[](const int32 Index) const { return IsValidIndex(Index) ? Items[Index].MapComponent : nullptr; }
+
+	/*********************************************************************************************
+	 * Side-indices to find items in O(1) instead of linear search, are not replicated
+	 ********************************************************************************************* */
+protected:
+	/** Item index by its map component. */
+	mutable TMap<const UMapComponent*, int32> ComponentIndices;
+
+	/** Item index by hash of its pool handle. */
+	mutable TMap<FGuid, int32> HandleIndices;
+
+	/** Item indices by cell of their map components, multiple components could be located on the same cell. */
+	mutable TMultiMap<FCell, int32> CellIndices;
+
+	/** Cell by which each item was indexed in CellIndices, allows to remove it even if the cell of map component is changed. */
+	mutable TArray<FCell> IndexedCells;
+
+	/** The number of indexed items of players, counted by the replicated actor type, so clients count players even before their components are resolved. */
+	mutable int32 PlayersNum = 0;
+
+	/** The number of replicated items without resolved map components, @see FMapComponentsContainer::GetUnresolvedNum. */
+	mutable int32 UnresolvedNum = 0;
+
+	/** Is true when indices have to be rebuilt from Items. */
+	mutable bool bIndicesDirty = true;
+
+	/** Is incremented every time any item is indexed or unindexed. */
+	mutable uint32 ItemsVersion = 0;
+
+	/** Is incremented every time items are added, removed, reordered or their map components are replaced. */
+	mutable uint32 LayoutVersion = 0;
+
+	/** The Generated Map that owns this container, is not replicated. */
+	TWeakObjectPtr<AGeneratedMap> OwnerMap = nullptr;
+
+	/** Rebuilds all indices if they were marked dirty. */
+	void EnsureIndices() const;
+
+	/** Adds specified item to the indices. */
+	void AddIndices(int32 ItemIndex) const;
+
+	/** Removes specified item from the indices. */
+	void RemoveIndices(int32 ItemIndex) const;
+
+	/** Swaps the item with the last one and removes it, keeping indices in sync. */
+	void RemoveAtSwap(int32 ItemIndex);
+
+	int32 IndexOf(const UMapComponent* MapComponent) const;
+	int32 IndexOf(const FCell& Cell) const;
+	int32 IndexOf(const FPoolObjectHandle& PoolObjectHandle) const;
+
+	FORCEINLINE FMapComponentSpec* FindByIndex(int32 Index) { return Items.IsValidIndex(Index) ? &Items[Index] : nullptr; }
 };
 
 /**
@@ -0,0 +1,67 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Structures/LevelLayout.h"
+
+/**
+ * Compact binary state of the running match that is kept in memory, e.g: for crash recovery or an instant rematch on the same board:
+ * - Layout: walls, boxes and items of each cell with the level type and the generation seed, @see FLevelLayout.
+ * - Items with their types, bombs with their owners, radius and remaining fuse, players with their cells and powerups.
+ * - Seconds remaining to the end of the match.
+ * Is captured by reading the grid only, so it could be taken every few seconds on the server.
+ * @see AGeneratedMap::CaptureMatchSnapshot() and AGeneratedMap::RestoreMatchSnapshot().
+ */
+struct BOMBER_API FMatchSnapshot
+{
+	/** 'BMMS' that starts each snapshot. */
+	static constexpr uint32 Magic = 0x534D4D42;
+
+	/** Is incremented on each change of the format. */
+	static constexpr uint16 Version = 1;
+
+	/** The item on the level. */
+	struct FItem
+	{
+		int32 CellIndex = INDEX_NONE;
+		uint8 ItemType = 0;
+	};
+
+	/** The bomb on the level. */
+	struct FBomb
+	{
+		int32 CellIndex = INDEX_NONE;
+		int32 OwnerCharacterID = INDEX_NONE;
+		int32 FireRadius = INDEX_NONE;
+		float FuseSecondsRemain = 0.f;
+	};
+
+	/** The alive player on the level. */
+	struct FPlayer
+	{
+		int32 CharacterID = INDEX_NONE;
+		int32 CellIndex = INDEX_NONE;
+		int32 SkateN = 0;
+		int32 BombN = 0;
+		int32 FireN = 0;
+	};
+
+	/** Walls, boxes and items of each cell, players and bombs are stored separately. */
+	FLevelLayout Layout;
+
+	TArray<FItem> Items;
+	TArray<FBomb> Bombs;
+	TArray<FPlayer> Players;
+
+	/** Seconds remaining to the end of the match, 0 if the match was not in progress. */
+	float InGameSecondsRemain = 0.f;
+
+	/** Writes or reads the snapshot, returns false if read data is not a valid snapshot. */
+	bool Serialize(FArchive& Ar);
+
+	/** Writes the snapshot to given bytes. */
+	void SaveToBytes(TArray<uint8>& OutBytes);
+
+	/** Reads the snapshot from given bytes, returns false if they are not a valid snapshot. */
+	bool LoadFromBytes(const TArray<uint8>& Bytes);
+};
@@ -0,0 +1,161 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+//---
+#include "AISchedulerSubsystem.generated.h"
+
+class AMyAIController;
+struct FAIWorldSnapshot;
+
+/**
+ * The bot that is updated by the scheduler with its own update interval.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FAIScheduledBot
+{
+	GENERATED_BODY()
+
+	/** The controller of the bot. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++")
+	TWeakObjectPtr<AMyAIController> AIController = nullptr;
+
+	/** The world time in seconds when the bot has to be updated next time. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++")
+	double NextUpdateTime = 0.0;
+};
+
+/**
+ * Owns the update of all bots in the world instead of one looping timer per AI controller.
+ * Each bot is updated by its own interval (level of detail): more often while any threat is near, less often while it is isolated,
+ * @see AMyAIController::GetUpdateInterval. All bots that are due are queued together, so they read the same AI world snapshot
+ * and could be staggered across frames to flatten spikes.
+ * Is updated by the AI phase of each step of the Grid Simulation Subsystem, so a frame here is one simulation step.
+ * - Bomber.AI.StaggerFrames: number of frames the batch is spread across.
+ * - Bomber.AI.FrameBudgetMs: time budget per frame for updating bots, the rest is postponed to next frames.
+ * - Bomber.AI.Parallel: decisions of all bots of the frame are made in parallel, then applied on the game thread.
+ * With the task pipeline of the Grid Simulation Subsystem, decisions are launched as a task at the end of one step
+ * and are applied at the start of the next one, so they are made while the game thread renders the frame.
+ */
+UCLASS()
+class BOMBER_API UAISchedulerSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the AI Scheduler Subsystem, is checked and wil crash if can't be obtained. */
+	static UAISchedulerSubsystem& Get(const UObject* WorldContextObject = nullptr);
+
+	/** Returns the pointer to the AI Scheduler Subsystem. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UAISchedulerSubsystem* GetAISchedulerSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Starts updating given bot, is called by the bot itself when its AI is enabled. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void RegisterBot(AMyAIController* AIController);
+
+	/** Stops updating given bot, is called by the bot itself when its AI is disabled. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void UnregisterBot(AMyAIController* AIController);
+
+	/** Queues due bots and updates pending ones, is called by the Grid Simulation Subsystem on each step. */
+	void UpdateBots(float DeltaTime);
+
+	/** Returns the number of bots that are currently updated. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetBotsNum() const { return BotsInternal.Num(); }
+
+	/** Returns the time budget in milliseconds per frame for updating bots, 0 if is not limited. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static float GetFrameBudgetMs();
+
+	/** Returns how long bots were updated in the last frame in milliseconds. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetLastFrameUpdateMs() const { return LastFrameUpdateMsInternal; }
+
+	/** Queues due bots, gathers their inputs on the game thread and launches the task that makes their decisions in parallel over given snapshot.
+	 * Decisions are not applied until ApplyLaunchedDecisions() is called, so the task runs while the game thread does other work.
+	 * @param Snapshot The copy of the level state that is kept alive by the task until all decisions are made. */
+	void LaunchDecisions(const TSharedRef<const FAIWorldSnapshot, ESPMode::ThreadSafe>& Snapshot);
+
+	/** Waits for the launched decisions if they are not made yet and applies them on the game thread, does nothing if nothing is launched. */
+	void ApplyLaunchedDecisions();
+
+	/** Returns how long decisions of the last launched task were made on workers in milliseconds. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetLastDecisionsMs() const { return LastDecisionsMsInternal; }
+
+	/** Returns how long the game thread waited for the last launched decisions in milliseconds, is 0 if they were made in time. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetLastDecisionsWaitMs() const { return LastDecisionsWaitMsInternal; }
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** All bots that are currently updated with the time of their next update. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Bots"))
+	TArray<FAIScheduledBot> BotsInternal;
+
+	/** Due bots that are not updated yet, is filled when no bots are pending. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Pending Bots"))
+	TArray<TWeakObjectPtr<AMyAIController>> PendingBotsInternal;
+
+	/** The number of bots to update per frame from the queued ones, is calculated by Bomber.AI.StaggerFrames. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Bots Per Frame"))
+	int32 BotsPerFrameInternal = 0;
+
+	/** How long bots were updated in the last frame in milliseconds. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Frame Update Ms"))
+	float LastFrameUpdateMsInternal = 0.f;
+
+	/** How long decisions of the last launched task were made on workers in milliseconds. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Decisions Ms"))
+	float LastDecisionsMsInternal = 0.f;
+
+	/** How long the game thread waited for the last launched decisions in milliseconds. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Decisions Wait Ms"))
+	float LastDecisionsWaitMsInternal = 0.f;
+
+	/** Bots with their inputs and decisions of the launched task, is written by the task only until it is completed. */
+	TSharedPtr<struct FAIDecisionsBatch, ESPMode::ThreadSafe> LaunchedBatchInternal = nullptr;
+
+	/** The task that makes decisions of the launched batch. */
+	UE::Tasks::FTask LaunchedDecisionsTaskInternal;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Waits for the launched decisions, so workers don't read the batch of destroyed world. */
+	virtual void Deinitialize() override;
+
+	/** Queues all registered bots whose update time has come. */
+	void QueueDueBots();
+
+	/** Schedules the next update of given bot by its current level of detail. */
+	void ScheduleNextUpdate(const AMyAIController* AIController);
+
+	/** Updates pending bots one by one until the number of bots per frame or the frame budget is reached. */
+	void UpdatePendingBots(double StartTime);
+
+	/** Takes pending bots of this frame and gathers their inputs on the game thread, bots that can't decide are rescheduled. */
+	void GatherPendingDecisions(struct FAIDecisionsBatch& OutBatch);
+
+	/** Makes decisions of all bots of given batch in parallel over their snapshots, is safe to call from any thread. */
+	static void MakeDecisions(struct FAIDecisionsBatch& InOutBatch);
+
+	/** Applies made decisions of given batch on the game thread and schedules next updates of their bots. */
+	void ApplyDecisions(const struct FAIDecisionsBatch& Batch);
+
+	/** Makes decisions of pending bots of this frame in parallel and applies them on the game thread.
+	 * All bots of the frame see the same level state, so the frame budget is not checked between them. */
+	void UpdatePendingBotsParallel();
+};
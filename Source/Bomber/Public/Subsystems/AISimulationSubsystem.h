@@ -0,0 +1,121 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "AISimulationSubsystem.generated.h"
+
+enum class ECurrentGameState : uint8;
+
+/**
+ * Result of one bot in one simulated match.
+ */
+struct FAISimulationBotResult
+{
+	/** The ID of the character controlled by the bot. */
+	int32 CharacterID = INDEX_NONE;
+
+	/** The character and its bot, are weak since the match could be ended by destroying them. */
+	TWeakObjectPtr<const class APlayerCharacter> PlayerCharacter = nullptr;
+	TWeakObjectPtr<class AMyAIController> AIController = nullptr;
+
+	/** Seconds since the match start when the bot was blasted, is negative while it is alive. */
+	float DeathTime = -1.f;
+
+	/** The number of decisions made during the match. */
+	int32 DecisionsNum = 0;
+
+	/** The average and the longest decision in milliseconds. */
+	double AverageDecisionMs = 0.0;
+	double MaxDecisionMs = 0.0;
+};
+
+/**
+ * Runs bot-only matches one by one without any player input to evaluate and tune UAIDataAsset parameters.
+ * Is created only if the game is launched with the -AISimulation=<MatchesNum> argument, e.g.:
+ * Bomber.exe -game -nullrhi -nosound -AISimulation=100 -AISimulationDilation=10 -AISimulationOutput=D:/Results.csv
+ * - Each character, including the one of the local player, is possessed by the bot.
+ * - The next match starts as soon as the previous one is ended, the game is closed after the last match.
+ * - Win, match length and decision timings of each bot are appended to the CSV file after each match.
+ * To run matches in parallel, launch several processes with different output files.
+ */
+UCLASS()
+class BOMBER_API UAISimulationSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the pointer to the AI Simulation Subsystem, is null if the game is not simulated. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UAISimulationSubsystem* GetAISimulationSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true if the game is launched to simulate bot-only matches. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsSimulationEnabled();
+
+	/** Returns the number of already simulated matches. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetFinishedMatchesNum() const { return FinishedMatchesNumInternal; }
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** The number of matches to simulate, is taken from the -AISimulation argument. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Matches Num"))
+	int32 MatchesNumInternal = 0;
+
+	/** The number of already simulated matches. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Finished Matches Num"))
+	int32 FinishedMatchesNumInternal = 0;
+
+	/** The world time in seconds when the current match was started. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Match Start Time"))
+	double MatchStartTimeInternal = 0.0;
+
+	/** Path to the CSV file where results are written. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Output File Path"))
+	FString OutputFilePathInternal;
+
+	/** All rows written to the output file. */
+	FString OutputCSVInternal;
+
+	/** Results of bots in the current match. */
+	TArray<FAISimulationBotResult> BotResultsInternal;
+
+	/** The number of matches won by each character ID. */
+	TMap<int32, int32> WinsByCharacterIDInternal;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds launched with the -AISimulation argument. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Applies the time dilation and starts listening the game states. */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Starts the next match or records results of the finished one. */
+	UFUNCTION()
+	void OnGameStateChanged(ECurrentGameState CurrentGameState);
+
+	/** Remembers when bots are blasted. */
+	UFUNCTION()
+	void OnAnyCharacterDestroyed();
+
+	/** Sets the Game Starting state on the next tick, so all listeners of the current state are notified first. */
+	void StartNextMatch();
+
+	/** Remembers all bots that take part in the match and starts counting their decisions. */
+	void OnMatchStarted();
+
+	/** Writes results of the finished match and closes the game after the last one. */
+	void OnMatchEnded();
+};
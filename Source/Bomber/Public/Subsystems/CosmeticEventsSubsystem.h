@@ -0,0 +1,150 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+//---
+#include "Bomber.h"
+#include "Structures/Cell.h"
+//---
+#include "CosmeticEventsSubsystem.generated.h"
+
+/**
+ * Types of events produced by the grid simulation for cosmetic systems.
+ */
+UENUM(BlueprintType)
+enum class ECosmeticEventType : uint8
+{
+	None,
+	///< The cell was exploded by a bomb
+	Explosion,
+	///< The level actor was destroyed from the level
+	ActorDestroyed,
+	///< The item was picked up by a player
+	ItemPicked,
+	///< The level actor moved to another cell
+	CellChanged
+};
+
+/**
+ * The event that is queued by gameplay code and is consumed by cosmetic systems once per frame.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FCosmeticEvent
+{
+	GENERATED_BODY()
+
+	/** The type of this event. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	ECosmeticEventType Type = ECosmeticEventType::None;
+
+	/** The cell where the event happened. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	FCell Cell = FCell::InvalidCell;
+
+	/** The type of the level actor this event is about. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	EActorType ActorType = EActorType::None;
+
+	/** The object that produced this event, e.g: the Map Component that moved, could be destroyed until the event is consumed. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	TWeakObjectPtr<UObject> Source = nullptr;
+};
+
+/**
+ * Decouples the grid simulation from its cosmetics: gameplay code only queues typed events here,
+ * while VFX, audio and debug renderers consume them in batches once per frame.
+ * Duplicates are coalesced on queueing, e.g: overlapped blasts of one chain explode each cell once,
+ * so each consumer spends its budget only on unique events.
+ * Is not created on the dedicated server and on simulated clients of the load test, since nobody sees or hears cosmetics there.
+ * - Bomber.Cosmetics.Enabled: 0 to process cosmetics right away instead of batching them by frames.
+ */
+UCLASS()
+class BOMBER_API UCosmeticEventsSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Is called once per frame with all coalesced events of this frame grouped by their type, so custom consumers are able to batch them as well. */
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnCosmeticEvents, TConstArrayView<FCosmeticEvent> /*Events*/);
+	FOnCosmeticEvents OnCosmeticEvents;
+
+	/** Returns the pointer to the Cosmetic Events Subsystem, is null on the dedicated server. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UCosmeticEventsSubsystem* GetCosmeticEventsSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Queues the event to be consumed with other events of this frame.
+	 * Is coalesced with the same event that is already queued: explosions by their cell, moves by their source and others by all params. */
+	void AddEvent(ECosmeticEventType Type, const FCell& Cell, EActorType ActorType, UObject* Source = nullptr);
+
+	/** Returns the number of events queued for this frame. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetQueuedEventsNum() const { return QueuedEventsInternal.Num(); }
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** Key of the queued event to coalesce duplicates. */
+	struct FCosmeticEventKey
+	{
+		ECosmeticEventType Type = ECosmeticEventType::None;
+		FCell Cell = FCell::InvalidCell;
+		TObjectKey<UObject> Source;
+
+		FORCEINLINE bool operator==(const FCosmeticEventKey& Other) const { return Type == Other.Type && Cell == Other.Cell && Source == Other.Source; }
+		friend FORCEINLINE uint32 GetTypeHash(const FCosmeticEventKey& Key) { return HashCombine(HashCombine(GetTypeHash(Key.Type), GetTypeHash(Key.Cell)), GetTypeHash(Key.Source)); }
+	};
+
+	/** Events queued for this frame in the order of queueing. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Queued Events"))
+	TArray<FCosmeticEvent> QueuedEventsInternal;
+
+	/** Indices of queued events by their keys, is used to coalesce duplicates in constant time. */
+	TMap<FCosmeticEventKey, int32> QueuedEventIndicesInternal;
+
+	/** The frame of ExplosionsSpawnedInFrameInternal, the explosion budget is reset on the next frame. */
+	uint64 ExplosionsBudgetFrameInternal = 0;
+
+	/** The number of explosion emitters spawned in the current frame, is limited by the explosion tier, @see UCosmeticEventsSubsystem::ConsumeExplosions. */
+	int32 ExplosionsSpawnedInFrameInternal = 0;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds that are not the dedicated server. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Is ticked only while any event is queued. */
+	virtual bool IsTickable() const override;
+
+	/** Consumes all events queued for this frame. */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id of this tickable object. */
+	virtual TStatId GetStatId() const override;
+
+	/** Is called when the world is torn down, drops all queued events. */
+	virtual void Deinitialize() override;
+
+	/** Passes given events to all consumers, events are expected to be grouped by their type. */
+	void ConsumeEvents(TConstArrayView<FCosmeticEvent> Events);
+
+	/** Spawns explosion emitters of all exploded cells by the explosion tier of current game settings and plays explosion sound once.
+	 * Emitters are pooled by the world Niagara pool, chains detonated in the same frame share the budget of the tier.
+	 * @see UBombDataAsset::GetExplosionVFXTier */
+	void ConsumeExplosions(TConstArrayView<FCosmeticEvent> Events);
+
+	/** Plays the pickup sound once for all items picked up in this frame. */
+	void ConsumeItemPickups(TConstArrayView<FCosmeticEvent> Events);
+
+	/** Displays new cells of moved level actors once per frame, is not available in shipping build. */
+	void ConsumeCellChanges(TConstArrayView<FCosmeticEvent> Events);
+};
@@ -0,0 +1,77 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/GameInstanceSubsystem.h"
+//---
+#include "DataAssetsPreloadSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+/**
+ * Requests all data assets of UDataAssetsContainer at once asynchronously as soon as the game instance is started,
+ * so their first getters do not block the game thread by synchronous loading at gameplay moments.
+ * The Menu game state is postponed until all data assets are loaded, @see AMyGameStateBase::ServerSetGameState.
+ */
+UCLASS()
+class BOMBER_API UDataAssetsPreloadSubsystem final : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Is called once all data assets are loaded. */
+	DECLARE_MULTICAST_DELEGATE(FOnDataAssetsPreloaded);
+	FOnDataAssetsPreloaded OnDataAssetsPreloaded;
+
+	/** Returns the pointer to the Data Assets Preload Subsystem. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UDataAssetsPreloadSubsystem* GetDataAssetsPreloadSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true if all data assets are loaded. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsPreloaded() const { return bIsPreloadedInternal; }
+
+	/** Returns how long all data assets were loaded in seconds, 0 if they are not loaded yet. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE float GetPreloadSeconds() const { return PreloadSecondsInternal; }
+
+	/** Calls given function once all data assets are loaded, calls it right away if they are loaded already. */
+	void CallOrWaitPreloaded(const FOnDataAssetsPreloaded::FDelegate& Callback);
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** Is true once all data assets are loaded. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Preloaded"))
+	bool bIsPreloadedInternal = false;
+
+	/** The time in seconds when the preload was requested. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Preload Start Time"))
+	double PreloadStartTimeInternal = 0.0;
+
+	/** How long all data assets were loaded in seconds. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Preload Seconds"))
+	float PreloadSecondsInternal = 0.f;
+
+	/** Keeps all preloaded data assets in memory while the game instance is alive. */
+	TSharedPtr<FStreamableHandle> PreloadHandleInternal = nullptr;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Requests all data assets of the container asynchronously. */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Releases preloaded data assets. */
+	virtual void Deinitialize() override;
+
+	/** Is called once all data assets are loaded. */
+	void OnPreloaded();
+};
@@ -0,0 +1,79 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "GarbageCollectionSubsystem.generated.h"
+
+enum class ECurrentGameState : uint8;
+
+/**
+ * Moves garbage collection out of the match, so reachability passes over hundreds of pooled level actors do not hitch the round.
+ * - During the In-Game state, automatic purges are postponed by 'Bomber.GC.InGamePurgeInterval'
+ *   and the incremental reachability analysis is allowed if supported by the engine, so forced passes are spread over frames.
+ * - Garbage is collected at safe points instead: once the match is ended and once the level is regenerated outside of the match.
+ * The engine still collects garbage mid-match on low memory, previous engine settings are restored when the match is left.
+ * Can be disabled by 'Bomber.GC.Enabled 0'.
+ */
+UCLASS()
+class BOMBER_API UGarbageCollectionSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the pointer to the Garbage Collection Subsystem. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UGarbageCollectionSubsystem* GetGarbageCollectionSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true while automatic garbage collection is postponed by the match. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsCollectionPostponed() const { return !OverriddenConsoleVariablesInternal.IsEmpty(); }
+
+	/** Requests the full garbage collection on the next tick.
+	 * Is called on safe points, when a hitch is not noticeable. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	void CollectGarbageAtSafePoint();
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** Engine console variables overridden during the match with their previous values. */
+	TMap<FString, FString> OverriddenConsoleVariablesInternal;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Starts listening the game states and the level generation. */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Restores engine settings if the world is left during the match. */
+	virtual void Deinitialize() override;
+
+	/** Postpones collection on the In-Game state and collects garbage once the match is ended. */
+	UFUNCTION()
+	void OnGameStateChanged(ECurrentGameState CurrentGameState);
+
+	/** Collects garbage once the level is regenerated outside of the match, since old level actors may be released. */
+	UFUNCTION()
+	void OnGeneratedLevelActors();
+
+	/** Overrides engine settings, so garbage is not collected automatically during the match. */
+	void PostponeCollection();
+
+	/** Restores engine settings overridden by the match. */
+	void RestoreCollection();
+
+	/** Sets the engine console variable if it exists and remembers its previous value to be restored. */
+	void OverrideConsoleVariable(const TCHAR* Name, const FString& Value);
+};
@@ -10,6 +10,7 @@ class AGeneratedMap;
 
 /**
  * Provides access to the Generated Map and its world from anywhere in game as well as in editor.
+ * Keeps all registered Generated Maps, so each match instance in the same world can resolve its own grid by context.
  */
 UCLASS()
 class BOMBER_API UGeneratedMapSubsystem final : public UWorldSubsystem
@@ -34,9 +35,25 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void SetGeneratedMap(AGeneratedMap* InGeneratedMap);
 
+	/** Removes given Generated Map from registered ones, the next registered map becomes the primary one if it was removed. */
+	void UnregisterGeneratedMap(AGeneratedMap* InGeneratedMap);
+
+	/** Returns all registered Generated Maps, one per match instance in this world. */
+	const TArray<TObjectPtr<AGeneratedMap>>& GetGeneratedMaps() const { return GeneratedMapsInternal; }
+
+	/** Returns the Generated Map of the match instance that owns given context object, the primary one if it can't be resolved.
+	 * Is resolved by the owner chain first since level actors are spawned by their map, then by the grid that contains the actor location. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (Keywords = "Level"))
+	AGeneratedMap* GetGeneratedMapByContext(const UObject* ContextObject) const;
+
 private:
 	/** Is main game actor on persistent level.
 	 * @see UGeneratedMapSubsystem::GetGeneratedMap */
 	UPROPERTY(Transient)
 	TObjectPtr<AGeneratedMap> GeneratedMapInternal = nullptr;
+
+	/** All Generated Maps registered in this world, contains the primary one.
+	 * @see UGeneratedMapSubsystem::GetGeneratedMapByContext */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AGeneratedMap>> GeneratedMapsInternal;
 };
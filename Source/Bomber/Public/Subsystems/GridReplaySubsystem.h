@@ -0,0 +1,233 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "Bomber.h"
+//---
+#include "GridReplaySubsystem.generated.h"
+
+enum class ECurrentGameState : uint8;
+
+/**
+ * Types of grid events stored in the replay.
+ * Bomb placing and player cells are inputs that are applied on playback, others are results that are compared with re-simulated ones.
+ */
+UENUM(BlueprintType)
+enum class EGridReplayEventType : uint8
+{
+	None,
+	BombPlaced,
+	BombDetonated,
+	ActorDestroyed,
+	ItemPicked,
+	PlayerCellChanged,
+	///< Is not recorded in the replay since it is re-simulated, but is sent to spectators with the item type
+	ItemSpawned
+};
+
+/**
+ * One grid event of the replay.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridReplayEvent
+{
+	GENERATED_BODY()
+
+	/** The number of the simulation step since the match start when the event happened. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	int64 Step = 0;
+
+	/** The type of the event. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	EGridReplayEventType Type = EGridReplayEventType::None;
+
+	/** The grid index of the cell where the event happened. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	int32 CellIndex = INDEX_NONE;
+
+	/** The ID of the character that caused the event or the number of bombs in the chain for detonations, INDEX_NONE if is not used. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	int32 Value = INDEX_NONE;
+
+	/** The actor type of destroyed actor or the item type of picked item, 0 if is not used. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	uint8 Param = 0;
+
+	/** Returns true if the event is applied on playback instead of being re-simulated. */
+	bool IsInput() const { return Type == EGridReplayEventType::BombPlaced || Type == EGridReplayEventType::PlayerCellChanged; }
+
+	/** Returns the event as string for logging. */
+	FString ToString() const;
+
+	/** Compares all fields of the events. */
+	friend bool operator==(const FGridReplayEvent& A, const FGridReplayEvent& B) { return A.Step == B.Step && A.Type == B.Type && A.CellIndex == B.CellIndex && A.Value == B.Value && A.Param == B.Param; }
+};
+
+/**
+ * The whole recorded match: everything needed to generate the same level and the ordered stream of its grid events.
+ * Is written as packed binary, so the file takes a few kilobytes.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridReplay
+{
+	GENERATED_BODY()
+
+	/** The seed of the level generation. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	int32 Seed = 0;
+
+	/** The number of columns (X) and rows (Y) of the grid. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	FIntPoint GridSize = FIntPoint::ZeroValue;
+
+	/** The level type of the match. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	ELevelType LevelType = ELT::None;
+
+	/** The length of one simulation step in seconds, 0 if steps were variable. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	float StepSeconds = 0.f;
+
+	/** The step that took the most CPU time and its time in milliseconds. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	int64 SlowestStep = 0;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	float SlowestStepMs = 0.f;
+
+	/** All grid events in the order of happening. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "C++")
+	TArray<FGridReplayEvent> Events;
+
+	/** Returns the step of the last event, 0 if there are no events. */
+	FORCEINLINE int64 GetLastStep() const { return Events.IsEmpty() ? 0 : Events.Last().Step; }
+
+	/** Reads or writes the replay in the packed binary format, returns false if the data is not a replay of supported version. */
+	bool Serialize(FArchive& Ar);
+};
+
+/**
+ * Records matches as a compact stream of grid events and re-simulates them on the server.
+ * Relies on the fixed steps of the Grid Simulation Subsystem: events are stamped by step numbers and inputs are applied before their step.
+ * Is created only if the game is launched with one of the arguments:
+ * -GridReplayRecord[=<Path>]: each match is written to the file when it is ended, e.g. -GridReplayRecord=D:/Match.grp
+ * -GridReplayPlay=<Path>: the level is generated by the recorded seed and the match is re-simulated from the file.
+ * Playback is headless with -nullrhi -nosound and closes the game once finished, otherwise it is visual.
+ * Re-simulated results are compared with recorded ones, the first divergence and the slowest step are logged.
+ */
+UCLASS()
+class BOMBER_API UGridReplaySubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the pointer to the Grid Replay Subsystem, is null if the game is not recorded or played. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UGridReplaySubsystem* GetGridReplaySubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true if the game is launched to record matches. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsRecordingEnabled();
+
+	/** Returns true if the game is launched to play the replay. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsPlaybackEnabled();
+
+	/** Writes given replay to the file, returns true if succeeded. */
+	static bool SaveReplay(FGridReplay& Replay, const FString& FilePath);
+
+	/** Reads the replay from the file, returns true if succeeded. */
+	static bool LoadReplay(const FString& FilePath, FGridReplay& OutReplay);
+
+	/** Adds the event of the current simulation step if the match is recorded or played.
+	 * @param Type The type of the event.
+	 * @param Cell The cell where the event happened.
+	 * @param Value The ID of the causer character or the number of bombs in the chain.
+	 * @param Param The actor or item type. */
+	void RecordEvent(EGridReplayEventType Type, const struct FCell& Cell, int32 Value = INDEX_NONE, uint8 Param = 0);
+
+	/** Returns true while the current match is recorded or re-simulated. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsMatchRunning() const { return StartStepInternal != INDEX_NONE; }
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** Events of the current match, during playback contains re-simulated events. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Recorded Replay"))
+	FGridReplay RecordedReplayInternal;
+
+	/** The replay loaded from the file to be played. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Playback Replay"))
+	FGridReplay PlaybackReplayInternal;
+
+	/** Path to the file where the replay is written to or read from. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "File Path"))
+	FString FilePathInternal;
+
+	/** The simulation step when the current match was started, INDEX_NONE if no match is running. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Start Step"))
+	int64 StartStepInternal = INDEX_NONE;
+
+	/** The index of the next event in the playback replay. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Next Playback Event"))
+	int32 NextPlaybackEventInternal = 0;
+
+	/** The number of recorded matches. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Recorded Matches Num"))
+	int32 RecordedMatchesNumInternal = 0;
+
+	/** Characters of the current match by their IDs to apply their inputs on playback. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Characters"))
+	TMap<int32, TWeakObjectPtr<class APlayerCharacter>> CharactersInternal;
+
+	/** Handles of listened steps of the Grid Simulation Subsystem. */
+	FDelegateHandle PreSimulationStepHandle;
+	FDelegateHandle SimulationStepHandle;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds launched with the -GridReplayRecord or -GridReplayPlay argument. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Loads the replay to be played and starts listening the game states. */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Stops listening simulation steps. */
+	virtual void Deinitialize() override;
+
+	/** Starts or ends the recording of the match. */
+	UFUNCTION()
+	void OnGameStateChanged(ECurrentGameState CurrentGameState);
+
+	/** Sets the Game Starting state on the next tick to start the playback. */
+	void StartPlaybackMatch();
+
+	/** Remembers the start step and characters of the match, takes the control from characters on playback. */
+	void OnMatchStarted();
+
+	/** Writes the recorded match to the file. */
+	void OnMatchEnded();
+
+	/** Applies recorded inputs of the starting step on playback. */
+	void OnPreSimulationStep(int64 StepNumber);
+
+	/** Remembers the slowest step of the match. */
+	void OnSimulationStep(int64 StepNumber);
+
+	/** Applies recorded input to its character. */
+	void ApplyPlaybackEvent(const FGridReplayEvent& Event);
+
+	/** Compares re-simulated results with recorded ones and closes the game if is headless. */
+	void FinishPlayback();
+};
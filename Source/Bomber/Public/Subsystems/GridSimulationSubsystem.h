@@ -0,0 +1,261 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+//---
+#include "GridSimulationSubsystem.generated.h"
+
+class ABombActor;
+class AItemActor;
+class APlayerCharacter;
+
+/**
+ * The fuse of the bomb that waits for its detonation step.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridSimulationBomb
+{
+	GENERATED_BODY()
+
+	/** The bomb to detonate. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++")
+	TWeakObjectPtr<ABombActor> Bomb = nullptr;
+
+	/** The world time in seconds when the bomb has to be detonated. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++")
+	double DetonationTime = 0.0;
+
+	/** The absolute slot of the fuse wheel where the bomb is stored, the bucket is the slot modulo the wheel size. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++")
+	int64 Slot = 0;
+};
+
+/**
+ * The item that was overlapped by the player and waits for its pickup step.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridSimulationPickup
+{
+	GENERATED_BODY()
+
+	/** The overlapped item. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++")
+	TWeakObjectPtr<AItemActor> Item = nullptr;
+
+	/** The player that overlapped the item. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++")
+	TWeakObjectPtr<APlayerCharacter> Player = nullptr;
+};
+
+/**
+ * CPU time spent on each phase of one simulation step.
+ */
+USTRUCT(BlueprintType)
+struct BOMBER_API FGridSimulationStepStats
+{
+	GENERATED_BODY()
+
+	/** The number of the step since the simulation was started. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	int64 StepNumber = 0;
+
+	/** How long due bombs were collected in milliseconds. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float BombTimersMs = 0.f;
+
+	/** How long due bombs were detonated with their chain reactions in milliseconds. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float ExplosionsMs = 0.f;
+
+	/** How long overlapped items were picked up in milliseconds. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float PickupsMs = 0.f;
+
+	/** How long bots were updated in milliseconds, with the task pipeline it's only gathering of inputs and launching of decisions. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float AIMs = 0.f;
+
+	/** How long the shared AI snapshot was built for the launched decisions in milliseconds, is used by the task pipeline only. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float SnapshotMs = 0.f;
+
+	/** How long decisions of the previous step were made on workers in milliseconds, is used by the task pipeline only. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float DecisionsMs = 0.f;
+
+	/** How long the game thread waited for decisions of the previous step in milliseconds, is used by the task pipeline only.
+	 * Is above 0 when decisions take longer than the rest of the frame, so the AI limits scaling by bot count and map size. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float DecisionsWaitMs = 0.f;
+
+	/** How long decisions of the previous step were applied on the game thread in milliseconds, including the wait. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float ApplyMs = 0.f;
+
+	/** How long the whole step took in milliseconds. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "C++")
+	float TotalMs = 0.f;
+};
+
+/**
+ * Runs the grid game logic on the server by fixed steps instead of separate actor timers, so the order of events is always defined.
+ * Each step processes its phases in the next order:
+ * 1. Bomb timers: bombs whose detonation time has come are collected from the fuse wheel, the earliest one is the first.
+ * 2. Explosions: collected bombs are detonated one by one with their chain reactions.
+ * 3. Pickups: items overlapped since the previous step are picked up by their players.
+ * 4. AI: bots are updated by the AI Scheduler Subsystem.
+ * - Bomber.Simulation.StepRate: number of steps per second, 0 to run one step per frame.
+ * - Bomber.Simulation.MaxStepsPerFrame: limits catching up after a hitch, the rest of the time is skipped.
+ * - Bomber.Simulation.TaskPipeline: runs the step as the task graph where decisions of bots overlap with the rest of the frame:
+ *   0. Apply: decisions launched by the previous step are waited and applied on the game thread.
+ *   1-3. Bomb timers, explosions and pickups are resolved serially on the game thread, since they change level actors.
+ *   4. Snapshot: the shared copy of the level state is built on the game thread.
+ *   5. AI: inputs of due bots are gathered and their decisions are launched as a task over the snapshot, making them in parallel.
+ * Fuses of all bombs are held by one bucketed timer wheel instead of a timer per bomb:
+ * each slot of the wheel is one step, so scheduling and cancelling are O(1) and each step visits only its own bucket.
+ */
+UCLASS()
+class BOMBER_API UGridSimulationSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Is called after each simulation step on the server, the step number is passed. */
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnSimulationStep, int64 /*StepNumber*/);
+	FOnSimulationStep OnSimulationStep;
+
+	/** Is called before the first phase of each simulation step on the server, the number of the starting step is passed. */
+	FOnSimulationStep OnPreSimulationStep;
+
+	/** Returns the Grid Simulation Subsystem, is checked and wil crash if can't be obtained. */
+	static UGridSimulationSubsystem& Get(const UObject* WorldContextObject = nullptr);
+
+	/** Returns the pointer to the Grid Simulation Subsystem. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UGridSimulationSubsystem* GetGridSimulationSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns the length of one step in seconds, 0 if each frame is one step. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static float GetStepSeconds();
+
+	/** Detonates given bomb on the first step that reaches its detonation time, replaces previous schedule of this bomb. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void ScheduleBomb(ABombActor* Bomb, double DetonationTime);
+
+	/** Cancels the detonation of given bomb if it is scheduled. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void UnscheduleBomb(const ABombActor* Bomb);
+
+	/** Cancels the fuse of given bomb and detonates it right away, e.g. when it is removed from the level. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void DetonateBombNow(ABombActor* Bomb);
+
+	/** Returns the world time in seconds when given bomb is going to explode, MAX_flt if it is not scheduled. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	float GetBombDetonationTime(const ABombActor* Bomb) const;
+
+	/** Returns seconds left until given bomb explodes, MAX_flt if it is not scheduled. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	float GetBombFuseRemaining(const ABombActor* Bomb) const;
+
+	/** Returns the number of bombs with burning fuses. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetFusesNum() const { return FusesInternal.Num(); }
+
+	/** Picks up given item by given player on the next step. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void QueuePickup(AItemActor* Item, APlayerCharacter* Player);
+
+	/** Returns the number of steps processed since the simulation was started. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int64 GetStepNumber() const { return LastStepStatsInternal.StepNumber; }
+
+	/** Returns the world time in seconds of the last processed step. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE double GetSimulationTime() const { return SimulationTimeInternal; }
+
+	/** Returns CPU time spent on each phase of the last step. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE FGridSimulationStepStats GetLastStepStats() const { return LastStepStatsInternal; }
+
+	/** Stops or resumes processing of steps, so bots and fuses are not updated while the server is idle.
+	 * On resuming, the next step is aligned to the current time instead of catching up the paused time. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "C++")
+	void SetSimulationPaused(bool bPause);
+
+	/** Returns true if steps are not processed, @see UGridSimulationSubsystem::SetSimulationPaused. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsSimulationPaused() const { return bIsSimulationPausedInternal; }
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** Fuses of all scheduled bombs by their bombs. */
+	TMap<TObjectKey<ABombActor>, FGridSimulationBomb> FusesInternal;
+
+	/** Buckets of the fuse wheel, bombs are stored in the bucket of their slot in the order of scheduling. */
+	TArray<TArray<TObjectKey<ABombActor>>> FuseWheelInternal;
+
+	/** The length of one slot of the fuse wheel in seconds, is taken from the step length when the wheel is empty. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Fuse Slot Seconds"))
+	double FuseSlotSecondsInternal = 0.0;
+
+	/** The last slot of the fuse wheel whose bombs are all collected. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Fuse Slot"))
+	int64 LastFuseSlotInternal = 0;
+
+	/** Items overlapped since the previous step in the order of overlapping. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Pending Pickups"))
+	TArray<FGridSimulationPickup> PendingPickupsInternal;
+
+	/** The world time in seconds of the last processed step, is negative until the first step. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Simulation Time"))
+	double SimulationTimeInternal = -1.0;
+
+	/** CPU time spent on each phase of the last step. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Last Step Stats"))
+	FGridSimulationStepStats LastStepStatsInternal;
+
+	/** If true, steps are not processed, is set while the dedicated server is idle. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Simulation Paused"))
+	bool bIsSimulationPausedInternal = false;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds, the simulation itself runs only on the server. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Is ticked only on the server. */
+	virtual bool IsTickable() const override;
+
+	/** Runs all steps that are due by current world time. */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id of this tickable object. */
+	virtual TStatId GetStatId() const override;
+
+	/** Processes all phases of one step in their order. */
+	void ProcessStep(float StepSeconds);
+
+	/** Returns the absolute slot of the fuse wheel for given world time. */
+	int64 GetFuseSlot(double Time) const;
+
+	/** Moves all bombs whose detonation time has come from the fuse wheel to given array sorted by their detonation time. */
+	void CollectDueBombs(TArray<FGridSimulationBomb>& OutDueBombs);
+
+	/** Detonates given bombs in their order. */
+	void DetonateBombs(const TArray<FGridSimulationBomb>& DueBombs);
+
+	/** Picks up all pending items in the order of overlapping, the item is taken by the first player only. */
+	void ProcessPickups();
+};
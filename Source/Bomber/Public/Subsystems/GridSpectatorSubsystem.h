@@ -0,0 +1,157 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "Structures/GridSpectatorStream.h"
+//---
+#include "GridSpectatorSubsystem.generated.h"
+
+enum class ECurrentGameState : uint8;
+
+/**
+ * Streams matches to spectators as grid events instead of replicating level actors to them.
+ * Server sends the layout bitmask once, then the ordered events of each simulation step and player positions at reduced frequency.
+ * Spectator clients rebuild the grid locally from this stream, so the cost of each spectator is a few bytes per step.
+ * Clients join as spectators by the 'SpectatorOnly=1' URL option, level actors are not relevant for them.
+ */
+UCLASS()
+class BOMBER_API UGridSpectatorSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Delegates
+	 * --------------------------------------------------- */
+
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSpectatorLayoutChanged);
+
+	/** Is called on spectator clients when the whole layout is received, e.g: on joining or on match start. */
+	UPROPERTY(BlueprintAssignable, Transient, Category = "C++")
+	FOnSpectatorLayoutChanged OnSpectatorLayoutChanged;
+
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSpectatorEvent, const FGridReplayEvent&, Event);
+
+	/** Is called on spectator clients for each received grid event after it is applied to the local grid. */
+	UPROPERTY(BlueprintAssignable, Transient, Category = "C++")
+	FOnSpectatorEvent OnSpectatorEvent;
+
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the pointer to the Grid Spectator Subsystem, is null if spectators are disabled. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UGridSpectatorSubsystem* GetGridSpectatorSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true if given viewer is the spectator that watches the stream, so level actors are not replicated to it. */
+	static bool IsStreamViewer(const AActor* RealViewer);
+
+	/** Server-only: starts streaming to given spectator beginning with the current layout. */
+	void AddSpectator(class AMyPlayerController* Spectator);
+
+	/** Server-only: stops streaming to given spectator. */
+	void RemoveSpectator(const class AMyPlayerController* Spectator);
+
+	/** Server-only: adds the event to be sent to spectators at the end of the current simulation step.
+	 * @param Type The type of the event.
+	 * @param Cell The cell where the event happened.
+	 * @param Value The ID of the causer character or the number of bombs in the chain.
+	 * @param Param The actor or item type. */
+	void AddEvent(EGridReplayEventType Type, const struct FCell& Cell, int32 Value = INDEX_NONE, uint8 Param = 0);
+
+	/** Returns true if there is at least one spectator to stream to. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool HasSpectators() const { return !SpectatorsInternal.IsEmpty(); }
+
+	/** Client-only: replaces the local grid by received layout. */
+	void ApplyLayout(const FGridSpectatorLayout& Layout);
+
+	/** Client-only: applies received events to the local grid in their order. */
+	void ApplyEvents(const FGridSpectatorEvents& Events);
+
+	/** Client-only: remembers received player positions. */
+	void ApplyPlayers(const FGridSpectatorPlayers& Players);
+
+	/** Returns EActorType bitmask of the cell on the locally rebuilt grid. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	int32 GetCellActorTypes(int32 CellIndex) const;
+
+	/** Returns the item type on the cell of the locally rebuilt grid, 0 if there is no item. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE uint8 GetCellItemType(int32 CellIndex) const { return ItemTypesInternal.FindRef(CellIndex); }
+
+	/** Returns the last received positions of alive players. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE TArray<FGridSpectatorPlayer>& GetSpectatedPlayers() const { return PlayersInternal.Players; }
+
+	/** Returns the layout the local grid is rebuilt on. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	const FORCEINLINE FGridSpectatorLayout& GetSpectatedLayout() const { return LayoutInternal; }
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** Server: spectators the match is streamed to. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Spectators"))
+	TArray<TWeakObjectPtr<class AMyPlayerController>> SpectatorsInternal;
+
+	/** Server: events of the current step that are not sent yet. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Pending Events"))
+	FGridSpectatorEvents PendingEventsInternal;
+
+	/** Server: characters of the current match which positions are sent. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Characters"))
+	TArray<TWeakObjectPtr<class APlayerCharacter>> CharactersInternal;
+
+	/** Client: the grid rebuilt from received layout and events. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Layout"))
+	FGridSpectatorLayout LayoutInternal;
+
+	/** Client: types of items by their cell indices. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Item Types"))
+	TMap<int32, uint8> ItemTypesInternal;
+
+	/** Client: last received positions of players. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Players"))
+	FGridSpectatorPlayers PlayersInternal;
+
+	/** Server: sends player positions at reduced frequency while there are spectators. */
+	FTimerHandle PlayersTimerInternal;
+
+	/** Handle of listened steps of the Grid Simulation Subsystem. */
+	FDelegateHandle SimulationStepHandle;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created for game worlds when the 'Bomber.Spectator.Enabled' is set. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Starts listening simulation steps and game states on the server. */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Stops listening simulation steps. */
+	virtual void Deinitialize() override;
+
+	/** Resends the layout on match start since the level is regenerated. */
+	UFUNCTION()
+	void OnGameStateChanged(ECurrentGameState CurrentGameState);
+
+	/** Sends pending events of finished step to all spectators. */
+	void OnSimulationStep(int64 StepNumber);
+
+	/** Returns the current grid as the layout to be sent. */
+	FGridSpectatorLayout MakeLayout() const;
+
+	/** Sends the current grid to given spectator together with types of items that are already on the level. */
+	void SendLayout(class AMyPlayerController& Spectator) const;
+
+	/** Sends positions of alive players to all spectators. */
+	void SendPlayers();
+};
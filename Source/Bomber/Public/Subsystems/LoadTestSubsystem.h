@@ -0,0 +1,146 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "Containers/Ticker.h"
+//---
+#include "LoadTestSubsystem.generated.h"
+
+enum class ECurrentGameState : uint8;
+
+/**
+ * Measures how many sessions a server box can host by cycling matches that are watched by simulated clients.
+ * Is created only on the server launched with the -LoadTest[=ClientsNum] argument, e.g.:
+ * BomberServer.exe -log -LoadTest=3 -LoadTestMinutes=30 -LoadTestOutput=D:/LoadTest.csv [-LoadTestClientExe=D:/Bomber.exe]
+ * - Given number of headless clients are launched and connected to this server: -nullrhi -nosound -LoadTestClient, cosmetics are not created there.
+ * - Characters of all players are played by bots on the server, so clients receive the same replication as in the real match.
+ * - Matches are cycled Menu -> Game Starting -> In-Game -> End-Game -> Menu once all clients are connected.
+ * - Once per second the tick time of the world, replication CPU, bandwidth of each connection and sent bytes are written to the CSV file.
+ * - Network stats by their source are counted along, they are dumped to the log when the load test is finished.
+ */
+UCLASS()
+class BOMBER_API ULoadTestSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the pointer to the Load Test Subsystem, is null if the load test is not enabled. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static ULoadTestSubsystem* GetLoadTestSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true if the server is launched to run the load test. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsLoadTestEnabled();
+
+	/** Returns true if the game is launched as the simulated client of the load test. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsLoadTestClient();
+
+	/** Returns the number of launched clients that are still running. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	int32 GetRunningClientsNum() const;
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** Seconds to stay in the Menu state between matches. */
+	static constexpr float MenuDelay = 2.f;
+
+	/** Seconds to wait for all clients to be connected, the match is started with connected ones after that. */
+	static constexpr float ConnectTimeout = 60.f;
+
+	/** Path to the CSV file where samples are appended. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Output File Path"))
+	FString OutputFilePathInternal;
+
+	/** The number of clients to launch. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Clients Num"))
+	int32 ClientsNumInternal = 0;
+
+	/** Minutes to run the load test, is not limited if 0. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Duration Minutes"))
+	float DurationMinutesInternal = 0.f;
+
+	/** Is true while the next match is going to be started. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Match Start Pending"))
+	bool bIsMatchStartPendingInternal = false;
+
+	/** Processes of launched clients. */
+	TArray<FProcHandle> ClientProcessesInternal;
+
+	/** The platform time when the load test was started. */
+	double LoadStartTimeInternal = 0.0;
+
+	/** The platform time when the Menu state was entered. */
+	double MenuStartTimeInternal = 0.0;
+
+	/** The platform time when the last sample was written. */
+	double LastSampleTimeInternal = 0.0;
+
+	/** The platform time when the current world tick and the current net flush were started. */
+	double WorldTickStartTimeInternal = 0.0;
+	double TickFlushStartTimeInternal = 0.0;
+
+	/** Summary and longest world tick time in seconds and the number of ticks since the last sample. */
+	double TickSecondsInternal = 0.0;
+	double MaxTickSecondsInternal = 0.0;
+	int32 TicksNumInternal = 0;
+
+	/** Summary time in seconds of flushing the net driver since the last sample, it's where actors are replicated to connections. */
+	double ReplicationSecondsInternal = 0.0;
+
+	/** Bytes sent by the game net driver when the last sample was written. */
+	uint64 LastOutBytesInternal = 0;
+
+	/** Handles of delegates that measure each tick of the world. */
+	FTSTicker::FDelegateHandle FrameTickerHandleInternal;
+	FDelegateHandle WorldTickStartHandleInternal;
+	FDelegateHandle TickFlushHandleInternal;
+	FDelegateHandle PostTickFlushHandleInternal;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds launched with the -LoadTest argument. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Launches clients, starts listening the game states and measuring ticks. */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Stops measuring and closes launched clients. */
+	virtual void Deinitialize() override;
+
+	/** Launches given number of headless clients connected to this server. */
+	void LaunchClients(const UWorld& InWorld);
+
+	/** Moves the game to the next state of the cycle. */
+	UFUNCTION()
+	void OnGameStateChanged(ECurrentGameState CurrentGameState);
+
+	/** Sets given game state after the delay, so all listeners of the current state are notified first. */
+	void SetGameStateDelayed(ECurrentGameState NewGameState, float Delay);
+
+	/** Is called when the world starts ticking. */
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaTime);
+
+	/** Is called when the world starts flushing the net driver. */
+	void OnTickFlush(float DeltaTime);
+
+	/** Is called when the net driver of the world is flushed, ends the measured world tick. */
+	void OnPostTickFlush();
+
+	/** Writes the sample once per second, starts the match once clients are connected and finishes the load test once the duration is passed. */
+	bool OnFrameTick(float DeltaTime);
+
+	/** Writes all measured values since the last sample to the CSV file and resets them. */
+	void WriteSample();
+};
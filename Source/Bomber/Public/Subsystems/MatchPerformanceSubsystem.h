@@ -0,0 +1,112 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "Containers/Ticker.h"
+//---
+#include "MatchPerformanceSubsystem.generated.h"
+
+enum class ECurrentGameState : uint8;
+
+/**
+ * Writes the performance summary of each match on the server once the match is ended, so slow matches could be found among many sessions.
+ * Is created only if the game is launched with the -MatchPerfReport argument, e.g.:
+ * BomberServer.exe -MatchPerfReport=D:/MatchPerf.csv
+ * - Frame times are sampled on the core ticker during the In-Game state.
+ * - Decision timings of bots, explosions, time of destroying level actors, peak number of level actors and sent bytes are summarized.
+ * - One row per match is appended to the CSV file, so results of all sessions could be aggregated from one file.
+ */
+UCLASS()
+class BOMBER_API UMatchPerformanceSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the pointer to the Match Performance Subsystem, is null if the report is not enabled. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static UMatchPerformanceSubsystem* GetMatchPerformanceSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true if the game is launched to write match performance reports. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsReportEnabled();
+
+	/** Is called by bombs to count resolved explosions of the current match. */
+	void AddExplosions(int32 ExplosionsNum);
+
+	/** Is called by the Generated Map to count the time of destroying level actors of the current match. */
+	void AddDestroyLevelActorsTime(double Seconds);
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** Path to the CSV file where reports are appended. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Output File Path"))
+	FString OutputFilePathInternal;
+
+	/** The number of already reported matches. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Reported Matches Num"))
+	int32 ReportedMatchesNumInternal = 0;
+
+	/** Is true while the match is measured. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Match Measured"))
+	bool bIsMatchMeasuredInternal = false;
+
+	/** The platform time when the current match was started. */
+	double MatchStartTimeInternal = 0.0;
+
+	/** Every frame time in seconds of the current match. */
+	TArray<float> FrameTimesInternal;
+
+	/** The number of resolved explosions in the current match. */
+	int32 ExplosionsNumInternal = 0;
+
+	/** The number of calls and summary time in seconds of destroying level actors in the current match. */
+	int32 DestroyLevelActorsCallsInternal = 0;
+	double DestroyLevelActorsSecondsInternal = 0.0;
+
+	/** The largest number of level actors on the grid in the current match. */
+	int32 PeakMapComponentsNumInternal = 0;
+
+	/** Bytes sent by the game net driver when the current match was started. */
+	uint64 MatchStartOutBytesInternal = 0;
+
+	/** Handle of the frame sampling on the core ticker. */
+	FTSTicker::FDelegateHandle FrameTickerHandleInternal;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds launched with the -MatchPerfReport argument. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Starts listening the game states. */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Stops sampling frames. */
+	virtual void Deinitialize() override;
+
+	/** Starts measuring on the In-Game state and writes the report on the End-Game state. */
+	UFUNCTION()
+	void OnGameStateChanged(ECurrentGameState CurrentGameState);
+
+	/** Resets all counters and starts sampling frames. */
+	void OnMatchStarted();
+
+	/** Writes the report of the finished match. */
+	void OnMatchEnded();
+
+	/** Samples the frame time and the number of level actors during the match. */
+	bool OnFrameTick(float DeltaTime);
+
+	/** Returns the number of bytes sent by the game net driver, 0 for the standalone game. */
+	uint64 GetOutBytes() const;
+};
@@ -0,0 +1,59 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "PlayWorldSubsystem.generated.h"
+
+class AMyGameStateBase;
+class UGeneratedMapSubsystem;
+class USoundsSubsystem;
+
+/**
+ * Caches the play world with its frequently requested game objects, so hot getters don't resolve the world on each call.
+ * Each game world registers itself on initialization by its PIE instance and unregisters on teardown.
+ * Editor worlds are not supported, getters resolve the world as before there.
+ */
+UCLASS()
+class BOMBER_API UPlayWorldSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the subsystem of the world of given context object or of the current play world, nullptr if it is not a game world. */
+	static UPlayWorldSubsystem* GetPlayWorldSubsystem(const UObject* OptionalWorldContext = nullptr);
+
+	/** Returns the Bomber Game State of this world, nullptr if it is not spawned yet. */
+	AMyGameStateBase* GetMyGameState() const;
+
+	/** Returns the Generated Map Subsystem of this world. */
+	FORCEINLINE UGeneratedMapSubsystem* GetGeneratedMapSubsystem() const { return GeneratedMapSubsystemInternal; }
+
+	/** Returns the Sounds Subsystem of this world, is resolved on first request since its class is set in the data asset. */
+	USoundsSubsystem* GetSoundsSubsystem() const;
+
+protected:
+	/** The Generated Map Subsystem, is initialized together with this one. */
+	UPROPERTY(Transient)
+	TObjectPtr<UGeneratedMapSubsystem> GeneratedMapSubsystemInternal = nullptr;
+
+	/** The Sounds Subsystem, is cached on first request. */
+	UPROPERTY(Transient)
+	mutable TObjectPtr<USoundsSubsystem> SoundsSubsystemInternal = nullptr;
+
+	/** Subsystems of game worlds by their PIE instance + 1, so the standalone game is the first one. */
+	static TArray<TWeakObjectPtr<UPlayWorldSubsystem>> PlayWorldSubsystems;
+
+	/** Returns the index of given world in PlayWorldSubsystems. */
+	static int32 GetPlayWorldIndex(const UWorld& World);
+
+	/** Is created only for game worlds, since the editor world is resolved by the editor context. */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Registers this world as current play world of its PIE instance. */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Unregisters this world if it is still current one of its PIE instance. */
+	virtual void Deinitialize() override;
+};
@@ -0,0 +1,94 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "RenderWarmUpSubsystem.generated.h"
+
+enum class ECurrentGameState : uint8;
+
+/**
+ * Warms up render states of level actors and explosions on clients while the menu is shown,
+ * so the first bomb and the first render of each level type do not hitch by shader and PSO compilation.
+ * For each level type of UGeneratedMapDataAsset::GetLevelStreamRows, meshes of walls, boxes, items, bombs and players
+ * are set to transient components out of view with all bomb materials and player skins, then their PSOs are precached.
+ * The explosion VFX is activated once there as well, the warm-up actor is destroyed after few seconds.
+ * Once each match is starting, the world Niagara pool is prewarmed by explosions of the current tier, see FExplosionVFXTier::PrewarmNum.
+ * Can be disabled by 'Bomber.WarmUp.Enabled 0'.
+ */
+UCLASS()
+class BOMBER_API URenderWarmUpSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the pointer to the Render Warm Up Subsystem, is null on the dedicated server. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static URenderWarmUpSubsystem* GetRenderWarmUpSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true if the warm-up is finished. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsWarmedUp() const { return bIsWarmedUpInternal; }
+
+	/** Returns the number of components that were created to warm up render states. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetWarmedUpComponentsNum() const { return WarmedUpComponentsNumInternal; }
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** How long warm-up components are kept alive, so asynchronous compilation of their PSOs and the VFX are started. */
+	static constexpr float WarmUpSeconds = 3.f;
+
+	/** The transient actor that owns all warm-up components, is destroyed once the warm-up is finished. */
+	UPROPERTY(Transient)
+	TObjectPtr<AActor> WarmUpActorInternal = nullptr;
+
+	/** Is true once the warm-up is finished. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Warmed Up"))
+	bool bIsWarmedUpInternal = false;
+
+	/** The number of components that were created to warm up render states. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Warmed Up Components Num"))
+	int32 WarmedUpComponentsNumInternal = 0;
+
+	/** Destroys the warm-up actor once its time is passed. */
+	FTimerHandle WarmUpTimerInternal;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds that render, so not on the dedicated server. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Starts the warm-up once all data assets are loaded and starts listening the game states. */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Destroys the warm-up actor if it is still alive. */
+	virtual void Deinitialize() override;
+
+	/** Creates warm-up components for all level types, precaches their PSOs and activates the explosion VFX. */
+	void StartWarmUp();
+
+	/** Creates the transient component out of view with given static or skeletal mesh and material, then precaches its PSOs. */
+	void WarmUpMesh(class UStreamableRenderAsset* Mesh, class UMaterialInterface* Material = nullptr);
+
+	/** Destroys the warm-up actor with all its components. */
+	void FinishWarmUp();
+
+	/** Prewarms explosions on the Game Starting state. */
+	UFUNCTION()
+	void OnGameStateChanged(ECurrentGameState CurrentGameState);
+
+	/** Spawns pooled explosions out of view by the explosion tier of current game settings,
+	 * so they are released to the world Niagara pool and the first blasts of the match reuse them. */
+	void PrewarmExplosionVFX();
+};
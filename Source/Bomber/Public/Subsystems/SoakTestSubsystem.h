@@ -0,0 +1,123 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+//---
+#include "Containers/Ticker.h"
+//---
+#include "SoakTestSubsystem.generated.h"
+
+enum class ECurrentGameState : uint8;
+
+/**
+ * Metrics sampled once per match by the soak test, each of them is expected to stay flat over long uptime.
+ */
+enum class ESoakTestMetric : uint8
+{
+	UsedMemoryMB,
+	UObjectsNum,
+	PooledActorsNum,
+	TextRendersNum,
+	NiagaraComponentsNum,
+	MeshInstancesNum,
+	AverageFrameMs,
+	Num
+};
+
+/**
+ * Cycles bot-only matches for hours to find leaks and unbounded growth that appear only over long uptime, such as on kiosk builds.
+ * Is created only if the game is launched with the -SoakTest[=Hours] argument, e.g.:
+ * Bomber.exe -game -SoakTest=12 -SoakTestOutput=D:/Soak.csv
+ * - Each character, including the one of the local player, is possessed by the bot.
+ * - Game states are cycled Menu -> Game Starting -> In-Game -> End-Game -> Menu, the game is closed once the given hours are passed.
+ * - Memory, UObjects, pooled actors, text renders, Niagara components, mesh instances and frame time are sampled after each match.
+ * - A metric is flagged if it grows after each of the last matches, flags are logged and written to the CSV file.
+ */
+UCLASS()
+class BOMBER_API USoakTestSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* ---------------------------------------------------
+	 *		Public functions
+	 * --------------------------------------------------- */
+
+	/** Returns the pointer to the Soak Test Subsystem, is null if the soak test is not enabled. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "WorldContextObject"))
+	static USoakTestSubsystem* GetSoakTestSubsystem(const UObject* WorldContextObject = nullptr);
+
+	/** Returns true if the game is launched to run the soak test. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static bool IsSoakTestEnabled();
+
+	/** Returns the number of already finished matches. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE int32 GetFinishedMatchesNum() const { return FinishedMatchesNumInternal; }
+
+protected:
+	/* ---------------------------------------------------
+	 *		Protected properties
+	 * --------------------------------------------------- */
+
+	/** The number of last matches a metric has to grow in a row to be flagged. */
+	static constexpr int32 GrowthWindow = 8;
+
+	/** Seconds to stay in the Menu state between matches. */
+	static constexpr float MenuDelay = 2.f;
+
+	/** Path to the CSV file where samples are appended. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Output File Path"))
+	FString OutputFilePathInternal;
+
+	/** Hours to run the soak test, is not limited if 0. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Duration Hours"))
+	float DurationHoursInternal = 0.f;
+
+	/** The number of already finished matches. */
+	UPROPERTY(VisibleInstanceOnly, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Finished Matches Num"))
+	int32 FinishedMatchesNumInternal = 0;
+
+	/** The platform time when the soak test was started. */
+	double SoakStartTimeInternal = 0.0;
+
+	/** Summary frame time in seconds and the number of frames of the current match. */
+	double MatchFrameSecondsInternal = 0.0;
+	int32 MatchFramesNumInternal = 0;
+
+	/** Last samples of each metric, the oldest one goes first. */
+	TArray<double> SamplesInternal[static_cast<int32>(ESoakTestMetric::Num)];
+
+	/** Handle of the frame sampling on the core ticker. */
+	FTSTicker::FDelegateHandle FrameTickerHandleInternal;
+
+	/* ---------------------------------------------------
+	 *		Protected functions
+	 * --------------------------------------------------- */
+
+	/** Is created only for game worlds launched with the -SoakTest argument. */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Starts listening the game states and sampling frames. */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Stops sampling frames. */
+	virtual void Deinitialize() override;
+
+	/** Moves the game to the next state of the cycle. */
+	UFUNCTION()
+	void OnGameStateChanged(ECurrentGameState CurrentGameState);
+
+	/** Sets given game state after the delay, so all listeners of the current state are notified first. */
+	void SetGameStateDelayed(ECurrentGameState NewGameState, float Delay);
+
+	/** Samples all metrics of the finished match, writes them and closes the game once the duration is passed. */
+	void OnMatchEnded();
+
+	/** Counts the frame time of the current match. */
+	bool OnFrameTick(float DeltaTime);
+
+	/** Returns the current value of given metric. */
+	double SampleMetric(ESoakTestMetric Metric) const;
+};
@@ -7,6 +7,10 @@
 #include "SoundsSubsystem.generated.h"
 
 class UAudioComponent;
+class USoundBase;
+class USoundWave;
+
+struct FStreamableHandle;
 
 enum class ELevelType : uint8;
 enum class ECurrentGameState : uint8;
@@ -37,7 +41,7 @@ public:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Active End-Game Countdown SFX"))
 	TObjectPtr<UAudioComponent> ActiveEndGameCountdownSFX = nullptr;
 
-	/** Set new sound volume.
+	/** Set new sound volume, is applied once on the next frame, so only the last value of dragged slider is pushed to the sound mix.
 	 * @param InSoundClass The of the sounds.
 	 * @param InVolume New value to set. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
@@ -116,6 +120,29 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Background Music Component"))
 	TObjectPtr<UAudioComponent> BackgroundMusicComponentInternal = nullptr;
 
+	/** Pooled components that are reused to play explosion sounds, its size is limited by USoundsDataAsset::ExplosionMaxVoicesInternal. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Explosion SFX Pool"))
+	TArray<TObjectPtr<UAudioComponent>> ExplosionSFXPoolInternal;
+
+	/** Level music with retained compressed audio, the least recently needed one is the first.
+	 * @see USoundsSubsystem::PreloadLevelMusic */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Retained Music"))
+	TArray<TObjectPtr<USoundWave>> RetainedMusicInternal;
+
+	/** The index of the pooled explosion component to be stolen next when all of them are playing. */
+	int32 NextExplosionVoiceIndexInternal = 0;
+
+	/** The world time in seconds when the last explosion sound was started, is used to merge simultaneous explosions. */
+	double LastExplosionSFXTimeInternal = -1.0;
+
+	/** The handle of level music that is loaded in background, its level type is preloaded again once it's completed.
+	 * @see USoundsSubsystem::PreloadLevelMusic */
+	TSharedPtr<FStreamableHandle> LevelMusicHandleInternal = nullptr;
+
+	/** Volumes by sound classes that are waiting to be applied on the next frame.
+	 * @see USoundsSubsystem::SetSoundVolumeByClass */
+	TMap<TWeakObjectPtr<class USoundClass>, float> PendingVolumesInternal;
+
 	/* ---------------------------------------------------
 	 *		Protected functions
 	 * --------------------------------------------------- */
@@ -123,10 +150,38 @@ protected:
 	/** Called when world is ready to start gameplay before the game mode transitions to the correct state and call BeginPlay on all actors */
 	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
 
+	/** Releases all retained level music and writes pending volumes to config. */
+	virtual void Deinitialize() override;
+
 	/** Blueprint even called when the game starts. */
 	UFUNCTION(BlueprintImplementableEvent, Category = "C++", meta = (DisplayName = "Begin Play"))
 	void OnBeginPlay();
 
+	/** Preloads music of specified level and its neighbours in the levels list, since the main menu switches levels one by one.
+	 * Streamed music has its first chunk primed and its compressed audio retained, so the level switch starts it without a load stall.
+	 * Music of other levels is released from the least recently needed one while the memory budget is exceeded.
+	 * Music is soft referenced, so not loaded one is requested to be loaded in background first.
+	 * @see USoundsDataAsset::MusicMemoryBudgetInternal */
+	void PreloadLevelMusic(ELevelType CurrentLevelType);
+
+	/** Returns the soft references to music of specified level and its neighbours in the levels list. */
+	void GetNeededLevelMusic(ELevelType CurrentLevelType, TArray<TSoftObjectPtr<USoundBase>>& OutNeededMusic) const;
+
+	/** Primes and retains loaded music of specified level and its neighbours, releases other music over the memory budget. */
+	void RetainLevelMusic(ELevelType CurrentLevelType);
+
+	/** Is called when the music requested by PreloadLevelMusic is loaded, retains it and plays the current music. */
+	void OnLevelMusicLoaded(ELevelType LoadedLevelType);
+
+	/** Pushes all pending volumes to the main sound mix at once. */
+	void ApplyPendingVolumes();
+
+	/** Sets the config volume and requests deferred saving if it is changed. */
+	void UpdateConfigVolume(double& InOutConfigVolume, double InVolume);
+
+	/** Returns the pooled component to play next explosion: idle one, newly created one or the oldest playing one. */
+	UAudioComponent* AcquireExplosionAudioComponent(USoundBase* ExplosionSFX);
+
 	/** Is called to play the End-Game sound on ending the current game. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void OnEndGameStateChanged(EEndGameState EndGameState);
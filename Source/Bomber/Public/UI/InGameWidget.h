@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Blueprint/UserWidget.h"
+#include "Engine/TimerHandle.h"
 //---
 #include "InGameWidget.generated.h"
 
@@ -34,6 +35,18 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "C++", meta = (BlueprintProtected, BindWidget))
 	TObjectPtr<class UInGameMenuWidget> InGameMenuWidget = nullptr;
 
+	/** Optional box that wraps static parts of the HUD to cache them, the countdown should be placed outside or invalidate itself on change. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "C++", meta = (BlueprintProtected, BindWidgetOptional))
+	TObjectPtr<class UInvalidationBox> StaticContentInvalidationBox = nullptr;
+
+	/** Is scheduled to the moment when the displayed countdown second changes. */
+	UPROPERTY(BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Countdown Update Timer"))
+	FTimerHandle CountdownUpdateTimerInternal;
+
+	/** The last displayed second of the current countdown, is used to skip updates within the same second. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Displayed Countdown Seconds"))
+	int32 DisplayedCountdownSecondsInternal = INDEX_NONE;
+
 	/* ---------------------------------------------------
 	 *		Protected functions
 	 * --------------------------------------------------- */
@@ -48,10 +61,28 @@ protected:
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "C++", meta = (BlueprintProtected))
 	void LaunchStartingCountdown();
 
+	/** Is called while level actors are spawned during the starting countdown to show the progress.
+	 * @param Progress From 0 to 1, is 1 when all level actors are spawned. */
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "C++", meta = (BlueprintProtected))
+	void OnGenerationProgressChanged(float Progress);
+
 	/** Launch the main timer that count the seconds to the game ending. */
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "C++", meta = (BlueprintProtected))
 	void LaunchInGameCountdown();
 
+	/** Is called only when the displayed second of the current countdown is changed.
+	 * @param SecondsRemain Rounded up seconds that remain for the 'Three-two-one-GO' timer or to the end of the match. */
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "C++", meta = (BlueprintProtected))
+	void OnCountdownSecondChanged(int32 SecondsRemain);
+
+	/** Computes the remain seconds of the current countdown locally and schedules next update to the moment the displayed second changes. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void UpdateCountdown();
+
+	/** Stops updating the countdown, e.g. when the match is ended. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void StopCountdown();
+
 	/** Called when the current game state was changed. */
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "C++", meta = (BlueprintProtected))
 	void OnGameStateChanged(ECurrentGameState CurrentGameState);
@@ -46,7 +46,9 @@ class BOMBER_API UInputCategoryWidget final : public USettingSubWidget
 	GENERATED_BODY()
 
 public:
-	/** Sets the input context to be represented by this widget. */
+	/** Sets the input context to be represented by this widget.
+	 * Its input buttons are not created here, but on the first construction of this widget, so hidden categories cost nothing.
+	 * Buttons that are already created are rebuilt if given data differs from the current one. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void CreateInputButtons(const FInputCategoryData& InInputCategoryData);
 
@@ -82,7 +84,12 @@ protected:
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void UpdateStyle();
 
-	/** Adds all input buttons to the root of this widget. */
+	/** Creates input buttons for each mapping of own category data if they are not created yet.
+	 * Created buttons are kept by this widget, so they are reused on next openings of the settings until the category data is changed. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
+	void CreateInputButtonsIfNeeded();
+
+	/** Adds all input buttons to the root of this widget, already attached buttons are skipped. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (BlueprintProtected))
 	void AttachInputButtons();
 };
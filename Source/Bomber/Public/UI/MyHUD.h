@@ -6,6 +6,8 @@
 //---
 #include "MyHUD.generated.h"
 
+struct FStreamableHandle;
+
 /**
  * The custom HUD class. Also manages other widgets.
  * @see Access its data with UUIDataAsset (Content/Bomber/DataAssets/DA_UI).
@@ -32,6 +34,12 @@ public:
 	UPROPERTY(BlueprintCallable, BlueprintAssignable, Category = "C++")
 	FOnClose OnClose;
 
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSettingsWidgetCreated, class USettingsWidget*, SettingsWidget);
+
+	/** Is called to notify that the settings widget was created and constructed, it happens on demand after widgets initialization. */
+	UPROPERTY(BlueprintCallable, BlueprintAssignable, Category = "C++")
+	FOnSettingsWidgetCreated OnSettingsWidgetCreated;
+
 	/* ---------------------------------------------------
 	*		Public functions
 	* --------------------------------------------------- */
@@ -47,18 +55,28 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE class UInGameWidget* GetInGameWidget() const { return InGameWidgetInternal; }
 
-	/** Returns the current settings widget object. */
+	/** Returns the current settings widget object, might be null if it was not requested yet.
+	 * @see AMyHUD::GetOrCreateSettingsWidget */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE class USettingsWidget* GetSettingsWidget() const { return SettingsWidgetInternal; }
 
+	/** Returns the settings widget object, creates and constructs it right away if it was not created yet. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	class USettingsWidget* GetOrCreateSettingsWidget();
+
 	/** Returns the current FPS counter widget object. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE class UUserWidget* GetFPSCounterWidget() const { return FPSCounterWidgetInternal; }
 
-	/** Returns the nickname widget by a player index. */
+	/** Returns the nickname widget by a player index, might be null if it was not requested yet.
+	 * @see AMyHUD::GetOrCreateNicknameWidget */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE class UUserWidget* GetNicknameWidget(int32 Index) const { return NicknameWidgetsInternal.IsValidIndex(Index) ? NicknameWidgetsInternal[Index] : nullptr; }
 
+	/** Returns the nickname widget by a player index, creates it on first request. */
+	UFUNCTION(BlueprintCallable, Category = "C++")
+	class UUserWidget* GetOrCreateNicknameWidget(int32 Index);
+
 	/** Notify listen UI widgets to
 	close widget. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
@@ -72,6 +90,15 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++")
 	FORCEINLINE bool IsFPSCounterEnabled() const { return bIsFPSCounterEnabledInternal; }
 
+	/** Set true to show the live performance overlay on the HUD: AI time, grid queries, level actors, replication and explosions.
+	 * Its numbers are refreshed by the 'Bomber.UI.PerfOverlayInterval' rate, is not available in shipping build. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (DevelopmentOnly))
+	void SetPerfOverlayEnabled(bool bEnable);
+
+	/** Returns true if the live performance overlay is shown on the HUD. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	FORCEINLINE bool IsPerfOverlayEnabled() const { return bIsPerfOverlayEnabledInternal; }
+
 	/** Internal UUserWidget::CreateWidget wrapper. */
 	static UUserWidget* CreateWidgetByClass(APlayerController* PlayerController, TSubclassOf<UUserWidget> WidgetClass, bool bAddToViewport = true, int32 ZOrder = 0);
 
@@ -107,6 +134,27 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Config, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is FPS Counter Enabled"))
 	bool bIsFPSCounterEnabledInternal;
 
+	/** If true, the live performance overlay is drawn on the HUD, is toggled by the 'Bomber.Debug.PerfOverlay' cheat. */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Transient, Category = "C++", meta = (BlueprintProtected, DisplayName = "Is Perf Overlay Enabled"))
+	bool bIsPerfOverlayEnabledInternal = false;
+
+	/** Text lines of the performance overlay, are rebuilt only by the throttled rate and drawn as they are in between. */
+	TArray<FString> PerfOverlayLinesInternal;
+
+	/** The time and the frame number of the last overlay refresh, numbers are averaged over the frames since then. */
+	double PerfOverlayUpdateTimeInternal = 0.0;
+	uint64 PerfOverlayUpdateFrameInternal = 0;
+
+	/** Measured totals of each budgeted function on the last overlay refresh, the overlay shows their difference. */
+	TArray<double> PerfOverlayTotalMsInternal;
+	TArray<uint64> PerfOverlayTotalCallsInternal;
+
+	/** Keeps the settings widget class loaded once it is requested asynchronously. */
+	TSharedPtr<FStreamableHandle> SettingsWidgetClassHandleInternal = nullptr;
+
+	/** The value of 'Slate.EnableGlobalInvalidation' before it was enabled by this HUD, is restored on end play. */
+	TOptional<bool> PrevGlobalInvalidationInternal;
+
 	/* ---------------------------------------------------
 	*		Protected functions
 	* --------------------------------------------------- */
@@ -114,6 +162,15 @@ protected:
 	/** Init all widgets on gameplay starting before begin play. */
 	virtual void PostInitializeComponents() override;
 
+	/** Restores global Slate settings that were changed by this HUD. */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Draws the performance overlay if it is enabled. */
+	virtual void DrawHUD() override;
+
+	/** Rebuilds text lines of the performance overlay by numbers measured since the last refresh. */
+	void UpdatePerfOverlayLines();
+
 	/** Will try to start the process of initializing all widgets used in game. */
 	UFUNCTION(BlueprintCallable, Category = "C++")
 	void TryInitWidgets();
@@ -124,4 +181,10 @@ protected:
 
 	/** Is called right after the game was started and windows size is set. */
 	void OnViewportResizedWhenInit(class FViewport* Viewport, uint32 Index);
+
+	/** Starts loading the settings widget class in background to create the widget later without hitches. */
+	void RequestSettingsWidgetClass();
+
+	/** Is called when the settings widget class is loaded, creates the widget on next frame. */
+	void OnSettingsWidgetClassLoaded();
 };
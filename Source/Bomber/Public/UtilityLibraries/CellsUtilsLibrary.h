@@ -5,6 +5,7 @@
 #include "Kismet/BlueprintFunctionLibrary.h"
 //---
 #include "Structures/Cell.h"
+#include "Structures/CellMask.h"
 //---
 #include "CellsUtilsLibrary.generated.h"
 
@@ -161,11 +162,13 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "C1,C2", DisplayName = "Distance (Cell)", ScriptMethod = "Distance", Keywords = "magnitude,length"))
 	static FORCEINLINE double Cell_Distance(const FCell& C1, const FCell& C2) { return FCell::Distance<double>(C1, C2); }
 
-	/** Find the max distance between cells within specified set, where each 1 unit means one cell. */
+	/** Find the max distance between cells within specified set, where each 1 unit means one cell.
+	 * Is linear by the number of cells, use GetMaxDistanceOnLevel() for the whole level grid instead. */
 	UFUNCTION(BlueprintPure, Category = "C++")
 	static FORCEINLINE double GetCellArrayMaxDistance(const TSet<FCell>& Cells) { return FCell::GetCellArrayMaxDistance<double>(Cells); }
 
 	/** Finds the closest cell to the given cell within array of cells.
+	 * Walks all cells, use SnapCellOnLevel() to find the closest cell of the whole level grid in constant time.
 	 * @param Cells The array of cells to search in.
 	 * @param CellToCheck The start position of the cell to check. */
 	UFUNCTION(BlueprintPure, Category = "C++")
@@ -300,7 +303,7 @@ public:
 
 	/** Returns the cell by specified column (X) and row (Y) on current level if exists, invalid cell otherwise. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	static FORCEINLINE FCell GetCellByPositionOnLevel(int32 ColumnX, int32 RowY) { return GetCellByPositionOnGrid(FIntPoint(ColumnX, RowY), GetAllCellsOnLevel()); }
+	static FCell GetCellByPositionOnLevel(int32 ColumnX, int32 RowY);
 
 	/** Takes the cell and returns its column (X) and row (Y) position on current level if exists, -1 otherwise. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "InCell"))
@@ -327,11 +330,11 @@ public:
 #pragma region CornerCell
 	/** Returns 4 corner cells of the Generated Map respecting its current size. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	static FORCEINLINE TSet<FCell> GetCornerCellsOnLevel() { return GetCornerCellsOnGrid(GetAllCellsOnLevel()); }
+	static TSet<FCell> GetCornerCellsOnLevel();
 
 	/** Returns specified corner cell in given grid. */
 	UFUNCTION(BlueprintPure, Category = "C++")
-	static FORCEINLINE FCell GetCellByCornerOnLevel(EGridCorner CornerType) { return GetCellByCornerOnGrid(CornerType, GetAllCellsOnLevel()); }
+	static FCell GetCellByCornerOnLevel(EGridCorner CornerType);
 
 	/** Returns true if given cell is corner cell of current level. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "Cell"))
@@ -341,6 +344,11 @@ public:
 	 * @param CellToCheck The start position of the cell to check. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "CellToCheck"))
 	static FCell GetNearestCornerCellOnLevel(const FCell& CellToCheck);
+
+	/** Returns the max distance between cells of the level grid, where each 1 unit means one cell.
+	 * Is constant time: it is the diagonal between opposite corners by the cached size of the grid. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static double GetMaxDistanceOnLevel();
 #pragma endregion CornerCell
 
 	/** Returns all empty grid cell locations on the Generated Map where non of actors are present. */
@@ -353,6 +361,13 @@ public:
 	static TSet<FCell> GetAllCellsWithActors(
 		UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/Bomber.EActorType")) int32 ActorsTypesBitmask);
 
+	/** Returns the number of cells on the Generated Map that have actors of specified types.
+	 * If non of actors are chosen, returns the number of empty cells without actors.
+	 * Is cheaper than taking the length of GetAllCellsWithActors, since no set is built. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (Keywords = "Count"))
+	static int32 GetCellsNumWithActors(
+		UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/Bomber.EActorType")) int32 ActorsTypesBitmask);
+
 	/** Takes cells and returns only empty cells where non of actors are present.
 	 * Could be useful to extract only free no actor cells with within given cells. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (Keywords = "Free"))
@@ -409,10 +424,22 @@ public:
 		const TSet<FCell>& Cells,
 		UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/Bomber.EActorType")) int32 ActorsTypesBitmask);
 
+	/** Returns the number of steps by free cells from specified cell to the nearest cell with actors of specified types, -1 if it can't be reached.
+	 * Is taken from the distance map cached by the Generated Map, so it is cheap to call for many cells per tick.
+	 * Could be useful to find how far is the nearest item or player. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "Cell", Keywords = "Distance,Path"))
+	static int32 GetDistanceToActors(
+		const FCell& Cell,
+		UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/Bomber.EActorType")) int32 ActorsTypesBitmask);
+
+	/** Returns the number of steps by free cells from specified cell to the nearest cell that is not going to be exploded, -1 if there is no way to be safe. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "Cell", Keywords = "Distance,Path"))
+	static int32 GetDistanceToSafety(const FCell& Cell);
+
 	/** Returns true if specified cell is present on the Generated Map.
 	 * Could be useful to check is input cell valid. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "Cell", Keywords = "Valid"))
-	static FORCEINLINE bool IsCellExistsOnLevel(const FCell& Cell) { return Cell.IsValid() && GetAllCellsOnLevel().Contains(Cell); }
+	static bool IsCellExistsOnLevel(const FCell& Cell);
 
 	/** Returns true if the cell is present on the Generated Map with such row and column indexes.
 	 * Could be useful to check row and and column. */
@@ -421,12 +448,12 @@ public:
 
 	/** Returns true if at least one cell is present on the Generated Map.*/
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (Keywords = "Valid"))
-	static FORCEINLINE bool IsAnyCellExistsOnLevel(const TSet<FCell>& Cells) { return GetAllCellsOnLevel().Intersect(Cells).Num() > 0; }
+	static bool IsAnyCellExistsOnLevel(const TSet<FCell>& Cells);
 
 	/** Returns true if all specified cells are present on the Generated Map.
 	 * Could be useful to determine are all input cells valid. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (Keywords = "valid"))
-	static FORCEINLINE bool AreAllCellsExistOnLevel(const TSet<FCell>& Cells) { return GetAllCellsOnLevel().Includes(Cells); }
+	static bool AreAllCellsExistOnLevel(const TSet<FCell>& Cells);
 
 	/** Returns cells around the center in specified radius and according desired type of breaks.
 	 * Could be useful to find all possible ways around.
@@ -443,6 +470,7 @@ public:
 
 	/** Returns cells that match specified actors in specified radius from a center, according desired type of breaks.
 	 * If non of actors are chosen, returns matching empty cells around without actors.
+	 * Actors are found only in chunks overlapped by the radius, @see AGeneratedMap::GetCellIndicesInArea.
 	 * Could be useful to determine are there any players or items around.
 	 *
 	 * @param CenterCell The start of searching in specified direction.
@@ -554,19 +582,87 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "Cell"))
 	static FCell RotateCellAroundLevelOrigin(const FCell& Cell, float AxisZ);
 
-	/** Gets a copy of given cell snapped to nearest cell on the level grid. */
+	/** Gets a copy of given cell snapped to nearest cell on the level grid.
+	 * Is constant time: the cell is projected on the grid axes instead of searching over all cells. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "InCell", Keywords = "Grid Snap,near"))
-	static FORCEINLINE FCell SnapCellOnLevel(const FCell& Cell) { return GetCellArrayNearest(GetAllCellsOnLevel(), Cell); }
+	static FCell SnapCellOnLevel(const FCell& Cell);
 
-	/** Returns nearest free cell to given cell, where free means cell with no other level actors except players. */
+	/** Returns nearest free cell to given cell, where free means cell with no other level actors except players.
+	 * Is searched by expanding rings around the snapped cell on the occupancy grid, so usually only a few cells are checked. */
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "Cell"))
 	static FCell GetNearestFreeCell(const FCell& Cell);
 
+	/* ---------------------------------------------------
+	 *		Cell mask utilities
+	 * --------------------------------------------------- */
+
+	/** Returns the mask of given cells, cells that don't exist on the level are skipped. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "To Cell Mask (Cells)", CompactNodeTitle = "->", BlueprintAutocast))
+	static FCellMask Conv_CellsToCellMask(const TSet<FCell>& Cells);
+
+	/** Returns cells of given mask, is the only operation on the mask that allocates the set. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "To Cells (Cell Mask)", CompactNodeTitle = "->", BlueprintAutocast))
+	static TSet<FCell> Conv_CellMaskToCells(const FCellMask& Mask);
+
+	/** Returns cells of given mask as the array ordered by row-major index, so it's cheaper to iterate than the set. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (Keywords = "Cells"))
+	static TArray<FCell> CellMaskToArray(const FCellMask& Mask);
+
+	/** Returns the mask of all cells with actors of specified types on the level.
+	 * If non of actors are chosen, returns the mask of empty cells without actors. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (Keywords = "Cell By Actor"))
+	static FCellMask GetCellMaskWithActors(UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/Bomber.EActorType")) int32 ActorsTypesBitmask);
+
+	/** Is the same as GetCellsAround, but returns the mask instead of the set.
+	 * @param CenterCell The start of searching in all directions.
+	 * @param Pathfinder Type of cells searching.
+	 * @param Radius Distance in number of cells from a center. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "CenterCell", Keywords = "Side"))
+	static FCellMask GetCellMaskAround(const FCell& CenterCell, EPathType Pathfinder, int32 Radius);
+
+	/** Returns the mask of cells with actors of specified types within the square of given radius around the center cell.
+	 * Visits only chunks of the grid overlapped by the square, but the returned mask still covers the whole grid,
+	 * so allocating and zeroing it is O(N) of cells: C++ code should call AGeneratedMap::GetCellIndicesInArea directly.
+	 * @param CenterCell The center of the square.
+	 * @param Radius Distance in number of cells from a center to each side of the square.
+	 * @param ActorsTypesBitmask Types of actors to find, any actor if none is chosen. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (AutoCreateRefTerm = "CenterCell", Keywords = "Cell By Actor Chunk"))
+	static FCellMask GetCellMaskInArea(const FCell& CenterCell, int32 Radius, UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/Bomber.EActorType")) int32 ActorsTypesBitmask);
+
+	/** Takes the mask and returns only cells with specified actor types, it's the intersection with cells of these actors on the level.
+	 * If non of actors are chosen, returns only empty cells without actors. */
+	UFUNCTION(BlueprintPure, Category = "C++")
+	static FCellMask FilterCellMaskByActors(const FCellMask& Mask, UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/Bomber.EActorType")) int32 ActorsTypesBitmask);
+
+	/** Returns cells that are contained in any of given masks. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "Union (Cell Mask)", CompactNodeTitle = "|", Keywords = "Or,Add"))
+	static FCellMask CellMask_Union(const FCellMask& A, const FCellMask& B);
+
+	/** Returns cells that are contained in both given masks. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "Intersect (Cell Mask)", CompactNodeTitle = "&", Keywords = "And"))
+	static FCellMask CellMask_Intersect(const FCellMask& A, const FCellMask& B);
+
+	/** Returns cells of the first mask that are not contained in the second one. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "Subtract (Cell Mask)", Keywords = "Difference,Remove"))
+	static FCellMask CellMask_Subtract(const FCellMask& A, const FCellMask& B);
+
+	/** Returns true if given cell is contained in the mask. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "Contains (Cell Mask)", AutoCreateRefTerm = "Cell"))
+	static bool CellMask_Contains(const FCellMask& Mask, const FCell& Cell);
+
+	/** Returns the number of cells contained in the mask. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "Count (Cell Mask)", CompactNodeTitle = "COUNT", Keywords = "Num,Length"))
+	static FORCEINLINE int32 CellMask_Count(const FCellMask& Mask) { return Mask.Bitboard.CountSetBits(); }
+
+	/** Returns true if none of cells is contained in the mask. */
+	UFUNCTION(BlueprintPure, Category = "C++", meta = (DisplayName = "Is Empty (Cell Mask)"))
+	static FORCEINLINE bool CellMask_IsEmpty(const FCellMask& Mask) { return Mask.Bitboard.IsEmpty(); }
+
 	/* ---------------------------------------------------
 	 *		Debug cells utilities
 	 * --------------------------------------------------- */
 
-	/** Remove all text renders of the Owner, is not available in shipping build. */
+	/** Remove all displayed cells of the Owner, is not available in shipping build. */
 	UFUNCTION(BlueprintCallable, Category = "C++", meta = (DevelopmentOnly, DefaultToSelf = "Owner"))
 	static void ClearDisplayedCells(const UObject* Owner);
 
@@ -62,8 +62,8 @@ public:
 	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "OptionalWorldContext"))
 	static class UMyGameUserSettings* GetMyGameUserSettings(const UObject* OptionalWorldContext = nullptr);
 
-	/** Returns the Settings widget. */
-	UFUNCTION(BlueprintPure, Category = "C++", meta = (WorldContext = "OptionalWorldContext"))
+	/** Returns the Settings widget, creates it if was not requested yet. */
+	UFUNCTION(BlueprintCallable, Category = "C++", meta = (WorldContext = "OptionalWorldContext"))
 	static class USettingsWidget* GetSettingsWidget(const UObject* OptionalWorldContext = nullptr);
 
 	/** Returns the Camera Component used on level. */
@@ -3,6 +3,7 @@
 #include "MyUnrealEdEngine.h"
 //---
 #include "UnrealEdGlobals.h"
+#include "Containers/Ticker.h"
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(MyUnrealEdEngine)
 
@@ -12,6 +13,27 @@ UMyUnrealEdEngine::FOnAnyDataAssetChanged UMyUnrealEdEngine::GOnAnyDataAssetChan
 // Binds to update movements of each AI controller.
 UMyUnrealEdEngine::FUpdateAI UMyUnrealEdEngine::GOnAIUpdatedDelegate;
 
+// Requests to update all AI controllers on the next editor tick, so many level changes in the same frame cause only one update
+void UMyUnrealEdEngine::MarkAIDirty()
+{
+	static bool bIsAIDirty = false;
+	if (bIsAIDirty)
+	{
+		// Is already requested
+		return;
+	}
+
+	bIsAIDirty = true;
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([](float DeltaTime)
+	{
+		bIsAIDirty = false;
+		GOnAIUpdatedDelegate.Broadcast();
+
+		// Is called once
+		return false;
+	}));
+}
+
 // Returns this Unreal Editor Engine object
 const UMyUnrealEdEngine& UMyUnrealEdEngine::Get()
 {
@@ -16,14 +16,17 @@ class BOMBEREDITOR_API UMyUnrealEdEngine : public UUnrealEdEngine
 	GENERATED_BODY()
 
 public:
-	DECLARE_MULTICAST_DELEGATE(FOnAnyDataAssetChanged);
-	/** Will notify on any data asset changes. */
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnAnyDataAssetChanged, const UObject* /*ChangedDataAsset*/);
+	/** Will notify on any data asset changes, the changed data asset is passed to let listeners react only on relevant changes. */
 	static FOnAnyDataAssetChanged GOnAnyDataAssetChanged;
 
 	DECLARE_MULTICAST_DELEGATE(FUpdateAI);
-	/** Binds to update movements of each AI controller. */
+	/** Binds to update movements of each AI controller, is broadcast by MarkAIDirty() once per editor tick. */
 	static FUpdateAI GOnAIUpdatedDelegate;
 
+	/** Requests to update all AI controllers on the next editor tick, so many level changes in the same frame cause only one update. */
+	static void MarkAIDirty();
+
 	/** Returns this Unreal Editor Engine object. */
 	static const UMyUnrealEdEngine& Get();
 };